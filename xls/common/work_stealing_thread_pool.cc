@@ -0,0 +1,135 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/work_stealing_thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "xls/common/thread.h"
+
+namespace xls {
+namespace {
+
+// The pool and worker index of the current thread if it is a worker thread.
+thread_local const WorkStealingThreadPool* current_pool = nullptr;
+thread_local int64_t current_worker_index = 0;
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(
+    std::optional<int64_t> thread_count) {
+  int64_t count =
+      std::max(thread_count.value_or(AvailableCPUs()), int64_t{1});
+  for (int64_t i = 0; i < count; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (int64_t i = 0; i < count; ++i) {
+    threads_.push_back(std::make_unique<Thread>([this, i]() {
+      current_pool = this;
+      current_worker_index = i;
+      WorkerLoop(i);
+    }));
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  WaitUntilIdle();
+  {
+    absl::MutexLock lock(&mutex_);
+    shutting_down_ = true;
+  }
+  for (std::unique_ptr<Thread>& thread : threads_) {
+    thread->Join();
+  }
+}
+
+void WorkStealingThreadPool::Schedule(std::function<void()> task) {
+  pending_tasks_.fetch_add(1);
+  int64_t index = current_pool == this
+                      ? current_worker_index
+                      : next_worker_.fetch_add(1) % thread_count();
+  {
+    Worker& worker = *workers_[index];
+    absl::MutexLock lock(&worker.mutex);
+    worker.tasks.push_back(std::move(task));
+  }
+  queued_tasks_.fetch_add(1);
+  // A worker increments `sleeping_workers_` before it checks `queued_tasks_`
+  // under `mutex_` so either the worker observes the new task or the task
+  // observes the sleeping worker. Releasing `mutex_` re-evaluates the wait
+  // condition of the sleeping workers.
+  if (sleeping_workers_.load() > 0) {
+    absl::MutexLock lock(&mutex_);
+  }
+}
+
+void WorkStealingThreadPool::WaitUntilIdle() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &WorkStealingThreadPool::NoPendingTasks));
+}
+
+std::optional<std::function<void()>> WorkStealingThreadPool::TryGetTask(
+    int64_t worker_index) {
+  {
+    Worker& worker = *workers_[worker_index];
+    absl::MutexLock lock(&worker.mutex);
+    if (!worker.tasks.empty()) {
+      std::function<void()> task = std::move(worker.tasks.back());
+      worker.tasks.pop_back();
+      queued_tasks_.fetch_sub(1);
+      return task;
+    }
+  }
+  for (int64_t i = 1; i < thread_count(); ++i) {
+    Worker& victim = *workers_[(worker_index + i) % thread_count()];
+    absl::MutexLock lock(&victim.mutex);
+    if (!victim.tasks.empty()) {
+      std::function<void()> task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      queued_tasks_.fetch_sub(1);
+      return task;
+    }
+  }
+  return std::nullopt;
+}
+
+void WorkStealingThreadPool::WorkerLoop(int64_t worker_index) {
+  while (true) {
+    std::optional<std::function<void()>> task = TryGetTask(worker_index);
+    if (task.has_value()) {
+      (*task)();
+      if (pending_tasks_.fetch_sub(1) == 1) {
+        // Wake up any threads blocked in WaitUntilIdle.
+        absl::MutexLock lock(&mutex_);
+      }
+      continue;
+    }
+    absl::MutexLock lock(&mutex_);
+    sleeping_workers_.fetch_add(1);
+    mutex_.Await(absl::Condition(
+        this, &WorkStealingThreadPool::HasQueuedTasksOrShutdown));
+    sleeping_workers_.fetch_sub(1);
+    if (shutting_down_ && queued_tasks_.load() <= 0) {
+      return;
+    }
+  }
+}
+
+}  // namespace xls
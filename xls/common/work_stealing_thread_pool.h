@@ -0,0 +1,103 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_COMMON_WORK_STEALING_THREAD_POOL_H_
+#define XLS_COMMON_WORK_STEALING_THREAD_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/thread.h"
+
+namespace xls {
+
+// A fixed-size pool of worker threads with per-worker task deques. A task
+// scheduled from within a worker of the pool is pushed onto that worker's own
+// deque and is popped in LIFO order by the owner which keeps related work on
+// the same core. Idle workers steal the oldest task from the deques of other
+// workers. Tasks scheduled from outside the pool are distributed round-robin.
+//
+// All methods are thread-safe.
+class WorkStealingThreadPool {
+ public:
+  // Creates a pool with `thread_count` worker threads. If `thread_count` is
+  // std::nullopt the number of available CPUs is used.
+  explicit WorkStealingThreadPool(
+      std::optional<int64_t> thread_count = std::nullopt);
+
+  // Waits for all scheduled tasks to complete and joins the worker threads.
+  ~WorkStealingThreadPool();
+
+  WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+  WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+  // Schedules `task` for execution on a worker thread. Tasks may schedule
+  // further tasks.
+  void Schedule(std::function<void()> task);
+
+  // Blocks until every task scheduled so far, including tasks scheduled
+  // transitively by those tasks, has completed. Must not be called from a
+  // worker thread of this pool.
+  void WaitUntilIdle();
+
+  int64_t thread_count() const { return workers_.size(); }
+
+ private:
+  struct Worker {
+    absl::Mutex mutex;
+    std::deque<std::function<void()>> tasks ABSL_GUARDED_BY(mutex);
+  };
+
+  void WorkerLoop(int64_t worker_index);
+
+  // Pops a task from the back of the given worker's deque or, failing that,
+  // steals one from the front of another worker's deque.
+  std::optional<std::function<void()>> TryGetTask(int64_t worker_index);
+
+  // Returns true if there are tasks which are not yet picked up by a worker
+  // or if the pool is shutting down.
+  bool HasQueuedTasksOrShutdown() const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return queued_tasks_.load() > 0 || shutting_down_;
+  }
+
+  bool NoPendingTasks() const { return pending_tasks_.load() == 0; }
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::unique_ptr<Thread>> threads_;
+
+  // Number of tasks sitting in worker deques.
+  std::atomic<int64_t> queued_tasks_ = 0;
+  // Number of tasks which have been scheduled but have not completed.
+  std::atomic<int64_t> pending_tasks_ = 0;
+  // Number of workers waiting for tasks.
+  std::atomic<int64_t> sleeping_workers_ = 0;
+  // Index of the worker to which the next externally scheduled task is given.
+  std::atomic<int64_t> next_worker_ = 0;
+
+  // Used for waking up sleeping workers and threads blocked in WaitUntilIdle.
+  absl::Mutex mutex_;
+  bool shutting_down_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace xls
+
+#endif  // XLS_COMMON_WORK_STEALING_THREAD_POOL_H_
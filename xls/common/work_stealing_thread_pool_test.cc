@@ -0,0 +1,90 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/work_stealing_thread_pool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace xls {
+namespace {
+
+TEST(WorkStealingThreadPoolTest, RunsAllTasks) {
+  WorkStealingThreadPool pool(4);
+  EXPECT_EQ(pool.thread_count(), 4);
+  std::atomic<int64_t> count = 0;
+  for (int64_t i = 0; i < 1000; ++i) {
+    pool.Schedule([&]() { count.fetch_add(1); });
+  }
+  pool.WaitUntilIdle();
+  EXPECT_EQ(count.load(), 1000);
+}
+
+TEST(WorkStealingThreadPoolTest, TasksScheduleTasks) {
+  WorkStealingThreadPool pool(3);
+  std::atomic<int64_t> count = 0;
+  // Each task spawns two children down to a fixed depth.
+  std::function<void(int64_t)> spawn = [&](int64_t depth) {
+    count.fetch_add(1);
+    if (depth > 0) {
+      pool.Schedule([&, depth]() { spawn(depth - 1); });
+      pool.Schedule([&, depth]() { spawn(depth - 1); });
+    }
+  };
+  pool.Schedule([&]() { spawn(10); });
+  pool.WaitUntilIdle();
+  EXPECT_EQ(count.load(), (int64_t{1} << 11) - 1);
+}
+
+TEST(WorkStealingThreadPoolTest, ReusableAfterIdle) {
+  WorkStealingThreadPool pool(2);
+  std::vector<int64_t> results(100, 0);
+  for (int64_t round = 1; round <= 5; ++round) {
+    for (int64_t& result : results) {
+      pool.Schedule([&result]() { ++result; });
+    }
+    pool.WaitUntilIdle();
+    for (int64_t result : results) {
+      EXPECT_EQ(result, round);
+    }
+  }
+}
+
+TEST(WorkStealingThreadPoolTest, DestructorWaitsForTasks) {
+  std::atomic<int64_t> count = 0;
+  {
+    WorkStealingThreadPool pool(2);
+    for (int64_t i = 0; i < 100; ++i) {
+      pool.Schedule([&]() { count.fetch_add(1); });
+    }
+  }
+  EXPECT_EQ(count.load(), 100);
+}
+
+TEST(WorkStealingThreadPoolTest, SingleThread) {
+  WorkStealingThreadPool pool(1);
+  int64_t count = 0;
+  for (int64_t i = 0; i < 100; ++i) {
+    pool.Schedule([&]() { ++count; });
+  }
+  pool.WaitUntilIdle();
+  EXPECT_EQ(count, 100);
+}
+
+}  // namespace
+}  // namespace xls
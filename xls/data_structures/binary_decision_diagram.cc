@@ -33,22 +33,76 @@
 #include "absl/strings/str_join.h"
 
 namespace xls {
+namespace {
 
-BinaryDecisionDiagram::BinaryDecisionDiagram() {
-  // Leaf node 0.
-  nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
-                           /*p=*/1));
-  // Leaf node 1.
+// Garbage collection and reordering are not considered until the graph has at
+// least this many nodes.
+constexpr int64_t kMinGcThreshold = 1 << 12;
+constexpr int64_t kMinReorderThreshold = 1 << 12;
+
+// While sifting a variable, stop moving it in one direction once the graph has
+// grown by this factor over the best size seen.
+constexpr double kMaxSiftGrowth = 1.2;
+
+// Limits on the work done by a single reordering.
+constexpr int64_t kMaxSiftedVariables = 1000;
+constexpr int64_t kMaxSwapsPerReorder = 1 << 20;
+
+int32_t SaturatingPathSum(int32_t a, int32_t b) {
+  return static_cast<int32_t>(
+      std::min(static_cast<int64_t>(a) + b,
+               static_cast<int64_t>(std::numeric_limits<int32_t>::max())));
+}
+
+}  // namespace
+
+BinaryDecisionDiagram::BinaryDecisionDiagram()
+    : gc_threshold_(kMinGcThreshold), reorder_threshold_(kMinReorderThreshold) {
+  // The terminal node. The uncomplemented expression is zero.
   nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
                            /*p=*/1));
+  live_node_count_ = 1;
+  peak_node_count_ = 1;
+}
+
+int64_t BinaryDecisionDiagram::Level(BddNodeIndex expr) const {
+  if (NodeId(expr) == 0) {
+    return std::numeric_limits<int64_t>::max();
+  }
+  return level_of_variable_[GetNode(expr).variable.value()];
+}
+
+int32_t BinaryDecisionDiagram::AllocateNode(BddVariable var, BddNodeIndex high,
+                                            BddNodeIndex low) {
+  // Compute the number of paths that the new node will have to the terminal
+  // nodes 0 and 1. Saturate at INT32_MAX.
+  int32_t paths =
+      SaturatingPathSum(GetNode(low).path_count, GetNode(high).path_count);
+  Ref(high);
+  Ref(low);
+  int32_t node_id;
+  if (free_nodes_.empty()) {
+    node_id = nodes_.size();
+    nodes_.emplace_back(var, high, low, paths);
+  } else {
+    node_id = free_nodes_.back();
+    free_nodes_.pop_back();
+    nodes_[node_id] = BddNode(var, high, low, paths);
+  }
+  ++live_node_count_;
+  peak_node_count_ = std::max(peak_node_count_, live_node_count_);
+  return node_id;
 }
 
 BddNodeIndex BinaryDecisionDiagram::CreateVariableBaseNode(BddVariable var) {
-  const BddNodeIndex high = one();
-  const BddNodeIndex low = zero();
-  const int32_t paths = 2;
-  nodes_.emplace_back(var, high, low, paths);
-  return BddNodeIndex(nodes_.size() - 1);
+  level_of_variable_.push_back(variable_at_level_.size());
+  variable_at_level_.push_back(var);
+  unique_tables_.emplace_back();
+  int32_t node_id = AllocateNode(var, one(), zero());
+  unique_tables_.back()[{one(), zero()}] = node_id;
+  // Base nodes are never freed.
+  ++nodes_[node_id].ref_count;
+  return MakeExpression(node_id, /*complement=*/false);
 }
 
 BddNodeIndex BinaryDecisionDiagram::GetOrCreateNode(BddVariable var,
@@ -58,26 +112,73 @@ BddNodeIndex BinaryDecisionDiagram::GetOrCreateNode(BddVariable var,
     return low;
   }
 
-  // If low == 0 and high == 1, then this is a variable base node and is kept
-  // in the variable_base_nodes_ vector.
-  if (low == zero() && high == one()) {
-    return variable_base_nodes_[var.value()];
+  // Keep the low child uncomplemented by complementing the node instead.
+  bool complement = IsComplemented(low);
+  if (complement) {
+    high = Not(high);
+    low = Not(low);
+  }
+  auto [it, inserted] =
+      unique_tables_[var.value()].try_emplace(NodeKey{high, low}, 0);
+  if (inserted) {
+    it->second = AllocateNode(var, high, low);
+  }
+  return MakeExpression(it->second, complement);
+}
+
+void BinaryDecisionDiagram::Ref(BddNodeIndex expr) {
+  // The terminal node is never freed so it is not counted.
+  if (NodeId(expr) != 0) {
+    ++nodes_[NodeId(expr)].ref_count;
   }
+}
 
-  // Otherwise, this is a normal node and is kept in node_map_.
-  NodeKey key = std::make_tuple(var, high, low);
-  auto it = node_map_.lazy_emplace(key, [&](const auto& ctor) {
-    // Compute the number of paths that the new node will have to the terminal
-    // nodes 0 and 1. Use int64s to avoid overflowing and saturate at INT32_MAX.
-    int32_t paths =
-        std::min(static_cast<int64_t>(GetNode(low).path_count) +
-                     GetNode(high).path_count,
-                 static_cast<int64_t>(std::numeric_limits<int32_t>::max()));
-    nodes_.emplace_back(var, high, low, paths);
-    BddNodeIndex node_index = BddNodeIndex(nodes_.size() - 1);
-    ctor(key, node_index);
-  });
-  return it->second;
+void BinaryDecisionDiagram::Deref(BddNodeIndex expr) {
+  if (NodeId(expr) != 0) {
+    BddNode& node = nodes_[NodeId(expr)];
+    CHECK_GT(node.ref_count, 0);
+    --node.ref_count;
+  }
+}
+
+void BinaryDecisionDiagram::DerefAndMaybeFree(BddNodeIndex expr) {
+  std::vector<int32_t> worklist;
+  auto deref = [&](BddNodeIndex e) {
+    int32_t node_id = NodeId(e);
+    if (node_id != 0 && --nodes_[node_id].ref_count == 0) {
+      worklist.push_back(node_id);
+    }
+  };
+  deref(expr);
+  while (!worklist.empty()) {
+    int32_t node_id = worklist.back();
+    worklist.pop_back();
+    BddNode node = nodes_[node_id];
+    unique_tables_[node.variable.value()].erase(NodeKey{node.high, node.low});
+    nodes_[node_id] = BddNode(BddVariable(-1), BddNodeIndex(-1),
+                              BddNodeIndex(-1), /*p=*/0);
+    free_nodes_.push_back(node_id);
+    --live_node_count_;
+    deref(node.high);
+    deref(node.low);
+  }
+}
+
+int64_t BinaryDecisionDiagram::GarbageCollect() {
+  int64_t before = live_node_count_;
+  for (int32_t node_id = 1; node_id < nodes_.size(); ++node_id) {
+    if (!IsFree(node_id) && nodes_[node_id].ref_count == 0) {
+      // Take a reference so DerefAndMaybeFree releases it.
+      ++nodes_[node_id].ref_count;
+      DerefAndMaybeFree(MakeExpression(node_id, /*complement=*/false));
+    }
+  }
+  // Cached results may refer to freed nodes.
+  ite_map_.clear();
+  ++gc_count_;
+  VLOG(2) << absl::StreamFormat("BDD garbage collection freed %d of %d nodes",
+                                before - live_node_count_, before);
+  return before - live_node_count_;
 }
 
 BddNodeIndex BinaryDecisionDiagram::Restrict(BddNodeIndex expr, BddVariable var,
@@ -87,9 +188,9 @@ BddNodeIndex BinaryDecisionDiagram::Restrict(BddNodeIndex expr, BddVariable var,
   }
 
   const BddNode& node = GetNode(expr);
-  CHECK_LE(var, node.variable);
+  CHECK_LE(level_of_variable_[var.value()], Level(expr));
   if (node.variable == var) {
-    return value ? node.high : node.low;
+    return value ? High(expr) : Low(expr);
   }
   return expr;
 }
@@ -103,32 +204,59 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
   if (cond == zero()) {
     return if_false;
   }
-  if (if_true == one() && if_false == zero()) {
-    return cond;
+  // Replace operands which are equal to the condition (or its complement) with
+  // constants.
+  if (if_true == cond) {
+    if_true = one();
+  } else if (if_true == Not(cond)) {
+    if_true = zero();
+  }
+  if (if_false == cond) {
+    if_false = zero();
+  } else if (if_false == Not(cond)) {
+    if_false = one();
   }
   if (if_true == if_false) {
     return if_true;
   }
+  if (if_true == one() && if_false == zero()) {
+    return cond;
+  }
+  if (if_true == zero() && if_false == one()) {
+    return Not(cond);
+  }
+
+  // Normalize so that equivalent expressions share a cache entry: the
+  // condition and the if-true operand are uncomplemented.
+  if (IsComplemented(cond)) {
+    cond = Not(cond);
+    std::swap(if_true, if_false);
+  }
+  bool complement_result = false;
+  if (IsComplemented(if_true)) {
+    if_true = Not(if_true);
+    if_false = Not(if_false);
+    complement_result = true;
+  }
+  auto complement_if_needed = [&](BddNodeIndex expr) {
+    return complement_result ? Not(expr) : expr;
+  };
+
   auto key = std::make_tuple(cond, if_true, if_false);
   auto it = ite_map_.find(key);
   if (it != ite_map_.end()) {
-    return it->second;
+    return complement_if_needed(it->second);
   }
 
   // The expression is non-trivial and has not been computed before. Recursively
   // decompose the expression by peeling away the first variable and performing
   // a Shannon decomposition.
 
-  // First, find the lowest-index variable amongst all expressions. In all paths
-  // through the BDD the variable indices are strictly increasing.
-  BddVariable min_var = GetNode(cond).variable;
-  // Only non-leaf nodes (not zero or one) have associated variables.
-  if (if_true != zero() && if_true != one()) {
-    min_var = std::min(min_var, GetNode(if_true).variable);
-  }
-  if (if_false != zero() && if_false != one()) {
-    min_var = std::min(min_var, GetNode(if_false).variable);
-  }
+  // First, find the variable at the lowest level amongst all expressions. In
+  // all paths through the BDD the variable levels are strictly increasing.
+  int64_t min_level =
+      std::min({Level(cond), Level(if_true), Level(if_false)});
+  BddVariable min_var = variable_at_level_[min_level];
 
   // Perform a Shannon expansion about the variable where Shannon expansion is
   // the identity:
@@ -142,13 +270,9 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
                                            Restrict(if_true, min_var, false),
                                            Restrict(if_false, min_var, false));
 
-  if (true_cofactor == false_cofactor) {
-    ite_map_[key] = true_cofactor;
-    return true_cofactor;
-  }
   BddNodeIndex expr = GetOrCreateNode(min_var, true_cofactor, false_cofactor);
   ite_map_[key] = expr;
-  return expr;
+  return complement_if_needed(expr);
 }
 
 template <typename T>
@@ -189,6 +313,9 @@ std::vector<BddNodeIndex> BinaryDecisionDiagram::NewVariables(int64_t count) {
   // [0] https://en.cppreference.com/w/cpp/container/vector/reserve
   ReserveVector(nodes_.size() + count, nodes_);
   ReserveVector(variable_base_nodes_.size() + count, variable_base_nodes_);
+  ReserveVector(variable_base_nodes_.size() + count, unique_tables_);
+  ReserveVector(variable_base_nodes_.size() + count, level_of_variable_);
+  ReserveVector(variable_base_nodes_.size() + count, variable_at_level_);
 
   std::vector<BddNodeIndex> indexes;
   indexes.reserve(count);
@@ -201,10 +328,6 @@ std::vector<BddNodeIndex> BinaryDecisionDiagram::NewVariables(int64_t count) {
   return indexes;
 }
 
-BddNodeIndex BinaryDecisionDiagram::Not(BddNodeIndex expr) {
-  return IfThenElse(expr, zero(), one());
-}
-
 BddNodeIndex BinaryDecisionDiagram::Or(BddNodeIndex a, BddNodeIndex b) {
   return IfThenElse(a, one(), b);
 }
@@ -213,6 +336,173 @@ BddNodeIndex BinaryDecisionDiagram::And(BddNodeIndex a, BddNodeIndex b) {
   return IfThenElse(a, b, zero());
 }
 
+void BinaryDecisionDiagram::SwapAdjacentLevels(int64_t level) {
+  BddVariable x = variable_at_level_[level];
+  BddVariable y = variable_at_level_[level + 1];
+  auto is_y_node = [&](BddNodeIndex e) {
+    return NodeId(e) != 0 && GetNode(e).variable == y;
+  };
+
+  // Only the nodes of `x` with a child labeled `y` change. The others do not
+  // depend on `y` and simply move down a level. Process the nodes in index
+  // order so the result does not depend on hash map iteration order.
+  std::vector<int32_t> to_rewrite;
+  for (const auto& [key, node_id] : unique_tables_[x.value()]) {
+    if (is_y_node(key.first) || is_y_node(key.second)) {
+      to_rewrite.push_back(node_id);
+    }
+  }
+  std::sort(to_rewrite.begin(), to_rewrite.end());
+
+  for (int32_t node_id : to_rewrite) {
+    BddNodeIndex f1 = nodes_[node_id].high;
+    BddNodeIndex f0 = nodes_[node_id].low;
+    unique_tables_[x.value()].erase(NodeKey{f1, f0});
+    auto cofactor = [&](BddNodeIndex e, bool value) {
+      if (!is_y_node(e)) {
+        return e;
+      }
+      return value ? High(e) : Low(e);
+    };
+    // The node computes ITE(x, f1, f0). Expanded about y first it becomes
+    // ITE(y, ITE(x, f11, f01), ITE(x, f10, f00)).
+    BddNodeIndex new_high =
+        GetOrCreateNode(x, cofactor(f1, true), cofactor(f0, true));
+    Ref(new_high);
+    BddNodeIndex new_low =
+        GetOrCreateNode(x, cofactor(f1, false), cofactor(f0, false));
+    Ref(new_low);
+    // `f0` is uncomplemented and so are its cofactors, hence so is `new_low`.
+    DCHECK(!IsComplemented(new_low));
+    BddNode& node = nodes_[node_id];
+    node.variable = y;
+    node.high = new_high;
+    node.low = new_low;
+    bool inserted =
+        unique_tables_[y.value()].try_emplace(NodeKey{new_high, new_low},
+                                              node_id)
+            .second;
+    CHECK(inserted);
+    DerefAndMaybeFree(f1);
+    DerefAndMaybeFree(f0);
+  }
+
+  std::swap(variable_at_level_[level], variable_at_level_[level + 1]);
+  level_of_variable_[x.value()] = level + 1;
+  level_of_variable_[y.value()] = level;
+}
+
+bool BinaryDecisionDiagram::SiftVariable(BddVariable var,
+                                         int64_t& swap_budget) {
+  const int64_t last_level = variable_count() - 1;
+  int64_t level = level_of_variable_[var.value()];
+  int64_t best_size = live_node_count_;
+  int64_t best_level = level;
+  auto size_limit = [&]() {
+    return static_cast<int64_t>(kMaxSiftGrowth * best_size);
+  };
+  auto swap = [&](int64_t upper_level) {
+    SwapAdjacentLevels(upper_level);
+    --swap_budget;
+  };
+  auto move_down = [&]() {
+    while (level < last_level && swap_budget > 0 &&
+           live_node_count_ <= size_limit()) {
+      swap(level);
+      ++level;
+      if (live_node_count_ < best_size) {
+        best_size = live_node_count_;
+        best_level = level;
+      }
+    }
+  };
+  auto move_up = [&]() {
+    while (level > 0 && swap_budget > 0 && live_node_count_ <= size_limit()) {
+      swap(level - 1);
+      --level;
+      if (live_node_count_ < best_size) {
+        best_size = live_node_count_;
+        best_level = level;
+      }
+    }
+  };
+  // Visit the nearer end first.
+  if (level > last_level / 2) {
+    move_down();
+    move_up();
+  } else {
+    move_up();
+    move_down();
+  }
+  // Return to the best position seen. This is done even if the budget is
+  // exhausted.
+  while (level < best_level) {
+    swap(level);
+    ++level;
+  }
+  while (level > best_level) {
+    swap(level - 1);
+    --level;
+  }
+  return swap_budget > 0;
+}
+
+void BinaryDecisionDiagram::RecomputePathCounts() {
+  for (int64_t level = variable_count() - 1; level >= 0; --level) {
+    BddVariable var = variable_at_level_[level];
+    for (const auto& [key, node_id] : unique_tables_[var.value()]) {
+      nodes_[node_id].path_count = SaturatingPathSum(
+          GetNode(key.first).path_count, GetNode(key.second).path_count);
+    }
+  }
+}
+
+void BinaryDecisionDiagram::Reorder() {
+  GarbageCollect();
+  int64_t before = live_node_count_;
+
+  // Sift the variables with the most nodes first.
+  std::vector<BddVariable> variables;
+  for (int64_t i = 0; i < variable_count(); ++i) {
+    // Variables with only their base node hardly affect the graph size.
+    if (unique_tables_[i].size() > 1) {
+      variables.push_back(BddVariable(i));
+    }
+  }
+  std::stable_sort(variables.begin(), variables.end(),
+                   [&](BddVariable a, BddVariable b) {
+                     return unique_tables_[a.value()].size() >
+                            unique_tables_[b.value()].size();
+                   });
+  if (variables.size() > kMaxSiftedVariables) {
+    variables.resize(kMaxSiftedVariables);
+  }
+  int64_t swap_budget = kMaxSwapsPerReorder;
+  for (BddVariable var : variables) {
+    if (!SiftVariable(var, swap_budget)) {
+      break;
+    }
+  }
+
+  RecomputePathCounts();
+  ite_map_.clear();
+  ++reorder_count_;
+  VLOG(2) << absl::StreamFormat("BDD reordering: %d nodes -> %d nodes", before,
+                                live_node_count_);
+}
+
+void BinaryDecisionDiagram::MaybeCollectGarbage() {
+  if (live_node_count_ < gc_threshold_) {
+    return;
+  }
+  GarbageCollect();
+  if (dynamic_reordering_ && live_node_count_ >= reorder_threshold_) {
+    Reorder();
+    reorder_threshold_ = std::max(kMinReorderThreshold, 2 * live_node_count_);
+  }
+  gc_threshold_ = std::max(kMinGcThreshold, 2 * live_node_count_);
+}
+
 absl::StatusOr<bool> BinaryDecisionDiagram::Evaluate(
     BddNodeIndex expr,
     const absl::flat_hash_map<BddNodeIndex, bool>& variable_values) const {
@@ -238,8 +528,7 @@ absl::StatusOr<bool> BinaryDecisionDiagram::Evaluate(
           absl::StrFormat("Missing value for BDD variable %d (node index %d)",
                           GetNode(result).variable.value(), var_node.value()));
     }
-    result = variable_values.at(var_node) ? GetNode(result).high
-                                          : GetNode(result).low;
+    result = variable_values.at(var_node) ? High(result) : Low(result);
   }
   VLOG(2) << "  result = " << (result == one() ? true : false);
   return result == one();
@@ -272,9 +561,9 @@ void BinaryDecisionDiagram::ToStringDnfHelper(BddNodeIndex expr,
 
   const BddNode& node = GetNode(expr);
   terms->push_back(absl::StrCat("x", node.variable.value()));
-  ToStringDnfHelper(node.high, minterms_to_emit, terms, str);
+  ToStringDnfHelper(High(expr), minterms_to_emit, terms, str);
   terms->back() = absl::StrCat("!x", node.variable.value());
-  ToStringDnfHelper(node.low, minterms_to_emit, terms, str);
+  ToStringDnfHelper(Low(expr), minterms_to_emit, terms, str);
   terms->pop_back();
 }
 
@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -34,19 +35,29 @@ namespace xls {
 //   K.S. Brace, R.L. Rudell, and R.E. Bryant,
 //   "Efficient Implementation of a BDD package"
 //   https://ieeexplore.ieee.org/document/114826
+//
+// Edges may be complemented so Not is a constant-time operation, nodes are
+// reference counted so unused nodes can be reclaimed, and the variable order
+// can be changed by sifting:
+//   R. Rudell, "Dynamic variable ordering for ordered binary decision
+//   diagrams", https://ieeexplore.ieee.org/document/580029
 
 // For efficiency variables and nodes are referred to by indices into vector
-// data members in the BDD.
+// data members in the BDD. A BddNodeIndex refers to an expression: the low bit
+// indicates whether the expression is the complement of the node and the
+// remaining bits are the index of the node.
 XLS_DEFINE_STRONG_INT_TYPE(BddVariable, int32_t);
 XLS_DEFINE_STRONG_INT_TYPE(BddNodeIndex, int32_t);
 
 // A node in the BDD. The node is associated with a single variable and has
 // children corresponding to when the variable is true (high) and when it is
-// false (low).
+// false (low). The low child is never a complemented expression which keeps
+// the representation canonical. The children of the expression which is the
+// complement of this node are the complements of `high` and `low`.
 struct BddNode {
-  BddNode() : variable(0), high(0), low(0), path_count(0) {}
+  BddNode() : variable(0), high(0), low(0), path_count(0), ref_count(0) {}
   BddNode(BddVariable v, BddNodeIndex h, BddNodeIndex l, int32_t p)
-      : variable(v), high(h), low(l), path_count(p) {}
+      : variable(v), high(h), low(l), path_count(p), ref_count(0) {}
 
   BddVariable variable;
   BddNodeIndex high;
@@ -56,16 +67,20 @@ struct BddNode {
   // the growth of the BDD by halting evaluation if the number of paths gets too
   // large. Saturates at INT32_MAX.
   int32_t path_count;
+
+  // Number of parent nodes plus the number of outstanding references taken
+  // with BinaryDecisionDiagram::Ref.
+  int32_t ref_count;
 };
 
 class BinaryDecisionDiagram {
  public:
-  // Creates an empty BDD. Initialize the BDD contains only the nodes
-  // corresponding to zero and one.
+  // Creates an empty BDD. Initially the BDD contains only the terminal node
+  // which represents zero and (complemented) one.
   BinaryDecisionDiagram();
 
   // Adds a new variable to the BDD and returns the node corresponding the
-  // variable's value.
+  // variable's value. The variable is placed last in the variable order.
   BddNodeIndex NewVariable();
 
   // Adds `count` new variables to the BDD and returns the nodes corresponding
@@ -74,8 +89,10 @@ class BinaryDecisionDiagram {
   // `count`.
   std::vector<BddNodeIndex> NewVariables(int64_t count);
 
-  // Returns the inverse of the given expression.
-  BddNodeIndex Not(BddNodeIndex expr);
+  // Returns the inverse of the given expression. Never creates nodes.
+  BddNodeIndex Not(BddNodeIndex expr) const {
+    return BddNodeIndex(expr.value() ^ 1);
+  }
 
   // Returns the OR/AND of the given expressions.
   BddNodeIndex And(BddNodeIndex a, BddNodeIndex b);
@@ -93,17 +110,34 @@ class BinaryDecisionDiagram {
       BddNodeIndex expr,
       const absl::flat_hash_map<BddNodeIndex, bool>& variable_values) const;
 
-  // Returns the BDD node with the given index.
+  // Returns the BDD node underlying the given expression. If the expression is
+  // complemented the children of the node must be complemented as well to get
+  // the cofactors of the expression.
   const BddNode& GetNode(BddNodeIndex node_index) const {
-    return nodes_.at(node_index.value());
+    return nodes_.at(node_index.value() >> 1);
   }
 
-  // Returns the number of nodes in the graph.
-  int64_t size() const { return nodes_.size(); }
+  // Returns true if the given expression is the complement of its node.
+  static bool IsComplemented(BddNodeIndex expr) {
+    return (expr.value() & 1) != 0;
+  }
+
+  // Returns the number of live nodes in the graph. This includes nodes which
+  // are no longer referenced but have not yet been garbage collected.
+  int64_t size() const { return live_node_count_; }
+
+  // Returns the largest number of live nodes the graph has had.
+  int64_t peak_size() const { return peak_node_count_; }
 
   // Returns the number of variables in the graph.
   int64_t variable_count() const { return variable_base_nodes_.size(); }
 
+  // Returns the position of the given variable in the variable order. Level
+  // zero is closest to the root.
+  int64_t GetVariableLevel(BddVariable variable) const {
+    return level_of_variable_.at(variable.value());
+  }
+
   // Returns the number of paths in the given expression.
   int64_t path_count(BddNodeIndex expr) const {
     return GetNode(expr).path_count;
@@ -118,14 +152,68 @@ class BinaryDecisionDiagram {
   // variable. The expression of a base node is exactly equal to the value of
   // the variable.
   bool IsVariableBaseNode(BddNodeIndex expr) const {
-    return GetNode(expr).high == one() && GetNode(expr).low == zero();
+    return !IsComplemented(expr) && GetNode(expr).high == one() &&
+           GetNode(expr).low == zero();
   }
 
   // Returns the node corresponding to the given if-then-else expression.
   BddNodeIndex IfThenElse(BddNodeIndex cond, BddNodeIndex if_true,
                           BddNodeIndex if_false);
 
+  // Takes or releases a reference to the given expression. Garbage collection
+  // and reordering preserve referenced expressions and everything reachable
+  // from them; any other BddNodeIndex held by the caller may be invalidated.
+  // Variable base nodes are always referenced.
+  void Ref(BddNodeIndex expr);
+  void Deref(BddNodeIndex expr);
+
+  // Frees every node which is not reachable from a referenced expression and
+  // returns the number of nodes freed. Freed nodes are reused by later
+  // operations.
+  int64_t GarbageCollect();
+
+  // Garbage collects and then reorders the variables by sifting to reduce the
+  // number of nodes. Referenced expressions keep their BddNodeIndex values
+  // and denote the same functions afterwards though their structure (and path
+  // counts) may change.
+  void Reorder();
+
+  // Garbage collects if the number of nodes has doubled since the last
+  // collection and, if dynamic reordering is enabled and the graph has grown
+  // past the reordering threshold, reorders the variables. Clients with long
+  // running constructions should call this at points where all expressions
+  // they hold are referenced.
+  void MaybeCollectGarbage();
+
+  void set_dynamic_reordering(bool value) { dynamic_reordering_ = value; }
+  bool dynamic_reordering() const { return dynamic_reordering_; }
+
+  int64_t garbage_collection_count() const { return gc_count_; }
+  int64_t reorder_count() const { return reorder_count_; }
+
  private:
+  static int32_t NodeId(BddNodeIndex expr) { return expr.value() >> 1; }
+  static BddNodeIndex MakeExpression(int32_t node_id, bool complement) {
+    return BddNodeIndex((node_id << 1) | (complement ? 1 : 0));
+  }
+
+  // Returns whether the given node slot is on the free list.
+  bool IsFree(int32_t node_id) const {
+    return node_id != 0 && nodes_[node_id].variable < BddVariable(0);
+  }
+
+  // Returns the level of the top variable of the expression. The terminal is
+  // below every variable.
+  int64_t Level(BddNodeIndex expr) const;
+
+  // Returns the cofactors of the expression with respect to its top variable.
+  BddNodeIndex High(BddNodeIndex expr) const {
+    return BddNodeIndex(GetNode(expr).high.value() ^ (expr.value() & 1));
+  }
+  BddNodeIndex Low(BddNodeIndex expr) const {
+    return BddNodeIndex(GetNode(expr).low.value() ^ (expr.value() & 1));
+  }
+
   // Helper for constructing a DNF string respresentation.
   void ToStringDnfHelper(BddNodeIndex expr, int64_t* minterms_to_emit,
                          std::vector<std::string>* terms,
@@ -136,6 +224,14 @@ class BinaryDecisionDiagram {
   BddNodeIndex GetOrCreateNode(BddVariable var, BddNodeIndex high,
                                BddNodeIndex low);
 
+  // Creates a node with the given fields, taking references to the children.
+  // The caller is responsible for adding it to the unique table.
+  int32_t AllocateNode(BddVariable var, BddNodeIndex high, BddNodeIndex low);
+
+  // Drops a reference to the node of the given expression and frees the node,
+  // and transitively its children, if no references remain.
+  void DerefAndMaybeFree(BddNodeIndex expr);
+
   // Returns the node equal to given expression with the given variable
   // set to the given value.
   BddNodeIndex Restrict(BddNodeIndex expr, BddVariable var, bool value);
@@ -148,24 +244,49 @@ class BinaryDecisionDiagram {
   // Creates the base BddNode corresponding to the given variable.
   BddNodeIndex CreateVariableBaseNode(BddVariable var);
 
+  // Exchanges the variables at levels `level` and `level + 1` in place. Every
+  // BddNodeIndex keeps denoting the same function.
+  void SwapAdjacentLevels(int64_t level);
+
+  // Moves the given variable to the level which minimizes the node count.
+  // Returns false if the swap budget ran out.
+  bool SiftVariable(BddVariable var, int64_t& swap_budget);
+
+  // Recomputes the path counts of every node after reordering.
+  void RecomputePathCounts();
+
   // NodeIndexes corresponding to the base nodes (var, one, zero) for each
   // variable.
   std::vector<BddNodeIndex> variable_base_nodes_;
 
-  // The vector of all the nodes in the BDD.
+  // The vector of all the nodes in the BDD. Freed slots are kept in
+  // `free_nodes_` for reuse.
   std::vector<BddNode> nodes_;
+  std::vector<int32_t> free_nodes_;
+  int64_t live_node_count_ = 0;
+  int64_t peak_node_count_ = 0;
+
+  // The current variable order.
+  std::vector<int32_t> level_of_variable_;
+  std::vector<BddVariable> variable_at_level_;
 
-  // A map from BDD node content (variable id, high child, low child) to the
-  // index of the respective node. This map is used to ensure that no duplicate
-  // nodes are created.
-  using NodeKey = std::tuple<BddVariable, BddNodeIndex, BddNodeIndex>;
-  absl::flat_hash_map<NodeKey, BddNodeIndex> node_map_;
+  // For each variable, a map from BDD node content (high child, low child) to
+  // the index of the respective node. These maps ensure that no duplicate
+  // nodes are created and let reordering find the nodes of a variable.
+  using NodeKey = std::pair<BddNodeIndex, BddNodeIndex>;
+  std::vector<absl::flat_hash_map<NodeKey, int32_t>> unique_tables_;
 
   // A map from if-then-else expression to the node corresponding to that
   // expression. The key elements are (condition, if-true, if-false). This map
-  // enables fast lookup for expressions.
+  // enables fast lookup for expressions. Cleared by garbage collection.
   using IteKey = std::tuple<BddNodeIndex, BddNodeIndex, BddNodeIndex>;
   absl::flat_hash_map<IteKey, BddNodeIndex> ite_map_;
+
+  bool dynamic_reordering_ = false;
+  int64_t gc_threshold_;
+  int64_t reorder_threshold_;
+  int64_t gc_count_ = 0;
+  int64_t reorder_count_ = 0;
 };
 
 }  // namespace xls
@@ -15,14 +15,17 @@
 #include "xls/data_structures/binary_decision_diagram.h"
 
 #include <cstdint>
+#include <cstdlib>
 #include <limits>
 #include <string>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "benchmark/benchmark.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/log.h"
+#include "absl/types/span.h"
 #include "absl/status/status_matchers.h"
 
 namespace xls {
@@ -315,5 +318,172 @@ TEST(BinaryDecisionDiagramTest, ThreeVariableExhaustive) {
   }
 }
 
+TEST(BinaryDecisionDiagramTest, NotDoesNotCreateNodes) {
+  BinaryDecisionDiagram bdd;
+  BddNodeIndex x = bdd.NewVariable();
+  BddNodeIndex y = bdd.NewVariable();
+  BddNodeIndex x_and_y = bdd.And(x, y);
+
+  int64_t before_size = bdd.size();
+  BddNodeIndex not_x_and_y = bdd.Not(x_and_y);
+  EXPECT_EQ(bdd.size(), before_size);
+  EXPECT_EQ(bdd.Not(not_x_and_y), x_and_y);
+  EXPECT_EQ(bdd.Not(bdd.zero()), bdd.one());
+  EXPECT_THAT(bdd.Evaluate(not_x_and_y, {{x, true}, {y, true}}),
+              IsOkAndHolds(false));
+  EXPECT_THAT(bdd.Evaluate(not_x_and_y, {{x, true}, {y, false}}),
+              IsOkAndHolds(true));
+
+  // NAND and OR of the complements share a node.
+  EXPECT_EQ(not_x_and_y, bdd.Or(bdd.Not(x), bdd.Not(y)));
+  EXPECT_EQ(bdd.size(), before_size);
+  EXPECT_FALSE(bdd.IsVariableBaseNode(bdd.Not(x)));
+  EXPECT_TRUE(bdd.IsVariableBaseNode(x));
+}
+
+TEST(BinaryDecisionDiagramTest, GarbageCollection) {
+  BinaryDecisionDiagram bdd;
+  std::vector<BddNodeIndex> vars = bdd.NewVariables(8);
+  int64_t base_size = bdd.size();
+
+  BddNodeIndex kept = bdd.zero();
+  for (int64_t i = 0; i < 8; i += 2) {
+    kept = bdd.Or(kept, bdd.And(vars[i], vars[i + 1]));
+  }
+  bdd.Ref(kept);
+  // Temporaries which are not referenced.
+  for (int64_t i = 0; i < 7; ++i) {
+    bdd.Or(bdd.And(vars[i], bdd.Not(vars[i + 1])), vars[7 - i]);
+  }
+  int64_t size_before_gc = bdd.size();
+  std::string kept_dnf = bdd.ToStringDnf(kept);
+
+  EXPECT_GT(bdd.GarbageCollect(), 0);
+  EXPECT_LT(bdd.size(), size_before_gc);
+  EXPECT_GT(bdd.size(), base_size);
+  EXPECT_EQ(bdd.ToStringDnf(kept), kept_dnf);
+  EXPECT_EQ(bdd.peak_size(), size_before_gc);
+
+  // Rebuilding the kept expression finds the existing nodes.
+  BddNodeIndex rebuilt = bdd.zero();
+  for (int64_t i = 0; i < 8; i += 2) {
+    rebuilt = bdd.Or(rebuilt, bdd.And(vars[i], vars[i + 1]));
+  }
+  EXPECT_EQ(rebuilt, kept);
+
+  // Once released everything but the variables is collected.
+  bdd.Deref(kept);
+  bdd.GarbageCollect();
+  EXPECT_EQ(bdd.size(), base_size);
+  EXPECT_EQ(bdd.ToStringDnf(vars[3]), "x3");
+}
+
+// Returns x0.y0 + x1.y1 + ... The size of the BDD is exponential in the
+// number of pairs if all of the x variables are ordered before the y variables
+// but linear if each x is adjacent to its y.
+BddNodeIndex PairwiseProducts(BinaryDecisionDiagram& bdd,
+                              absl::Span<const BddNodeIndex> xs,
+                              absl::Span<const BddNodeIndex> ys) {
+  BddNodeIndex result = bdd.zero();
+  for (int64_t i = 0; i < xs.size(); ++i) {
+    result = bdd.Or(result, bdd.And(xs[i], ys[i]));
+  }
+  return result;
+}
+
+TEST(BinaryDecisionDiagramTest, ReorderPreservesFunctions) {
+  constexpr int64_t kPairs = 6;
+  BinaryDecisionDiagram bdd;
+  std::vector<BddNodeIndex> xs = bdd.NewVariables(kPairs);
+  std::vector<BddNodeIndex> ys = bdd.NewVariables(kPairs);
+  BddNodeIndex f = PairwiseProducts(bdd, xs, ys);
+  BddNodeIndex g = bdd.Or(bdd.Not(f), bdd.And(xs[0], bdd.Not(ys[kPairs - 1])));
+  bdd.Ref(f);
+  bdd.Ref(g);
+
+  auto assignment = [&](int64_t value) {
+    absl::flat_hash_map<BddNodeIndex, bool> values;
+    for (int64_t i = 0; i < kPairs; ++i) {
+      values[xs[i]] = ((value >> i) & 1) != 0;
+      values[ys[i]] = ((value >> (kPairs + i)) & 1) != 0;
+    }
+    return values;
+  };
+  std::vector<bool> f_values;
+  std::vector<bool> g_values;
+  for (int64_t value = 0; value < (1 << (2 * kPairs)); ++value) {
+    f_values.push_back(*bdd.Evaluate(f, assignment(value)));
+    g_values.push_back(*bdd.Evaluate(g, assignment(value)));
+  }
+
+  bdd.GarbageCollect();
+  int64_t size_before = bdd.size();
+  bdd.Reorder();
+  EXPECT_EQ(bdd.reorder_count(), 1);
+  EXPECT_LT(bdd.size(), size_before);
+  // Each y is placed next to its x.
+  for (int64_t i = 0; i < kPairs; ++i) {
+    EXPECT_EQ(std::abs(bdd.GetVariableLevel(bdd.GetNode(xs[i]).variable) -
+                       bdd.GetVariableLevel(bdd.GetNode(ys[i]).variable)),
+              1);
+  }
+  for (int64_t value = 0; value < (1 << (2 * kPairs)); ++value) {
+    EXPECT_THAT(bdd.Evaluate(f, assignment(value)),
+                IsOkAndHolds(f_values[value]));
+    EXPECT_THAT(bdd.Evaluate(g, assignment(value)),
+                IsOkAndHolds(g_values[value]));
+  }
+  EXPECT_EQ(bdd.path_count(f), (int64_t{1} << (kPairs + 1)) - 1);
+
+  // Operations after reordering agree with the new order.
+  EXPECT_EQ(PairwiseProducts(bdd, xs, ys), f);
+}
+
+TEST(BinaryDecisionDiagramTest, DynamicReordering) {
+  BinaryDecisionDiagram bdd;
+  bdd.set_dynamic_reordering(true);
+  constexpr int64_t kPairs = 16;
+  std::vector<BddNodeIndex> xs = bdd.NewVariables(kPairs);
+  std::vector<BddNodeIndex> ys = bdd.NewVariables(kPairs);
+  BddNodeIndex result = bdd.zero();
+  for (int64_t i = 0; i < kPairs; ++i) {
+    BddNodeIndex next = bdd.Or(result, bdd.And(xs[i], ys[i]));
+    bdd.Ref(next);
+    bdd.Deref(result);
+    result = next;
+    bdd.MaybeCollectGarbage();
+  }
+  // Without reordering the final expression alone has 2^(kPairs+1) nodes.
+  EXPECT_GT(bdd.reorder_count(), 0);
+  EXPECT_GT(bdd.garbage_collection_count(), 0);
+  EXPECT_LT(bdd.peak_size(), 1 << 16);
+
+  // With each x next to its y the graph holds the terminal, the base nodes and
+  // 2 * kPairs - 1 nodes for the expression.
+  bdd.Reorder();
+  EXPECT_EQ(bdd.size(), 1 + 2 * kPairs + 2 * kPairs - 1);
+}
+
+void BM_PairwiseProducts(benchmark::State& state) {
+  for (auto _ : state) {
+    BinaryDecisionDiagram bdd;
+    bdd.set_dynamic_reordering(state.range(1) != 0);
+    std::vector<BddNodeIndex> xs = bdd.NewVariables(state.range(0));
+    std::vector<BddNodeIndex> ys = bdd.NewVariables(state.range(0));
+    BddNodeIndex result = bdd.zero();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      BddNodeIndex next = bdd.Or(result, bdd.And(xs[i], ys[i]));
+      bdd.Ref(next);
+      bdd.Deref(result);
+      result = next;
+      bdd.MaybeCollectGarbage();
+    }
+    state.counters["peak_nodes"] = bdd.peak_size();
+  }
+}
+BENCHMARK(BM_PairwiseProducts)
+    ->ArgsProduct({{8, 12, 16}, {0, 1}})
+    ->ArgNames({"pairs", "reorder"});
+
 }  // namespace
 }  // namespace xls
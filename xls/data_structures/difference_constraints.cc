@@ -0,0 +1,330 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/data_structures/difference_constraints.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/log/check.h"
+
+namespace xls {
+namespace {
+
+// Distance of nodes not (yet) reached by a shortest-path search, and the
+// capacity of the arcs of the flow network. Small enough that adding a
+// distance and an arc cost does not overflow.
+constexpr int64_t kInfinity = std::numeric_limits<int64_t>::max() / 4;
+
+}  // namespace
+
+int64_t DifferenceConstraintSystem::AddVariable() {
+  cost_.push_back(0);
+  return variable_count() - 1;
+}
+
+void DifferenceConstraintSystem::AddDifferenceAtLeast(int64_t x, int64_t y,
+                                                      int64_t limit) {
+  arcs_.push_back(Arc{.tail = NodeOf(y), .head = NodeOf(x), .cost = -limit});
+}
+
+void DifferenceConstraintSystem::AddLowerBound(int64_t x, int64_t limit) {
+  arcs_.push_back(Arc{.tail = kOrigin, .head = NodeOf(x), .cost = -limit});
+}
+
+void DifferenceConstraintSystem::AddUpperBound(int64_t x, int64_t limit) {
+  arcs_.push_back(Arc{.tail = NodeOf(x), .head = kOrigin, .cost = limit});
+}
+
+void DifferenceConstraintSystem::AddToObjective(int64_t x, int64_t cost) {
+  cost_[NodeOf(x)] += cost;
+}
+
+DifferenceConstraintSystem::Result DifferenceConstraintSystem::Solve() {
+  solved_ = false;
+  const int64_t node_count = cost_.size();
+
+  // Build the residual network in compressed sparse row form.
+  residual_arc_start_.assign(node_count + 1, 0);
+  for (const Arc& arc : arcs_) {
+    ++residual_arc_start_[arc.tail + 1];
+    ++residual_arc_start_[arc.head + 1];
+  }
+  for (int64_t v = 0; v < node_count; ++v) {
+    residual_arc_start_[v + 1] += residual_arc_start_[v];
+  }
+  residual_arcs_.resize(2 * arcs_.size());
+  std::vector<int64_t> next(residual_arc_start_.begin(),
+                            residual_arc_start_.end() - 1);
+  for (int64_t i = 0; i < arcs_.size(); ++i) {
+    residual_arcs_[next[arcs_[i].tail]++] = 2 * i;
+    residual_arcs_[next[arcs_[i].head]++] = 2 * i + 1;
+  }
+
+  // A node with objective coefficient c must receive a net flow of c.
+  flow_.assign(arcs_.size(), 0);
+  excess_.resize(node_count);
+  excess_[kOrigin] = 0;
+  for (int64_t v = 1; v < node_count; ++v) {
+    excess_[v] = -cost_[v];
+    excess_[kOrigin] += cost_[v];
+  }
+
+  if (!ComputeFeasiblePotentials()) {
+    return Result::kInfeasible;
+  }
+  if (!RouteFlow()) {
+    return Result::kUnbounded;
+  }
+  solved_ = true;
+  return Result::kOptimal;
+}
+
+int64_t DifferenceConstraintSystem::ReducedCost(int64_t residual_arc) const {
+  const Arc& arc = arcs_[residual_arc / 2];
+  if (residual_arc % 2 == 0) {
+    return arc.cost + potential_[arc.tail] - potential_[arc.head];
+  }
+  return -arc.cost + potential_[arc.head] - potential_[arc.tail];
+}
+
+int64_t DifferenceConstraintSystem::ResidualCapacity(
+    int64_t residual_arc) const {
+  return residual_arc % 2 == 0 ? kInfinity : flow_[residual_arc / 2];
+}
+
+bool DifferenceConstraintSystem::ComputeFeasiblePotentials() {
+  const int64_t node_count = cost_.size();
+  potential_.assign(node_count, 0);
+
+  // Shortest distances from a virtual root with a zero-cost arc to every node.
+  // `parent` records the node from which the distance was last lowered. A
+  // cycle among these pointers is a negative-cost cycle; the pointers are
+  // checked for cycles after every `node_count` improvements.
+  std::vector<int64_t> parent(node_count, -1);
+  std::vector<int64_t> visited_by(node_count, -1);
+  auto has_parent_cycle = [&]() {
+    absl::c_fill(visited_by, -1);
+    for (int64_t start = 0; start < node_count; ++start) {
+      int64_t v = start;
+      while (v != -1 && visited_by[v] == -1) {
+        visited_by[v] = start;
+        v = parent[v];
+      }
+      if (v != -1 && visited_by[v] == start) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  std::deque<int64_t> queue;
+  std::vector<bool> in_queue(node_count, true);
+  for (int64_t v = 0; v < node_count; ++v) {
+    queue.push_back(v);
+  }
+  int64_t improvements = 0;
+  while (!queue.empty()) {
+    const int64_t u = queue.front();
+    queue.pop_front();
+    in_queue[u] = false;
+    for (int64_t i = residual_arc_start_[u]; i < residual_arc_start_[u + 1];
+         ++i) {
+      const int64_t residual_arc = residual_arcs_[i];
+      if (residual_arc % 2 != 0) {
+        continue;
+      }
+      const Arc& arc = arcs_[residual_arc / 2];
+      if (potential_[u] + arc.cost >= potential_[arc.head]) {
+        continue;
+      }
+      potential_[arc.head] = potential_[u] + arc.cost;
+      parent[arc.head] = u;
+      if (++improvements % node_count == 0 && has_parent_cycle()) {
+        return false;
+      }
+      if (!in_queue[arc.head]) {
+        in_queue[arc.head] = true;
+        queue.push_back(arc.head);
+      }
+    }
+  }
+  return true;
+}
+
+bool DifferenceConstraintSystem::RouteFlow() {
+  auto has_excess = [&]() {
+    return absl::c_any_of(excess_, [](int64_t e) { return e > 0; });
+  };
+  while (has_excess()) {
+    if (!RaisePotentials()) {
+      return false;
+    }
+    // The potentials were raised along a shortest path to a deficit so that
+    // path is admissible.
+    CHECK(PushBlockingFlow());
+  }
+  return true;
+}
+
+bool DifferenceConstraintSystem::RaisePotentials() {
+  const int64_t node_count = cost_.size();
+  std::vector<int64_t> distance(node_count, kInfinity);
+  using Entry = std::pair<int64_t, int64_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+  for (int64_t v = 0; v < node_count; ++v) {
+    if (excess_[v] > 0) {
+      distance[v] = 0;
+      heap.push({0, v});
+    }
+  }
+  std::optional<int64_t> deficit_distance;
+  while (!heap.empty()) {
+    auto [d, u] = heap.top();
+    heap.pop();
+    if (d > distance[u]) {
+      continue;
+    }
+    if (excess_[u] < 0) {
+      deficit_distance = d;
+      break;
+    }
+    for (int64_t i = residual_arc_start_[u]; i < residual_arc_start_[u + 1];
+         ++i) {
+      const int64_t residual_arc = residual_arcs_[i];
+      if (ResidualCapacity(residual_arc) == 0) {
+        continue;
+      }
+      const Arc& arc = arcs_[residual_arc / 2];
+      const int64_t v = residual_arc % 2 == 0 ? arc.head : arc.tail;
+      const int64_t candidate = d + ReducedCost(residual_arc);
+      if (candidate < distance[v]) {
+        distance[v] = candidate;
+        heap.push({candidate, v});
+      }
+    }
+  }
+  if (!deficit_distance.has_value()) {
+    return false;
+  }
+  // Capping the distances at the distance of the closest deficit keeps the
+  // reduced costs of all residual arcs non-negative.
+  for (int64_t v = 0; v < node_count; ++v) {
+    potential_[v] += std::min(distance[v], *deficit_distance);
+  }
+  return true;
+}
+
+bool DifferenceConstraintSystem::PushBlockingFlow() {
+  const int64_t node_count = cost_.size();
+  auto admissible = [&](int64_t residual_arc) {
+    return ResidualCapacity(residual_arc) > 0 && ReducedCost(residual_arc) == 0;
+  };
+  auto head_of = [&](int64_t residual_arc) {
+    const Arc& arc = arcs_[residual_arc / 2];
+    return residual_arc % 2 == 0 ? arc.head : arc.tail;
+  };
+
+  bool pushed = false;
+  std::vector<int64_t> queue;
+  std::vector<int64_t> path;
+  while (true) {
+    // Layer the admissible network by distance from the nodes with excess.
+    // Nodes with a deficit terminate paths so they are not expanded.
+    level_.assign(node_count, -1);
+    queue.clear();
+    for (int64_t v = 0; v < node_count; ++v) {
+      if (excess_[v] > 0) {
+        level_[v] = 0;
+        queue.push_back(v);
+      }
+    }
+    bool reached_deficit = false;
+    for (int64_t q = 0; q < queue.size(); ++q) {
+      const int64_t u = queue[q];
+      for (int64_t i = residual_arc_start_[u]; i < residual_arc_start_[u + 1];
+           ++i) {
+        const int64_t residual_arc = residual_arcs_[i];
+        const int64_t v = head_of(residual_arc);
+        if (level_[v] != -1 || !admissible(residual_arc)) {
+          continue;
+        }
+        level_[v] = level_[u] + 1;
+        if (excess_[v] < 0) {
+          reached_deficit = true;
+        } else {
+          queue.push_back(v);
+        }
+      }
+    }
+    if (!reached_deficit) {
+      return pushed;
+    }
+
+    // Augment along shortest admissible paths until none is left, advancing
+    // past exhausted arcs as in Dinic's algorithm.
+    current_arc_.assign(residual_arc_start_.begin(),
+                        residual_arc_start_.end() - 1);
+    for (int64_t source = 0; source < node_count; ++source) {
+      while (excess_[source] > 0 && level_[source] == 0) {
+        path.clear();
+        int64_t u = source;
+        while (excess_[u] >= 0) {
+          int64_t& i = current_arc_[u];
+          while (i < residual_arc_start_[u + 1] &&
+                 (level_[head_of(residual_arcs_[i])] != level_[u] + 1 ||
+                  !admissible(residual_arcs_[i]))) {
+            ++i;
+          }
+          if (i < residual_arc_start_[u + 1]) {
+            path.push_back(residual_arcs_[i]);
+            u = head_of(residual_arcs_[i]);
+            continue;
+          }
+          // Dead end: retreat and skip the arc leading here.
+          level_[u] = -1;
+          if (path.empty()) {
+            break;
+          }
+          path.pop_back();
+          u = path.empty() ? source : head_of(path.back());
+          ++current_arc_[u];
+        }
+        if (excess_[u] >= 0) {
+          break;
+        }
+        int64_t amount = std::min(excess_[source], -excess_[u]);
+        for (int64_t residual_arc : path) {
+          amount = std::min(amount, ResidualCapacity(residual_arc));
+        }
+        for (int64_t residual_arc : path) {
+          flow_[residual_arc / 2] += residual_arc % 2 == 0 ? amount : -amount;
+        }
+        excess_[source] -= amount;
+        excess_[u] += amount;
+        pushed = true;
+      }
+    }
+  }
+}
+
+}  // namespace xls
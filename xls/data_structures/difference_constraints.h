@@ -0,0 +1,155 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DATA_STRUCTURES_DIFFERENCE_CONSTRAINTS_H_
+#define XLS_DATA_STRUCTURES_DIFFERENCE_CONSTRAINTS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/log/check.h"
+
+namespace xls {
+
+// A linear program over integer variables x_0, ..., x_{n-1} in which every
+// constraint bounds the difference of two variables (x - y >= limit) or a
+// single variable, and whose objective is to minimize a linear function of
+// the variables.
+//
+// The constraint matrix of such a program is totally unimodular, so the
+// optimum is attained at integer values. Rather than using a general LP
+// solver, the program is solved through its dual, which is an uncapacitated
+// minimum-cost flow problem: every constraint x - y >= limit is an arc from y
+// to x with cost -limit, and every objective coefficient is the demand of a
+// node. The optimal values are the node potentials of a minimum-cost flow.
+//
+// Solve() first computes feasible potentials with a queue-based Bellman-Ford
+// search, which also detects infeasible (cyclic) constraints, and then runs a
+// primal-dual algorithm: each phase raises the potentials along shortest paths
+// from the nodes with excess supply and routes a blocking flow over the
+// zero-reduced-cost arcs. The number of phases is bounded by the range of the
+// optimal values, which makes this fast for scheduling problems where the
+// values are pipeline stages.
+class DifferenceConstraintSystem {
+ public:
+  enum class Result : int8_t {
+    // An optimal solution was found and is available through value().
+    kOptimal,
+    // No assignment satisfies the constraints.
+    kInfeasible,
+    // The objective is unbounded below over the feasible assignments.
+    kUnbounded,
+  };
+
+  DifferenceConstraintSystem() = default;
+
+  // Adds a new variable and returns its index. Variables are numbered
+  // consecutively from zero.
+  int64_t AddVariable();
+  int64_t variable_count() const { return cost_.size() - 1; }
+
+  // Adds the constraint x - y >= limit.
+  void AddDifferenceAtLeast(int64_t x, int64_t y, int64_t limit);
+
+  // Adds the constraint x - y <= limit.
+  void AddDifferenceAtMost(int64_t x, int64_t y, int64_t limit) {
+    AddDifferenceAtLeast(y, x, -limit);
+  }
+
+  // Adds the constraint x >= limit.
+  void AddLowerBound(int64_t x, int64_t limit);
+
+  // Adds the constraint x <= limit.
+  void AddUpperBound(int64_t x, int64_t limit);
+
+  // Adds `cost * x` to the minimized objective.
+  void AddToObjective(int64_t x, int64_t cost);
+
+  // Solves the program. Constraints and objective terms may be added between
+  // calls.
+  Result Solve();
+
+  // Returns the value of `x` in the solution found by the last call to
+  // Solve(), which must have returned kOptimal.
+  int64_t value(int64_t x) const {
+    CHECK(solved_);
+    return potential_[kOrigin] - potential_[NodeOf(x)];
+  }
+
+  int64_t constraint_count() const { return arcs_.size(); }
+
+ private:
+  // An arc of the flow network for the constraint head - tail >= limit. The
+  // arc has unlimited capacity and cost -limit.
+  struct Arc {
+    int64_t tail;
+    int64_t head;
+    int64_t cost;
+  };
+
+  // Node of the flow network which represents the constant zero. Bounds on
+  // single variables are differences to this node.
+  static constexpr int64_t kOrigin = 0;
+
+  int64_t NodeOf(int64_t x) const {
+    CHECK_GE(x, 0);
+    CHECK_LT(x, variable_count());
+    return x + 1;
+  }
+
+  // Sets `potential_` to potentials under which every arc has a non-negative
+  // reduced cost. Returns false if there is a negative-cost cycle, i.e., the
+  // constraints are infeasible.
+  bool ComputeFeasiblePotentials();
+
+  // Routes the supplies to the demands along shortest paths, maintaining the
+  // optimality of `potential_`. Returns false if some supply cannot reach a
+  // demand, i.e., the objective is unbounded.
+  bool RouteFlow();
+
+  // Raises `potential_` by the shortest-path distances from the nodes with
+  // excess, capped at the distance to the closest node with a deficit. Returns
+  // false if no such node is reachable.
+  bool RaisePotentials();
+
+  // Pushes a blocking flow from the nodes with excess to the nodes with a
+  // deficit over arcs with zero reduced cost. Returns false if no node with a
+  // deficit is reachable over such arcs.
+  bool PushBlockingFlow();
+
+  int64_t ReducedCost(int64_t residual_arc) const;
+  int64_t ResidualCapacity(int64_t residual_arc) const;
+
+  // The objective coefficient of every node. The origin has the negated sum of
+  // all coefficients so that the demands of the flow problem are balanced.
+  std::vector<int64_t> cost_ = {0};
+  std::vector<Arc> arcs_;
+
+  // The residual network: residual arc 2 * i is arc i and residual arc
+  // 2 * i + 1 is its reversal. `residual_arcs_` lists the residual arcs
+  // leaving node v at [residual_arc_start_[v], residual_arc_start_[v + 1]).
+  std::vector<int64_t> residual_arc_start_;
+  std::vector<int64_t> residual_arcs_;
+  std::vector<int64_t> flow_;
+  std::vector<int64_t> excess_;
+  std::vector<int64_t> potential_;
+  // Scratch space for the blocking flow computations.
+  std::vector<int64_t> level_;
+  std::vector<int64_t> current_arc_;
+  bool solved_ = false;
+};
+
+}  // namespace xls
+
+#endif  // XLS_DATA_STRUCTURES_DIFFERENCE_CONSTRAINTS_H_
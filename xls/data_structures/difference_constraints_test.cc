@@ -0,0 +1,291 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/data_structures/difference_constraints.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/check.h"
+#include "benchmark/benchmark.h"
+
+namespace xls {
+namespace {
+
+using Result = DifferenceConstraintSystem::Result;
+
+TEST(DifferenceConstraintsTest, NoConstraints) {
+  DifferenceConstraintSystem system;
+  int64_t x = system.AddVariable();
+  ASSERT_EQ(system.Solve(), Result::kOptimal);
+  EXPECT_EQ(system.value(x), 0);
+}
+
+TEST(DifferenceConstraintsTest, MinimizeSum) {
+  DifferenceConstraintSystem system;
+  int64_t x = system.AddVariable();
+  int64_t y = system.AddVariable();
+  system.AddDifferenceAtLeast(x, y, 3);
+  system.AddLowerBound(y, 2);
+  system.AddToObjective(x, 1);
+  system.AddToObjective(y, 1);
+  ASSERT_EQ(system.Solve(), Result::kOptimal);
+  EXPECT_EQ(system.value(x), 5);
+  EXPECT_EQ(system.value(y), 2);
+}
+
+TEST(DifferenceConstraintsTest, MaximizeWithUpperBounds) {
+  DifferenceConstraintSystem system;
+  int64_t x = system.AddVariable();
+  int64_t y = system.AddVariable();
+  system.AddDifferenceAtMost(x, y, -4);
+  system.AddUpperBound(y, 10);
+  system.AddToObjective(x, -1);
+  ASSERT_EQ(system.Solve(), Result::kOptimal);
+  EXPECT_EQ(system.value(x), 6);
+  EXPECT_EQ(system.value(y), 10);
+}
+
+TEST(DifferenceConstraintsTest, MinimizeLifetime) {
+  // A value defined in `def` and used in `use1` and `use2`, which are pinned
+  // to stages 1 and 3. `last_use` - `def` is the lifetime of the value which
+  // is cheaper the later `def` is scheduled, up to the first use.
+  DifferenceConstraintSystem system;
+  int64_t def = system.AddVariable();
+  int64_t use1 = system.AddVariable();
+  int64_t use2 = system.AddVariable();
+  int64_t last_use = system.AddVariable();
+  system.AddLowerBound(def, 0);
+  system.AddDifferenceAtLeast(use1, def, 0);
+  system.AddDifferenceAtLeast(use2, def, 0);
+  system.AddDifferenceAtLeast(last_use, use1, 0);
+  system.AddDifferenceAtLeast(last_use, use2, 0);
+  system.AddDifferenceAtLeast(last_use, def, 0);
+  system.AddLowerBound(use1, 1);
+  system.AddUpperBound(use1, 1);
+  system.AddLowerBound(use2, 3);
+  system.AddUpperBound(use2, 3);
+  system.AddToObjective(last_use, 32);
+  system.AddToObjective(def, -32);
+  ASSERT_EQ(system.Solve(), Result::kOptimal);
+  EXPECT_EQ(system.value(def), 1);
+  EXPECT_EQ(system.value(last_use), 3);
+}
+
+TEST(DifferenceConstraintsTest, Infeasible) {
+  DifferenceConstraintSystem system;
+  int64_t x = system.AddVariable();
+  int64_t y = system.AddVariable();
+  int64_t z = system.AddVariable();
+  system.AddDifferenceAtLeast(y, x, 1);
+  system.AddDifferenceAtLeast(z, y, 1);
+  system.AddDifferenceAtMost(z, x, 1);
+  EXPECT_EQ(system.Solve(), Result::kInfeasible);
+}
+
+TEST(DifferenceConstraintsTest, InfeasibleBounds) {
+  DifferenceConstraintSystem system;
+  int64_t x = system.AddVariable();
+  system.AddLowerBound(x, 3);
+  system.AddUpperBound(x, 2);
+  system.AddToObjective(x, 1);
+  EXPECT_EQ(system.Solve(), Result::kInfeasible);
+}
+
+TEST(DifferenceConstraintsTest, Unbounded) {
+  DifferenceConstraintSystem system;
+  int64_t x = system.AddVariable();
+  int64_t y = system.AddVariable();
+  system.AddDifferenceAtLeast(x, y, 0);
+  system.AddUpperBound(x, 5);
+  system.AddToObjective(y, 1);
+  EXPECT_EQ(system.Solve(), Result::kUnbounded);
+}
+
+TEST(DifferenceConstraintsTest, ResolveAfterChanges) {
+  DifferenceConstraintSystem system;
+  int64_t x = system.AddVariable();
+  int64_t y = system.AddVariable();
+  system.AddLowerBound(x, 0);
+  system.AddLowerBound(y, 0);
+  system.AddToObjective(x, 1);
+  system.AddToObjective(y, 1);
+  ASSERT_EQ(system.Solve(), Result::kOptimal);
+  EXPECT_EQ(system.value(x), 0);
+  EXPECT_EQ(system.value(y), 0);
+
+  system.AddDifferenceAtLeast(y, x, 2);
+  system.AddDifferenceAtLeast(x, system.AddVariable(), 1);
+  ASSERT_EQ(system.Solve(), Result::kOptimal);
+  EXPECT_EQ(system.value(x), 0);
+  EXPECT_EQ(system.value(y), 2);
+}
+
+// Solves a random system with every variable bounded to [0, kRange] and
+// compares against an exhaustive search over all assignments.
+TEST(DifferenceConstraintsTest, MatchesExhaustiveSearch) {
+  constexpr int64_t kRange = 3;
+  std::mt19937_64 rng(42);
+  for (int64_t trial = 0; trial < 500; ++trial) {
+    const int64_t variable_count =
+        std::uniform_int_distribution<int64_t>(1, 5)(rng);
+    const int64_t constraint_count =
+        std::uniform_int_distribution<int64_t>(0, 8)(rng);
+    struct Constraint {
+      int64_t x;
+      int64_t y;
+      int64_t limit;
+    };
+    std::vector<Constraint> constraints;
+    std::vector<int64_t> costs;
+    DifferenceConstraintSystem system;
+    for (int64_t i = 0; i < variable_count; ++i) {
+      system.AddVariable();
+      system.AddLowerBound(i, 0);
+      system.AddUpperBound(i, kRange);
+      costs.push_back(std::uniform_int_distribution<int64_t>(-4, 4)(rng));
+      system.AddToObjective(i, costs.back());
+    }
+    std::uniform_int_distribution<int64_t> variable(0, variable_count - 1);
+    for (int64_t i = 0; i < constraint_count; ++i) {
+      Constraint c{.x = variable(rng),
+                   .y = variable(rng),
+                   .limit = std::uniform_int_distribution<int64_t>(
+                       -kRange, kRange)(rng)};
+      constraints.push_back(c);
+      system.AddDifferenceAtLeast(c.x, c.y, c.limit);
+    }
+
+    auto satisfies = [&](const std::vector<int64_t>& values) {
+      for (const Constraint& c : constraints) {
+        if (values[c.x] - values[c.y] < c.limit) {
+          return false;
+        }
+      }
+      return true;
+    };
+    auto objective = [&](const std::vector<int64_t>& values) {
+      int64_t result = 0;
+      for (int64_t i = 0; i < variable_count; ++i) {
+        result += costs[i] * values[i];
+      }
+      return result;
+    };
+    std::optional<int64_t> best;
+    std::vector<int64_t> values(variable_count, 0);
+    while (true) {
+      if (satisfies(values) &&
+          (!best.has_value() || objective(values) < *best)) {
+        best = objective(values);
+      }
+      int64_t i = 0;
+      while (i < variable_count && values[i] == kRange) {
+        values[i++] = 0;
+      }
+      if (i == variable_count) {
+        break;
+      }
+      ++values[i];
+    }
+
+    Result result = system.Solve();
+    if (!best.has_value()) {
+      EXPECT_EQ(result, Result::kInfeasible) << "trial " << trial;
+      continue;
+    }
+    ASSERT_EQ(result, Result::kOptimal) << "trial " << trial;
+    for (int64_t i = 0; i < variable_count; ++i) {
+      values[i] = system.value(i);
+      EXPECT_GE(values[i], 0) << "trial " << trial;
+      EXPECT_LE(values[i], kRange) << "trial " << trial;
+    }
+    EXPECT_TRUE(satisfies(values)) << "trial " << trial;
+    EXPECT_EQ(objective(values), *best) << "trial " << trial;
+  }
+}
+
+// Builds a system shaped like an SDC scheduling problem: a random dataflow
+// graph whose nodes are scheduled into `stage_count` stages with timing
+// constraints between random pairs, minimizing the weighted lifetimes.
+DifferenceConstraintSystem SchedulingSystem(int64_t node_count,
+                                            int64_t stage_count) {
+  std::mt19937_64 rng(0);
+  DifferenceConstraintSystem system;
+  int64_t last_stage = system.AddVariable();
+  system.AddLowerBound(last_stage, stage_count - 1);
+  system.AddUpperBound(last_stage, stage_count - 1);
+  std::vector<int64_t> cycle;
+  std::vector<int64_t> last_use;
+  for (int64_t i = 0; i < node_count; ++i) {
+    cycle.push_back(system.AddVariable());
+    last_use.push_back(system.AddVariable());
+    system.AddLowerBound(cycle[i], 0);
+    system.AddDifferenceAtMost(cycle[i], last_stage, 0);
+    system.AddDifferenceAtLeast(last_use[i], cycle[i], 0);
+    int64_t weight = 1024 * std::uniform_int_distribution<int64_t>(1, 64)(rng);
+    system.AddToObjective(last_use[i], weight);
+    system.AddToObjective(cycle[i], 1 - weight);
+    if (i == 0) {
+      continue;
+    }
+    std::uniform_int_distribution<int64_t> earlier(std::max<int64_t>(0, i - 64),
+                                                   i - 1);
+    for (int64_t j = 0; j < 2; ++j) {
+      int64_t operand = earlier(rng);
+      system.AddDifferenceAtLeast(cycle[i], cycle[operand], 0);
+      system.AddDifferenceAtLeast(last_use[operand], cycle[i], 0);
+    }
+  }
+  // Timing constraints: nodes far apart in the graph are in different stages.
+  int64_t span = std::max<int64_t>(2, node_count / stage_count);
+  for (int64_t i = span; i < node_count; ++i) {
+    system.AddDifferenceAtLeast(cycle[i], cycle[i - span], 1);
+  }
+  return system;
+}
+
+TEST(DifferenceConstraintsTest, SchedulingSystemIsFeasible) {
+  DifferenceConstraintSystem system = SchedulingSystem(1000, 8);
+  EXPECT_EQ(system.Solve(), Result::kOptimal);
+}
+
+void BM_SolveSchedulingSystem(benchmark::State& state) {
+  DifferenceConstraintSystem system =
+      SchedulingSystem(state.range(0), state.range(1));
+  for (auto _ : state) {
+    CHECK(system.Solve() == Result::kOptimal);
+  }
+}
+BENCHMARK(BM_SolveSchedulingSystem)
+    ->ArgsProduct({{100, 1000, 10000}, {4, 16}});
+
+void BM_DetectInfeasibleSchedulingSystem(benchmark::State& state) {
+  // Too few stages for the chain of timing constraints.
+  DifferenceConstraintSystem system =
+      SchedulingSystem(state.range(0), state.range(1));
+  system.AddUpperBound(0, state.range(1) - 2);
+  for (auto _ : state) {
+    CHECK(system.Solve() == Result::kInfeasible);
+  }
+}
+BENCHMARK(BM_DetectInfeasibleSchedulingSystem)
+    ->ArgsProduct({{100, 1000, 10000}, {4, 16}});
+
+}  // namespace
+}  // namespace xls
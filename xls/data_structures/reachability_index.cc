@@ -0,0 +1,361 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/data_structures/reachability_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xls/common/work_stealing_thread_pool.h"
+#include "xls/data_structures/inline_bitmap.h"
+
+namespace xls {
+namespace {
+
+// Graphs with fewer vertices are labeled on the calling thread as scheduling
+// helpers would cost more than the traversals themselves.
+constexpr int64_t kMinParallelVertexCount = 4096;
+
+using Interval = ReachabilityIndex::Interval;
+
+// Successor lists in compressed sparse row form.
+struct Graph {
+  std::vector<int32_t> offsets;
+  std::vector<int32_t> targets;
+
+  int32_t vertex_count() const { return offsets.size() - 1; }
+  absl::Span<const int32_t> successors(int32_t v) const {
+    return absl::MakeConstSpan(targets).subspan(offsets[v],
+                                                offsets[v + 1] - offsets[v]);
+  }
+};
+
+struct Traversal {
+  // Interval of post-order numbers of the depth-first tree descendants.
+  std::vector<Interval> tree;
+  // Interval from the lowest post-order number reachable to the post-order
+  // number of the vertex.
+  std::vector<Interval> label;
+  bool has_cycle = false;
+};
+
+// Labels shared out between the threads computing them.
+struct LabelWork {
+  explicit LabelWork(int64_t label_count) : label_count(label_count) {}
+
+  bool AllDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+    return done_count == label_count;
+  }
+
+  const int64_t label_count;
+  std::atomic<int64_t> next_label = 0;
+  absl::Mutex mutex;
+  int64_t done_count ABSL_GUARDED_BY(mutex) = 0;
+};
+
+// Visits the graph depth-first starting from `roots`. If `seed` is non-zero
+// the roots and the successors of each vertex are visited in a random order
+// derived from `seed`, otherwise they are visited in order.
+Traversal Traverse(const Graph& graph, std::vector<int32_t> roots,
+                   uint64_t seed) {
+  const int32_t vertex_count = graph.vertex_count();
+  std::vector<int32_t> shuffled_targets;
+  absl::Span<const int32_t> targets = graph.targets;
+  if (seed != 0) {
+    std::mt19937_64 rng(seed);
+    shuffled_targets = graph.targets;
+    for (int32_t v = 0; v < vertex_count; ++v) {
+      std::shuffle(shuffled_targets.begin() + graph.offsets[v],
+                   shuffled_targets.begin() + graph.offsets[v + 1], rng);
+    }
+    std::shuffle(roots.begin(), roots.end(), rng);
+    targets = shuffled_targets;
+  }
+
+  enum class State : uint8_t { kUnvisited, kActive, kFinished };
+  struct Frame {
+    int32_t vertex;
+    int32_t next_edge;
+  };
+  std::vector<State> state(vertex_count, State::kUnvisited);
+  std::vector<Frame> stack;
+  Traversal result;
+  result.tree.resize(vertex_count);
+  result.label.resize(vertex_count);
+  int32_t post = 0;
+  auto enter = [&](int32_t v) {
+    state[v] = State::kActive;
+    result.tree[v].lo = post;
+    stack.push_back({v, graph.offsets[v]});
+  };
+  for (int32_t root : roots) {
+    if (state[root] != State::kUnvisited) {
+      continue;
+    }
+    enter(root);
+    while (!stack.empty()) {
+      Frame& frame = stack.back();
+      if (frame.next_edge < graph.offsets[frame.vertex + 1]) {
+        int32_t successor = targets[frame.next_edge++];
+        if (state[successor] == State::kUnvisited) {
+          enter(successor);
+        } else if (state[successor] == State::kActive) {
+          result.has_cycle = true;
+        }
+        continue;
+      }
+      int32_t v = frame.vertex;
+      stack.pop_back();
+      state[v] = State::kFinished;
+      result.tree[v].hi = post;
+      int32_t lo = result.tree[v].lo;
+      for (int32_t successor : graph.successors(v)) {
+        lo = std::min(lo, result.label[successor].lo);
+      }
+      result.label[v] = Interval{.lo = lo, .hi = post};
+      ++post;
+    }
+  }
+  // Vertices on a cycle without a path from a root are never visited.
+  if (post != vertex_count) {
+    result.has_cycle = true;
+  }
+  return result;
+}
+
+}  // namespace
+
+/* static */ absl::StatusOr<ReachabilityIndex> ReachabilityIndex::Create(
+    int64_t vertex_count, absl::Span<const std::pair<int64_t, int64_t>> edges,
+    const ReachabilityIndexOptions& options) {
+  if (vertex_count < 0 ||
+      vertex_count >= std::numeric_limits<int32_t>::max() ||
+      edges.size() >= std::numeric_limits<int32_t>::max()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported graph size: %d vertices, %d edges",
+                        vertex_count, edges.size()));
+  }
+
+  // Build the deduplicated successor lists.
+  Graph graph;
+  graph.offsets.resize(vertex_count + 1, 0);
+  for (const auto& [from, to] : edges) {
+    if (from < 0 || from >= vertex_count || to < 0 || to >= vertex_count) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Edge (%d, %d) refers to a vertex outside [0, %d)",
+                          from, to, vertex_count));
+    }
+    ++graph.offsets[from + 1];
+  }
+  for (int64_t v = 0; v < vertex_count; ++v) {
+    graph.offsets[v + 1] += graph.offsets[v];
+  }
+  graph.targets.resize(edges.size());
+  {
+    std::vector<int32_t> cursor(graph.offsets.begin(), graph.offsets.end() - 1);
+    for (const auto& [from, to] : edges) {
+      graph.targets[cursor[from]++] = to;
+    }
+  }
+  std::vector<bool> has_predecessor(vertex_count, false);
+  int32_t write = 0;
+  int32_t begin = 0;
+  for (int32_t v = 0; v < vertex_count; ++v) {
+    int32_t end = graph.offsets[v + 1];
+    std::sort(graph.targets.begin() + begin, graph.targets.begin() + end);
+    graph.offsets[v] = write;
+    for (int32_t i = begin; i < end; ++i) {
+      int32_t target = graph.targets[i];
+      if (write > graph.offsets[v] && graph.targets[write - 1] == target) {
+        continue;
+      }
+      graph.targets[write++] = target;
+      has_predecessor[target] = true;
+    }
+    begin = end;
+  }
+  graph.offsets[vertex_count] = write;
+  graph.targets.resize(write);
+  graph.targets.shrink_to_fit();
+
+  std::vector<int32_t> roots;
+  for (int32_t v = 0; v < vertex_count; ++v) {
+    if (!has_predecessor[v]) {
+      roots.push_back(v);
+    }
+  }
+
+  // Each label is an independent traversal so they may be computed
+  // concurrently. Label zero visits vertices in order and also defines the
+  // spanning forest.
+  const int64_t label_count = std::max(options.label_count, int64_t{1});
+  std::vector<Traversal> traversals(label_count);
+  if (options.thread_pool == nullptr ||
+      vertex_count < kMinParallelVertexCount) {
+    for (int64_t i = 0; i < label_count; ++i) {
+      traversals[i] = Traverse(graph, roots, /*seed=*/i);
+    }
+  } else {
+    // Labels are claimed from a shared counter by the calling thread and by
+    // helper tasks on the pool. The caller only waits for labels which a
+    // helper has already claimed so it never waits on a task which has not
+    // started. Helpers which start late find no label left and only touch the
+    // shared state.
+    auto work = std::make_shared<LabelWork>(label_count);
+    auto traverse_labels = [&traversals, &graph, &roots](LabelWork& work) {
+      for (int64_t i = work.next_label++; i < work.label_count;
+           i = work.next_label++) {
+        traversals[i] = Traverse(graph, roots, /*seed=*/i);
+        absl::MutexLock lock(&work.mutex);
+        ++work.done_count;
+      }
+    };
+    const int64_t helper_count =
+        std::min(options.thread_pool->thread_count(), label_count - 1);
+    for (int64_t t = 0; t < helper_count; ++t) {
+      options.thread_pool->Schedule(
+          [work, traverse_labels]() { traverse_labels(*work); });
+    }
+    traverse_labels(*work);
+    absl::MutexLock lock(&work->mutex);
+    work->mutex.Await(absl::Condition(work.get(), &LabelWork::AllDone));
+  }
+  if (traversals[0].has_cycle) {
+    return absl::InvalidArgumentError("Graph contains a cycle");
+  }
+
+  ReachabilityIndex index;
+  index.tree_ = std::move(traversals[0].tree);
+  index.labels_.reserve(label_count);
+  for (Traversal& traversal : traversals) {
+    index.labels_.push_back(std::move(traversal.label));
+  }
+  index.vertex_at_post_.resize(vertex_count);
+  for (int32_t v = 0; v < vertex_count; ++v) {
+    index.vertex_at_post_[index.tree_[v].hi] = v;
+  }
+
+  // Tree edges and forward edges stay within the tree interval of their
+  // source. Only the remaining (cross) edges need to be searched.
+  index.exception_offsets_.reserve(vertex_count + 1);
+  for (int32_t post = 0; post < vertex_count; ++post) {
+    index.exception_offsets_.push_back(index.exception_targets_.size());
+    int32_t v = index.vertex_at_post_[post];
+    for (int32_t successor : graph.successors(v)) {
+      if (!index.TreeReaches(v, successor)) {
+        index.exception_targets_.push_back(successor);
+      }
+    }
+  }
+  index.exception_offsets_.push_back(index.exception_targets_.size());
+  index.exception_targets_.shrink_to_fit();
+  return index;
+}
+
+bool ReachabilityIndex::LabelsMayReach(int32_t from, int32_t to) const {
+  for (const std::vector<Interval>& label : labels_) {
+    if (!label[from].Contains(label[to])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ReachabilityIndex::IsReachable(int64_t from, int64_t to) const {
+  DCHECK_GE(from, 0);
+  DCHECK_LT(from, vertex_count());
+  DCHECK_GE(to, 0);
+  DCHECK_LT(to, vertex_count());
+  if (TreeReaches(from, to)) {
+    return true;
+  }
+  if (!LabelsMayReach(from, to)) {
+    return false;
+  }
+  // Any path leaving the tree interval of a vertex does so through an
+  // exception edge of one of its tree descendants.
+  std::vector<int32_t> stack = {static_cast<int32_t>(from)};
+  absl::flat_hash_set<int32_t> visited = {static_cast<int32_t>(from)};
+  while (!stack.empty()) {
+    int32_t v = stack.back();
+    stack.pop_back();
+    for (int32_t e = exception_offsets_[tree_[v].lo];
+         e < exception_offsets_[tree_[v].hi + 1]; ++e) {
+      int32_t successor = exception_targets_[e];
+      if (TreeReaches(v, successor)) {
+        continue;
+      }
+      if (TreeReaches(successor, to)) {
+        return true;
+      }
+      if (LabelsMayReach(successor, to) && visited.insert(successor).second) {
+        stack.push_back(successor);
+      }
+    }
+  }
+  return false;
+}
+
+InlineBitmap ReachabilityIndex::GetReachable(int64_t from) const {
+  DCHECK_GE(from, 0);
+  DCHECK_LT(from, vertex_count());
+  InlineBitmap result(vertex_count());
+  std::vector<int32_t> stack = {static_cast<int32_t>(from)};
+  result.Set(from);
+  while (!stack.empty()) {
+    int32_t v = stack.back();
+    stack.pop_back();
+    for (int32_t post = tree_[v].lo; post <= tree_[v].hi; ++post) {
+      result.Set(vertex_at_post_[post]);
+    }
+    for (int32_t e = exception_offsets_[tree_[v].lo];
+         e < exception_offsets_[tree_[v].hi + 1]; ++e) {
+      int32_t successor = exception_targets_[e];
+      if (!result.Get(successor)) {
+        result.Set(successor);
+        stack.push_back(successor);
+      }
+    }
+  }
+  return result;
+}
+
+int64_t ReachabilityIndex::MemoryUsage() const {
+  int64_t bytes = tree_.capacity() * sizeof(Interval) +
+                  labels_.capacity() * sizeof(std::vector<Interval>) +
+                  vertex_at_post_.capacity() * sizeof(int32_t) +
+                  exception_offsets_.capacity() * sizeof(int32_t) +
+                  exception_targets_.capacity() * sizeof(int32_t);
+  for (const std::vector<Interval>& label : labels_) {
+    bytes += label.capacity() * sizeof(Interval);
+  }
+  return bytes;
+}
+
+}  // namespace xls
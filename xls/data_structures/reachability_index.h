@@ -0,0 +1,130 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_DATA_STRUCTURES_REACHABILITY_INDEX_H_
+#define XLS_DATA_STRUCTURES_REACHABILITY_INDEX_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/common/work_stealing_thread_pool.h"
+#include "xls/data_structures/inline_bitmap.h"
+
+namespace xls {
+
+struct ReachabilityIndexOptions {
+  // Number of randomized depth-first traversals used to label the vertices.
+  // Each label can prove that a vertex is *not* reachable in constant time.
+  // More labels prune more of the search done by queries at the cost of eight
+  // bytes per vertex per label.
+  int64_t label_count = 3;
+
+  // Pool whose workers help compute the labels. If null, or if the graph is
+  // small, the labels are computed on the calling thread. The calling thread
+  // computes labels as well so the index may be built from a task running on
+  // `thread_pool` itself.
+  WorkStealingThreadPool* thread_pool = nullptr;
+};
+
+// A compressed reachability index for a directed acyclic graph with vertices
+// numbered [0, vertex_count).
+//
+// Rather than materializing the transitive closure, which requires O(V^2)
+// memory, the index stores O(V + E) data:
+//
+//  * A depth-first spanning forest labels every vertex with the interval of
+//    post-order numbers of its tree descendants. `to` lying within the tree
+//    interval of `from` proves reachability.
+//
+//  * A number of randomized depth-first traversals label every vertex with an
+//    interval [lowest post-order number reachable, own post-order number]
+//    (GRAIL labeling). If `to` is reachable from `from` the interval of `to`
+//    is contained in the interval of `from`, so a non-contained interval
+//    proves unreachability.
+//
+//  * The non-tree edges which leave the tree interval of their source are
+//    kept as exception lists stored in post-order. The exceptions of the tree
+//    descendants of a vertex are therefore a contiguous range.
+//
+// Queries not decided by the labels are answered lazily by a search which
+// follows only the exception edges and is pruned by the labels. Labels are
+// computed concurrently.
+//
+// The index is immutable after construction and safe to query concurrently.
+class ReachabilityIndex {
+ public:
+  // Builds the index for the graph with the given edges. Returns an error if
+  // the graph contains a cycle or an edge refers to a vertex out of range.
+  // Duplicate edges are allowed.
+  static absl::StatusOr<ReachabilityIndex> Create(
+      int64_t vertex_count,
+      absl::Span<const std::pair<int64_t, int64_t>> edges,
+      const ReachabilityIndexOptions& options = ReachabilityIndexOptions());
+
+  ReachabilityIndex(ReachabilityIndex&&) = default;
+  ReachabilityIndex& operator=(ReachabilityIndex&&) = default;
+  ReachabilityIndex(const ReachabilityIndex&) = default;
+  ReachabilityIndex& operator=(const ReachabilityIndex&) = default;
+
+  int64_t vertex_count() const { return tree_.size(); }
+  int64_t label_count() const { return labels_.size(); }
+
+  // Returns true if there is a path from `from` to `to`. Every vertex reaches
+  // itself.
+  bool IsReachable(int64_t from, int64_t to) const;
+
+  // Returns the set of vertices reachable from `from`, including `from`
+  // itself, indexed by vertex number.
+  InlineBitmap GetReachable(int64_t from) const;
+
+  // Returns the number of bytes of heap memory held by the index.
+  int64_t MemoryUsage() const;
+
+  // A closed interval of post-order numbers.
+  struct Interval {
+    int32_t lo = 0;
+    int32_t hi = 0;
+
+    bool Contains(const Interval& other) const {
+      return lo <= other.lo && other.hi <= hi;
+    }
+  };
+
+ private:
+  ReachabilityIndex() = default;
+
+  bool TreeReaches(int32_t from, int32_t to) const {
+    return tree_[from].lo <= tree_[to].hi && tree_[to].hi <= tree_[from].hi;
+  }
+  bool LabelsMayReach(int32_t from, int32_t to) const;
+
+  // Tree interval of each vertex. `hi` is the post-order number of the vertex.
+  std::vector<Interval> tree_;
+  // GRAIL labels, indexed by label then by vertex.
+  std::vector<std::vector<Interval>> labels_;
+  // Vertex with each post-order number.
+  std::vector<int32_t> vertex_at_post_;
+  // Exception edge targets of the vertex with post-order number `p` are
+  // exception_targets_[exception_offsets_[p], exception_offsets_[p + 1]).
+  std::vector<int32_t> exception_offsets_;
+  std::vector<int32_t> exception_targets_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_DATA_STRUCTURES_REACHABILITY_INDEX_H_
@@ -0,0 +1,265 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/data_structures/reachability_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/work_stealing_thread_pool.h"
+#include "xls/data_structures/inline_bitmap.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::StatusIs;
+
+using Edges = std::vector<std::pair<int64_t, int64_t>>;
+
+// Returns a random DAG with `vertex_count` vertices where each vertex has up
+// to `max_fan_out` successors among the next `window` vertices of a random
+// topological order.
+Edges RandomDag(int64_t vertex_count, int64_t max_fan_out, int64_t window,
+                uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::vector<int64_t> order(vertex_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), rng);
+  Edges edges;
+  for (int64_t i = 0; i + 1 < vertex_count; ++i) {
+    int64_t fan_out = std::uniform_int_distribution<int64_t>(
+        0, max_fan_out)(rng);
+    for (int64_t j = 0; j < fan_out; ++j) {
+      int64_t target = std::uniform_int_distribution<int64_t>(
+          i + 1, std::min(i + window, vertex_count - 1))(rng);
+      edges.push_back({order[i], order[target]});
+    }
+  }
+  return edges;
+}
+
+// Materializes the reachable set of every vertex with one bitmap per vertex.
+std::vector<InlineBitmap> BitmapClosure(int64_t vertex_count,
+                                        const Edges& edges) {
+  std::vector<std::vector<int64_t>> successors(vertex_count);
+  std::vector<int64_t> in_degree(vertex_count, 0);
+  for (const auto& [from, to] : edges) {
+    successors[from].push_back(to);
+    ++in_degree[to];
+  }
+  std::vector<int64_t> topo_order;
+  for (int64_t v = 0; v < vertex_count; ++v) {
+    if (in_degree[v] == 0) {
+      topo_order.push_back(v);
+    }
+  }
+  for (int64_t i = 0; i < topo_order.size(); ++i) {
+    for (int64_t s : successors[topo_order[i]]) {
+      if (--in_degree[s] == 0) {
+        topo_order.push_back(s);
+      }
+    }
+  }
+  std::vector<InlineBitmap> closure(vertex_count, InlineBitmap(vertex_count));
+  for (auto it = topo_order.rbegin(); it != topo_order.rend(); ++it) {
+    closure[*it].Set(*it);
+    for (int64_t s : successors[*it]) {
+      closure[*it].Union(closure[s]);
+    }
+  }
+  return closure;
+}
+
+void ExpectMatchesClosure(const ReachabilityIndex& index,
+                          int64_t vertex_count, const Edges& edges) {
+  std::vector<InlineBitmap> closure = BitmapClosure(vertex_count, edges);
+  for (int64_t from = 0; from < vertex_count; ++from) {
+    EXPECT_EQ(index.GetReachable(from), closure[from]) << "from " << from;
+    for (int64_t to = 0; to < vertex_count; ++to) {
+      EXPECT_EQ(index.IsReachable(from, to), closure[from].Get(to))
+          << from << " -> " << to;
+    }
+  }
+}
+
+TEST(ReachabilityIndexTest, Diamond) {
+  Edges edges = {{0, 1}, {0, 2}, {1, 3}, {2, 3}};
+  XLS_ASSERT_OK_AND_ASSIGN(ReachabilityIndex index,
+                           ReachabilityIndex::Create(5, edges));
+  EXPECT_EQ(index.vertex_count(), 5);
+  EXPECT_TRUE(index.IsReachable(0, 3));
+  EXPECT_TRUE(index.IsReachable(2, 3));
+  EXPECT_TRUE(index.IsReachable(4, 4));
+  EXPECT_FALSE(index.IsReachable(3, 0));
+  EXPECT_FALSE(index.IsReachable(1, 2));
+  EXPECT_FALSE(index.IsReachable(0, 4));
+  ExpectMatchesClosure(index, 5, edges);
+}
+
+TEST(ReachabilityIndexTest, DuplicateEdges) {
+  Edges edges = {{0, 1}, {0, 1}, {1, 2}, {1, 2}, {0, 2}};
+  XLS_ASSERT_OK_AND_ASSIGN(ReachabilityIndex index,
+                           ReachabilityIndex::Create(3, edges));
+  ExpectMatchesClosure(index, 3, edges);
+}
+
+TEST(ReachabilityIndexTest, EmptyGraph) {
+  XLS_ASSERT_OK_AND_ASSIGN(ReachabilityIndex index,
+                           ReachabilityIndex::Create(0, {}));
+  EXPECT_EQ(index.vertex_count(), 0);
+}
+
+TEST(ReachabilityIndexTest, Cycle) {
+  EXPECT_THAT(ReachabilityIndex::Create(3, Edges{{0, 1}, {1, 2}, {2, 1}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ReachabilityIndex::Create(2, Edges{{0, 1}, {1, 0}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ReachabilityIndex::Create(1, Edges{{0, 0}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ReachabilityIndexTest, VertexOutOfRange) {
+  EXPECT_THAT(ReachabilityIndex::Create(2, Edges{{0, 2}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ReachabilityIndex::Create(2, Edges{{-1, 1}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ReachabilityIndexTest, RandomDags) {
+  for (int64_t label_count : {1, 2, 5}) {
+    for (uint64_t seed = 0; seed < 8; ++seed) {
+      Edges edges = RandomDag(/*vertex_count=*/100, /*max_fan_out=*/4,
+                              /*window=*/20, seed);
+      XLS_ASSERT_OK_AND_ASSIGN(
+          ReachabilityIndex index,
+          ReachabilityIndex::Create(
+              100, edges,
+              ReachabilityIndexOptions{.label_count = label_count}));
+      EXPECT_EQ(index.label_count(), label_count);
+      ExpectMatchesClosure(index, 100, edges);
+    }
+  }
+}
+
+TEST(ReachabilityIndexTest, ParallelConstruction) {
+  constexpr int64_t kVertexCount = 10000;
+  Edges edges = RandomDag(kVertexCount, /*max_fan_out=*/3, /*window=*/200,
+                          /*seed=*/42);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      ReachabilityIndex serial,
+      ReachabilityIndex::Create(
+          kVertexCount, edges,
+          ReachabilityIndexOptions{.label_count = 4}));
+  WorkStealingThreadPool pool(/*thread_count=*/4);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      ReachabilityIndex parallel,
+      ReachabilityIndex::Create(
+          kVertexCount, edges,
+          ReachabilityIndexOptions{.label_count = 4, .thread_pool = &pool}));
+  EXPECT_EQ(serial.MemoryUsage(), parallel.MemoryUsage());
+  std::vector<InlineBitmap> closure = BitmapClosure(kVertexCount, edges);
+  std::mt19937_64 rng(0);
+  std::uniform_int_distribution<int64_t> vertex(0, kVertexCount - 1);
+  for (int64_t i = 0; i < 20000; ++i) {
+    int64_t from = vertex(rng);
+    int64_t to = vertex(rng);
+    EXPECT_EQ(serial.IsReachable(from, to), closure[from].Get(to));
+    EXPECT_EQ(parallel.IsReachable(from, to), closure[from].Get(to));
+  }
+  for (int64_t i = 0; i < 20; ++i) {
+    int64_t from = vertex(rng);
+    EXPECT_EQ(parallel.GetReachable(from), closure[from]);
+  }
+}
+
+TEST(ReachabilityIndexTest, MemoryIsLinear) {
+  constexpr int64_t kVertexCount = 100000;
+  Edges edges;
+  // A ladder: every vertex reaches every later vertex.
+  for (int64_t v = 0; v + 1 < kVertexCount; ++v) {
+    edges.push_back({v, v + 1});
+    if (v + 2 < kVertexCount) {
+      edges.push_back({v, v + 2});
+    }
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(ReachabilityIndex index,
+                           ReachabilityIndex::Create(kVertexCount, edges));
+  EXPECT_LT(index.MemoryUsage(), kVertexCount * 64);
+  EXPECT_TRUE(index.IsReachable(0, kVertexCount - 1));
+  EXPECT_FALSE(index.IsReachable(kVertexCount - 1, 0));
+}
+
+// Compares building the index with materializing one bitmap per vertex.
+// Arguments are the vertex count and the maximum fan-out.
+void BM_ReachabilityIndexBuild(benchmark::State& state) {
+  int64_t vertex_count = state.range(0);
+  Edges edges = RandomDag(vertex_count, state.range(1), /*window=*/1000,
+                          /*seed=*/0);
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    absl::StatusOr<ReachabilityIndex> index =
+        ReachabilityIndex::Create(vertex_count, edges);
+    CHECK_OK(index);
+    bytes = index->MemoryUsage();
+    benchmark::DoNotOptimize(index);
+  }
+  state.counters["bytes"] = bytes;
+}
+
+void BM_BitmapClosureBuild(benchmark::State& state) {
+  int64_t vertex_count = state.range(0);
+  Edges edges = RandomDag(vertex_count, state.range(1), /*window=*/1000,
+                          /*seed=*/0);
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    std::vector<InlineBitmap> closure = BitmapClosure(vertex_count, edges);
+    bytes = vertex_count * ((vertex_count + 63) / 64) * sizeof(uint64_t);
+    benchmark::DoNotOptimize(closure);
+  }
+  state.counters["bytes"] = bytes;
+}
+
+void BM_ReachabilityIndexQuery(benchmark::State& state) {
+  int64_t vertex_count = state.range(0);
+  Edges edges = RandomDag(vertex_count, state.range(1), /*window=*/1000,
+                          /*seed=*/0);
+  absl::StatusOr<ReachabilityIndex> index =
+      ReachabilityIndex::Create(vertex_count, edges);
+  CHECK_OK(index);
+  std::mt19937_64 rng(0);
+  std::uniform_int_distribution<int64_t> vertex(0, vertex_count - 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(index->IsReachable(vertex(rng), vertex(rng)));
+  }
+}
+
+BENCHMARK(BM_ReachabilityIndexBuild)->RangePair(1024, 65536, 2, 4);
+BENCHMARK(BM_BitmapClosureBuild)->RangePair(1024, 65536, 2, 4);
+BENCHMARK(BM_ReachabilityIndexQuery)->RangePair(1024, 65536, 2, 4);
+
+}  // namespace
+}  // namespace xls
@@ -16,12 +16,16 @@
 #define XLS_DATA_STRUCTURES_TRANSITIVE_CLOSURE_H_
 
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/data_structures/reachability_index.h"
 
 namespace xls {
 
@@ -106,6 +110,56 @@ HashRelation<V> TransitiveClosure(const HashRelation<V>& relation) {
   return result;
 }
 
+// The transitive closure of an acyclic relation. Unlike TransitiveClosure the
+// closure is not materialized: memory is linear in the size of the relation
+// and membership is computed on demand by a ReachabilityIndex.
+template <typename V>
+class AcyclicTransitiveClosure {
+ public:
+  // Returns an error if the relation contains a cycle.
+  static absl::StatusOr<AcyclicTransitiveClosure<V>> Create(
+      const HashRelation<V>& relation,
+      const ReachabilityIndexOptions& options = ReachabilityIndexOptions()) {
+    absl::flat_hash_map<V, int64_t> indices;
+    auto index_of = [&](const V& v) {
+      return indices.insert({v, indices.size()}).first->second;
+    };
+    std::vector<std::pair<int64_t, int64_t>> edges;
+    for (const auto& [node, children] : relation) {
+      int64_t node_index = index_of(node);
+      for (const V& child : children) {
+        edges.push_back({node_index, index_of(child)});
+      }
+    }
+    XLS_ASSIGN_OR_RETURN(
+        ReachabilityIndex index,
+        ReachabilityIndex::Create(indices.size(), edges, options));
+    return AcyclicTransitiveClosure<V>(std::move(indices), std::move(index));
+  }
+
+  // Returns true if (`from`, `to`) is in the transitive closure, i.e., there
+  // is a non-empty path from `from` to `to` in the relation.
+  bool Contains(const V& from, const V& to) const {
+    if (from == to) {
+      return false;
+    }
+    auto from_it = indices_.find(from);
+    auto to_it = indices_.find(to);
+    if (from_it == indices_.end() || to_it == indices_.end()) {
+      return false;
+    }
+    return index_.IsReachable(from_it->second, to_it->second);
+  }
+
+ private:
+  AcyclicTransitiveClosure(absl::flat_hash_map<V, int64_t> indices,
+                           ReachabilityIndex index)
+      : indices_(std::move(indices)), index_(std::move(index)) {}
+
+  absl::flat_hash_map<V, int64_t> indices_;
+  ReachabilityIndex index_;
+};
+
 }  // namespace xls
 
 #endif  // XLS_DATA_STRUCTURES_TRANSITIVE_CLOSURE_H_
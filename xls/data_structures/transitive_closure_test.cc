@@ -20,6 +20,9 @@
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/status/matchers.h"
 
 namespace xls {
 namespace {
@@ -43,5 +46,32 @@ TEST(TransitiveClosureTest, Simple) {
   EXPECT_FALSE(tc.contains("qux"));
 }
 
+TEST(AcyclicTransitiveClosureTest, MatchesTransitiveClosure) {
+  HashRelation<V> rel;
+  rel["foo"].insert("bar");
+  rel["bar"].insert("baz");
+  rel["bar"].insert("qux");
+  rel["baz"].insert("qux");
+  rel["foo2"].insert("baz");
+  HashRelation<V> tc = TransitiveClosure<V>(rel);
+  XLS_ASSERT_OK_AND_ASSIGN(AcyclicTransitiveClosure<V> atc,
+                           AcyclicTransitiveClosure<V>::Create(rel));
+  for (const V& from : {"foo", "foo2", "bar", "baz", "qux", "unrelated"}) {
+    for (const V& to : {"foo", "foo2", "bar", "baz", "qux", "unrelated"}) {
+      EXPECT_EQ(atc.Contains(from, to),
+                tc.contains(from) && tc.at(from).contains(to))
+          << from << " -> " << to;
+    }
+  }
+}
+
+TEST(AcyclicTransitiveClosureTest, Cycle) {
+  HashRelation<V> rel;
+  rel["foo"].insert("bar");
+  rel["bar"].insert("foo");
+  EXPECT_THAT(AcyclicTransitiveClosure<V>::Create(rel),
+              absl_testing::StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 }  // namespace
 }  // namespace xls
@@ -57,6 +57,8 @@ To gather BDD stats of a set of benchmarks:
 ABSL_FLAG(int64_t, bdd_path_limit, 0,
           "Maximum number of paths before truncating the BDD subgraph "
           "and declaring a new variable. If zero, then no limit.");
+ABSL_FLAG(bool, bdd_dynamic_reordering, false,
+          "Whether to reorder the BDD variables by sifting as the BDD grows.");
 ABSL_FLAG(std::vector<std::string>, benchmarks, {},
           "Comma-separated list of benchmarks gather BDD stats about.");
 
@@ -119,13 +121,21 @@ absl::Status RealMain(std::string_view input_path) {
     absl::Time start = absl::Now();
     XLS_ASSIGN_OR_RETURN(
         std::unique_ptr<BddFunction> bdd_function,
-        BddFunction::Run(top.value(), absl::GetFlag(FLAGS_bdd_path_limit)));
+        BddFunction::Run(top.value(), absl::GetFlag(FLAGS_bdd_path_limit),
+                         /*node_filter=*/std::nullopt,
+                         absl::GetFlag(FLAGS_bdd_dynamic_reordering)));
     absl::Duration bdd_time = absl::Now() - start;
     total_time += bdd_time;
+    const BinaryDecisionDiagram& bdd = bdd_function->bdd();
     std::cout << "BDD construction time: " << bdd_time << "\n";
-    std::cout << "BDD node count: " << bdd_function->bdd().size() << "\n";
-    std::cout << "BDD variable count: " << bdd_function->bdd().variable_count()
+    std::cout << "BDD node count: " << bdd.size() << "\n";
+    std::cout << "BDD peak node count: " << bdd.peak_size() << "\n";
+    std::cout << "BDD peak node memory (bytes): "
+              << bdd.peak_size() * sizeof(BddNode) << "\n";
+    std::cout << "BDD variable count: " << bdd.variable_count() << "\n";
+    std::cout << "BDD garbage collections: " << bdd.garbage_collection_count()
               << "\n";
+    std::cout << "BDD variable reorderings: " << bdd.reorder_count() << "\n";
 
     int64_t number_bits = 0;
     for (Node* node : top.value()->nodes()) {
@@ -134,9 +144,14 @@ absl::Status RealMain(std::string_view input_path) {
     std::cout << "Bits in graph: " << number_bits << "\n";
 
     int64_t max_paths = 0;
-    for (int64_t i = 0; i < bdd_function->bdd().size(); ++i) {
-      max_paths =
-          std::max(max_paths, bdd_function->bdd().path_count(BddNodeIndex(i)));
+    for (Node* node : top.value()->nodes()) {
+      if (!node->GetType()->IsBits()) {
+        continue;
+      }
+      for (int64_t i = 0; i < node->BitCountOrDie(); ++i) {
+        max_paths = std::max(
+            max_paths, bdd.path_count(bdd_function->GetBddNode(node, i)));
+      }
     }
     if (max_paths == std::numeric_limits<int32_t>::max()) {
       std::cout << "Maximum paths of any expression: INT32_MAX\n";
@@ -76,6 +76,7 @@
 #include "xls/jit/jit_runtime.h"
 #include "xls/jit/orc_jit.h"
 #include "xls/jit/proc_jit.h"
+#include "xls/jit/switchable_function_jit.h"
 #include "xls/passes/bdd_function.h"
 #include "xls/passes/bdd_query_engine.h"
 #include "xls/passes/optimization_pass.h"
@@ -554,9 +555,9 @@ absl::Status RunFunctionInterpreterAndJit(Function* function,
   absl::Time start_jit_compile = absl::Now();
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<FunctionJit> jit,
                        FunctionJit::Create(function));
-  std::cout << absl::StreamFormat(
-      "JIT compile time (%s): %dms\n", description,
-      DurationToMs(absl::Now() - start_jit_compile));
+  absl::Duration jit_compile_time = absl::Now() - start_jit_compile;
+  std::cout << absl::StreamFormat("JIT compile time (%s): %dms\n",
+                                  description, DurationToMs(jit_compile_time));
 
   const int64_t kInputCount = 100;
   auto arg_set =
@@ -576,6 +577,13 @@ absl::Status RunFunctionInterpreterAndJit(Function* function,
       jit->GetReturnTypeSize(), jit->GetReturnTypeAlignment()));
   absl::Span<uint8_t> result_aligned = jit->runtime()->AsAligned(
       absl::MakeSpan(result_buffer), jit->GetReturnTypeAlignment());
+  absl::Time start_jit_first_run = absl::Now();
+  XLS_RETURN_IF_ERROR(jit->RunWithViews(jit_arg_pointers.front(),
+                                        result_aligned, &events));
+  std::cout << absl::StreamFormat(
+      "JIT latency to first result (%s): %dus\n", description,
+      absl::ToInt64Microseconds(absl::Now() - start_jit_first_run +
+                                jit_compile_time));
   XLS_ASSIGN_OR_RETURN(
       float jit_run_rate,
       CountRate(
@@ -605,6 +613,33 @@ absl::Status RunFunctionInterpreterAndJit(Function* function,
   std::cout << absl::StreamFormat(
       "Interpreter run time (%s): %d calls/s\n", description,
       static_cast<int64_t>(kInputCount * interpreter_run_rate));
+
+  // Tiered execution answers from the interpreter while the JIT tiers compile
+  // in the background.
+  absl::Time start_tiered = absl::Now();
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<SwitchableFunctionJit> tiered,
+                       SwitchableFunctionJit::CreateTiered(function));
+  XLS_RETURN_IF_ERROR(tiered->Run(arg_set.front()).status());
+  std::cout << absl::StreamFormat(
+      "Tiered latency to first result (%s): %dus\n", description,
+      absl::ToInt64Microseconds(absl::Now() - start_tiered));
+  tiered->WaitForCompilation();
+  std::cout << absl::StreamFormat("Tiered time to final tier (%s): %dms\n",
+                                  description,
+                                  DurationToMs(absl::Now() - start_tiered));
+  XLS_ASSIGN_OR_RETURN(
+      float tiered_run_rate,
+      CountRate(
+          [&]() -> absl::Status {
+            for (const std::vector<Value>& args : arg_set) {
+              CHECK_OK(tiered->Run(args).status());
+            }
+            return absl::OkStatus();
+          },
+          kRunDurationMs));
+  std::cout << absl::StreamFormat(
+      "Tiered steady-state run time (%s): %d calls/s\n", description,
+      static_cast<int64_t>(kInputCount * tiered_run_rate));
   return absl::OkStatus();
 }
 
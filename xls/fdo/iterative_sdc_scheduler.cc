@@ -17,10 +17,12 @@
 #include <algorithm>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <optional>
 #include <random>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -31,7 +33,6 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
-#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/types/span.h"
 #include "xls/common/logging/log_lines.h"
@@ -269,6 +270,7 @@ absl::Status RefineDelayEstimations(
 }
 
 absl::Status BuildError(IterativeSDCSchedulingModel &model,
+                        math_opt::IncrementalSolver &solver,
                         const math_opt::SolveResult &result,
                         SchedulingFailureBehavior failure_behavior) {
   CHECK_NE(result.termination.reason, math_opt::TerminationReason::kOptimal);
@@ -279,9 +281,8 @@ absl::Status BuildError(IterativeSDCSchedulingModel &model,
            math_opt::TerminationReason::kInfeasibleOrUnbounded)) {
     XLS_RETURN_IF_ERROR(model.AddSlackVariables(
         failure_behavior.infeasible_per_state_backedge_slack_pool));
-    XLS_ASSIGN_OR_RETURN(
-        math_opt::SolveResult result_with_slack,
-        math_opt::Solve(model.UnderlyingModel(), math_opt::SolverType::kGlop));
+    XLS_ASSIGN_OR_RETURN(math_opt::SolveResult result_with_slack,
+                         solver.Solve());
     if (result_with_slack.termination.reason ==
             math_opt::TerminationReason::kOptimal ||
         result_with_slack.termination.reason ==
@@ -303,23 +304,20 @@ absl::Status BuildError(IterativeSDCSchedulingModel &model,
 
 }  // namespace
 
-absl::Status IterativeSDCSchedulingModel::AddTimingConstraints(
+absl::Status IterativeSDCSchedulingModel::UpdateTimingConstraints(
     int64_t clock_period_ps) {
   absl::flat_hash_map<Node *, std::vector<Node *>> delay_constraints =
       delay_manager_.GetPathsOverDelayThreshold(clock_period_ps);
 
-  int64_t number_constraints = 0;
+  std::vector<std::pair<Node *, Node *>> constraints;
   for (const auto &p : delay_constraints) {
     Node *source = p.first;
     for (Node *target : p.second) {
-      number_constraints++;
-      DiffAtLeastConstraint(target, source, 1, "timing");
-      VLOG(2) << "Setting timing constraint: "
-              << absl::StrFormat("1 ≤ %s - %s", target->GetName(),
-                                 source->GetName());
+      constraints.push_back({source, target});
     }
   }
-  VLOG(2) << "Number of timing constraints added: " << number_constraints;
+  SetTimingConstraints(constraints);
+  VLOG(2) << "Number of timing constraints: " << constraints.size();
   return absl::OkStatus();
 }
 
@@ -400,37 +398,45 @@ absl::StatusOr<ScheduleCycleMap> ScheduleByIterativeSDC(
   ScheduleCycleMap cycle_map;
   absl::flat_hash_set<NodeCut> evaluated_cuts;
   std::mt19937_64 bit_gen;
-  for (int64_t i = 0; i < options.iteration_number; ++i) {
-    IterativeSDCSchedulingModel model(f, delay_manager);
+  // Only the timing constraints depend on the refined delays so the model is
+  // built once and updated in each iteration. The incremental solver then
+  // starts each solve from the previous solution.
+  IterativeSDCSchedulingModel model(f, delay_manager);
 
-    for (const SchedulingConstraint &constraint : constraints) {
-      XLS_RETURN_IF_ERROR(model.AddSchedulingConstraint(constraint));
-    }
+  for (const SchedulingConstraint &constraint : constraints) {
+    XLS_RETURN_IF_ERROR(model.AddSchedulingConstraint(constraint));
+  }
 
-    for (Node *node : f->nodes()) {
-      for (Node *user : node->users()) {
-        XLS_RETURN_IF_ERROR(model.AddDefUseConstraints(node, user));
-      }
-      if (f->IsFunction() && f->HasImplicitUse(node)) {
-        XLS_RETURN_IF_ERROR(model.AddDefUseConstraints(node, std::nullopt));
-      }
+  for (Node *node : f->nodes()) {
+    for (Node *user : node->users()) {
+      XLS_RETURN_IF_ERROR(model.AddDefUseConstraints(node, user));
+    }
+    if (f->IsFunction() && f->HasImplicitUse(node)) {
+      XLS_RETURN_IF_ERROR(model.AddDefUseConstraints(node, std::nullopt));
     }
+  }
 
-    if (f->IsProc()) {
-      Proc *proc = f->AsProcOrDie();
-      for (int64_t index = 0; index < proc->GetStateElementCount(); ++index) {
-        StateRead *const state_read = proc->GetStateRead(index);
-        Node *const next_state_element = proc->GetNextStateElement(index);
-
-        // The next-state element always has lifetime extended to the state-read
-        // node, since we can't store the new value in the state register until
-        // the old value's been used.
-        XLS_RETURN_IF_ERROR(
-            model.AddLifetimeConstraint(next_state_element, state_read));
-      }
+  if (f->IsProc()) {
+    Proc *proc = f->AsProcOrDie();
+    for (int64_t index = 0; index < proc->GetStateElementCount(); ++index) {
+      StateRead *const state_read = proc->GetStateRead(index);
+      Node *const next_state_element = proc->GetNextStateElement(index);
+
+      // The next-state element always has lifetime extended to the state-read
+      // node, since we can't store the new value in the state register until
+      // the old value's been used.
+      XLS_RETURN_IF_ERROR(
+          model.AddLifetimeConstraint(next_state_element, state_read));
     }
+  }
 
-    XLS_RETURN_IF_ERROR(model.AddTimingConstraints(clock_period_ps));
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<math_opt::IncrementalSolver> solver,
+      math_opt::NewIncrementalSolver(&model.UnderlyingModel(),
+                                     math_opt::SolverType::kGlop));
+
+  for (int64_t i = 0; i < options.iteration_number; ++i) {
+    XLS_RETURN_IF_ERROR(model.UpdateTimingConstraints(clock_period_ps));
 
     int64_t min_pipeline_length = 1;
     model.SetPipelineLength(pipeline_stages);
@@ -441,11 +447,11 @@ absl::StatusOr<ScheduleCycleMap> ScheduleByIterativeSDC(
       model.MinimizePipelineLength();
       XLS_ASSIGN_OR_RETURN(
           const math_opt::SolveResult result_with_minimized_pipeline_length,
-          math_opt::Solve(model.UnderlyingModel(),
-                          math_opt::SolverType::kGlop));
+          solver->Solve());
       if (result_with_minimized_pipeline_length.termination.reason !=
           math_opt::TerminationReason::kOptimal) {
-        return BuildError(model, result_with_minimized_pipeline_length,
+        return BuildError(model, *solver,
+                          result_with_minimized_pipeline_length,
                           failure_behavior);
       }
       XLS_ASSIGN_OR_RETURN(
@@ -457,12 +463,10 @@ absl::StatusOr<ScheduleCycleMap> ScheduleByIterativeSDC(
 
     model.SetObjective();
 
-    XLS_ASSIGN_OR_RETURN(
-        math_opt::SolveResult result,
-        math_opt::Solve(model.UnderlyingModel(), math_opt::SolverType::kGlop));
+    XLS_ASSIGN_OR_RETURN(math_opt::SolveResult result, solver->Solve());
 
     if (result.termination.reason != math_opt::TerminationReason::kOptimal) {
-      return BuildError(model, result, failure_behavior);
+      return BuildError(model, *solver, result, failure_behavior);
     }
 
     // Extract scheduling results to the cycle map.
@@ -42,8 +42,10 @@ class IterativeSDCSchedulingModel : public SDCSchedulingModel {
 
   // Overrides the original timing constraints builder. This method directly
   // call delay manager to extract the paths longer than the given clock period
-  // instead of recalculating them.
-  absl::Status AddTimingConstraints(int64_t clock_period_ps);
+  // instead of recalculating them. Constraints from a previous call which are
+  // no longer needed are removed, so the model can be re-solved incrementally
+  // after the delay manager refines its estimates.
+  absl::Status UpdateTimingConstraints(int64_t clock_period_ps);
 
  private:
   const DelayManager& delay_manager_;
@@ -0,0 +1,585 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/interpreter/bytecode_interpreter.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/common/math_util.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/data_structures/inline_bitmap.h"
+#include "xls/interpreter/ir_interpreter.h"
+#include "xls/interpreter/observer.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/dfs_visitor.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/keyword_args.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/ir/value_utils.h"
+
+namespace xls {
+
+enum class BytecodeFunction::Opcode : uint8_t {
+  kAdd,
+  kSub,
+  kUMul,
+  kSMul,
+  kUDiv,
+  kUMod,
+  kNeg,
+  kNot,
+  kIdentity,
+  kAnd,
+  kOr,
+  kXor,
+  kNand,
+  kNor,
+  kAndReduce,
+  kOrReduce,
+  kXorReduce,
+  kEq,
+  kNe,
+  kULt,
+  kULe,
+  kUGt,
+  kUGe,
+  kSLt,
+  kSLe,
+  kSGt,
+  kSGe,
+  kShll,
+  kShrl,
+  kShra,
+  kBitSlice,
+  kDynamicBitSlice,
+  kConcat,
+  kZeroExt,
+  kSignExt,
+  kSel,
+  kGate,
+  // Evaluates the node with IrInterpreter.
+  kFallback,
+};
+
+namespace {
+
+constexpr int64_t kWordBits = 64;
+
+uint64_t WordMask(int64_t bit_count) {
+  return bit_count >= kWordBits ? ~uint64_t{0}
+                                : (uint64_t{1} << bit_count) - 1;
+}
+
+// Interprets the low `bit_count` bits of `word` as a two's complement value.
+int64_t SignExtendWord(uint64_t word, int64_t bit_count) {
+  if (bit_count == 0) {
+    return 0;
+  }
+  int64_t shift = kWordBits - bit_count;
+  return static_cast<int64_t>(word << shift) >> shift;
+}
+
+uint64_t ShiftLeft(uint64_t word, uint64_t amount) {
+  return amount >= kWordBits ? 0 : word << amount;
+}
+
+uint64_t ShiftRight(uint64_t word, uint64_t amount) {
+  return amount >= kWordBits ? 0 : word >> amount;
+}
+
+// Records the order in which IrInterpreter visits the nodes of a function so
+// that side effects are evaluated in the same order.
+class VisitOrderRecorder : public DfsVisitorWithDefault {
+ public:
+  absl::Status DefaultHandler(Node* node) override {
+    order_.push_back(node);
+    return absl::OkStatus();
+  }
+
+  std::vector<Node*>& order() { return order_; }
+
+ private:
+  std::vector<Node*> order_;
+};
+
+}  // namespace
+
+/* static */ std::optional<BytecodeFunction::Opcode>
+BytecodeFunction::WordOpcode(Op op) {
+  switch (op) {
+    case Op::kAdd:
+      return Opcode::kAdd;
+    case Op::kSub:
+      return Opcode::kSub;
+    case Op::kUMul:
+      return Opcode::kUMul;
+    case Op::kSMul:
+      return Opcode::kSMul;
+    case Op::kUDiv:
+      return Opcode::kUDiv;
+    case Op::kUMod:
+      return Opcode::kUMod;
+    case Op::kNeg:
+      return Opcode::kNeg;
+    case Op::kNot:
+      return Opcode::kNot;
+    case Op::kIdentity:
+      return Opcode::kIdentity;
+    case Op::kAnd:
+      return Opcode::kAnd;
+    case Op::kOr:
+      return Opcode::kOr;
+    case Op::kXor:
+      return Opcode::kXor;
+    case Op::kNand:
+      return Opcode::kNand;
+    case Op::kNor:
+      return Opcode::kNor;
+    case Op::kAndReduce:
+      return Opcode::kAndReduce;
+    case Op::kOrReduce:
+      return Opcode::kOrReduce;
+    case Op::kXorReduce:
+      return Opcode::kXorReduce;
+    case Op::kEq:
+      return Opcode::kEq;
+    case Op::kNe:
+      return Opcode::kNe;
+    case Op::kULt:
+      return Opcode::kULt;
+    case Op::kULe:
+      return Opcode::kULe;
+    case Op::kUGt:
+      return Opcode::kUGt;
+    case Op::kUGe:
+      return Opcode::kUGe;
+    case Op::kSLt:
+      return Opcode::kSLt;
+    case Op::kSLe:
+      return Opcode::kSLe;
+    case Op::kSGt:
+      return Opcode::kSGt;
+    case Op::kSGe:
+      return Opcode::kSGe;
+    case Op::kShll:
+      return Opcode::kShll;
+    case Op::kShrl:
+      return Opcode::kShrl;
+    case Op::kShra:
+      return Opcode::kShra;
+    case Op::kBitSlice:
+      return Opcode::kBitSlice;
+    case Op::kDynamicBitSlice:
+      return Opcode::kDynamicBitSlice;
+    case Op::kConcat:
+      return Opcode::kConcat;
+    case Op::kZeroExt:
+      return Opcode::kZeroExt;
+    case Op::kSignExt:
+      return Opcode::kSignExt;
+    case Op::kSel:
+      return Opcode::kSel;
+    case Op::kGate:
+      return Opcode::kGate;
+    default:
+      return std::nullopt;
+  }
+}
+
+/* static */ Value BytecodeFunction::ReadSlot(const Slot& slot,
+                                              absl::Span<const uint64_t> words,
+                                              absl::Span<const Value> values) {
+  switch (slot.kind) {
+    case Slot::Kind::kWord:
+      return Value(UBits(words[slot.index], slot.bit_count));
+    case Slot::Kind::kWideBits: {
+      InlineBitmap bitmap(slot.bit_count);
+      for (int64_t i = 0; i < bitmap.word_count(); ++i) {
+        bitmap.SetWord(i, words[slot.index + i]);
+      }
+      return Value(Bits::FromBitmap(std::move(bitmap)));
+    }
+    case Slot::Kind::kValue:
+      return values[slot.index];
+  }
+  LOG(FATAL) << "Invalid slot kind";
+}
+
+/* static */ void BytecodeFunction::WriteSlot(const Slot& slot,
+                                              const Value& value,
+                                              absl::Span<uint64_t> words,
+                                              absl::Span<Value> values) {
+  switch (slot.kind) {
+    case Slot::Kind::kWord:
+      words[slot.index] = value.bits().bitmap().GetWord(0);
+      return;
+    case Slot::Kind::kWideBits: {
+      const InlineBitmap& bitmap = value.bits().bitmap();
+      for (int64_t i = 0; i < bitmap.word_count(); ++i) {
+        words[slot.index + i] = bitmap.GetWord(i);
+      }
+      return;
+    }
+    case Slot::Kind::kValue:
+      values[slot.index] = value;
+      return;
+  }
+  LOG(FATAL) << "Invalid slot kind";
+}
+
+BytecodeFunction::Slot BytecodeFunction::AllocateSlot(Node* node) {
+  Slot slot;
+  if (node->GetType()->IsBits()) {
+    int64_t bit_count = node->BitCountOrDie();
+    slot = Slot{.kind = bit_count <= kWordBits ? Slot::Kind::kWord
+                                               : Slot::Kind::kWideBits,
+                .index = word_count_,
+                .bit_count = bit_count};
+    word_count_ += std::max(CeilOfRatio(bit_count, kWordBits), int64_t{1});
+    initial_words_.resize(word_count_, 0);
+  } else {
+    slot = Slot{
+        .kind = Slot::Kind::kValue, .index = value_count_, .bit_count = 0};
+    ++value_count_;
+    initial_values_.emplace_back();
+  }
+  slots_[node] = slot;
+  return slot;
+}
+
+void BytecodeFunction::AddInstruction(Node* node, const Slot& result) {
+  std::optional<Opcode> opcode;
+  if (result.kind == Slot::Kind::kWord) {
+    opcode = WordOpcode(node->op());
+  }
+  Instruction instruction{.opcode = Opcode::kFallback,
+                          .result = result,
+                          .mask = WordMask(result.bit_count),
+                          .operand_start = static_cast<int64_t>(
+                              operands_.size()),
+                          .operand_count = node->operand_count(),
+                          .immediate = 0,
+                          .node = node};
+  for (Node* operand : node->operands()) {
+    const Slot& operand_slot = slots_.at(operand);
+    if (operand_slot.kind != Slot::Kind::kWord) {
+      opcode = std::nullopt;
+    }
+    operands_.push_back(operand_slot);
+  }
+  if (opcode.has_value()) {
+    instruction.opcode = *opcode;
+    if (node->Is<BitSlice>()) {
+      instruction.immediate = node->As<BitSlice>()->start();
+    } else if (node->Is<Select>()) {
+      instruction.immediate = node->As<Select>()->cases().size();
+    }
+  }
+  instructions_.push_back(instruction);
+}
+
+/* static */ absl::StatusOr<std::unique_ptr<BytecodeFunction>>
+BytecodeFunction::Compile(Function* function) {
+  auto bytecode = absl::WrapUnique(new BytecodeFunction(function));
+  // Evaluate nodes in the order IrInterpreter would so that side effects such
+  // as traces are recorded in the same order.
+  VisitOrderRecorder recorder;
+  XLS_RETURN_IF_ERROR(function->Accept(&recorder));
+  for (Node* node : recorder.order()) {
+    Slot slot = bytecode->AllocateSlot(node);
+    if (node->Is<Param>()) {
+      continue;
+    }
+    if (node->Is<Literal>()) {
+      WriteSlot(slot, node->As<Literal>()->value(),
+                absl::MakeSpan(bytecode->initial_words_),
+                absl::MakeSpan(bytecode->initial_values_));
+      bytecode->literals_.push_back(node);
+      continue;
+    }
+    bytecode->AddInstruction(node, slot);
+  }
+  for (Param* param : function->params()) {
+    bytecode->param_slots_.push_back(bytecode->slots_.at(param));
+  }
+  bytecode->return_slot_ = bytecode->slots_.at(function->return_value());
+  VLOG(3) << absl::StreamFormat(
+      "Compiled function %s into %d instructions, %d words and %d values",
+      function->name(), bytecode->instructions_.size(), bytecode->word_count_,
+      bytecode->value_count_);
+  return bytecode;
+}
+
+BytecodeFunction::~BytecodeFunction() = default;
+
+std::unique_ptr<BytecodeFunction::State> BytecodeFunction::CreateState()
+    const {
+  return absl::WrapUnique(new State(*this));
+}
+
+absl::Status BytecodeFunction::RunFallback(
+    const Instruction& instruction, State& state,
+    std::optional<EvaluationObserver*> observer) const {
+  Node* node = instruction.node;
+  state.fallback_values_.clear();
+  for (int64_t i = 0; i < instruction.operand_count; ++i) {
+    state.fallback_values_.insert_or_assign(
+        node->operand(i), ReadSlot(operands_[instruction.operand_start + i],
+                                   state.words_, state.values_));
+  }
+  IrInterpreter interpreter(&state.fallback_values_, &state.events_, observer);
+  XLS_RETURN_IF_ERROR(node->VisitSingleNode(&interpreter));
+  WriteSlot(instruction.result, interpreter.ResolveAsValue(node),
+            absl::MakeSpan(state.words_), absl::MakeSpan(state.values_));
+  return absl::OkStatus();
+}
+
+absl::StatusOr<InterpreterResult<Value>> BytecodeFunction::Run(
+    absl::Span<const Value> args, State& state,
+    std::optional<EvaluationObserver*> observer) const {
+  XLS_RET_CHECK_EQ(state.function_, this);
+  // A previous run which failed may have left events behind.
+  state.events_ = InterpreterEvents();
+  if (args.size() != param_slots_.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Function `%s` (type: `%s`) wants %d arguments, got %d.",
+        function_->name(), function_->GetType()->ToString(),
+        param_slots_.size(), args.size()));
+  }
+  for (int64_t argno = 0; argno < args.size(); ++argno) {
+    Param* param = function_->param(argno);
+    if (!ValueConformsToType(args[argno], param->GetType())) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Got argument %s for parameter %d which is not of type %s",
+          args[argno].ToString(), argno, param->GetType()->ToString()));
+    }
+    WriteSlot(param_slots_[argno], args[argno], absl::MakeSpan(state.words_),
+              absl::MakeSpan(state.values_));
+  }
+  if (observer.has_value()) {
+    for (int64_t argno = 0; argno < args.size(); ++argno) {
+      (*observer)->NodeEvaluated(function_->param(argno), args[argno]);
+    }
+    for (Node* literal : literals_) {
+      (*observer)->NodeEvaluated(literal, literal->As<Literal>()->value());
+    }
+  }
+
+  uint64_t* words = state.words_.data();
+  for (const Instruction& instruction : instructions_) {
+    const Slot* operands = operands_.data() + instruction.operand_start;
+    auto operand = [&](int64_t i) { return words[operands[i].index]; };
+    auto signed_operand = [&](int64_t i) {
+      return SignExtendWord(words[operands[i].index], operands[i].bit_count);
+    };
+    uint64_t result;
+    switch (instruction.opcode) {
+      case Opcode::kAdd:
+        result = operand(0) + operand(1);
+        break;
+      case Opcode::kSub:
+        result = operand(0) - operand(1);
+        break;
+      case Opcode::kUMul:
+        result = operand(0) * operand(1);
+        break;
+      case Opcode::kSMul:
+        result = static_cast<uint64_t>(signed_operand(0)) *
+                 static_cast<uint64_t>(signed_operand(1));
+        break;
+      case Opcode::kUDiv:
+        result = operand(1) == 0 ? ~uint64_t{0} : operand(0) / operand(1);
+        break;
+      case Opcode::kUMod:
+        result = operand(1) == 0 ? 0 : operand(0) % operand(1);
+        break;
+      case Opcode::kNeg:
+        result = uint64_t{0} - operand(0);
+        break;
+      case Opcode::kNot:
+        result = ~operand(0);
+        break;
+      case Opcode::kIdentity:
+      case Opcode::kZeroExt:
+        result = operand(0);
+        break;
+      case Opcode::kAnd:
+      case Opcode::kNand:
+        result = operand(0);
+        for (int64_t i = 1; i < instruction.operand_count; ++i) {
+          result &= operand(i);
+        }
+        if (instruction.opcode == Opcode::kNand) {
+          result = ~result;
+        }
+        break;
+      case Opcode::kOr:
+      case Opcode::kNor:
+        result = operand(0);
+        for (int64_t i = 1; i < instruction.operand_count; ++i) {
+          result |= operand(i);
+        }
+        if (instruction.opcode == Opcode::kNor) {
+          result = ~result;
+        }
+        break;
+      case Opcode::kXor:
+        result = operand(0);
+        for (int64_t i = 1; i < instruction.operand_count; ++i) {
+          result ^= operand(i);
+        }
+        break;
+      case Opcode::kAndReduce:
+        result = operand(0) == WordMask(operands[0].bit_count) ? 1 : 0;
+        break;
+      case Opcode::kOrReduce:
+        result = operand(0) != 0 ? 1 : 0;
+        break;
+      case Opcode::kXorReduce:
+        result = std::popcount(operand(0)) & 1;
+        break;
+      case Opcode::kEq:
+        result = operand(0) == operand(1) ? 1 : 0;
+        break;
+      case Opcode::kNe:
+        result = operand(0) != operand(1) ? 1 : 0;
+        break;
+      case Opcode::kULt:
+        result = operand(0) < operand(1) ? 1 : 0;
+        break;
+      case Opcode::kULe:
+        result = operand(0) <= operand(1) ? 1 : 0;
+        break;
+      case Opcode::kUGt:
+        result = operand(0) > operand(1) ? 1 : 0;
+        break;
+      case Opcode::kUGe:
+        result = operand(0) >= operand(1) ? 1 : 0;
+        break;
+      case Opcode::kSLt:
+        result = signed_operand(0) < signed_operand(1) ? 1 : 0;
+        break;
+      case Opcode::kSLe:
+        result = signed_operand(0) <= signed_operand(1) ? 1 : 0;
+        break;
+      case Opcode::kSGt:
+        result = signed_operand(0) > signed_operand(1) ? 1 : 0;
+        break;
+      case Opcode::kSGe:
+        result = signed_operand(0) >= signed_operand(1) ? 1 : 0;
+        break;
+      case Opcode::kShll:
+        result = ShiftLeft(operand(0), operand(1));
+        break;
+      case Opcode::kShrl:
+        result = ShiftRight(operand(0), operand(1));
+        break;
+      case Opcode::kShra: {
+        int64_t value = signed_operand(0);
+        result = operand(1) >= kWordBits
+                     ? (value < 0 ? ~uint64_t{0} : 0)
+                     : static_cast<uint64_t>(value >> operand(1));
+        break;
+      }
+      case Opcode::kBitSlice:
+        result = ShiftRight(operand(0), instruction.immediate);
+        break;
+      case Opcode::kDynamicBitSlice:
+        result = operand(1) >= operands[0].bit_count
+                     ? 0
+                     : ShiftRight(operand(0), operand(1));
+        break;
+      case Opcode::kConcat:
+        result = 0;
+        for (int64_t i = 0; i < instruction.operand_count; ++i) {
+          result = ShiftLeft(result, operands[i].bit_count) | operand(i);
+        }
+        break;
+      case Opcode::kSignExt:
+        result = static_cast<uint64_t>(signed_operand(0));
+        break;
+      case Opcode::kSel: {
+        uint64_t selector = operand(0);
+        result = selector < instruction.immediate
+                     ? operand(1 + selector)
+                     : operand(instruction.operand_count - 1);
+        break;
+      }
+      case Opcode::kGate:
+        result = operand(0) != 0 ? operand(1) : 0;
+        break;
+      case Opcode::kFallback:
+        XLS_RETURN_IF_ERROR(RunFallback(instruction, state, observer));
+        continue;
+    }
+    words[instruction.result.index] = result & instruction.mask;
+    if (observer.has_value()) {
+      (*observer)->NodeEvaluated(
+          instruction.node,
+          Value(UBits(words[instruction.result.index],
+                      instruction.result.bit_count)));
+    }
+  }
+
+  Value result = ReadSlot(return_slot_, state.words_, state.values_);
+  InterpreterEvents events = std::move(state.events_);
+  state.events_ = InterpreterEvents();
+  return InterpreterResult<Value>{std::move(result), std::move(events)};
+}
+
+absl::StatusOr<InterpreterResult<Value>> BytecodeFunction::Run(
+    absl::Span<const Value> args,
+    std::optional<EvaluationObserver*> observer) const {
+  std::unique_ptr<State> state = CreateState();
+  return Run(args, *state, observer);
+}
+
+absl::StatusOr<InterpreterResult<Value>> InterpretFunctionBytecode(
+    Function* function, absl::Span<const Value> args,
+    std::optional<EvaluationObserver*> observer) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BytecodeFunction> bytecode,
+                       BytecodeFunction::Compile(function));
+  return bytecode->Run(args, observer);
+}
+
+absl::StatusOr<InterpreterResult<Value>> InterpretFunctionBytecodeKwargs(
+    Function* function, const absl::flat_hash_map<std::string, Value>& args,
+    std::optional<EvaluationObserver*> observer) {
+  XLS_ASSIGN_OR_RETURN(std::vector<Value> positional_args,
+                       KeywordArgsToPositional(*function, args));
+  return InterpretFunctionBytecode(function, positional_args, observer);
+}
+
+}  // namespace xls
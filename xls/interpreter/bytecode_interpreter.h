@@ -0,0 +1,178 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_INTERPRETER_BYTECODE_INTERPRETER_H_
+#define XLS_INTERPRETER_BYTECODE_INTERPRETER_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/interpreter/observer.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/node.h"
+#include "xls/ir/op.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+// A Function lowered once into a flat array of instructions which is evaluated
+// in a single dispatch loop. This is an alternative to IrInterpreter, which
+// visits the node graph through virtual dispatch and stores every result as a
+// Value in a hash map, for uses where the JIT is unavailable or too slow to
+// start.
+//
+// Every node is assigned a slot at compile time. Bits-typed nodes live in a
+// contiguous register file of uint64_t words (one word for values of up to 64
+// bits, consecutive words for wider values) and all other nodes live in an
+// array of Values. Operations on bits values of at most 64 bits are executed
+// directly on the words without allocation. Remaining operations (wide
+// arithmetic, aggregates, invokes, loops, traces, ...) are evaluated by
+// IrInterpreter one node at a time.
+class BytecodeFunction {
+ public:
+  // Mutable state used to run a BytecodeFunction. Reusing a state across runs
+  // avoids allocating the register file for each run.
+  class State {
+   public:
+    State(const State&) = delete;
+    State& operator=(const State&) = delete;
+
+   private:
+    friend class BytecodeFunction;
+
+    explicit State(const BytecodeFunction& function)
+        : function_(&function),
+          words_(function.initial_words_),
+          values_(function.initial_values_) {}
+
+    const BytecodeFunction* function_;
+    std::vector<uint64_t> words_;
+    std::vector<Value> values_;
+    InterpreterEvents events_;
+    // Operand values of the node being evaluated by IrInterpreter.
+    absl::flat_hash_map<Node*, Value> fallback_values_;
+  };
+
+  static absl::StatusOr<std::unique_ptr<BytecodeFunction>> Compile(
+      Function* function);
+
+  ~BytecodeFunction();
+
+  Function* function() const { return function_; }
+
+  // Returns a new state for running this function.
+  std::unique_ptr<State> CreateState() const;
+
+  // Runs the function on the given arguments using the given state, which
+  // must have been created by this object.
+  absl::StatusOr<InterpreterResult<Value>> Run(
+      absl::Span<const Value> args, State& state,
+      std::optional<EvaluationObserver*> observer = std::nullopt) const;
+
+  // Runs the function on the given arguments using a fresh state.
+  absl::StatusOr<InterpreterResult<Value>> Run(
+      absl::Span<const Value> args,
+      std::optional<EvaluationObserver*> observer = std::nullopt) const;
+
+ private:
+  // Where the value of a node is stored.
+  struct Slot {
+    enum class Kind : uint8_t {
+      // A bits value of at most 64 bits held in the word `index`.
+      kWord,
+      // A bits value of more than 64 bits held in the words starting at
+      // `index`.
+      kWideBits,
+      // Any other value held in the Value at `index`.
+      kValue,
+    };
+    Kind kind;
+    int64_t index;
+    int64_t bit_count;
+  };
+
+  enum class Opcode : uint8_t;
+
+  struct Instruction {
+    Opcode opcode;
+    Slot result;
+    // Mask of the bits of the result for word results.
+    uint64_t mask;
+    // The operands are the `operand_count` slots in `operands_` starting at
+    // `operand_start`.
+    int64_t operand_start;
+    int64_t operand_count;
+    // Opcode-specific immediate.
+    int64_t immediate;
+    Node* node;
+  };
+
+  explicit BytecodeFunction(Function* function) : function_(function) {}
+
+  // Returns the opcode which evaluates `op` on words, or std::nullopt if the
+  // op has no word-level implementation.
+  static std::optional<Opcode> WordOpcode(Op op);
+
+  static Value ReadSlot(const Slot& slot, absl::Span<const uint64_t> words,
+                        absl::Span<const Value> values);
+  static void WriteSlot(const Slot& slot, const Value& value,
+                        absl::Span<uint64_t> words, absl::Span<Value> values);
+
+  Slot AllocateSlot(Node* node);
+  void AddInstruction(Node* node, const Slot& result);
+
+  // Evaluates the node of `instruction` with IrInterpreter.
+  absl::Status RunFallback(const Instruction& instruction, State& state,
+                           std::optional<EvaluationObserver*> observer) const;
+
+  Function* function_;
+  std::vector<Instruction> instructions_;
+  std::vector<Slot> operands_;
+  absl::flat_hash_map<Node*, Slot> slots_;
+  std::vector<Slot> param_slots_;
+  Slot return_slot_;
+
+  // Register file contents shared by all runs. Literal slots are only ever
+  // written here.
+  int64_t word_count_ = 0;
+  int64_t value_count_ = 0;
+  std::vector<uint64_t> initial_words_;
+  std::vector<Value> initial_values_;
+  // Literals in evaluation order, for reporting to observers.
+  std::vector<Node*> literals_;
+};
+
+// Runs the given function with the bytecode interpreter. Compiles the function
+// on each call; use BytecodeFunction directly to amortize compilation.
+absl::StatusOr<InterpreterResult<Value>> InterpretFunctionBytecode(
+    Function* function, absl::Span<const Value> args,
+    std::optional<EvaluationObserver*> observer = std::nullopt);
+
+// As above with the arguments given by name.
+absl::StatusOr<InterpreterResult<Value>> InterpretFunctionBytecodeKwargs(
+    Function* function, const absl::flat_hash_map<std::string, Value>& args,
+    std::optional<EvaluationObserver*> observer = std::nullopt);
+
+}  // namespace xls
+
+#endif  // XLS_INTERPRETER_BYTECODE_INTERPRETER_H_
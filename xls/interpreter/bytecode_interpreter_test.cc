@@ -0,0 +1,149 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/interpreter/bytecode_interpreter.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "xls/common/status/matchers.h"
+#include "xls/interpreter/ir_evaluator_test_base.h"
+#include "xls/interpreter/observer.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+
+INSTANTIATE_TEST_SUITE_P(
+    BytecodeInterpreterTest, IrEvaluatorTestBase,
+    testing::Values(IrEvaluatorTestParam(
+        [](Function* function, absl::Span<const Value> args,
+           std::optional<EvaluationObserver*> obs) {
+          return InterpretFunctionBytecode(function, args, obs);
+        },
+        [](Function* function,
+           const absl::flat_hash_map<std::string, Value>& kwargs,
+           std::optional<EvaluationObserver*> obs) {
+          return InterpretFunctionBytecodeKwargs(function, kwargs, obs);
+        },
+        true)));
+
+class BytecodeInterpreterOnlyTest : public IrTestBase {};
+
+TEST_F(BytecodeInterpreterOnlyTest, StateIsReusedAcrossRuns) {
+  Package package("my_package");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function, Parser::ParseFunction(R"(
+    fn f(x: bits[8], y: bits[8]) -> bits[8] {
+      literal.1: bits[8] = literal(value=3)
+      umul.2: bits[8] = umul(x, literal.1)
+      ult.3: bits[1] = ult(x, y)
+      ret sel.4: bits[8] = sel(ult.3, cases=[umul.2, y])
+    }
+    )",
+                                                                     &package));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BytecodeFunction> bytecode,
+                           BytecodeFunction::Compile(function));
+  std::unique_ptr<BytecodeFunction::State> state = bytecode->CreateState();
+  for (int64_t x = 0; x < 256; x += 17) {
+    for (int64_t y = 0; y < 256; y += 13) {
+      XLS_ASSERT_OK_AND_ASSIGN(
+          InterpreterResult<Value> result,
+          bytecode->Run({Value(UBits(x, 8)), Value(UBits(y, 8))}, *state));
+      EXPECT_EQ(result.value, Value(UBits(x < y ? y : (x * 3) & 0xff, 8)));
+    }
+  }
+}
+
+TEST_F(BytecodeInterpreterOnlyTest, MixesWordAndFallbackNodes) {
+  Package package("my_package");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function, Parser::ParseFunction(R"(
+    fn f(x: bits[100], y: bits[32]) -> (bits[100], bits[32]) {
+      zero_ext.1: bits[100] = zero_ext(y, new_bit_count=100)
+      add.2: bits[100] = add(x, zero_ext.1)
+      bit_slice.3: bits[32] = bit_slice(add.2, start=64, width=32)
+      xor.4: bits[32] = xor(bit_slice.3, y)
+      ret tuple.5: (bits[100], bits[32]) = tuple(add.2, xor.4)
+    }
+    )",
+                                                                     &package));
+  Bits x = bits_ops::Concat({UBits(1, 36), Bits::AllOnes(64)});
+  XLS_ASSERT_OK_AND_ASSIGN(
+      InterpreterResult<Value> result,
+      InterpretFunctionBytecode(function, {Value(x), Value(UBits(1, 32))}));
+  Bits sum = bits_ops::Concat({UBits(2, 36), UBits(0, 64)});
+  EXPECT_EQ(result.value,
+            Value::Tuple({Value(sum), Value(UBits(3, 32))}));
+}
+
+TEST_F(BytecodeInterpreterOnlyTest, TracesAreRecordedPerRun) {
+  Package package("my_package");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function, Parser::ParseFunction(R"(
+    fn f(tkn: token, x: bits[8]) -> bits[8] {
+      literal.1: bits[1] = literal(value=1)
+      trace.2: token = trace(tkn, literal.1, format="x is {}", data_operands=[x])
+      ret neg.3: bits[8] = neg(x)
+    }
+    )",
+                                                                     &package));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BytecodeFunction> bytecode,
+                           BytecodeFunction::Compile(function));
+  std::unique_ptr<BytecodeFunction::State> state = bytecode->CreateState();
+  for (int64_t x : {1, 2}) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        InterpreterResult<Value> result,
+        bytecode->Run({Value::Token(), Value(UBits(x, 8))}, *state));
+    EXPECT_EQ(result.value, Value(UBits(256 - x, 8)));
+    ASSERT_EQ(result.events.trace_msgs.size(), 1);
+    EXPECT_EQ(result.events.trace_msgs[0].message, absl::StrCat("x is ", x));
+  }
+}
+
+TEST_F(BytecodeInterpreterOnlyTest, RejectsMistypedArguments) {
+  Package package("my_package");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function, Parser::ParseFunction(R"(
+    fn f(x: bits[8]) -> bits[8] {
+      ret identity.1: bits[8] = identity(x)
+    }
+    )",
+                                                                     &package));
+  EXPECT_THAT(InterpretFunctionBytecode(function, {Value(UBits(1, 4))}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("not of type bits[8]")));
+  EXPECT_THAT(InterpretFunctionBytecode(function, {}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("wants 1 arguments, got 0")));
+}
+
+}  // namespace
+}  // namespace xls
@@ -95,9 +95,9 @@ class ChannelQueue {
   // is called when a value is needed for reading. If a generator is attached
   // then calling `Write` returns an error.
   using GeneratorFn = std::function<std::optional<Value>()>;
-  absl::Status AttachGenerator(GeneratorFn generator);
+  virtual absl::Status AttachGenerator(GeneratorFn generator);
 
-  void AddCallback(std::unique_ptr<ChannelQueueCallback> callback) {
+  virtual void AddCallback(std::unique_ptr<ChannelQueueCallback> callback) {
     callbacks_.push_back(std::move(callback));
   }
 
@@ -0,0 +1,169 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/parallel_proc_runtime.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/evaluator_options.h"
+#include "xls/interpreter/proc_evaluator.h"
+#include "xls/ir/events.h"
+#include "xls/ir/package.h"
+#include "xls/ir/proc_elaboration.h"
+
+namespace xls {
+
+/* static */ absl::StatusOr<std::unique_ptr<ParallelProcRuntime>>
+ParallelProcRuntime::Create(
+    std::vector<std::unique_ptr<ProcEvaluator>>&& evaluators,
+    std::unique_ptr<ChannelQueueManager>&& queue_manager,
+    const EvaluatorOptions& options, std::optional<int64_t> thread_count) {
+  // Verify there exists exactly one evaluator per proc in the package.
+  absl::flat_hash_map<Proc*, std::unique_ptr<ProcEvaluator>> evaluator_map;
+  for (std::unique_ptr<ProcEvaluator>& evaluator : evaluators) {
+    Proc* proc = evaluator->proc();
+    auto [it, inserted] = evaluator_map.insert({proc, std::move(evaluator)});
+    XLS_RET_CHECK(inserted) << absl::StreamFormat(
+        "More than one evaluator given for proc `%s`", proc->name());
+  }
+  for (Proc* proc : queue_manager->elaboration().procs()) {
+    XLS_RET_CHECK(evaluator_map.contains(proc))
+        << absl::StreamFormat("No evaluator given for proc `%s`", proc->name());
+  }
+  XLS_RET_CHECK_EQ(evaluator_map.size(),
+                   queue_manager->elaboration().procs().size())
+      << "More evaluators than procs given.";
+  XLS_RET_CHECK(!thread_count.has_value() || *thread_count > 0)
+      << "Thread count must be positive.";
+  return absl::WrapUnique(
+      new ParallelProcRuntime(std::move(evaluator_map),
+                              std::move(queue_manager), options, thread_count));
+}
+
+void ParallelProcRuntime::ScheduleInstance(ProcInstance* instance) {
+  thread_pool_.Schedule([this, instance]() { RunInstance(instance); });
+}
+
+void ParallelProcRuntime::RunInstance(ProcInstance* instance) {
+  ProcEvaluator* evaluator = evaluators_.at(instance->proc()).get();
+  ProcContinuation* continuation = continuations_.at(instance).get();
+  while (true) {
+    {
+      absl::MutexLock lock(&mutex_);
+      if (!status_.ok()) {
+        return;
+      }
+    }
+    VLOG(3) << absl::StreamFormat("Ticking proc instance `%s`",
+                                  instance->GetName());
+    absl::StatusOr<TickResult> tick_result = evaluator->Tick(*continuation);
+    absl::Status status = tick_result.status();
+    if (status.ok()) {
+      status = InterpreterEventsToStatus(GetInterpreterEvents(instance));
+    }
+    absl::MutexLock lock(&mutex_);
+    if (!status.ok()) {
+      if (status_.ok()) {
+        status_ = std::move(status);
+      }
+      return;
+    }
+    VLOG(3) << "Tick result: " << *tick_result;
+
+    progress_made_ |= tick_result->progress_made;
+    progress_made_on_io_procs_ |=
+        (tick_result->progress_made && evaluator->ProcHasIoOperations());
+    switch (tick_result->execution_state) {
+      case TickExecutionState::kCompleted:
+        return;
+      case TickExecutionState::kSentOnChannel: {
+        ChannelInstance* channel_instance =
+            tick_result->channel_instance.value();
+        auto it = blocked_instances_.find(channel_instance);
+        if (it != blocked_instances_.end()) {
+          VLOG(3) << absl::StreamFormat(
+              "Unblocking proc instance `%s` and scheduling it",
+              it->second->GetName());
+          ScheduleInstance(it->second);
+          blocked_instances_.erase(it);
+        }
+        // This proc instance is not blocked and continues running on this
+        // thread.
+        break;
+      }
+      case TickExecutionState::kBlockedOnReceive: {
+        ChannelInstance* channel_instance =
+            tick_result->channel_instance.value();
+        // Data may have been sent on the channel after the receive executed
+        // but before this thread acquired the lock. In this case the sender
+        // did not see this instance as blocked so retry the receive.
+        if (!queue_manager_->GetQueue(channel_instance).IsEmpty()) {
+          break;
+        }
+        VLOG(3) << absl::StreamFormat(
+            "Proc instance `%s` is now blocked on channel instance `%s`",
+            instance->GetName(), channel_instance->ToString());
+        blocked_instances_[channel_instance] = instance;
+        return;
+      }
+    }
+  }
+}
+
+absl::StatusOr<ParallelProcRuntime::NetworkTickResult>
+ParallelProcRuntime::TickInternal() {
+  VLOG(3) << absl::StreamFormat("TickInternal on package %s",
+                                package()->name());
+  {
+    absl::MutexLock lock(&mutex_);
+    blocked_instances_.clear();
+    progress_made_ = false;
+    progress_made_on_io_procs_ = false;
+    status_ = absl::OkStatus();
+  }
+  for (ProcInstance* instance : elaboration().proc_instances()) {
+    ScheduleInstance(instance);
+  }
+  thread_pool_.WaitUntilIdle();
+
+  absl::MutexLock lock(&mutex_);
+  XLS_RETURN_IF_ERROR(status_);
+  std::vector<ChannelInstance*> blocked_channel_instances;
+  for (ChannelInstance* instance : elaboration().channel_instances()) {
+    if (blocked_instances_.contains(instance)) {
+      blocked_channel_instances.push_back(instance);
+    }
+  }
+  return NetworkTickResult{
+      .progress_made = progress_made_,
+      .progress_made_on_io_procs = progress_made_on_io_procs_,
+      .blocked_channel_instances = std::move(blocked_channel_instances),
+  };
+}
+
+}  // namespace xls
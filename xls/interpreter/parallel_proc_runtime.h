@@ -0,0 +1,96 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_INTERPRETER_PARALLEL_PROC_RUNTIME_H_
+#define XLS_INTERPRETER_PARALLEL_PROC_RUNTIME_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/work_stealing_thread_pool.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/evaluator_options.h"
+#include "xls/interpreter/proc_evaluator.h"
+#include "xls/interpreter/proc_runtime.h"
+#include "xls/ir/package.h"
+#include "xls/ir/proc_elaboration.h"
+
+namespace xls {
+
+// Class for interpreting a network of procs using multiple threads. Each tick
+// of the network schedules every proc instance on a work-stealing thread pool.
+// A proc instance runs until it completes its iteration or blocks on a
+// receive. A blocked proc instance is rescheduled when data is sent on the
+// channel it is waiting on. The evaluators must support concurrently ticking
+// distinct continuations, which ProcJit and ProcInterpreter do.
+//
+// For networks whose procs communicate only through blocking receives the
+// results are identical to SerialProcRuntime. Values observed by non-blocking
+// receives depend on thread scheduling.
+//
+// ParallelProcRuntimes are thread-compatible, but not thread-safe.
+class ParallelProcRuntime : public ProcRuntime {
+ public:
+  // Creates and returns a proc network runtime for the given evaluators.
+  // `thread_count` is the number of worker threads. If std::nullopt then the
+  // number of available CPUs is used.
+  static absl::StatusOr<std::unique_ptr<ParallelProcRuntime>> Create(
+      std::vector<std::unique_ptr<ProcEvaluator>>&& evaluators,
+      std::unique_ptr<ChannelQueueManager>&& queue_manager,
+      const EvaluatorOptions& options = EvaluatorOptions(),
+      std::optional<int64_t> thread_count = std::nullopt);
+
+ private:
+  ParallelProcRuntime(
+      absl::flat_hash_map<Proc*, std::unique_ptr<ProcEvaluator>>&& evaluators,
+      std::unique_ptr<ChannelQueueManager>&& queue_manager,
+      const EvaluatorOptions& options, std::optional<int64_t> thread_count)
+      : ProcRuntime(std::move(evaluators), std::move(queue_manager), options),
+        thread_pool_(thread_count) {}
+
+  absl::StatusOr<NetworkTickResult> TickInternal() override;
+
+  // Ticks the given proc instance until it completes its iteration, blocks on
+  // a receive, or an error occurs. Runs on a worker thread.
+  void RunInstance(ProcInstance* instance);
+
+  // Schedules the given proc instance to run on the thread pool.
+  void ScheduleInstance(ProcInstance* instance);
+
+  WorkStealingThreadPool thread_pool_;
+
+  // State of the network tick in progress.
+  absl::Mutex mutex_;
+  // Proc instances blocked on a receive indexed by the channel instance they
+  // are blocked on.
+  absl::flat_hash_map<ChannelInstance*, ProcInstance*> blocked_instances_
+      ABSL_GUARDED_BY(mutex_);
+  bool progress_made_ ABSL_GUARDED_BY(mutex_) = false;
+  bool progress_made_on_io_procs_ ABSL_GUARDED_BY(mutex_) = false;
+  // The first error encountered during the tick. Once set no further proc
+  // instances are ticked.
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xls
+
+#endif  // XLS_INTERPRETER_PARALLEL_PROC_RUNTIME_H_
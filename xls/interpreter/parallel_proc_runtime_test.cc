@@ -0,0 +1,164 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/parallel_proc_runtime.h"
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/get_runfile_path.h"
+#include "xls/common/status/matchers.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/evaluator_options.h"
+#include "xls/interpreter/proc_runtime.h"
+#include "xls/interpreter/proc_runtime_test_base.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/channel_ops.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/jit_proc_runtime.h"
+
+namespace xls {
+namespace {
+
+using ::testing::Optional;
+
+constexpr const char kIrAssertPath[] = "xls/interpreter/force_assert.ir";
+
+class ParallelProcRuntimeTest : public IrTestBase {};
+
+TEST_F(ParallelProcRuntimeTest, JitAsserts) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::filesystem::path ir_path,
+                           GetXlsRunfilePath(kIrAssertPath));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string ir_text, GetFileContents(ir_path));
+  XLS_ASSERT_OK_AND_ASSIGN(auto package, Parser::ParsePackage(ir_text));
+  XLS_ASSERT_OK_AND_ASSIGN(auto runtime,
+                           CreateJitParallelProcRuntime(package.get()));
+
+  EXPECT_THAT(runtime->Tick(),
+              absl_testing::StatusIs(
+                  absl::StatusCode::kAborted,
+                  ::testing::HasSubstr("Assertion failure via fail!")));
+}
+
+// A wide network of independent pipelines, each a chain of pass-through procs
+// fed by an input channel. Checks that all values make it through every
+// pipeline in order regardless of which worker ticks which proc.
+TEST_F(ParallelProcRuntimeTest, WideNetworkOfPipelines) {
+  constexpr int64_t kPipelines = 16;
+  constexpr int64_t kStages = 4;
+  constexpr int64_t kValues = 50;
+  auto package = CreatePackage();
+  std::vector<Channel*> inputs;
+  std::vector<Channel*> outputs;
+  for (int64_t p = 0; p < kPipelines; ++p) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Channel * input,
+        package->CreateStreamingChannel(absl::StrFormat("in%d", p),
+                                        ChannelOps::kReceiveOnly,
+                                        package->GetBitsType(32)));
+    inputs.push_back(input);
+    Channel* previous = input;
+    for (int64_t s = 0; s < kStages; ++s) {
+      bool is_last = s == kStages - 1;
+      XLS_ASSERT_OK_AND_ASSIGN(
+          Channel * next,
+          package->CreateStreamingChannel(
+              absl::StrFormat("p%d_s%d", p, s),
+              is_last ? ChannelOps::kSendOnly : ChannelOps::kSendReceive,
+              package->GetBitsType(32)));
+      TokenlessProcBuilder pb(absl::StrFormat("proc_p%d_s%d", p, s), "tkn",
+                              package.get());
+      pb.Send(next, pb.Add(pb.Receive(previous), pb.Literal(UBits(1, 32))));
+      XLS_ASSERT_OK(pb.Build({}).status());
+      previous = next;
+    }
+    outputs.push_back(previous);
+  }
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ProcRuntime> runtime,
+      CreateJitParallelProcRuntime(package.get(), EvaluatorOptions(),
+                                   /*thread_count=*/4));
+  for (int64_t p = 0; p < kPipelines; ++p) {
+    ChannelQueue& queue = runtime->queue_manager().GetQueue(inputs[p]);
+    for (int64_t v = 0; v < kValues; ++v) {
+      XLS_ASSERT_OK(queue.Write(Value(UBits(100 * p + v, 32))));
+    }
+  }
+  XLS_ASSERT_OK(runtime->TickUntilBlocked(/*max_ticks=*/1000));
+  for (int64_t p = 0; p < kPipelines; ++p) {
+    ChannelQueue& queue = runtime->queue_manager().GetQueue(outputs[p]);
+    EXPECT_EQ(queue.GetSize(), kValues);
+    for (int64_t v = 0; v < kValues; ++v) {
+      EXPECT_THAT(queue.Read(),
+                  Optional(Value(UBits(100 * p + v + kStages, 32))));
+    }
+  }
+}
+
+// Instantiate and run all the tests in proc_runtime_test_base.cc using
+// the parallel runtime with a varying number of threads.
+INSTANTIATE_TEST_SUITE_P(
+    ParallelProcRuntimeTest, ProcRuntimeTestBase,
+    testing::Values(
+        ProcRuntimeTestParam(
+            "jit_1_thread",
+            [](Package* package, const EvaluatorOptions& options)
+                -> std::unique_ptr<ProcRuntime> {
+              return CreateJitParallelProcRuntime(package, options,
+                                                  /*thread_count=*/1)
+                  .value();
+            },
+            [](Proc* top, const EvaluatorOptions& options)
+                -> std::unique_ptr<ProcRuntime> {
+              return CreateJitParallelProcRuntime(top, options,
+                                                  /*thread_count=*/1)
+                  .value();
+            },
+            /*supports_observers=*/true),
+        ProcRuntimeTestParam(
+            "jit_4_threads",
+            [](Package* package, const EvaluatorOptions& options)
+                -> std::unique_ptr<ProcRuntime> {
+              return CreateJitParallelProcRuntime(package, options,
+                                                  /*thread_count=*/4)
+                  .value();
+            },
+            [](Proc* top, const EvaluatorOptions& options)
+                -> std::unique_ptr<ProcRuntime> {
+              return CreateJitParallelProcRuntime(top, options,
+                                                  /*thread_count=*/4)
+                  .value();
+            },
+            /*supports_observers=*/true)),
+    [](const testing::TestParamInfo<ProcRuntimeTestBase::ParamType>& info) {
+      return info.param.name();
+    });
+
+}  // namespace
+}  // namespace xls
@@ -174,6 +174,8 @@ class AbstractEvaluator {
     return result;
   }
 
+  Vector Reverse(Span input) { return Vector(input.rbegin(), input.rend()); }
+
   Element Equals(Span a, Span b) {
     CHECK_EQ(a.size(), b.size());
     Element result = One();
@@ -180,17 +180,8 @@ class AbstractNodeEvaluator : public DfsVisitorWithDefault {
     XLS_ASSIGN_OR_RETURN(LeafTypeTreeView<LeafValueT> rhs,
                          GetCompoundValue(eq->operand(1)), _ << "from: " << eq);
     XLS_RET_CHECK(lhs.type()->IsEqualTo(rhs.type())) << eq;
-    std::vector<typename AbstractEvaluatorT::Element> values;
-    values.reserve(lhs.elements().size());
-    for (int64_t i = 0; i < lhs.elements().size(); ++i) {
-      values.push_back(
-          evaluator().Equals(lhs.elements().at(i), rhs.elements().at(i)));
-    }
-    if (values.size() == 1) {
-      return SetValue(eq, std::move(values));
-    }
-    return SetValue(
-        eq, typename AbstractEvaluatorT::Vector{evaluator().AndReduce(values)});
+    typename AbstractEvaluatorT::Element equal = AllLeavesEqual(lhs, rhs);
+    return SetValue(eq, typename AbstractEvaluatorT::Vector{equal});
   }
 
   absl::Status HandleGate(Gate* gate) override {
@@ -265,18 +256,9 @@ class AbstractNodeEvaluator : public DfsVisitorWithDefault {
     XLS_ASSIGN_OR_RETURN(LeafTypeTreeView<LeafValueT> rhs,
                          GetCompoundValue(ne->operand(1)), _ << "from: " << ne);
     XLS_RET_CHECK(lhs.type()->IsEqualTo(rhs.type())) << ne;
-    std::vector<typename AbstractEvaluatorT::Element> values;
-    values.reserve(lhs.elements().size());
-    for (int64_t i = 0; i < lhs.elements().size(); ++i) {
-      values.push_back(
-          evaluator().Equals(lhs.elements().at(i), rhs.elements().at(i)));
-    }
-    if (values.size() == 1) {
-      return SetValue(ne, typename AbstractEvaluatorT::Vector{
-                              evaluator().Not(values.front())});
-    }
-    return SetValue(ne, typename AbstractEvaluatorT::Vector{evaluator().Not(
-                            evaluator().AndReduce(values).front())});
+    typename AbstractEvaluatorT::Element equal = AllLeavesEqual(lhs, rhs);
+    return SetValue(
+        ne, typename AbstractEvaluatorT::Vector{evaluator().Not(equal)});
   };
   absl::Status HandleNeg(UnOp* neg) override {
     XLS_ASSIGN_OR_RETURN(auto v, GetValue(neg->operand(0)));
@@ -344,9 +326,8 @@ class AbstractNodeEvaluator : public DfsVisitorWithDefault {
     return SetValue(or_reduce, evaluator_.OrReduce(args));
   }
   absl::Status HandleReverse(UnOp* reverse) override {
-    XLS_ASSIGN_OR_RETURN(auto vec, GetOwnedValue(reverse->operand(0)));
-    absl::c_reverse(vec);
-    return SetValue(reverse, std::move(vec));
+    XLS_ASSIGN_OR_RETURN(auto v, GetValue(reverse->operand(0)));
+    return SetValue(reverse, evaluator_.Reverse(v));
   }
   absl::Status HandleSDiv(BinOp* div) override {
     XLS_ASSIGN_OR_RETURN(auto lhs, GetValue(div->operand(0)));
@@ -646,6 +627,23 @@ class AbstractNodeEvaluator : public DfsVisitorWithDefault {
   }
 
  private:
+  // Returns whether each leaf of 'lhs' equals the corresponding leaf of 'rhs'.
+  typename AbstractEvaluatorT::Element AllLeavesEqual(
+      const LeafTypeTreeView<LeafValueT>& lhs,
+      const LeafTypeTreeView<LeafValueT>& rhs) {
+    if (lhs.elements().size() == 1) {
+      return evaluator().Equals(lhs.elements().front(),
+                                rhs.elements().front());
+    }
+    typename AbstractEvaluatorT::Element result = evaluator().One();
+    for (int64_t i = 0; i < lhs.elements().size(); ++i) {
+      result = evaluator().And(
+          result,
+          evaluator().Equals(lhs.elements().at(i), rhs.elements().at(i)));
+    }
+    return result;
+  }
+
   AbstractEvaluatorT& evaluator_;
   // Values of the components of components of compound values. nullptr values
   // represent values which are considered unconstrained. This uses unique_ptr
@@ -21,8 +21,10 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/numeric/int128.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
@@ -50,6 +52,92 @@ Bits TruncateOrSignExtend(Bits bits, int64_t bit_count) {
   return Truncate(std::move(bits), bit_count);
 }
 
+// Word-level arithmetic kernels. These operate directly on the uint64_t words
+// backing the bitmaps (least significant word first) and avoid the round trip
+// through BigInt for values wider than a single word.
+
+// Returns the sum of `lhs` and `rhs` modulo 2^bit_count. Both operands must
+// have the same width.
+Bits AddWords(const InlineBitmap& lhs, const InlineBitmap& rhs) {
+  InlineBitmap result(lhs.bit_count());
+  uint64_t carry = 0;
+  for (int64_t i = 0; i < result.word_count(); ++i) {
+    uint64_t a = lhs.GetWord(i);
+    uint64_t sum = a + rhs.GetWord(i);
+    uint64_t carry_out = sum < a ? 1 : 0;
+    sum += carry;
+    carry_out |= sum < carry ? 1 : 0;
+    result.SetWord(i, sum);
+    carry = carry_out;
+  }
+  return Bits::FromBitmap(std::move(result));
+}
+
+// Returns the difference of `lhs` and `rhs` modulo 2^bit_count. Both operands
+// must have the same width.
+Bits SubWords(const InlineBitmap& lhs, const InlineBitmap& rhs) {
+  InlineBitmap result(lhs.bit_count());
+  uint64_t borrow = 0;
+  for (int64_t i = 0; i < result.word_count(); ++i) {
+    uint64_t a = lhs.GetWord(i);
+    uint64_t b = rhs.GetWord(i);
+    uint64_t diff = a - b;
+    uint64_t borrow_out = a < b ? 1 : 0;
+    borrow_out |= diff < borrow ? 1 : 0;
+    diff -= borrow;
+    result.SetWord(i, diff);
+    borrow = borrow_out;
+  }
+  return Bits::FromBitmap(std::move(result));
+}
+
+// Returns the low `result_width` bits of the product of the unsigned values
+// `lhs` and `rhs` using schoolbook multiplication. Partial products above the
+// result width are never computed.
+Bits MulWords(const InlineBitmap& lhs, const InlineBitmap& rhs,
+              int64_t result_width) {
+  InlineBitmap result(result_width);
+  const int64_t result_words = result.word_count();
+  absl::InlinedVector<uint64_t, 8> accum(result_words, 0);
+  for (int64_t i = 0; i < std::min(lhs.word_count(), result_words); ++i) {
+    uint64_t a = lhs.GetWord(i);
+    if (a == 0) {
+      continue;
+    }
+    uint64_t carry = 0;
+    int64_t j = 0;
+    for (; j < rhs.word_count() && i + j < result_words; ++j) {
+      absl::uint128 t =
+          absl::uint128{a} * rhs.GetWord(j) + accum[i + j] + carry;
+      accum[i + j] = absl::Uint128Low64(t);
+      carry = absl::Uint128High64(t);
+    }
+    // No earlier row has written past index i + j - 1 so this word is zero.
+    if (i + j < result_words) {
+      accum[i + j] = carry;
+    }
+  }
+  for (int64_t i = 0; i < result_words; ++i) {
+    result.SetWord(i, accum[i]);
+  }
+  return Bits::FromBitmap(std::move(result));
+}
+
+// Divides the unsigned value `lhs` by the non-zero single word `divisor`.
+// Returns the quotient, which has the width of `lhs`, and sets `remainder`.
+Bits DivWord(const InlineBitmap& lhs, uint64_t divisor, uint64_t* remainder) {
+  DCHECK_NE(divisor, 0);
+  InlineBitmap quotient(lhs.bit_count());
+  uint64_t rem = 0;
+  for (int64_t i = lhs.word_count() - 1; i >= 0; --i) {
+    absl::uint128 dividend = absl::MakeUint128(rem, lhs.GetWord(i));
+    quotient.SetWord(i, absl::Uint128Low64(dividend / divisor));
+    rem = absl::Uint128Low64(dividend % divisor);
+  }
+  *remainder = rem;
+  return Bits::FromBitmap(std::move(quotient));
+}
+
 }  // namespace
 
 Bits And(const Bits& lhs, const Bits& rhs) {
@@ -204,9 +292,7 @@ Bits Add(const Bits& lhs, const Bits& rhs) {
     return UBits(result, lhs.bit_count());
   }
 
-  Bits sum = BigInt::Add(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
-                 .ToSignedBits();
-  return TruncateOrSignExtend(std::move(sum), lhs.bit_count());
+  return AddWords(lhs.bitmap(), rhs.bitmap());
 }
 
 Bits Sub(const Bits& lhs, const Bits& rhs) {
@@ -217,9 +303,7 @@ Bits Sub(const Bits& lhs, const Bits& rhs) {
     uint64_t result = (lhs_int - rhs_int) & Mask(lhs.bit_count());
     return UBits(result, lhs.bit_count());
   }
-  Bits diff = BigInt::Sub(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
-                  .ToSignedBits();
-  return TruncateOrSignExtend(std::move(diff), lhs.bit_count());
+  return SubWords(lhs.bitmap(), rhs.bitmap());
 }
 
 Bits Increment(const Bits& x) {
@@ -257,9 +341,10 @@ Bits SMul(const Bits& lhs, const Bits& rhs) {
     return SBits(result, result_width);
   }
 
-  BigInt product =
-      BigInt::Mul(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs));
-  return product.ToSignedBitsWithBitCount(result_width).value();
+  // The signed product fits in `result_width` bits so it is equal to the low
+  // bits of the product of the sign-extended operands.
+  return MulWords(SignExtend(lhs, result_width).bitmap(),
+                  SignExtend(rhs, result_width).bitmap(), result_width);
 }
 
 Bits UMul(const Bits& lhs, const Bits& rhs) {
@@ -271,15 +356,21 @@ Bits UMul(const Bits& lhs, const Bits& rhs) {
     return UBits(result, result_width);
   }
 
-  BigInt product =
-      BigInt::Mul(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
-  return product.ToUnsignedBitsWithBitCount(result_width).value();
+  return MulWords(lhs.bitmap(), rhs.bitmap(), result_width);
 }
 
 Bits UDiv(const Bits& lhs, const Bits& rhs) {
   if (rhs.IsZero()) {
     return Bits::AllOnes(lhs.bit_count());
   }
+  if (rhs.FitsInUint64()) {
+    uint64_t divisor = rhs.ToUint64().value();
+    if (lhs.bit_count() <= 64) {
+      return UBits(lhs.ToUint64().value() / divisor, lhs.bit_count());
+    }
+    uint64_t remainder;
+    return DivWord(lhs.bitmap(), divisor, &remainder);
+  }
   BigInt quotient =
       BigInt::Div(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
   return ZeroExtend(quotient.ToUnsignedBits(), lhs.bit_count());
@@ -289,6 +380,15 @@ Bits UMod(const Bits& lhs, const Bits& rhs) {
   if (rhs.IsZero()) {
     return Bits(rhs.bit_count());
   }
+  if (rhs.FitsInUint64()) {
+    uint64_t divisor = rhs.ToUint64().value();
+    if (lhs.bit_count() <= 64) {
+      return UBits(lhs.ToUint64().value() % divisor, rhs.bit_count());
+    }
+    uint64_t remainder;
+    DivWord(lhs.bitmap(), divisor, &remainder);
+    return UBits(remainder, rhs.bit_count());
+  }
   BigInt modulo =
       BigInt::Mod(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
   return ZeroExtend(modulo.ToUnsignedBits(), rhs.bit_count());
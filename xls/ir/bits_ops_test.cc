@@ -29,6 +29,7 @@
 #include "absl/strings/str_split.h"
 #include "xls/common/status/matchers.h"
 #include "xls/data_structures/inline_bitmap.h"
+#include "xls/ir/big_int.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/bits_test_utils.h"
 #include "xls/ir/format_preference.h"
@@ -304,6 +305,74 @@ TEST(BitsOpsTest, UMod) {
             "0x1002_3004_5006");
 }
 
+TEST(BitsOpsTest, WideArithmeticCarriesAcrossWords) {
+  EXPECT_EQ(bits_ops::Add(Bits::AllOnes(200), UBits(1, 200)), Bits(200));
+  EXPECT_EQ(bits_ops::Sub(Bits(200), UBits(1, 200)), Bits::AllOnes(200));
+  EXPECT_EQ(bits_ops::Add(Bits::AllOnes(128), Bits::AllOnes(128)),
+            bits_ops::ShiftLeftLogical(Bits::AllOnes(128), 1));
+  EXPECT_EQ(bits_ops::SMul(SBits(-1, 100), SBits(-1, 100)), UBits(1, 200));
+  EXPECT_EQ(bits_ops::SMul(SBits(-3, 100), UBits(5, 100)), SBits(-15, 200));
+  EXPECT_EQ(bits_ops::UDiv(Bits::AllOnes(192), UBits(3, 2)),
+            bits_ops::Concat({UBits(0x5555555555555555, 64),
+                              UBits(0x5555555555555555, 64),
+                              UBits(0x5555555555555555, 64)}));
+  EXPECT_EQ(bits_ops::UMod(Bits::AllOnes(192), UBits(11, 100)), UBits(3, 100));
+}
+
+// Resizes `rhs` to the width of `lhs`.
+Bits MatchWidth(const Bits& lhs, const Bits& rhs) {
+  return rhs.bit_count() > lhs.bit_count()
+             ? bits_ops::Truncate(rhs, lhs.bit_count())
+             : bits_ops::ZeroExtend(rhs, lhs.bit_count());
+}
+
+void AddMatchesBigInt(const Bits& lhs, const Bits& rhs) {
+  Bits resized_rhs = MatchWidth(lhs, rhs);
+  Bits expected = bits_ops::Truncate(
+      bits_ops::ZeroExtend(
+          BigInt::Add(BigInt::MakeUnsigned(lhs),
+                      BigInt::MakeUnsigned(resized_rhs))
+              .ToUnsignedBits(),
+          lhs.bit_count() + 1),
+      lhs.bit_count());
+  EXPECT_EQ(bits_ops::Add(lhs, resized_rhs), expected);
+  EXPECT_EQ(bits_ops::Sub(expected, resized_rhs), lhs);
+}
+FUZZ_TEST(BitsOpsFuzzTest, AddMatchesBigInt)
+    .WithDomains(NonemptyBits(), NonemptyBits());
+
+void MulMatchesBigInt(const Bits& lhs, const Bits& rhs) {
+  const int64_t result_width = lhs.bit_count() + rhs.bit_count();
+  EXPECT_EQ(bits_ops::UMul(lhs, rhs),
+            BigInt::Mul(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs))
+                .ToUnsignedBitsWithBitCount(result_width)
+                .value());
+  EXPECT_EQ(bits_ops::SMul(lhs, rhs),
+            BigInt::Mul(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
+                .ToSignedBitsWithBitCount(result_width)
+                .value());
+}
+FUZZ_TEST(BitsOpsFuzzTest, MulMatchesBigInt)
+    .WithDomains(NonemptyBits(), NonemptyBits());
+
+void DivModMatchesBigInt(const Bits& lhs, const Bits& rhs) {
+  if (rhs.IsZero()) {
+    return;
+  }
+  BigInt lhs_int = BigInt::MakeUnsigned(lhs);
+  BigInt rhs_int = BigInt::MakeUnsigned(rhs);
+  EXPECT_EQ(bits_ops::UDiv(lhs, rhs),
+            BigInt::Div(lhs_int, rhs_int)
+                .ToUnsignedBitsWithBitCount(lhs.bit_count())
+                .value());
+  EXPECT_EQ(bits_ops::UMod(lhs, rhs),
+            BigInt::Mod(lhs_int, rhs_int)
+                .ToUnsignedBitsWithBitCount(rhs.bit_count())
+                .value());
+}
+FUZZ_TEST(BitsOpsFuzzTest, DivModMatchesBigInt)
+    .WithDomains(NonemptyBits(), NonemptyBits(/*max_byte_count=*/8));
+
 TEST(BitsOpsTest, SDiv) {
   EXPECT_EQ(bits_ops::SDiv(SBits(100, 64), SBits(5, 64)), SBits(20, 64));
   EXPECT_EQ(bits_ops::SDiv(SBits(100, 64), SBits(-5, 64)), SBits(-20, 64));
@@ -1228,5 +1297,45 @@ void BM_ZeroExtendMove(benchmark::State& state) {
 }
 BENCHMARK(BM_ZeroExtendMove)->Range(33, 1 << 20);
 
+// Returns a value of the given width with a pseudo-random bit pattern.
+Bits BenchmarkValue(int64_t bit_count, uint64_t seed) {
+  InlineBitmap bitmap(bit_count);
+  uint64_t word = seed;
+  for (int64_t i = 0; i < bitmap.word_count(); ++i) {
+    word = word * 6364136223846793005 + 1442695040888963407;
+    bitmap.SetWord(i, word);
+  }
+  return Bits::FromBitmap(std::move(bitmap));
+}
+
+template <Bits (*kOp)(const Bits&, const Bits&)>
+void BM_BinaryOp(benchmark::State& state) {
+  Bits lhs = BenchmarkValue(state.range(0), 1);
+  Bits rhs = BenchmarkValue(state.range(0), 2);
+  for (auto _ : state) {
+    auto v = kOp(lhs, rhs);
+    benchmark::DoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_BinaryOp<bits_ops::Add>)->Range(1, 4096);
+BENCHMARK(BM_BinaryOp<bits_ops::Sub>)->Range(1, 4096);
+BENCHMARK(BM_BinaryOp<bits_ops::UMul>)->Range(1, 4096);
+BENCHMARK(BM_BinaryOp<bits_ops::SMul>)->Range(1, 4096);
+BENCHMARK(BM_BinaryOp<bits_ops::UDiv>)->Range(1, 4096);
+BENCHMARK(BM_BinaryOp<bits_ops::UMod>)->Range(1, 4096);
+
+// Division by a divisor which fits in a single word.
+template <Bits (*kOp)(const Bits&, const Bits&)>
+void BM_DivideBySmall(benchmark::State& state) {
+  Bits lhs = BenchmarkValue(state.range(0), 1);
+  Bits rhs = bits_ops::ZeroExtend(UBits(1000003, 20), state.range(0));
+  for (auto _ : state) {
+    auto v = kOp(lhs, rhs);
+    benchmark::DoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_DivideBySmall<bits_ops::UDiv>)->Range(64, 4096);
+BENCHMARK(BM_DivideBySmall<bits_ops::UMod>)->Range(64, 4096);
+
 }  // namespace
 }  // namespace xls
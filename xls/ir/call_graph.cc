@@ -55,8 +55,8 @@ std::optional<Function*> CalledFunction(Node* node) {
       return std::nullopt;
   }
 }
+}  // namespace
 
-// Returns the functions called directly by the nodes of the given FunctionBase.
 std::vector<FunctionBase*> CalledFunctions(FunctionBase* function_base) {
   absl::flat_hash_set<FunctionBase*> called_set;
   std::vector<FunctionBase*> called;
@@ -84,7 +84,6 @@ std::vector<FunctionBase*> CalledFunctions(FunctionBase* function_base) {
   }
   return called;
 }
-}  // namespace
 
 // Recursive DFS visitor of the call graph induced by invoke
 // instructions. Builds a post order of functions in the post_order vector.
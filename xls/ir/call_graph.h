@@ -26,6 +26,10 @@
 
 namespace xls {
 
+// Returns the functions called and blocks instantiated directly by the given
+// FunctionBase without duplicates.
+std::vector<FunctionBase*> CalledFunctions(FunctionBase* function_base);
+
 // Returns the functions called and blocks instantiated transitively by the
 // given FunctionBase. Called functions/instantiated blocks are returned before
 // callee/instantiator FunctionBases in the returned order. The final element in
@@ -0,0 +1,58 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_IR_CHANGE_LISTENER_H_
+#define XLS_IR_CHANGE_LISTENER_H_
+
+namespace xls {
+
+class FunctionBase;
+class Node;
+
+// Interface for observing mutations of the nodes of a FunctionBase. Listeners
+// are registered with FunctionBase::AddChangeListener and are notified
+// synchronously as the graph is mutated. Listeners are not owned by the
+// FunctionBase and must be removed before they are destroyed.
+//
+// Notifications are only sent for nodes which have been added to the
+// function. Operands set during construction of a node are reported by
+// NodeAdded. Nodes deleted along with the FunctionBase itself are not reported
+// individually.
+class ChangeListener {
+ public:
+  virtual ~ChangeListener() = default;
+
+  // Called after `node` has been added to the function.
+  virtual void NodeAdded(Node* node) {}
+
+  // Called before `node` is removed from the function and deleted. `node` has
+  // no users at this point. The pointer must not be dereferenced after this
+  // call returns.
+  virtual void NodeDeleted(Node* node) {}
+
+  // Called after an operand of `node` changed from `old_operand` to
+  // `new_operand`. `old_operand` is nullptr if an operand was added and
+  // `new_operand` is nullptr if an operand was removed.
+  virtual void OperandChanged(Node* node, Node* old_operand,
+                              Node* new_operand) {}
+
+  // Called when the FunctionBase is destroyed. The listener is implicitly
+  // unregistered.
+  virtual void FunctionBaseDeleted(FunctionBase* function_base) {}
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_CHANGE_LISTENER_H_
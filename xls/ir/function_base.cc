@@ -47,6 +47,21 @@
 
 namespace xls {
 
+FunctionBase::~FunctionBase() {
+  // Listeners may unregister themselves in response.
+  std::vector<ChangeListener*> listeners = std::move(change_listeners_);
+  change_listeners_.clear();
+  for (ChangeListener* listener : listeners) {
+    listener->FunctionBaseDeleted(this);
+  }
+  Node* node = first_node_;
+  while (node != nullptr) {
+    Node* next = node->next_in_function_base_;
+    delete node;
+    node = next;
+  }
+}
+
 std::vector<std::string> FunctionBase::AttributeIrStrings() const {
   std::vector<std::string> attribute_strings;
   if (ForeignFunctionData().has_value()) {
@@ -152,10 +167,27 @@ absl::Status FunctionBase::RemoveNode(Node* node) {
     next_values_by_state_read_.at(state_read).erase(next);
     std::erase(next_values_, next);
   }
-  auto node_it = node_iterators_.find(node);
-  XLS_RET_CHECK(node_it != node_iterators_.end());
-  nodes_.erase(node_it->second);
-  node_iterators_.erase(node_it);
+  XLS_RET_CHECK_EQ(node->function_base(), this) << node->GetName();
+  for (ChangeListener* listener : change_listeners_) {
+    listener->NodeDeleted(node);
+  }
+  if (topo_order_ != nullptr) {
+    topo_order_->NodeRemoved(node);
+  }
+  if (node->prev_in_function_base_ == nullptr) {
+    first_node_ = node->next_in_function_base_;
+  } else {
+    node->prev_in_function_base_->next_in_function_base_ =
+        node->next_in_function_base_;
+  }
+  if (node->next_in_function_base_ == nullptr) {
+    last_node_ = node->prev_in_function_base_;
+  } else {
+    node->next_in_function_base_->prev_in_function_base_ =
+        node->prev_in_function_base_;
+  }
+  --node_count_;
+  delete node;
   return absl::OkStatus();
 }
 
@@ -244,8 +276,22 @@ Node* FunctionBase::AddNodeInternal(std::unique_ptr<Node> node) {
     next_values_.push_back(node->As<Next>());
     next_values_by_state_read_.at(state_read).insert(next);
   }
-  Node* ptr = node.get();
-  node_iterators_[ptr] = nodes_.insert(nodes_.end(), std::move(node));
+  Node* ptr = node.release();
+  ptr->prev_in_function_base_ = last_node_;
+  ptr->next_in_function_base_ = nullptr;
+  if (last_node_ == nullptr) {
+    first_node_ = ptr;
+  } else {
+    last_node_->next_in_function_base_ = ptr;
+  }
+  last_node_ = ptr;
+  ++node_count_;
+  if (topo_order_ != nullptr) {
+    topo_order_->NodeAdded(ptr);
+  }
+  for (ChangeListener* listener : change_listeners_) {
+    listener->NodeAdded(ptr);
+  }
   return ptr;
 }
 
@@ -15,8 +15,9 @@
 #ifndef XLS_IR_FUNCTION_BASE_H_
 #define XLS_IR_FUNCTION_BASE_H_
 
+#include <cstddef>
 #include <cstdint>
-#include <list>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <ostream>
@@ -32,13 +33,14 @@
 #include "absl/types/span.h"
 #include "xls/common/iterator_range.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/change_listener.h"
 #include "xls/ir/dfs_visitor.h"
 #include "xls/ir/foreign_function_data.pb.h"
+#include "xls/ir/incremental_topo_order.h"
 #include "xls/ir/name_uniquer.h"
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
-#include "xls/ir/unwrapping_iterator.h"
 #include "xls/ir/verify_node.h"
 
 namespace xls {
@@ -48,16 +50,43 @@ class Proc;
 
 // Base class for Functions and Procs. A holder of a set of nodes.
 class FunctionBase {
- protected:
-  using NodeList = std::list<std::unique_ptr<Node>>;
-
  public:
+  // Iterator over the nodes of a FunctionBase in the order they were added.
+  // Adding nodes does not invalidate iterators. Removing a node invalidates
+  // only the iterators which point to it.
+  class NodeIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Node*;
+    using difference_type = ptrdiff_t;
+    using pointer = Node* const*;
+    using reference = Node*;
+
+    NodeIterator() = default;
+    explicit NodeIterator(Node* node) : node_(node) {}
+
+    Node* operator*() const { return node_; }
+    NodeIterator& operator++() {
+      node_ = node_->next_in_function_base_;
+      return *this;
+    }
+    NodeIterator operator++(int) {
+      NodeIterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+    bool operator==(const NodeIterator& other) const = default;
+
+   private:
+    Node* node_ = nullptr;
+  };
+
   FunctionBase(std::string_view name, Package* package)
       : name_(name), package_(package) {}
   FunctionBase(const FunctionBase& other) = delete;
   void operator=(const FunctionBase& other) = delete;
 
-  virtual ~FunctionBase() = default;
+  virtual ~FunctionBase();
 
   Package* package() const { return package_; }
   const std::string& name() const { return name_; }
@@ -101,18 +130,12 @@ class FunctionBase {
   // Moves the given param to the given index in the parameter list.
   absl::Status MoveParamToIndex(Param* param, int64_t index);
 
-  int64_t node_count() const { return nodes_.size(); }
+  int64_t node_count() const { return node_count_; }
 
   // Expose Nodes, so that transformation passes can operate
   // on this function.
-  xabsl::iterator_range<UnwrappingIterator<NodeList::iterator>> nodes() {
-    return xabsl::make_range(MakeUnwrappingIterator(nodes_.begin()),
-                             MakeUnwrappingIterator(nodes_.end()));
-  }
-  xabsl::iterator_range<UnwrappingIterator<NodeList::const_iterator>> nodes()
-      const {
-    return xabsl::make_range(MakeUnwrappingIterator(nodes_.begin()),
-                             MakeUnwrappingIterator(nodes_.end()));
+  xabsl::iterator_range<NodeIterator> nodes() const {
+    return xabsl::make_range(NodeIterator(first_node_), NodeIterator());
   }
 
   // Adds a node to the set owned by this function.
@@ -147,6 +170,32 @@ class FunctionBase {
     return new_node;
   }
 
+  // Returns true if `a` precedes `b` in a topological order of the nodes. The
+  // order is computed on first use and then maintained incrementally as nodes
+  // are added and removed and operands are replaced, so repeated queries do
+  // not re-sort the graph. The order is generally not the one returned by
+  // TopoSort. See IncrementalTopoOrder.
+  bool IsBeforeInTopoOrder(const Node* a, const Node* b) {
+    return GetIncrementalTopoOrder().IsBefore(a, b);
+  }
+
+  // Returns the nodes in the incrementally maintained topological order used
+  // by IsBeforeInTopoOrder.
+  std::vector<Node*> IncrementalTopoSort() {
+    return GetIncrementalTopoOrder().GetOrder();
+  }
+
+  // Registers `listener` to be notified of mutations of the nodes of this
+  // function. The listener is not owned and must outlive its registration.
+  void AddChangeListener(ChangeListener* listener) {
+    change_listeners_.push_back(listener);
+  }
+
+  // Unregisters a listener added with AddChangeListener.
+  void RemoveChangeListener(ChangeListener* listener) {
+    std::erase(change_listeners_, listener);
+  }
+
   // Find a node by its name, as generated by DumpIr.
   absl::StatusOr<Node*> GetNode(std::string_view standard_node_name) const;
 
@@ -219,6 +268,34 @@ class FunctionBase {
   // added node.
   virtual Node* AddNodeInternal(std::unique_ptr<Node> node);
 
+  // Node notifies the incrementally maintained topological order of new
+  // operand edges.
+  friend class Node;
+  void OperandAdded(Node* operand, Node* user) {
+    if (topo_order_ != nullptr) {
+      topo_order_->OperandAdded(operand, user);
+    }
+  }
+
+  // Node notifies the change listeners of operand mutations. Mutations of
+  // nodes which have not yet been added to the function are not reported.
+  void OperandChanged(Node* node, Node* old_operand, Node* new_operand) {
+    if (change_listeners_.empty() ||
+        (node->prev_in_function_base_ == nullptr && first_node_ != node)) {
+      return;
+    }
+    for (ChangeListener* listener : change_listeners_) {
+      listener->OperandChanged(node, old_operand, new_operand);
+    }
+  }
+
+  IncrementalTopoOrder& GetIncrementalTopoOrder() {
+    if (topo_order_ == nullptr) {
+      topo_order_ = std::make_unique<IncrementalTopoOrder>(this);
+    }
+    return *topo_order_;
+  }
+
   // Returns a vector containing the reserved words in the IR.
   static std::vector<std::string> GetIrReservedWords();
 
@@ -226,11 +303,18 @@ class FunctionBase {
   Package* package_;
   std::optional<int64_t> initiation_interval_;
 
-  // Store Nodes in std::list as they can be added and removed arbitrarily and
-  // we want a stable iteration order. Keep a map from instruction pointer to
-  // location in the list for fast lookup.
-  NodeList nodes_;
-  absl::flat_hash_map<const Node*, NodeList::iterator> node_iterators_;
+  // Nodes are owned by the function base and kept in an intrusive doubly
+  // linked list threaded through the nodes themselves as they can be added and
+  // removed arbitrarily and we want a stable iteration order.
+  Node* first_node_ = nullptr;
+  Node* last_node_ = nullptr;
+  int64_t node_count_ = 0;
+
+  // Created on the first topological order query. Null otherwise so mutations
+  // incur no overhead unless the order is used.
+  std::unique_ptr<IncrementalTopoOrder> topo_order_;
+
+  std::vector<ChangeListener*> change_listeners_;
 
   std::vector<Param*> params_;
   std::vector<Next*> next_values_;
@@ -24,8 +24,10 @@
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "xls/common/status/matchers.h"
 #include "xls/ir/bits.h"
+#include "xls/ir/change_listener.h"
 #include "xls/ir/dfs_visitor.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_test_base.h"
@@ -197,6 +199,87 @@ fn id(x: bits[32], y: bits[32]) -> bits[32] {
   EXPECT_EQ(func->GetType(), updated);
 }
 
+TEST_F(FunctionTest, NodesInInsertionOrderAfterRemoval) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, ParseFunction(R"(
+fn f(x: bits[32], y: bits[32]) -> bits[32] {
+  not.3: bits[32] = not(x)
+  neg.4: bits[32] = neg(y)
+  ret add.5: bits[32] = add(x, y)
+}
+)",
+                                                          p.get()));
+  Node* x = FindNode("x", func);
+  Node* y = FindNode("y", func);
+  Node* add = FindNode("add.5", func);
+  XLS_ASSERT_OK(func->RemoveNode(FindNode("not.3", func)));
+  XLS_ASSERT_OK(func->RemoveNode(FindNode("neg.4", func)));
+  EXPECT_EQ(func->node_count(), 3);
+  EXPECT_THAT(func->nodes(), ElementsAre(x, y, add));
+
+  // Removing the first and last nodes updates the ends of the list.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * sub, func->MakeNode<BinOp>(SourceInfo(), x, y, Op::kSub));
+  XLS_ASSERT_OK(func->set_return_value(sub));
+  XLS_ASSERT_OK(func->RemoveNode(add));
+  EXPECT_THAT(func->nodes(), ElementsAre(x, y, sub));
+  XLS_ASSERT_OK_AND_ASSIGN(Node * inv,
+                           func->MakeNode<UnOp>(SourceInfo(), x, Op::kNot));
+  EXPECT_THAT(func->nodes(), ElementsAre(x, y, sub, inv));
+  XLS_ASSERT_OK(func->RemoveNode(inv));
+  EXPECT_THAT(func->nodes(), ElementsAre(x, y, sub));
+  EXPECT_EQ(func->node_count(), 3);
+}
+
+class RecordingListener : public ChangeListener {
+ public:
+  void NodeAdded(Node* node) override {
+    events_.push_back(absl::StrCat("added ", node->GetName()));
+  }
+  void NodeDeleted(Node* node) override {
+    events_.push_back(absl::StrCat("deleted ", node->GetName()));
+  }
+  void OperandChanged(Node* node, Node* old_operand,
+                      Node* new_operand) override {
+    events_.push_back(absl::StrCat(
+        node->GetName(), ": ",
+        old_operand == nullptr ? "none" : old_operand->GetName(), " -> ",
+        new_operand == nullptr ? "none" : new_operand->GetName()));
+  }
+
+  const std::vector<std::string>& events() const { return events_; }
+
+ private:
+  std::vector<std::string> events_;
+};
+
+TEST_F(FunctionTest, ChangeListenerIsNotified) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, ParseFunction(R"(
+fn f(x: bits[32], y: bits[32]) -> bits[32] {
+  ret add.3: bits[32] = add(x, y)
+}
+)",
+                                                          p.get()));
+  RecordingListener listener;
+  func->AddChangeListener(&listener);
+  Node* x = FindNode("x", func);
+  Node* y = FindNode("y", func);
+  Node* add = FindNode("add.3", func);
+  // Operands set when the node is constructed are not reported separately.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * sub, func->MakeNodeWithName<BinOp>(SourceInfo(), x, y, Op::kSub,
+                                                "sub"));
+  XLS_ASSERT_OK(add->ReplaceUsesWith(sub));
+  XLS_ASSERT_OK(func->RemoveNode(add));
+  XLS_ASSERT_OK(sub->ReplaceOperandNumber(1, x));
+  func->RemoveChangeListener(&listener);
+  XLS_ASSERT_OK(sub->ReplaceOperandNumber(1, y));
+
+  EXPECT_THAT(listener.events(),
+              ElementsAre("added sub", "deleted add.3", "sub: y -> x"));
+}
+
 TEST_F(FunctionTest, MoveParams) {
   auto p = CreatePackage();
   FunctionBuilder b("f", p.get());
@@ -0,0 +1,214 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/ir/incremental_topo_order.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/topo_sort.h"
+
+namespace xls {
+namespace {
+
+// Holes are only compacted once there are at least this many of them.
+constexpr int64_t kMinHolesToCompact = 64;
+
+// Maximum number of nodes visited while repairing the order between two
+// queries. Past this the order is recomputed by TopoSort on the next query
+// instead, so maintaining the order never costs much more than calling TopoSort
+// when it is queried. In particular a pass which mutates the graph without
+// querying the order stops maintaining it once the budget is spent, after which
+// every notification returns immediately.
+constexpr int64_t kMaxReorderVisits = 1024;
+
+// Encodes the position of a node visited while repairing the order, and
+// decodes it again. Encoded positions are below -1 so they never compare as
+// within the region being repaired.
+int64_t MarkedPosition(int64_t position) { return -2 - position; }
+
+}  // namespace
+
+IncrementalTopoOrder::IncrementalTopoOrder(FunctionBase* f)
+    : function_base_(f) {
+  Rebuild();
+}
+
+// Nodes are deleted before the order when a FunctionBase is destroyed so the
+// destructor must not touch them.
+IncrementalTopoOrder::~IncrementalTopoOrder() = default;
+
+bool IncrementalTopoOrder::IsBefore(const Node* a, const Node* b) {
+  MaybeRebuild();
+  visits_since_query_ = 0;
+  DCHECK_GE(a->topo_position_, 0) << a;
+  DCHECK_GE(b->topo_position_, 0) << b;
+  return a->topo_position_ < b->topo_position_;
+}
+
+std::vector<Node*> IncrementalTopoOrder::GetOrder() {
+  MaybeRebuild();
+  visits_since_query_ = 0;
+  std::vector<Node*> result;
+  result.reserve(order_.size() - hole_count_);
+  for (Node* node : order_) {
+    if (node != nullptr) {
+      result.push_back(node);
+    }
+  }
+  return result;
+}
+
+void IncrementalTopoOrder::NodeAdded(Node* node) {
+  if (needs_rebuild_) {
+    return;
+  }
+  node->topo_position_ = order_.size();
+  order_.push_back(node);
+}
+
+void IncrementalTopoOrder::NodeRemoved(Node* node) {
+  if (needs_rebuild_ || node->topo_position_ < 0) {
+    return;
+  }
+  order_[node->topo_position_] = nullptr;
+  node->topo_position_ = -1;
+  ++hole_count_;
+  if (hole_count_ >= kMinHolesToCompact &&
+      2 * hole_count_ > static_cast<int64_t>(order_.size())) {
+    Compact();
+  }
+}
+
+void IncrementalTopoOrder::OperandAdded(Node* operand, Node* user) {
+  int64_t lower = user->topo_position_;
+  int64_t upper = operand->topo_position_;
+  // Nothing to do if the order is already being recomputed, if the user is
+  // still under construction and not yet in the order, or if the new edge
+  // agrees with the order.
+  if (needs_rebuild_ || lower < 0 || upper < lower) {
+    return;
+  }
+  if (upper == lower) {
+    needs_rebuild_ = true;
+    return;
+  }
+
+  // Collect the nodes reachable from `user` which are placed before `operand`
+  // and the nodes which reach `operand` which are placed after `user`. Only
+  // these need to move, and they move within the positions they already
+  // occupy. Visited nodes are marked by encoding their position as a negative
+  // number so no set of visited nodes has to be allocated. Bailing out leaves
+  // marked nodes behind which is fine as the rebuild reassigns all positions.
+  forward_.clear();
+  backward_.clear();
+  auto visit = [&](Node* node, std::vector<Node*>& nodes) {
+    nodes.push_back(node);
+    node->topo_position_ = MarkedPosition(node->topo_position_);
+  };
+  visit(user, forward_);
+  for (int64_t i = 0; i < forward_.size(); ++i) {
+    for (Node* node_user : forward_[i]->users()) {
+      int64_t position = node_user->topo_position_;
+      if (position == upper) {
+        // `operand` is reachable from `user` so the new edge closes a cycle.
+        VLOG(3) << "Operand edge " << operand->GetName() << " -> "
+                << user->GetName() << " closes a cycle";
+        needs_rebuild_ = true;
+        return;
+      }
+      if (position >= 0 && position < upper) {
+        visit(node_user, forward_);
+      }
+    }
+    if (visits_since_query_ + static_cast<int64_t>(forward_.size()) >
+        kMaxReorderVisits) {
+      needs_rebuild_ = true;
+      return;
+    }
+  }
+  visit(operand, backward_);
+  for (int64_t i = 0; i < backward_.size(); ++i) {
+    for (Node* node_operand : backward_[i]->operands()) {
+      if (node_operand->topo_position_ > lower) {
+        visit(node_operand, backward_);
+      }
+    }
+    if (visits_since_query_ +
+            static_cast<int64_t>(forward_.size() + backward_.size()) >
+        kMaxReorderVisits) {
+      needs_rebuild_ = true;
+      return;
+    }
+  }
+
+  // Marking negates the order so sorting by the marked positions in
+  // descending order sorts by position.
+  auto by_position = [](const Node* a, const Node* b) {
+    return a->topo_position_ > b->topo_position_;
+  };
+  absl::c_sort(forward_, by_position);
+  absl::c_sort(backward_, by_position);
+  positions_.clear();
+  for (const std::vector<Node*>* nodes : {&backward_, &forward_}) {
+    for (Node* node : *nodes) {
+      positions_.push_back(MarkedPosition(node->topo_position_));
+    }
+  }
+  absl::c_sort(positions_);
+  visits_since_query_ += positions_.size();
+  int64_t i = 0;
+  for (const std::vector<Node*>* nodes : {&backward_, &forward_}) {
+    for (Node* node : *nodes) {
+      node->topo_position_ = positions_[i++];
+      order_[node->topo_position_] = node;
+    }
+  }
+}
+
+void IncrementalTopoOrder::MaybeRebuild() {
+  if (needs_rebuild_) {
+    Rebuild();
+  }
+}
+
+void IncrementalTopoOrder::Rebuild() {
+  order_ = TopoSort(function_base_);
+  for (int64_t i = 0; i < order_.size(); ++i) {
+    order_[i]->topo_position_ = i;
+  }
+  hole_count_ = 0;
+  needs_rebuild_ = false;
+}
+
+void IncrementalTopoOrder::Compact() {
+  int64_t next = 0;
+  for (Node* node : order_) {
+    if (node != nullptr) {
+      node->topo_position_ = next;
+      order_[next++] = node;
+    }
+  }
+  order_.resize(next);
+  hole_count_ = 0;
+}
+
+}  // namespace xls
@@ -0,0 +1,89 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_IR_INCREMENTAL_TOPO_ORDER_H_
+#define XLS_IR_INCREMENTAL_TOPO_ORDER_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace xls {
+
+class FunctionBase;
+class Node;
+
+// A topological order of the nodes of a FunctionBase which is maintained
+// incrementally as the graph is mutated. Each node holds its position in the
+// order so comparing two nodes is O(1). New nodes are appended to the end of
+// the order which is always valid because their operands already exist.
+// Removed nodes leave holes which are compacted once they make up half of the
+// order. When an operand edge is added which points backwards in the order the
+// affected region is reordered using the algorithm of Pearce and Kelly ("A
+// Dynamic Topological Sort Algorithm for Directed Acyclic Graphs", 2006),
+// which only visits nodes whose position lies between the two endpoints. Once
+// the repairs since the last query have visited too many nodes the order is
+// instead recomputed on the next query. This bounds the cost of maintaining an
+// order which is no longer being queried.
+//
+// The order is generally not the one returned by TopoSort. Instances are owned
+// by the FunctionBase and notified of mutations by it; see
+// FunctionBase::IsBeforeInTopoOrder.
+class IncrementalTopoOrder {
+ public:
+  // Initializes the order from TopoSort(f).
+  explicit IncrementalTopoOrder(FunctionBase* f);
+  ~IncrementalTopoOrder();
+
+  IncrementalTopoOrder(const IncrementalTopoOrder&) = delete;
+  IncrementalTopoOrder& operator=(const IncrementalTopoOrder&) = delete;
+
+  // Returns true if `a` comes before `b` in the order.
+  bool IsBefore(const Node* a, const Node* b);
+
+  // Returns the nodes in order.
+  std::vector<Node*> GetOrder();
+
+  // Notifications of graph mutations.
+  void NodeAdded(Node* node);
+  void NodeRemoved(Node* node);
+  void OperandAdded(Node* operand, Node* user);
+
+ private:
+  // Rebuilds the order from scratch if a mutation could not be applied
+  // incrementally.
+  void MaybeRebuild();
+  void Rebuild();
+  void Compact();
+
+  FunctionBase* function_base_;
+  // Nodes indexed by position. Removed nodes leave nullptr holes.
+  std::vector<Node*> order_;
+  int64_t hole_count_ = 0;
+  // Set if an operand edge closed a cycle or required reordering too many
+  // nodes. Cycles may exist transiently during transformations; the order is
+  // recomputed on the next query.
+  bool needs_rebuild_ = false;
+  // Number of nodes visited by repairs since the order was last queried.
+  int64_t visits_since_query_ = 0;
+
+  // Scratch space of OperandAdded, kept to avoid allocating on every repair.
+  std::vector<Node*> forward_;
+  std::vector<Node*> backward_;
+  std::vector<int64_t> positions_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_INCREMENTAL_TOPO_ORDER_H_
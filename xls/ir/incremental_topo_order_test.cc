@@ -0,0 +1,286 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/ir/incremental_topo_order.h"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/benchmark_support.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "xls/ir/source_location.h"
+#include "xls/ir/topo_sort.h"
+
+namespace xls {
+namespace {
+
+using ::testing::UnorderedElementsAreArray;
+
+class IncrementalTopoOrderTest : public IrTestBase {
+ protected:
+  // Checks that the incremental order contains every node exactly once and
+  // places every operand before its users.
+  void ExpectValidOrder(FunctionBase* f) {
+    std::vector<Node*> order = f->IncrementalTopoSort();
+    std::vector<Node*> nodes(f->nodes().begin(), f->nodes().end());
+    EXPECT_THAT(order, UnorderedElementsAreArray(nodes));
+    absl::flat_hash_set<Node*> seen;
+    for (Node* node : order) {
+      for (Node* operand : node->operands()) {
+        EXPECT_TRUE(seen.contains(operand))
+            << operand->GetName() << " is not before " << node->GetName();
+        EXPECT_TRUE(f->IsBeforeInTopoOrder(operand, node));
+        EXPECT_FALSE(f->IsBeforeInTopoOrder(node, operand));
+      }
+      seen.insert(node);
+    }
+  }
+};
+
+TEST_F(IncrementalTopoOrderTest, NewNodesAreAppended) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue add = fb.Add(x, y);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(add));
+  EXPECT_EQ(f->IncrementalTopoSort(), TopoSort(f));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * neg, f->MakeNode<UnOp>(SourceInfo(), add.node(), Op::kNeg));
+  EXPECT_TRUE(f->IsBeforeInTopoOrder(add.node(), neg));
+  ExpectValidOrder(f);
+}
+
+TEST_F(IncrementalTopoOrderTest, ReplaceUsesWithNewerNode) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue add = fb.Add(x, y);
+  BValue neg = fb.Negate(add);
+  BValue inv = fb.Not(neg);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(inv));
+  EXPECT_TRUE(f->IsBeforeInTopoOrder(add.node(), neg.node()));
+
+  // The replacement is appended after the users of `add` so they must move
+  // after it.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * sub,
+      f->MakeNode<BinOp>(SourceInfo(), x.node(), y.node(), Op::kSub));
+  EXPECT_TRUE(f->IsBeforeInTopoOrder(inv.node(), sub));
+  XLS_ASSERT_OK(add.node()->ReplaceUsesWith(sub));
+  EXPECT_TRUE(f->IsBeforeInTopoOrder(sub, neg.node()));
+  EXPECT_TRUE(f->IsBeforeInTopoOrder(sub, inv.node()));
+  XLS_ASSERT_OK(f->RemoveNode(add.node()));
+  ExpectValidOrder(f);
+}
+
+TEST_F(IncrementalTopoOrderTest, TransientCycle) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue a = fb.Not(x);
+  BValue b = fb.Negate(a);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(b));
+  ExpectValidOrder(f);
+
+  // Temporarily make `a` an operand of itself via `b` and then break the
+  // cycle in the other direction.
+  XLS_ASSERT_OK(a.node()->ReplaceOperandNumber(0, b.node()));
+  XLS_ASSERT_OK(b.node()->ReplaceOperandNumber(0, x.node()));
+  ExpectValidOrder(f);
+  EXPECT_TRUE(f->IsBeforeInTopoOrder(b.node(), a.node()));
+}
+
+TEST_F(IncrementalTopoOrderTest, LargeReorderFallsBackToRebuild) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue head = fb.Not(x);
+  BValue v = head;
+  for (int64_t i = 0; i < 5000; ++i) {
+    v = fb.Negate(v);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(v));
+  ExpectValidOrder(f);
+
+  // Every node of the chain must move after the replacement which is more
+  // than is reordered incrementally.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * neg, f->MakeNode<UnOp>(SourceInfo(), x.node(), Op::kNeg));
+  XLS_ASSERT_OK(head.node()->ReplaceOperandNumber(0, neg));
+  EXPECT_TRUE(f->IsBeforeInTopoOrder(neg, head.node()));
+  EXPECT_TRUE(f->IsBeforeInTopoOrder(neg, v.node()));
+  ExpectValidOrder(f);
+}
+
+TEST_F(IncrementalTopoOrderTest, RepairsWithoutQueriesFallBackToRebuild) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  std::vector<BValue> heads;
+  std::vector<BValue> tails;
+  for (int64_t i = 0; i < 100; ++i) {
+    heads.push_back(fb.Not(x));
+    BValue v = heads.back();
+    for (int64_t j = 0; j < 20; ++j) {
+      v = fb.Negate(v);
+    }
+    tails.push_back(v);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f,
+                           fb.BuildWithReturnValue(fb.Concat(tails)));
+  ExpectValidOrder(f);
+
+  // Each replacement reorders a short chain but together they visit more
+  // nodes than are reordered between two queries.
+  std::vector<Node*> negs;
+  for (BValue head : heads) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Node * neg, f->MakeNode<UnOp>(SourceInfo(), x.node(), Op::kNeg));
+    XLS_ASSERT_OK(head.node()->ReplaceOperandNumber(0, neg));
+    negs.push_back(neg);
+  }
+  for (int64_t i = 0; i < heads.size(); ++i) {
+    EXPECT_TRUE(f->IsBeforeInTopoOrder(negs[i], tails[i].node()));
+  }
+  ExpectValidOrder(f);
+}
+
+TEST_F(IncrementalTopoOrderTest, RandomMutations) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  std::vector<BValue> values = {fb.Param("x", p->GetBitsType(8)),
+                                fb.Param("y", p->GetBitsType(8))};
+  std::mt19937_64 bitgen(42);
+  for (int64_t i = 0; i < 200; ++i) {
+    std::uniform_int_distribution<int64_t> pick(0, values.size() - 1);
+    values.push_back(fb.Add(values[pick(bitgen)], values[pick(bitgen)]));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f,
+                           fb.BuildWithReturnValue(values.back()));
+  ExpectValidOrder(f);
+
+  for (int64_t i = 0; i < 500; ++i) {
+    std::vector<Node*> nodes(f->nodes().begin(), f->nodes().end());
+    std::uniform_int_distribution<int64_t> pick(0, nodes.size() - 1);
+    Node* node = nodes[pick(bitgen)];
+    switch (i % 3) {
+      case 0: {
+        // Add a node using two random nodes.
+        XLS_ASSERT_OK(f->MakeNode<BinOp>(SourceInfo(), node,
+                                         nodes[pick(bitgen)], Op::kAdd)
+                          .status());
+        break;
+      }
+      case 1: {
+        // Replace an operand with a node which is not a transitive user.
+        if (node->operand_count() == 0) {
+          break;
+        }
+        Node* replacement = nodes[pick(bitgen)];
+        std::vector<Node*> order = TopoSort(f);
+        if (absl::c_find(order, replacement) >= absl::c_find(order, node)) {
+          // Only pick replacements which come earlier in a fresh topological
+          // sort to avoid creating cycles.
+          break;
+        }
+        XLS_ASSERT_OK(node->ReplaceOperandNumber(0, replacement));
+        break;
+      }
+      case 2: {
+        if (node->IsDead() && node != f->return_value() && !node->Is<Param>()) {
+          XLS_ASSERT_OK(f->RemoveNode(node));
+        }
+        break;
+      }
+    }
+  }
+  ExpectValidOrder(f);
+}
+
+void BM_IncrementalOrderAfterReplacement(benchmark::State& state) {
+  auto p = std::make_unique<Package>("balanced_tree_pkg");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Function * f,
+      benchmark_support::GenerateBalancedTree(
+          p.get(), /*depth=*/state.range(0), /*fan_out=*/2,
+          benchmark_support::strategy::BinaryAdd(),
+          benchmark_support::strategy::DistinctLiteral()));
+  std::vector<Node*> leaves;
+  for (Node* node : f->nodes()) {
+    if (node->Is<Literal>()) {
+      leaves.push_back(node);
+    }
+  }
+  int64_t i = 0;
+  for (auto _ : state) {
+    // Replace a leaf with a freshly added node and query the order.
+    Node* leaf = leaves[i++ % leaves.size()];
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Node * neg, f->MakeNode<UnOp>(SourceInfo(), leaf, Op::kNeg));
+    XLS_ASSERT_OK(leaf->ReplaceUsesWith(
+        neg, [&](Node* user) { return user != neg; }));
+    benchmark::DoNotOptimize(f->IsBeforeInTopoOrder(neg, f->return_value()));
+  }
+}
+
+void BM_FullTopoSortAfterReplacement(benchmark::State& state) {
+  auto p = std::make_unique<Package>("balanced_tree_pkg");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Function * f,
+      benchmark_support::GenerateBalancedTree(
+          p.get(), /*depth=*/state.range(0), /*fan_out=*/2,
+          benchmark_support::strategy::BinaryAdd(),
+          benchmark_support::strategy::DistinctLiteral()));
+  std::vector<Node*> leaves;
+  for (Node* node : f->nodes()) {
+    if (node->Is<Literal>()) {
+      leaves.push_back(node);
+    }
+  }
+  int64_t i = 0;
+  for (auto _ : state) {
+    Node* leaf = leaves[i++ % leaves.size()];
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Node * neg, f->MakeNode<UnOp>(SourceInfo(), leaf, Op::kNeg));
+    XLS_ASSERT_OK(leaf->ReplaceUsesWith(
+        neg, [&](Node* user) { return user != neg; }));
+    benchmark::DoNotOptimize(TopoSort(f));
+  }
+}
+
+BENCHMARK(BM_IncrementalOrderAfterReplacement)->DenseRange(4, 16, 4);
+BENCHMARK(BM_FullTopoSortAfterReplacement)->DenseRange(4, 16, 4);
+
+}  // namespace
+}  // namespace xls
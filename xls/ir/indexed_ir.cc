@@ -0,0 +1,464 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/ir/indexed_ir.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "xls/common/file/file_descriptor.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/call_graph.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/fileno.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/ir/verifier.h"
+
+namespace xls {
+namespace {
+
+constexpr std::string_view kMagic("XLSIDXIR", 8);
+constexpr uint32_t kVersion = 1;
+
+void AppendInt(std::string* out, uint64_t value, int64_t bytes) {
+  for (int64_t i = 0; i < bytes; ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+void AppendString(std::string* out, std::string_view s) {
+  AppendInt(out, s.size(), 4);
+  out->append(s);
+}
+
+// Bounds-checked cursor over the bytes of a indexed IR file.
+class ByteReader {
+ public:
+  explicit ByteReader(std::string_view data) : data_(data) {}
+
+  absl::StatusOr<std::string_view> ReadBytes(uint64_t count) {
+    if (count > data_.size() - position_) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Indexed IR is truncated: expected %d bytes at offset %d", count,
+          position_));
+    }
+    std::string_view bytes = data_.substr(position_, count);
+    position_ += count;
+    return bytes;
+  }
+
+  absl::StatusOr<uint64_t> ReadInt(int64_t bytes) {
+    XLS_ASSIGN_OR_RETURN(std::string_view raw, ReadBytes(bytes));
+    uint64_t value = 0;
+    for (int64_t i = 0; i < bytes; ++i) {
+      value |= uint64_t{static_cast<uint8_t>(raw[i])} << (8 * i);
+    }
+    return value;
+  }
+
+  absl::StatusOr<std::string_view> ReadString() {
+    XLS_ASSIGN_OR_RETURN(uint64_t size, ReadInt(4));
+    return ReadBytes(size);
+  }
+
+  std::string_view remaining() const { return data_.substr(position_); }
+
+ private:
+  std::string_view data_;
+  uint64_t position_ = 0;
+};
+
+// Returns the package-scoped declarations of the package as IR text.
+std::string DeclarationsIr(Package* package) {
+  std::string out;
+  std::vector<Fileno> filenos;
+  for (const auto& [fileno, filename] : package->fileno_to_name()) {
+    filenos.push_back(fileno);
+  }
+  std::sort(filenos.begin(), filenos.end());
+  for (Fileno fileno : filenos) {
+    absl::StrAppend(&out, "file_number ", static_cast<int32_t>(fileno), " \"",
+                    package->fileno_to_name().at(fileno), "\"\n");
+  }
+  for (Channel* channel : package->channels()) {
+    absl::StrAppend(&out, channel->ToString(), "\n");
+  }
+  return out;
+}
+
+// Returns the kind of the function base as encoded in the index. Must match
+// IndexedIrReader::Entry::Kind.
+uint64_t EncodeKind(FunctionBase* function_base) {
+  if (function_base->IsFunction()) {
+    return 0;
+  }
+  return function_base->IsProc() ? 1 : 2;
+}
+
+absl::Status VerifyFunctionBase(FunctionBase* function_base) {
+  if (function_base->IsFunction()) {
+    return VerifyFunction(function_base->AsFunctionOrDie());
+  }
+  if (function_base->IsProc()) {
+    return VerifyProc(function_base->AsProcOrDie());
+  }
+  return VerifyBlock(function_base->AsBlockOrDie());
+}
+
+}  // namespace
+
+bool IsIndexedIr(std::string_view contents) {
+  return contents.substr(0, kMagic.size()) == kMagic;
+}
+
+std::string SerializePackageToIndexedIr(Package* package) {
+  std::vector<FunctionBase*> order = FunctionsInPostOrder(package);
+  absl::flat_hash_map<FunctionBase*, int64_t> indices;
+  for (int64_t i = 0; i < order.size(); ++i) {
+    indices[order[i]] = i;
+  }
+
+  std::string out(kMagic);
+  AppendInt(&out, kVersion, 4);
+  AppendString(&out, package->name());
+  std::optional<FunctionBase*> top = package->GetTop();
+  AppendString(&out, top.has_value() ? (*top)->name() : "");
+  AppendString(&out, DeclarationsIr(package));
+
+  std::string sections;
+  AppendInt(&out, order.size(), 4);
+  for (FunctionBase* fb : order) {
+    // The top marker is not included in the section; the reader sets the top
+    // from the header.
+    std::string text;
+    std::vector<std::string> attributes = fb->AttributeIrStrings();
+    if (!attributes.empty()) {
+      absl::StrAppend(&text, "#[", absl::StrJoin(attributes, ", "), "]\n");
+    }
+    absl::StrAppend(&text, fb->DumpIr());
+
+    AppendInt(&out, EncodeKind(fb), 1);
+    AppendString(&out, fb->name());
+    AppendInt(&out, sections.size(), 8);
+    AppendInt(&out, text.size(), 8);
+    std::vector<FunctionBase*> callees = CalledFunctions(fb);
+    AppendInt(&out, callees.size(), 4);
+    for (FunctionBase* callee : callees) {
+      AppendInt(&out, indices.at(callee), 4);
+    }
+    sections.append(text);
+  }
+  out.append(sections);
+  return out;
+}
+
+/* static */ absl::StatusOr<std::unique_ptr<IndexedIrReader>>
+IndexedIrReader::Open(const std::filesystem::path& path) {
+  FileDescriptor fd(open(path.c_str(), O_RDONLY));
+  if (fd.get() == -1) {
+    return absl::ErrnoToStatus(errno,
+                               absl::StrCat("Failed to open ", path.string()));
+  }
+  struct stat file_stat;
+  if (fstat(fd.get(), &file_stat) != 0) {
+    return absl::ErrnoToStatus(errno,
+                               absl::StrCat("Failed to stat ", path.string()));
+  }
+  if (file_stat.st_size == 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Indexed IR file is empty: ", path.string()));
+  }
+  void* mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                       fd.get(), /*offset=*/0);
+  if (mapping == MAP_FAILED) {
+    return absl::ErrnoToStatus(errno,
+                               absl::StrCat("Failed to map ", path.string()));
+  }
+  auto reader = absl::WrapUnique(new IndexedIrReader());
+  reader->mapping_ = mapping;
+  reader->mapping_size_ = file_stat.st_size;
+  reader->data_ =
+      std::string_view(static_cast<const char*>(mapping), file_stat.st_size);
+  XLS_RETURN_IF_ERROR(reader->Initialize()) << "in " << path.string();
+  return reader;
+}
+
+/* static */ absl::StatusOr<std::unique_ptr<IndexedIrReader>>
+IndexedIrReader::FromBuffer(std::string buffer) {
+  auto reader = absl::WrapUnique(new IndexedIrReader());
+  reader->owned_buffer_ = std::move(buffer);
+  reader->data_ = reader->owned_buffer_;
+  XLS_RETURN_IF_ERROR(reader->Initialize());
+  return reader;
+}
+
+IndexedIrReader::~IndexedIrReader() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+absl::Status IndexedIrReader::Initialize() {
+  ByteReader reader(data_);
+  if (!IsIndexedIr(data_)) {
+    return absl::InvalidArgumentError("Input is not indexed IR");
+  }
+  XLS_RETURN_IF_ERROR(reader.ReadBytes(kMagic.size()).status());
+  XLS_ASSIGN_OR_RETURN(uint64_t version, reader.ReadInt(4));
+  if (version != kVersion) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Unsupported indexed IR version %d, expected %d", version, kVersion));
+  }
+  XLS_ASSIGN_OR_RETURN(std::string_view package_name, reader.ReadString());
+  XLS_ASSIGN_OR_RETURN(std::string_view top_name, reader.ReadString());
+  XLS_ASSIGN_OR_RETURN(std::string_view declarations, reader.ReadString());
+
+  package_ = std::make_unique<Package>(package_name);
+  XLS_RETURN_IF_ERROR(
+      Parser::ParseDeclarationsNoVerify(declarations, package_.get()).status());
+
+  XLS_ASSIGN_OR_RETURN(uint64_t entry_count, reader.ReadInt(4));
+  std::vector<std::pair<uint64_t, uint64_t>> section_ranges;
+  entries_.resize(entry_count);
+  section_ranges.reserve(entry_count);
+  for (int64_t i = 0; i < entry_count; ++i) {
+    Entry& entry = entries_[i];
+    XLS_ASSIGN_OR_RETURN(uint64_t kind, reader.ReadInt(1));
+    if (kind > static_cast<uint64_t>(Entry::Kind::kBlock)) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid function base kind %d in indexed IR", kind));
+    }
+    entry.kind = static_cast<Entry::Kind>(kind);
+    XLS_ASSIGN_OR_RETURN(entry.name, reader.ReadString());
+    XLS_ASSIGN_OR_RETURN(uint64_t offset, reader.ReadInt(8));
+    XLS_ASSIGN_OR_RETURN(uint64_t size, reader.ReadInt(8));
+    section_ranges.push_back({offset, size});
+    XLS_ASSIGN_OR_RETURN(uint64_t dependency_count, reader.ReadInt(4));
+    entry.dependencies.reserve(dependency_count);
+    for (int64_t j = 0; j < dependency_count; ++j) {
+      XLS_ASSIGN_OR_RETURN(uint64_t dependency, reader.ReadInt(4));
+      if (dependency >= i) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Function base `%s` has invalid dependency index %d", entry.name,
+            dependency));
+      }
+      entry.dependencies.push_back(dependency);
+    }
+    auto [_, inserted] = name_to_index_.insert({entry.name, i});
+    if (!inserted) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Function base `%s` is defined more than once", entry.name));
+    }
+  }
+
+  std::string_view sections = reader.remaining();
+  for (int64_t i = 0; i < entry_count; ++i) {
+    auto [offset, size] = section_ranges[i];
+    if (offset > sections.size() || size > sections.size() - offset) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Section of function base `%s` is out of bounds", entries_[i].name));
+    }
+    entries_[i].text = sections.substr(offset, size);
+  }
+
+  if (!top_name.empty()) {
+    if (!name_to_index_.contains(top_name)) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Top `%s` is not defined in indexed IR", top_name));
+    }
+    top_name_ = top_name;
+  }
+  return absl::OkStatus();
+}
+
+std::vector<std::string_view> IndexedIrReader::GetFunctionBaseNames() const {
+  std::vector<std::string_view> names;
+  names.reserve(entries_.size());
+  for (const Entry& entry : entries_) {
+    names.push_back(entry.name);
+  }
+  return names;
+}
+
+bool IndexedIrReader::IsMaterialized(std::string_view name) const {
+  auto it = name_to_index_.find(name);
+  return it != name_to_index_.end() &&
+         entries_[it->second].function_base != nullptr;
+}
+
+absl::StatusOr<FunctionBase*> IndexedIrReader::Materialize(
+    std::string_view name) {
+  auto it = name_to_index_.find(name);
+  if (it == name_to_index_.end()) {
+    return absl::NotFoundError(absl::StrFormat(
+        "No function base named `%s` in indexed IR package", name));
+  }
+  int64_t index = it->second;
+  if (entries_[index].function_base != nullptr) {
+    return entries_[index].function_base;
+  }
+
+  // Gather the unmaterialized transitive dependencies.
+  std::vector<bool> visited(entries_.size(), false);
+  std::vector<int64_t> worklist = {index};
+  std::vector<int64_t> pending;
+  bool procs_added = false;
+  visited[index] = true;
+  while (!worklist.empty()) {
+    int64_t i = worklist.back();
+    worklist.pop_back();
+    const Entry& entry = entries_[i];
+    if (entry.function_base != nullptr) {
+      continue;
+    }
+    pending.push_back(i);
+    std::vector<int64_t> successors = entry.dependencies;
+    if (entry.kind == Entry::Kind::kProc && !procs_added) {
+      procs_added = true;
+      for (int64_t j = 0; j < entries_.size(); ++j) {
+        if (entries_[j].kind == Entry::Kind::kProc) {
+          successors.push_back(j);
+        }
+      }
+    }
+    for (int64_t successor : successors) {
+      if (!visited[successor]) {
+        visited[successor] = true;
+        worklist.push_back(successor);
+      }
+    }
+  }
+  XLS_RETURN_IF_ERROR(MaterializeEntries(std::move(pending)));
+  return entries_[index].function_base;
+}
+
+absl::Status IndexedIrReader::MaterializeAll() {
+  std::vector<int64_t> pending;
+  for (int64_t i = 0; i < entries_.size(); ++i) {
+    if (entries_[i].function_base == nullptr) {
+      pending.push_back(i);
+    }
+  }
+  return MaterializeEntries(std::move(pending));
+}
+
+absl::Status IndexedIrReader::MaterializeProcs() {
+  // Materializing any proc materializes all of them.
+  for (const Entry& entry : entries_) {
+    if (entry.kind == Entry::Kind::kProc && entry.function_base == nullptr) {
+      return Materialize(entry.name).status();
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status IndexedIrReader::MaterializeEntries(std::vector<int64_t> indices) {
+  if (package_ == nullptr) {
+    return absl::FailedPreconditionError(
+        "Package has already been taken from the indexed IR reader");
+  }
+  std::sort(indices.begin(), indices.end());
+  for (int64_t i : indices) {
+    Entry& entry = entries_[i];
+    XLS_ASSIGN_OR_RETURN(
+        std::vector<FunctionBase*> parsed,
+        Parser::ParseDeclarationsNoVerify(entry.text, package_.get()));
+    XLS_RET_CHECK_EQ(parsed.size(), 1);
+    XLS_RET_CHECK_EQ(parsed.front()->name(), entry.name);
+    entry.function_base = parsed.front();
+    if (top_name_ == entry.name) {
+      XLS_RETURN_IF_ERROR(package_->SetTop(entry.function_base));
+    }
+  }
+  // Verify after parsing all of the entries as procs may refer to procs which
+  // appear later in the index.
+  for (int64_t i : indices) {
+    XLS_RETURN_IF_ERROR(VerifyFunctionBase(entries_[i].function_base));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::unique_ptr<Package>> LoadIndexedIrPackage(
+    std::unique_ptr<IndexedIrReader> reader,
+    std::optional<std::string_view> top) {
+  if (!top.has_value()) {
+    top = reader->top_name();
+  }
+  if (top.has_value()) {
+    XLS_RETURN_IF_ERROR(reader->Materialize(*top).status());
+    XLS_RETURN_IF_ERROR(reader->package()->SetTopByName(*top));
+  } else {
+    XLS_RETURN_IF_ERROR(reader->MaterializeAll());
+  }
+  if (!reader->package()->channels().empty()) {
+    XLS_RETURN_IF_ERROR(reader->MaterializeProcs());
+  }
+  XLS_RETURN_IF_ERROR(VerifyPackage(reader->package()));
+  return reader->TakePackage();
+}
+
+absl::StatusOr<std::unique_ptr<Package>> LoadPackageFromFile(
+    const std::filesystem::path& path, std::optional<std::string_view> top) {
+  // Only regular files can be mapped; other files (e.g., stdin) are read in
+  // full.
+  if (std::filesystem::is_regular_file(path)) {
+    std::ifstream stream(path, std::ios::binary);
+    std::string magic(kMagic.size(), '\0');
+    if (stream.read(magic.data(), magic.size()) && IsIndexedIr(magic)) {
+      XLS_ASSIGN_OR_RETURN(std::unique_ptr<IndexedIrReader> reader,
+                           IndexedIrReader::Open(path));
+      return LoadIndexedIrPackage(std::move(reader), top);
+    }
+  }
+  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(path));
+  if (IsIndexedIr(contents)) {
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<IndexedIrReader> reader,
+                         IndexedIrReader::FromBuffer(std::move(contents)));
+    return LoadIndexedIrPackage(std::move(reader), top);
+  }
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       Parser::ParsePackageInParallel(contents, path.string()));
+  if (top.has_value()) {
+    XLS_RETURN_IF_ERROR(package->SetTopByName(*top));
+  }
+  return package;
+}
+
+}  // namespace xls
@@ -0,0 +1,167 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_IR_INDEXED_IR_H_
+#define XLS_IR_INDEXED_IR_H_
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+
+// Container format for IR packages which supports loading individual function
+// bases on demand. This is not a binary encoding of the IR: each function base
+// is stored as IR text and is parsed by the IR parser when it is loaded. What
+// the container adds is an index, so a tool which only needs the top and its
+// callees parses only those instead of the whole package. The file consists
+// of a header and an index followed by one section per function base:
+//
+//   magic (8 bytes), format version (u32)
+//   package name, top name (empty if none)
+//   package-scoped declarations (file numbers and global channels) as IR text
+//   index: for each function base in post order
+//     kind (u8), name, section offset (u64), section size (u64),
+//     indices of the function bases it depends on
+//   sections, each holding the IR text of one function base including its
+//     attributes
+//
+// Strings are encoded as a u32 length followed by the bytes. Integers are
+// little-endian. The index is read in place so opening a memory-mapped file
+// costs time proportional to the number of function bases, not the size of
+// the IR. Loading every function base costs about as much as parsing the
+// equivalent IR text.
+
+// Returns true if `contents` starts with the indexed IR magic number.
+bool IsIndexedIr(std::string_view contents);
+
+// Serializes the given package into the indexed IR format.
+std::string SerializePackageToIndexedIr(Package* package);
+
+// Reads indexed IR and materializes the function bases of the package lazily.
+// Materializing a function base first materializes everything it depends on:
+// the functions it calls, the blocks it instantiates and, for procs, all
+// other procs of the package since procs reference each other through
+// channels and proc instantiations. Each materialized function base is
+// verified on its own (VerifyFunction, VerifyProc or VerifyBlock). Invariants
+// of the package as a whole, such as unique node ids and the send and receive
+// nodes of each channel, are only checked by LoadIndexedIrPackage.
+class IndexedIrReader {
+ public:
+  // Memory-maps the file at `path`.
+  static absl::StatusOr<std::unique_ptr<IndexedIrReader>> Open(
+      const std::filesystem::path& path);
+
+  // Reads indexed IR from an in-memory buffer.
+  static absl::StatusOr<std::unique_ptr<IndexedIrReader>> FromBuffer(
+      std::string buffer);
+
+  ~IndexedIrReader();
+
+  IndexedIrReader(const IndexedIrReader&) = delete;
+  IndexedIrReader& operator=(const IndexedIrReader&) = delete;
+
+  // The package being materialized. Initially it contains only the
+  // package-scoped declarations.
+  Package* package() const { return package_.get(); }
+
+  // Transfers ownership of the package to the caller. No further function
+  // bases can be materialized afterwards.
+  std::unique_ptr<Package> TakePackage() { return std::move(package_); }
+
+  // Names of all function bases in the file in post order.
+  std::vector<std::string_view> GetFunctionBaseNames() const;
+
+  // Name of the top function base recorded in the file, if any.
+  std::optional<std::string_view> top_name() const { return top_name_; }
+
+  bool IsMaterialized(std::string_view name) const;
+
+  // Materializes the function base with the given name along with its
+  // dependencies. If it is the top of the package recorded in the file it is
+  // also set as the top of the package.
+  absl::StatusOr<FunctionBase*> Materialize(std::string_view name);
+
+  // Materializes every function base in the file.
+  absl::Status MaterializeAll();
+
+  // Materializes every proc in the file along with its dependencies.
+  absl::Status MaterializeProcs();
+
+ private:
+  struct Entry {
+    enum class Kind : uint8_t { kFunction, kProc, kBlock };
+    Kind kind;
+    std::string_view name;
+    std::string_view text;
+    std::vector<int64_t> dependencies;
+    FunctionBase* function_base = nullptr;
+  };
+
+  IndexedIrReader() = default;
+
+  // Parses the header and index of `data_` and creates the package.
+  absl::Status Initialize();
+
+  // Materializes the entries with the given indices in index order, which is
+  // a valid post order of the call graph.
+  absl::Status MaterializeEntries(std::vector<int64_t> indices);
+
+  // Either `owned_buffer_` or the memory mapping holds the bytes of `data_`.
+  std::string owned_buffer_;
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  std::string_view data_;
+
+  std::unique_ptr<Package> package_;
+  std::optional<std::string_view> top_name_;
+  std::vector<Entry> entries_;
+  absl::flat_hash_map<std::string_view, int64_t> name_to_index_;
+};
+
+// Loads a package from indexed IR. If `top` is given it and its dependencies
+// are materialized and it is set as the top of the package. Otherwise, if the
+// file records a top, that top and its dependencies are materialized. If
+// there is neither the entire package is materialized. If the package
+// declares channels all procs are materialized too, since a channel is only
+// valid along with its send and receive nodes. The package is verified with
+// VerifyPackage before it is returned.
+absl::StatusOr<std::unique_ptr<Package>> LoadIndexedIrPackage(
+    std::unique_ptr<IndexedIrReader> reader,
+    std::optional<std::string_view> top = std::nullopt);
+
+// Loads the package in the file at `path` which may hold either IR text or
+// indexed IR. Indexed IR in a regular file is memory-mapped and loaded as by
+// LoadIndexedIrPackage. IR text is parsed in full with
+// Parser::ParsePackageInParallel. If `top` is given it is set as the top of
+// the returned package.
+absl::StatusOr<std::unique_ptr<Package>> LoadPackageFromFile(
+    const std::filesystem::path& path,
+    std::optional<std::string_view> top = std::nullopt);
+
+}  // namespace xls
+
+#endif  // XLS_IR_INDEXED_IR_H_
@@ -0,0 +1,322 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/ir/indexed_ir.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/channel_ops.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/ir_scanner.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+class IndexedIrTest : public IrTestBase {};
+
+// Builds a package with functions `leaf`, `mid` (calls `leaf`), `main`
+// (calls `mid`, top) and `unused`.
+std::unique_ptr<Package> MakeCallChainPackage(std::string_view name) {
+  auto p = std::make_unique<Package>(name);
+  FunctionBuilder leaf_builder("leaf", p.get());
+  BValue x = leaf_builder.Param("x", p->GetBitsType(32));
+  leaf_builder.Add(x, leaf_builder.Literal(UBits(1, 32)));
+  Function* leaf = leaf_builder.Build().value();
+
+  FunctionBuilder mid_builder("mid", p.get());
+  BValue y = mid_builder.Param("y", p->GetBitsType(32));
+  mid_builder.Invoke({mid_builder.Invoke({y}, leaf)}, leaf);
+  Function* mid = mid_builder.Build().value();
+
+  FunctionBuilder main_builder("main", p.get());
+  BValue z = main_builder.Param("z", p->GetBitsType(32));
+  main_builder.Invoke({z}, mid);
+  CHECK_OK(p->SetTop(main_builder.Build().value()));
+
+  FunctionBuilder unused_builder("unused", p.get());
+  unused_builder.Param("w", p->GetBitsType(8));
+  CHECK_OK(unused_builder.Build().status());
+  return p;
+}
+
+TEST_F(IndexedIrTest, RoundTrip) {
+  std::unique_ptr<Package> p = MakeCallChainPackage(TestName());
+  std::string indexed = SerializePackageToIndexedIr(p.get());
+  EXPECT_TRUE(IsIndexedIr(indexed));
+  EXPECT_FALSE(IsIndexedIr(p->DumpIr()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<IndexedIrReader> reader,
+                           IndexedIrReader::FromBuffer(indexed));
+  EXPECT_EQ(reader->top_name(), "main");
+  EXPECT_THAT(reader->GetFunctionBaseNames(),
+              ElementsAre("leaf", "mid", "main", "unused"));
+  XLS_ASSERT_OK(reader->MaterializeAll());
+  std::unique_ptr<Package> loaded = reader->TakePackage();
+  EXPECT_EQ(loaded->DumpIr(), p->DumpIr());
+  EXPECT_THAT(reader->Materialize("main"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST_F(IndexedIrTest, MaterializesDependenciesOnly) {
+  std::unique_ptr<Package> p = MakeCallChainPackage(TestName());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<IndexedIrReader> reader,
+      IndexedIrReader::FromBuffer(SerializePackageToIndexedIr(p.get())));
+  EXPECT_TRUE(reader->package()->functions().empty());
+
+  XLS_ASSERT_OK_AND_ASSIGN(FunctionBase * mid, reader->Materialize("mid"));
+  EXPECT_EQ(mid->name(), "mid");
+  EXPECT_TRUE(reader->IsMaterialized("leaf"));
+  EXPECT_FALSE(reader->IsMaterialized("main"));
+  EXPECT_FALSE(reader->IsMaterialized("unused"));
+  EXPECT_EQ(reader->package()->functions().size(), 2);
+  EXPECT_FALSE(reader->package()->HasTop());
+
+  XLS_ASSERT_OK_AND_ASSIGN(FunctionBase * main, reader->Materialize("main"));
+  EXPECT_EQ(reader->package()->GetTop(), main);
+  EXPECT_EQ(reader->package()->functions().size(), 3);
+  EXPECT_THAT(reader->Materialize("mid"), IsOkAndHolds(mid));
+  EXPECT_THAT(reader->Materialize("nonexistent"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST_F(IndexedIrTest, LoadPackageWithTopOverride) {
+  std::unique_ptr<Package> p = MakeCallChainPackage(TestName());
+  std::string indexed = SerializePackageToIndexedIr(p.get());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<IndexedIrReader> reader,
+                           IndexedIrReader::FromBuffer(indexed));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> loaded,
+                           LoadIndexedIrPackage(std::move(reader)));
+  EXPECT_EQ(loaded->functions().size(), 3);
+  EXPECT_EQ(loaded->GetTop().value()->name(), "main");
+
+  XLS_ASSERT_OK_AND_ASSIGN(reader, IndexedIrReader::FromBuffer(indexed));
+  XLS_ASSERT_OK_AND_ASSIGN(loaded,
+                           LoadIndexedIrPackage(std::move(reader), "unused"));
+  EXPECT_EQ(loaded->functions().size(), 1);
+  EXPECT_EQ(loaded->GetTop().value()->name(), "unused");
+}
+
+TEST_F(IndexedIrTest, ProcsAreMaterializedTogether) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * ch, p->CreateStreamingChannel("ch", ChannelOps::kSendReceive,
+                                              p->GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out, p->CreateStreamingChannel("out", ChannelOps::kSendOnly,
+                                               p->GetBitsType(32)));
+  TokenlessProcBuilder producer("producer", "tkn", p.get());
+  BValue count = producer.StateElement("count", Value(UBits(0, 32)));
+  producer.Send(ch, count);
+  XLS_ASSERT_OK(
+      producer.Build({producer.Add(count, producer.Literal(UBits(1, 32)))})
+          .status());
+  TokenlessProcBuilder consumer("consumer", "tkn", p.get());
+  consumer.Send(out, consumer.Receive(ch));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * top, consumer.Build());
+  XLS_ASSERT_OK(p->SetTop(top));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<IndexedIrReader> reader,
+      IndexedIrReader::FromBuffer(SerializePackageToIndexedIr(p.get())));
+  EXPECT_EQ(reader->package()->channels().size(), 2);
+  XLS_ASSERT_OK(reader->Materialize("consumer").status());
+  EXPECT_TRUE(reader->IsMaterialized("producer"));
+  EXPECT_EQ(reader->package()->DumpIr(), p->DumpIr());
+}
+
+TEST_F(IndexedIrTest, LoadFunctionTopWithChannels) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out, p->CreateStreamingChannel("out", ChannelOps::kSendOnly,
+                                               p->GetBitsType(32)));
+  TokenlessProcBuilder pb("producer", "tkn", p.get());
+  pb.Send(out, pb.Literal(UBits(42, 32)));
+  XLS_ASSERT_OK(pb.Build({}).status());
+  FunctionBuilder fb("f", p.get());
+  fb.Param("x", p->GetBitsType(32));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK(p->SetTop(f));
+
+  // The channel has no send node unless the proc is loaded as well, which
+  // VerifyPackage rejects.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<IndexedIrReader> reader,
+      IndexedIrReader::FromBuffer(SerializePackageToIndexedIr(p.get())));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> loaded,
+                           LoadIndexedIrPackage(std::move(reader)));
+  EXPECT_EQ(loaded->GetTop().value()->name(), "f");
+  EXPECT_EQ(loaded->procs().size(), 1);
+}
+
+TEST_F(IndexedIrTest, OpenMappedFile) {
+  std::unique_ptr<Package> p = MakeCallChainPackage(TestName());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TempFile file,
+      TempFile::CreateWithContent(SerializePackageToIndexedIr(p.get())));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<IndexedIrReader> reader,
+                           IndexedIrReader::Open(file.path()));
+  XLS_ASSERT_OK(reader->MaterializeAll());
+  EXPECT_EQ(reader->package()->DumpIr(), p->DumpIr());
+}
+
+TEST_F(IndexedIrTest, LoadPackageFromFile) {
+  std::unique_ptr<Package> p = MakeCallChainPackage(TestName());
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile text_file,
+                           TempFile::CreateWithContent(p->DumpIr()));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TempFile indexed_file,
+      TempFile::CreateWithContent(SerializePackageToIndexedIr(p.get())));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> from_text,
+                           LoadPackageFromFile(text_file.path(), "mid"));
+  EXPECT_EQ(from_text->functions().size(), 4);
+  EXPECT_EQ(from_text->GetTop().value()->name(), "mid");
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> from_indexed,
+                           LoadPackageFromFile(indexed_file.path(), "mid"));
+  EXPECT_EQ(from_indexed->functions().size(), 2);
+  EXPECT_EQ(from_indexed->GetTop().value()->name(), "mid");
+}
+
+TEST_F(IndexedIrTest, MalformedInput) {
+  EXPECT_THAT(IndexedIrReader::FromBuffer("package foo"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("not indexed IR")));
+
+  std::unique_ptr<Package> p = MakeCallChainPackage(TestName());
+  std::string indexed = SerializePackageToIndexedIr(p.get());
+  EXPECT_THAT(IndexedIrReader::FromBuffer(indexed.substr(0, 40)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("truncated")));
+  EXPECT_THAT(
+      IndexedIrReader::FromBuffer(indexed.substr(0, indexed.size() - 1)),
+      StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("out of bounds")));
+}
+
+// Builds a package of `function_count` independent functions of
+// `nodes_per_function` nodes each along with a top function which calls the
+// first of them.
+std::unique_ptr<Package> MakeLargePackage(int64_t function_count,
+                                          int64_t nodes_per_function) {
+  auto p = std::make_unique<Package>("large");
+  Function* first = nullptr;
+  for (int64_t i = 0; i < function_count; ++i) {
+    FunctionBuilder fb(absl::StrCat("f", i), p.get());
+    BValue x = fb.Param("x", p->GetBitsType(64));
+    for (int64_t j = 0; j < nodes_per_function; ++j) {
+      x = fb.Add(x, fb.Literal(UBits(j * 0x9e3779b97f4a7c15ULL, 64)));
+    }
+    Function* f = fb.Build().value();
+    if (first == nullptr) {
+      first = f;
+    }
+  }
+  FunctionBuilder fb("top", p.get());
+  fb.Invoke({fb.Param("x", p->GetBitsType(64))}, first);
+  CHECK_OK(p->SetTop(fb.Build().value()));
+  return p;
+}
+
+void BM_ParseText(benchmark::State& state) {
+  std::string text = MakeLargePackage(state.range(0), 100)->DumpIr();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Parser::ParsePackage(text).value());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+void BM_ParseTextInParallel(benchmark::State& state) {
+  std::string text = MakeLargePackage(state.range(0), 100)->DumpIr();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Parser::ParsePackageInParallel(text).value());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+// Tokenization alone, which ParsePackageInParallel splits across threads
+// before parsing function bodies concurrently.
+void BM_TokenizeText(benchmark::State& state) {
+  std::string text = MakeLargePackage(state.range(0), 100)->DumpIr();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(TokenizeString(text).value());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+void BM_TokenizeTextInParallel(benchmark::State& state) {
+  std::string text = MakeLargePackage(state.range(0), 100)->DumpIr();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(TokenizeStringInParallel(text).value());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+void BM_LoadIndexedAll(benchmark::State& state) {
+  std::string indexed =
+      SerializePackageToIndexedIr(MakeLargePackage(state.range(0), 100).get());
+  for (auto _ : state) {
+    std::unique_ptr<IndexedIrReader> reader =
+        IndexedIrReader::FromBuffer(indexed).value();
+    CHECK_OK(reader->MaterializeAll());
+    benchmark::DoNotOptimize(reader->TakePackage());
+  }
+  state.SetBytesProcessed(state.iterations() * indexed.size());
+}
+
+void BM_LoadIndexedTop(benchmark::State& state) {
+  std::string indexed =
+      SerializePackageToIndexedIr(MakeLargePackage(state.range(0), 100).get());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        LoadIndexedIrPackage(IndexedIrReader::FromBuffer(indexed).value())
+            .value());
+  }
+  state.SetBytesProcessed(state.iterations() * indexed.size());
+}
+
+BENCHMARK(BM_ParseText)->Range(1, 1024);
+BENCHMARK(BM_ParseTextInParallel)->Range(1, 1024);
+BENCHMARK(BM_TokenizeText)->Range(1, 1024);
+BENCHMARK(BM_TokenizeTextInParallel)->Range(1, 1024);
+BENCHMARK(BM_LoadIndexedAll)->Range(1, 1024);
+BENCHMARK(BM_LoadIndexedTop)->Range(1, 1024);
+
+}  // namespace
+}  // namespace xls
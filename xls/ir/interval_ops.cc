@@ -801,7 +801,7 @@ IntervalSet Concat(absl::Span<IntervalSet const> sets) {
 
 // Bit ops.
 IntervalSet Not(const IntervalSet& a) {
-  TernaryEvaluator eval;
+  BitSerialTernaryEvaluator eval;
   // Special case 1-bit version to avoid allocations.
   if (a.BitCount() == 1) {
     return TernaryToOneBitRange(eval.Not(OneBitRangeToTernary(a)));
@@ -813,7 +813,7 @@ IntervalSet Not(const IntervalSet& a) {
 IntervalSet And(const IntervalSet& a, const IntervalSet& b) {
   CHECK_EQ(a.BitCount(), b.BitCount());
   // Special case 1-bit version to avoid allocations.
-  TernaryEvaluator eval;
+  BitSerialTernaryEvaluator eval;
   if (a.BitCount() == 1) {
     return TernaryToOneBitRange(
         eval.And(OneBitRangeToTernary(a), OneBitRangeToTernary(b)));
@@ -824,7 +824,7 @@ IntervalSet And(const IntervalSet& a, const IntervalSet& b) {
 }
 IntervalSet Or(const IntervalSet& a, const IntervalSet& b) {
   CHECK_EQ(a.BitCount(), b.BitCount());
-  TernaryEvaluator eval;
+  BitSerialTernaryEvaluator eval;
   if (a.BitCount() == 1) {
     return TernaryToOneBitRange(
         eval.Or(OneBitRangeToTernary(a), OneBitRangeToTernary(b)));
@@ -836,7 +836,7 @@ IntervalSet Or(const IntervalSet& a, const IntervalSet& b) {
 
 IntervalSet Xor(const IntervalSet& a, const IntervalSet& b) {
   CHECK_EQ(a.BitCount(), b.BitCount());
-  TernaryEvaluator eval;
+  BitSerialTernaryEvaluator eval;
   if (a.BitCount() == 1) {
     return TernaryToOneBitRange(
         eval.Xor(OneBitRangeToTernary(a), OneBitRangeToTernary(b)));
@@ -992,7 +992,7 @@ IntervalSet Gate(const IntervalSet& cond, const IntervalSet& val) {
 }
 IntervalSet OneHot(const IntervalSet& val, LsbOrMsb lsb_or_msb,
                    int64_t max_interval_bits) {
-  TernaryEvaluator tern;
+  BitSerialTernaryEvaluator tern;
   TernaryVector src = ExtractTernaryVector(val);
   TernaryVector res;
   switch (lsb_or_msb) {
@@ -14,6 +14,7 @@
 
 #include "xls/ir/ir_parser.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <initializer_list>
@@ -27,6 +28,7 @@
 #include <variant>
 #include <vector>
 
+#include "absl/cleanup/cleanup.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
@@ -43,6 +45,7 @@
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/visitor.h"
+#include "xls/common/work_stealing_thread_pool.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/channel.h"
@@ -59,6 +62,7 @@
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/op.h"
+#include "xls/ir/package.h"
 #include "xls/ir/proc_instantiation.h"
 #include "xls/ir/register.h"
 #include "xls/ir/source_location.h"
@@ -706,6 +710,199 @@ absl::StatusOr<ProcBuilder*> CastToProcBuilderOrError(
   }
 }
 
+absl::StatusOr<bool> Parser::MaybeParseTopKeyword(
+    bool has_top, std::optional<Token>* previous_top_token) {
+  XLS_ASSIGN_OR_RETURN(Token peek, scanner_.PeekToken());
+  if (peek.type() != LexicalTokenType::kKeyword || peek.value() != "top") {
+    return false;
+  }
+  XLS_RETURN_IF_ERROR(scanner_.DropKeywordOrError("top"));
+  XLS_ASSIGN_OR_RETURN(peek, scanner_.PeekToken());
+  if (has_top && previous_top_token->has_value()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Top declared more than once, previous declaration @ %s",
+        previous_top_token->value().pos().ToHumanString()));
+  }
+  *previous_top_token = peek;
+  return true;
+}
+
+absl::Status Parser::ParseDeclaration(Package* package,
+                                      std::string_view filename,
+                                      const DeclAttributes& attributes,
+                                      bool is_top,
+                                      std::vector<FunctionBase*>* parsed) {
+  XLS_ASSIGN_OR_RETURN(Token peek, scanner_.PeekToken());
+  if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "fn") {
+    XLS_ASSIGN_OR_RETURN(Function * fn, ParseFunction(package, attributes),
+                         _ << "@ " << filename);
+    if (is_top) {
+      XLS_RETURN_IF_ERROR(package->SetTop(fn));
+    }
+    if (parsed != nullptr) {
+      parsed->push_back(fn);
+    }
+    return absl::OkStatus();
+  }
+  if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "proc") {
+    XLS_ASSIGN_OR_RETURN(Proc * proc, ParseProc(package, attributes),
+                         _ << "@ " << filename);
+    if (is_top) {
+      XLS_RETURN_IF_ERROR(package->SetTop(proc));
+    }
+    if (parsed != nullptr) {
+      parsed->push_back(proc);
+    }
+    return absl::OkStatus();
+  }
+  if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "block") {
+    XLS_ASSIGN_OR_RETURN(Block * block, ParseBlock(package, attributes),
+                         _ << "@ " << filename);
+    if (is_top) {
+      XLS_RETURN_IF_ERROR(package->SetTop(block));
+    }
+    if (parsed != nullptr) {
+      parsed->push_back(block);
+    }
+    return absl::OkStatus();
+  }
+  if (is_top) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Expected fn, proc or block definition, got %s @ %s",
+                        peek.value(), peek.pos().ToHumanString()));
+  }
+  if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "chan") {
+    XLS_RETURN_IF_ERROR(ParseChannel(package, attributes).status())
+        << "@ " << filename;
+    return absl::OkStatus();
+  }
+  if (peek.type() == LexicalTokenType::kKeyword &&
+      peek.value() == "file_number") {
+    XLS_RETURN_IF_ERROR(ParseFileNumber(package, attributes))
+        << "@ " << filename;
+    return absl::OkStatus();
+  }
+  return absl::InvalidArgumentError(
+      absl::StrFormat("Expected attribute or declaration "
+                      "(`fn`, `proc`, `block`, `chan`, `file_number`), "
+                      "got %s @ %s",
+                      peek.value(), peek.pos().ToHumanString()));
+}
+
+absl::Status Parser::ParseDeclarations(Package* package,
+                                       std::string_view filename,
+                                       std::vector<FunctionBase*>* parsed) {
+  std::optional<Token> previous_top_token;
+  while (!AtEof()) {
+    XLS_ASSIGN_OR_RETURN(DeclAttributes attributes, MaybeParseAttributes());
+    // The fn, proc or block is a top entity.
+    XLS_ASSIGN_OR_RETURN(
+        bool is_top,
+        MaybeParseTopKeyword(package->HasTop(), &previous_top_token));
+    XLS_RETURN_IF_ERROR(
+        ParseDeclaration(package, filename, attributes, is_top, parsed));
+  }
+  return absl::OkStatus();
+}
+
+namespace {
+
+// Operations which refer to other functions by name. Functions containing them
+// are parsed on the calling thread by ParseDeclarationsInParallel, once the
+// functions they may refer to have been added to the package.
+constexpr std::string_view kFunctionReferenceOps[] = {
+    "invoke", "map", "counted_for", "dynamic_counted_for"};
+
+// Nodes of functions parsed on workers are numbered from this id. Creating a
+// node increments the next node id and giving a node an explicit id raises the
+// next node id to at least that id plus one. Parsing a function therefore maps
+// a next node id `n` to max(n + node_count, raised), where `raised` is the
+// final next node id of the scope if it was raised (making it non-negative).
+// This lets the package end up with the same next node id as a serial parse,
+// which determines the ids given to nodes without explicit ids.
+constexpr int64_t kWorkerFirstNodeId = std::numeric_limits<int64_t>::min() / 2;
+
+}  // namespace
+
+absl::Status Parser::ParseDeclarationsInParallel(
+    Package* package, std::string_view filename,
+    WorkStealingThreadPool& thread_pool) {
+  struct PendingFunction {
+    explicit PendingFunction(Scanner scanner) : parser(std::move(scanner)) {}
+
+    Parser parser;
+    DeclAttributes attributes;
+    bool is_top = false;
+    absl::StatusOr<UnbuiltFunction> function;
+    int64_t next_node_id = kWorkerFirstNodeId;
+    TransformMetrics transform_metrics;
+  };
+  std::vector<std::unique_ptr<PendingFunction>> pending;
+  bool pending_top = false;
+  // Workers refer to the pending functions so must finish before returning.
+  absl::Cleanup wait_for_workers = [&] { thread_pool.WaitUntilIdle(); };
+
+  // Adds the functions parsed on workers to the package in declaration order.
+  auto build_pending = [&]() -> absl::Status {
+    thread_pool.WaitUntilIdle();
+    for (std::unique_ptr<PendingFunction>& p : pending) {
+      XLS_RETURN_IF_ERROR(p->function.status()) << "@ " << filename;
+      int64_t next_node_id = package->next_node_id() +
+                             p->function->builder->function()->node_count();
+      if (p->next_node_id >= 0) {
+        next_node_id = std::max(next_node_id, p->next_node_id);
+      }
+      package->set_next_node_id(next_node_id);
+      package->transform_metrics() =
+          package->transform_metrics() + p->transform_metrics;
+      XLS_ASSIGN_OR_RETURN(
+          Function * fn, BuildFunction(*std::move(p->function), p->attributes),
+          _ << "@ " << filename);
+      if (p->is_top) {
+        XLS_RETURN_IF_ERROR(package->SetTop(fn));
+      }
+    }
+    pending.clear();
+    pending_top = false;
+    return absl::OkStatus();
+  };
+
+  std::optional<Token> previous_top_token;
+  while (!AtEof()) {
+    XLS_ASSIGN_OR_RETURN(DeclAttributes attributes, MaybeParseAttributes());
+    XLS_ASSIGN_OR_RETURN(
+        bool is_top,
+        MaybeParseTopKeyword(package->HasTop() || pending_top,
+                             &previous_top_token));
+    XLS_ASSIGN_OR_RETURN(Token peek, scanner_.PeekToken());
+    std::optional<int64_t> token_count;
+    if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "fn") {
+      token_count = scanner_.CountTokensThroughMatchingCurl();
+    }
+    if (!token_count.has_value() ||
+        scanner_.NextTokensContainIdent(*token_count, kFunctionReferenceOps)) {
+      XLS_RETURN_IF_ERROR(build_pending());
+      XLS_RETURN_IF_ERROR(
+          ParseDeclaration(package, filename, attributes, is_top,
+                           /*parsed=*/nullptr));
+      continue;
+    }
+
+    auto p = std::make_unique<PendingFunction>(scanner_.SplitOff(*token_count));
+    p->attributes = std::move(attributes);
+    p->is_top = is_top;
+    pending_top = pending_top || is_top;
+    thread_pool.Schedule([package, p = p.get()] {
+      ConcurrentTransformScope scope(package, kWorkerFirstNodeId);
+      p->function = p->parser.ParseUnbuiltFunction(package);
+      p->next_node_id = scope.next_node_id();
+      p->transform_metrics = scope.transform_metrics();
+    });
+    pending.push_back(std::move(p));
+  }
+  return build_pending();
+}
+
 absl::StatusOr<BValue> Parser::ParseNode(
     BuilderBase* fb, absl::flat_hash_map<std::string, BValue>* name_to_value) {
   // <output_name>: <type> = op(...)
@@ -2180,6 +2377,13 @@ absl::Status Parser::ParseFileNumber(Package* package,
 
 absl::StatusOr<Function*> Parser::ParseFunction(
     Package* package, const DeclAttributes& attributes) {
+  XLS_ASSIGN_OR_RETURN(UnbuiltFunction function,
+                       ParseUnbuiltFunction(package));
+  return BuildFunction(std::move(function), attributes);
+}
+
+absl::StatusOr<Parser::UnbuiltFunction> Parser::ParseUnbuiltFunction(
+    Package* package) {
   if (AtEof()) {
     return absl::InvalidArgumentError("Could not parse function; at EOF.");
   }
@@ -2195,22 +2399,28 @@ absl::StatusOr<Function*> Parser::ParseFunction(
                        ParseBody(fb, &name_to_value, package));
 
   XLS_RET_CHECK(std::holds_alternative<BValue>(body_result));
-  BValue return_value = std::get<BValue>(body_result);
+  return UnbuiltFunction{.builder = std::move(function_data.first),
+                         .return_value = std::get<BValue>(body_result),
+                         .return_type = function_data.second};
+}
 
+absl::StatusOr<Function*> Parser::BuildFunction(
+    UnbuiltFunction function, const DeclAttributes& attributes) {
+  BValue return_value = function.return_value;
   if (return_value.valid() &&
-      return_value.node()->GetType() != function_data.second) {
+      return_value.node()->GetType() != function.return_type) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "Type of return value %s does not match declared function return type "
         "%s",
         return_value.node()->GetType()->ToString(),
-        function_data.second->ToString()));
+        function.return_type->ToString()));
   }
 
   // TODO(leary): 2019-02-19 Could be an empty function body, need to decide
   // what to do for those. Accept that the return value can be null and handle
   // everywhere?
   XLS_ASSIGN_OR_RETURN(Function * result,
-                       fb->BuildWithReturnValue(return_value));
+                       function.builder->BuildWithReturnValue(return_value));
 
   for (const auto& [attribute, literal] : attributes) {
     if (attribute == "initiation_interval") {
@@ -2731,6 +2941,23 @@ static absl::Status VerifyAndSwapError(Package* package) {
   return package;
 }
 
+/* static */ absl::StatusOr<std::unique_ptr<Package>>
+Parser::ParsePackageInParallel(std::string_view input_string,
+                               std::optional<std::string_view> filename,
+                               std::optional<int64_t> thread_count) {
+  XLS_ASSIGN_OR_RETURN(Scanner scanner,
+                       Scanner::CreateInParallel(input_string, thread_count));
+  Parser parser(std::move(scanner));
+  XLS_ASSIGN_OR_RETURN(std::string package_name, parser.ParsePackageName());
+  auto package = std::make_unique<Package>(package_name);
+  WorkStealingThreadPool thread_pool(thread_count);
+  XLS_RETURN_IF_ERROR(parser.ParseDeclarationsInParallel(
+      package.get(), filename.value_or("<unknown file>"), thread_pool));
+  SetUnassignedNodeIds(package.get());
+  XLS_RETURN_IF_ERROR(VerifyAndSwapError(package.get()));
+  return package;
+}
+
 /* static */ absl::StatusOr<std::unique_ptr<Package>>
 Parser::ParsePackageWithEntry(std::string_view input_string,
                               std::string_view entry,
@@ -2748,6 +2975,21 @@ Parser::ParsePackageNoVerify(std::string_view input_string,
   return ParseDerivedPackageNoVerify<Package>(input_string, filename, entry);
 }
 
+/* static */ absl::StatusOr<std::vector<FunctionBase*>>
+Parser::ParseDeclarationsNoVerify(std::string_view input_string,
+                                  Package* package,
+                                  std::optional<std::string_view> filename) {
+  XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
+  Parser p(std::move(scanner));
+  std::vector<FunctionBase*> parsed;
+  XLS_RETURN_IF_ERROR(p.ParseDeclarations(
+      package, filename.value_or("<unknown file>"), &parsed));
+  for (FunctionBase* fb : parsed) {
+    SetUnassignedNodeIds(package, fb);
+  }
+  return parsed;
+}
+
 /* static */ absl::StatusOr<Value> Parser::ParseValue(
     std::string_view input_string, Type* expected_type) {
   XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
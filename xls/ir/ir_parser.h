@@ -38,6 +38,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/work_stealing_thread_pool.h"
 #include "xls/ir/block.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/function.h"
@@ -68,6 +69,22 @@ class Parser {
       std::string_view input_string,
       std::optional<std::string_view> filename = std::nullopt);
 
+  // As above but tokenizes the input on multiple threads (see
+  // TokenizeStringInParallel) and parses the bodies of functions concurrently.
+  // The returned package is identical to the one returned by ParsePackage. If
+  // `thread_count` is std::nullopt the number of available CPUs is used.
+  //
+  // Each function body is parsed on a worker inside its own
+  // ConcurrentTransformScope and the functions are added to the package in
+  // declaration order once parsed. Functions which refer to other functions
+  // (invoke, map, counted_for and dynamic_counted_for), procs, blocks and
+  // channels are parsed on the calling thread after all preceding functions
+  // have been added, so they resolve exactly as in ParsePackage.
+  static absl::StatusOr<std::unique_ptr<Package>> ParsePackageInParallel(
+      std::string_view input_string,
+      std::optional<std::string_view> filename = std::nullopt,
+      std::optional<int64_t> thread_count = std::nullopt);
+
   // As above, but sets the entry function to be the given name in the returned
   // package.
   static absl::StatusOr<std::unique_ptr<Package>> ParsePackageWithEntry(
@@ -120,6 +137,14 @@ class Parser {
       std::optional<std::string_view> filename = std::nullopt,
       std::optional<std::string_view> entry = std::nullopt);
 
+  // Parses the given input string as a sequence of top-level declarations
+  // (without a `package` header) into an existing package. Returns the newly
+  // created function bases. The package is not verified. This is used to
+  // build up a package incrementally, e.g., when lazily loading binary IR.
+  static absl::StatusOr<std::vector<FunctionBase*>> ParseDeclarationsNoVerify(
+      std::string_view input_string, Package* package,
+      std::optional<std::string_view> filename = std::nullopt);
+
   // Parses a literal value that should be of type "expected_type" and returns
   // it.
   static absl::StatusOr<Value> ParseValue(std::string_view input_string,
@@ -136,12 +161,29 @@ class Parser {
  private:
   friend class ArgParser;
 
-  explicit Parser(Scanner scanner) : scanner_(scanner) {}
+  explicit Parser(Scanner scanner) : scanner_(std::move(scanner)) {}
 
   // Parse a function starting at the current scanner position.
   absl::StatusOr<Function*> ParseFunction(
       Package* package, const DeclAttributes& attributes = {});
 
+  // A function whose body has been parsed but which has not yet been added to
+  // the package.
+  struct UnbuiltFunction {
+    std::unique_ptr<FunctionBuilder> builder;
+    BValue return_value;
+    Type* return_type;
+  };
+
+  // Parses a function starting at the current scanner position without adding
+  // it to the package. Only touches the thread-safe parts of the package so
+  // may run inside a ConcurrentTransformScope.
+  absl::StatusOr<UnbuiltFunction> ParseUnbuiltFunction(Package* package);
+
+  // Adds a function parsed by ParseUnbuiltFunction to its package.
+  absl::StatusOr<Function*> BuildFunction(UnbuiltFunction function,
+                                          const DeclAttributes& attributes);
+
   // Parse a proc starting at the current scanner position.
   absl::StatusOr<Proc*> ParseProc(Package* package,
                                   const DeclAttributes& attributes = {});
@@ -329,6 +371,37 @@ class Parser {
   absl::Status ParseFileNumber(Package* package,
                                const DeclAttributes& attributes = {});
 
+  // Parses a package from the tokens of the given scanner.
+  template <typename PackageT>
+  static absl::StatusOr<std::unique_ptr<PackageT>>
+  ParseDerivedPackageFromScanner(Scanner scanner,
+                                 std::optional<std::string_view> filename,
+                                 std::optional<std::string_view> entry);
+
+  // Parses top-level declarations (functions, procs, blocks, channels and
+  // file numbers) until the end of input and adds them to `package`. If
+  // `parsed` is non-null the newly created function bases are appended to it.
+  absl::Status ParseDeclarations(Package* package, std::string_view filename,
+                                 std::vector<FunctionBase*>* parsed = nullptr);
+
+  // Drops the `top` keyword if it is next and returns whether it was.
+  // `previous_top_token` holds the previous `top` keyword, if any; declaring a
+  // second top is an error if `has_top` is true.
+  absl::StatusOr<bool> MaybeParseTopKeyword(
+      bool has_top, std::optional<Token>* previous_top_token);
+
+  // Parses the declaration at the current scanner position, which follows its
+  // attributes and `top` keyword if any, and adds it to `package`.
+  absl::Status ParseDeclaration(Package* package, std::string_view filename,
+                                const DeclAttributes& attributes, bool is_top,
+                                std::vector<FunctionBase*>* parsed);
+
+  // As ParseDeclarations but parses the bodies of functions which do not refer
+  // to other functions on `thread_pool`. See ParsePackageInParallel.
+  absl::Status ParseDeclarationsInParallel(Package* package,
+                                           std::string_view filename,
+                                           WorkStealingThreadPool& thread_pool);
+
   // Parse a sequence of attributes of the form:
   //
   // #[<ident>(<literal>)]
@@ -343,8 +416,16 @@ class Parser {
 absl::StatusOr<std::unique_ptr<PackageT>> Parser::ParseDerivedPackageNoVerify(
     std::string_view input_string, std::optional<std::string_view> filename,
     std::optional<std::string_view> entry) {
-  std::optional<Token> previous_top_token;
   XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
+  return ParseDerivedPackageFromScanner<PackageT>(std::move(scanner), filename,
+                                                  entry);
+}
+
+/* static */ template <typename PackageT>
+absl::StatusOr<std::unique_ptr<PackageT>>
+Parser::ParseDerivedPackageFromScanner(Scanner scanner,
+                                       std::optional<std::string_view> filename,
+                                       std::optional<std::string_view> entry) {
   Parser parser(std::move(scanner));
 
   XLS_ASSIGN_OR_RETURN(std::string package_name, parser.ParsePackageName());
@@ -352,75 +433,7 @@ absl::StatusOr<std::unique_ptr<PackageT>> Parser::ParseDerivedPackageNoVerify(
   auto package = std::make_unique<PackageT>(package_name);
   std::string filename_str =
       (filename.has_value() ? std::string(filename.value()) : "<unknown file>");
-  while (!parser.AtEof()) {
-    XLS_ASSIGN_OR_RETURN(DeclAttributes attributes,
-                         parser.MaybeParseAttributes());
-
-    XLS_ASSIGN_OR_RETURN(Token peek, parser.scanner_.PeekToken());
-
-    bool is_top = false;
-    // The fn, proc or block is a top entity.
-    if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "top") {
-      is_top = true;
-      XLS_RETURN_IF_ERROR(parser.scanner_.DropKeywordOrError("top"));
-      XLS_ASSIGN_OR_RETURN(peek, parser.scanner_.PeekToken());
-      if (package.get()->HasTop() && previous_top_token.has_value()) {
-        return absl::InvalidArgumentError(absl::StrFormat(
-            "Top declared more than once, previous declaration @ %s",
-            previous_top_token.value().pos().ToHumanString()));
-      }
-      previous_top_token = peek;
-    }
-    if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "fn") {
-      XLS_ASSIGN_OR_RETURN(Function * fn,
-                           parser.ParseFunction(package.get(), attributes),
-                           _ << "@ " << filename_str);
-      if (is_top) {
-        XLS_RETURN_IF_ERROR(package->SetTop(fn));
-      }
-      continue;
-    }
-    if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "proc") {
-      XLS_ASSIGN_OR_RETURN(Proc * proc,
-                           parser.ParseProc(package.get(), attributes),
-                           _ << "@ " << filename_str);
-      if (is_top) {
-        XLS_RETURN_IF_ERROR(package->SetTop(proc));
-      }
-      continue;
-    }
-    if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "block") {
-      XLS_ASSIGN_OR_RETURN(Block * block,
-                           parser.ParseBlock(package.get(), attributes),
-                           _ << "@ " << filename_str);
-      if (is_top) {
-        XLS_RETURN_IF_ERROR(package->SetTop(block));
-      }
-      continue;
-    }
-    if (is_top) {
-      return absl::InvalidArgumentError(
-          absl::StrFormat("Expected fn, proc or block definition, got %s @ %s",
-                          peek.value(), peek.pos().ToHumanString()));
-    }
-    if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "chan") {
-      XLS_RETURN_IF_ERROR(
-          parser.ParseChannel(package.get(), attributes).status())
-          << "@ " << filename_str;
-      continue;
-    }
-    if (peek.type() == LexicalTokenType::kKeyword &&
-        peek.value() == "file_number") {
-      XLS_RETURN_IF_ERROR(parser.ParseFileNumber(package.get(), attributes))
-          << "@ " << filename_str;
-      continue;
-    }
-    return absl::InvalidArgumentError(
-        absl::StrFormat("Expected attribute or declaration "
-                        "(`fn`, `proc`, `block`, `chan`, `file_number`), "
-                        "got %s @ %s",
-                        peek.value(), peek.pos().ToHumanString()));
-  }
+  XLS_RETURN_IF_ERROR(parser.ParseDeclarations(package.get(), filename_str));
 
   // Verify the given entry function exists in the package.
   if (entry.has_value()) {
@@ -19,11 +19,13 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/substitute.h"
 #include "xls/common/casts.h"
 #include "xls/common/source_location.h"
@@ -33,6 +35,8 @@
 #include "xls/ir/channel.h"
 #include "xls/ir/channel.pb.h"
 #include "xls/ir/channel_ops.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/ir_scanner.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/op.h"
 #include "xls/ir/package.h"
@@ -172,6 +176,118 @@ fn two_plus_two() -> bits[32] {
   EXPECT_EQ(func->name(), "two_plus_two");
 }
 
+TEST(IrParserTest, ParseDeclarationsIntoExistingPackage) {
+  Package package("my_package");
+  std::string first_input = R"(
+fn one() -> bits[32] {
+  ret literal.1: bits[32] = literal(value=1, id=1)
+}
+)";
+  std::string second_input = R"(
+chan ch(bits[32], id=0, kind=streaming, flow_control=ready_valid,
+        ops=send_only)
+
+top fn two() -> bits[32] {
+  invoke.2: bits[32] = invoke(to_apply=one, id=2)
+  ret add.3: bits[32] = add(invoke.2, invoke.2, id=3)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<FunctionBase*> first,
+      Parser::ParseDeclarationsNoVerify(first_input, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<FunctionBase*> second,
+      Parser::ParseDeclarationsNoVerify(second_input, &package));
+  ASSERT_EQ(first.size(), 1);
+  EXPECT_EQ(first.front()->name(), "one");
+  ASSERT_EQ(second.size(), 1);
+  EXPECT_EQ(second.front()->name(), "two");
+  EXPECT_EQ(package.GetTop(), second.front());
+  EXPECT_EQ(package.channels().size(), 1);
+}
+
+TEST(IrParserTest, ParsePackageInParallelMatchesSerial) {
+  std::string input = "package big\n\n";
+  for (int64_t i = 0; input.size() < 2 * kMinParallelTokenizeSize; ++i) {
+    absl::StrAppendFormat(&input,
+                          "fn f%d(x: bits[32] id=%d) -> bits[32] {\n"
+                          "  literal.%d: bits[32] = literal(value=%d, id=%d)\n"
+                          "  ret add.%d: bits[32] = add(x, literal.%d, id=%d)\n"
+                          "}\n\n",
+                          i, 3 * i + 1, 3 * i + 2, i, 3 * i + 2, 3 * i + 3,
+                          3 * i + 2, 3 * i + 3);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> serial,
+                           Parser::ParsePackage(input));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Package> parallel,
+      Parser::ParsePackageInParallel(input, std::nullopt, /*thread_count=*/4));
+  EXPECT_EQ(parallel->DumpIr(), serial->DumpIr());
+}
+
+TEST(IrParserTest, ParsePackageInParallelResolvesReferences) {
+  std::string input = R"(package refs
+
+chan ch(bits[32], id=0, kind=streaming, flow_control=none, ops=send_only,
+        metadata="""""")
+
+fn add_one(x: bits[32]) -> bits[32] {
+  one: bits[32] = literal(value=1)
+  ret add: bits[32] = add(x, one)
+}
+
+fn numbered(x: bits[32] id=40) -> bits[32] {
+  ret neg.41: bits[32] = neg(x, id=41)
+}
+
+fn calls(x: bits[32]) -> bits[32] {
+  ret invoke: bits[32] = invoke(x, to_apply=add_one)
+}
+
+fn unnumbered(x: bits[32]) -> bits[32] {
+  ret not: bits[32] = not(x)
+}
+
+top fn main(x: bits[32]) -> bits[32] {
+  a: bits[32] = invoke(x, to_apply=calls)
+  b: bits[32] = invoke(a, to_apply=numbered)
+  ret c: bits[32] = invoke(b, to_apply=unnumbered)
+}
+
+proc p(tkn: token, st: bits[32], init={token, 0}) {
+  send: token = send(tkn, st, channel=ch)
+  next (send, st)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> serial,
+                           Parser::ParsePackage(input));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Package> parallel,
+      Parser::ParsePackageInParallel(input, std::nullopt, /*thread_count=*/4));
+  EXPECT_EQ(parallel->DumpIr(), serial->DumpIr());
+  EXPECT_EQ(parallel->next_node_id(), serial->next_node_id());
+  ASSERT_TRUE(parallel->GetTop().has_value());
+  EXPECT_EQ((*parallel->GetTop())->name(), "main");
+}
+
+TEST(IrParserTest, ParsePackageInParallelReportsErrorsOfWorkers) {
+  std::string input = R"(package errors
+
+fn good(x: bits[32]) -> bits[32] {
+  ret neg: bits[32] = neg(x)
+}
+
+fn bad(x: bits[32]) -> bits[8] {
+  ret neg: bits[32] = neg(x)
+}
+)";
+  EXPECT_THAT(
+      Parser::ParsePackageInParallel(input, std::nullopt, /*thread_count=*/2)
+          .status(),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("does not match declared function return type")));
+}
+
 TEST(IrParserTest, ParseMultiFunctionPackage) {
   std::string input = R"(package MultiFunctionPackage
 
@@ -14,15 +14,18 @@
 
 #include "xls/ir/ir_scanner.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cstdint>
 #include <functional>
+#include <iterator>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
@@ -30,7 +33,10 @@
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
+#include "xls/common/work_stealing_thread_pool.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/number_parser.h"
 
@@ -134,8 +140,8 @@ class Tokenizer {
  public:
   // Tokenizes the given string and returns the vector of Tokens.
   static absl::StatusOr<std::vector<Token>> TokenizeString(
-      std::string_view str) {
-    Tokenizer tokenizer(str);
+      std::string_view str, int64_t start_lineno = 0) {
+    Tokenizer tokenizer(str, start_lineno);
     return tokenizer.Tokenize();
   }
 
@@ -381,7 +387,8 @@ class Tokenizer {
   int64_t colno() const { return colno_; }
 
  private:
-  explicit Tokenizer(std::string_view str) : str_(str) {}
+  Tokenizer(std::string_view str, int64_t start_lineno)
+      : str_(str), lineno_(start_lineno) {}
 
   // The string being tokenized.
   std::string_view str_;
@@ -400,11 +407,140 @@ absl::StatusOr<std::vector<Token>> TokenizeString(std::string_view str) {
   return Tokenizer::TokenizeString(str);
 }
 
+namespace {
+
+// Returns the index of the first line at or after `pos` which starts with a
+// top-level declaration or the size of `str` if there is none. A split at
+// such a line is very unlikely to fall inside a multi-line string.
+int64_t NextDeclarationStart(std::string_view str, int64_t pos) {
+  constexpr std::string_view kDeclarationPrefixes[] = {
+      "fn ", "proc ", "block ", "top ", "chan ", "file_number ", "#["};
+  while (true) {
+    size_t newline = str.find('\n', pos);
+    if (newline == std::string_view::npos) {
+      return str.size();
+    }
+    pos = newline + 1;
+    std::string_view line = str.substr(pos);
+    for (std::string_view prefix : kDeclarationPrefixes) {
+      if (line.substr(0, prefix.size()) == prefix) {
+        return pos;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<std::vector<Token>> TokenizeStringInParallel(
+    std::string_view str, std::optional<int64_t> thread_count) {
+  int64_t threads = thread_count.value_or(AvailableCPUs());
+  if (threads <= 1 || str.size() < kMinParallelTokenizeSize) {
+    return TokenizeString(str);
+  }
+
+  // Split the input into pieces which start at the beginning of a top-level
+  // declaration. Use a few pieces per thread to balance the load.
+  struct Piece {
+    std::string_view text;
+    int64_t start_lineno;
+    absl::StatusOr<std::vector<Token>> tokens = std::vector<Token>();
+  };
+  const int64_t target_size =
+      std::max<int64_t>(str.size() / (threads * 4), 4096);
+  std::vector<Piece> pieces;
+  int64_t start = 0;
+  int64_t lineno = 0;
+  while (start < str.size()) {
+    int64_t end = std::min<int64_t>(start + target_size, str.size());
+    if (end < str.size()) {
+      end = NextDeclarationStart(str, end);
+    }
+    std::string_view text = str.substr(start, end - start);
+    pieces.push_back(Piece{.text = text, .start_lineno = lineno});
+    lineno += std::count(text.begin(), text.end(), '\n');
+    start = end;
+  }
+
+  {
+    WorkStealingThreadPool pool(std::min<int64_t>(threads, pieces.size()));
+    for (Piece& piece : pieces) {
+      pool.Schedule([&piece]() {
+        piece.tokens =
+            Tokenizer::TokenizeString(piece.text, piece.start_lineno);
+      });
+    }
+    pool.WaitUntilIdle();
+  }
+
+  int64_t token_count = 0;
+  for (const Piece& piece : pieces) {
+    if (!piece.tokens.ok()) {
+      // Either the input is malformed or a piece boundary fell inside a
+      // multi-line string. Tokenize serially which handles the latter and
+      // reports errors with the same positions as TokenizeString.
+      return TokenizeString(str);
+    }
+    token_count += piece.tokens->size();
+  }
+  std::vector<Token> tokens;
+  tokens.reserve(token_count);
+  for (Piece& piece : pieces) {
+    std::move(piece.tokens->begin(), piece.tokens->end(),
+              std::back_inserter(tokens));
+  }
+  return tokens;
+}
+
 absl::StatusOr<Scanner> Scanner::Create(std::string_view text) {
   XLS_ASSIGN_OR_RETURN(auto tokens, TokenizeString(text));
   return Scanner(std::move(tokens));
 }
 
+absl::StatusOr<Scanner> Scanner::CreateInParallel(
+    std::string_view text, std::optional<int64_t> thread_count) {
+  XLS_ASSIGN_OR_RETURN(auto tokens,
+                       TokenizeStringInParallel(text, thread_count));
+  return Scanner(std::move(tokens));
+}
+
+std::optional<int64_t> Scanner::CountTokensThroughMatchingCurl() const {
+  int64_t depth = 0;
+  for (int64_t i = token_idx_; i < tokens_.size(); ++i) {
+    if (tokens_[i].type() == LexicalTokenType::kCurlOpen) {
+      ++depth;
+    } else if (tokens_[i].type() == LexicalTokenType::kCurlClose) {
+      if (depth == 0) {
+        return std::nullopt;
+      }
+      if (--depth == 0) {
+        return i - token_idx_ + 1;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+bool Scanner::NextTokensContainIdent(
+    int64_t count, absl::Span<const std::string_view> values) const {
+  for (int64_t i = token_idx_; i < token_idx_ + count; ++i) {
+    if (tokens_[i].type() == LexicalTokenType::kIdent &&
+        absl::c_linear_search(values, tokens_[i].value())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Scanner Scanner::SplitOff(int64_t count) {
+  CHECK_LE(token_idx_ + count, tokens_.size());
+  std::vector<Token> tokens(
+      std::make_move_iterator(tokens_.begin() + token_idx_),
+      std::make_move_iterator(tokens_.begin() + token_idx_ + count));
+  token_idx_ += count;
+  return Scanner(std::move(tokens));
+}
+
 absl::StatusOr<Token> Scanner::PeekToken() const {
   if (AtEof()) {
     return absl::InvalidArgumentError("Expected token, but found EOF.");
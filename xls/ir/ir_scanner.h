@@ -16,9 +16,11 @@
 #define XLS_IR_IR_SCANNER_H_
 
 #include <cstdint>
+#include <optional>
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "absl/base/no_destructor.h"
@@ -27,6 +29,7 @@
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/ir/bits.h"
 
 namespace xls {
@@ -136,10 +139,27 @@ inline std::ostream& operator<<(std::ostream& os, const Token& token) {
 // driven tokenization.
 absl::StatusOr<std::vector<Token>> TokenizeString(std::string_view str);
 
+// Inputs smaller than this are always tokenized serially.
+inline constexpr int64_t kMinParallelTokenizeSize = 1 << 20;
+
+// Tokenizes the given string on multiple threads. The input is split at line
+// starts into pieces which are tokenized concurrently and then concatenated.
+// The result, including source positions and errors, is identical to
+// TokenizeString. If `thread_count` is std::nullopt the number of available
+// CPUs is used. See Parser::ParsePackageInParallel for how much of parsing
+// this covers.
+absl::StatusOr<std::vector<Token>> TokenizeStringInParallel(
+    std::string_view str, std::optional<int64_t> thread_count = std::nullopt);
+
 class Scanner {
  public:
   static absl::StatusOr<Scanner> Create(std::string_view text);
 
+  // As above but tokenizes with TokenizeStringInParallel.
+  static absl::StatusOr<Scanner> CreateInParallel(
+      std::string_view text,
+      std::optional<int64_t> thread_count = std::nullopt);
+
   // Peeks at the next token in the token stream, or returns an error if we're
   // at EOF and no more tokens are available.
   absl::StatusOr<Token> PeekToken() const;
@@ -219,8 +239,22 @@ class Scanner {
   // Check if more tokens are available.
   bool AtEof() const { return token_idx_ >= tokens_.size(); }
 
+  // Returns the number of tokens from the current position up to and including
+  // the closing curly brace which matches the first opening curly brace, or
+  // std::nullopt if there is no such brace.
+  std::optional<int64_t> CountTokensThroughMatchingCurl() const;
+
+  // Returns true if any of the next `count` tokens is an identifier equal to
+  // one of `values`.
+  bool NextTokensContainIdent(int64_t count,
+                              absl::Span<const std::string_view> values) const;
+
+  // Moves the next `count` tokens into a new scanner and skips them in this
+  // one.
+  Scanner SplitOff(int64_t count);
+
  private:
-  explicit Scanner(std::vector<Token> tokens) : tokens_(tokens) {}
+  explicit Scanner(std::vector<Token> tokens) : tokens_(std::move(tokens)) {}
 
   int64_t token_idx_ = 0;
   std::vector<Token> tokens_;
@@ -14,6 +14,7 @@
 
 #include "xls/ir/ir_scanner.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -21,6 +22,7 @@
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "xls/common/status/matchers.h"
 
@@ -179,5 +181,50 @@ TEST(IrScannerTest, UnterminatedTripleQuotedStrings) {
                HasSubstr("Unterminated quoted string starting at 1:1")));
 }
 
+// Returns IR-like text of at least `size` bytes which includes comments and
+// multi-line strings, some of which contain lines that look like
+// declarations.
+std::string MakeLargeInput(int64_t size) {
+  std::string text;
+  for (int64_t i = 0; text.size() < size; ++i) {
+    absl::StrAppend(&text, "// Function ", i, "\n");
+    absl::StrAppend(&text, "#[attr(\"\"\"\n", i % 1000 == 0 ? "fn " : "",
+                    "string", i, "() {\n}\n\"\"\")]\n");
+    absl::StrAppend(&text, "fn f", i, "(x: bits[32]) -> bits[32] {\n");
+    absl::StrAppend(&text, "  ret add.", i, ": bits[32] = add(x, x, id=", i,
+                    ")\n}\n\n");
+  }
+  return text;
+}
+
+void ExpectSameTokens(absl::Span<const Token> a, absl::Span<const Token> b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (int64_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i].type(), b[i].type()) << i;
+    EXPECT_EQ(a[i].value(), b[i].value()) << i;
+    EXPECT_EQ(a[i].pos().lineno, b[i].pos().lineno) << i;
+    EXPECT_EQ(a[i].pos().colno, b[i].pos().colno) << i;
+  }
+}
+
+TEST(IrScannerTest, TokenizeInParallelMatchesSerial) {
+  std::string text = MakeLargeInput(4 * kMinParallelTokenizeSize);
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<Token> serial, TokenizeString(text));
+  for (int64_t thread_count : {1, 2, 7}) {
+    XLS_ASSERT_OK_AND_ASSIGN(std::vector<Token> parallel,
+                             TokenizeStringInParallel(text, thread_count));
+    ExpectSameTokens(serial, parallel);
+  }
+}
+
+TEST(IrScannerTest, TokenizeInParallelReportsSameError) {
+  std::string text = MakeLargeInput(4 * kMinParallelTokenizeSize);
+  text.insert(text.find("\nfn f", text.size() / 2) + 1, "\"unterminated\n");
+  absl::Status serial = TokenizeString(text).status();
+  EXPECT_THAT(serial, StatusIs(absl::StatusCode::kInvalidArgument,
+                               HasSubstr("Unterminated quoted string")));
+  EXPECT_EQ(TokenizeStringInParallel(text, 4).status(), serial);
+}
+
 }  // namespace
 }  // namespace xls
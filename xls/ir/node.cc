@@ -70,6 +70,7 @@ void Node::AddOperand(Node* operand) {
           << operands_.size() << " operand of " << GetName();
   operands_.push_back(operand);
   operand->AddUser(this);
+  function_base_->OperandChanged(this, /*old_operand=*/nullptr, operand);
   VLOG(3) << " " << operand->GetName()
           << " user now: " << operand->GetUsersString();
 }
@@ -109,6 +110,7 @@ void Node::AddUser(Node* user) {
   }
   if (it == users_.end() || (*it)->id() != user->id()) {
     users_.insert(it, user);
+    function_base_->OperandAdded(this, user);
   }
 }
 
@@ -831,6 +833,9 @@ bool Node::ReplaceOperand(Node* old_operand, Node* new_operand) {
     }
   }
   old_operand->RemoveUser(this);
+  if (did_replace) {
+    function_base_->OperandChanged(this, old_operand, new_operand);
+  }
   return did_replace;
 }
 
@@ -848,6 +853,7 @@ absl::Status Node::ReplaceOperandNumber(int64_t operand_no, Node* new_operand,
   // node in another operand slot, it is safe to call.
   new_operand->AddUser(this);
   operands_[operand_no] = new_operand;
+  function_base_->OperandChanged(this, old_operand, new_operand);
 
   for (Node* operand : operands()) {
     if (operand == old_operand) {
@@ -865,6 +871,7 @@ absl::Status Node::RemoveOptionalOperand(int64_t operand_no) {
   ++package()->transform_metrics().operands_removed;
 
   operands_.pop_back();
+  function_base_->OperandChanged(this, old_operand, /*new_operand=*/nullptr);
 
   for (Node* operand : operands()) {
     if (operand == old_operand) {
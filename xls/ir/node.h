@@ -15,6 +15,7 @@
 #ifndef XLS_IR_NODE_H_
 #define XLS_IR_NODE_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -32,6 +33,7 @@
 #include "absl/types/span.h"
 #include "xls/common/casts.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/node_allocator.h"
 #include "xls/ir/op.h"
 #include "xls/ir/source_location.h"
 #include "xls/ir/type.h"
@@ -52,6 +54,14 @@ class Node {
  public:
   virtual ~Node() = default;
 
+  // Nodes are allocated from size-segregated slabs. See NodeAllocator.
+  static void* operator new(size_t size) {
+    return NodeAllocator::Allocate(size);
+  }
+  static void operator delete(void* ptr, size_t size) {
+    NodeAllocator::Deallocate(ptr, size);
+  }
+
   // Accepts the visitor, instructing it to visit this node.
   //
   // The visitor is instructed to visit this node with:
@@ -287,6 +297,7 @@ class Node {
   // Block needs to be a friend to strongly name ports (guarantee name has no
   // uniquifying prefix).
   friend class Block;
+  friend class IncrementalTopoOrder;
 
   Node(Op op, Type* type, const SourceInfo& loc, std::string_view name,
        FunctionBase* function);
@@ -333,6 +344,14 @@ class Node {
 
   // Set of users sorted by node_id for stability.
   absl::InlinedVector<Node*, 2> users_;
+
+  // Links in the intrusive list of nodes owned by the function base.
+  Node* prev_in_function_base_ = nullptr;
+  Node* next_in_function_base_ = nullptr;
+
+  // Position in the function base's IncrementalTopoOrder or -1 if the node is
+  // not in one.
+  int64_t topo_position_ = -1;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Node& node) {
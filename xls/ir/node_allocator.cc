@@ -0,0 +1,337 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/node_allocator.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include "absl/base/config.h"
+#include "absl/base/no_destructor.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace xls {
+namespace {
+
+constexpr int64_t kSizeClassCount =
+    NodeAllocator::kMaxSlabAllocationSize / NodeAllocator::kGranularity;
+
+// Number of blocks moved at once between a thread cache and the shared free
+// list, and carved at once from a shared slab. A thread cache holds at most
+// twice this many free blocks of each size class.
+constexpr int64_t kBatchSize = 32;
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+// Header at the start of each slab. Slabs are aligned to their size so the
+// slab of a block is found by masking its address.
+struct alignas(NodeAllocator::kGranularity) Slab {
+  // Number of blocks carved from this slab which are not on the shared free
+  // list, i.e. which are allocated or held by a thread cache. Guarded by the
+  // mutex of the slab's size class. The slab can be returned to the system
+  // once this drops to zero.
+  int64_t outstanding_count = 0;
+};
+
+Slab* SlabOf(void* block) {
+  return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(block) &
+                                 ~uintptr_t{NodeAllocator::kSlabSize - 1});
+}
+
+struct SizeClass {
+  absl::Mutex mutex;
+  FreeBlock* free_list ABSL_GUARDED_BY(mutex) = nullptr;
+  int64_t free_count ABSL_GUARDED_BY(mutex) = 0;
+  // Unallocated remainder of the most recently allocated slab.
+  Slab* slab ABSL_GUARDED_BY(mutex) = nullptr;
+  char* slab_next ABSL_GUARDED_BY(mutex) = nullptr;
+  char* slab_end ABSL_GUARDED_BY(mutex) = nullptr;
+  int64_t slab_count ABSL_GUARDED_BY(mutex) = 0;
+  // The free list is scanned for slabs to release once it has doubled in
+  // length since the last scan, which keeps the scans amortized O(1).
+  int64_t release_free_count ABSL_GUARDED_BY(mutex) = 0;
+};
+
+std::array<SizeClass, kSizeClassCount>& SizeClasses() {
+  static absl::NoDestructor<std::array<SizeClass, kSizeClassCount>>
+      size_classes;
+  return *size_classes;
+}
+
+bool UsesSlab(size_t size) {
+#ifdef ABSL_HAVE_ADDRESS_SANITIZER
+  // Reusing blocks would hide use-after-free errors.
+  return false;
+#else
+  return size > 0 && size <= NodeAllocator::kMaxSlabAllocationSize;
+#endif
+}
+
+int64_t SizeClassIndex(size_t size) {
+  return (static_cast<int64_t>(size) - 1) / NodeAllocator::kGranularity;
+}
+
+int64_t BlockSize(int64_t index) {
+  return (index + 1) * NodeAllocator::kGranularity;
+}
+
+// Returns the slabs whose blocks are all on the free list to the system.
+void ReleaseFreeSlabs(SizeClass& size_class)
+    ABSL_EXCLUSIVE_LOCKS_REQUIRED(size_class.mutex) {
+  std::vector<Slab*> released;
+  FreeBlock** link = &size_class.free_list;
+  while (*link != nullptr) {
+    FreeBlock* block = *link;
+    Slab* slab = SlabOf(block);
+    // The slab being carved still has blocks which are not on the free list.
+    if (slab == size_class.slab || slab->outstanding_count > 0) {
+      link = &block->next;
+      continue;
+    }
+    if (slab->outstanding_count == 0) {
+      // Mark the slab so it is only released once.
+      slab->outstanding_count = -1;
+      released.push_back(slab);
+    }
+    *link = block->next;
+    --size_class.free_count;
+  }
+  for (Slab* slab : released) {
+    ::operator delete(slab, std::align_val_t(NodeAllocator::kSlabSize));
+  }
+  size_class.slab_count -= released.size();
+  size_class.release_free_count = size_class.free_count;
+}
+
+// Pushes `block` onto the shared free list.
+void PushShared(SizeClass& size_class, FreeBlock* block)
+    ABSL_EXCLUSIVE_LOCKS_REQUIRED(size_class.mutex) {
+  --SlabOf(block)->outstanding_count;
+  block->next = size_class.free_list;
+  size_class.free_list = block;
+  ++size_class.free_count;
+}
+
+void MaybeReleaseFreeSlabs(SizeClass& size_class, int64_t index)
+    ABSL_EXCLUSIVE_LOCKS_REQUIRED(size_class.mutex) {
+  int64_t blocks_per_slab = NodeAllocator::kSlabSize / BlockSize(index);
+  if (size_class.free_count >= blocks_per_slab &&
+      size_class.free_count >= 2 * size_class.release_free_count) {
+    ReleaseFreeSlabs(size_class);
+  }
+}
+
+// Carves up to `max_count` blocks from the current slab of `size_class`,
+// starting a new slab if it is exhausted. Returns the first block and sets
+// `end` past the last one.
+char* CarveShared(SizeClass& size_class, int64_t index, int64_t max_count,
+                  char*& end) ABSL_EXCLUSIVE_LOCKS_REQUIRED(size_class.mutex) {
+  int64_t block_size = BlockSize(index);
+  if (size_class.slab_end - size_class.slab_next < block_size) {
+    size_class.slab = new (::operator new(
+        NodeAllocator::kSlabSize, std::align_val_t(NodeAllocator::kSlabSize)))
+        Slab();
+    size_class.slab_next = reinterpret_cast<char*>(size_class.slab + 1);
+    size_class.slab_end =
+        reinterpret_cast<char*>(size_class.slab) + NodeAllocator::kSlabSize;
+    ++size_class.slab_count;
+  }
+  int64_t count = std::min(
+      max_count, (size_class.slab_end - size_class.slab_next) / block_size);
+  char* begin = size_class.slab_next;
+  size_class.slab_next += count * block_size;
+  size_class.slab->outstanding_count += count;
+  end = size_class.slab_next;
+  return begin;
+}
+
+// Free blocks and an uncarved range of a slab held by one thread for one size
+// class. Both are accessed without locking and count as outstanding blocks of
+// their slabs.
+struct LocalSizeClass {
+  FreeBlock* free_list = nullptr;
+  int64_t free_count = 0;
+  char* carve_next = nullptr;
+  char* carve_end = nullptr;
+};
+
+struct ThreadCache {
+  std::array<LocalSizeClass, kSizeClassCount> size_classes;
+};
+
+// Points to the cache of the current thread. Trivially destructible so it may
+// be read after the cache itself is gone, in which case it is null and
+// `thread_cache_destroyed` is set.
+thread_local ThreadCache* thread_cache = nullptr;
+thread_local bool thread_cache_destroyed = false;
+
+// Returns the blocks of a thread cache to the shared free lists when the
+// thread exits.
+class ThreadCacheOwner {
+ public:
+  ~ThreadCacheOwner() {
+    thread_cache = nullptr;
+    thread_cache_destroyed = true;
+    for (int64_t index = 0; index < kSizeClassCount; ++index) {
+      LocalSizeClass& local = cache_.size_classes[index];
+      SizeClass& size_class = SizeClasses()[index];
+      absl::MutexLock lock(&size_class.mutex);
+      while (local.free_list != nullptr) {
+        FreeBlock* block = local.free_list;
+        local.free_list = block->next;
+        PushShared(size_class, block);
+      }
+      for (; local.carve_next < local.carve_end;
+           local.carve_next += BlockSize(index)) {
+        PushShared(size_class, reinterpret_cast<FreeBlock*>(local.carve_next));
+      }
+      MaybeReleaseFreeSlabs(size_class, index);
+    }
+  }
+
+  ThreadCache& cache() { return cache_; }
+
+ private:
+  ThreadCache cache_;
+};
+
+// Returns the cache of the current thread or nullptr if the thread is exiting
+// and its cache has already been destroyed.
+ThreadCache* GetThreadCache() {
+  if (thread_cache == nullptr && !thread_cache_destroyed) {
+    thread_local ThreadCacheOwner owner;
+    thread_cache = &owner.cache();
+  }
+  return thread_cache;
+}
+
+}  // namespace
+
+/* static */ void* NodeAllocator::Allocate(size_t size) {
+  if (!UsesSlab(size)) {
+    return ::operator new(size, std::align_val_t(kGranularity));
+  }
+  int64_t index = SizeClassIndex(size);
+  int64_t block_size = BlockSize(index);
+  SizeClass& size_class = SizeClasses()[index];
+  ThreadCache* cache = GetThreadCache();
+  if (cache == nullptr) {
+    absl::MutexLock lock(&size_class.mutex);
+    if (size_class.free_list != nullptr) {
+      FreeBlock* block = size_class.free_list;
+      size_class.free_list = block->next;
+      --size_class.free_count;
+      ++SlabOf(block)->outstanding_count;
+      return block;
+    }
+    char* end;
+    return CarveShared(size_class, index, /*max_count=*/1, end);
+  }
+
+  LocalSizeClass& local = cache->size_classes[index];
+  if (local.free_list == nullptr && local.carve_next == local.carve_end) {
+    // Refill the cache from the shared free list, or else from a slab.
+    absl::MutexLock lock(&size_class.mutex);
+    for (int64_t i = 0; i < kBatchSize && size_class.free_list != nullptr;
+         ++i) {
+      FreeBlock* block = size_class.free_list;
+      size_class.free_list = block->next;
+      --size_class.free_count;
+      ++SlabOf(block)->outstanding_count;
+      block->next = local.free_list;
+      local.free_list = block;
+      ++local.free_count;
+    }
+    if (local.free_list == nullptr) {
+      local.carve_next =
+          CarveShared(size_class, index, kBatchSize, local.carve_end);
+    }
+  }
+  if (local.free_list != nullptr) {
+    FreeBlock* block = local.free_list;
+    local.free_list = block->next;
+    --local.free_count;
+    return block;
+  }
+  void* result = local.carve_next;
+  local.carve_next += block_size;
+  return result;
+}
+
+/* static */ void NodeAllocator::Deallocate(void* ptr, size_t size) {
+  if (ptr == nullptr) {
+    return;
+  }
+  if (!UsesSlab(size)) {
+    ::operator delete(ptr, std::align_val_t(kGranularity));
+    return;
+  }
+  int64_t index = SizeClassIndex(size);
+  SizeClass& size_class = SizeClasses()[index];
+  ThreadCache* cache = GetThreadCache();
+  if (cache == nullptr) {
+    absl::MutexLock lock(&size_class.mutex);
+    PushShared(size_class, new (ptr) FreeBlock());
+    MaybeReleaseFreeSlabs(size_class, index);
+    return;
+  }
+
+  LocalSizeClass& local = cache->size_classes[index];
+  local.free_list = new (ptr) FreeBlock{.next = local.free_list};
+  ++local.free_count;
+  if (local.free_count > 2 * kBatchSize) {
+    // Return a batch to the shared free list so blocks freed by one thread
+    // can be reused by others and their slabs released.
+    absl::MutexLock lock(&size_class.mutex);
+    for (int64_t i = 0; i < kBatchSize; ++i) {
+      FreeBlock* block = local.free_list;
+      local.free_list = block->next;
+      --local.free_count;
+      PushShared(size_class, block);
+    }
+    MaybeReleaseFreeSlabs(size_class, index);
+  }
+}
+
+/* static */ int64_t NodeAllocator::GetFreeBlockCount(size_t size) {
+  if (!UsesSlab(size)) {
+    return 0;
+  }
+  int64_t index = SizeClassIndex(size);
+  int64_t local_count = 0;
+  if (ThreadCache* cache = GetThreadCache(); cache != nullptr) {
+    local_count = cache->size_classes[index].free_count;
+  }
+  SizeClass& size_class = SizeClasses()[index];
+  absl::MutexLock lock(&size_class.mutex);
+  return size_class.free_count + local_count;
+}
+
+/* static */ int64_t NodeAllocator::GetSlabCount(size_t size) {
+  if (!UsesSlab(size)) {
+    return 0;
+  }
+  SizeClass& size_class = SizeClasses()[SizeClassIndex(size)];
+  absl::MutexLock lock(&size_class.mutex);
+  return size_class.slab_count;
+}
+
+}  // namespace xls
@@ -0,0 +1,60 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_IR_NODE_ALLOCATOR_H_
+#define XLS_IR_NODE_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace xls {
+
+// Slab allocator backing `Node::operator new`. Nodes are carved out of large
+// slabs segregated by size class so nodes created together are contiguous in
+// memory. Freed nodes are threaded onto a per-thread free list and reused by
+// later allocations of the same size class, so most allocations and
+// deallocations take no lock. Blocks move between the per-thread lists and a
+// shared free list per size class in batches, and the blocks of an exiting
+// thread are returned to the shared list. Slabs whose blocks are all on the
+// shared free list are returned to the system. Allocations larger than
+// kMaxSlabAllocationSize, and all allocations under AddressSanitizer, are
+// forwarded to the global allocator.
+//
+// All methods are thread-safe.
+class NodeAllocator {
+ public:
+  // Allocations are rounded up to a multiple of this many bytes. This is also
+  // the alignment of every allocation.
+  static constexpr int64_t kGranularity = 16;
+  static constexpr int64_t kMaxSlabAllocationSize = 512;
+  static constexpr int64_t kSlabSize = 64 * 1024;
+
+  static void* Allocate(size_t size);
+  static void Deallocate(void* ptr, size_t size);
+
+  // Returns the number of free blocks available for reuse by the calling
+  // thread in the size class of `size`, i.e. those on the shared free list and
+  // on the thread's own list. Returns zero for sizes which are not
+  // slab-allocated.
+  static int64_t GetFreeBlockCount(size_t size);
+
+  // Returns the number of slabs currently allocated for the size class of
+  // `size`.
+  static int64_t GetSlabCount(size_t size);
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_NODE_ALLOCATOR_H_
@@ -0,0 +1,164 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/ir/node_allocator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+#include "absl/base/config.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/thread.h"
+#include "xls/ir/benchmark_support.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "xls/ir/source_location.h"
+
+namespace xls {
+namespace {
+
+class NodeAllocatorTest : public IrTestBase {
+ protected:
+  void SetUp() override {
+#ifdef ABSL_HAVE_ADDRESS_SANITIZER
+    GTEST_SKIP() << "Slabs are disabled under AddressSanitizer.";
+#endif
+  }
+};
+
+TEST_F(NodeAllocatorTest, AllocationsAreAligned) {
+  std::vector<std::pair<void*, size_t>> allocations;
+  for (size_t size : {1, 8, 16, 17, 100, 512, 513, 4096}) {
+    void* ptr = NodeAllocator::Allocate(size);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % NodeAllocator::kGranularity,
+              0)
+        << size;
+    allocations.push_back({ptr, size});
+  }
+  for (auto [ptr, size] : allocations) {
+    NodeAllocator::Deallocate(ptr, size);
+  }
+}
+
+TEST_F(NodeAllocatorTest, FreedBlocksAreReused) {
+  constexpr size_t kSize = 200;
+  void* a = NodeAllocator::Allocate(kSize);
+  int64_t free_count = NodeAllocator::GetFreeBlockCount(kSize);
+  NodeAllocator::Deallocate(a, kSize);
+  EXPECT_EQ(NodeAllocator::GetFreeBlockCount(kSize), free_count + 1);
+
+  // Sizes in the same size class share the free list.
+  void* b = NodeAllocator::Allocate(kSize - 1);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(NodeAllocator::GetFreeBlockCount(kSize), free_count);
+  NodeAllocator::Deallocate(b, kSize - 1);
+}
+
+TEST_F(NodeAllocatorTest, LargeAllocationsBypassSlabs) {
+  constexpr size_t kSize = NodeAllocator::kMaxSlabAllocationSize + 1;
+  void* ptr = NodeAllocator::Allocate(kSize);
+  NodeAllocator::Deallocate(ptr, kSize);
+  EXPECT_EQ(NodeAllocator::GetFreeBlockCount(kSize), 0);
+}
+
+TEST_F(NodeAllocatorTest, FreeSlabsAreReleased) {
+  constexpr size_t kSize = 48;
+  constexpr int64_t kCount = 20 * NodeAllocator::kSlabSize / kSize;
+  int64_t slab_count = NodeAllocator::GetSlabCount(kSize);
+  std::vector<void*> blocks;
+  for (int64_t i = 0; i < kCount; ++i) {
+    blocks.push_back(NodeAllocator::Allocate(kSize));
+  }
+  int64_t peak_slab_count = NodeAllocator::GetSlabCount(kSize);
+  EXPECT_GE(peak_slab_count, slab_count + 19);
+  for (void* block : blocks) {
+    NodeAllocator::Deallocate(block, kSize);
+  }
+  // Only the slabs of blocks still held by this thread's list, the slab being
+  // carved, and slabs freed since the free list was last scanned remain.
+  EXPECT_LT(NodeAllocator::GetSlabCount(kSize), peak_slab_count / 2);
+}
+
+TEST_F(NodeAllocatorTest, BlocksFreedByExitingThreadsAreShared) {
+  constexpr size_t kSize = 80;
+  std::vector<void*> blocks;
+  for (int64_t i = 0; i < 10; ++i) {
+    blocks.push_back(NodeAllocator::Allocate(kSize));
+  }
+  int64_t free_count = NodeAllocator::GetFreeBlockCount(kSize);
+  Thread thread([&blocks]() {
+    for (void* block : blocks) {
+      NodeAllocator::Deallocate(block, kSize);
+    }
+  });
+  thread.Join();
+  // The blocks were returned to the shared free list when the thread exited,
+  // unless they were returned to the system along with their slab.
+  int64_t new_free_count = NodeAllocator::GetFreeBlockCount(kSize);
+  EXPECT_TRUE(new_free_count == free_count + 10 || new_free_count < free_count)
+      << new_free_count;
+}
+
+TEST_F(NodeAllocatorTest, RemovedNodesAreReused) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  fb.Not(x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(x));
+
+  Node* not_node = f->return_value()->users().front();
+  int64_t free_count = NodeAllocator::GetFreeBlockCount(sizeof(UnOp));
+  XLS_ASSERT_OK(f->RemoveNode(not_node));
+  EXPECT_EQ(NodeAllocator::GetFreeBlockCount(sizeof(UnOp)), free_count + 1);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Node * neg,
+                           f->MakeNode<UnOp>(SourceInfo(), x.node(), Op::kNeg));
+  EXPECT_EQ(neg, not_node);
+  EXPECT_EQ(NodeAllocator::GetFreeBlockCount(sizeof(UnOp)), free_count);
+}
+
+// Builds a balanced tree, walks its nodes, and tears it down again. Measures
+// node allocation, iteration, and deallocation.
+void BM_BuildWalkAndDestroyBalancedTree(benchmark::State& state) {
+  for (auto _ : state) {
+    auto p = std::make_unique<Package>("balanced_tree_pkg");
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Function * f,
+        benchmark_support::GenerateBalancedTree(
+            p.get(), /*depth=*/state.range(0), /*fan_out=*/2,
+            benchmark_support::strategy::BinaryAdd(),
+            benchmark_support::strategy::DistinctLiteral()));
+    int64_t bit_count = 0;
+    for (Node* node : f->nodes()) {
+      bit_count += node->BitCountOrDie();
+    }
+    benchmark::DoNotOptimize(bit_count);
+  }
+}
+
+BENCHMARK(BM_BuildWalkAndDestroyBalancedTree)->DenseRange(4, 16, 4);
+
+}  // namespace
+}  // namespace xls
@@ -779,7 +779,7 @@ Literal::Literal(const SourceInfo& loc, Value value, std::string_view name,
                  FunctionBase* function)
     : Node(Op::kLiteral, function->package()->GetTypeForValue(value), loc, name,
            function),
-      value_(std::move(value)) {
+      value_(function->package()->InternValue(std::move(value))) {
   CHECK(IsOpClass<Literal>(op_))
       << "Op `" << op_ << "` is not a valid op for Node class `Literal`.";
 }
@@ -798,7 +798,11 @@ bool Literal::IsDefinitelyEqualTo(const Node* other) const {
     return false;
   }
 
-  return value_ == other->As<Literal>()->value_;
+  const Literal* other_literal = other->As<Literal>();
+  if (package() == other_literal->package()) {
+    return value_ == other_literal->value_;
+  }
+  return value() == other_literal->value();
 }
 
 Map::Map(const SourceInfo& loc, Node* arg, Function* to_apply,
@@ -40,6 +40,7 @@
 #include "xls/ir/state_element.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
+#include "xls/ir/value_pool.h"
 
 // TODO(meheff): Add comments to classes and methods.
 
@@ -613,14 +614,18 @@ class Literal final : public Node {
   absl::StatusOr<Node*> CloneInNewFunction(
       absl::Span<Node* const> new_operands,
       FunctionBase* new_function) const final;
-  const Value& value() const { return value_; }
+  const Value& value() const { return value_.value(); }
+
+  // Returns the handle of the value interned in the package. Handles of equal
+  // literals in the same package compare equal.
+  const InternedValue& interned_value() const { return value_; }
 
   bool IsZero() const { return value().IsBits() && value().bits().IsZero(); }
 
   bool IsDefinitelyEqualTo(const Node* other) const final;
 
  private:
-  Value value_;
+  InternedValue value_;
 };
 
 class Map final : public Node {
@@ -56,6 +56,24 @@
 #include "xls/ir/value_utils.h"
 
 namespace xls {
+namespace {
+
+// The transform scope active on the current thread.
+thread_local ConcurrentTransformScope* active_transform_scope = nullptr;
+
+}  // namespace
+
+ConcurrentTransformScope::ConcurrentTransformScope(Package* package,
+                                                   int64_t first_node_id)
+    : package_(package), next_node_id_(first_node_id) {
+  CHECK(active_transform_scope == nullptr)
+      << "ConcurrentTransformScopes may not be nested";
+  active_transform_scope = this;
+}
+
+ConcurrentTransformScope::~ConcurrentTransformScope() {
+  active_transform_scope = nullptr;
+}
 
 Package::Package(std::string_view name) : name_(name) {}
 
@@ -145,6 +163,43 @@ absl::StatusOr<FunctionBase*> Package::GetFunctionBaseByName(
       absl::StrFormat("More than one instance with name: %s", name));
 }
 
+ConcurrentTransformScope* Package::ActiveTransformScope() const {
+  if (active_transform_scope != nullptr &&
+      active_transform_scope->package_ == this) {
+    return active_transform_scope;
+  }
+  return nullptr;
+}
+
+int64_t Package::GetNextNodeIdAndIncrement() {
+  if (ConcurrentTransformScope* scope = ActiveTransformScope()) {
+    return scope->next_node_id_++;
+  }
+  return next_node_id_++;
+}
+
+int64_t Package::next_node_id() const {
+  if (ConcurrentTransformScope* scope = ActiveTransformScope()) {
+    return scope->next_node_id_;
+  }
+  return next_node_id_;
+}
+
+void Package::set_next_node_id(int64_t value) {
+  if (ConcurrentTransformScope* scope = ActiveTransformScope()) {
+    scope->next_node_id_ = value;
+    return;
+  }
+  next_node_id_ = value;
+}
+
+TransformMetrics& Package::transform_metrics() {
+  if (ConcurrentTransformScope* scope = ActiveTransformScope()) {
+    return scope->transform_metrics_;
+  }
+  return transform_metrics_;
+}
+
 Function* Package::AddFunction(std::unique_ptr<Function> f) {
   functions_.push_back(std::move(f));
   return functions_.back().get();
@@ -695,6 +750,8 @@ absl::StatusOr<SingleValueChannel*> Package::CreateSingleValueChannelInProc(
 }
 
 absl::Status Package::RemoveChannel(Channel* channel) {
+  XLS_RET_CHECK(ActiveTransformScope() == nullptr)
+      << "Channels may not be removed inside a ConcurrentTransformScope";
   // First check that the channel is owned by this package.
   auto it = std::find(channel_vec_.begin(), channel_vec_.end(), channel);
   XLS_RET_CHECK(it != channel_vec_.end()) << "Channel not owned by package";
@@ -730,6 +787,8 @@ absl::Status Package::RemoveChannel(Channel* channel) {
 }
 
 absl::Status Package::AddChannel(std::unique_ptr<Channel> channel, Proc* proc) {
+  XLS_RET_CHECK(ActiveTransformScope() == nullptr)
+      << "Channels may not be added inside a ConcurrentTransformScope";
   if (proc != nullptr) {
     next_channel_id_ = std::max(next_channel_id_, channel->id() + 1);
     return proc->AddChannel(std::move(channel)).status();
@@ -38,6 +38,7 @@
 #include "xls/ir/type.h"
 #include "xls/ir/type_manager.h"
 #include "xls/ir/value.h"
+#include "xls/ir/value_pool.h"
 #include "xls/ir/xls_type.pb.h"
 
 namespace xls {
@@ -46,6 +47,7 @@ class Block;
 class Channel;
 class Function;
 class FunctionBase;
+class Package;
 class Proc;
 class SingleValueChannel;
 class StreamingChannel;
@@ -78,6 +80,42 @@ struct TransformMetrics {
   TransformMetricsProto ToProto() const;
 };
 
+// Makes the package-wide state which is updated while the nodes of a function
+// base are created and transformed private to the current thread. While a
+// scope is active on a thread, nodes of the package created on that thread take
+// their ids from a counter owned by the scope and transform metrics are
+// accumulated in the scope rather than in the package. This allows distinct
+// function bases of a package to be transformed concurrently, each on its own
+// thread inside its own scope.
+//
+// Nodes created inside concurrent scopes started at the same id may share ids
+// so the caller must renumber them once the scopes are destroyed. Channels may
+// not be added or removed while a scope is active. Scopes may not be nested.
+class ConcurrentTransformScope {
+ public:
+  ConcurrentTransformScope(Package* package, int64_t first_node_id);
+  ~ConcurrentTransformScope();
+
+  ConcurrentTransformScope(const ConcurrentTransformScope&) = delete;
+  ConcurrentTransformScope& operator=(const ConcurrentTransformScope&) =
+      delete;
+
+  // The id which will be assigned to the next node created in the scope.
+  int64_t next_node_id() const { return next_node_id_; }
+
+  // The transformations made in the scope.
+  const TransformMetrics& transform_metrics() const {
+    return transform_metrics_;
+  }
+
+ private:
+  friend class Package;
+
+  Package* package_;
+  int64_t next_node_id_;
+  TransformMetrics transform_metrics_;
+};
+
 class Package {
  public:
   explicit Package(std::string_view name);
@@ -154,6 +192,14 @@ class Package {
     return type_manager_.GetTypeForValue(value);
   }
 
+  // Returns a handle to the interned copy of `value` owned by this package.
+  // Literals hold their values as interned handles so equal constants are
+  // stored once and compare in constant time.
+  InternedValue InternValue(Value value) {
+    return value_pool_.Intern(std::move(value));
+  }
+  const ValuePool& value_pool() const { return value_pool_; }
+
   // Add a function, proc, or block to the package. Ownership is transferred to
   // the package.
   Function* AddFunction(std::unique_ptr<Function> f);
@@ -219,8 +265,9 @@ class Package {
   std::string SourceLocationToString(const SourceLocation& loc);
 
   // Retrieves the next node ID to assign to a node in the package and
-  // increments the next node counter. For use in node construction.
-  int64_t GetNextNodeIdAndIncrement() { return next_node_id_++; }
+  // increments the next node counter. For use in node construction. Inside a
+  // ConcurrentTransformScope the counter of the scope is used.
+  int64_t GetNextNodeIdAndIncrement();
 
   // Adds a file to the file-number table and returns its corresponding number.
   // If it already exists, returns the existing file-number entry.
@@ -285,10 +332,11 @@ class Package {
 
   std::vector<std::string> GetFunctionNames() const;
 
-  int64_t next_node_id() const { return next_node_id_; }
+  // Inside a ConcurrentTransformScope these access the counter of the scope.
+  int64_t next_node_id() const;
 
   // Intended for use by the parser when node ids are suggested by the IR text.
-  void set_next_node_id(int64_t value) { next_node_id_ = value; }
+  void set_next_node_id(int64_t value);
 
   // Create a channel. Channels are used with send/receive nodes in communicate
   // between procs or between procs and external (to XLS) components. If no
@@ -444,13 +492,19 @@ class Package {
       Channel* channel, std::string_view name,
       const CloneChannelOverrides& overrides = CloneChannelOverrides());
 
-  // Returns the transform metrics aggregated across all FunctionBases.
+  // Returns the transform metrics aggregated across all FunctionBases. The
+  // mutable accessor returns the metrics of the ConcurrentTransformScope
+  // active on the current thread, if any.
   const TransformMetrics& transform_metrics() const {
     return transform_metrics_;
   }
-  TransformMetrics& transform_metrics() { return transform_metrics_; }
+  TransformMetrics& transform_metrics();
 
  private:
+  // Returns the ConcurrentTransformScope of this package which is active on
+  // the current thread or nullptr if there is none.
+  ConcurrentTransformScope* ActiveTransformScope() const;
+
   std::vector<std::string> GetChannelNames() const;
 
   // Adds the given channel to the package.
@@ -470,6 +524,10 @@ class Package {
   // Ordinal to assign to the next node created in this package.
   int64_t next_node_id_ = 1;
 
+  // Interned values of the literals in this package. Declared before the
+  // functions so it outlives the handles held by their literals.
+  ValuePool value_pool_;
+
   std::vector<std::unique_ptr<Function>> functions_;
   std::vector<std::unique_ptr<Proc>> procs_;
   std::vector<std::unique_ptr<Block>> blocks_;
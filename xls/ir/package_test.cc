@@ -34,6 +34,8 @@
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/source_location.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/ir/xls_type.pb.h"
@@ -1224,5 +1226,40 @@ TEST_F(PackageTest, TransformMetrics) {
   EXPECT_EQ(p->transform_metrics().operands_replaced, 2);
 }
 
+TEST_F(PackageTest, ConcurrentTransformScope) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(x));
+  int64_t next_node_id = p->next_node_id();
+  TransformMetrics metrics = p->transform_metrics();
+
+  {
+    ConcurrentTransformScope scope(p.get(), /*first_node_id=*/100);
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Node * neg, f->MakeNode<UnOp>(SourceInfo(), x.node(), Op::kNeg));
+    EXPECT_EQ(neg->id(), 100);
+    EXPECT_EQ(p->next_node_id(), 101);
+    EXPECT_EQ(scope.next_node_id(), 101);
+    EXPECT_EQ(scope.transform_metrics().nodes_added, 1);
+    XLS_ASSERT_OK(f->set_return_value(neg));
+  }
+
+  // The package-wide state is untouched by the scope.
+  EXPECT_EQ(p->next_node_id(), next_node_id);
+  EXPECT_EQ(p->transform_metrics().nodes_added, metrics.nodes_added);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * literal, f->MakeNode<Literal>(SourceInfo(), Value(UBits(1, 32))));
+  EXPECT_EQ(literal->id(), next_node_id);
+
+  // Channels may not be created inside a scope.
+  ConcurrentTransformScope scope(p.get(), /*first_node_id=*/200);
+  EXPECT_THAT(p->CreateStreamingChannel("ch", ChannelOps::kSendOnly,
+                                        p->GetBitsType(32))
+                  .status(),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("ConcurrentTransformScope")));
+}
+
 }  // namespace
 }  // namespace xls
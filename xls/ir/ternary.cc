@@ -15,7 +15,9 @@
 #include "xls/ir/ternary.h"
 
 #include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <initializer_list>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -109,6 +111,121 @@ absl::StatusOr<TernaryVector> StringToTernaryVector(std::string_view s) {
   return result;
 }
 
+namespace {
+
+// Returns the 64 bits of `bitmap` starting at bit `start`. Bits past the end of
+// the bitmap are zero.
+uint64_t GetWordAt(const InlineBitmap& bitmap, int64_t start) {
+  int64_t word = start / 64;
+  int64_t shift = start % 64;
+  if (word >= bitmap.word_count()) {
+    return 0;
+  }
+  uint64_t result = bitmap.GetWord(word) >> shift;
+  if (shift != 0 && word + 1 < bitmap.word_count()) {
+    result |= bitmap.GetWord(word + 1) << (64 - shift);
+  }
+  return result;
+}
+
+// Ors `bits` into the 64 bits of `bitmap` starting at bit `start`. Bits past
+// the end of the bitmap are dropped.
+void OrWordAt(InlineBitmap& bitmap, int64_t start, uint64_t bits) {
+  int64_t word = start / 64;
+  int64_t shift = start % 64;
+  if (word >= bitmap.word_count()) {
+    return;
+  }
+  bitmap.SetWord(word, bitmap.GetWord(word) | (bits << shift));
+  if (shift != 0 && word + 1 < bitmap.word_count()) {
+    bitmap.SetWord(word + 1,
+                   bitmap.GetWord(word + 1) | (bits >> (64 - shift)));
+  }
+}
+
+}  // namespace
+
+PackedTernaryVector::PackedTernaryVector(
+    std::initializer_list<TernaryValue> values)
+    : PackedTernaryVector(static_cast<int64_t>(values.size())) {
+  int64_t index = 0;
+  for (TernaryValue value : values) {
+    Set(index++, value);
+  }
+}
+
+PackedTernaryVector::PackedTernaryVector(InlineBitmap known,
+                                         InlineBitmap value)
+    : known_(std::move(known)), value_(std::move(value)) {
+  CHECK_EQ(known_.bit_count(), value_.bit_count());
+  value_.Intersect(known_);
+}
+
+/* static */ PackedTernaryVector PackedTernaryVector::FromSpan(
+    TernarySpan span) {
+  static_assert(static_cast<int8_t>(TernaryValue::kKnownZero) == 0 &&
+                static_cast<int8_t>(TernaryValue::kKnownOne) == 1 &&
+                static_cast<int8_t>(TernaryValue::kUnknown) == 2);
+  PackedTernaryVector result(span.size());
+  for (int64_t word = 0; word < result.word_count(); ++word) {
+    TernarySpan chunk = span.subspan(word * 64, 64);
+    uint64_t known = 0;
+    uint64_t value = 0;
+    // Branch-free so the loop can be vectorized: bit 1 of the encoding is the
+    // unknown flag and bit 0 is the value.
+    for (int64_t bit = 0; bit < chunk.size(); ++bit) {
+      uint64_t encoded = static_cast<uint8_t>(chunk[bit]);
+      known |= ((encoded >> 1) ^ 1) << bit;
+      value |= (encoded & 1) << bit;
+    }
+    result.known_.SetWord(word, known);
+    result.value_.SetWord(word, value);
+  }
+  return result;
+}
+
+/* static */ PackedTernaryVector PackedTernaryVector::FromBits(
+    const Bits& bits) {
+  return PackedTernaryVector(InlineBitmap(bits.bit_count(), /*fill=*/true),
+                             bits.bitmap());
+}
+
+TernaryVector PackedTernaryVector::ToVector() const {
+  TernaryVector result(bit_count());
+  TernaryValue* data = result.data();
+  for (int64_t word = 0; word < word_count(); ++word) {
+    uint64_t known = known_.GetWord(word);
+    uint64_t value = value_.GetWord(word);
+    int64_t limit = std::min<int64_t>(64, bit_count() - word * 64);
+    for (int64_t bit = 0; bit < limit; ++bit) {
+      *data++ = static_cast<TernaryValue>(
+          ((((known >> bit) & 1) ^ 1) << 1) | ((value >> bit) & 1));
+    }
+  }
+  return result;
+}
+
+PackedTernaryVector PackedTernaryVector::Slice(int64_t start,
+                                               int64_t width) const {
+  CHECK_GE(start, 0);
+  CHECK_GE(width, 0);
+  CHECK_LE(start + width, bit_count());
+  PackedTernaryVector result(width);
+  for (int64_t word = 0; word < result.word_count(); ++word) {
+    result.known_.SetWord(word, GetWordAt(known_, start + word * 64));
+    result.value_.SetWord(word, GetWordAt(value_, start + word * 64));
+  }
+  return result;
+}
+
+int64_t PackedTernaryVector::NumberOfKnownBits() const {
+  int64_t result = 0;
+  for (int64_t word = 0; word < word_count(); ++word) {
+    result += std::popcount(known_.GetWord(word));
+  }
+  return result;
+}
+
 namespace ternary_ops {
 
 TernaryVector FromKnownBits(const Bits& known_bits,
@@ -325,6 +442,183 @@ TernaryVector BitsToTernary(const Bits& bits) {
   return result;
 }
 
+namespace {
+
+struct KnownAndValue {
+  uint64_t known;
+  uint64_t value;
+};
+
+// Builds a vector by applying `f` to the known and value words of `lhs` and
+// `rhs` one word at a time. `f` is called with (lhs_known, lhs_value,
+// rhs_known, rhs_value).
+template <typename F>
+PackedTernaryVector WordwiseOp(const PackedTernaryVector& lhs,
+                               const PackedTernaryVector& rhs, F f) {
+  CHECK_EQ(lhs.bit_count(), rhs.bit_count());
+  InlineBitmap known(lhs.bit_count());
+  InlineBitmap value(lhs.bit_count());
+  for (int64_t word = 0; word < known.word_count(); ++word) {
+    KnownAndValue result =
+        f(lhs.known().GetWord(word), lhs.value().GetWord(word),
+          rhs.known().GetWord(word), rhs.value().GetWord(word));
+    known.SetWord(word, result.known);
+    value.SetWord(word, result.value & result.known);
+  }
+  return PackedTernaryVector(std::move(known), std::move(value));
+}
+
+// Returns the carry into each bit of a ripple-carry chain where a carry is
+// produced at the bits in `generate` and passed along at the bits in
+// `propagate`. `generate` and `propagate` must be disjoint. `carry` is the
+// carry into bit 0 and is updated to the carry out of bit 63. This is the
+// carry chain of the addition (generate | propagate) + generate.
+uint64_t RippleCarries(uint64_t generate, uint64_t propagate, uint64_t& carry) {
+  uint64_t x = generate | propagate;
+  uint64_t y = generate;
+  uint64_t sum = x + y + carry;
+  carry = ((x & y) | ((x | y) & ~sum)) >> 63;
+  return sum ^ x ^ y;
+}
+
+}  // namespace
+
+PackedTernaryVector And(const PackedTernaryVector& lhs,
+                        const PackedTernaryVector& rhs) {
+  return WordwiseOp(lhs, rhs,
+                    [](uint64_t lhs_known, uint64_t lhs_value,
+                       uint64_t rhs_known, uint64_t rhs_value) {
+                      uint64_t one = lhs_value & rhs_value;
+                      uint64_t zero = (lhs_known & ~lhs_value) |
+                                      (rhs_known & ~rhs_value);
+                      return KnownAndValue{.known = one | zero, .value = one};
+                    });
+}
+
+PackedTernaryVector Or(const PackedTernaryVector& lhs,
+                       const PackedTernaryVector& rhs) {
+  return WordwiseOp(lhs, rhs,
+                    [](uint64_t lhs_known, uint64_t lhs_value,
+                       uint64_t rhs_known, uint64_t rhs_value) {
+                      uint64_t one = lhs_value | rhs_value;
+                      uint64_t zero = (lhs_known & ~lhs_value) &
+                                      (rhs_known & ~rhs_value);
+                      return KnownAndValue{.known = one | zero, .value = one};
+                    });
+}
+
+PackedTernaryVector Xor(const PackedTernaryVector& lhs,
+                        const PackedTernaryVector& rhs) {
+  return WordwiseOp(lhs, rhs,
+                    [](uint64_t lhs_known, uint64_t lhs_value,
+                       uint64_t rhs_known, uint64_t rhs_value) {
+                      return KnownAndValue{.known = lhs_known & rhs_known,
+                                           .value = lhs_value ^ rhs_value};
+                    });
+}
+
+PackedTernaryVector Not(const PackedTernaryVector& input) {
+  InlineBitmap value(input.bit_count());
+  for (int64_t word = 0; word < value.word_count(); ++word) {
+    value.SetWord(word, ~input.value().GetWord(word));
+  }
+  return PackedTernaryVector(input.known(), std::move(value));
+}
+
+PackedTernaryVector Add(const PackedTernaryVector& lhs,
+                        const PackedTernaryVector& rhs) {
+  // Bit-serial evaluation computes each sum bit as a ^ b ^ c and the carry out
+  // as (a & b) | ((a ^ b) & c) with ternary operations. The carry is tracked
+  // as two chains: the bits where it is known to be one and the bits where it
+  // may be one. Each chain is an ordinary carry chain so one integer addition
+  // evaluates it across a whole word.
+  uint64_t carry_one = 0;
+  uint64_t carry_maybe_one = 0;
+  return WordwiseOp(
+      lhs, rhs,
+      [&](uint64_t lhs_known, uint64_t lhs_value, uint64_t rhs_known,
+          uint64_t rhs_value) {
+        uint64_t both_known = lhs_known & rhs_known;
+        uint64_t half_sum_one = both_known & (lhs_value ^ rhs_value);
+        uint64_t half_sum_zero = both_known & ~(lhs_value ^ rhs_value);
+        uint64_t either_zero =
+            (lhs_known & ~lhs_value) | (rhs_known & ~rhs_value);
+        uint64_t carries_one = RippleCarries(lhs_value & rhs_value,
+                                             half_sum_one, carry_one);
+        uint64_t carries_maybe_one =
+            RippleCarries(~either_zero, ~half_sum_zero & either_zero,
+                          carry_maybe_one);
+        return KnownAndValue{
+            .known = both_known & (carries_one | ~carries_maybe_one),
+            .value = lhs_value ^ rhs_value ^ carries_one};
+      });
+}
+
+PackedTernaryVector Intersection(const PackedTernaryVector& lhs,
+                                 const PackedTernaryVector& rhs) {
+  return WordwiseOp(lhs, rhs,
+                    [](uint64_t lhs_known, uint64_t lhs_value,
+                       uint64_t rhs_known, uint64_t rhs_value) {
+                      return KnownAndValue{
+                          .known = lhs_known & rhs_known &
+                                   ~(lhs_value ^ rhs_value),
+                          .value = lhs_value};
+                    });
+}
+
+absl::StatusOr<PackedTernaryVector> Union(const PackedTernaryVector& lhs,
+                                          const PackedTernaryVector& rhs) {
+  CHECK_EQ(lhs.bit_count(), rhs.bit_count());
+  for (int64_t word = 0; word < lhs.word_count(); ++word) {
+    uint64_t conflicts =
+        lhs.known().GetWord(word) & rhs.known().GetWord(word) &
+        (lhs.value().GetWord(word) ^ rhs.value().GetWord(word));
+    if (conflicts != 0) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Incompatible values (mismatch at bit %d); cannot unify %s and %s",
+          word * 64 + std::countr_zero(conflicts), ToString(lhs),
+          ToString(rhs)));
+    }
+  }
+  return WordwiseOp(lhs, rhs,
+                    [](uint64_t lhs_known, uint64_t lhs_value,
+                       uint64_t rhs_known, uint64_t rhs_value) {
+                      return KnownAndValue{.known = lhs_known | rhs_known,
+                                           .value = lhs_value | rhs_value};
+                    });
+}
+
+absl::Status UpdateWithUnion(PackedTernaryVector& lhs,
+                             const PackedTernaryVector& rhs) {
+  XLS_ASSIGN_OR_RETURN(lhs, Union(lhs, rhs));
+  return absl::OkStatus();
+}
+
+void UpdateWithIntersection(PackedTernaryVector& lhs,
+                            const PackedTernaryVector& rhs) {
+  lhs = Intersection(lhs, rhs);
+}
+
+PackedTernaryVector Concat(absl::Span<const PackedTernarySpan> inputs) {
+  int64_t bit_count = 0;
+  for (PackedTernarySpan input : inputs) {
+    bit_count += input.size();
+  }
+  InlineBitmap known(bit_count);
+  InlineBitmap value(bit_count);
+  // The last input holds the least significant bits.
+  int64_t offset = 0;
+  for (auto it = inputs.rbegin(); it != inputs.rend(); ++it) {
+    const PackedTernaryVector& input = it->vector();
+    for (int64_t word = 0; word < input.word_count(); ++word) {
+      OrWordAt(known, offset + word * 64, input.known().GetWord(word));
+      OrWordAt(value, offset + word * 64, input.value().GetWord(word));
+    }
+    offset += input.bit_count();
+  }
+  return PackedTernaryVector(std::move(known), std::move(value));
+}
+
 /* static */ std::vector<int64_t> RealizedTernaryIterator::FindUnknownOffsets(
     TernarySpan span) {
   std::vector<int64_t> result;
@@ -338,6 +632,24 @@ TernaryVector BitsToTernary(const Bits& bits) {
   return result;
 }
 
+/* static */ std::vector<int64_t> RealizedTernaryIterator::FindUnknownOffsets(
+    const PackedTernaryVector& ternary) {
+  std::vector<int64_t> result;
+  result.reserve(ternary.bit_count() - ternary.NumberOfKnownBits());
+  for (int64_t word = 0; word < ternary.word_count(); ++word) {
+    uint64_t unknown = ~ternary.known().GetWord(word);
+    while (unknown != 0) {
+      int64_t offset = word * 64 + std::countr_zero(unknown);
+      if (offset >= ternary.bit_count()) {
+        break;
+      }
+      result.push_back(offset);
+      unknown &= unknown - 1;
+    }
+  }
+  return result;
+}
+
 namespace {
 std::pair<bool, InlineBitmap> IncrementOnOffsets(
     InlineBitmap bm, absl::Span<int64_t const> offsets) {
@@ -17,11 +17,13 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <initializer_list>
 #include <iterator>
 #include <optional>
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "absl/algorithm/container.h"
@@ -31,6 +33,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "xls/common/iterator_range.h"
+#include "xls/data_structures/inline_bitmap.h"
 #include "xls/data_structures/leaf_type_tree.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/value.h"
@@ -70,6 +73,121 @@ inline std::ostream& operator<<(std::ostream& os, TernarySpan vector) {
   return os;
 }
 
+// A ternary vector packed into two bitmaps. `known` has a one for each bit
+// whose value is known and `value` holds the values of the known bits. Bits of
+// `value` which are not known are always zero so equal vectors have equal
+// bitmaps. A TernaryVector uses a byte per bit; the operations on packed
+// vectors in ternary_ops instead process 64 bits at a time.
+class PackedTernaryVector {
+ public:
+  // Creates an all-unknown vector of the given width.
+  explicit PackedTernaryVector(int64_t bit_count = 0)
+      : known_(bit_count), value_(bit_count) {}
+
+  // Creates a vector of the given width with every bit set to `fill`.
+  PackedTernaryVector(int64_t bit_count, TernaryValue fill)
+      : known_(bit_count, /*fill=*/fill != TernaryValue::kUnknown),
+        value_(bit_count, /*fill=*/fill == TernaryValue::kKnownOne) {}
+
+  // Creates a vector holding `values` with element 0 as the least significant
+  // bit, like the equivalent TernaryVector.
+  PackedTernaryVector(std::initializer_list<TernaryValue> values);
+
+  // Creates a vector from the given masks. Bits of `value` which are not set
+  // in `known` are ignored. CHECK fails if the widths differ.
+  PackedTernaryVector(InlineBitmap known, InlineBitmap value);
+
+  static PackedTernaryVector FromSpan(TernarySpan span);
+
+  // Returns a fully known vector with the value of `bits`.
+  static PackedTernaryVector FromBits(const Bits& bits);
+
+  TernaryVector ToVector() const;
+
+  int64_t bit_count() const { return known_.bit_count(); }
+  int64_t word_count() const { return known_.word_count(); }
+
+  // Read accessors with the names used by TernaryVector so code can be written
+  // generically over both.
+  int64_t size() const { return bit_count(); }
+  bool empty() const { return bit_count() == 0; }
+  TernaryValue operator[](int64_t index) const { return Get(index); }
+
+  const InlineBitmap& known() const { return known_; }
+  const InlineBitmap& value() const { return value_; }
+
+  TernaryValue Get(int64_t index) const {
+    if (!known_.Get(index)) {
+      return TernaryValue::kUnknown;
+    }
+    return value_.Get(index) ? TernaryValue::kKnownOne
+                             : TernaryValue::kKnownZero;
+  }
+  void Set(int64_t index, TernaryValue value) {
+    known_.Set(index, value != TernaryValue::kUnknown);
+    value_.Set(index, value == TernaryValue::kKnownOne);
+  }
+
+  // Returns the `width` bits starting at bit `start`.
+  PackedTernaryVector Slice(int64_t start, int64_t width) const;
+
+  bool IsFullyKnown() const { return known_.IsAllOnes(); }
+  bool AllUnknown() const { return known_.IsAllZeroes(); }
+  bool IsKnownOne() const { return value_.IsAllOnes(); }
+  bool IsKnownZero() const {
+    return known_.IsAllOnes() && value_.IsAllZeroes();
+  }
+  int64_t NumberOfKnownBits() const;
+
+  bool operator==(const PackedTernaryVector& other) const {
+    return known_ == other.known_ && value_ == other.value_;
+  }
+  bool operator!=(const PackedTernaryVector& other) const {
+    return !(*this == other);
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const PackedTernaryVector& v) {
+    return H::combine(std::move(h), v.known_, v.value_);
+  }
+
+ private:
+  InlineBitmap known_;
+  InlineBitmap value_;
+};
+
+// A reference to a PackedTernaryVector. It plays the role TernarySpan plays for
+// TernaryVector: it is cheap to copy and is implicitly created from a vector.
+// The referenced vector must outlive it.
+class PackedTernarySpan {
+ public:
+  PackedTernarySpan(const PackedTernaryVector& vector)  // NOLINT
+      : vector_(&vector) {}
+
+  operator const PackedTernaryVector&() const {  // NOLINT
+    return *vector_;
+  }
+  const PackedTernaryVector& vector() const { return *vector_; }
+
+  int64_t size() const { return vector_->size(); }
+  bool empty() const { return vector_->empty(); }
+  TernaryValue operator[](int64_t index) const { return vector_->Get(index); }
+  TernaryValue back() const { return vector_->Get(size() - 1); }
+
+ private:
+  const PackedTernaryVector* vector_;
+};
+
+inline std::string ToString(const PackedTernaryVector& value) {
+  return ToString(value.ToVector());
+}
+
+inline std::ostream& operator<<(std::ostream& os,
+                                const PackedTernaryVector& vector) {
+  os << ToString(vector);
+  return os;
+}
+
 namespace ternary_ops {
 
 // Returns a vector with known bits as represented in `known_bits`, with values
@@ -175,6 +293,47 @@ inline TernaryValue Or(const TernaryValue& a, const TernaryValue& b) {
 
 TernaryVector BitsToTernary(const Bits& bits);
 
+// Word-wide operations on packed ternary vectors. Each produces the same result
+// as applying the corresponding BitSerialTernaryEvaluator operation bit by bit.
+// CHECK fails if the operands have different widths.
+PackedTernaryVector And(const PackedTernaryVector& lhs,
+                        const PackedTernaryVector& rhs);
+PackedTernaryVector Or(const PackedTernaryVector& lhs,
+                       const PackedTernaryVector& rhs);
+PackedTernaryVector Xor(const PackedTernaryVector& lhs,
+                        const PackedTernaryVector& rhs);
+PackedTernaryVector Not(const PackedTernaryVector& input);
+
+// Returns the sum of `lhs` and `rhs` truncated to their width. The carry chain
+// is evaluated a word at a time with integer additions.
+PackedTernaryVector Add(const PackedTernaryVector& lhs,
+                        const PackedTernaryVector& rhs);
+
+// Packed equivalents of the span-based Intersection and Union above.
+PackedTernaryVector Intersection(const PackedTernaryVector& lhs,
+                                 const PackedTernaryVector& rhs);
+absl::StatusOr<PackedTernaryVector> Union(const PackedTernaryVector& lhs,
+                                          const PackedTernaryVector& rhs);
+absl::Status UpdateWithUnion(PackedTernaryVector& lhs,
+                             const PackedTernaryVector& rhs);
+void UpdateWithIntersection(PackedTernaryVector& lhs,
+                            const PackedTernaryVector& rhs);
+
+// Returns the concatenation of `inputs`. The first input holds the most
+// significant bits, as with bits_ops::Concat.
+PackedTernaryVector Concat(absl::Span<const PackedTernarySpan> inputs);
+
+inline bool IsFullyKnown(const PackedTernaryVector& ternary) {
+  return ternary.IsFullyKnown();
+}
+inline bool AllUnknown(const PackedTernaryVector& v) { return v.AllUnknown(); }
+inline bool IsKnownOne(const PackedTernaryVector& ternary) {
+  return ternary.IsKnownOne();
+}
+inline bool IsKnownZero(const PackedTernaryVector& ternary) {
+  return ternary.IsKnownZero();
+}
+
 // An iterator of possible ternary values.
 class RealizedTernaryIterator {
  public:
@@ -260,10 +419,17 @@ class RealizedTernaryIterator {
         value_(ToKnownBitsValues(span)),
         unknown_bit_offsets_(
             RealizedTernaryIterator::FindUnknownOffsets(span)) {}
+  explicit RealizedTernaryIterator(const PackedTernaryVector& ternary)
+      : finished_(false),
+        value_(Bits::FromBitmap(ternary.value())),
+        unknown_bit_offsets_(
+            RealizedTernaryIterator::FindUnknownOffsets(ternary)) {}
 
   void Advance(int64_t amnt);
   void Advance(const Bits& amnt);
   static std::vector<int64_t> FindUnknownOffsets(TernarySpan span);
+  static std::vector<int64_t> FindUnknownOffsets(
+      const PackedTernaryVector& ternary);
 
   bool finished_;
   Bits value_;
@@ -271,6 +437,8 @@ class RealizedTernaryIterator {
 
   friend xabsl::iterator_range<RealizedTernaryIterator> AllBitsValues(
       TernarySpan span);
+  friend xabsl::iterator_range<RealizedTernaryIterator> AllBitsValues(
+      PackedTernarySpan ternary);
 };
 
 // Make an iterator range that enumerates all possible values which match the
@@ -283,6 +451,11 @@ inline xabsl::iterator_range<RealizedTernaryIterator> AllBitsValues(
   static_assert(std::forward_iterator<RealizedTernaryIterator>);
   return {RealizedTernaryIterator(span), RealizedTernaryIterator()};
 }
+inline xabsl::iterator_range<RealizedTernaryIterator> AllBitsValues(
+    PackedTernarySpan ternary) {
+  return {RealizedTernaryIterator(ternary.vector()),
+          RealizedTernaryIterator()};
+}
 
 // Make an iterator range that enumerates all possible values which match the
 // given tree of ternaries. The values are produced in order from smallest to
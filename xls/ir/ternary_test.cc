@@ -15,17 +15,22 @@
 #include "xls/ir/ternary.h"
 
 #include <cstdint>
+#include <iterator>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "xls/common/iterator_range.h"
 #include "xls/common/status/matchers.h"
+#include "xls/data_structures/inline_bitmap.h"
 #include "xls/data_structures/leaf_type_tree.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/bits_ops.h"
@@ -75,6 +80,133 @@ TEST(Ternary, NumberOfKnownBits) {
   EXPECT_EQ(ternary_ops::NumberOfKnownBits(TernaryVector()), 0);
 }
 
+TEST(Ternary, PackedTernaryVectorRoundTrip) {
+  for (std::string_view s : {"0b", "0b1", "0bX", "0b1101X1X001",
+                             "0bX1X0_1111_0000_XXXX_1010_0101_X0X1_1X1X_0000_"
+                             "1111_XXXX_0101_1010_X0X0_1X1X_0101_X"}) {
+    TernaryVector vector = *StringToTernaryVector(s);
+    PackedTernaryVector packed = PackedTernaryVector::FromSpan(vector);
+    EXPECT_EQ(packed.bit_count(), vector.size());
+    EXPECT_EQ(packed.ToVector(), vector) << s;
+    EXPECT_EQ(packed.NumberOfKnownBits(),
+              ternary_ops::NumberOfKnownBits(vector));
+    EXPECT_EQ(packed.IsFullyKnown(), ternary_ops::IsFullyKnown(vector));
+    EXPECT_EQ(packed.AllUnknown(), ternary_ops::AllUnknown(vector));
+    for (int64_t i = 0; i < vector.size(); ++i) {
+      EXPECT_EQ(packed.Get(i), vector[i]);
+    }
+  }
+  EXPECT_EQ(PackedTernaryVector::FromBits(UBits(0b1011, 4)).ToVector(),
+            *StringToTernaryVector("0b1011"));
+  EXPECT_EQ(PackedTernaryVector(3).ToVector(), *StringToTernaryVector("0bXXX"));
+}
+
+TEST(Ternary, PackedTernaryVectorIgnoresUnknownValueBits) {
+  PackedTernaryVector a(InlineBitmap::FromWord(0b0011, 4),
+                        InlineBitmap::FromWord(0b1110, 4));
+  PackedTernaryVector b(InlineBitmap::FromWord(0b0011, 4),
+                        InlineBitmap::FromWord(0b0010, 4));
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(ToString(a), "0bXX10");
+
+  a.Set(3, TernaryValue::kKnownOne);
+  a.Set(0, TernaryValue::kUnknown);
+  EXPECT_EQ(ToString(a), "0b1X1X");
+}
+
+TEST(Ternary, PackedOps) {
+  auto packed = [](std::string_view s) {
+    return PackedTernaryVector::FromSpan(*StringToTernaryVector(s));
+  };
+  EXPECT_EQ(ToString(ternary_ops::And(packed("0b111XXX000"),
+                                      packed("0b0X10X10X1"))),
+            "0b0_X10X_X000");
+  EXPECT_EQ(ToString(ternary_ops::Or(packed("0b111XXX000"),
+                                     packed("0b0X10X10X1"))),
+            "0b1_11XX_10X1");
+  EXPECT_EQ(ToString(ternary_ops::Xor(packed("0b111XXX000"),
+                                      packed("0b0X10X10X1"))),
+            "0b1_X0XX_X0X1");
+  EXPECT_EQ(ToString(ternary_ops::Not(packed("0b1X0"))), "0b0X1");
+  EXPECT_EQ(ToString(ternary_ops::Add(packed("0b0011"), packed("0b0001"))),
+            "0b0100");
+  EXPECT_EQ(ToString(ternary_ops::Add(packed("0b0X11"), packed("0b0001"))),
+            "0bXX00");
+  EXPECT_EQ(ToString(ternary_ops::Add(packed("0b000X"), packed("0b0001"))),
+            "0b00XX");
+  EXPECT_EQ(ToString(ternary_ops::Add(packed("0b1111"), packed("0b0001"))),
+            "0b0000");
+}
+
+TEST(Ternary, PackedIntersectionAndUnion) {
+  auto packed = [](std::string_view s) {
+    return PackedTernaryVector::FromSpan(*StringToTernaryVector(s));
+  };
+  EXPECT_EQ(ternary_ops::Intersection(packed("0b1101X1X001"),
+                                      packed("0b0X01X1X00X")),
+            packed("0bXX01X1X00X"));
+  EXPECT_THAT(
+      ternary_ops::Union(packed("0b1101X1X0XX"), packed("0bXX01X11X01")),
+      IsOkAndHolds(packed("0b1101X11001")));
+  EXPECT_THAT(ternary_ops::Union(packed("0b10"), packed("0b11")),
+              absl_testing::StatusIs(absl::StatusCode::kInvalidArgument));
+
+  PackedTernaryVector v = packed("0b1101X1X0XX");
+  XLS_EXPECT_OK(ternary_ops::UpdateWithUnion(v, packed("0bXX01X11X01")));
+  EXPECT_EQ(v, packed("0b1101X11001"));
+  ternary_ops::UpdateWithIntersection(v, packed("0b0101X11000"));
+  EXPECT_EQ(v, packed("0bX101X1100X"));
+}
+
+TEST(Ternary, PackedSliceAndConcat) {
+  // Widths which are not multiples of 64 so slices and concatenations cross
+  // word boundaries at varying offsets.
+  std::string wide = "0b";
+  for (int64_t i = 0; i < 150; ++i) {
+    wide += "01X1X"[(i * 7 + i / 3) % 5];
+  }
+  TernaryVector vector = *StringToTernaryVector(wide);
+  PackedTernaryVector packed = PackedTernaryVector::FromSpan(vector);
+  for (int64_t start : {0, 1, 63, 64, 70, 149}) {
+    for (int64_t width : {0, 1, 64, 65, 80}) {
+      if (start + width > vector.size()) {
+        continue;
+      }
+      EXPECT_EQ(packed.Slice(start, width).ToVector(),
+                TernaryVector(vector.begin() + start,
+                              vector.begin() + start + width))
+          << start << ", " << width;
+    }
+  }
+
+  PackedTernaryVector a = packed.Slice(0, 3);
+  PackedTernaryVector b = packed.Slice(5, 70);
+  PackedTernaryVector c = packed.Slice(80, 61);
+  TernaryVector expected = c.ToVector();
+  absl::c_copy(b.ToVector(), std::back_inserter(expected));
+  absl::c_copy(a.ToVector(), std::back_inserter(expected));
+  EXPECT_EQ(ternary_ops::Concat({a, b, c}).ToVector(), expected);
+  EXPECT_EQ(ternary_ops::Concat({}).bit_count(), 0);
+}
+
+TEST(Ternary, PackedConstructorsAndPredicates) {
+  EXPECT_EQ(ToString(PackedTernaryVector(
+                {TernaryValue::kKnownZero, TernaryValue::kUnknown,
+                 TernaryValue::kKnownOne})),
+            "0b1X0");
+  EXPECT_EQ(ToString(PackedTernaryVector(3, TernaryValue::kKnownOne)), "0b111");
+  EXPECT_EQ(ToString(PackedTernaryVector(3, TernaryValue::kUnknown)), "0bXXX");
+
+  EXPECT_TRUE(ternary_ops::IsKnownOne(
+      PackedTernaryVector(70, TernaryValue::kKnownOne)));
+  EXPECT_TRUE(ternary_ops::IsKnownZero(
+      PackedTernaryVector(70, TernaryValue::kKnownZero)));
+  EXPECT_FALSE(ternary_ops::IsKnownZero(
+      PackedTernaryVector(70, TernaryValue::kUnknown)));
+  EXPECT_TRUE(
+      ternary_ops::AllUnknown(PackedTernaryVector(70, TernaryValue::kUnknown)));
+}
+
 MATCHER_P(ToVector, m,
           testing::DescribeMatcher<std::vector<Bits>>(m, negation)) {
   return testing::ExplainMatchResult(
@@ -105,6 +237,14 @@ TEST(TernaryIterator, Iterate) {
   EXPECT_THAT(++it, range.end());
 }
 
+TEST(TernaryIterator, IteratePacked) {
+  PackedTernaryVector ternary =
+      PackedTernaryVector::FromSpan(*StringToTernaryVector("0bX0X1"));
+  EXPECT_THAT(ternary_ops::AllBitsValues(ternary),
+              IteratorElementsAre(UBits(0b0001, 4), UBits(0b0011, 4),
+                                  UBits(0b1001, 4), UBits(0b1011, 4)));
+}
+
 // Instructions treat a 0-bit value as a thing that exists so ternary should as
 // well.
 TEST(TernaryIterator, IterateZeroLength) {
@@ -24,6 +24,7 @@
 #include "absl/container/inlined_vector.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
@@ -31,6 +32,8 @@
 
 namespace xls {
 
+// Owns the types of a package. Types are created on first request and are
+// never destroyed. All methods are thread-safe.
 class TypeManager {
  public:
   explicit TypeManager();
@@ -42,9 +45,11 @@ class TypeManager {
   TypeManager& operator=(const TypeManager&) = delete;
   // Returns whether the given type is one of the types owned by this package.
   bool IsOwnedType(const Type* type) const {
+    absl::ReaderMutexLock lock(mutex_.get());
     return owned_types_.find(type) != owned_types_.end();
   }
   bool IsOwnedFunctionType(const FunctionType* function_type) const {
+    absl::ReaderMutexLock lock(mutex_.get());
     return owned_function_types_.find(function_type) !=
            owned_function_types_.end();
   }
@@ -67,6 +72,11 @@ class TypeManager {
   Type* GetTypeForValue(const Value& value);
 
  private:
+  // Guards the members below except `token_type_`. Types are looked up under a
+  // reader lock and created under a writer lock. Held by pointer so the type
+  // manager remains movable.
+  std::unique_ptr<absl::Mutex> mutex_ = std::make_unique<absl::Mutex>();
+
   // Set of owned types in this package.
   absl::flat_hash_set<const Type*> owned_types_;
 
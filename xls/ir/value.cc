@@ -253,7 +253,7 @@ void Value::FlattenTo(BitPushBuffer* buffer) const {
 }
 
 absl::StatusOr<std::vector<Value>> Value::GetElements() const {
-  if (!std::holds_alternative<std::vector<Value>>(payload_)) {
+  if (!std::holds_alternative<Elements>(payload_)) {
     return absl::InvalidArgumentError("Value does not hold elements.");
   }
   return std::vector<Value>(elements().begin(), elements().end());
@@ -467,6 +467,14 @@ bool Value::operator==(const Value& other) const {
     return bits() == other.bits();
   }
 
+  // Aggregates which share their element storage are trivially equal.
+  const Elements* lhs_elements = std::get_if<Elements>(&payload_);
+  const Elements* rhs_elements = std::get_if<Elements>(&other.payload_);
+  if (lhs_elements != nullptr && rhs_elements != nullptr &&
+      *lhs_elements == *rhs_elements) {
+    return true;
+  }
+
   // All non-Bits types are container types -- should have a size attribute.
   if (size() != other.size()) {
     return false;
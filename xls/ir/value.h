@@ -17,6 +17,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -62,13 +63,16 @@ inline std::ostream& operator<<(std::ostream& os, ValueKind kind) {
 //
 // TODO(leary): 2019-04-04 Arrays are not currently multi-dimensional, we had
 // some discussion around this, maybe they should be?
+//
+// The elements of tuples and arrays are immutable and shared between copies of
+// a Value so copying an aggregate is constant time regardless of its size.
 class Value {
  public:
   static Value Tuple(absl::Span<const Value> elements) {
     return Value(ValueKind::kTuple, elements);
   }
   static Value TupleOwned(std::vector<Value>&& elements) {
-    return Value(ValueKind::kTuple, elements);
+    return Value(ValueKind::kTuple, std::move(elements));
   }
 
   // All members of "elements" must be of the same type, or an error status will
@@ -107,7 +111,7 @@ class Value {
   }
 
   static Value Token() {
-    return Value(ValueKind::kToken, std::vector<Value>({}));
+    return Value(ValueKind::kToken, Elements());
   }
   static Value Bool(bool enabled) {
     return Value(
@@ -146,7 +150,11 @@ class Value {
   absl::StatusOr<std::vector<Value>> GetElements() const;
 
   absl::Span<const Value> elements() const {
-    return std::get<std::vector<Value>>(payload_);
+    const Elements& elements = std::get<Elements>(payload_);
+    if (elements == nullptr) {
+      return {};
+    }
+    return *elements;
   }
   const Value& element(int64_t i) const { return elements().at(i); }
   int64_t size() const { return elements().size(); }
@@ -193,19 +201,43 @@ class Value {
 
   template <typename H>
   friend H AbslHashValue(H h, const Value& v) {
-    return H::combine(std::move(h), v.kind_, v.payload_);
+    if (v.IsBits()) {
+      return H::combine(std::move(h), v.kind_, v.bits());
+    }
+    if (!std::holds_alternative<Elements>(v.payload_)) {
+      return H::combine(std::move(h), v.kind_);
+    }
+    // Hash the contents rather than the (shared) storage so equal values hash
+    // equal.
+    absl::Span<const Value> elements = v.elements();
+    return H::combine(H::combine_contiguous(H::combine(std::move(h), v.kind_),
+                                            elements.data(), elements.size()),
+                      elements.size());
   }
 
  private:
+  // Immutable element storage of a tuple, array or token. Empty aggregates and
+  // tokens hold a null pointer to avoid an allocation.
+  using Elements = std::shared_ptr<const std::vector<Value>>;
+
+  Value(ValueKind kind, Elements elements)
+      : kind_(kind), payload_(std::move(elements)) {}
+
   Value(ValueKind kind, absl::Span<const Value> elements)
       : kind_(kind),
-        payload_(std::vector<Value>(elements.begin(), elements.end())) {}
+        payload_(elements.empty()
+                     ? Elements()
+                     : std::make_shared<const std::vector<Value>>(
+                           elements.begin(), elements.end())) {}
 
   Value(ValueKind kind, std::vector<Value>&& elements)
-      : kind_(kind), payload_(std::move(elements)) {}
+      : kind_(kind),
+        payload_(elements.empty() ? Elements()
+                                  : std::make_shared<const std::vector<Value>>(
+                                        std::move(elements))) {}
 
   ValueKind kind_;
-  std::variant<std::nullptr_t, std::vector<Value>, Bits> payload_;
+  std::variant<std::nullptr_t, Elements, Bits> payload_;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Value& value) {
@@ -0,0 +1,98 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/ir/value_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "absl/hash/hash.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+void InternedValue::Release() {
+  if (entry_ == nullptr) {
+    return;
+  }
+  // Once the count is decremented the entry may be freed by another thread so
+  // everything needed to find it again is read first.
+  State* state = entry_->state;
+  size_t hash = entry_->hash;
+  const Entry* entry = entry_;
+  entry_ = nullptr;
+  if (entry->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    ValuePool::MaybeErase(state, entry, hash);
+  }
+}
+
+const InternedValue::Entry* ValuePool::Find(const Value& value,
+                                            size_t hash) const {
+  absl::ReaderMutexLock lock(&state_->mutex);
+  auto it = state_->entries.find(State::ValueKey{.value = value, .hash = hash});
+  if (it == state_->entries.end()) {
+    return nullptr;
+  }
+  // Entries are only erased while holding the lock exclusively so the entry
+  // cannot be erased before the new reference is taken.
+  (*it)->ref_count.fetch_add(1, std::memory_order_relaxed);
+  return it->get();
+}
+
+InternedValue ValuePool::Insert(Value value, size_t hash) {
+  absl::MutexLock lock(&state_->mutex);
+  auto it = state_->entries.find(State::ValueKey{.value = value, .hash = hash});
+  if (it != state_->entries.end()) {
+    (*it)->ref_count.fetch_add(1, std::memory_order_relaxed);
+    return InternedValue(it->get());
+  }
+  auto entry = std::make_unique<Entry>(std::move(value), hash, state_.get());
+  const Entry* result = entry.get();
+  state_->entries.insert(std::move(entry));
+  return InternedValue(result);
+}
+
+/* static */ void ValuePool::MaybeErase(State* state, const Entry* entry,
+                                        size_t hash) {
+  absl::MutexLock lock(&state->mutex);
+  // The entry may have been interned again, or interned again and released
+  // and erased by another thread, since its count dropped to zero.
+  auto it = state->entries.find(State::EntryKey{.entry = entry, .hash = hash});
+  if (it != state->entries.end() &&
+      (*it)->ref_count.load(std::memory_order_acquire) == 0) {
+    state->entries.erase(it);
+  }
+}
+
+InternedValue ValuePool::Intern(const Value& value) {
+  size_t hash = absl::HashOf(value);
+  if (const Entry* entry = Find(value, hash)) {
+    return InternedValue(entry);
+  }
+  return Insert(value, hash);
+}
+
+InternedValue ValuePool::Intern(Value&& value) {
+  size_t hash = absl::HashOf(value);
+  if (const Entry* entry = Find(value, hash)) {
+    return InternedValue(entry);
+  }
+  return Insert(std::move(value), hash);
+}
+
+}  // namespace xls
@@ -0,0 +1,191 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_IR_VALUE_POOL_H_
+#define XLS_IR_VALUE_POOL_H_
+
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+class ValuePool;
+
+// An immutable, reference-counted handle to a Value interned in a ValuePool.
+// The hash of the value is computed once when it is interned. Handles from the
+// same pool compare equal if and only if their values are equal, so equality
+// and hashing of handles are O(1) regardless of the size of the value. The
+// entry of a value is removed from the pool when its last handle is destroyed.
+// Handles must not outlive the pool which created them.
+class InternedValue {
+ public:
+  InternedValue(const InternedValue& other) : entry_(other.entry_) {
+    entry_->ref_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  InternedValue(InternedValue&& other) : entry_(other.entry_) {
+    other.entry_ = nullptr;
+  }
+  InternedValue& operator=(InternedValue other) {
+    std::swap(entry_, other.entry_);
+    return *this;
+  }
+  ~InternedValue() { Release(); }
+
+  const Value& value() const { return entry_->value; }
+  size_t hash() const { return entry_->hash; }
+
+  // Handles may only be compared if they were created by the same pool.
+  bool operator==(const InternedValue& other) const {
+    return entry_ == other.entry_;
+  }
+  bool operator!=(const InternedValue& other) const {
+    return !(*this == other);
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const InternedValue& v) {
+    return H::combine(std::move(h), v.entry_->hash);
+  }
+
+ private:
+  friend class ValuePool;
+
+  struct State;
+  struct Entry {
+    Entry(Value value, size_t hash, State* state)
+        : value(std::move(value)), hash(hash), state(state) {}
+
+    const Value value;
+    const size_t hash;
+    // The pool state holding this entry.
+    State* const state;
+    // Number of handles of this entry. An entry whose count drops to zero is
+    // removed unless it is interned again first.
+    mutable std::atomic<int64_t> ref_count = 1;
+  };
+
+  // Takes ownership of a reference to `entry`.
+  explicit InternedValue(const Entry* entry) : entry_(entry) {}
+
+  void Release();
+
+  // Null for moved-from handles.
+  const Entry* entry_;
+};
+
+// The entries of a ValuePool.
+struct InternedValue::State {
+  // A value to look up along with its precomputed hash.
+  struct ValueKey {
+    const Value& value;
+    size_t hash;
+  };
+  // An entry to look up by address, without dereferencing it.
+  struct EntryKey {
+    const Entry* entry;
+    size_t hash;
+  };
+
+  // Hash and equality functors which allow entries to be looked up by key
+  // without constructing an entry or rehashing the value.
+  struct EntryHash {
+    using is_transparent = void;
+    size_t operator()(const std::unique_ptr<Entry>& entry) const {
+      return entry->hash;
+    }
+    size_t operator()(const ValueKey& key) const { return key.hash; }
+    size_t operator()(const EntryKey& key) const { return key.hash; }
+  };
+  struct EntryEq {
+    using is_transparent = void;
+    bool operator()(const std::unique_ptr<Entry>& a,
+                    const std::unique_ptr<Entry>& b) const {
+      return a == b;
+    }
+    bool operator()(const std::unique_ptr<Entry>& a, const ValueKey& b) const {
+      return a->hash == b.hash && a->value == b.value;
+    }
+    bool operator()(const ValueKey& a, const std::unique_ptr<Entry>& b) const {
+      return (*this)(b, a);
+    }
+    bool operator()(const std::unique_ptr<Entry>& a, const EntryKey& b) const {
+      return a.get() == b.entry;
+    }
+    bool operator()(const EntryKey& a, const std::unique_ptr<Entry>& b) const {
+      return (*this)(b, a);
+    }
+  };
+
+  absl::Mutex mutex;
+  // Entries are heap allocated for pointer stability.
+  absl::flat_hash_set<std::unique_ptr<Entry>, EntryHash, EntryEq> entries
+      ABSL_GUARDED_BY(mutex);
+};
+
+// A pool of interned Values. Each distinct value is stored once no matter how
+// many times it is interned and is freed when no handle of it remains. Each
+// Package owns a pool which holds the values of its literals. All methods are
+// thread-safe.
+class ValuePool {
+ public:
+  ValuePool() = default;
+
+  // Value pool is move-only. Handles remain valid when the pool is moved.
+  ValuePool(ValuePool&&) = default;
+  ValuePool& operator=(ValuePool&&) = default;
+  ValuePool(const ValuePool&) = delete;
+  ValuePool& operator=(const ValuePool&) = delete;
+
+  // Returns the handle of the interned value equal to `value`, adding it to the
+  // pool if it is not already present.
+  InternedValue Intern(const Value& value);
+  InternedValue Intern(Value&& value);
+
+  // Returns the number of distinct values in the pool.
+  int64_t size() const {
+    absl::ReaderMutexLock lock(&state_->mutex);
+    return state_->entries.size();
+  }
+
+ private:
+  friend class InternedValue;
+  using Entry = InternedValue::Entry;
+  using State = InternedValue::State;
+
+  // Returns a new reference to the existing entry equal to `value` if there is
+  // one.
+  const Entry* Find(const Value& value, size_t hash) const;
+  // Adds a new entry unless an equal entry was added concurrently since the
+  // caller's Find.
+  InternedValue Insert(Value value, size_t hash);
+  // Removes `entry` if it is still in the pool and has no handles. `entry` may
+  // already have been freed so it is only dereferenced if it is found.
+  static void MaybeErase(State* state, const Entry* entry, size_t hash);
+
+  // Heap allocated so entries can refer to it across moves of the pool.
+  std::unique_ptr<State> state_ = std::make_unique<State>();
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_VALUE_POOL_H_
@@ -0,0 +1,127 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/ir/value_pool.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
+#include "xls/common/thread.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+Value MakeTable(int64_t size, int64_t seed) {
+  std::vector<Value> elements;
+  for (int64_t i = 0; i < size; ++i) {
+    elements.push_back(Value(UBits((i * 7 + seed) % 256, 1024)));
+  }
+  return Value::ArrayOwned(std::move(elements));
+}
+
+TEST(ValuePoolTest, EqualValuesShareAnEntry) {
+  ValuePool pool;
+  InternedValue a = pool.Intern(Value(UBits(42, 32)));
+  InternedValue b = pool.Intern(Value(UBits(42, 32)));
+  InternedValue c = pool.Intern(Value(UBits(42, 33)));
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  EXPECT_EQ(&a.value(), &b.value());
+  EXPECT_EQ(a.value(), Value(UBits(42, 32)));
+  EXPECT_EQ(a.hash(), absl::HashOf(Value(UBits(42, 32))));
+  EXPECT_EQ(pool.size(), 2);
+}
+
+TEST(ValuePoolTest, AggregatesWithDistinctStorage) {
+  ValuePool pool;
+  // Equal tables built separately do not share storage but intern to the same
+  // entry.
+  InternedValue a = pool.Intern(MakeTable(64, 1));
+  InternedValue b = pool.Intern(MakeTable(64, 1));
+  InternedValue c = pool.Intern(MakeTable(64, 2));
+  InternedValue d = pool.Intern(Value::Tuple({MakeTable(64, 1)}));
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  EXPECT_NE(a, d);
+  EXPECT_EQ(pool.size(), 3);
+}
+
+TEST(ValuePoolTest, HandlesAreHashable) {
+  ValuePool pool;
+  absl::flat_hash_set<InternedValue> set;
+  for (int64_t i = 0; i < 100; ++i) {
+    set.insert(pool.Intern(Value(UBits(i % 10, 8))));
+  }
+  EXPECT_EQ(set.size(), 10);
+  EXPECT_EQ(pool.size(), 10);
+}
+
+TEST(ValuePoolTest, HandlesSurviveGrowth) {
+  ValuePool pool;
+  InternedValue first = pool.Intern(Value(UBits(0, 16)));
+  for (int64_t i = 1; i < 1000; ++i) {
+    pool.Intern(Value(UBits(i, 16)));
+  }
+  EXPECT_EQ(first.value(), Value(UBits(0, 16)));
+  EXPECT_EQ(first, pool.Intern(Value(UBits(0, 16))));
+}
+
+TEST(ValuePoolTest, EntriesAreFreedWithTheirLastHandle) {
+  ValuePool pool;
+  InternedValue a = pool.Intern(MakeTable(64, 1));
+  {
+    InternedValue b = pool.Intern(MakeTable(64, 2));
+    InternedValue b_copy = b;
+    EXPECT_EQ(pool.size(), 2);
+  }
+  EXPECT_EQ(pool.size(), 1);
+
+  // Moved handles keep the entry alive.
+  InternedValue moved = std::move(a);
+  EXPECT_EQ(pool.size(), 1);
+  EXPECT_EQ(moved, pool.Intern(MakeTable(64, 1)));
+  moved = pool.Intern(MakeTable(64, 3));
+  EXPECT_EQ(pool.size(), 1);
+  EXPECT_EQ(moved.value(), MakeTable(64, 3));
+}
+
+TEST(ValuePoolTest, ConcurrentInternAndRelease) {
+  ValuePool pool;
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int64_t t = 0; t < 4; ++t) {
+    threads.push_back(std::make_unique<Thread>([&pool]() {
+      for (int64_t i = 0; i < 10000; ++i) {
+        InternedValue a = pool.Intern(Value(UBits(i % 3, 8)));
+        InternedValue b = pool.Intern(Value(UBits(i % 3, 8)));
+        EXPECT_EQ(a, b);
+      }
+    }));
+  }
+  for (std::unique_ptr<Thread>& thread : threads) {
+    thread->Join();
+  }
+  EXPECT_EQ(pool.size(), 0);
+}
+
+}  // namespace
+}  // namespace xls
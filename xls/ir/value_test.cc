@@ -16,13 +16,17 @@
 
 #include <cstdint>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "xls/common/fuzzing/fuzztest.h"
+#include "absl/hash/hash.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/types/span.h"
+#include "benchmark/benchmark.h"
 #include "google/protobuf/text_format.h"
 #include "xls/common/proto_test_utils.h"
 #include "xls/common/status/matchers.h"
@@ -685,6 +689,36 @@ TEST(ValueTest, FromProtoMaxBitSize) {
   }
 }
 
+TEST(ValueTest, CopiesShareElements) {
+  Value tuple = Value::Tuple({Value(UBits(1, 8)), Value(UBits(2, 16))});
+  Value array = Value::ArrayOrDie({tuple, tuple, tuple});
+  Value copy = array;
+  EXPECT_EQ(copy.elements().data(), array.elements().data());
+  EXPECT_EQ(copy, array);
+  EXPECT_EQ(absl::HashOf(copy), absl::HashOf(array));
+
+  // Structurally equal values with distinct storage compare and hash equal.
+  Value rebuilt = Value::ArrayOrDie(
+      {Value::Tuple({Value(UBits(1, 8)), Value(UBits(2, 16))}), tuple,
+       Value::TupleOwned({Value(UBits(1, 8)), Value(UBits(2, 16))})});
+  EXPECT_NE(rebuilt.elements().data(), array.elements().data());
+  EXPECT_EQ(rebuilt, array);
+  EXPECT_EQ(absl::HashOf(rebuilt), absl::HashOf(array));
+
+  Value different = Value::ArrayOrDie(
+      {tuple, tuple, Value::Tuple({Value(UBits(1, 8)), Value(UBits(3, 16))})});
+  EXPECT_NE(different, array);
+}
+
+TEST(ValueTest, EmptyAggregatesAndTokens) {
+  EXPECT_TRUE(Value::Tuple({}).empty());
+  EXPECT_TRUE(Value::Token().empty());
+  EXPECT_EQ(Value::Tuple({}), Value::TupleOwned({}));
+  EXPECT_NE(Value::Tuple({}), Value::Token());
+  EXPECT_NE(absl::HashOf(Value::Tuple({})), absl::HashOf(Value::Token()));
+  EXPECT_EQ(Value::Token(), Value::Token());
+}
+
 void ProtoValueRoundTripWorks(const ValueProto& v) {
   auto value = Value::FromProto(v, /*max_bit_size=*/1 << 16);
   if (!value.ok()) {
@@ -701,6 +735,56 @@ void ProtoValueRoundTripWorks(const ValueProto& v) {
 
 FUZZ_TEST(ValueProto, ProtoValueRoundTripWorks)
     .WithDomains(fuzztest::Arbitrary<ValueProto>());
+
+// Returns an array of `size` elements, each of which is a tuple of a narrow
+// bits value, a wide bits value and a small array.
+Value MakeNestedArray(int64_t size) {
+  std::vector<Value> elements;
+  elements.reserve(size);
+  for (int64_t i = 0; i < size; ++i) {
+    elements.push_back(Value::Tuple(
+        {Value(UBits(i % 256, 8)), Value(UBits(i, 128)),
+         Value::UBitsArray({1, 2, static_cast<uint64_t>(i % 16)}, 4).value()}));
+  }
+  return Value::ArrayOwned(std::move(elements));
+}
+
+void BM_ConstructNestedArray(benchmark::State& state) {
+  for (auto _ : state) {
+    Value v = MakeNestedArray(state.range(0));
+    benchmark::DoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_ConstructNestedArray)->Range(1, 4096);
+
+void BM_CopyNestedArray(benchmark::State& state) {
+  Value v = MakeNestedArray(state.range(0));
+  for (auto _ : state) {
+    Value copy = v;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_CopyNestedArray)->Range(1, 4096);
+
+void BM_HashNestedArray(benchmark::State& state) {
+  Value v = MakeNestedArray(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(absl::HashOf(v));
+  }
+}
+BENCHMARK(BM_HashNestedArray)->Range(1, 4096);
+
+// Compares two structurally equal values which do not share storage so every
+// element is visited.
+void BM_CompareNestedArray(benchmark::State& state) {
+  Value a = MakeNestedArray(state.range(0));
+  Value b = MakeNestedArray(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a == b);
+  }
+}
+BENCHMARK(BM_CompareNestedArray)->Range(1, 4096);
+
 }  // namespace
 
 }  // namespace xls
@@ -553,8 +553,8 @@ absl::Status BlockJitContinuation::SetInputPorts(
         << ip_type->ToString();
     ++it;
   }
-  return block_jit_->runtime()->PackArgs(values, metadata_.input_port_types,
-                                         input_port_pointers());
+  return block_jit_->runtime()->PackArgs(
+      values, block_jit_->input_port_layouts(), input_port_pointers());
 }
 
 absl::Status BlockJitContinuation::SetInputPorts(
@@ -605,8 +605,8 @@ absl::Status BlockJitContinuation::SetRegisters(
         << metadata_.register_types[i]->ToString();
     ++it;
   }
-  return block_jit_->runtime()->PackArgs(values, metadata_.register_types,
-                                         register_pointers());
+  return block_jit_->runtime()->PackArgs(
+      values, block_jit_->register_layouts(), register_pointers());
 }
 
 absl::Status BlockJitContinuation::SetRegisters(
@@ -650,8 +650,8 @@ std::vector<Value> BlockJitContinuation::GetOutputPorts() const {
   result.reserve(output_port_pointers().size());
   int i = 0;
   for (auto ptr : output_port_pointers()) {
-    result.push_back(block_jit_->runtime()->UnpackBuffer(
-        ptr, metadata_.output_port_types[i++]));
+    result.push_back(
+        block_jit_->output_port_layouts()[i++].NativeLayoutToValue(ptr));
   }
   return result;
 }
@@ -702,8 +702,8 @@ std::vector<Value> BlockJitContinuation::GetRegisters() const {
   result.reserve(register_pointers().size());
   int i = 0;
   for (auto ptr : register_pointers()) {
-    result.push_back(block_jit_->runtime()->UnpackBuffer(
-        ptr, metadata_.register_types[i++]));
+    result.push_back(
+        block_jit_->register_layouts()[i++].NativeLayoutToValue(ptr));
   }
   return result;
 }
@@ -45,6 +45,7 @@
 #include "xls/jit/jit_runtime.h"
 #include "xls/jit/observer.h"
 #include "xls/jit/orc_jit.h"
+#include "xls/jit/type_layout.h"
 
 namespace xls {
 
@@ -111,6 +112,18 @@ class BlockJit {
         .subspan(metadata_.InputPortCount());
   }
 
+  // Native layouts of the port and register types, used to convert Values
+  // without going through the (locking) JitRuntime.
+  absl::Span<const TypeLayout> input_port_layouts() const {
+    return input_port_layouts_;
+  }
+  absl::Span<const TypeLayout> output_port_layouts() const {
+    return output_port_layouts_;
+  }
+  absl::Span<const TypeLayout> register_layouts() const {
+    return register_layouts_;
+  }
+
   bool supports_observer() const { return supports_observer_; }
 
  protected:
@@ -121,13 +134,22 @@ class BlockJit {
         runtime_(std::move(runtime)),
         jit_(std::move(jit)),
         function_(std::move(function)),
-        supports_observer_(supports_observer) {}
+        supports_observer_(supports_observer),
+        input_port_layouts_(
+            runtime_->CreateTypeLayouts(metadata_.input_port_types)),
+        output_port_layouts_(
+            runtime_->CreateTypeLayouts(metadata_.output_port_types)),
+        register_layouts_(
+            runtime_->CreateTypeLayouts(metadata_.register_types)) {}
 
   InterfaceMetadata metadata_;
   std::unique_ptr<JitRuntime> runtime_;
   std::unique_ptr<OrcJit> jit_;
   JittedFunctionBase function_;
   bool supports_observer_;
+  std::vector<TypeLayout> input_port_layouts_;
+  std::vector<TypeLayout> output_port_layouts_;
+  std::vector<TypeLayout> register_layouts_;
 };
 
 class BlockJitContinuation {
@@ -38,6 +38,8 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
+#include "llvm/include/llvm/IR/Attributes.h"
+#include "llvm/include/llvm/IR/BasicBlock.h"
 #include "llvm/include/llvm/IR/Constants.h"
 #include "llvm/include/llvm/IR/DerivedTypes.h"
 #include "llvm/include/llvm/IR/Function.h"
@@ -1258,6 +1260,88 @@ absl::StatusOr<llvm::Function*> BuildPackedWrapper(
   return wrapper.function();
 }
 
+// Builds a wrapper around the jitted function `callee` which evaluates
+// `batch_size` independent invocations in a single call. The argument and
+// result buffers are laid out as struct-of-arrays: the i-th pointer in `inputs`
+// points to `batch_size` consecutive values of the i-th input each occupying
+// its native LLVM allocation size. The lanes are evaluated one at a time by a
+// loop into which `callee` is inlined. The lanes share the temp buffer so the
+// loop is not vectorized; the saving over separate calls is the per-call
+// overhead of the runtime.
+absl::StatusOr<llvm::Function*> BuildBatchedWrapper(
+    FunctionBase* xls_function, llvm::Function* callee,
+    JitBuilderContext& jit_context) {
+  llvm::LLVMContext* context = &jit_context.context();
+  llvm::Type* i64_type = llvm::Type::getInt64Ty(*context);
+  std::vector<Node*> inputs = GetJittedFunctionInputs(xls_function);
+  std::vector<Node*> outputs = GetJittedFunctionOutputs(xls_function);
+  LlvmFunctionWrapper wrapper = LlvmFunctionWrapper::Create(
+      absl::StrFormat("%s_batched", xls_function->name()), inputs, outputs,
+      i64_type, jit_context,
+      LlvmFunctionWrapper::FunctionArg{.name = "batch_size",
+                                       .type = i64_type});
+  llvm::IRBuilder<>& entry_builder = wrapper.entry_builder();
+  llvm::Value* batch_size = wrapper.GetExtraArg().value();
+
+  // Arrays of pointers to the buffers of a single lane which are passed to the
+  // callee.
+  llvm::Type* pointer_type = llvm::PointerType::get(*context, 0);
+  llvm::Value* input_arg_array = entry_builder.CreateAlloca(
+      llvm::ArrayType::get(pointer_type, inputs.size()));
+  llvm::Value* output_arg_array = entry_builder.CreateAlloca(
+      llvm::ArrayType::get(pointer_type, outputs.size()));
+
+  llvm::BasicBlock* loop_block =
+      llvm::BasicBlock::Create(*context, "lane_loop", wrapper.function());
+  llvm::BasicBlock* exit_block =
+      llvm::BasicBlock::Create(*context, "exit", wrapper.function());
+  llvm::Value* zero = llvm::ConstantInt::get(i64_type, 0);
+  entry_builder.CreateCondBr(entry_builder.CreateICmpSGT(batch_size, zero),
+                             loop_block, exit_block);
+
+  llvm::IRBuilder<> loop_builder(loop_block);
+  llvm::PHINode* lane = loop_builder.CreatePHI(i64_type, 2, "lane");
+  lane->addIncoming(zero, entry_builder.GetInsertBlock());
+  auto set_lane_pointers = [&](absl::Span<Node* const> nodes,
+                               llvm::Value* batched_array,
+                               llvm::Value* lane_array, bool is_output) {
+    for (int64_t i = 0; i < nodes.size(); ++i) {
+      Type* xls_type = is_output ? OutputType(nodes[i]) : InputType(nodes[i]);
+      llvm::Value* base =
+          LoadPointerFromPointerArray(i, batched_array, &loop_builder);
+      llvm::Value* lane_buffer = loop_builder.CreateGEP(
+          jit_context.type_converter().ConvertToLlvmType(xls_type), base,
+          {lane});
+      llvm::Value* slot = loop_builder.CreateGEP(
+          pointer_type, lane_array,
+          {llvm::ConstantInt::get(llvm::Type::getInt32Ty(*context), i)});
+      loop_builder.CreateStore(lane_buffer, slot);
+    }
+  };
+  set_lane_pointers(inputs, wrapper.GetInputsArg(), input_arg_array,
+                    /*is_output=*/false);
+  set_lane_pointers(outputs, wrapper.GetOutputsArg(), output_arg_array,
+                    /*is_output=*/true);
+
+  llvm::CallInst* call = loop_builder.CreateCall(
+      callee, {input_arg_array, output_arg_array, wrapper.GetTempBufferArg(),
+               wrapper.GetInterpreterEventsArg(),
+               wrapper.GetInstanceContextArg(), wrapper.GetJitRuntimeArg(),
+               /*continuation_point=*/zero});
+  call->addFnAttr(llvm::Attribute::AlwaysInline);
+
+  llvm::Value* next_lane =
+      loop_builder.CreateAdd(lane, llvm::ConstantInt::get(i64_type, 1));
+  lane->addIncoming(next_lane, loop_block);
+  loop_builder.CreateCondBr(loop_builder.CreateICmpSLT(next_lane, batch_size),
+                            loop_block, exit_block);
+
+  llvm::IRBuilder<> exit_builder(exit_block);
+  exit_builder.CreateRet(zero);
+
+  return wrapper.function();
+}
+
 }  // namespace
 
 JitArgumentSet JittedFunctionBase::CreateInputBuffer() const {
@@ -1286,7 +1370,7 @@ JitTempBuffer JittedFunctionBase::CreateTempBuffer() const {
 // dependent xls::Functions which may be called by `xls_function`.
 absl::StatusOr<JittedFunctionBase> JittedFunctionBase::BuildInternal(
     FunctionBase* xls_function, JitBuilderContext& jit_context,
-    bool build_packed_wrapper) {
+    bool build_packed_wrapper, bool build_batched_wrapper) {
   std::vector<FunctionBase*> functions = GetDependentFunctions(xls_function);
   BufferAllocator allocator(&jit_context.type_converter());
   llvm::Function* top_function = nullptr;
@@ -1318,12 +1402,19 @@ absl::StatusOr<JittedFunctionBase> JittedFunctionBase::BuildInternal(
 
   std::string function_name = MangleForLLVM(top_function->getName().str());
   std::string packed_wrapper_name;
+  std::string batched_wrapper_name;
   if (build_packed_wrapper) {
     XLS_ASSIGN_OR_RETURN(
         llvm::Function * packed_wrapper_function,
         BuildPackedWrapper(xls_function, top_function, jit_context));
     packed_wrapper_name = packed_wrapper_function->getName().str();
   }
+  if (build_batched_wrapper) {
+    XLS_ASSIGN_OR_RETURN(
+        llvm::Function * batched_wrapper_function,
+        BuildBatchedWrapper(xls_function, top_function, jit_context));
+    batched_wrapper_name = batched_wrapper_function->getName().str();
+  }
 
   XLS_RETURN_IF_ERROR(
       jit_context.llvm_compiler().CompileModule(jit_context.ConsumeModule()));
@@ -1357,6 +1448,20 @@ absl::StatusOr<JittedFunctionBase> JittedFunctionBase::BuildInternal(
     }
   }
 
+  if (build_batched_wrapper) {
+    jitted_function.batched_function_name_ = batched_wrapper_name;
+    if (jit_context.llvm_compiler().IsOrcJit()) {
+      XLS_ASSIGN_OR_RETURN(auto* orc_jit,
+                           jit_context.llvm_compiler().AsOrcJit());
+      XLS_ASSIGN_OR_RETURN(auto batched_fn_address,
+                           orc_jit->LoadSymbol(batched_wrapper_name));
+      jitted_function.batched_function_ =
+          absl::bit_cast<JitFunctionType>(batched_fn_address);
+    } else {
+      jitted_function.batched_function_ = InvalidJitFunctionUse;
+    }
+  }
+
   for (const Node* input : GetJittedFunctionInputs(xls_function)) {
     Type* input_type = InputType(input);
     jitted_function.input_buffer_sizes_.push_back(
@@ -1397,24 +1502,28 @@ absl::StatusOr<JittedFunctionBase> JittedFunctionBase::BuildInternal(
 }
 
 absl::StatusOr<JittedFunctionBase> JittedFunctionBase::Build(
-    Function* xls_function, LlvmCompiler& compiler) {
+    Function* xls_function, LlvmCompiler& compiler,
+    bool include_batched_entry_point) {
   JitBuilderContext jit_context(compiler, xls_function);
-  return JittedFunctionBase::BuildInternal(xls_function, jit_context,
-                                           /*build_packed_wrapper=*/true);
+  return JittedFunctionBase::BuildInternal(
+      xls_function, jit_context, /*build_packed_wrapper=*/true,
+      /*build_batched_wrapper=*/include_batched_entry_point);
 }
 
 absl::StatusOr<JittedFunctionBase> JittedFunctionBase::Build(
     Proc* proc, LlvmCompiler& compiler) {
   JitBuilderContext jit_context(compiler, proc);
   return JittedFunctionBase::BuildInternal(proc, jit_context,
-                                           /*build_packed_wrapper=*/false);
+                                           /*build_packed_wrapper=*/false,
+                                           /*build_batched_wrapper=*/false);
 }
 
 absl::StatusOr<JittedFunctionBase> JittedFunctionBase::Build(
     Block* block, LlvmCompiler& compiler) {
   JitBuilderContext jit_context(compiler, block);
   return JittedFunctionBase::BuildInternal(block, jit_context,
-                                           /*build_packed_wrapper=*/false);
+                                           /*build_packed_wrapper=*/false,
+                                           /*build_batched_wrapper=*/false);
 }
 
 absl::StatusOr<JittedFunctionBase> JittedFunctionBase::BuildFromAot(
@@ -1560,4 +1669,25 @@ std::optional<int64_t> JittedFunctionBase::RunPackedJittedFunction(
   }
   return std::nullopt;
 }
+
+absl::Status JittedFunctionBase::RunBatchedJittedFunction(
+    const uint8_t* const* inputs, uint8_t* const* outputs, void* temp_buffer,
+    InterpreterEvents* events, InstanceContext* instance_context,
+    JitRuntime* jit_runtime, int64_t batch_size) const {
+  if (!batched_function_.has_value()) {
+    return absl::UnimplementedError(
+        absl::StrFormat("No batched entry point available for `%s`",
+                        function_name_));
+  }
+  XLS_RET_CHECK_GE(batch_size, 0);
+  XLS_RETURN_IF_ERROR(
+      VerifyOffsetAlignments(inputs, input_buffer_abi_alignments()));
+  XLS_RETURN_IF_ERROR(
+      VerifyOffsetAlignments(outputs, output_buffer_abi_alignments()));
+  XLS_RET_CHECK(IsAligned(temp_buffer, temp_buffer_alignment_));
+  (*batched_function_)(inputs, outputs, temp_buffer, events, instance_context,
+                       jit_runtime, batch_size);
+  return absl::OkStatus();
+}
+
 }  // namespace xls
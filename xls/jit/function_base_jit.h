@@ -25,6 +25,7 @@
 #include "absl/algorithm/container.h"
 #include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "llvm/include/llvm/IR/DataLayout.h"
@@ -83,9 +84,12 @@ class JittedFunctionBase {
  public:
   JittedFunctionBase() = default;
   // Builds and returns an LLVM IR function implementing the given XLS
-  // function.
-  static absl::StatusOr<JittedFunctionBase> Build(Function* xls_function,
-                                                  LlvmCompiler& compiler);
+  // function. If `include_batched_entry_point` is true the entry point used by
+  // RunBatchedJittedFunction is also built. It contains a second copy of the
+  // function body so it is only built on request.
+  static absl::StatusOr<JittedFunctionBase> Build(
+      Function* xls_function, LlvmCompiler& compiler,
+      bool include_batched_entry_point = false);
 
   // Builds and returns an LLVM IR function implementing the given XLS
   // proc.
@@ -151,6 +155,17 @@ class JittedFunctionBase {
       InterpreterEvents* events, InstanceContext* instance_context,
       JitRuntime* jit_runtime, int64_t continuation_point) const;
 
+  // Executes the batched version of the function on `batch_size` independent
+  // sets of inputs. Each pointer in `inputs` and `outputs` refers to
+  // `batch_size` consecutive values in the native LLVM data layout, each
+  // occupying the respective entry of `input_buffer_sizes()` or
+  // `output_buffer_sizes()` bytes. The buffers must satisfy the ABI alignments.
+  // Only functions have a batched version.
+  absl::Status RunBatchedJittedFunction(
+      const uint8_t* const* inputs, uint8_t* const* outputs, void* temp_buffer,
+      InterpreterEvents* events, InstanceContext* instance_context,
+      JitRuntime* jit_runtime, int64_t batch_size) const;
+
   // Checks if we have a packed version of the function.
   bool HasPackedFunction() const { return packed_function_.has_value(); }
   std::optional<std::string_view> packed_function_name() const {
@@ -159,6 +174,14 @@ class JittedFunctionBase {
                : std::nullopt;
   }
 
+  // Checks if we have a batched version of the function.
+  bool HasBatchedFunction() const { return batched_function_.has_value(); }
+  std::optional<std::string_view> batched_function_name() const {
+    return HasBatchedFunction()
+               ? std::make_optional<std::string_view>(*batched_function_name_)
+               : std::nullopt;
+  }
+
   std::string_view function_name() const { return function_name_; }
 
   absl::Span<int64_t const> input_buffer_sizes() const {
@@ -213,6 +236,8 @@ class JittedFunctionBase {
     JittedFunctionBase res = *this;
     res.function_ = entrypoint;
     res.packed_function_ = packed_entrypoint;
+    res.batched_function_name_ = std::nullopt;
+    res.batched_function_ = std::nullopt;
     return res;
   }
 
@@ -252,7 +277,7 @@ class JittedFunctionBase {
 
   static absl::StatusOr<JittedFunctionBase> BuildInternal(
       FunctionBase* function, JitBuilderContext& jit_context,
-      bool build_packed_wrapper);
+      bool build_packed_wrapper, bool build_batched_wrapper);
 
   // Name and function pointer for the jitted function which accepts/produces
   // arguments/results in LLVM native format.
@@ -265,6 +290,14 @@ class JittedFunctionBase {
   std::optional<std::string> packed_function_name_;
   std::optional<JitFunctionType> packed_function_;
 
+  // Name and function pointer for the jitted function which evaluates a batch
+  // of independent invocations with arguments/results in LLVM native format
+  // laid out as struct-of-arrays. The extra argument is the batch size rather
+  // than a continuation point. Only exists for JITted xls::Functions built
+  // with `include_batched_entry_point`.
+  std::optional<std::string> batched_function_name_;
+  std::optional<JitFunctionType> batched_function_;
+
   // Sizes of the inputs/outputs in native LLVM format for `function_base`.
   std::vector<int64_t> input_buffer_sizes_;
   std::vector<int64_t> output_buffer_sizes_;
@@ -14,6 +14,7 @@
 
 #include "xls/jit/function_jit.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -44,6 +45,7 @@
 #include "xls/jit/aot_compiler.h"
 #include "xls/jit/aot_entrypoint.pb.h"
 #include "xls/jit/function_base_jit.h"
+#include "xls/jit/jit_buffer.h"
 #include "xls/jit/jit_runtime.h"
 #include "xls/jit/observer.h"
 #include "xls/jit/orc_jit.h"
@@ -98,7 +100,14 @@ absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::Create(
     Function* xls_function, int64_t opt_level, bool include_observer_callbacks,
     JitObserver* jit_observer) {
   return CreateInternal(xls_function, opt_level, include_observer_callbacks,
-                        jit_observer);
+                        jit_observer, /*include_batched_entry_point=*/false);
+}
+
+absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::CreateBatched(
+    Function* xls_function, int64_t opt_level, JitObserver* jit_observer) {
+  return CreateInternal(xls_function, opt_level,
+                        /*include_observer_callbacks=*/false, jit_observer,
+                        /*include_batched_entry_point=*/true);
 }
 
 // Returns an object containing an AOT-compiled version of the specified XLS
@@ -151,14 +160,15 @@ absl::StatusOr<JitObjectCode> FunctionJit::CreateObjectCode(
 
 absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::CreateInternal(
     Function* xls_function, int64_t opt_level, bool include_observer_callbacks,
-    JitObserver* jit_observer) {
+    JitObserver* jit_observer, bool include_batched_entry_point) {
   XLS_ASSIGN_OR_RETURN(
       auto orc_jit,
       OrcJit::Create(opt_level, include_observer_callbacks, jit_observer));
   XLS_ASSIGN_OR_RETURN(llvm::DataLayout data_layout,
                        orc_jit->CreateDataLayout());
   XLS_ASSIGN_OR_RETURN(auto function_base,
-                       JittedFunctionBase::Build(xls_function, *orc_jit));
+                       JittedFunctionBase::Build(xls_function, *orc_jit,
+                                                 include_batched_entry_point));
 
   XLS_ASSIGN_OR_RETURN(InterfaceMetadata metadata,
                        InterfaceMetadata::CreateFromFunction(xls_function));
@@ -184,16 +194,16 @@ absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
   }
 
   // Allocate argument buffers and copy in arg Values.
-  XLS_RETURN_IF_ERROR(jit_runtime_->PackArgs(args, metadata_.param_types,
-                                             arg_buffers_.pointers()));
+  XLS_RETURN_IF_ERROR(
+      jit_runtime_->PackArgs(args, param_layouts_, arg_buffers_.pointers()));
 
   InterpreterEvents events;
   jitted_function_base_.RunJittedFunction(
       arg_buffers_, result_buffers_, temp_buffer_, &events,
       /*instance_context=*/&callbacks_, /*jit_runtime=*/runtime(),
       /*continuation_point=*/0);
-  Value result = jit_runtime_->UnpackBuffer(result_buffers_.pointers()[0],
-                                            metadata_.return_type);
+  Value result =
+      return_layout_.NativeLayoutToValue(result_buffers_.pointers()[0]);
 
   return InterpreterResult<Value>{std::move(result), std::move(events)};
 }
@@ -205,6 +215,86 @@ absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
   return Run(positional_args);
 }
 
+absl::Status FunctionJit::RunBatchedWithViews(
+    absl::Span<uint8_t* const> args, absl::Span<uint8_t> result_buffer,
+    int64_t batch_size, InterpreterEvents* events) {
+  if (args.size() != metadata_.ParamCount()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Arg list has the wrong size: %d vs expected %d.",
+                        args.size(), metadata_.ParamCount()));
+  }
+  if (batch_size < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Batch size must be non-negative: %d", batch_size));
+  }
+  if (result_buffer.size() < GetReturnTypeSize() * batch_size) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Result buffer too small - must be at least %d bytes!",
+        GetReturnTypeSize() * batch_size));
+  }
+  uint8_t* output_buffers[1] = {result_buffer.data()};
+  return jitted_function_base_.RunBatchedJittedFunction(
+      args.data(), output_buffers, temp_buffer_.get(), events,
+      /*instance_context=*/&callbacks_, runtime(), batch_size);
+}
+
+absl::StatusOr<InterpreterResult<std::vector<Value>>> FunctionJit::RunBatched(
+    absl::Span<const std::vector<Value>> args) {
+  int64_t batch_size = args.size();
+  for (int64_t lane = 0; lane < batch_size; ++lane) {
+    if (args[lane].size() != metadata_.ParamCount()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Arg list %d to '%s' has the wrong size: %d vs expected %d.", lane,
+          metadata_.name, args[lane].size(), metadata_.ParamCount()));
+    }
+    for (int64_t i = 0; i < metadata_.ParamCount(); ++i) {
+      if (!ValueConformsToType(args[lane][i], metadata_.param_types[i])) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Got argument %s for parameter %d which is not of type %s",
+            args[lane][i].ToString(), i,
+            metadata_.param_types[i]->ToString()));
+      }
+    }
+  }
+
+  // Lay out each parameter as a contiguous array with one element per lane.
+  auto allocate = [&](int64_t alignment, int64_t element_size) {
+    return std::unique_ptr<uint8_t[], DeleteAligned>(
+        static_cast<uint8_t*>(AllocateAligned(
+            alignment, std::max(element_size * batch_size, int64_t{1}))));
+  };
+  std::vector<std::unique_ptr<uint8_t[], DeleteAligned>> arg_storage;
+  std::vector<uint8_t*> arg_pointers;
+  for (int64_t i = 0; i < metadata_.ParamCount(); ++i) {
+    int64_t size = GetArgTypeSize(i);
+    arg_storage.push_back(allocate(
+        jitted_function_base_.input_buffer_preferred_alignments()[i], size));
+    arg_pointers.push_back(arg_storage.back().get());
+    for (int64_t lane = 0; lane < batch_size; ++lane) {
+      param_layouts_[i].ValueToNativeLayout(args[lane][i],
+                                            arg_pointers.back() + lane * size);
+    }
+  }
+  std::unique_ptr<uint8_t[], DeleteAligned> result_storage = allocate(
+      jitted_function_base_.output_buffer_preferred_alignments()[0],
+      GetReturnTypeSize());
+
+  InterpreterEvents events;
+  XLS_RETURN_IF_ERROR(RunBatchedWithViews(
+      arg_pointers,
+      absl::MakeSpan(result_storage.get(), GetReturnTypeSize() * batch_size),
+      batch_size, &events));
+
+  std::vector<Value> results;
+  results.reserve(batch_size);
+  for (int64_t lane = 0; lane < batch_size; ++lane) {
+    results.push_back(return_layout_.NativeLayoutToValue(
+        result_storage.get() + lane * GetReturnTypeSize()));
+  }
+  return InterpreterResult<std::vector<Value>>{std::move(results),
+                                               std::move(events)};
+}
+
 template <bool kForceZeroCopy>
 absl::Status FunctionJit::RunWithViews(absl::Span<uint8_t* const> args,
                                        absl::Span<uint8_t> result_buffer,
@@ -41,6 +41,7 @@
 #include "xls/jit/jit_runtime.h"
 #include "xls/jit/observer.h"
 #include "xls/jit/orc_jit.h"
+#include "xls/jit/type_layout.h"
 
 namespace xls {
 
@@ -57,6 +58,14 @@ class FunctionJit {
       bool include_observer_callbacks = false,
       JitObserver* jit_observer = nullptr);
 
+  // As Create() but also compiles the entry point used by RunBatched() and
+  // RunBatchedWithViews(). The batched entry point contains a second copy of
+  // the function body which costs compile time and code size so it is only
+  // built for callers which evaluate batches.
+  static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateBatched(
+      Function* xls_function, int64_t opt_level = 3,
+      JitObserver* jit_observer = nullptr);
+
   // Returns an object containing an AOT-compiled version of the specified XLS
   // function.
   static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateFromAot(
@@ -93,6 +102,29 @@ class FunctionJit {
                             absl::Span<uint8_t> result_buffer,
                             InterpreterEvents* events);
 
+  // Executes the compiled function on `batch_size` independent sets of
+  // arguments in a single call. The arguments and results are laid out as
+  // struct-of-arrays: `args[i]` points to `batch_size` consecutive values of
+  // the i-th parameter, each occupying GetArgTypeSize(i) bytes in the native
+  // LLVM layout, and `result_buffer` holds `batch_size` results of
+  // GetReturnTypeSize() bytes each. Each buffer must be aligned to
+  // GetArgTypeAlignment(i) or GetReturnTypeAlignment() respectively.
+  //
+  // The lanes are evaluated one at a time by a loop in the jitted code. This
+  // amortizes the call and argument setup overhead of RunWithViews() for
+  // workloads such as fuzzing or exhaustive testing which evaluate a function
+  // many times. Returns an error unless the object was created with
+  // CreateBatched().
+  absl::Status RunBatchedWithViews(absl::Span<uint8_t* const> args,
+                                   absl::Span<uint8_t> result_buffer,
+                                   int64_t batch_size,
+                                   InterpreterEvents* events);
+
+  // As above but with arguments and results as Values. `args[i]` is the
+  // argument list for the i-th invocation.
+  absl::StatusOr<InterpreterResult<std::vector<Value>>> RunBatched(
+      absl::Span<const std::vector<Value>> args);
+
   // Similar to RunWithViews(), except the arguments here are _packed_views_ -
   // views whose data elements are tightly packed, with no padding bits or bytes
   // between them. The function return value is specified as the last arg - its
@@ -236,11 +268,14 @@ class FunctionJit {
         result_buffers_(jitted_function_base_.CreateOutputBuffer()),
         temp_buffer_(jitted_function_base_.CreateTempBuffer()),
         jit_runtime_(std::move(runtime)),
+        param_layouts_(jit_runtime_->CreateTypeLayouts(metadata_.param_types)),
+        return_layout_(jit_runtime_->CreateTypeLayout(metadata_.return_type)),
         has_observer_callbacks_(has_observer_callbacks) {}
 
   static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateInternal(
       Function* xls_function, int64_t opt_level,
-      bool include_observer_callbacks, JitObserver* jit_observer);
+      bool include_observer_callbacks, JitObserver* jit_observer,
+      bool include_batched_entry_point);
 
   template <bool kForceZeroCopy, typename... ArgsT>
   absl::Status RunWithUnpackedViewsCommon(ArgsT... args) {
@@ -318,6 +353,11 @@ class FunctionJit {
 
   std::unique_ptr<JitRuntime> jit_runtime_;
 
+  // Native layouts of the parameter and return types used to convert Values
+  // without going through the (locking) JitRuntime on every call.
+  std::vector<TypeLayout> param_layouts_;
+  TypeLayout return_layout_;
+
   // Are callbacks for node-values compiled in.
   bool has_observer_callbacks_;
 };
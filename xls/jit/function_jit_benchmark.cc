@@ -0,0 +1,125 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "include/benchmark/benchmark.h"
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/jit/function_jit.h"
+#include "xls/jit/jit_buffer.h"
+
+namespace xls {
+namespace {
+
+// Measures evaluating a function on many independent argument sets with the
+// batched entry point versus a loop of scalar RunWithViews calls.
+constexpr std::string_view kIr = R"(
+package BM
+
+top fn f(a: bits[32], b: bits[32], c: bits[32]) -> bits[32] {
+  add.1: bits[32] = add(a, b)
+  xor.2: bits[32] = xor(add.1, c)
+  umul.3: bits[32] = umul(xor.2, a)
+  shrl.4: bits[32] = shrl(umul.3, c)
+  ret sub.5: bits[32] = sub(shrl.4, b)
+}
+)";
+
+using AlignedBuffer = std::unique_ptr<uint8_t[], DeleteAligned>;
+
+// Struct-of-arrays argument and result storage for `batch_size` lanes.
+struct BatchBuffers {
+  std::vector<AlignedBuffer> args;
+  std::vector<uint8_t*> arg_pointers;
+  AlignedBuffer result;
+};
+
+BatchBuffers CreateBatchBuffers(FunctionJit& jit, Function* f,
+                                int64_t batch_size) {
+  std::minstd_rand bitgen;
+  BatchBuffers buffers;
+  for (int64_t i = 0; i < f->params().size(); ++i) {
+    int64_t size = jit.GetArgTypeSize(i);
+    buffers.args.push_back(AlignedBuffer(static_cast<uint8_t*>(
+        AllocateAligned(jit.GetArgTypeAlignment(i), size * batch_size))));
+    uint8_t* data = buffers.args.back().get();
+    for (int64_t j = 0; j < size * batch_size; ++j) {
+      data[j] = static_cast<uint8_t>(bitgen());
+    }
+    buffers.arg_pointers.push_back(data);
+  }
+  buffers.result = AlignedBuffer(static_cast<uint8_t*>(AllocateAligned(
+      jit.GetReturnTypeAlignment(), jit.GetReturnTypeSize() * batch_size)));
+  return buffers;
+}
+
+static void BM_ScalarRunWithViews(benchmark::State& state) {
+  int64_t batch_size = state.range(0);
+  std::unique_ptr<Package> p = Parser::ParsePackage(kIr).value();
+  Function* f = p->GetTopAsFunction().value();
+  std::unique_ptr<FunctionJit> jit = FunctionJit::Create(f).value();
+  BatchBuffers buffers = CreateBatchBuffers(*jit, f, batch_size);
+  std::vector<uint8_t*> lane_args(buffers.arg_pointers.size());
+  InterpreterEvents events;
+  for (auto _ : state) {
+    for (int64_t lane = 0; lane < batch_size; ++lane) {
+      for (int64_t i = 0; i < lane_args.size(); ++i) {
+        lane_args[i] = buffers.arg_pointers[i] + lane * jit->GetArgTypeSize(i);
+      }
+      CHECK_OK(jit->RunWithViews</*kForceZeroCopy=*/true>(
+          lane_args,
+          absl::MakeSpan(
+              buffers.result.get() + lane * jit->GetReturnTypeSize(),
+              jit->GetReturnTypeSize()),
+          &events));
+    }
+    benchmark::DoNotOptimize(buffers.result.get());
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+static void BM_RunBatchedWithViews(benchmark::State& state) {
+  int64_t batch_size = state.range(0);
+  std::unique_ptr<Package> p = Parser::ParsePackage(kIr).value();
+  Function* f = p->GetTopAsFunction().value();
+  std::unique_ptr<FunctionJit> jit = FunctionJit::CreateBatched(f).value();
+  BatchBuffers buffers = CreateBatchBuffers(*jit, f, batch_size);
+  InterpreterEvents events;
+  for (auto _ : state) {
+    CHECK_OK(jit->RunBatchedWithViews(
+        buffers.arg_pointers,
+        absl::MakeSpan(buffers.result.get(),
+                       jit->GetReturnTypeSize() * batch_size),
+        batch_size, &events));
+    benchmark::DoNotOptimize(buffers.result.get());
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+BENCHMARK(BM_ScalarRunWithViews)->Range(1, 4096);
+BENCHMARK(BM_RunBatchedWithViews)->Range(1, 4096);
+
+}  // namespace
+}  // namespace xls
+
+BENCHMARK_MAIN();
@@ -45,6 +45,8 @@
 #include "absl/strings/substitute.h"
 #include "absl/types/span.h"
 #include "llvm/include/llvm/IR/DataLayout.h"
+#include "llvm/include/llvm/IR/Function.h"
+#include "llvm/include/llvm/IR/Module.h"
 #include "xls/common/bits_util.h"
 #include "xls/common/math_util.h"
 #include "xls/common/status/matchers.h"
@@ -77,9 +79,13 @@ namespace {
 using ::absl_testing::IsOk;
 using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
+using ::testing::Contains;
+using ::testing::Each;
 using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Not;
 using ::testing::TestParamInfo;
 using ::testing::Values;
 
@@ -327,6 +333,229 @@ TEST(FunctionJitTest, OneHotZeroBit) {
               IsOkAndHolds(Value(UBits(1, 1))));
 }
 
+TEST(FunctionJitTest, RunBatched) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: bits[8], y: (bits[3], bits[17])) -> (bits[17], bits[8]) {
+    tuple_index.1: bits[3] = tuple_index(y, index=0)
+    tuple_index.2: bits[17] = tuple_index(y, index=1)
+    zero_ext.3: bits[17] = zero_ext(x, new_bit_count=17)
+    umul.4: bits[17] = umul(zero_ext.3, tuple_index.2)
+    shll.5: bits[8] = shll(x, tuple_index.1)
+    ret tuple.6: (bits[17], bits[8]) = tuple(umul.4, shll.5)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, FunctionJit::CreateBatched(function));
+  ASSERT_TRUE(jit->jitted_function_base().HasBatchedFunction());
+
+  std::minstd_rand bitgen;
+  for (int64_t batch_size : {0, 1, 7, 64, 1000}) {
+    std::vector<std::vector<Value>> args;
+    for (int64_t lane = 0; lane < batch_size; ++lane) {
+      args.push_back({RandomValue(function->param(0)->GetType(), bitgen),
+                      RandomValue(function->param(1)->GetType(), bitgen)});
+    }
+    XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<std::vector<Value>> result,
+                             jit->RunBatched(args));
+    ASSERT_EQ(result.value.size(), static_cast<size_t>(batch_size));
+    for (int64_t lane = 0; lane < batch_size; ++lane) {
+      EXPECT_THAT(RunJitNoEvents(jit.get(), args[lane]),
+                  IsOkAndHolds(result.value[lane]))
+          << "lane " << lane;
+    }
+  }
+}
+
+TEST(FunctionJitTest, RunBatchedCollectsEvents) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(tkn: token, x: bits[8]) -> token {
+    literal.1: bits[1] = literal(value=1)
+    ret trace.2: token = trace(tkn, literal.1, format="x is {}", data_operands=[x])
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, FunctionJit::CreateBatched(function));
+  std::vector<std::vector<Value>> args = {
+      {Value::Token(), Value(UBits(1, 8))},
+      {Value::Token(), Value(UBits(2, 8))},
+      {Value::Token(), Value(UBits(3, 8))}};
+  XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<std::vector<Value>> result,
+                           jit->RunBatched(args));
+  EXPECT_THAT(result.value, ElementsAre(Value::Token(), Value::Token(),
+                                        Value::Token()));
+  ASSERT_EQ(result.events.trace_msgs.size(), 3);
+  EXPECT_EQ(result.events.trace_msgs[0].message, "x is 1");
+  EXPECT_EQ(result.events.trace_msgs[2].message, "x is 3");
+}
+
+TEST(FunctionJitTest, RunBatchedWithViewsRejectsSmallResultBuffer) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: bits[32]) -> bits[32] {
+    ret neg.1: bits[32] = neg(x)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, FunctionJit::CreateBatched(function));
+  std::vector<uint32_t> inputs = {1, 2, 3, 4};
+  std::vector<uint32_t> outputs(3);
+  std::vector<uint8_t*> args = {reinterpret_cast<uint8_t*>(inputs.data())};
+  InterpreterEvents events;
+  EXPECT_THAT(
+      jit->RunBatchedWithViews(
+          args,
+          absl::MakeSpan(reinterpret_cast<uint8_t*>(outputs.data()),
+                         outputs.size() * sizeof(uint32_t)),
+          /*batch_size=*/4, &events),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+  outputs.resize(4);
+  XLS_ASSERT_OK(jit->RunBatchedWithViews(
+      args,
+      absl::MakeSpan(reinterpret_cast<uint8_t*>(outputs.data()),
+                     outputs.size() * sizeof(uint32_t)),
+      /*batch_size=*/4, &events));
+  EXPECT_THAT(outputs, ElementsAre(-1u, -2u, -3u, -4u));
+}
+
+// Records the modules handed to the LLVM compiler and the names of the
+// functions they define. OrcJit serializes the notifications.
+class FunctionNameObserver final : public JitObserver {
+ public:
+  JitObserverRequests GetNotificationOptions() const final {
+    return JitObserverRequests{.unoptimized_module = true};
+  }
+  void UnoptimizedModule(const llvm::Module* module) final {
+    ++module_count_;
+    for (const llvm::Function& function : *module) {
+      if (!function.isDeclaration()) {
+        function_names_.push_back(function.getName().str());
+      }
+    }
+  }
+
+  const std::vector<std::string>& function_names() const {
+    return function_names_;
+  }
+  int64_t module_count() const { return module_count_; }
+
+ private:
+  std::vector<std::string> function_names_;
+  int64_t module_count_ = 0;
+};
+
+TEST(FunctionJitTest, BatchedEntryPointIsOptIn) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: bits[32]) -> bits[32] {
+    ret neg.1: bits[32] = neg(x)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+
+  FunctionNameObserver default_observer;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto jit,
+      FunctionJit::Create(function, LlvmCompiler::kDefaultOptLevel,
+                          /*include_observer_callbacks=*/false,
+                          &default_observer));
+  EXPECT_FALSE(jit->jitted_function_base().HasBatchedFunction());
+  EXPECT_THAT(default_observer.function_names(), Not(IsEmpty()));
+  EXPECT_THAT(default_observer.function_names(),
+              Each(Not(HasSubstr("_batched"))));
+  std::vector<uint32_t> inputs = {1};
+  std::vector<uint32_t> outputs(1);
+  std::vector<uint8_t*> args = {reinterpret_cast<uint8_t*>(inputs.data())};
+  InterpreterEvents events;
+  EXPECT_THAT(
+      jit->RunBatchedWithViews(
+          args,
+          absl::MakeSpan(reinterpret_cast<uint8_t*>(outputs.data()),
+                         outputs.size() * sizeof(uint32_t)),
+          /*batch_size=*/1, &events),
+      StatusIs(absl::StatusCode::kUnimplemented));
+
+  FunctionNameObserver batched_observer;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto batched_jit,
+      FunctionJit::CreateBatched(function, LlvmCompiler::kDefaultOptLevel,
+                                 &batched_observer));
+  EXPECT_TRUE(batched_jit->jitted_function_base().HasBatchedFunction());
+  EXPECT_THAT(batched_observer.function_names(),
+              Contains(HasSubstr("_batched")));
+}
+
+TEST(FunctionJitTest, CompilesSplitModuleConcurrently) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  package my_package
+
+  fn add3(x: bits[32]) -> bits[32] {
+    literal.1: bits[32] = literal(value=3)
+    ret add.2: bits[32] = add(x, literal.1)
+  }
+
+  fn mul5(x: bits[32]) -> bits[32] {
+    literal.3: bits[32] = literal(value=5)
+    ret umul.4: bits[32] = umul(x, literal.3)
+  }
+
+  fn xor_both(x: bits[32]) -> bits[32] {
+    invoke.5: bits[32] = invoke(x, to_apply=add3)
+    invoke.6: bits[32] = invoke(x, to_apply=mul5)
+    ret xor.7: bits[32] = xor(invoke.5, invoke.6)
+  }
+
+  top fn main(x: bits[32], y: bits[32]) -> bits[32] {
+    invoke.8: bits[32] = invoke(x, to_apply=xor_both)
+    invoke.9: bits[32] = invoke(y, to_apply=add3)
+    ret add.10: bits[32] = add(invoke.8, invoke.9)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                           Parser::ParsePackage(ir_text));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function, p->GetTopAsFunction());
+  FunctionNameObserver observer;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto orc_jit,
+      OrcJit::Create(LlvmCompiler::kDefaultOptLevel,
+                     /*include_observer_callbacks=*/false, &observer));
+  // Force a split into several modules regardless of the module size and the
+  // number of CPUs of the machine running the test.
+  constexpr int64_t kModuleCount = 4;
+  orc_jit->SetMinInstructionsPerModule(1);
+  orc_jit->SetMaxModulesPerCompilation(kModuleCount);
+  XLS_ASSERT_OK_AND_ASSIGN(llvm::DataLayout data_layout,
+                           orc_jit->CreateDataLayout());
+  XLS_ASSERT_OK_AND_ASSIGN(JittedFunctionBase jit,
+                           JittedFunctionBase::Build(function, *orc_jit));
+
+  alignas(16) std::array<uint32_t, 1> x = {7};
+  alignas(16) std::array<uint32_t, 1> y = {11};
+  alignas(16) std::array<uint32_t, 1> output = {0};
+  std::array<uint8_t*, 2> inputs = {reinterpret_cast<uint8_t*>(x.data()),
+                                    reinterpret_cast<uint8_t*>(y.data())};
+  std::array<uint8_t*, 1> outputs = {reinterpret_cast<uint8_t*>(output.data())};
+  InterpreterEvents events;
+  JitRuntime runtime(data_layout);
+  JitTempBuffer temp_buffer = jit.CreateTempBuffer();
+  std::optional<int64_t> ret = jit.RunPackedJittedFunction(
+      inputs.data(), outputs.data(), &temp_buffer, &events,
+      /*instance_context=*/nullptr, /*jit_runtime=*/&runtime,
+      /*continuation_point=*/0);
+  ASSERT_TRUE(ret.has_value());
+  EXPECT_EQ(output[0], ((7 + 3) ^ (7 * 5)) + (11 + 3));
+
+  // Every part defines a function reachable from the entry points so all of
+  // them have been materialized.
+  EXPECT_EQ(observer.module_count(), kModuleCount);
+}
+
 // Very basic smoke test for packed and unpacked types.
 TEST(FunctionJitTest, PackedAndUnpackedSmoke) {
   Package package("my_package");
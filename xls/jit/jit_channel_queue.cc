@@ -22,54 +22,109 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/log/check.h"
 #include "absl/memory/memory.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "xls/common/math_util.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/channel_queue.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
+#include "xls/ir/proc.h"
 #include "xls/ir/proc_elaboration.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/jit/jit_runtime.h"
+#include "xls/jit/type_layout.h"
 
 namespace xls {
 namespace {
 
-void WriteValueOnQueue(const Value& value, Type* type, JitRuntime& runtime,
-                       ByteQueue& queue) {
+template <typename QueueT>
+void WriteValueOnQueue(const Value& value, const TypeLayout& type_layout,
+                       QueueT& queue) {
   absl::InlinedVector<uint8_t, ByteQueue::kInitBufferSize> buffer(
       queue.element_size());
-  runtime.BlitValueToBuffer(value, type, absl::MakeSpan(buffer));
+  type_layout.ValueToNativeLayout(value, buffer.data());
   queue.Write(buffer.data());
 }
 
-std::optional<Value> ReadValueFromQueue(Type* type, JitRuntime& runtime,
-                                        ByteQueue& queue) {
+template <typename QueueT>
+std::optional<Value> ReadValueFromQueue(const TypeLayout& type_layout,
+                                        QueueT& queue) {
   std::vector<uint8_t> buffer(queue.element_size());
   if (!queue.Read(buffer.data())) {
     return std::nullopt;
   }
-  return runtime.UnpackBuffer(buffer.data(), type);
+  return type_layout.NativeLayoutToValue(buffer.data());
+}
+
+// Returns the allocated size of an element of the given size in a queue
+// buffer. Elements are aligned to the largest scalar type.
+int64_t AllocatedElementSize(int64_t channel_element_size) {
+  // Special case to handle empty tuples. Assigning the allocated element size
+  // to one serves as a tangible instance for the number of elements within the
+  // queue.
+  return std::max(
+      RoundUpToNearest(channel_element_size,
+                       static_cast<int64_t>(alignof(std::max_align_t))),
+      int64_t{1});
+}
+
+// Returns the streaming channel instances in the elaboration which are sent on
+// by exactly one proc instance and received from by exactly one proc instance.
+absl::flat_hash_set<ChannelInstance*> GetSingleProducerSingleConsumerChannels(
+    const ProcElaboration& elaboration) {
+  absl::flat_hash_map<ChannelInstance*, absl::flat_hash_set<ProcInstance*>>
+      senders;
+  absl::flat_hash_map<ChannelInstance*, absl::flat_hash_set<ProcInstance*>>
+      receivers;
+  for (ProcInstance* proc_instance : elaboration.proc_instances()) {
+    for (Node* node : proc_instance->proc()->nodes()) {
+      if (!node->Is<ChannelNode>()) {
+        continue;
+      }
+      ChannelNode* channel_node = node->As<ChannelNode>();
+      absl::StatusOr<ChannelInstance*> channel_instance =
+          proc_instance->GetChannelInstance(channel_node->channel_name());
+      if (!channel_instance.ok()) {
+        continue;
+      }
+      if (channel_node->direction() == Direction::kSend) {
+        senders[*channel_instance].insert(proc_instance);
+      } else {
+        receivers[*channel_instance].insert(proc_instance);
+      }
+    }
+  }
+  absl::flat_hash_set<ChannelInstance*> result;
+  for (ChannelInstance* channel_instance : elaboration.channel_instances()) {
+    if (channel_instance->channel->kind() != ChannelKind::kStreaming) {
+      continue;
+    }
+    auto sender_it = senders.find(channel_instance);
+    auto receiver_it = receivers.find(channel_instance);
+    if (sender_it != senders.end() && sender_it->second.size() == 1 &&
+        receiver_it != receivers.end() && receiver_it->second.size() == 1) {
+      result.insert(channel_instance);
+    }
+  }
+  return result;
 }
 
 }  // namespace
 
 ByteQueue::ByteQueue(int64_t channel_element_size, bool is_single_value)
     : channel_element_size_(channel_element_size),
-      allocated_element_size_(
-          RoundUpToNearest(channel_element_size,
-                           static_cast<int64_t>(alignof(std::max_align_t)))),
+      allocated_element_size_(AllocatedElementSize(channel_element_size)),
       is_single_value_(is_single_value) {
-  // Special case to handle empty tuples. Assigning the allocated element size
-  // to one serves as a tangible instance for the number of elements within the
-  // queue.
-  if (allocated_element_size_ == 0) {
-    allocated_element_size_ = 1;
-  }
   // Align the vector allocation to a power of 2 for efficient utilization
   // of the memory.
   int64_t element_size_2 = 1 << CeilOfLog2(allocated_element_size_);
@@ -102,18 +157,112 @@ void ByteQueue::Resize() {
   }
 }
 
+SpscByteQueue::Segment::Segment(int64_t capacity,
+                                int64_t allocated_element_size, int64_t begin)
+    : capacity(capacity),
+      begin(begin),
+      buffer(std::make_unique<uint8_t[]>(capacity * allocated_element_size)) {
+  DCHECK(IsPowerOfTwo(static_cast<uint64_t>(capacity)));
+}
+
+SpscByteQueue::SpscByteQueue(int64_t channel_element_size)
+    : channel_element_size_(channel_element_size),
+      allocated_element_size_(AllocatedElementSize(channel_element_size)) {
+  // Size the first segment to hold as many elements as fit in
+  // kInitBufferSize bytes, rounded down to a power of two.
+  int64_t capacity = 1;
+  while (2 * capacity * allocated_element_size_ <= kInitBufferSize) {
+    capacity *= 2;
+  }
+  write_segment_ =
+      new Segment(capacity, allocated_element_size_, /*begin=*/0);
+  read_segment_ = write_segment_;
+}
+
+SpscByteQueue::~SpscByteQueue() {
+  Segment* segment = read_segment_;
+  while (segment != nullptr) {
+    Segment* next = segment->next.load(std::memory_order_acquire);
+    delete segment;
+    segment = next;
+  }
+}
+
+SpscByteQueue::Segment* SpscByteQueue::AddSegment(int64_t begin) {
+  Segment* segment = write_segment_;
+  Segment* new_segment =
+      new Segment(2 * segment->capacity, allocated_element_size_, begin);
+  // `end` must be written before `next` is published so the consumer observes
+  // the final value.
+  segment->end = begin;
+  segment->next.store(new_segment, std::memory_order_release);
+  write_segment_ = new_segment;
+  return new_segment;
+}
+
+SpscByteQueue::Segment* SpscByteQueue::RetireReadSegment() {
+  Segment* segment = read_segment_;
+  Segment* next = segment->next.load(std::memory_order_acquire);
+  // The producer never writes to a segment after publishing its successor so
+  // the drained segment may be freed.
+  delete segment;
+  read_segment_ = next;
+  return next;
+}
+
 int64_t ThreadSafeJitChannelQueue::GetSizeInternal() const {
   return byte_queue_.size();
 }
 
 void ThreadSafeJitChannelQueue::WriteInternal(const Value& value) {
   CallWriteCallbacks(value);
-  WriteValueOnQueue(value, channel()->type(), *jit_runtime_, byte_queue_);
+  WriteValueOnQueue(value, type_layout_, byte_queue_);
 }
 
 std::optional<Value> ThreadSafeJitChannelQueue::ReadInternal() {
-  std::optional<Value> value =
-      ReadValueFromQueue(channel()->type(), *jit_runtime_, byte_queue_);
+  std::optional<Value> value = ReadValueFromQueue(type_layout_, byte_queue_);
+  if (value.has_value()) {
+    CallReadCallbacks(value.value());
+  }
+  return value;
+}
+
+SpscJitChannelQueue::SpscJitChannelQueue(ChannelInstance* channel_instance,
+                                         JitRuntime* jit_runtime)
+    : JitChannelQueue(channel_instance, jit_runtime),
+      byte_queue_(
+          jit_runtime->GetTypeByteSize(channel_instance->channel->type())) {
+  CHECK_EQ(channel_instance->channel->kind(), ChannelKind::kStreaming)
+      << "SpscJitChannelQueue only supports streaming channels: "
+      << channel_instance->ToString();
+}
+
+absl::Status SpscJitChannelQueue::AttachGenerator(GeneratorFn generator) {
+  XLS_RETURN_IF_ERROR(JitChannelQueue::AttachGenerator(std::move(generator)));
+  locked_.store(true, std::memory_order_release);
+  return absl::OkStatus();
+}
+
+void SpscJitChannelQueue::AddCallback(
+    std::unique_ptr<ChannelQueueCallback> callback) {
+  {
+    absl::MutexLock lock(&mutex_);
+    callbacks_.push_back(std::move(callback));
+  }
+  locked_.store(true, std::memory_order_release);
+}
+
+int64_t SpscJitChannelQueue::GetSizeInternal() const {
+  return byte_queue_.size();
+}
+
+void SpscJitChannelQueue::WriteInternal(const Value& value) {
+  CallWriteCallbacks(value);
+  WriteValueOnQueue(value, type_layout_, byte_queue_);
+}
+
+std::optional<Value> SpscJitChannelQueue::ReadInternal() {
+  std::optional<Value> value = ReadValueFromQueue(type_layout_, byte_queue_);
   if (value.has_value()) {
     CallReadCallbacks(value.value());
   }
@@ -126,12 +275,11 @@ int64_t ThreadUnsafeJitChannelQueue::GetSizeInternal() const {
 
 void ThreadUnsafeJitChannelQueue::WriteInternal(const Value& value) {
   CallWriteCallbacks(value);
-  WriteValueOnQueue(value, channel()->type(), *jit_runtime_, byte_queue_);
+  WriteValueOnQueue(value, type_layout_, byte_queue_);
 }
 
 std::optional<Value> ThreadUnsafeJitChannelQueue::ReadInternal() {
-  std::optional<Value> value =
-      ReadValueFromQueue(channel()->type(), *jit_runtime_, byte_queue_);
+  std::optional<Value> value = ReadValueFromQueue(type_layout_, byte_queue_);
   if (value.has_value()) {
     CallReadCallbacks(value.value());
   }
@@ -149,10 +297,17 @@ JitChannelQueueManager::CreateThreadSafe(Package* package,
 /* static */ absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
 JitChannelQueueManager::CreateThreadSafe(ProcElaboration&& elaboration,
                                          std::unique_ptr<JitRuntime> runtime) {
+  absl::flat_hash_set<ChannelInstance*> spsc_channels =
+      GetSingleProducerSingleConsumerChannels(elaboration);
   std::vector<std::unique_ptr<ChannelQueue>> queues;
   for (ChannelInstance* channel_instance : elaboration.channel_instances()) {
-    queues.push_back(std::make_unique<ThreadSafeJitChannelQueue>(
-        channel_instance, runtime.get()));
+    if (spsc_channels.contains(channel_instance)) {
+      queues.push_back(std::make_unique<SpscJitChannelQueue>(channel_instance,
+                                                             runtime.get()));
+    } else {
+      queues.push_back(std::make_unique<ThreadSafeJitChannelQueue>(
+          channel_instance, runtime.get()));
+    }
   }
   return absl::WrapUnique(new JitChannelQueueManager(
       std::move(elaboration), std::move(queues), std::move(runtime)));
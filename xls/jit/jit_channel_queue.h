@@ -14,6 +14,8 @@
 #ifndef XLS_JIT_JIT_CHANNEL_QUEUE_H_
 #define XLS_JIT_JIT_CHANNEL_QUEUE_H_
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <memory>
@@ -21,8 +23,10 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/optimization.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
 #include "xls/interpreter/channel_queue.h"
@@ -31,6 +35,7 @@
 #include "xls/ir/proc_elaboration.h"
 #include "xls/ir/value.h"
 #include "xls/jit/jit_runtime.h"
+#include "xls/jit/type_layout.h"
 
 namespace xls {
 
@@ -112,13 +117,142 @@ class ByteQueue {
   bool is_single_value_;
 };
 
+// A lock-free unbounded FIFO queue of raw bytes which supports exactly one
+// producer thread and exactly one consumer thread. The queue is a linked list
+// of circular buffer segments. When the segment being written is full the
+// producer links in a new segment of twice the capacity, and the consumer
+// frees a segment once it has been drained. The producer and consumer indices
+// live on separate cache lines and are published with release/acquire ordering
+// so the fast path of `Write` and `Read` touches no shared state other than
+// the two indices.
+class SpscByteQueue {
+ public:
+  // `channel_element_size` is the granularity of the queue access. Each read or
+  // write to the queue handles this many bytes at a time.
+  explicit SpscByteQueue(int64_t channel_element_size);
+  ~SpscByteQueue();
+
+  SpscByteQueue(const SpscByteQueue&) = delete;
+  SpscByteQueue& operator=(const SpscByteQueue&) = delete;
+
+  int64_t element_size() const { return channel_element_size_; }
+
+  // Writes an element to the queue. Must only be called by the producer.
+  void Write(const uint8_t* data) {
+#ifdef ABSL_HAVE_MEMORY_SANITIZER
+    __msan_unpoison(data, channel_element_size_);
+#endif
+    int64_t write_index = write_index_.load(std::memory_order_relaxed);
+    Segment* segment = write_segment_;
+    if (write_index - std::max(cached_read_index_, segment->begin) ==
+        segment->capacity) {
+      // The segment appears full. Refresh the view of the consumer index before
+      // growing the queue.
+      cached_read_index_ = read_index_.load(std::memory_order_acquire);
+      if (write_index - std::max(cached_read_index_, segment->begin) ==
+          segment->capacity) {
+        segment = AddSegment(write_index);
+      }
+    }
+    memcpy(segment->SlotAddress(write_index, allocated_element_size_), data,
+           channel_element_size_);
+    write_index_.store(write_index + 1, std::memory_order_release);
+  }
+
+  // Reads an element from the queue into `buffer`. Returns false if the queue
+  // is empty. Must only be called by the consumer.
+  bool Read(uint8_t* buffer) {
+    int64_t read_index = read_index_.load(std::memory_order_relaxed);
+    if (read_index == cached_write_index_) {
+      cached_write_index_ = write_index_.load(std::memory_order_acquire);
+      if (read_index == cached_write_index_) {
+        return false;
+      }
+    }
+    Segment* segment = read_segment_;
+    if (ABSL_PREDICT_FALSE(
+            segment->next.load(std::memory_order_acquire) != nullptr &&
+            read_index == segment->end)) {
+      segment = RetireReadSegment();
+    }
+    memcpy(buffer, segment->SlotAddress(read_index, allocated_element_size_),
+           channel_element_size_);
+    read_index_.store(read_index + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Returns the number of elements in the queue. May be called from any
+  // thread. If the queue is concurrently accessed the value is a snapshot.
+  int64_t size() const {
+    // Load the read index first. Indices only increase so the difference is
+    // never negative.
+    int64_t read_index = read_index_.load(std::memory_order_acquire);
+    return write_index_.load(std::memory_order_acquire) - read_index;
+  }
+
+  static constexpr int64_t kInitBufferSize = 128;
+
+ private:
+  // A circular buffer holding a contiguous range of the elements of the
+  // queue. Elements are identified by their global index (the number of
+  // elements written to the queue before them).
+  struct Segment {
+    Segment(int64_t capacity, int64_t allocated_element_size, int64_t begin);
+
+    uint8_t* SlotAddress(int64_t index, int64_t allocated_element_size) {
+      return buffer.get() + (index & (capacity - 1)) * allocated_element_size;
+    }
+
+    // Number of elements the segment can hold. Always a power of two.
+    int64_t capacity;
+    // Global index of the first element written to this segment.
+    int64_t begin;
+    // Global index one past the last element written to this segment. Written
+    // by the producer before `next` is published and read by the consumer only
+    // after observing a non-null `next`.
+    int64_t end = 0;
+    std::unique_ptr<uint8_t[]> buffer;
+    // The segment which follows this one. Non-null once the producer has
+    // stopped writing to this segment.
+    std::atomic<Segment*> next = nullptr;
+  };
+
+  // Appends a new segment of double capacity starting at global index `begin`
+  // and makes it the write segment. Called by the producer.
+  Segment* AddSegment(int64_t begin);
+
+  // Frees the drained read segment and advances to its successor. Called by
+  // the consumer.
+  Segment* RetireReadSegment();
+
+  // Size of an element in the channel in units of bytes.
+  int64_t channel_element_size_;
+  // Allocated size of an element in a segment in units of bytes. The elements
+  // are aligned to the largest scalar type.
+  int64_t allocated_element_size_;
+
+  // State written by the producer.
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<int64_t> write_index_ = 0;
+  Segment* write_segment_;
+  // Producer's possibly stale copy of `read_index_`.
+  int64_t cached_read_index_ = 0;
+
+  // State written by the consumer.
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<int64_t> read_index_ = 0;
+  Segment* read_segment_;
+  // Consumer's possibly stale copy of `write_index_`.
+  int64_t cached_write_index_ = 0;
+};
+
 // Abstract base class for channel queues which may be used by the JIT. These
 // queues support reading and writing raw bytes to the queue rather the just
 // xls::Values.
 class JitChannelQueue : public ChannelQueue {
  public:
   JitChannelQueue(ChannelInstance* channel, JitRuntime* jit_runtime)
-      : ChannelQueue(channel), jit_runtime_(jit_runtime) {}
+      : ChannelQueue(channel),
+        jit_runtime_(jit_runtime),
+        type_layout_(jit_runtime->CreateTypeLayout(channel->channel->type())) {}
   ~JitChannelQueue() override = default;
 
   virtual void WriteRaw(const uint8_t* data) = 0;
@@ -126,6 +260,8 @@ class JitChannelQueue : public ChannelQueue {
 
  protected:
   JitRuntime* jit_runtime_;
+  // Native layout of the channel type.
+  TypeLayout type_layout_;
 };
 
 // A thread-safe version of the JIT channel queue. All accesses are guarded by a
@@ -145,7 +281,7 @@ class ThreadSafeJitChannelQueue : public JitChannelQueue {
     absl::MutexLock lock(&mutex_);
     byte_queue_.Write(data);
     if (!callbacks_.empty()) {
-      CallWriteCallbacks(jit_runtime_->UnpackBuffer(data, channel()->type()));
+      CallWriteCallbacks(type_layout_.NativeLayoutToValue(data));
     }
   }
 
@@ -161,7 +297,7 @@ class ThreadSafeJitChannelQueue : public JitChannelQueue {
     }
     bool value_read = byte_queue_.Read(buffer);
     if (value_read && !callbacks_.empty()) {
-      CallReadCallbacks(jit_runtime_->UnpackBuffer(buffer, channel()->type()));
+      CallReadCallbacks(type_layout_.NativeLayoutToValue(buffer));
     }
     return value_read;
   }
@@ -190,7 +326,7 @@ class ThreadUnsafeJitChannelQueue : public JitChannelQueue {
   void WriteRaw(const uint8_t* data) override {
     byte_queue_.Write(data);
     if (!callbacks_.empty()) {
-      CallWriteCallbacks(jit_runtime_->UnpackBuffer(data, channel()->type()));
+      CallWriteCallbacks(type_layout_.NativeLayoutToValue(data));
     }
   }
   bool ReadRaw(uint8_t* buffer) override {
@@ -202,7 +338,7 @@ class ThreadUnsafeJitChannelQueue : public JitChannelQueue {
     }
     bool value_read = byte_queue_.Read(buffer);
     if (value_read && !callbacks_.empty()) {
-      CallReadCallbacks(jit_runtime_->UnpackBuffer(buffer, channel()->type()));
+      CallReadCallbacks(type_layout_.NativeLayoutToValue(buffer));
     }
     return value_read;
   }
@@ -215,13 +351,76 @@ class ThreadUnsafeJitChannelQueue : public JitChannelQueue {
   ByteQueue byte_queue_;
 };
 
+// A lock-free version of the JIT channel queue for streaming channels which
+// have exactly one sending and exactly one receiving proc instance. `WriteRaw`
+// may only be called from a single producer thread and `ReadRaw` from a single
+// consumer thread.
+//
+// Generators and callbacks, which are used for testing and tracing, require
+// serialization: a generator writes to the queue from the consumer thread. Once
+// either is attached the queue switches permanently to guarding every access
+// with the mutex. Generators and callbacks must be attached before the queue is
+// accessed concurrently.
+class SpscJitChannelQueue : public JitChannelQueue {
+ public:
+  SpscJitChannelQueue(ChannelInstance* channel_instance,
+                      JitRuntime* jit_runtime);
+  ~SpscJitChannelQueue() override = default;
+
+  absl::Status AttachGenerator(GeneratorFn generator) override;
+  void AddCallback(std::unique_ptr<ChannelQueueCallback> callback) override;
+
+  void WriteRaw(const uint8_t* data) override {
+    if (ABSL_PREDICT_FALSE(locked_.load(std::memory_order_acquire))) {
+      absl::MutexLock lock(&mutex_);
+      byte_queue_.Write(data);
+      if (!callbacks_.empty()) {
+        CallWriteCallbacks(type_layout_.NativeLayoutToValue(data));
+      }
+      return;
+    }
+    byte_queue_.Write(data);
+  }
+  bool ReadRaw(uint8_t* buffer) override {
+    if (ABSL_PREDICT_FALSE(locked_.load(std::memory_order_acquire))) {
+      absl::MutexLock lock(&mutex_);
+      if (generator_.has_value()) {
+        std::optional<Value> generated_value = (*generator_)();
+        if (generated_value.has_value()) {
+          WriteInternal(generated_value.value());
+        }
+      }
+      bool value_read = byte_queue_.Read(buffer);
+      if (value_read && !callbacks_.empty()) {
+        CallReadCallbacks(type_layout_.NativeLayoutToValue(buffer));
+      }
+      return value_read;
+    }
+    return byte_queue_.Read(buffer);
+  }
+
+ protected:
+  int64_t GetSizeInternal() const ABSL_SHARED_LOCKS_REQUIRED(mutex_) override;
+  void WriteInternal(const Value& value)
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_) override;
+  std::optional<Value> ReadInternal()
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_) override;
+
+  SpscByteQueue byte_queue_;
+  // Whether a generator or callback is attached in which case all accesses
+  // are serialized with `mutex_`.
+  std::atomic<bool> locked_ = false;
+};
+
 // A Channel manager which holds exclusively JitChannelQueues.
 class JitChannelQueueManager : public ChannelQueueManager {
  public:
   ~JitChannelQueueManager() override = default;
 
   // Factories which create a queue manager with exclusively ThreadSafe/Unsafe
-  // queues.
+  // queues. The thread-safe factories back channels with a single sender and a
+  // single receiver with lock-free SpscJitChannelQueues and all other channels
+  // with ThreadSafeJitChannelQueues.
   static absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
   CreateThreadSafe(Package* package, std::unique_ptr<JitRuntime> runtime);
   static absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
@@ -70,6 +70,79 @@ static void BM_QueueWriteThenRead(benchmark::State& state) {
   }
 }
 
+// State shared between the producer and the consumer thread of
+// BM_QueueContendedThroughput.
+template <typename QueueT>
+struct ContendedQueueState {
+  explicit ContendedQueueState(int64_t element_size_bytes)
+      : package("benchmark") {
+    orc_jit = OrcJit::Create().value();
+    jit_runtime =
+        std::make_unique<JitRuntime>(orc_jit->CreateDataLayout().value());
+    Channel* channel =
+        package
+            .CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                    package.GetBitsType(8 * element_size_bytes))
+            .value();
+    elaboration = std::make_unique<ProcElaboration>(
+        ProcElaboration::ElaborateOldStylePackage(&package).value());
+    queue = std::make_unique<QueueT>(
+        elaboration->GetUniqueInstance(channel).value(), jit_runtime.get());
+  }
+
+  Package package;
+  std::unique_ptr<OrcJit> orc_jit;
+  std::unique_ptr<JitRuntime> jit_runtime;
+  std::unique_ptr<ProcElaboration> elaboration;
+  std::unique_ptr<QueueT> queue;
+};
+
+// Benchmark evaluating throughput of the queue with one producer thread
+// writing to the channel concurrently with one consumer thread reading from
+// the channel. Each iteration the producer writes `send_count` elements and the
+// consumer spins until it has read `send_count` elements.
+template <typename QueueT,
+          typename std::enable_if<std::is_base_of_v<JitChannelQueue, QueueT>,
+                                  QueueT>::type* = nullptr>
+static void BM_QueueContendedThroughput(benchmark::State& state) {
+  static ContendedQueueState<QueueT>* shared_state = nullptr;
+  int64_t element_size_bytes = state.range(0);
+  int64_t send_count = state.range(1);
+  // Setup before the benchmark loop is complete in all threads before any
+  // thread enters the loop.
+  if (state.thread_index() == 0) {
+    shared_state = new ContendedQueueState<QueueT>(element_size_bytes);
+  }
+
+  std::vector<uint8_t> buffer(element_size_bytes);
+  std::fill(buffer.begin(), buffer.end(), 42);
+  for (auto _ : state) {
+    JitChannelQueue& queue = *shared_state->queue;
+    if (state.thread_index() == 0) {
+      for (int64_t i = 0; i < send_count; ++i) {
+        queue.WriteRaw(buffer.data());
+      }
+    } else {
+      for (int64_t i = 0; i < send_count;) {
+        if (queue.ReadRaw(buffer.data())) {
+          ++i;
+        }
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * send_count);
+  state.SetBytesProcessed(state.iterations() * send_count *
+                          element_size_bytes);
+
+  if (state.thread_index() == 0) {
+    // Both threads have exited the benchmark loop and have processed the same
+    // number of elements so the queue is empty.
+    CHECK(shared_state->queue->IsEmpty());
+    delete shared_state;
+    shared_state = nullptr;
+  }
+}
+
 // For the following benchmark, the first element in the pair denotes the buffer
 // size written/read from the channel queue. The second element in the pair
 // denotes the number of writes and/or reads to the channel queue.
@@ -93,6 +166,34 @@ BENCHMARK(BM_QueueWriteThenRead<ThreadUnsafeJitChannelQueue>)
     ->ArgPair(2048, 1)
     ->ArgPair(2048, 128);
 
+BENCHMARK(BM_QueueWriteThenRead<SpscJitChannelQueue>)
+    ->ArgPair(1, 1)
+    ->ArgPair(1, 128)
+    ->ArgPair(8, 1)
+    ->ArgPair(8, 128)
+    ->ArgPair(32, 1)
+    ->ArgPair(32, 128)
+    ->ArgPair(2048, 1)
+    ->ArgPair(2048, 128);
+
+// The contended benchmarks run with two threads: thread 0 is the producer and
+// thread 1 is the consumer.
+BENCHMARK(BM_QueueContendedThroughput<ThreadSafeJitChannelQueue>)
+    ->ArgPair(8, 1)
+    ->ArgPair(8, 128)
+    ->ArgPair(32, 128)
+    ->ArgPair(2048, 128)
+    ->Threads(2)
+    ->UseRealTime();
+
+BENCHMARK(BM_QueueContendedThroughput<SpscJitChannelQueue>)
+    ->ArgPair(8, 1)
+    ->ArgPair(8, 128)
+    ->ArgPair(32, 128)
+    ->ArgPair(2048, 128)
+    ->Threads(2)
+    ->UseRealTime();
+
 }  // namespace
 }  // namespace xls
 
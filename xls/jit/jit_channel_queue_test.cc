@@ -18,6 +18,7 @@
 #include <cstring>
 #include <memory>
 #include <optional>
+#include <string_view>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -25,10 +26,13 @@
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "xls/common/status/matchers.h"
+#include "xls/common/thread.h"
+#include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/channel_queue_test_base.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/channel_ops.h"
+#include "xls/ir/function_builder.h"
 #include "xls/ir/package.h"
 #include "xls/ir/proc_elaboration.h"
 #include "xls/ir/value.h"
@@ -68,7 +72,8 @@ template <typename QueueT>
 class JitChannelQueueTest : public ::testing::Test {};
 
 using QueueTypes =
-    ::testing::Types<ThreadSafeJitChannelQueue, ThreadUnsafeJitChannelQueue>;
+    ::testing::Types<ThreadSafeJitChannelQueue, ThreadUnsafeJitChannelQueue,
+                     SpscJitChannelQueue>;
 TYPED_TEST_SUITE(JitChannelQueueTest, QueueTypes);
 
 // An empty tuple represents a zero width.
@@ -181,5 +186,197 @@ TYPED_TEST(JitChannelQueueTest, IotaGeneratorWithRawApi) {
                                  "a generator function")));
 }
 
+TYPED_TEST(JitChannelQueueTest, GrowsAcrossManyElements) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                     package.GetBitsType(64)));
+  XLS_ASSERT_OK_AND_ASSIGN(ProcElaboration elaboration,
+                           ProcElaboration::ElaborateOldStylePackage(&package));
+
+  TypeParam queue(elaboration.GetUniqueInstance(channel).value(),
+                  GetJitRuntime());
+
+  // Interleave bursts of writes and reads so the queue grows while the read
+  // position is in the middle of the buffer.
+  uint64_t next_write = 0;
+  uint64_t next_read = 0;
+  for (int64_t burst = 1; burst < 100; ++burst) {
+    for (int64_t i = 0; i < burst; ++i) {
+      queue.WriteRaw(reinterpret_cast<const uint8_t*>(&next_write));
+      ++next_write;
+    }
+    for (int64_t i = 0; i < burst / 2; ++i) {
+      uint64_t result;
+      EXPECT_TRUE(queue.ReadRaw(reinterpret_cast<uint8_t*>(&result)));
+      EXPECT_EQ(result, next_read);
+      ++next_read;
+    }
+    EXPECT_EQ(queue.GetSize(), static_cast<int64_t>(next_write - next_read));
+  }
+  uint64_t result;
+  while (queue.ReadRaw(reinterpret_cast<uint8_t*>(&result))) {
+    EXPECT_EQ(result, next_read);
+    ++next_read;
+  }
+  EXPECT_EQ(next_read, next_write);
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(SpscJitChannelQueueTest, ConcurrentProducerAndConsumer) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                     package.GetBitsType(64)));
+  XLS_ASSERT_OK_AND_ASSIGN(ProcElaboration elaboration,
+                           ProcElaboration::ElaborateOldStylePackage(&package));
+
+  SpscJitChannelQueue queue(elaboration.GetUniqueInstance(channel).value(),
+                            GetJitRuntime());
+
+  constexpr uint64_t kCount = 1000000;
+  Thread producer([&]() {
+    for (uint64_t i = 0; i < kCount; ++i) {
+      queue.WriteRaw(reinterpret_cast<const uint8_t*>(&i));
+    }
+  });
+  uint64_t expected = 0;
+  while (expected < kCount) {
+    uint64_t result;
+    if (queue.ReadRaw(reinterpret_cast<uint8_t*>(&result))) {
+      EXPECT_EQ(result, expected);
+      if (result != expected) {
+        break;
+      }
+      ++expected;
+    }
+  }
+  producer.Join();
+  EXPECT_EQ(expected, kCount);
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+// Records the values passed to the write and read callbacks of a queue.
+class RecordingCallback : public ChannelQueueCallback {
+ public:
+  RecordingCallback(std::vector<Value>* written, std::vector<Value>* read)
+      : written_(written), read_(read) {}
+
+  void ReadValue(ChannelInstance* channel_instance,
+                 const Value& value) override {
+    read_->push_back(value);
+  }
+  void WriteValue(ChannelInstance* channel_instance,
+                  const Value& value) override {
+    written_->push_back(value);
+  }
+
+ private:
+  std::vector<Value>* written_;
+  std::vector<Value>* read_;
+};
+
+TEST(SpscJitChannelQueueTest, ConcurrentProducerAndConsumerWithCallback) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                     package.GetBitsType(64)));
+  XLS_ASSERT_OK_AND_ASSIGN(ProcElaboration elaboration,
+                           ProcElaboration::ElaborateOldStylePackage(&package));
+
+  SpscJitChannelQueue queue(elaboration.GetUniqueInstance(channel).value(),
+                            GetJitRuntime());
+  // The callbacks are only invoked with the queue's mutex held so they may
+  // append to unsynchronized vectors.
+  std::vector<Value> written;
+  std::vector<Value> read;
+  queue.AddCallback(std::make_unique<RecordingCallback>(&written, &read));
+
+  constexpr uint64_t kCount = 10000;
+  Thread producer([&]() {
+    for (uint64_t i = 0; i < kCount; ++i) {
+      queue.WriteRaw(reinterpret_cast<const uint8_t*>(&i));
+    }
+  });
+  uint64_t expected = 0;
+  while (expected < kCount) {
+    uint64_t result;
+    if (queue.ReadRaw(reinterpret_cast<uint8_t*>(&result))) {
+      EXPECT_EQ(result, expected);
+      if (result != expected) {
+        break;
+      }
+      ++expected;
+    }
+  }
+  producer.Join();
+  EXPECT_EQ(expected, kCount);
+  ASSERT_EQ(written.size(), kCount);
+  ASSERT_EQ(read.size(), expected);
+  for (uint64_t i = 0; i < expected; ++i) {
+    EXPECT_EQ(written[i], Value(UBits(i, 64)));
+    EXPECT_EQ(read[i], Value(UBits(i, 64)));
+  }
+}
+
+TEST(SpscJitChannelQueueTest, ManagerSelectsSpscQueues) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * spsc_channel,
+      package.CreateStreamingChannel("spsc", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * mpsc_channel,
+      package.CreateStreamingChannel("mpsc", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * input_channel,
+      package.CreateStreamingChannel("in", ChannelOps::kReceiveOnly,
+                                     package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * single_value_channel,
+      package.CreateSingleValueChannel("sv", ChannelOps::kSendReceive,
+                                       package.GetBitsType(32)));
+
+  // Two producers, one of which also feeds the single-value channel.
+  for (std::string_view name : {"producer0", "producer1"}) {
+    ProcBuilder pb(name, &package);
+    BValue tok = pb.Literal(Value::Token());
+    BValue value = pb.Literal(UBits(42, 32));
+    pb.Send(mpsc_channel, tok, value);
+    if (name == "producer0") {
+      pb.Send(spsc_channel, tok, value);
+      pb.Send(single_value_channel, tok, value);
+    }
+    XLS_ASSERT_OK(pb.Build().status());
+  }
+  ProcBuilder pb("consumer", &package);
+  BValue tok = pb.Literal(Value::Token());
+  pb.Receive(spsc_channel, tok);
+  pb.Receive(mpsc_channel, tok);
+  pb.Receive(input_channel, tok);
+  pb.Receive(single_value_channel, tok);
+  XLS_ASSERT_OK(pb.Build().status());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<OrcJit> orc_jit, OrcJit::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(auto data_layout, orc_jit->CreateDataLayout());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<JitChannelQueueManager> queue_manager,
+      JitChannelQueueManager::CreateThreadSafe(
+          &package, std::make_unique<JitRuntime>(data_layout)));
+
+  auto is_spsc = [&](Channel* channel) {
+    return dynamic_cast<SpscJitChannelQueue*>(
+               &queue_manager->GetJitQueue(channel)) != nullptr;
+  };
+  EXPECT_TRUE(is_spsc(spsc_channel));
+  EXPECT_FALSE(is_spsc(mpsc_channel));
+  EXPECT_FALSE(is_spsc(input_channel));
+  EXPECT_FALSE(is_spsc(single_value_channel));
+}
+
 }  // namespace
 }  // namespace xls
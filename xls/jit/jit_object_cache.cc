@@ -0,0 +1,184 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/jit_object_cache.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>  // NOLINT
+#include <utility>
+
+#include "absl/base/no_destructor.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "llvm/include/llvm/ADT/StringExtras.h"
+#include "llvm/include/llvm/ADT/StringRef.h"
+#include "llvm/include/llvm/IR/Metadata.h"
+#include "llvm/include/llvm/IR/Module.h"
+#include "llvm/include/llvm/Support/Casting.h"
+#include "llvm/include/llvm/Support/ErrorOr.h"
+#include "llvm/include/llvm/Support/MemoryBuffer.h"
+#include "llvm/include/llvm/Support/SHA256.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/jit/llvm_compiler.h"
+
+namespace xls {
+namespace {
+
+// Name of the named metadata node holding the cache key of a module.
+constexpr std::string_view kCacheKeyMetadata = "xls.object_cache_key";
+
+struct CacheDirectory {
+  absl::Mutex mutex;
+  std::optional<std::filesystem::path> path ABSL_GUARDED_BY(mutex);
+};
+
+CacheDirectory& GetCacheDirectory() {
+  static absl::NoDestructor<CacheDirectory> directory;
+  return *directory;
+}
+
+}  // namespace
+
+/* static */ std::string JitObjectCache::ComputeKey(
+    const llvm::Module& module, std::string_view compiler_options) {
+  llvm::SHA256 hasher;
+  hasher.update(llvm::StringRef(compiler_options));
+  // Separate the options from the IR text so distinct (options, IR) pairs
+  // cannot produce the same hashed byte stream.
+  hasher.update(llvm::StringRef("\0", 1));
+  hasher.update(DumpLlvmModuleToString(&module));
+  return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+/* static */ void JitObjectCache::SetModuleKey(llvm::Module& module,
+                                              std::string_view key) {
+  llvm::NamedMDNode* node =
+      module.getOrInsertNamedMetadata(kCacheKeyMetadata);
+  node->clearOperands();
+  node->addOperand(llvm::MDNode::get(
+      module.getContext(), {llvm::MDString::get(module.getContext(), key)}));
+}
+
+/* static */ std::optional<std::string> JitObjectCache::GetModuleKey(
+    const llvm::Module& module) {
+  llvm::NamedMDNode* node = module.getNamedMetadata(kCacheKeyMetadata);
+  if (node == nullptr || node->getNumOperands() != 1) {
+    return std::nullopt;
+  }
+  auto* key =
+      llvm::dyn_cast<llvm::MDString>(node->getOperand(0)->getOperand(0));
+  if (key == nullptr) {
+    return std::nullopt;
+  }
+  return key->getString().str();
+}
+
+std::filesystem::path JitObjectCache::ObjectPath(std::string_view key) const {
+  return directory_ / absl::StrFormat("%s.o", key);
+}
+
+bool JitObjectCache::Lookup(const llvm::Module* module, std::string_view key) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> object =
+      llvm::MemoryBuffer::getFile(ObjectPath(key).string(), /*IsText=*/false,
+                                  /*RequiresNullTerminator=*/false);
+  if (!object) {
+    misses_.fetch_add(1);
+    VLOG(2) << absl::StreamFormat("JIT object cache miss: %s", key);
+    return false;
+  }
+  hits_.fetch_add(1);
+  VLOG(2) << absl::StreamFormat("JIT object cache hit: %s", key);
+  absl::MutexLock lock(&mutex_);
+  staged_objects_[module] = {std::string(key), std::move(object.get())};
+  return true;
+}
+
+std::unique_ptr<llvm::MemoryBuffer> JitObjectCache::getObject(
+    const llvm::Module* module) {
+  std::optional<std::string> key = GetModuleKey(*module);
+  if (!key.has_value()) {
+    return nullptr;
+  }
+  absl::MutexLock lock(&mutex_);
+  auto it = staged_objects_.find(module);
+  if (it == staged_objects_.end()) {
+    return nullptr;
+  }
+  // The entry may be left over from a module at the same address whose
+  // compilation failed before claiming it.
+  std::unique_ptr<llvm::MemoryBuffer> object;
+  if (it->second.first == *key) {
+    object = std::move(it->second.second);
+  }
+  staged_objects_.erase(it);
+  return object;
+}
+
+void JitObjectCache::notifyObjectCompiled(const llvm::Module* module,
+                                          llvm::MemoryBufferRef object) {
+  std::optional<std::string> key = GetModuleKey(*module);
+  if (!key.has_value()) {
+    return;
+  }
+  // Write to a uniquely named temporary file and rename it into place so
+  // concurrent readers never observe a partially written object.
+  static std::atomic<int64_t> temp_file_count = 0;
+  std::filesystem::path path = ObjectPath(*key);
+  std::filesystem::path temp_path = directory_ / absl::StrFormat(
+      "%s.%d.%d.tmp", *key, getpid(), temp_file_count.fetch_add(1));
+  absl::Status status = RecursivelyCreateDir(directory_);
+  if (status.ok()) {
+    status = SetFileContents(
+        temp_path, std::string_view(object.getBufferStart(),
+                                    object.getBufferSize()));
+  }
+  if (status.ok()) {
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+      status = absl::InternalError(absl::StrFormat(
+          "Unable to rename %s to %s: %s", temp_path.string(), path.string(),
+          ec.message()));
+      std::filesystem::remove(temp_path, ec);
+    }
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Unable to write JIT object cache entry: " << status;
+  }
+}
+
+void SetJitObjectCacheDirectory(
+    std::optional<std::filesystem::path> directory) {
+  CacheDirectory& cache_directory = GetCacheDirectory();
+  absl::MutexLock lock(&cache_directory.mutex);
+  cache_directory.path = std::move(directory);
+}
+
+std::optional<std::filesystem::path> GetJitObjectCacheDirectory() {
+  CacheDirectory& cache_directory = GetCacheDirectory();
+  absl::MutexLock lock(&cache_directory.mutex);
+  return cache_directory.path;
+}
+
+}  // namespace xls
@@ -0,0 +1,106 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_JIT_OBJECT_CACHE_H_
+#define XLS_JIT_JIT_OBJECT_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "llvm/include/llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/include/llvm/Support/MemoryBuffer.h"
+
+namespace llvm {
+class Module;
+}  // namespace llvm
+
+namespace xls {
+
+// A persistent llvm::ObjectCache which stores compiled object files in a
+// directory. Objects are content-addressed: the key is a hash of the
+// unoptimized LLVM IR text along with everything else which affects code
+// generation (opt level, target triple, CPU features, and JIT options) so a
+// cached object is reused only when compiling it again would produce the same
+// code. The directory may be shared between concurrent processes.
+//
+// Because the key is computed from the unoptimized module the lookup happens
+// before optimization. The compiler calls Lookup() and, on a hit, skips the
+// optimization pipeline; getObject() then hands the loaded object to the
+// compile layer which skips code generation.
+class JitObjectCache final : public llvm::ObjectCache {
+ public:
+  explicit JitObjectCache(std::filesystem::path directory)
+      : directory_(std::move(directory)) {}
+
+  // Returns the cache key of the (unoptimized) `module` when compiled with
+  // the given options. `compiler_options` must uniquely describe every other
+  // input of code generation.
+  static std::string ComputeKey(const llvm::Module& module,
+                                std::string_view compiler_options);
+
+  // Records `key` in `module` so the key is available in getObject and
+  // notifyObjectCompiled which only receive the (optimized) module.
+  static void SetModuleKey(llvm::Module& module, std::string_view key);
+  static std::optional<std::string> GetModuleKey(const llvm::Module& module);
+
+  // Looks up the object for `key` in the cache directory. Returns true and
+  // stages the object for the following getObject call for `module` on a hit.
+  // Objects are staged per module so concurrent compilations of identical
+  // modules, which share a key, each get their own object.
+  bool Lookup(const llvm::Module* module, std::string_view key);
+
+  // llvm::ObjectCache implementation.
+  void notifyObjectCompiled(const llvm::Module* module,
+                            llvm::MemoryBufferRef object) override;
+  std::unique_ptr<llvm::MemoryBuffer> getObject(
+      const llvm::Module* module) override;
+
+  const std::filesystem::path& directory() const { return directory_; }
+  int64_t hits() const { return hits_.load(); }
+  int64_t misses() const { return misses_.load(); }
+
+ private:
+  std::filesystem::path ObjectPath(std::string_view key) const;
+
+  std::filesystem::path directory_;
+  std::atomic<int64_t> hits_ = 0;
+  std::atomic<int64_t> misses_ = 0;
+
+  absl::Mutex mutex_;
+  // Objects loaded by Lookup which have not yet been claimed by getObject,
+  // along with their keys.
+  absl::flat_hash_map<
+      const llvm::Module*,
+      std::pair<std::string, std::unique_ptr<llvm::MemoryBuffer>>>
+      staged_objects_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Sets the directory of the persistent object cache used by every OrcJit
+// created afterwards in this process. std::nullopt (the default) disables the
+// cache.
+void SetJitObjectCacheDirectory(std::optional<std::filesystem::path> directory);
+std::optional<std::filesystem::path> GetJitObjectCacheDirectory();
+
+}  // namespace xls
+
+#endif  // XLS_JIT_JIT_OBJECT_CACHE_H_
@@ -0,0 +1,164 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/jit_object_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "llvm/include/llvm/IR/LLVMContext.h"
+#include "llvm/include/llvm/IR/Module.h"
+#include "llvm/include/llvm/Support/MemoryBuffer.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/function_jit.h"
+#include "xls/jit/observer.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+
+constexpr std::string_view kIr = R"(
+package p
+
+top fn f(x: bits[32], y: bits[32]) -> bits[32] {
+  umul.1: bits[32] = umul(x, y)
+  ret add.2: bits[32] = add(umul.1, x)
+}
+)";
+
+class CacheCountingObserver final : public JitObserver {
+ public:
+  JitObserverRequests GetNotificationOptions() const override {
+    return JitObserverRequests{.object_cache_lookup = true};
+  }
+  void ObjectCacheLookup(const llvm::Module* module, bool hit) override {
+    ++(hit ? hits : misses);
+  }
+
+  int64_t hits = 0;
+  int64_t misses = 0;
+};
+
+class JitObjectCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+    temp_dir_.emplace(std::move(temp_dir));
+    SetJitObjectCacheDirectory(temp_dir_->path());
+  }
+  void TearDown() override { SetJitObjectCacheDirectory(std::nullopt); }
+
+  absl::StatusOr<Value> CompileAndRun(Function* f, int64_t opt_level,
+                                      JitObserver* observer) {
+    XLS_ASSIGN_OR_RETURN(
+        std::unique_ptr<FunctionJit> jit,
+        FunctionJit::Create(f, opt_level, /*include_observer_callbacks=*/false,
+                            observer));
+    XLS_ASSIGN_OR_RETURN(
+        InterpreterResult<Value> result,
+        jit->Run(std::vector<Value>{Value(UBits(3, 32)), Value(UBits(5, 32))}));
+    return result.value;
+  }
+
+  std::optional<TempDirectory> temp_dir_;
+};
+
+TEST_F(JitObjectCacheTest, SecondCompilationHitsCache) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                           Parser::ParsePackage(kIr));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetTopAsFunction());
+
+  CacheCountingObserver observer;
+  EXPECT_THAT(CompileAndRun(f, /*opt_level=*/3, &observer),
+              IsOkAndHolds(Value(UBits(18, 32))));
+  EXPECT_EQ(observer.hits, 0);
+  EXPECT_EQ(observer.misses, 1);
+
+  EXPECT_THAT(CompileAndRun(f, /*opt_level=*/3, &observer),
+              IsOkAndHolds(Value(UBits(18, 32))));
+  EXPECT_EQ(observer.hits, 1);
+  EXPECT_EQ(observer.misses, 1);
+
+  // A different optimization level produces different code so must not reuse
+  // the cached object.
+  EXPECT_THAT(CompileAndRun(f, /*opt_level=*/1, &observer),
+              IsOkAndHolds(Value(UBits(18, 32))));
+  EXPECT_EQ(observer.hits, 1);
+  EXPECT_EQ(observer.misses, 2);
+}
+
+TEST_F(JitObjectCacheTest, DifferentFunctionMissesCache) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                           Parser::ParsePackage(kIr));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetTopAsFunction());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p2,
+                           Parser::ParsePackage(R"(
+package p
+
+top fn f(x: bits[32], y: bits[32]) -> bits[32] {
+  umul.1: bits[32] = umul(x, y)
+  ret sub.2: bits[32] = sub(umul.1, x)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f2, p2->GetTopAsFunction());
+
+  CacheCountingObserver observer;
+  EXPECT_THAT(CompileAndRun(f, /*opt_level=*/3, &observer),
+              IsOkAndHolds(Value(UBits(18, 32))));
+  EXPECT_THAT(CompileAndRun(f2, /*opt_level=*/3, &observer),
+              IsOkAndHolds(Value(UBits(12, 32))));
+  EXPECT_EQ(observer.hits, 0);
+  EXPECT_EQ(observer.misses, 2);
+}
+
+TEST_F(JitObjectCacheTest, IdenticalModulesEachGetTheirObject) {
+  constexpr std::string_view kKey = "0123abcd";
+  XLS_ASSERT_OK(SetFileContents(temp_dir_->path() / "0123abcd.o", "object"));
+  JitObjectCache cache(temp_dir_->path());
+
+  // Identical modules compiled concurrently share a key but must each get the
+  // cached object; otherwise one of them would be compiled unoptimized.
+  llvm::LLVMContext context;
+  llvm::Module a("m", context);
+  llvm::Module b("m", context);
+  JitObjectCache::SetModuleKey(a, kKey);
+  JitObjectCache::SetModuleKey(b, kKey);
+  EXPECT_TRUE(cache.Lookup(&a, kKey));
+  EXPECT_TRUE(cache.Lookup(&b, kKey));
+  std::unique_ptr<llvm::MemoryBuffer> a_object = cache.getObject(&a);
+  std::unique_ptr<llvm::MemoryBuffer> b_object = cache.getObject(&b);
+  ASSERT_NE(a_object, nullptr);
+  ASSERT_NE(b_object, nullptr);
+  EXPECT_EQ(a_object->getBuffer().str(), "object");
+  EXPECT_EQ(b_object->getBuffer().str(), "object");
+  EXPECT_EQ(cache.getObject(&a), nullptr);
+}
+
+}  // namespace
+}  // namespace xls
@@ -38,6 +38,7 @@
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/evaluator_options.h"
+#include "xls/interpreter/parallel_proc_runtime.h"
 #include "xls/interpreter/proc_evaluator.h"
 #include "xls/interpreter/serial_proc_runtime.h"
 #include "xls/ir/package.h"
@@ -232,7 +233,14 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateAotRuntime(
   return std::move(proc_runtime);
 }
 
-absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateRuntime(
+// ProcJits for every proc in an elaboration along with the queue manager they
+// communicate through.
+struct ProcJitsAndQueueManager {
+  std::vector<std::unique_ptr<ProcEvaluator>> proc_jits;
+  std::unique_ptr<JitChannelQueueManager> queue_manager;
+};
+
+absl::StatusOr<ProcJitsAndQueueManager> CreateProcJits(
     ProcElaboration elaboration, const EvaluatorOptions& options) {
   // We use the compiler to know the data layout.
   XLS_ASSIGN_OR_RETURN(
@@ -243,27 +251,53 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateRuntime(
   XLS_ASSIGN_OR_RETURN(llvm::DataLayout layout, comp->CreateDataLayout());
   // Create a queue manager for the queues. This factory verifies that there an
   // receive only queue for every receive only channel.
+  ProcJitsAndQueueManager result;
   XLS_ASSIGN_OR_RETURN(
-      std::unique_ptr<JitChannelQueueManager> queue_manager,
+      result.queue_manager,
       JitChannelQueueManager::CreateThreadSafe(
           std::move(elaboration), std::make_unique<JitRuntime>(layout)));
 
   // Create a ProcJit for each Proc.
-  std::vector<std::unique_ptr<ProcEvaluator>> proc_jits;
-  for (Proc* proc : queue_manager->elaboration().procs()) {
+  for (Proc* proc : result.queue_manager->elaboration().procs()) {
     XLS_ASSIGN_OR_RETURN(
         std::unique_ptr<ProcJit> proc_jit,
         ProcJit::Create(
-            proc, &queue_manager->runtime(), queue_manager.get(),
+            proc, &result.queue_manager->runtime(),
+            result.queue_manager.get(),
             /*include_observer_callbacks=*/options.support_observers()));
-    proc_jits.push_back(std::move(proc_jit));
+    result.proc_jits.push_back(std::move(proc_jit));
   }
+  return result;
+}
+
+absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateRuntime(
+    ProcElaboration elaboration, const EvaluatorOptions& options) {
+  XLS_ASSIGN_OR_RETURN(ProcJitsAndQueueManager jits,
+                       CreateProcJits(std::move(elaboration), options));
+
+  // Create a runtime.
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<SerialProcRuntime> proc_runtime,
+                       SerialProcRuntime::Create(std::move(jits.proc_jits),
+                                                 std::move(jits.queue_manager),
+                                                 options));
+
+  XLS_RETURN_IF_ERROR(InsertInitialChannelValues(
+      proc_runtime->elaboration(), proc_runtime->queue_manager()));
+  return std::move(proc_runtime);
+}
+
+absl::StatusOr<std::unique_ptr<ParallelProcRuntime>> CreateParallelRuntime(
+    ProcElaboration elaboration, const EvaluatorOptions& options,
+    std::optional<int64_t> thread_count) {
+  XLS_ASSIGN_OR_RETURN(ProcJitsAndQueueManager jits,
+                       CreateProcJits(std::move(elaboration), options));
 
   // Create a runtime.
   XLS_ASSIGN_OR_RETURN(
-      std::unique_ptr<SerialProcRuntime> proc_runtime,
-      SerialProcRuntime::Create(std::move(proc_jits), std::move(queue_manager),
-                                options));
+      std::unique_ptr<ParallelProcRuntime> proc_runtime,
+      ParallelProcRuntime::Create(std::move(jits.proc_jits),
+                                  std::move(jits.queue_manager), options,
+                                  thread_count));
 
   XLS_RETURN_IF_ERROR(InsertInitialChannelValues(
       proc_runtime->elaboration(), proc_runtime->queue_manager()));
@@ -286,6 +320,22 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateJitSerialProcRuntime(
   return CreateRuntime(std::move(elaboration), options);
 }
 
+absl::StatusOr<std::unique_ptr<ParallelProcRuntime>>
+CreateJitParallelProcRuntime(Package* package, const EvaluatorOptions& options,
+                             std::optional<int64_t> thread_count) {
+  XLS_ASSIGN_OR_RETURN(ProcElaboration elaboration,
+                       ProcElaboration::ElaborateOldStylePackage(package));
+  return CreateParallelRuntime(std::move(elaboration), options, thread_count);
+}
+
+absl::StatusOr<std::unique_ptr<ParallelProcRuntime>>
+CreateJitParallelProcRuntime(Proc* top, const EvaluatorOptions& options,
+                             std::optional<int64_t> thread_count) {
+  XLS_ASSIGN_OR_RETURN(ProcElaboration elaboration,
+                       ProcElaboration::Elaborate(top));
+  return CreateParallelRuntime(std::move(elaboration), options, thread_count);
+}
+
 absl::StatusOr<JitObjectCode> CreateProcAotObjectCode(Package* package,
                                                       int64_t opt_level,
                                                       bool with_msan,
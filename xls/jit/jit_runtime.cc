@@ -38,6 +38,7 @@
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/jit/llvm_type_converter.h"
+#include "xls/jit/type_layout.h"
 
 namespace xls {
 
@@ -66,6 +67,42 @@ absl::Status JitRuntime::PackArgs(absl::Span<const Value> args,
   return absl::OkStatus();
 }
 
+absl::Status JitRuntime::PackArgs(absl::Span<const Value> args,
+                                  absl::Span<const TypeLayout> arg_layouts,
+                                  absl::Span<uint8_t* const> arg_buffers) {
+  if (arg_layouts.size() != args.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Number of argument layouts does not match number of arguments: %d "
+        "vs. %d",
+        arg_layouts.size(), args.size()));
+  }
+  if (arg_buffers.size() < args.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Input buffer is not large enough to hold all arguments: %d vs. %d",
+        arg_buffers.size(), args.size()));
+  }
+  for (int64_t i = 0; i < args.size(); ++i) {
+    arg_layouts[i].ValueToNativeLayout(args[i], arg_buffers[i]);
+  }
+  return absl::OkStatus();
+}
+
+TypeLayout JitRuntime::CreateTypeLayout(Type* xls_type) {
+  absl::MutexLock lock(&mutex_);
+  return type_converter_->CreateTypeLayout(xls_type);
+}
+
+std::vector<TypeLayout> JitRuntime::CreateTypeLayouts(
+    absl::Span<Type* const> xls_types) {
+  absl::MutexLock lock(&mutex_);
+  std::vector<TypeLayout> layouts;
+  layouts.reserve(xls_types.size());
+  for (Type* xls_type : xls_types) {
+    layouts.push_back(type_converter_->CreateTypeLayout(xls_type));
+  }
+  return layouts;
+}
+
 Value JitRuntime::UnpackBuffer(const uint8_t* buffer, const Type* result_type) {
   absl::MutexLock lock(&mutex_);
   return UnpackBufferInternal(buffer, result_type);
@@ -18,6 +18,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
@@ -27,6 +28,7 @@
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/jit/llvm_type_converter.h"
+#include "xls/jit/type_layout.h"
 
 namespace xls {
 
@@ -45,6 +47,12 @@ class JitRuntime {
                         absl::Span<Type* const> arg_types,
                         absl::Span<uint8_t* const> arg_buffers);
 
+  // As above but uses precomputed layouts of the argument types. Does not
+  // consult LLVM or acquire any lock.
+  absl::Status PackArgs(absl::Span<const Value> args,
+                        absl::Span<const TypeLayout> arg_layouts,
+                        absl::Span<uint8_t* const> arg_buffers);
+
   // Returns a Value constructed from the data inside "buffer" whose
   // contents are laid out according to the LLVM interpretation of the passed-in
   // type.
@@ -55,6 +63,13 @@ class JitRuntime {
   void BlitValueToBuffer(const Value& value, const Type* type,
                          absl::Span<uint8_t> buffer);
 
+  // Returns the native layout of the given type. Converting values with the
+  // returned TypeLayout is lock-free and much cheaper than UnpackBuffer and
+  // BlitValueToBuffer so callers which repeatedly convert values of a fixed
+  // type should create its layout once up front.
+  TypeLayout CreateTypeLayout(Type* xls_type);
+  std::vector<TypeLayout> CreateTypeLayouts(absl::Span<Type* const> xls_types);
+
   const llvm::DataLayout& data_layout() { return data_layout_; }
 
   // Returns the number of bytes that should be allocated for a native LLVM
@@ -43,6 +43,12 @@ JitObserverRequests CompoundJitObserver::GetNotificationOptions() const {
                          [](auto* o) {
                            return o->GetNotificationOptions().assembly_code_str;
                          }),
+      .object_cache_lookup =
+          absl::c_any_of(observers_,
+                         [](auto* o) {
+                           return o->GetNotificationOptions()
+                               .object_cache_lookup;
+                         }),
   };
 }
 void CompoundJitObserver::UnoptimizedModule(const llvm::Module* module) {
@@ -67,6 +73,14 @@ void CompoundJitObserver::AssemblyCodeString(const llvm::Module* module,
     }
   }
 }
+void CompoundJitObserver::ObjectCacheLookup(const llvm::Module* module,
+                                            bool hit) {
+  for (auto* o : observers_) {
+    if (o->GetNotificationOptions().object_cache_lookup) {
+      o->ObjectCacheLookup(module, hit);
+    }
+  }
+}
 
 void CompoundJitObserver::AddObserver(JitObserver* o) {
   observers_.push_back(o);
@@ -45,6 +45,8 @@ struct JitObserverRequests {
   bool optimized_module = false;
   // Do we want to get called with optimized asm code.
   bool assembly_code_str = false;
+  // Do we want to get called when the persistent object cache is consulted.
+  bool object_cache_lookup = false;
 };
 
 // Basic observer for JIT compilation events
@@ -60,6 +62,10 @@ class JitObserver {
   // Called when a LLVM module has been compiled with the module code.
   virtual void AssemblyCodeString(const llvm::Module* module,
                                   std::string_view asm_code) {}
+  // Called when the object code for a LLVM module is looked up in the
+  // persistent object cache. `hit` is true if the compiled object was found in
+  // which case optimization and code generation are skipped.
+  virtual void ObjectCacheLookup(const llvm::Module* module, bool hit) {}
 };
 
 // A compound observer that lets one trigger multiple observers at once.
@@ -72,6 +78,7 @@ class CompoundJitObserver final : public JitObserver {
   void OptimizedModule(const llvm::Module* module) final;
   void AssemblyCodeString(const llvm::Module* module,
                           std::string_view asm_code) final;
+  void ObjectCacheLookup(const llvm::Module* module, bool hit) final;
 
   void AddObserver(JitObserver* o);
 
@@ -14,12 +14,15 @@
 
 #include "xls/jit/orc_jit.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <filesystem>  // NOLINT
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "absl/log/log.h"
 #include "absl/log/vlog_is_on.h"
@@ -28,8 +31,11 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
 #include "llvm/include/llvm/ADT/SmallVector.h"
 #include "llvm/include/llvm/Analysis/CGSCCPassManager.h"
+#include "llvm/include/llvm/Bitcode/BitcodeReader.h"
+#include "llvm/include/llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/AbsoluteSymbols.h"  // IWYU pragma: keep
 #include "llvm/include/llvm/ExecutionEngine/Orc/CompileUtils.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/Core.h"
@@ -41,23 +47,30 @@
 #include "llvm/include/llvm/ExecutionEngine/Orc/Layer.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/Shared/ExecutorAddress.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/Shared/ExecutorSymbolDef.h"
+#include "llvm/include/llvm/ExecutionEngine/Orc/TaskDispatch.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
 #include "llvm/include/llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/include/llvm/IR/BasicBlock.h"
 #include "llvm/include/llvm/IR/DataLayout.h"
+#include "llvm/include/llvm/IR/Function.h"
 #include "llvm/include/llvm/IR/Instruction.h"
+#include "llvm/include/llvm/IR/LLVMContext.h"
 #include "llvm/include/llvm/IR/LegacyPassManager.h"
 #include "llvm/include/llvm/IR/Module.h"
 #include "llvm/include/llvm/IRPrinter/IRPrintingPasses.h"
 #include "llvm/include/llvm/Passes/PassBuilder.h"
 #include "llvm/include/llvm/Support/CodeGen.h"
 #include "llvm/include/llvm/Support/Error.h"
+#include "llvm/include/llvm/Support/MemoryBuffer.h"
 #include "llvm/include/llvm/Support/raw_ostream.h"
 #include "llvm/include/llvm/Transforms/Instrumentation/MemorySanitizer.h"
+#include "llvm/include/llvm/Transforms/Utils/SplitModule.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/jit/jit_clang_builtins.h"
 #include "xls/jit/jit_emulated_tls.h"  // NOLINT: Used with MSAN
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/llvm_compiler.h"
 #include "xls/jit/observer.h"
 
@@ -68,7 +81,10 @@ OrcJit::OrcJit(int64_t opt_level, bool include_msan,
     : LlvmCompiler(opt_level, include_msan, include_observer_callbacks),
       context_(std::make_unique<llvm::LLVMContext>()),
       execution_session_(
-          std::make_unique<llvm::orc::UnsupportedExecutorProcessControl>()),
+          std::make_unique<llvm::orc::UnsupportedExecutorProcessControl>(
+              /*SSP=*/nullptr,
+              std::make_unique<llvm::orc::DynamicThreadPoolTaskDispatcher>(
+                  std::optional<size_t>(AvailableCPUs())))),
       object_layer_(
           execution_session_,
           []() { return std::make_unique<llvm::SectionMemoryManager>(); }),
@@ -85,11 +101,41 @@ llvm::Expected<llvm::orc::ThreadSafeModule> OrcJit::Optimizer(
     const llvm::orc::MaterializationResponsibility& responsibility) {
   llvm::Module* bare_module = module.getModuleUnlocked();
 
-  VLOG(2) << "Unoptimized module IR:";
-  XLS_VLOG_LINES(2, DumpLlvmModuleToString(bare_module));
-  if (jit_observer_ != nullptr &&
-      jit_observer_->GetNotificationOptions().unoptimized_module) {
-    jit_observer_->UnoptimizedModule(bare_module);
+  // Modules may be optimized concurrently on the execution session's thread
+  // pool. Only the optimization itself runs outside of `observer_mutex_`.
+  {
+    absl::MutexLock lock(&observer_mutex_);
+    VLOG(2) << "Unoptimized module IR:";
+    XLS_VLOG_LINES(2, DumpLlvmModuleToString(bare_module));
+    if (jit_observer_ != nullptr &&
+        jit_observer_->GetNotificationOptions().unoptimized_module) {
+      jit_observer_->UnoptimizedModule(bare_module);
+    }
+  }
+
+  if (object_cache_ != nullptr) {
+    std::string key =
+        JitObjectCache::ComputeKey(*bare_module, ObjectCacheOptions());
+    JitObjectCache::SetModuleKey(*bare_module, key);
+    // Observers of the optimized module or the generated assembly require the
+    // module to actually be compiled so bypass the lookup for them. The
+    // compiled object is still added to the cache.
+    bool requires_compilation =
+        jit_observer_ != nullptr &&
+        (jit_observer_->GetNotificationOptions().optimized_module ||
+         jit_observer_->GetNotificationOptions().assembly_code_str);
+    if (!requires_compilation) {
+      bool hit = object_cache_->Lookup(bare_module, key);
+      if (jit_observer_ != nullptr &&
+          jit_observer_->GetNotificationOptions().object_cache_lookup) {
+        absl::MutexLock lock(&observer_mutex_);
+        jit_observer_->ObjectCacheLookup(bare_module, hit);
+      }
+      if (hit) {
+        // The compile layer gets the cached object from the object cache.
+        return module;
+      }
+    }
   }
 
   auto error = PerformStandardOptimization(bare_module);
@@ -97,6 +143,7 @@ llvm::Expected<llvm::orc::ThreadSafeModule> OrcJit::Optimizer(
     return llvm::Expected<llvm::orc::ThreadSafeModule>(std::move(error));
   }
 
+  absl::MutexLock lock(&observer_mutex_);
   VLOG(2) << "Optimized module IR:";
   XLS_VLOG_LINES(2, DumpLlvmModuleToString(bare_module));
   if (jit_observer_ != nullptr &&
@@ -221,7 +268,23 @@ absl::Status OrcJit::InitInternal() {
   // Add some selected compiler-rt symbols.
   XLS_RETURN_IF_ERROR(AddCompilerRtSymbols(dylib_, data_layout_));
 
-  auto compiler = std::make_unique<llvm::orc::SimpleCompiler>(*target_machine_);
+  std::optional<std::filesystem::path> cache_directory =
+      GetJitObjectCacheDirectory();
+  if (cache_directory.has_value()) {
+    object_cache_ = std::make_unique<JitObjectCache>(*cache_directory);
+  }
+  // Modules are compiled on the execution session's thread pool so each
+  // compilation creates its own target machine.
+  auto error_or_target_builder =
+      llvm::orc::JITTargetMachineBuilder::detectHost();
+  if (!error_or_target_builder) {
+    return absl::InternalError(
+        absl::StrCat("Unable to detect host: ",
+                     llvm::toString(error_or_target_builder.takeError())));
+  }
+  error_or_target_builder->setRelocationModel(llvm::Reloc::Model::PIC_);
+  auto compiler = std::make_unique<llvm::orc::ConcurrentIRCompiler>(
+      std::move(*error_or_target_builder), object_cache_.get());
   compile_layer_ = std::make_unique<llvm::orc::IRCompileLayer>(
       execution_session_, object_layer_, std::move(compiler));
 
@@ -237,13 +300,86 @@ absl::Status OrcJit::InitInternal() {
   return absl::OkStatus();
 }
 
+std::string OrcJit::ObjectCacheOptions() const {
+  return absl::StrFormat(
+      "opt_level=%d;triple=%s;cpu=%s;features=%s;msan=%d;"
+      "observer_callbacks=%d",
+      opt_level(), target_machine_->getTargetTriple().str(),
+      target_machine_->getTargetCPU().str(),
+      target_machine_->getTargetFeatureString().str(), include_msan(),
+      include_observer_callbacks());
+}
+
+absl::StatusOr<std::vector<llvm::orc::ThreadSafeModule>> OrcJit::SplitModule(
+    std::unique_ptr<llvm::Module>&& module) {
+  int64_t instruction_count = 0;
+  for (const llvm::Function& function : *module) {
+    instruction_count += function.getInstructionCount();
+  }
+  int64_t part_count = std::min<int64_t>(
+      instruction_count / std::max<int64_t>(min_instructions_per_module_, 1),
+      max_modules_per_compilation_.value_or(AvailableCPUs()));
+  std::vector<llvm::orc::ThreadSafeModule> modules;
+  if (part_count < 2) {
+    modules.push_back(llvm::orc::ThreadSafeModule(std::move(module), context_));
+    return modules;
+  }
+
+  // Each part is given its own LLVM context so the parts can be optimized and
+  // compiled concurrently. Parts are moved between contexts by round-tripping
+  // through bitcode.
+  absl::Status status = absl::OkStatus();
+  llvm::SplitModule(
+      *module, part_count,
+      [&](std::unique_ptr<llvm::Module> part) {
+        if (!status.ok()) {
+          return;
+        }
+        llvm::SmallVector<char, 0> bitcode;
+        llvm::raw_svector_ostream ostream(bitcode);
+        llvm::WriteBitcodeToFile(*part, ostream);
+        auto context = std::make_unique<llvm::LLVMContext>();
+        llvm::Expected<std::unique_ptr<llvm::Module>> parsed =
+            llvm::parseBitcodeFile(
+                llvm::MemoryBufferRef(
+                    std::string_view(bitcode.data(), bitcode.size()),
+                    part->getModuleIdentifier()),
+                *context);
+        if (!parsed) {
+          status = absl::InternalError(
+              absl::StrFormat("Unable to split LLVM module: %s",
+                              llvm::toString(parsed.takeError())));
+          return;
+        }
+        modules.push_back(llvm::orc::ThreadSafeModule(
+            std::move(*parsed),
+            llvm::orc::ThreadSafeContext(std::move(context))));
+      },
+      // Keep local symbols local. Each local is placed in the same part as its
+      // users so the private per-node functions can still be inlined and
+      // deleted rather than being externalized and kept in the object code.
+      /*PreserveLocals=*/true, /*RoundRobin=*/true);
+  XLS_RETURN_IF_ERROR(status);
+  VLOG(2) << absl::StreamFormat(
+      "Split LLVM module with %d instructions into %d modules",
+      instruction_count, modules.size());
+  return modules;
+}
+
 absl::Status OrcJit::CompileModule(std::unique_ptr<llvm::Module>&& module) {
   XLS_RETURN_IF_ERROR(VerifyModule(*module));
-  llvm::Error error = transform_layer_->add(
-      dylib_, llvm::orc::ThreadSafeModule(std::move(module), context_));
-  if (error) {
-    return absl::UnknownError(absl::StrFormat(
-        "Error compiling converted IR: %s", llvm::toString(std::move(error))));
+  // Adding a module does not compile it. Each module is optimized and compiled
+  // when one of its symbols is first looked up, and the modules it references
+  // are materialized concurrently while it is linked.
+  XLS_ASSIGN_OR_RETURN(std::vector<llvm::orc::ThreadSafeModule> modules,
+                       SplitModule(std::move(module)));
+  for (llvm::orc::ThreadSafeModule& part : modules) {
+    llvm::Error error = transform_layer_->add(dylib_, std::move(part));
+    if (error) {
+      return absl::UnknownError(
+          absl::StrFormat("Error compiling converted IR: %s",
+                          llvm::toString(std::move(error))));
+    }
   }
   return absl::OkStatus();
 }
@@ -17,10 +17,14 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/Core.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/IRTransformLayer.h"
@@ -31,6 +35,7 @@
 #include "llvm/include/llvm/Support/Error.h"
 #include "llvm/include/llvm/Support/raw_ostream.h"
 #include "llvm/include/llvm/Target/TargetMachine.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/llvm_compiler.h"
 #include "xls/jit/observer.h"
 
@@ -41,6 +46,10 @@ class OrcJit : public LlvmCompiler {
  public:
   static constexpr int64_t kDefaultOptLevel = 2;
 
+  // The default minimum number of LLVM instructions in each module compiled
+  // concurrently. See CompileModule.
+  static constexpr int64_t kDefaultMinInstructionsPerModule = 20000;
+
   ~OrcJit() override;
 
   absl::StatusOr<OrcJit*> AsOrcJit() override { return this; }
@@ -59,9 +68,26 @@ class OrcJit : public LlvmCompiler {
 
   JitObserver* jit_observer() const { return jit_observer_; }
 
-  // Compiles the given LLVM module into the JIT's execution session.
+  // Compiles the given LLVM module into the JIT's execution session. Large
+  // modules are split by function into several modules, each with its own LLVM
+  // context, which are optimized and compiled concurrently on the execution
+  // session's thread pool. Modules are materialized lazily when a symbol they
+  // define is first looked up.
   absl::Status CompileModule(std::unique_ptr<llvm::Module>&& module) override;
 
+  // Sets the minimum number of LLVM instructions in each module compiled
+  // concurrently. Modules with fewer than twice this many instructions are
+  // compiled as a single module which allows inlining across all functions.
+  void SetMinInstructionsPerModule(int64_t instructions) {
+    min_instructions_per_module_ = instructions;
+  }
+
+  // Sets the maximum number of modules a module is split into. Defaults to
+  // the number of available CPUs.
+  void SetMaxModulesPerCompilation(int64_t modules) {
+    max_modules_per_compilation_ = modules;
+  }
+
   // Returns the address of the given JIT'ed function.
   absl::StatusOr<llvm::orc::ExecutorAddr> LoadSymbol(
       std::string_view function_name);
@@ -72,6 +98,10 @@ class OrcJit : public LlvmCompiler {
   absl::StatusOr<std::unique_ptr<llvm::TargetMachine>> CreateTargetMachine()
       override;
 
+  // Returns the persistent object cache or nullptr if no cache directory was
+  // set with SetJitObjectCacheDirectory when this jit was created.
+  JitObjectCache* object_cache() const { return object_cache_.get(); }
+
  protected:
   absl::Status InitInternal() override;
 
@@ -84,15 +114,32 @@ class OrcJit : public LlvmCompiler {
       llvm::orc::ThreadSafeModule module,
       const llvm::orc::MaterializationResponsibility& responsibility);
 
+  // Returns a description of every compiler setting which affects the
+  // generated code. Part of the object cache key.
+  std::string ObjectCacheOptions() const;
+
+  // Splits `module` into modules which can be compiled concurrently. Returns
+  // `module` itself if it is too small to be worth splitting.
+  absl::StatusOr<std::vector<llvm::orc::ThreadSafeModule>> SplitModule(
+      std::unique_ptr<llvm::Module>&& module);
+
   llvm::orc::ThreadSafeContext context_;
   llvm::orc::ExecutionSession execution_session_;
   llvm::orc::RTDyldObjectLinkingLayer object_layer_;
   llvm::orc::JITDylib& dylib_;
 
+  // Must outlive the compile layer which refers to it.
+  std::unique_ptr<JitObjectCache> object_cache_;
   std::unique_ptr<llvm::orc::IRCompileLayer> compile_layer_;
   std::unique_ptr<llvm::orc::IRTransformLayer> transform_layer_;
 
   JitObserver* jit_observer_ = nullptr;
+  // Serializes observer notifications and assembly dumps as modules may be
+  // optimized concurrently.
+  absl::Mutex observer_mutex_;
+
+  int64_t min_instructions_per_module_ = kDefaultMinInstructionsPerModule;
+  std::optional<int64_t> max_modules_per_compilation_;
 };
 
 }  // namespace xls
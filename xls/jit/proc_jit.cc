@@ -54,6 +54,7 @@
 #include "xls/jit/llvm_compiler.h"
 #include "xls/jit/observer.h"
 #include "xls/jit/orc_jit.h"
+#include "xls/jit/type_layout.h"
 
 namespace xls {
 
@@ -133,6 +134,9 @@ class ProcJitContinuation : public ProcContinuation {
   int64_t continuation_point_;
   JitRuntime* jit_runtime_;
 
+  // Native layouts of the state elements indexed by state index.
+  std::vector<TypeLayout> state_layouts_;
+
   InterpreterEvents events_;
 
   // Buffers to hold inputs, outputs, and temporary storage. This is allocated
@@ -166,14 +170,17 @@ ProcJitContinuation::ProcJitContinuation(ProcInstance* proc_instance,
           InstanceContext::CreateForProc(proc_instance, std::move(queues))),
       observer_shim_(this),
       has_observer_callbacks_(has_observer_callbacks) {
+  std::vector<Type*> state_types;
+  for (StateElement* state_element : proc()->StateElements()) {
+    state_types.push_back(state_element->type());
+  }
+  state_layouts_ = jit_runtime_->CreateTypeLayouts(state_types);
+
   // Write initial state value to the input_buffer.
   for (StateElement* state_element : proc()->StateElements()) {
     int64_t state_index = *proc()->GetStateElementIndex(state_element);
-    jit_runtime->BlitValueToBuffer(
-        state_element->initial_value(), state_element->type(),
-        absl::Span<uint8_t>(
-            input_.pointers()[state_index],
-            jit_runtime_->GetTypeByteSize(state_element->type())));
+    state_layouts_[state_index].ValueToNativeLayout(
+        state_element->initial_value(), input_.pointers()[state_index]);
   }
 }
 
@@ -201,8 +208,8 @@ std::vector<Value> ProcJitContinuation::GetState() const {
   std::vector<Value> state;
   for (StateElement* state_element : proc()->StateElements()) {
     int64_t state_index = *proc()->GetStateElementIndex(state_element);
-    state.push_back(jit_runtime_->UnpackBuffer(input_.pointers()[state_index],
-                                               state_element->type()));
+    state.push_back(state_layouts_[state_index].NativeLayoutToValue(
+        input_.pointers()[state_index]));
   }
   return state;
 }
@@ -212,11 +219,8 @@ absl::Status ProcJitContinuation::SetState(std::vector<Value> v) {
 
   for (StateElement* state_element : proc()->StateElements()) {
     int64_t state_index = *proc()->GetStateElementIndex(state_element);
-    jit_runtime_->BlitValueToBuffer(
-        v[state_index], state_element->type(),
-        absl::Span<uint8_t>(
-            input_.pointers()[state_index],
-            jit_runtime_->GetTypeByteSize(state_element->type())));
+    state_layouts_[state_index].ValueToNativeLayout(
+        v[state_index], input_.pointers()[state_index]);
   }
 
   return absl::OkStatus();
@@ -14,23 +14,34 @@
 
 #include "xls/jit/switchable_function_jit.h"
 
+#include <atomic>
 #include <cstdint>
+#include <cstdlib>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "absl/types/span.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/ir_interpreter.h"
+#include "xls/ir/clone_package.h"
 #include "xls/ir/events.h"
 #include "xls/ir/function.h"
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
 #include "xls/ir/value.h"
 #include "xls/jit/function_jit.h"
 #include "xls/jit/observer.h"
@@ -48,6 +59,66 @@ constexpr ExecutionType kRealDefaultExecutionType = ExecutionType::kInterpreter;
 constexpr ExecutionType kRealDefaultExecutionType = ExecutionType::kJit;
 #endif
 
+namespace {
+
+// Tracks the tiered compilation threads which are still running so they can be
+// cancelled and waited for before LLVM's global state is torn down. The
+// registry itself is never destroyed so it does not depend on the order in
+// which static objects are destroyed.
+class RunningCompilations {
+ public:
+  static RunningCompilations& Get() {
+    static RunningCompilations* running_compilations = [] {
+      auto* result = new RunningCompilations();
+      // An atexit handler registered after an object with static storage
+      // duration is constructed runs before that object is destroyed. This is
+      // first reached from a CreateTiered call so LLVM's static objects are
+      // already constructed and outlive the handler.
+      std::atexit(+[] { Get().CancelAndWait(); });
+      return result;
+    }();
+    return *running_compilations;
+  }
+
+  // Registers a compilation whose pending tiers are skipped once `cancelled`
+  // is set.
+  void Add(std::atomic<bool>* cancelled) {
+    absl::MutexLock lock(&mutex_);
+    cancelled_flags_.insert(cancelled);
+    ++count_;
+  }
+  // Called once a compilation has compiled its last tier, while `cancelled`
+  // is still alive.
+  void Finished(std::atomic<bool>* cancelled) {
+    absl::MutexLock lock(&mutex_);
+    cancelled_flags_.erase(cancelled);
+  }
+  // Called once a finished compilation no longer uses LLVM.
+  void Remove() {
+    absl::MutexLock lock(&mutex_);
+    --count_;
+  }
+
+  // Cancels the tiers which have not started compiling and waits for the
+  // tiers in flight.
+  void CancelAndWait() {
+    absl::MutexLock lock(&mutex_);
+    for (std::atomic<bool>* cancelled : cancelled_flags_) {
+      cancelled->store(true, std::memory_order_relaxed);
+    }
+    mutex_.Await(absl::Condition(
+        +[](int64_t* count) { return *count == 0; }, &count_));
+  }
+
+ private:
+  absl::Mutex mutex_;
+  absl::flat_hash_set<std::atomic<bool>*> cancelled_flags_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace
+
 absl::StatusOr<std::unique_ptr<SwitchableFunctionJit>>
 SwitchableFunctionJit::CreateJit(Function* xls_function, int64_t opt_level,
                                  JitObserver* observer) {
@@ -55,14 +126,96 @@ SwitchableFunctionJit::CreateJit(Function* xls_function, int64_t opt_level,
       auto jit,
       FunctionJit::Create(xls_function, opt_level,
                           /*include_observer_callbacks=*/false, observer));
-  return std::unique_ptr<SwitchableFunctionJit>(new SwitchableFunctionJit(
-      xls_function, /*use_jit=*/true, std::move(jit)));
+  return std::unique_ptr<SwitchableFunctionJit>(
+      new SwitchableFunctionJit(xls_function, std::move(jit)));
 }
 
 absl::StatusOr<std::unique_ptr<SwitchableFunctionJit>>
 SwitchableFunctionJit::CreateInterpreter(Function* xls_function) {
   return std::unique_ptr<SwitchableFunctionJit>(
-      new SwitchableFunctionJit(xls_function, /*use_jit=*/false, nullptr));
+      new SwitchableFunctionJit(xls_function, nullptr));
+}
+
+absl::StatusOr<std::unique_ptr<SwitchableFunctionJit>>
+SwitchableFunctionJit::CreateTiered(Function* xls_function, int64_t opt_level,
+                                    JitObserver* observer) {
+  auto compilation = std::make_shared<TieredCompilation>();
+  XLS_ASSIGN_OR_RETURN(compilation->package,
+                       ClonePackage(xls_function->package()));
+  XLS_ASSIGN_OR_RETURN(compilation->function,
+                       compilation->package->GetFunction(xls_function->name()));
+  compilation->opt_level = opt_level;
+  compilation->observer = observer;
+
+  std::unique_ptr<SwitchableFunctionJit> jit(
+      new SwitchableFunctionJit(xls_function, nullptr));
+  jit->tiered_ = compilation;
+  // The thread owns a reference to the compilation state so it is detached
+  // rather than joined when this object is destroyed. It is waited for by
+  // ShutdownTieredCompilations instead.
+  RunningCompilations::Get().Add(&compilation->cancelled);
+  std::thread([compilation = std::move(compilation)]() mutable {
+    CompileTiers(*compilation);
+    compilation->done.Notify();
+    RunningCompilations::Get().Finished(&compilation->cancelled);
+    // Release the jits before signaling that LLVM is no longer in use.
+    compilation.reset();
+    RunningCompilations::Get().Remove();
+  }).detach();
+  return jit;
+}
+
+SwitchableFunctionJit::~SwitchableFunctionJit() {
+  if (tiered_ == nullptr) {
+    return;
+  }
+  tiered_->cancelled.store(true, std::memory_order_relaxed);
+  if (tiered_->observer != nullptr) {
+    tiered_->done.WaitForNotification();
+  }
+}
+
+/* static */ void SwitchableFunctionJit::ShutdownTieredCompilations() {
+  RunningCompilations::Get().CancelAndWait();
+}
+
+void SwitchableFunctionJit::WaitForCompilation() {
+  if (tiered_ != nullptr) {
+    tiered_->done.WaitForNotification();
+  }
+}
+
+void SwitchableFunctionJit::CompileTiers(TieredCompilation& compilation) {
+  std::vector<int64_t> tier_opt_levels;
+  if (compilation.opt_level > kBaselineOptLevel) {
+    tier_opt_levels.push_back(kBaselineOptLevel);
+  }
+  tier_opt_levels.push_back(compilation.opt_level);
+  for (int64_t tier_opt_level : tier_opt_levels) {
+    if (compilation.cancelled.load(std::memory_order_relaxed)) {
+      VLOG(2) << absl::StreamFormat(
+          "Cancelled compilation of `%s` at opt level %d",
+          compilation.function->name(), tier_opt_level);
+      return;
+    }
+    absl::StatusOr<std::unique_ptr<FunctionJit>> jit = FunctionJit::Create(
+        compilation.function, tier_opt_level,
+        /*include_observer_callbacks=*/false, compilation.observer);
+    if (!jit.ok()) {
+      LOG(WARNING) << absl::StreamFormat(
+          "Unable to JIT function `%s` at opt level %d, continuing on the "
+          "previous tier: %s",
+          compilation.function->name(), tier_opt_level,
+          jit.status().ToString());
+      return;
+    }
+    VLOG(2) << absl::StreamFormat("Switching `%s` to JIT at opt level %d",
+                                  compilation.function->name(),
+                                  tier_opt_level);
+    compilation.tier_jits.push_back(*std::move(jit));
+    compilation.current_jit.store(compilation.tier_jits.back().get(),
+                                  std::memory_order_release);
+  }
 }
 
 absl::StatusOr<std::unique_ptr<SwitchableFunctionJit>>
@@ -79,6 +232,9 @@ SwitchableFunctionJit::Create(Function* xls_function, ExecutionType execution,
     case ExecutionType::kJit:
       return SwitchableFunctionJit::CreateJit(xls_function, opt_level,
                                               observer);
+    case ExecutionType::kTiered:
+      return SwitchableFunctionJit::CreateTiered(xls_function, opt_level,
+                                                 observer);
     case ExecutionType::kDefault:
       LOG(FATAL) << "Unreachable";
   }
@@ -131,8 +287,8 @@ absl::StatusOr<InterpreterResult<Value>> Interpret(
 
 absl::StatusOr<InterpreterResult<Value>> SwitchableFunctionJit::Run(
     absl::Span<const Value> args) {
-  if (use_jit_) {
-    return function_jit_->Run(args);
+  if (FunctionJit* jit = CurrentJit(); jit != nullptr) {
+    return jit->Run(args);
   }
   XLS_ASSIGN_OR_RETURN(auto node_args, ToValueMap(args, function()));
   return Interpret(std::move(node_args), function());
@@ -140,8 +296,8 @@ absl::StatusOr<InterpreterResult<Value>> SwitchableFunctionJit::Run(
 
 absl::StatusOr<InterpreterResult<Value>> SwitchableFunctionJit::Run(
     const absl::flat_hash_map<std::string, Value>& kwargs) {
-  if (use_jit_) {
-    return function_jit_->Run(kwargs);
+  if (FunctionJit* jit = CurrentJit(); jit != nullptr) {
+    return jit->Run(kwargs);
   }
   XLS_ASSIGN_OR_RETURN(auto node_args, ToValueMap(kwargs, function()));
   return Interpret(std::move(node_args), function());
@@ -15,17 +15,21 @@
 #ifndef XLS_JIT_SWITCHABLE_FUNCTION_JIT_H_
 #define XLS_JIT_SWITCHABLE_FUNCTION_JIT_H_
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/notification.h"
 #include "absl/types/span.h"
 #include "xls/ir/events.h"
 #include "xls/ir/function.h"
+#include "xls/ir/package.h"
 #include "xls/ir/value.h"
 #include "xls/jit/function_jit.h"
 #include "xls/jit/observer.h"
@@ -36,6 +40,9 @@ enum class ExecutionType {
   kDefault,
   kJit,
   kInterpreter,
+  // Start executing in the interpreter while the JIT compiles in the
+  // background. See SwitchableFunctionJit::CreateTiered.
+  kTiered,
 };
 
 // A wrapper for the jit structures that can be turned off at build time if
@@ -44,6 +51,12 @@ enum class ExecutionType {
 // TODO(google/xls#1151): 2023-10-13 Implement the rest of the FunctionJit API.
 class SwitchableFunctionJit {
  public:
+  // The optimization level of the quickly compiled first JIT tier used in
+  // tiered execution.
+  static constexpr int64_t kBaselineOptLevel = 1;
+
+  ~SwitchableFunctionJit();
+
   // Returns an object containing a host-compiled version of the specified XLS
   // function.
   static absl::StatusOr<std::unique_ptr<SwitchableFunctionJit>> CreateJit(
@@ -51,6 +64,23 @@ class SwitchableFunctionJit {
       JitObserver* observer = nullptr);
   static absl::StatusOr<std::unique_ptr<SwitchableFunctionJit>>
   CreateInterpreter(Function* xls_function);
+  // Returns an object which immediately evaluates with the interpreter while a
+  // background thread compiles the function, first at kBaselineOptLevel and
+  // then at `opt_level`. Each call to Run uses the fastest tier available when
+  // the call starts; calls in progress complete on the tier they started on.
+  // The background thread compiles a private copy of the package so
+  // `xls_function` only needs to remain unmodified while this object exists.
+  // Compilation failures are logged and leave execution on the previous tier.
+  //
+  // Destroying the object cancels the compilation of any tier which has not
+  // started yet and does not wait for the tier in flight, which is discarded
+  // when it completes. If `observer` is given it is notified from the
+  // background thread and destruction instead waits for the tier in flight so
+  // the observer is not used after this object is gone. See also
+  // ShutdownTieredCompilations.
+  static absl::StatusOr<std::unique_ptr<SwitchableFunctionJit>> CreateTiered(
+      Function* xls_function, int64_t opt_level = 3,
+      JitObserver* observer = nullptr);
   static absl::StatusOr<std::unique_ptr<SwitchableFunctionJit>> Create(
       Function* xls_function, ExecutionType execution = ExecutionType::kDefault,
       int64_t opt_level = 3, JitObserver* observer = nullptr);
@@ -67,23 +97,72 @@ class SwitchableFunctionJit {
   // Returns the function that the JIT executes.
   Function* function() { return xls_function_; }
 
+  // Returns the JIT currently used for execution, if any. For tiered
+  // execution this changes as compilation progresses.
   std::optional<FunctionJit*> function_jit() {
-    if (use_jit_) {
-      return function_jit_.get();
+    FunctionJit* jit = CurrentJit();
+    if (jit != nullptr) {
+      return jit;
     }
     return std::nullopt;
   }
 
+  // Blocks until background compilation of all tiers has finished. Returns
+  // immediately if execution is not tiered.
+  void WaitForCompilation();
+
+  // Cancels the tiers of every tiered compilation in the process which have
+  // not started compiling and waits for the tiers in flight. The compilation
+  // threads use LLVM's global state so they must be done before it is torn
+  // down at exit. This is called automatically from an atexit handler but
+  // programs may call it earlier to shut down at a point of their choosing.
+  // Tiered objects created afterwards compile as usual.
+  static void ShutdownTieredCompilations();
+
  private:
-  explicit SwitchableFunctionJit(Function* xls_function, bool use_jit,
+  // State shared by a tiered SwitchableFunctionJit and its background
+  // compilation. The compilation holds a reference so it can run to
+  // completion after the SwitchableFunctionJit is destroyed.
+  struct TieredCompilation {
+    // Private copy of the package being compiled. The JITs refer to its types
+    // so it must outlive them.
+    std::unique_ptr<Package> package;
+    Function* function = nullptr;
+    int64_t opt_level = 0;
+    JitObserver* observer = nullptr;
+    // Set when the SwitchableFunctionJit is destroyed. Tiers which have not
+    // started compiling are skipped.
+    std::atomic<bool> cancelled = false;
+    // The most optimized of `tier_jits` compiled so far, or nullptr.
+    std::atomic<FunctionJit*> current_jit = nullptr;
+    // Jits of each tier. Superseded tiers are kept alive because a Run call
+    // may still be executing them. Written only by the compilation thread
+    // before the respective jit is published in `current_jit`.
+    std::vector<std::unique_ptr<FunctionJit>> tier_jits;
+    // Notified when the compilation thread is done.
+    absl::Notification done;
+  };
+
+  explicit SwitchableFunctionJit(Function* xls_function,
                                  std::unique_ptr<FunctionJit>&& jit)
-      : xls_function_(xls_function),
-        use_jit_(use_jit),
-        function_jit_(std::move(jit)) {}
+      : xls_function_(xls_function), function_jit_(std::move(jit)) {}
+
+  // Compiles each tier in turn and publishes it. Runs on the background
+  // compilation thread.
+  static void CompileTiers(TieredCompilation& compilation);
+
+  // Returns the jit used by Run or nullptr if the interpreter is used.
+  FunctionJit* CurrentJit() const {
+    if (tiered_ != nullptr) {
+      return tiered_->current_jit.load(std::memory_order_acquire);
+    }
+    return function_jit_.get();
+  }
 
   Function* xls_function_;
-  bool use_jit_;
   std::unique_ptr<FunctionJit> function_jit_;
+  // Non-null for tiered execution.
+  std::shared_ptr<TieredCompilation> tiered_;
 };
 }  // namespace xls
 
@@ -14,6 +14,8 @@
 
 #include "xls/jit/switchable_function_jit.h"
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -24,6 +26,7 @@
 #include "xls/ir/ir_test_base.h"
 #include "xls/ir/package.h"
 #include "xls/ir/value.h"
+#include "xls/jit/observer.h"
 
 namespace xls {
 namespace {
@@ -79,5 +82,101 @@ TEST_F(SwitchableFunctionJitTest, CanExecuteDefault) {
             Value::Tuple({Value(UBits(12, 8)), Value(UBits(32, 8))}));
 }
 
+TEST_F(SwitchableFunctionJitTest, CanExecuteTiered) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(auto f, TestFunction(p.get()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto runner, SwitchableFunctionJit::Create(f, ExecutionType::kTiered));
+  // Results must be identical regardless of which tier is in use while the
+  // background compilation progresses.
+  for (int64_t i = 0; i < 1000; ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        auto result,
+        runner->Run(std::vector<Value>{Value(UBits(i % 256, 8)),
+                                       Value(UBits(3, 8))}));
+    EXPECT_EQ(result.value, Value::Tuple({Value(UBits((i + 3) % 256, 8)),
+                                          Value(UBits((i * 3) % 256, 8))}));
+  }
+
+  runner->WaitForCompilation();
+  EXPECT_TRUE(runner->function_jit().has_value());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto result,
+      runner->Run(std::vector<Value>{Value(UBits(8, 8)), Value(UBits(4, 8))}));
+  EXPECT_EQ(result.value,
+            Value::Tuple({Value(UBits(12, 8)), Value(UBits(32, 8))}));
+}
+
+TEST_F(SwitchableFunctionJitTest, TieredCanBeDestroyedWhileCompiling) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(auto f, TestFunction(p.get()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto runner, SwitchableFunctionJit::Create(f, ExecutionType::kTiered));
+  // The background compilation works on its own copy of the package so both
+  // may be destroyed while it is still running.
+  runner.reset();
+  p.reset();
+}
+
+// Counts the modules handed to the LLVM compiler.
+class CountingObserver final : public JitObserver {
+ public:
+  JitObserverRequests GetNotificationOptions() const final {
+    return JitObserverRequests{.unoptimized_module = true};
+  }
+  void UnoptimizedModule(const llvm::Module* module) final {
+    module_count_.fetch_add(1);
+  }
+
+  int64_t module_count() const { return module_count_.load(); }
+
+ private:
+  std::atomic<int64_t> module_count_ = 0;
+};
+
+TEST_F(SwitchableFunctionJitTest, TieredWaitsForInFlightTierWithObserver) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(auto f, TestFunction(p.get()));
+
+  int64_t module_count;
+  {
+    CountingObserver observer;
+    XLS_ASSERT_OK_AND_ASSIGN(
+        auto runner,
+        SwitchableFunctionJit::CreateTiered(f, /*opt_level=*/3, &observer));
+    runner.reset();
+    // The observer goes out of scope here. Destroying the runner must have
+    // waited for the tier in flight so the observer is no longer used.
+    module_count = observer.module_count();
+  }
+  // At most the in-flight tier was compiled; later tiers were cancelled. The
+  // test function is far too small to be split so each tier is one module.
+  EXPECT_LE(module_count, 1);
+}
+
+TEST_F(SwitchableFunctionJitTest, ShutdownCancelsPendingTiers) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(auto f, TestFunction(p.get()));
+
+  CountingObserver observer;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto runner,
+      SwitchableFunctionJit::CreateTiered(f, /*opt_level=*/3, &observer));
+  SwitchableFunctionJit::ShutdownTieredCompilations();
+  // Only the tier in flight, if any, was compiled and nothing is compiled
+  // afterwards.
+  int64_t module_count = observer.module_count();
+  EXPECT_LE(module_count, 1);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto result,
+      runner->Run(std::vector<Value>{Value(UBits(8, 8)), Value(UBits(4, 8))}));
+  EXPECT_EQ(result.value,
+            Value::Tuple({Value(UBits(12, 8)), Value(UBits(32, 8))}));
+  runner->WaitForCompilation();
+  EXPECT_EQ(observer.module_count(), module_count);
+}
+
 }  // namespace
 }  // namespace xls
@@ -14,13 +14,16 @@
 
 #include "xls/jit/type_layout.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <iterator>
 #include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/log/check.h"
 #include "absl/strings/str_format.h"
@@ -42,21 +45,99 @@ static bool IsLeafValue(const Value& value) {
   return value.IsBits() || value.IsToken();
 }
 
+// Writes the data bytes of a leaf value. Padding is cleared separately.
 static void LeafValueToNativeLayout(const Value& value,
                                     const ElementLayout& element_layout,
                                     uint8_t* buffer) {
-  uint8_t* element_buffer = buffer + element_layout.offset;
   if (value.IsBits()) {
-    // Write the bytes from the Bits object into the buffer.
-    value.bits().ToBytes(
-        absl::MakeSpan(element_buffer, element_layout.data_size));
-    // Clear any padding bytes.
-    std::memset(element_buffer + element_layout.data_size, 0,
-                element_layout.padded_size - element_layout.data_size);
+    value.bits().ToBytes(absl::MakeSpan(buffer + element_layout.offset,
+                                        element_layout.data_size));
     return;
   }
-  CHECK(value.IsToken());
-  std::memset(buffer, 0, element_layout.padded_size);
+  // Tokens contain no data.
+  DCHECK(value.IsToken());
+}
+
+void TypeLayout::BuildPlan() {
+  // The bytes of each leaf element beyond its data are padding which must be
+  // zero. Tokens have no data so their entire element is padding. Bytes
+  // between elements are not part of any element and are left untouched.
+  std::vector<ElementLayout> sorted_elements = elements_;
+  absl::c_sort(sorted_elements,
+               [](const ElementLayout& a, const ElementLayout& b) {
+                 return a.offset < b.offset;
+               });
+  auto add_padding = [&](int64_t start, int64_t limit) {
+    if (start >= limit) {
+      return;
+    }
+    if (!padding_.empty() &&
+        padding_.back().offset + padding_.back().size == start) {
+      padding_.back().size = limit - padding_.back().offset;
+      return;
+    }
+    padding_.push_back(ByteRange{.offset = start, .size = limit - start});
+  };
+  for (const ElementLayout& element : sorted_elements) {
+    add_padding(element.offset + element.data_size,
+                element.offset + element.padded_size);
+  }
+
+  // Flatten the type into a post-order sequence of build steps. An explicit
+  // stack avoids recursing through deeply nested types.
+  struct Frame {
+    Type* type;
+    int64_t next_child;
+  };
+  std::vector<Frame> stack = {Frame{.type = type_, .next_child = 0}};
+  int64_t leaf_index = 0;
+  int64_t stack_depth = 0;
+  while (!stack.empty()) {
+    Frame& frame = stack.back();
+    Type* type = frame.type;
+    if (type->IsBits()) {
+      build_steps_.push_back(
+          BuildStep{.kind = BuildStep::Kind::kBits,
+                    .count = type->AsBitsOrDie()->bit_count(),
+                    .offset = elements_.at(leaf_index).offset});
+      ++leaf_index;
+      ++stack_depth;
+      stack.pop_back();
+    } else if (type->IsToken()) {
+      build_steps_.push_back(
+          BuildStep{.kind = BuildStep::Kind::kToken, .count = 0, .offset = 0});
+      ++leaf_index;
+      ++stack_depth;
+      stack.pop_back();
+    } else if (type->IsTuple()) {
+      TupleType* tuple_type = type->AsTupleOrDie();
+      if (frame.next_child < tuple_type->size()) {
+        Type* child = tuple_type->element_type(frame.next_child++);
+        stack.push_back(Frame{.type = child, .next_child = 0});
+        continue;
+      }
+      build_steps_.push_back(BuildStep{.kind = BuildStep::Kind::kTuple,
+                                       .count = tuple_type->size(),
+                                       .offset = 0});
+      stack_depth += 1 - tuple_type->size();
+      stack.pop_back();
+    } else {
+      ArrayType* array_type = type->AsArrayOrDie();
+      if (frame.next_child < array_type->size()) {
+        ++frame.next_child;
+        stack.push_back(
+            Frame{.type = array_type->element_type(), .next_child = 0});
+        continue;
+      }
+      build_steps_.push_back(BuildStep{.kind = BuildStep::Kind::kArray,
+                                       .count = array_type->size(),
+                                       .offset = 0});
+      stack_depth += 1 - array_type->size();
+      stack.pop_back();
+    }
+    max_stack_depth_ = std::max(max_stack_depth_, stack_depth);
+  }
+  CHECK_EQ(leaf_index, elements_.size());
 }
 
 void TypeLayout::ValueToNativeLayout(const Value& value,
@@ -64,6 +145,10 @@ void TypeLayout::ValueToNativeLayout(const Value& value,
   DCHECK(ValueConformsToType(value, type())) << absl::StreamFormat(
       "Value `%s` is not of type `%s`", value.ToString(), type()->ToString());
 
+  for (const ByteRange& range : padding_) {
+    std::memset(buffer + range.offset, 0, range.size);
+  }
+
   if (IsLeafValue(value)) {
     return LeafValueToNativeLayout(value, elements_.front(), buffer);
   }
@@ -97,7 +182,7 @@ void TypeLayout::ValueToNativeLayout(const Value& value,
     }
     const Value& value_element = frame.value->element(frame.index);
     if (IsLeafValue(value_element)) {
-      LeafValueToNativeLayout(value_element, elements_.at(leaf_index), buffer);
+      LeafValueToNativeLayout(value_element, elements_[leaf_index], buffer);
       ++frame.index;
       ++leaf_index;
     } else {
@@ -105,50 +190,38 @@ void TypeLayout::ValueToNativeLayout(const Value& value,
       push_frame(value_element);
     }
   }
-  CHECK_EQ(leaf_index, elements_.size());
+  DCHECK_EQ(leaf_index, elements_.size());
 }
 
-Value TypeLayout::NativeLayoutToValueInternal(Type* element_type,
-                                              const uint8_t* buffer,
-                                              int64_t* leaf_index) const {
-  if (element_type->IsBits()) {
-    int64_t bit_count = element_type->AsBitsOrDie()->bit_count();
-    const ElementLayout& element_layout = elements_.at(*leaf_index);
-    ++(*leaf_index);
-    return Value(
-        Bits::FromBytes(absl::MakeSpan(buffer + element_layout.offset,
-                                       CeilOfRatio(bit_count, int64_t{8})),
-                        bit_count));
-  }
-  if (element_type->IsToken()) {
-    ++(*leaf_index);
-    return Value::Token();
-  }
-  if (element_type->IsTuple()) {
-    TupleType* tuple_type = element_type->AsTupleOrDie();
-    std::vector<Value> elements;
-    elements.reserve(tuple_type->size());
-    for (int64_t i = 0; i < tuple_type->size(); ++i) {
-      elements.push_back(NativeLayoutToValueInternal(
-          tuple_type->element_type(i), buffer, leaf_index));
+Value TypeLayout::NativeLayoutToValue(const uint8_t* buffer) const {
+  std::vector<Value> stack;
+  stack.reserve(max_stack_depth_);
+  for (const BuildStep& step : build_steps_) {
+    switch (step.kind) {
+      case BuildStep::Kind::kBits:
+        stack.push_back(Value(Bits::FromBytes(
+            absl::MakeSpan(buffer + step.offset,
+                           CeilOfRatio(step.count, int64_t{8})),
+            step.count)));
+        break;
+      case BuildStep::Kind::kToken:
+        stack.push_back(Value::Token());
+        break;
+      case BuildStep::Kind::kTuple:
+      case BuildStep::Kind::kArray: {
+        auto first = stack.end() - step.count;
+        std::vector<Value> elements(std::make_move_iterator(first),
+                                    std::make_move_iterator(stack.end()));
+        stack.erase(first, stack.end());
+        stack.push_back(step.kind == BuildStep::Kind::kTuple
+                            ? Value::TupleOwned(std::move(elements))
+                            : Value::ArrayOwned(std::move(elements)));
+        break;
+      }
     }
-    return Value::TupleOwned(std::move(elements));
-  }
-
-  CHECK(element_type->IsArray());
-  ArrayType* array_type = element_type->AsArrayOrDie();
-  std::vector<Value> elements;
-  elements.reserve(array_type->size());
-  for (int64_t i = 0; i < array_type->size(); ++i) {
-    elements.push_back(NativeLayoutToValueInternal(array_type->element_type(),
-                                                   buffer, leaf_index));
   }
-  return Value::ArrayOwned(std::move(elements));
-}
-
-Value TypeLayout::NativeLayoutToValue(const uint8_t* buffer) const {
-  int64_t leaf_index = 0;
-  return NativeLayoutToValueInternal(type_, buffer, &leaf_index);
+  DCHECK_EQ(stack.size(), 1);
+  return std::move(stack.front());
 }
 
 std::string TypeLayout::ToString() const {
@@ -84,12 +84,18 @@ struct ElementLayout {
 //
 // TODO(https://github.com/google/xls/issues/760): Reduce the redundancy in the
 // array element layouts.
+//
+// On construction the layout is compiled into a flat plan so converting values
+// to and from the native layout neither walks the type nor recurses. Creating
+// a TypeLayout once and reusing it is much cheaper than converting through
+// JitRuntime which consults LLVM under a lock on every call.
 class TypeLayout {
  public:
   explicit TypeLayout(Type* type, int64_t size,
                       absl::Span<const ElementLayout> elements)
       : type_(type), size_(size), elements_(elements.begin(), elements.end()) {
     CHECK_EQ(elements.size(), type->leaf_count());
+    BuildPlan();
   }
 
   // Converts TypeLayout objects to/from TypeLayoutProtos.
@@ -98,7 +104,8 @@ class TypeLayout {
   TypeLayoutProto ToProto() const;
 
   // Writes `value` out to `buffer` in the native layout of the type. `buffer`
-  // must have room for at least `size()` bytes.
+  // must have room for at least `size()` bytes. The padding bytes of each leaf
+  // element are zeroed.
   void ValueToNativeLayout(const Value& value, uint8_t* buffer) const;
 
   // Returns a Value object representing the data of XLS type `type()` stored in
@@ -119,12 +126,37 @@ class TypeLayout {
   std::string ToString() const;
 
  private:
-  Value NativeLayoutToValueInternal(Type* element_type, const uint8_t* buffer,
-                                    int64_t* leaf_index) const;
+  // A contiguous range of bytes in the native layout.
+  struct ByteRange {
+    int64_t offset;
+    int64_t size;
+  };
+
+  // A step of the post-order program which builds a Value from the native
+  // layout. Leaf steps push a value onto a stack and aggregate steps replace
+  // the top `count` values of the stack with a tuple or array of them.
+  struct BuildStep {
+    enum class Kind : uint8_t { kBits, kToken, kTuple, kArray };
+    Kind kind;
+    // The bit count of a kBits step or the element count of a kTuple or
+    // kArray step.
+    int64_t count;
+    // The byte offset of the data of a kBits step.
+    int64_t offset;
+  };
+
+  // Computes `padding_`, `build_steps_` and `max_stack_depth_`.
+  void BuildPlan();
 
   Type* type_;
   int64_t size_;
   std::vector<ElementLayout> elements_;
+
+  // The padding byte ranges of the leaf elements with adjacent ranges merged.
+  std::vector<ByteRange> padding_;
+  std::vector<BuildStep> build_steps_;
+  // The maximum depth of the value stack while executing `build_steps_`.
+  int64_t max_stack_depth_ = 0;
 };
 
 std::ostream& operator<<(std::ostream& os, ElementLayout layout);
@@ -23,6 +23,8 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
@@ -38,13 +40,16 @@
 #include "xls/ir/number_parser.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
+#include "xls/jit/jit_runtime.h"
 #include "xls/jit/llvm_type_converter.h"
 #include "xls/jit/orc_jit.h"
 
 namespace xls {
 namespace {
 
+using ::absl_testing::StatusIs;
 using ::testing::ElementsAre;
+using ::testing::HasSubstr;
 
 class TypeLayoutTest : public IrTestBase {};
 
@@ -322,7 +327,9 @@ TEST_F(TypeLayoutTest, JitTypes) {
        {"()", "bits[8]", "bits[64]", "bits[1024]", "bits[32][2]", "bits[64][5]",
         "bits[123][10]",
         "(bits[1], (bits[8], bits[16], bits[1][3])[2], bits[77])",
-        "bits[1][100]", "(bits[3], (), bits[5], bits[7])[2][1][3]"}) {
+        "bits[1][100]", "(bits[3], (), bits[5], bits[7])[2][1][3]",
+        "((((bits[8], bits[16])[2], bits[32])[2], bits[1])[2], bits[64])[3]",
+        "(bits[1], (bits[2], (bits[3], (bits[4], (bits[5], ())))))[2]"}) {
     XLS_ASSERT_OK_AND_ASSIGN(Type * type,
                              Parser::ParseType(type_str, package.get()));
     TypeLayout layout = CreateTypeLayout(type);
@@ -371,5 +378,51 @@ TEST_F(TypeLayoutTest, JitTypes) {
   }
 }
 
+TEST_F(TypeLayoutTest, MatchesJitRuntime) {
+  // Conversions through precompiled TypeLayouts must agree with the
+  // conversions JitRuntime performs by consulting LLVM.
+  auto package = CreatePackage();
+  std::minstd_rand bitgen;
+  std::unique_ptr<OrcJit> orc_jit = OrcJit::Create().value();
+  JitRuntime runtime(orc_jit->CreateDataLayout().value());
+  for (const char* type_str :
+       {"()", "bits[42]", "(bits[4], bits[15], bits[16])", "bits[9][3]",
+        "(bits[1], (bits[8], bits[16], bits[1][3])[2], bits[77])",
+        "((((bits[8], bits[16])[2], bits[32])[2], bits[1])[2], bits[64])[3]"}) {
+    XLS_ASSERT_OK_AND_ASSIGN(Type * type,
+                             Parser::ParseType(type_str, package.get()));
+    TypeLayout layout = runtime.CreateTypeLayout(type);
+    ASSERT_EQ(layout.size(), runtime.GetTypeByteSize(type));
+    for (int64_t i = 0; i < 10; ++i) {
+      Value value = RandomValue(type, bitgen);
+      std::vector<uint8_t> expected(layout.size(), 0);
+      runtime.BlitValueToBuffer(value, type, absl::MakeSpan(expected));
+      std::vector<uint8_t> actual(layout.size(), 0);
+      layout.ValueToNativeLayout(value, actual.data());
+      EXPECT_EQ(actual, expected) << type_str;
+      EXPECT_EQ(layout.NativeLayoutToValue(expected.data()),
+                runtime.UnpackBuffer(expected.data(), type));
+    }
+  }
+}
+
+TEST_F(TypeLayoutTest, PackArgsChecksLayoutCount) {
+  auto package = CreatePackage();
+  std::unique_ptr<OrcJit> orc_jit = OrcJit::Create().value();
+  JitRuntime runtime(orc_jit->CreateDataLayout().value());
+  Type* type = package->GetBitsType(32);
+  std::vector<TypeLayout> layouts = runtime.CreateTypeLayouts({type});
+  std::vector<uint8_t> buffer0(layouts[0].size());
+  std::vector<uint8_t> buffer1(layouts[0].size());
+  std::vector<uint8_t*> buffers = {buffer0.data(), buffer1.data()};
+  std::vector<Value> args = {Value(UBits(1, 32)), Value(UBits(2, 32))};
+  EXPECT_THAT(runtime.PackArgs(args, layouts, buffers),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Number of argument layouts")));
+  XLS_EXPECT_OK(runtime.PackArgs(absl::MakeSpan(args).subspan(0, 1), layouts,
+                                 buffers));
+  EXPECT_EQ(layouts[0].NativeLayoutToValue(buffer0.data()), args[0]);
+}
+
 }  // namespace
 }  // namespace xls
@@ -17,12 +17,14 @@
 #include <random>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "include/benchmark/benchmark.h"
 #include "xls/interpreter/random_value.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
+#include "xls/jit/jit_runtime.h"
 #include "xls/jit/llvm_type_converter.h"
 #include "xls/jit/orc_jit.h"
 #include "xls/jit/type_layout.h"
@@ -32,7 +34,7 @@ namespace {
 
 // Measure the performance of conversion of a Value to/from the native XLS type
 // layout used by the jit.
-constexpr int kNumTypes = 10;
+constexpr int kNumTypes = 12;
 const char* kValueTypes[] = {
     "()",
     "bits[8]",
@@ -44,6 +46,9 @@ const char* kValueTypes[] = {
     "(bits[1], (bits[32], bits[64], bits[1][32])[5], bits[100])",
     "bits[1][1024]",
     "(bits[3], (), bits[5], bits[7])[3][10][42]",
+    "((((bits[8], bits[16])[2], bits[32])[2], bits[1])[2], bits[64])[8]",
+    "(bits[1], (bits[2], (bits[3], (bits[4], (bits[5], (bits[6], bits[7]))))))"
+    "[16]",
 };
 
 static TypeLayout CreateTypeLayout(Type* type) {
@@ -53,6 +58,32 @@ static TypeLayout CreateTypeLayout(Type* type) {
   return type_converter.CreateTypeLayout(type);
 }
 
+// Conversions through JitRuntime which consult LLVM on every call. These are
+// the baseline for the precompiled TypeLayout conversions below.
+static void BM_BlitValueToBuffer(benchmark::State& state) {
+  Package package("BM");
+  Type* type = Parser::ParseType(kValueTypes[state.range(0)], &package).value();
+  std::minstd_rand bitgen;
+  Value value = RandomValue(type, bitgen);
+  std::unique_ptr<OrcJit> orc_jit = OrcJit::Create().value();
+  JitRuntime runtime(orc_jit->CreateDataLayout().value());
+  std::vector<uint8_t> buffer(runtime.GetTypeByteSize(type));
+  for (auto _ : state) {
+    runtime.BlitValueToBuffer(value, type, absl::MakeSpan(buffer));
+  }
+}
+
+static void BM_UnpackBuffer(benchmark::State& state) {
+  Package package("BM");
+  Type* type = Parser::ParseType(kValueTypes[state.range(0)], &package).value();
+  std::unique_ptr<OrcJit> orc_jit = OrcJit::Create().value();
+  JitRuntime runtime(orc_jit->CreateDataLayout().value());
+  std::vector<uint8_t> buffer(runtime.GetTypeByteSize(type), 0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(runtime.UnpackBuffer(buffer.data(), type));
+  }
+}
+
 static void BM_ValueToNativeLayout(benchmark::State& state) {
   Package package("BM");
   Type* type = Parser::ParseType(kValueTypes[state.range(0)], &package).value();
@@ -77,6 +108,8 @@ static void BM_NativeLayoutToValue(benchmark::State& state) {
 
 BENCHMARK(BM_ValueToNativeLayout)->DenseRange(0, kNumTypes - 1);
 BENCHMARK(BM_NativeLayoutToValue)->DenseRange(0, kNumTypes - 1);
+BENCHMARK(BM_BlitValueToBuffer)->DenseRange(0, kNumTypes - 1);
+BENCHMARK(BM_UnpackBuffer)->DenseRange(0, kNumTypes - 1);
 
 }  // namespace
 }  // namespace xls
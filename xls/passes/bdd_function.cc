@@ -235,12 +235,14 @@ class BddStatistics {
 
 /* static */ absl::StatusOr<std::unique_ptr<BddFunction>> BddFunction::Run(
     FunctionBase* f, int64_t path_limit,
-    std::optional<std::function<bool(const Node*)>> node_filter) {
+    std::optional<std::function<bool(const Node*)>> node_filter,
+    bool dynamic_reordering) {
   VLOG(1) << absl::StreamFormat("BddFunction::Run(%s), %d nodes:", f->name(),
                                 f->node_count());
   XLS_VLOG_LINES(5, f->DumpIr());
 
   auto bdd_function = absl::WrapUnique(new BddFunction(f));
+  bdd_function->bdd().set_dynamic_reordering(dynamic_reordering);
   SaturatingBddEvaluator evaluator(path_limit, &bdd_function->bdd());
 
   // Create and return a vector containing newly defined BDD variables.
@@ -298,6 +300,12 @@ class BddStatistics {
         }
       }
     }
+    // Every expression held in `values` is referenced so this is a safe point
+    // to collect the intermediate nodes created while evaluating `node`.
+    for (const SaturatingBddNodeIndex& value : values.at(node)) {
+      bdd_function->bdd().Ref(std::get<BddNodeIndex>(value));
+    }
+    bdd_function->bdd().MaybeCollectGarbage();
     if (VLOG_IS_ON(5)) {
       VLOG(5) << "  " << node->GetName() << ":";
       for (int64_t i = 0; i < node->BitCountOrDie(); ++i) {
@@ -64,10 +64,19 @@ class BddFunction {
   // for which no information is known. If `node_filter` returns true, the node
   // still might *not* be evaluated because some kinds of nodes are never
   // evaluated for various reasons including computation expense.
+  //
+  // The expressions of the function's nodes are referenced in the BDD and
+  // unreferenced intermediate nodes are garbage collected as the construction
+  // proceeds. If `dynamic_reordering` is true the BDD variables are reordered
+  // by sifting whenever the number of live BDD nodes has doubled. Sifting is
+  // off by default as its cost only pays off on BDDs which grow large.
+  // Expressions later built by clients on top of the returned BDD are not
+  // referenced and are not collected.
   static absl::StatusOr<std::unique_ptr<BddFunction>> Run(
       FunctionBase* f, int64_t path_limit = 0,
       std::optional<std::function<bool(const Node*)>> node_filter =
-          std::nullopt);
+          std::nullopt,
+      bool dynamic_reordering = false);
 
   // Returns the underlying BDD.
   const BinaryDecisionDiagram& bdd() const { return bdd_; }
@@ -48,6 +48,7 @@
 #include "xls/passes/bdd_function.h"
 #include "xls/passes/predicate_state.h"
 #include "xls/passes/query_engine.h"
+#include "xls/passes/simulation_oracle.h"
 
 namespace xls {
 
@@ -251,7 +252,11 @@ bool BddQueryEngine::AssumingBddQueryEngine::IsFullyKnown(Node* n) const {
 
 absl::StatusOr<ReachedFixpoint> BddQueryEngine::Populate(FunctionBase* f) {
   XLS_ASSIGN_OR_RETURN(bdd_function_,
-                       BddFunction::Run(f, path_limit_, node_filter_));
+                       BddFunction::Run(f, path_limit_, node_filter_,
+                                        options_.dynamic_reordering));
+  simulation_.reset();
+  unsimulated_query_count_ = 0;
+  simulation_failed_ = false;
   // Construct the Bits objects indication which bit values are statically known
   // for each node and what those values are (0 or 1) if known.
   BinaryDecisionDiagram& bdd = this->bdd();
@@ -292,6 +297,31 @@ absl::StatusOr<ReachedFixpoint> BddQueryEngine::Populate(FunctionBase* f) {
   return rf;
 }
 
+const SimulationOracle* BddQueryEngine::GetSimulation() const {
+  if (!options_.simulation_filter || bdd_function_ == nullptr ||
+      simulation_failed_) {
+    return nullptr;
+  }
+  if (!simulation_.has_value()) {
+    if (unsimulated_query_count_ < options_.queries_before_simulation) {
+      ++unsimulated_query_count_;
+      return nullptr;
+    }
+    absl::StatusOr<SimulationOracle> simulation =
+        SimulationOracle::Run(bdd_function_->function_base());
+    if (!simulation.ok()) {
+      LOG(WARNING) << "Unable to simulate "
+                   << bdd_function_->function_base()->name()
+                   << ", BDD queries are not filtered: "
+                   << simulation.status();
+      simulation_failed_ = true;
+      return nullptr;
+    }
+    simulation_ = *std::move(simulation);
+  }
+  return &*simulation_;
+}
+
 std::unique_ptr<QueryEngine> BddQueryEngine::SpecializeGivenPredicate(
     const absl::flat_hash_set<PredicateState>& state) const {
   absl::flat_hash_map<Node*, ValueKnowledge> givens;
@@ -589,6 +619,12 @@ bool BddQueryEngine::AtMostOneTrue(
       return false;
     }
   }
+  if (!assumption.has_value() &&
+      SimulationRefutes([&](const SimulationOracle& simulation) {
+        return simulation.RefutesAtMostOneTrue(bits);
+      })) {
+    return false;
+  }
 
   // Compute the OR-reduction of a pairwise AND of all bits. If this value is
   // zero then no two bits can be simultaneously true. Equivalently: at most one
@@ -670,6 +706,12 @@ bool BddQueryEngine::AtLeastOneTrue(
     }
     bdd_bits.push_back(*bdd_node);
   }
+  if (!assumption.has_value() &&
+      SimulationRefutes([&](const SimulationOracle& simulation) {
+        return simulation.RefutesAtLeastOneTrue(bits);
+      })) {
+    return false;
+  }
   SaturatingBddNodeIndex or_reduce = evaluator.OrReduce(bdd_bits).front();
   if (HasTooManyPaths(or_reduce)) {
     VLOG(3) << "AtLeastOneTrue exceeded path limit of " << path_limit_;
@@ -704,6 +746,11 @@ bool BddQueryEngine::Implies(const TreeBitLocation& a,
   if (!b_bdd.has_value()) {
     return false;
   }
+  if (SimulationRefutes([&](const SimulationOracle& simulation) {
+        return simulation.RefutesImplies(a, b);
+      })) {
+    return false;
+  }
   return Implies(*a_bdd, *b_bdd);
 }
 
@@ -743,6 +790,7 @@ std::optional<TernaryVector> BddQueryEngine::ImpliedNodeTernary(
   // Create a Bdd node for the predicate_bit_values.
   SaturatingBddEvaluator evaluator(path_limit_, &bdd());
   SaturatingBddNodeVector bdd_predicate_bits;
+  std::vector<std::pair<TreeBitLocation, bool>> used_predicate_bit_values;
   for (const auto& [conjuction_bit_location, conjunction_value] :
        predicate_bit_values) {
     std::optional<BddNodeIndex> conjuction_bit =
@@ -754,6 +802,8 @@ std::optional<TernaryVector> BddQueryEngine::ImpliedNodeTernary(
     }
     bdd_predicate_bits.push_back(
         conjunction_value ? *conjuction_bit : bdd().Not(*conjuction_bit));
+    used_predicate_bit_values.push_back(
+        {conjuction_bit_location, conjunction_value});
   }
   SaturatingBddNodeIndex bdd_predicate =
       evaluator.And(assumption.value_or(bdd().one()),
@@ -776,16 +826,35 @@ std::optional<TernaryVector> BddQueryEngine::ImpliedNodeTernary(
     kImpliedTrue,
     kImpliedFalse
   };
+  // The simulated vectors under which the predicate holds. Without an
+  // assumption, a bit whose value varies across these vectors is not implied
+  // by the predicate.
+  std::optional<std::vector<uint64_t>> simulated_predicate;
+  if (!assumption.has_value()) {
+    if (const SimulationOracle* simulation = GetSimulation();
+        simulation != nullptr) {
+      simulated_predicate = simulation->VectorsWhere(used_predicate_bit_values);
+    }
+  }
+  auto simulation_refutes = [&](const TreeBitLocation& location, bool value) {
+    return simulated_predicate.has_value() &&
+           SimulationRefutes([&](const SimulationOracle& simulation) {
+             return simulation.RefutesImplies(*simulated_predicate, location,
+                                              value);
+           });
+  };
   auto implied_value = [&](int node_idx) -> std::optional<TernaryValue> {
-    std::optional<BddNodeIndex> bdd_node_bit =
-        GetBddNode(TreeBitLocation(node, node_idx));
+    TreeBitLocation location(node, node_idx);
+    std::optional<BddNodeIndex> bdd_node_bit = GetBddNode(location);
     if (!bdd_node_bit.has_value()) {
       return std::nullopt;
     }
-    if (Implies(bdd_predicate_bit, *bdd_node_bit)) {
+    if (!simulation_refutes(location, true) &&
+        Implies(bdd_predicate_bit, *bdd_node_bit)) {
       return TernaryValue::kKnownOne;
     }
-    if (Implies(bdd_predicate_bit, bdd().Not(*bdd_node_bit))) {
+    if (!simulation_refutes(location, false) &&
+        Implies(bdd_predicate_bit, bdd().Not(*bdd_node_bit))) {
       return TernaryValue::kKnownZero;
     }
     return TernaryValue::kUnknown;
@@ -23,6 +23,7 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
@@ -35,9 +36,27 @@
 #include "xls/passes/bdd_function.h"
 #include "xls/passes/predicate_state.h"
 #include "xls/passes/query_engine.h"
+#include "xls/passes/simulation_oracle.h"
 
 namespace xls {
 
+struct BddQueryEngineOptions {
+  // Whether the BDD variables are reordered by sifting as the BDD grows. See
+  // BddFunction for details.
+  bool dynamic_reordering = false;
+
+  // Whether queries without assumptions are first checked against a
+  // bit-parallel simulation of the function (see SimulationOracle). A query
+  // the simulation refutes needs no BDD computation.
+  bool simulation_filter = true;
+
+  // The number of queries answered by the BDD alone before the simulation is
+  // run. Simulating costs about as much as a handful of BDD queries, so it is
+  // deferred until the engine has shown it will be queried more than a few
+  // times.
+  int64_t queries_before_simulation = 16;
+};
+
 // A query engine which uses binary decision diagrams (BDDs) to analyze an XLS
 // function. BDDs provide sharp analysis of bits values and relationships
 // between bit values in the function (relative to ternary abstract evaluation).
@@ -51,14 +70,17 @@ class BddQueryEngine : public QueryEngine {
   // terminals 0 and 1 to allow for a BDD expression before truncating it.
   // `node_filter` is an optional function which can be used to limit the nodes
   // which the BDD evaluates (returning false means the node will node be
-  // evaluated). See BddFunction for details.
+  // evaluated).
   explicit BddQueryEngine(int64_t path_limit = 0,
                           std::optional<std::function<bool(const Node*)>>
-                              node_filter = std::nullopt)
-      : path_limit_(path_limit), node_filter_(node_filter) {}
+                              node_filter = std::nullopt,
+                          const BddQueryEngineOptions& options = {})
+      : path_limit_(path_limit), node_filter_(node_filter), options_(options) {}
 
   absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
 
+  const BddQueryEngineOptions& options() const { return options_; }
+
   bool IsTracked(Node* node) const override {
     return known_bits_.contains(node);
   }
@@ -102,6 +124,14 @@ class BddQueryEngine : public QueryEngine {
   // Returns the underlying BddFunction representing the XLS function.
   const BddFunction& bdd_function() const { return *bdd_function_; }
 
+  // Returns the counts of the queries which were checked against a simulation
+  // of the function before querying the BDD, and of those which the
+  // simulation refuted. Only queries without assumptions are checked. The
+  // counts are shared with the engine and keep accumulating.
+  std::shared_ptr<const SimulationFilterStats> simulation_stats() const {
+    return simulation_stats_;
+  }
+
  private:
   class AssumingBddQueryEngine;
 
@@ -161,6 +191,24 @@ class BddQueryEngine : public QueryEngine {
     return path_limit_ > 0 && bdd().GetNode(node).path_count > path_limit_;
   }
 
+  // Returns the simulation of the function or nullptr if queries are not
+  // filtered by simulation (yet). Each call counts as a query towards
+  // `options_.queries_before_simulation`; the simulation is run by the call
+  // which reaches it.
+  const SimulationOracle* GetSimulation() const;
+
+  // Returns true if the simulation of the function shows, according to
+  // `refutes`, that the property being queried does not hold. Counts the
+  // query in `simulation_stats_` if it was checked against the simulation.
+  bool SimulationRefutes(
+      absl::FunctionRef<bool(const SimulationOracle&)> refutes) const {
+    const SimulationOracle* simulation = GetSimulation();
+    if (simulation == nullptr) {
+      return false;
+    }
+    return simulation_stats_->Record(refutes(*simulation));
+  }
+
   // Returns true if the known bits for the nodes have changed.
   bool RecomputeKnownBits();
 
@@ -169,6 +217,8 @@ class BddQueryEngine : public QueryEngine {
 
   std::optional<std::function<bool(const Node*)>> node_filter_;
 
+  BddQueryEngineOptions options_;
+
   // Indicates the bits at the output of each node which have known values.
   absl::flat_hash_map<Node*, Bits> known_bits_;
 
@@ -176,6 +226,16 @@ class BddQueryEngine : public QueryEngine {
   absl::flat_hash_map<Node*, Bits> bits_values_;
 
   std::unique_ptr<BddFunction> bdd_function_;
+
+  // A simulation of the function used to refute queries before the more
+  // expensive BDD computations. Run lazily by GetSimulation.
+  mutable std::optional<SimulationOracle> simulation_;
+  // The number of queries made since Populate without a simulation.
+  mutable int64_t unsimulated_query_count_ = 0;
+  // Whether running the simulation failed, in which case it is not retried.
+  mutable bool simulation_failed_ = false;
+  std::shared_ptr<SimulationFilterStats> simulation_stats_ =
+      std::make_shared<SimulationFilterStats>();
 };
 
 }  // namespace xls
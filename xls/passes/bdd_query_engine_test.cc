@@ -114,6 +114,67 @@ TEST_F(BddQueryEngineTest, VariousComparisonPredicates) {
   EXPECT_FALSE(Implies(query_engine, x_lt_42.node(), x_eq_7.node()));
 }
 
+TEST_F(BddQueryEngineTest, SimulationRefutesQueries) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue x0 = fb.BitSlice(x, /*start=*/0, /*width=*/1);
+  BValue x1 = fb.BitSlice(x, /*start=*/1, /*width=*/1);
+  BValue x_lt_42 = fb.ULt(x, fb.Literal(UBits(42, 8)));
+  BValue x_eq_7 = fb.Eq(x, fb.Literal(UBits(7, 8)));
+  BValue not_x0 = fb.Not(x0);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  BddQueryEngine query_engine(/*path_limit=*/0, /*node_filter=*/std::nullopt,
+                              {.queries_before_simulation = 0});
+  XLS_ASSERT_OK(query_engine.Populate(f).status());
+
+  // The all-zeros and all-ones input vectors refute these.
+  EXPECT_FALSE(Implies(query_engine, x_lt_42.node(), x_eq_7.node()));
+  EXPECT_FALSE(query_engine.AtMostOneNodeTrue({x0.node(), x1.node()}));
+  EXPECT_FALSE(query_engine.AtLeastOneNodeTrue({x0.node(), x1.node()}));
+  EXPECT_EQ(query_engine.simulation_stats()->query_count, 3);
+  EXPECT_EQ(query_engine.simulation_stats()->refuted_count, 3);
+
+  // Properties which hold are still proven with the BDD.
+  EXPECT_TRUE(Implies(query_engine, x_eq_7.node(), x_lt_42.node()));
+  EXPECT_TRUE(query_engine.AtMostOneNodeTrue({x_eq_7.node(), not_x0.node()}));
+  EXPECT_EQ(query_engine.simulation_stats()->refuted_count, 3);
+}
+
+TEST_F(BddQueryEngineTest, SimulationIsDeferred) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue x0 = fb.BitSlice(x, /*start=*/0, /*width=*/1);
+  BValue x1 = fb.BitSlice(x, /*start=*/1, /*width=*/1);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  // The first two queries are answered by the BDD alone, the third is the
+  // first one checked against the simulation.
+  BddQueryEngine query_engine(/*path_limit=*/0, /*node_filter=*/std::nullopt,
+                              {.queries_before_simulation = 2});
+  XLS_ASSERT_OK(query_engine.Populate(f).status());
+  EXPECT_FALSE(query_engine.AtMostOneNodeTrue({x0.node(), x1.node()}));
+  EXPECT_FALSE(query_engine.AtLeastOneNodeTrue({x0.node(), x1.node()}));
+  EXPECT_EQ(query_engine.simulation_stats()->query_count, 0);
+  EXPECT_FALSE(query_engine.AtMostOneNodeTrue({x0.node(), x1.node()}));
+  EXPECT_EQ(query_engine.simulation_stats()->query_count, 1);
+  EXPECT_EQ(query_engine.simulation_stats()->refuted_count, 1);
+
+  // Repopulating the engine defers the simulation again.
+  XLS_ASSERT_OK(query_engine.Populate(f).status());
+  EXPECT_FALSE(query_engine.AtMostOneNodeTrue({x0.node(), x1.node()}));
+  EXPECT_EQ(query_engine.simulation_stats()->query_count, 1);
+
+  BddQueryEngine unfiltered_engine(
+      /*path_limit=*/0, /*node_filter=*/std::nullopt,
+      {.simulation_filter = false, .queries_before_simulation = 0});
+  XLS_ASSERT_OK(unfiltered_engine.Populate(f).status());
+  EXPECT_FALSE(unfiltered_engine.AtMostOneNodeTrue({x0.node(), x1.node()}));
+  EXPECT_FALSE(unfiltered_engine.AtLeastOneNodeTrue({x0.node(), x1.node()}));
+  EXPECT_EQ(unfiltered_engine.simulation_stats()->query_count, 0);
+}
+
 TEST_F(BddQueryEngineTest, BitValuesImplyNodeValueSimple) {
   auto p = CreatePackage();
   FunctionBuilder fb(TestName(), p.get());
@@ -42,8 +42,7 @@
 #include "xls/ir/op.h"
 #include "xls/ir/topo_sort.h"
 #include "xls/ir/value.h"
-#include "xls/passes/bdd_function.h"
-#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/optimization_context.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
@@ -443,8 +442,8 @@ absl::StatusOr<bool> BddSimplificationPass::RunOnFunctionBaseInternal(
     PassResults* results) const {
   std::vector<std::unique_ptr<QueryEngine>> query_engines;
   query_engines.push_back(std::make_unique<StatelessQueryEngine>());
-  query_engines.push_back(std::make_unique<BddQueryEngine>(
-      BddFunction::kDefaultPathLimit, IsCheapForBdds));
+  query_engines.push_back(
+      MakeQueryEngine(options.context, QueryEngineKind::kBdd));
 
   UnionQueryEngine query_engine(std::move(query_engines));
   XLS_RETURN_IF_ERROR(query_engine.Populate(f).status());
@@ -47,25 +47,28 @@
 #include "xls/ir/topo_sort.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
+#include "xls/passes/optimization_context.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
 #include "xls/passes/query_engine.h"
-#include "xls/passes/range_query_engine.h"
 #include "xls/passes/stateless_query_engine.h"
-#include "xls/passes/ternary_query_engine.h"
 #include "xls/passes/union_query_engine.h"
 
 namespace xls {
 namespace {
 
 static absl::StatusOr<std::unique_ptr<QueryEngine>> GetQueryEngine(
-    FunctionBase* f, int64_t opt_level) {
+    FunctionBase* f, const OptimizationPassOptions& options) {
   std::vector<std::unique_ptr<QueryEngine>> engines;
   engines.push_back(std::make_unique<StatelessQueryEngine>());
-  engines.push_back(std::make_unique<TernaryQueryEngine>());
-  if (opt_level >= 3) {
-    engines.push_back(std::make_unique<RangeQueryEngine>());
+  // Shared engines are brought up to date incrementally when the pass runs
+  // again on a function which changed only in part.
+  engines.push_back(
+      MakeQueryEngine(options.context, QueryEngineKind::kTernary));
+  if (options.opt_level >= 3) {
+    engines.push_back(
+        MakeQueryEngine(options.context, QueryEngineKind::kRange));
   }
   auto query_engine = std::make_unique<UnionQueryEngine>(std::move(engines));
 
@@ -1065,7 +1068,7 @@ absl::StatusOr<bool> BitSliceSimplificationPass::RunOnFunctionBaseInternal(
   bool changed = false;
 
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<QueryEngine> query_engine,
-                       GetQueryEngine(f, options.opt_level));
+                       GetQueryEngine(f, options));
 
   // Iterating through these operations in reverse topological order makes sure
   // we don't need to re-populate the query engine between nodes.
@@ -54,8 +54,7 @@
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_utils.h"
-#include "xls/passes/bdd_function.h"
-#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/optimization_context.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
@@ -608,8 +607,8 @@ absl::StatusOr<bool> ConditionalSpecializationPass::RunOnFunctionBaseInternal(
   std::vector<std::unique_ptr<QueryEngine>> query_engines;
   query_engines.push_back(std::make_unique<StatelessQueryEngine>());
   if (use_bdd_) {
-    query_engines.push_back(std::make_unique<BddQueryEngine>(
-        BddFunction::kDefaultPathLimit, IsCheapForBdds));
+    query_engines.push_back(
+        MakeQueryEngine(options.context, QueryEngineKind::kBdd));
   }
 
   UnionQueryEngine query_engine(std::move(query_engines));
@@ -76,8 +76,12 @@ absl::StatusOr<bool> RunCse(FunctionBase* f,
     for (Node* operand : GetOperandsForCse(n, &span_backing_store)) {
       values_to_hash.push_back(operand->id());
     }
-    // If this is slow because of many literals, the Literal values could be
-    // combined into the hash. As is, all literals get the same hash value.
+    // Literal values are interned with a precomputed hash so including it is
+    // cheap and keeps literals with different values out of the same bucket.
+    if (n->Is<Literal>()) {
+      values_to_hash.push_back(
+          static_cast<int64_t>(n->As<Literal>()->interned_value().hash()));
+    }
     return hasher(values_to_hash);
   };
 
@@ -14,7 +14,9 @@
 
 #include "xls/passes/cse_pass.h"
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -23,12 +25,15 @@
 #include "absl/status/statusor.h"
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
 #include "xls/ir/function.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/op.h"
 #include "xls/ir/package.h"
+#include "xls/ir/value.h"
 #include "xls/passes/dce_pass.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/pass_base.h"
@@ -120,6 +125,22 @@ TEST_F(CsePassTest, TwoIdenticalLiteralsNoLiteralCommoning) {
   EXPECT_EQ(f->node_count(), 3);
 }
 
+TEST_F(CsePassTest, ManyWideLiterals) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  std::vector<BValue> literals;
+  for (int64_t i = 0; i < 100; ++i) {
+    literals.push_back(fb.Literal(Value(UBits(i % 5, 1024))));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f,
+                           fb.BuildWithReturnValue(fb.Tuple(literals)));
+  // Equal literals share the interned value held by the package.
+  EXPECT_EQ(&literals[0].node()->As<Literal>()->value(),
+            &literals[5].node()->As<Literal>()->value());
+  EXPECT_THAT(Run(f), IsOkAndHolds(true));
+  EXPECT_EQ(f->node_count(), 6);
+}
+
 TEST_F(CsePassTest, NontrivialCommonSubexpressions) {
   auto p = CreatePackage();
   XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
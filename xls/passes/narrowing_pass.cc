@@ -62,6 +62,7 @@
 #include "xls/ir/value_utils.h"
 #include "xls/passes/aliasing_query_engine.h"
 #include "xls/passes/context_sensitive_range_query_engine.h"
+#include "xls/passes/optimization_context.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
@@ -69,9 +70,7 @@
 #include "xls/passes/predicate_state.h"
 #include "xls/passes/proc_state_range_query_engine.h"
 #include "xls/passes/query_engine.h"
-#include "xls/passes/range_query_engine.h"
 #include "xls/passes/stateless_query_engine.h"
-#include "xls/passes/ternary_query_engine.h"
 #include "xls/passes/union_query_engine.h"
 
 namespace xls {
@@ -1786,8 +1785,8 @@ void AnalysisLog(FunctionBase* f, const QueryEngine& query_engine) {
   }
 }
 
-absl::StatusOr<AliasingQueryEngine> GetQueryEngine(FunctionBase* f,
-                                                   AnalysisType analysis) {
+absl::StatusOr<AliasingQueryEngine> GetQueryEngine(
+    FunctionBase* f, AnalysisType analysis, OptimizationContext* context) {
   std::vector<std::unique_ptr<QueryEngine>> engines;
   engines.push_back(std::make_unique<StatelessQueryEngine>());
   if (analysis == AnalysisType::kRangeWithContext) {
@@ -1795,7 +1794,7 @@ absl::StatusOr<AliasingQueryEngine> GetQueryEngine(FunctionBase* f,
       // NB ProcStateRange already includes a ternary qe
       engines.push_back(std::make_unique<ProcStateRangeQueryEngine>());
     } else {
-      engines.push_back(std::make_unique<TernaryQueryEngine>());
+      engines.push_back(MakeQueryEngine(context, QueryEngineKind::kTernary));
     }
     engines.push_back(std::make_unique<ContextSensitiveRangeQueryEngine>());
   } else if (analysis == AnalysisType::kRange) {
@@ -1803,11 +1802,11 @@ absl::StatusOr<AliasingQueryEngine> GetQueryEngine(FunctionBase* f,
       // NB ProcStateRange already includes a ternary qe
       engines.push_back(std::make_unique<ProcStateRangeQueryEngine>());
     } else {
-      engines.push_back(std::make_unique<TernaryQueryEngine>());
-      engines.push_back(std::make_unique<RangeQueryEngine>());
+      engines.push_back(MakeQueryEngine(context, QueryEngineKind::kTernary));
+      engines.push_back(MakeQueryEngine(context, QueryEngineKind::kRange));
     }
   } else {
-    engines.push_back(std::make_unique<TernaryQueryEngine>());
+    engines.push_back(MakeQueryEngine(context, QueryEngineKind::kTernary));
   }
   auto query_engine = std::make_unique<UnionQueryEngine>(std::move(engines));
   XLS_RETURN_IF_ERROR(query_engine->Populate(f).status());
@@ -1823,7 +1822,8 @@ absl::StatusOr<bool> NarrowingPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const OptimizationPassOptions& options,
     PassResults* results) const {
   XLS_ASSIGN_OR_RETURN(AliasingQueryEngine query_engine,
-                       GetQueryEngine(f, RealAnalysis(options)));
+                       GetQueryEngine(f, RealAnalysis(options),
+                                      options.context));
 
   PredicateDominatorAnalysis pda = PredicateDominatorAnalysis::Run(f);
   SpecializedQueryEngines sqe(RealAnalysis(options), pda, query_engine);
@@ -15,98 +15,123 @@
 #include "xls/passes/node_dependency_analysis.h"
 
 #include <cstdint>
-#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
-#include "absl/container/flat_hash_set.h"
+#include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
+#include "xls/common/status/status_macros.h"
 #include "xls/data_structures/inline_bitmap.h"
+#include "xls/data_structures/reachability_index.h"
 #include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
-#include "xls/ir/topo_sort.h"
 
 namespace xls {
 
-namespace {
+absl::StatusOr<DependencyBitmap> NodeDependencyAnalysis::GetDependents(
+    Node* node) const {
+  if (!IsAnalyzed(node)) {
+    return absl::InvalidArgumentError("Node is not analyzed");
+  }
+  return DependencyBitmap(dependents_.at(node), node_indices_);
+}
+
+/* static */ NodeDependencyAnalysis NodeDependencyAnalysis::Create(
+    FunctionBase* fb, bool is_forward, absl::Span<Node* const> nodes) {
+  // The IR is acyclic so building the index can only fail on malformed
+  // functions.
+  absl::StatusOr<NodeReachability> reachability =
+      is_forward ? NodeReachability::ForwardDependents(fb)
+                 : NodeReachability::BackwardDependents(fb);
+  CHECK_OK(reachability.status());
+  absl::Span<Node* const> analyzed = nodes;
+  std::vector<Node*> all_nodes;
+  if (nodes.empty()) {
+    all_nodes.assign(fb->nodes().begin(), fb->nodes().end());
+    analyzed = all_nodes;
+  }
+  absl::flat_hash_map<Node*, InlineBitmap> dependents;
+  dependents.reserve(analyzed.size());
+  for (Node* node : analyzed) {
+    // Nodes of other functions are left unanalyzed.
+    if (dependents.contains(node) ||
+        !reachability->node_indices().contains(node)) {
+      continue;
+    }
+    dependents.emplace(node, *reachability->GetDependents(node));
+  }
+  return NodeDependencyAnalysis(is_forward, std::move(dependents),
+                                reachability->node_indices());
+}
+
+NodeDependencyAnalysis NodeDependencyAnalysis::BackwardDependents(
+    FunctionBase* fb, absl::Span<Node* const> nodes) {
+  return Create(fb, /*is_forward=*/false, nodes);
+}
+
+NodeDependencyAnalysis NodeDependencyAnalysis::ForwardDependents(
+    FunctionBase* fb, absl::Span<Node* const> nodes) {
+  return Create(fb, /*is_forward=*/true, nodes);
+}
 
-// Perform actual analysis.
-// f is the function to analyze. We only care about getting results for
-// 'interesting_nodes' if the set is non-empty (otherwise all nodes are
-// searched). Preds returns the nodes the argument depends on. iter is the
-// iterator to walk the function in the topological order defined by preds.
-template <typename Predecessors>
-std::tuple<absl::flat_hash_map<Node*, InlineBitmap>,
-           absl::flat_hash_map<Node*, int64_t>>
-AnalyzeDependents(FunctionBase* f,
-                  const absl::flat_hash_set<Node*>& interesting_nodes,
-                  Predecessors preds, absl::Span<Node* const> topo_sort) {
+/* static */ absl::StatusOr<NodeReachability> NodeReachability::Create(
+    FunctionBase* fb, bool is_forward,
+    const ReachabilityIndexOptions& options) {
   absl::flat_hash_map<Node*, int64_t> node_ids;
-  node_ids.reserve(f->node_count());
+  node_ids.reserve(fb->node_count());
   int64_t cnt = 0;
-  for (Node* n : f->nodes()) {
+  for (Node* n : fb->nodes()) {
     node_ids[n] = cnt++;
   }
-  auto is_interesting = [&](Node* n) {
-    return interesting_nodes.empty() || interesting_nodes.contains(n);
-  };
-  int64_t seen_interesting_nodes_count = 0;
-  auto is_last_interesting_node = [&](Node* node) {
-    if (interesting_nodes.empty()) {
-      return false;
-    }
-    if (interesting_nodes.contains(node)) {
-      ++seen_interesting_nodes_count;
-    }
-    return seen_interesting_nodes_count == interesting_nodes.size();
-  };
-  int64_t bitmap_size = f->node_count();
-  absl::flat_hash_map<Node*, InlineBitmap> results;
-  results.reserve(f->node_count());
-  for (Node* n : topo_sort) {
-    InlineBitmap& bm = results.emplace(n, bitmap_size).first->second;
-    bm.Set(node_ids[n]);
-    for (Node* pred : preds(n)) {
-      bm.Union(results.at(pred));
-    }
-    if (is_last_interesting_node(n)) {
-      break;
+  std::vector<std::pair<int64_t, int64_t>> edges;
+  for (Node* n : fb->nodes()) {
+    for (Node* operand : n->operands()) {
+      if (is_forward) {
+        edges.push_back({node_ids.at(operand), node_ids.at(n)});
+      } else {
+        edges.push_back({node_ids.at(n), node_ids.at(operand)});
+      }
     }
   }
-  // To avoid any bugs delete everything that's not specifically requested.
-  absl::erase_if(results,
-                 [&](auto& pair) { return !is_interesting(pair.first); });
-  return {results, node_ids};
+  // The IR is acyclic so this can only fail on malformed functions.
+  XLS_ASSIGN_OR_RETURN(
+      ReachabilityIndex index,
+      ReachabilityIndex::Create(node_ids.size(), edges, options));
+  return NodeReachability(is_forward, std::move(index), std::move(node_ids));
 }
 
-}  // namespace
+absl::StatusOr<NodeReachability> NodeReachability::ForwardDependents(
+    FunctionBase* fb, const ReachabilityIndexOptions& options) {
+  return Create(fb, /*is_forward=*/true, options);
+}
 
-absl::StatusOr<DependencyBitmap> NodeDependencyAnalysis::GetDependents(
-    Node* node) const {
-  if (!IsAnalyzed(node)) {
-    return absl::InvalidArgumentError("Node is not analyzed");
+absl::StatusOr<NodeReachability> NodeReachability::BackwardDependents(
+    FunctionBase* fb, const ReachabilityIndexOptions& options) {
+  return Create(fb, /*is_forward=*/false, options);
+}
+
+absl::StatusOr<int64_t> NodeReachability::GetIndex(Node* node) const {
+  auto it = node_indices_.find(node);
+  if (it == node_indices_.end()) {
+    return absl::InvalidArgumentError("node is from a different function!");
   }
-  return DependencyBitmap(dependents_.at(node), node_indices_);
+  return it->second;
 }
 
-NodeDependencyAnalysis NodeDependencyAnalysis::BackwardDependents(
-    FunctionBase* fb, absl::Span<Node* const> nodes) {
-  absl::flat_hash_set<Node*> interesting(nodes.begin(), nodes.end());
-  auto [dependents, node_ids] = AnalyzeDependents(
-      fb, interesting, [](Node* node) { return node->operands(); },
-      TopoSort(fb));
-  return NodeDependencyAnalysis(/*is_forwards=*/false, dependents, node_ids);
+absl::StatusOr<bool> NodeReachability::IsDependent(Node* from,
+                                                   Node* to) const {
+  XLS_ASSIGN_OR_RETURN(int64_t from_index, GetIndex(from));
+  XLS_ASSIGN_OR_RETURN(int64_t to_index, GetIndex(to));
+  return index_.IsReachable(from_index, to_index);
 }
 
-NodeDependencyAnalysis NodeDependencyAnalysis::ForwardDependents(
-    FunctionBase* fb, absl::Span<Node* const> nodes) {
-  absl::flat_hash_set<Node*> interesting(nodes.begin(), nodes.end());
-  auto [dependents, node_ids] = AnalyzeDependents(
-      fb, interesting, [](Node* node) { return node->users(); },
-      ReverseTopoSort(fb));
-  return NodeDependencyAnalysis(/*is_forwards=*/true, dependents, node_ids);
+absl::StatusOr<InlineBitmap> NodeReachability::GetDependents(
+    Node* node) const {
+  XLS_ASSIGN_OR_RETURN(int64_t index, GetIndex(node));
+  return index_.GetReachable(index);
 }
 
 }  // namespace xls
@@ -17,6 +17,7 @@
 
 #include <cstdint>
 #include <utility>
+#include <vector>
 
 #include "absl/base/attributes.h"
 #include "absl/container/flat_hash_map.h"
@@ -25,6 +26,7 @@
 #include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/data_structures/inline_bitmap.h"
+#include "xls/data_structures/reachability_index.h"
 #include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
 
@@ -62,6 +64,10 @@ class DependencyBitmap {
 
 // Analysis which lets us check whether different nodes are connected or over a
 // horizon from each other.
+//
+// The dependents are read off a NodeReachability index of the function and a
+// bitmap is only materialized for each analyzed node. Prefer NodeReachability
+// directly when dependents are needed for most nodes of a large function.
 class NodeDependencyAnalysis {
  public:
   NodeDependencyAnalysis(NodeDependencyAnalysis&&) = default;
@@ -114,11 +120,75 @@ class NodeDependencyAnalysis {
         dependents_(std::move(dependents)),
         node_indices_(std::move(node_ids)) {}
 
+  static NodeDependencyAnalysis Create(FunctionBase* fb, bool is_forward,
+                                       absl::Span<Node* const> nodes);
+
   bool is_forward_;
   absl::flat_hash_map<Node*, InlineBitmap> dependents_;
   absl::flat_hash_map<Node*, int64_t> node_indices_;
 };
 
+// Compressed alternative to NodeDependencyAnalysis for large functions.
+// NodeDependencyAnalysis stores a bitmap of dependents for every node which
+// needs O(n^2) memory. This stores a ReachabilityIndex with memory linear in
+// the size of the function and computes dependents on demand.
+class NodeReachability {
+ public:
+  NodeReachability(NodeReachability&&) = default;
+  NodeReachability(const NodeReachability&) = default;
+  NodeReachability& operator=(NodeReachability&&) = default;
+  NodeReachability& operator=(const NodeReachability&) = default;
+
+  // Index the forward dependents of every node, i.e., the nodes which are fed
+  // by a given node.
+  static absl::StatusOr<NodeReachability> ForwardDependents(
+      FunctionBase* fb,
+      const ReachabilityIndexOptions& options = ReachabilityIndexOptions());
+
+  // Index the backwards dependents of every node, i.e., the nodes which feed a
+  // given node.
+  static absl::StatusOr<NodeReachability> BackwardDependents(
+      FunctionBase* fb,
+      const ReachabilityIndexOptions& options = ReachabilityIndexOptions());
+
+  // Returns if this is a forwards-dependency relationship. That is if
+  // 'IsDependent(X, Y)' implies that a change in X could cause a change in Y.
+  bool IsForward() const { return is_forward_; }
+
+  // Return if 'to' is a dependent of 'from'. Every node is a dependent of
+  // itself.
+  absl::StatusOr<bool> IsDependent(Node* from, Node* to) const;
+
+  // Get the bitmap of dependents of 'node' indexed by node_indices(). The
+  // bitmap is computed by this call.
+  absl::StatusOr<InlineBitmap> GetDependents(Node* node) const;
+
+  const absl::flat_hash_map<Node*, int64_t>& node_indices() const {
+    return node_indices_;
+  }
+
+  // Returns the number of bytes of heap memory held by the reachability
+  // index.
+  int64_t MemoryUsage() const { return index_.MemoryUsage(); }
+
+ private:
+  NodeReachability(bool is_forward, ReachabilityIndex index,
+                   absl::flat_hash_map<Node*, int64_t> node_indices)
+      : is_forward_(is_forward),
+        index_(std::move(index)),
+        node_indices_(std::move(node_indices)) {}
+
+  static absl::StatusOr<NodeReachability> Create(
+      FunctionBase* fb, bool is_forward,
+      const ReachabilityIndexOptions& options);
+
+  absl::StatusOr<int64_t> GetIndex(Node* node) const;
+
+  bool is_forward_;
+  ReachabilityIndex index_;
+  absl::flat_hash_map<Node*, int64_t> node_indices_;
+};
+
 }  // namespace xls
 
 #endif  // XLS_PASSES_NODE_DEPENDENCY_ANALYSIS_H_
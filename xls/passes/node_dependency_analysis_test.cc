@@ -22,14 +22,19 @@
 #include "benchmark/benchmark.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status_matchers.h"
 #include "absl/strings/str_format.h"
 #include "xls/common/status/matchers.h"
+#include "xls/data_structures/inline_bitmap.h"
 #include "xls/ir/benchmark_support.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
 #include "xls/ir/package.h"
+#include "xls/ir/topo_sort.h"
 
 namespace xls {
 namespace {
@@ -295,6 +300,82 @@ TEST_F(NodeDependencyAnalysisTest, WorksWithNodeIdGaps) {
               testing::Not(absl_testing::IsOk()));
 }
 
+TEST_F(NodeDependencyAnalysisTest, ReachabilityMatchesTransitiveClosure) {
+  auto p = CreatePackage();
+  benchmark_support::strategy::DistinctLiteral selector;
+  benchmark_support::strategy::CaseSelect csts(selector);
+  benchmark_support::strategy::DistinctLiteral leaf;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto* f, benchmark_support::GenerateFullyConnectedLayerGraph(
+                   p.get(), /*depth=*/4, /*width=*/3, csts, leaf));
+  for (bool forward : {true, false}) {
+    // The dependents of each node computed directly from the graph.
+    absl::flat_hash_map<Node*, absl::flat_hash_set<Node*>> closure;
+    for (Node* node : forward ? ReverseTopoSort(f) : TopoSort(f)) {
+      absl::flat_hash_set<Node*>& dependents = closure[node];
+      dependents.insert(node);
+      for (Node* next : forward ? node->users() : node->operands()) {
+        dependents.insert(closure.at(next).begin(), closure.at(next).end());
+      }
+    }
+    NodeDependencyAnalysis nda(
+        forward ? NodeDependencyAnalysis::ForwardDependents(f)
+                : NodeDependencyAnalysis::BackwardDependents(f));
+    XLS_ASSERT_OK_AND_ASSIGN(
+        NodeReachability nr,
+        forward ? NodeReachability::ForwardDependents(f)
+                : NodeReachability::BackwardDependents(f));
+    EXPECT_EQ(nr.IsForward(), forward);
+    EXPECT_EQ(nr.node_indices(), nda.node_indices());
+    for (Node* from : f->nodes()) {
+      XLS_ASSERT_OK_AND_ASSIGN(DependencyBitmap analyzed,
+                               nda.GetDependents(from));
+      XLS_ASSERT_OK_AND_ASSIGN(InlineBitmap indexed, nr.GetDependents(from));
+      EXPECT_EQ(indexed, analyzed.bitmap());
+      for (Node* to : f->nodes()) {
+        bool expected = closure.at(from).contains(to);
+        EXPECT_THAT(nr.IsDependent(from, to),
+                    absl_testing::IsOkAndHolds(expected))
+            << from->GetName() << " -> " << to->GetName();
+        EXPECT_EQ(indexed.Get(nr.node_indices().at(to)), expected)
+            << from->GetName() << " -> " << to->GetName();
+      }
+    }
+  }
+}
+
+TEST_F(NodeDependencyAnalysisTest, ReachabilityOtherFunction) {
+  auto p = CreatePackage();
+  FunctionBuilder fb_1(TestName() + "_first", p.get());
+  FunctionBuilder fb_2(TestName() + "_second", p.get());
+  BValue x1 = fb_1.Param("x", p->GetBitsType(8));
+  BValue y1 = fb_1.Not(x1);
+  BValue x2 = fb_2.Param("x", p->GetBitsType(8));
+  XLS_ASSERT_OK_AND_ASSIGN(auto* f1, fb_1.Build());
+  XLS_ASSERT_OK(fb_2.Build().status());
+  XLS_ASSERT_OK_AND_ASSIGN(NodeReachability nr,
+                           NodeReachability::ForwardDependents(f1));
+  EXPECT_THAT(nr.IsDependent(x1.node(), y1.node()),
+              absl_testing::IsOkAndHolds(true));
+  EXPECT_THAT(nr.IsDependent(y1.node(), x1.node()),
+              absl_testing::IsOkAndHolds(false));
+  EXPECT_THAT(nr.IsDependent(x1.node(), x2.node()),
+              testing::Not(absl_testing::IsOk()));
+  EXPECT_THAT(nr.GetDependents(x2.node()), testing::Not(absl_testing::IsOk()));
+}
+
+// Heap memory held by the analyses, reported by the benchmarks below.
+int64_t MemoryUsage(const NodeDependencyAnalysis& nda) {
+  int64_t bytes = 0;
+  for (const auto& [node, _] : nda.node_indices()) {
+    if (nda.IsAnalyzed(node)) {
+      bytes += (nda.node_indices().size() + 63) / 64 * sizeof(uint64_t);
+    }
+  }
+  return bytes;
+}
+int64_t MemoryUsage(const NodeReachability& nr) { return nr.MemoryUsage(); }
+
 template <typename Iter>
 Node* NodeAt(Iter nodes, int64_t off) {
   return *std::next(nodes.begin(), off);
@@ -313,6 +394,7 @@ void BM_NDABinaryTree(Analyze analyze, benchmark::State& state) {
     auto v = analyze(f);
     benchmark::DoNotOptimize(v);
   }
+  state.counters["bytes"] = MemoryUsage(analyze(f));
 }
 void BM_NDABinaryTreeForward(benchmark::State& state) {
   BM_NDABinaryTree(
@@ -378,6 +460,7 @@ void BM_NDADense(Analyze analyze, benchmark::State& state) {
     auto v = analyze(f);
     benchmark::DoNotOptimize(v);
   }
+  state.counters["bytes"] = MemoryUsage(analyze(f));
 }
 
 void BM_NDADenseForward(benchmark::State& state) {
@@ -442,6 +525,7 @@ void BM_NDALadder(Analyze analyze, benchmark::State& state) {
     auto v = analyze(f);
     benchmark::DoNotOptimize(v);
   }
+  state.counters["bytes"] = MemoryUsage(analyze(f));
 }
 void BM_NDALadderForward(benchmark::State& state) {
   BM_NDALadder(
@@ -488,6 +572,39 @@ void BM_NDALadderBackwardMidOnly(benchmark::State& state) {
       state);
 }
 
+// The same graphs indexed by NodeReachability for comparison of build time
+// and memory.
+void BM_NRBinaryTreeForward(benchmark::State& state) {
+  BM_NDABinaryTree(
+      [](auto f) { return NodeReachability::ForwardDependents(f).value(); },
+      state);
+}
+void BM_NRBinaryTreeBackward(benchmark::State& state) {
+  BM_NDABinaryTree(
+      [](auto f) { return NodeReachability::BackwardDependents(f).value(); },
+      state);
+}
+void BM_NRLadderForward(benchmark::State& state) {
+  BM_NDALadder(
+      [](auto f) { return NodeReachability::ForwardDependents(f).value(); },
+      state);
+}
+void BM_NRLadderBackward(benchmark::State& state) {
+  BM_NDALadder(
+      [](auto f) { return NodeReachability::BackwardDependents(f).value(); },
+      state);
+}
+void BM_NRDenseForward(benchmark::State& state) {
+  BM_NDADense(
+      [](auto f) { return NodeReachability::ForwardDependents(f).value(); },
+      state);
+}
+void BM_NRDenseBackward(benchmark::State& state) {
+  BM_NDADense(
+      [](auto f) { return NodeReachability::BackwardDependents(f).value(); },
+      state);
+}
+
 BENCHMARK(BM_NDABinaryTreeForward)->DenseRange(2, 12, 2);
 BENCHMARK(BM_NDABinaryTreeBackward)->DenseRange(2, 12, 2);
 BENCHMARK(BM_NDABinaryTreeForwardReturnOnly)->DenseRange(2, 12, 2);
@@ -506,6 +623,12 @@ BENCHMARK(BM_NDADenseForwardReturnOnly)->RangePair(2, 512, 3, 32);
 BENCHMARK(BM_NDADenseBackwardReturnOnly)->RangePair(2, 512, 3, 32);
 BENCHMARK(BM_NDADenseForwardMidOnly)->RangePair(2, 512, 3, 32);
 BENCHMARK(BM_NDADenseBackwardMidOnly)->RangePair(2, 512, 3, 32);
+BENCHMARK(BM_NRBinaryTreeForward)->DenseRange(2, 12, 2);
+BENCHMARK(BM_NRBinaryTreeBackward)->DenseRange(2, 12, 2);
+BENCHMARK(BM_NRLadderForward)->Range(2, 1024);
+BENCHMARK(BM_NRLadderBackward)->Range(2, 1024);
+BENCHMARK(BM_NRDenseForward)->RangePair(2, 512, 3, 32);
+BENCHMARK(BM_NRDenseBackward)->RangePair(2, 512, 3, 32);
 
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,438 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/passes/optimization_context.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/data_structures/leaf_type_tree.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/call_graph.h"
+#include "xls/ir/change_listener.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/interval_set.h"
+#include "xls/ir/node.h"
+#include "xls/ir/ternary.h"
+#include "xls/ir/value.h"
+#include "xls/passes/bdd_function.h"
+#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/pass_base.h"
+#include "xls/passes/predicate_state.h"
+#include "xls/passes/query_engine.h"
+#include "xls/passes/range_query_engine.h"
+#include "xls/passes/ternary_query_engine.h"
+
+namespace xls {
+namespace {
+
+std::unique_ptr<QueryEngine> CreateQueryEngine(
+    QueryEngineKind kind, const QueryEngineOptions& options) {
+  switch (kind) {
+    case QueryEngineKind::kTernary:
+      return std::make_unique<TernaryQueryEngine>();
+    case QueryEngineKind::kRange:
+      return std::make_unique<RangeQueryEngine>();
+    case QueryEngineKind::kBdd:
+      return std::make_unique<BddQueryEngine>(
+          BddFunction::kDefaultPathLimit, IsCheapForBdds, options.bdd);
+  }
+  LOG(FATAL) << "Invalid query engine kind: " << static_cast<int>(kind);
+}
+
+// A query engine which forwards to an engine cached in an OptimizationContext.
+class SharedQueryEngineView final : public QueryEngine {
+ public:
+  SharedQueryEngineView(OptimizationContext* context, QueryEngineKind kind)
+      : context_(context), kind_(kind) {}
+
+  absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override {
+    XLS_ASSIGN_OR_RETURN(engine_, context_->GetQueryEngine(f, kind_));
+    return ReachedFixpoint::Changed;
+  }
+  bool IsTracked(Node* node) const override {
+    return engine().IsTracked(node);
+  }
+  std::optional<SharedLeafTypeTree<TernaryVector>> GetTernary(
+      Node* node) const override {
+    return engine().GetTernary(node);
+  }
+  std::unique_ptr<QueryEngine> SpecializeGivenPredicate(
+      const absl::flat_hash_set<PredicateState>& state) const override {
+    return engine().SpecializeGivenPredicate(state);
+  }
+  std::unique_ptr<QueryEngine> SpecializeGiven(
+      const absl::flat_hash_map<Node*, ValueKnowledge>& givens)
+      const override {
+    return engine().SpecializeGiven(givens);
+  }
+  LeafTypeTree<IntervalSet> GetIntervals(Node* node) const override {
+    return engine().GetIntervals(node);
+  }
+  bool AtMostOneTrue(absl::Span<TreeBitLocation const> bits) const override {
+    return engine().AtMostOneTrue(bits);
+  }
+  bool AtLeastOneTrue(absl::Span<TreeBitLocation const> bits) const override {
+    return engine().AtLeastOneTrue(bits);
+  }
+  bool Implies(const TreeBitLocation& a,
+               const TreeBitLocation& b) const override {
+    return engine().Implies(a, b);
+  }
+  std::optional<Bits> ImpliedNodeValue(
+      absl::Span<const std::pair<TreeBitLocation, bool>> predicate_bit_values,
+      Node* node) const override {
+    return engine().ImpliedNodeValue(predicate_bit_values, node);
+  }
+  std::optional<TernaryVector> ImpliedNodeTernary(
+      absl::Span<const std::pair<TreeBitLocation, bool>> predicate_bit_values,
+      Node* node) const override {
+    return engine().ImpliedNodeTernary(predicate_bit_values, node);
+  }
+  bool KnownEquals(const TreeBitLocation& a,
+                   const TreeBitLocation& b) const override {
+    return engine().KnownEquals(a, b);
+  }
+  bool KnownNotEquals(const TreeBitLocation& a,
+                      const TreeBitLocation& b) const override {
+    return engine().KnownNotEquals(a, b);
+  }
+  bool AtMostOneBitTrue(Node* node) const override {
+    return engine().AtMostOneBitTrue(node);
+  }
+  bool AtLeastOneBitTrue(Node* node) const override {
+    return engine().AtLeastOneBitTrue(node);
+  }
+  bool ExactlyOneBitTrue(Node* node) const override {
+    return engine().ExactlyOneBitTrue(node);
+  }
+  bool IsKnown(const TreeBitLocation& bit) const override {
+    return engine().IsKnown(bit);
+  }
+  std::optional<bool> KnownValue(const TreeBitLocation& bit) const override {
+    return engine().KnownValue(bit);
+  }
+  std::optional<Value> KnownValue(Node* node) const override {
+    return engine().KnownValue(node);
+  }
+  bool IsAllZeros(Node* node) const override {
+    return engine().IsAllZeros(node);
+  }
+  bool IsAllOnes(Node* node) const override {
+    return engine().IsAllOnes(node);
+  }
+  bool IsFullyKnown(Node* node) const override {
+    return engine().IsFullyKnown(node);
+  }
+  Bits MaxUnsignedValue(Node* node) const override {
+    return engine().MaxUnsignedValue(node);
+  }
+  Bits MinUnsignedValue(Node* node) const override {
+    return engine().MinUnsignedValue(node);
+  }
+
+ private:
+  const QueryEngine& engine() const {
+    CHECK(engine_ != nullptr) << "Shared query engine used before Populate";
+    return *engine_;
+  }
+
+  OptimizationContext* context_;
+  QueryEngineKind kind_;
+  QueryEngine* engine_ = nullptr;
+};
+
+}  // namespace
+
+std::string_view QueryEngineKindToString(QueryEngineKind kind) {
+  switch (kind) {
+    case QueryEngineKind::kTernary:
+      return "ternary";
+    case QueryEngineKind::kRange:
+      return "range";
+    case QueryEngineKind::kBdd:
+      return "bdd";
+  }
+  LOG(FATAL) << "Invalid query engine kind: " << static_cast<int>(kind);
+}
+
+// The cached engines of a single function and the changes made to the
+// function since each engine was last brought up to date.
+class OptimizationContext::FunctionState : public ChangeListener {
+ public:
+  FunctionState(OptimizationContext* context, FunctionBase* f)
+      : context_(context), f_(f) {
+    f_->AddChangeListener(this);
+  }
+  ~FunctionState() override {
+    if (f_ != nullptr) {
+      f_->RemoveChangeListener(this);
+    }
+  }
+
+  FunctionState(const FunctionState&) = delete;
+  FunctionState& operator=(const FunctionState&) = delete;
+
+  absl::StatusOr<QueryEngine*> GetQueryEngine(QueryEngineKind kind,
+                                              AnalysisCacheStats& stats) {
+    CachedEngine& cached = engines_[static_cast<int64_t>(kind)];
+    if (cached.engine != nullptr && !cached.dirty) {
+      ++stats.hit_count;
+      return cached.engine.get();
+    }
+    if (cached.engine != nullptr && cached.incremental) {
+      std::vector<Node*> changed(cached.changed.begin(), cached.changed.end());
+      std::vector<Node*> removed(cached.removed.begin(), cached.removed.end());
+      XLS_RETURN_IF_ERROR(
+          static_cast<TernaryQueryEngine*>(cached.engine.get())
+              ->UpdateNodes(f_, changed, removed));
+      ++stats.incremental_update_count;
+      stats.updated_node_count += changed.size();
+    } else {
+      ++stats.miss_count;
+      cached.engine =
+          CreateQueryEngine(kind, context_->query_engine_options_);
+      cached.incremental = kind == QueryEngineKind::kTernary;
+      XLS_RETURN_IF_ERROR(cached.engine->Populate(f_).status());
+    }
+    cached.dirty = false;
+    cached.changed.clear();
+    cached.removed.clear();
+    return cached.engine.get();
+  }
+
+  // Returns the number of changes made to the function since the state was
+  // created.
+  int64_t version() const { return version_; }
+  void IncrementVersion() { ++version_; }
+
+  // Returns the functions called and blocks instantiated by the function.
+  // Computed once per version.
+  absl::Span<FunctionBase* const> callees() {
+    if (callees_version_ != version_) {
+      callees_ = CalledFunctions(f_);
+      callees_version_ = version_;
+    }
+    return callees_;
+  }
+
+  // The passes which ran on the function without changing it, indexed by
+  // pass.
+  absl::flat_hash_map<const void*, NoOpRun>& no_op_runs() {
+    return no_op_runs_;
+  }
+
+  void NodeAdded(Node* node) override { MarkChanged(node); }
+
+  void NodeDeleted(Node* node) override {
+    ++version_;
+    for (CachedEngine& cached : engines_) {
+      cached.dirty = true;
+      if (TracksNodes(cached)) {
+        cached.changed.erase(node);
+        cached.removed.insert(node);
+      }
+    }
+  }
+
+  void OperandChanged(Node* node, Node* old_operand,
+                      Node* new_operand) override {
+    MarkChanged(node);
+  }
+
+  void FunctionBaseDeleted(FunctionBase* function_base) override {
+    f_ = nullptr;
+    // Destroys this object.
+    context_->functions_.erase(function_base);
+  }
+
+ private:
+  struct CachedEngine {
+    std::unique_ptr<QueryEngine> engine;
+    // Whether the engine is updated incrementally.
+    bool incremental = false;
+    // Whether the function changed since the engine was last brought up to
+    // date.
+    bool dirty = false;
+    // The nodes which were added or had their operands changed, and the nodes
+    // which were removed, since the engine was last brought up to date. Only
+    // maintained for engines which are updated incrementally.
+    absl::flat_hash_set<Node*> changed;
+    absl::flat_hash_set<Node*> removed;
+  };
+
+  static bool TracksNodes(const CachedEngine& cached) {
+    return cached.engine != nullptr && cached.incremental;
+  }
+
+  void MarkChanged(Node* node) {
+    ++version_;
+    for (CachedEngine& cached : engines_) {
+      cached.dirty = true;
+      if (TracksNodes(cached)) {
+        cached.changed.insert(node);
+      }
+    }
+  }
+
+  OptimizationContext* context_;
+  FunctionBase* f_;
+  std::array<CachedEngine, kQueryEngineKindCount> engines_;
+  int64_t version_ = 0;
+  std::vector<FunctionBase*> callees_;
+  std::optional<int64_t> callees_version_;
+  absl::flat_hash_map<const void*, NoOpRun> no_op_runs_;
+};
+
+OptimizationContext::OptimizationContext(QueryEngineOptions options)
+    : query_engine_options_(options) {}
+
+OptimizationContext::~OptimizationContext() = default;
+
+std::unique_ptr<QueryEngine> OptimizationContext::SharedQueryEngine(
+    QueryEngineKind kind) {
+  return std::make_unique<SharedQueryEngineView>(this, kind);
+}
+
+OptimizationContext::FunctionState& OptimizationContext::GetFunctionState(
+    FunctionBase* f) {
+  // Look up existing states without modifying the map so tracked functions
+  // may be queried concurrently.
+  auto it = functions_.find(f);
+  if (it != functions_.end()) {
+    return *it->second;
+  }
+  std::unique_ptr<FunctionState>& state = functions_[f];
+  state = std::make_unique<FunctionState>(this, f);
+  return *state;
+}
+
+void OptimizationContext::TrackFunctions(
+    absl::Span<FunctionBase* const> functions) {
+  for (FunctionBase* f : functions) {
+    GetFunctionState(f);
+  }
+}
+
+absl::StatusOr<QueryEngine*> OptimizationContext::GetQueryEngine(
+    FunctionBase* f, QueryEngineKind kind) {
+  AnalysisCacheStats stats;
+  absl::StatusOr<QueryEngine*> engine =
+      GetFunctionState(f).GetQueryEngine(kind, stats);
+  absl::MutexLock lock(&stats_mutex_);
+  stats_[static_cast<int64_t>(kind)] += stats;
+  return engine;
+}
+
+void OptimizationContext::BeginFunctionBasePass(
+    absl::Span<const PassInvocation> invocations) {
+  if (invocations.size() < synced_invocation_count_) {
+    // A new pipeline run started.
+    ++package_version_;
+    synced_invocation_count_ = 0;
+    announced_invocation_ = std::nullopt;
+  }
+  for (int64_t i = synced_invocation_count_; i < invocations.size(); ++i) {
+    if (invocations[i].ir_changed && announced_invocation_ != i) {
+      ++package_version_;
+    }
+  }
+  synced_invocation_count_ = invocations.size();
+  announced_invocation_ = invocations.size();
+}
+
+OptimizationContext::FunctionBaseVersion
+OptimizationContext::GetFunctionBaseVersion(FunctionBase* f) {
+  // Callees are tracked from here on so that later changes to them are seen.
+  int64_t callee_version = 0;
+  absl::flat_hash_set<FunctionBase*> visited = {f};
+  std::vector<FunctionBase*> worklist = {f};
+  while (!worklist.empty()) {
+    FunctionBase* g = worklist.back();
+    worklist.pop_back();
+    FunctionState& state = GetFunctionState(g);
+    if (g != f) {
+      callee_version += state.version();
+    }
+    for (FunctionBase* callee : state.callees()) {
+      if (visited.insert(callee).second) {
+        worklist.push_back(callee);
+      }
+    }
+  }
+  return FunctionBaseVersion{
+      .function_version = GetFunctionState(f).version(),
+      .callee_version = callee_version,
+      .package_version = package_version_};
+}
+
+bool OptimizationContext::IsKnownNoOp(const void* pass, FunctionBase* f,
+                                      int64_t opt_level) {
+  auto it = functions_.find(f);
+  if (it == functions_.end()) {
+    return false;
+  }
+  auto run_it = it->second->no_op_runs().find(pass);
+  return run_it != it->second->no_op_runs().end() &&
+         run_it->second == NoOpRun{.version = GetFunctionBaseVersion(f),
+                                   .opt_level = opt_level};
+}
+
+void OptimizationContext::RecordFunctionBasePassRun(
+    const void* pass, FunctionBase* f, const FunctionBaseVersion& version,
+    int64_t opt_level, bool changed) {
+  FunctionState& state = GetFunctionState(f);
+  if (changed) {
+    // The pass may have made changes which are not visible to the listener,
+    // such as setting the return value.
+    state.IncrementVersion();
+    state.no_op_runs().erase(pass);
+    return;
+  }
+  state.no_op_runs()[pass] =
+      NoOpRun{.version = version, .opt_level = opt_level};
+}
+
+void OptimizationContext::RecordStats(CompoundPassResult& result) const {
+  absl::MutexLock lock(&stats_mutex_);
+  for (int64_t i = 0; i < kQueryEngineKindCount; ++i) {
+    result.AddAnalysisCacheStats(
+        QueryEngineKindToString(static_cast<QueryEngineKind>(i)), stats_[i]);
+  }
+}
+
+std::unique_ptr<QueryEngine> MakeQueryEngine(OptimizationContext* context,
+                                             QueryEngineKind kind) {
+  if (context != nullptr) {
+    return context->SharedQueryEngine(kind);
+  }
+  return CreateQueryEngine(kind, QueryEngineOptions());
+}
+
+}  // namespace xls
@@ -0,0 +1,189 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_PASSES_OPTIMIZATION_CONTEXT_H_
+#define XLS_PASSES_OPTIMIZATION_CONTEXT_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xls/ir/function_base.h"
+#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/pass_base.h"
+#include "xls/passes/query_engine.h"
+
+namespace xls {
+
+// Kinds of query engines which can be shared between passes through an
+// OptimizationContext.
+enum class QueryEngineKind : uint8_t {
+  // A TernaryQueryEngine. Updated incrementally by re-evaluating only the
+  // forward cone of the changed nodes.
+  kTernary,
+  // A RangeQueryEngine. Recomputed if the function changed.
+  kRange,
+  // A BddQueryEngine with the default path limit which only evaluates nodes
+  // that are cheap for BDDs. Recomputed if the function changed.
+  kBdd,
+};
+inline constexpr int64_t kQueryEngineKindCount = 3;
+
+std::string_view QueryEngineKindToString(QueryEngineKind kind);
+
+// Options for the query engines created by an OptimizationContext or by
+// MakeQueryEngine.
+struct QueryEngineOptions {
+  // The options of BDD engines.
+  BddQueryEngineOptions bdd;
+};
+
+// Analysis state which is shared between the passes of an optimization
+// pipeline. Query engines are cached per FunctionBase and the context listens
+// for changes to each function with a cached engine. When a pass requests an
+// engine, an engine for an unchanged function is reused as is and a ternary
+// engine for a changed function only re-evaluates the nodes affected by the
+// change. Functions which are deleted are dropped from the cache.
+//
+// The context also remembers which function-base passes ran on a function
+// without changing it so that those passes can be skipped on the function
+// until it or a function it calls changes again.
+//
+// The context must outlive every engine obtained from it and must be
+// destroyed before the package. It is thread-compatible with one exception:
+// once TrackFunctions has been called for a set of functions, engines for
+// distinct functions of the set may be requested concurrently.
+class OptimizationContext {
+ public:
+  // `options` configures the engines created by the context.
+  explicit OptimizationContext(QueryEngineOptions options = {});
+  ~OptimizationContext();
+
+  OptimizationContext(const OptimizationContext&) = delete;
+  OptimizationContext& operator=(const OptimizationContext&) = delete;
+
+  // Returns a query engine which forwards to the engine of the given kind
+  // cached in this context. Populating the returned engine with a function
+  // brings the cached engine for that function up to date rather than
+  // computing a new one. Engines specialized from the returned engine are
+  // invalidated by the next Populate call.
+  std::unique_ptr<QueryEngine> SharedQueryEngine(QueryEngineKind kind);
+
+  // Returns the cached engine of the given kind for `f` updated to reflect
+  // the current state of `f`. The engine is owned by the context.
+  absl::StatusOr<QueryEngine*> GetQueryEngine(FunctionBase* f,
+                                              QueryEngineKind kind);
+
+  // Creates the cached state of each of the given functions which does not
+  // have one yet.
+  void TrackFunctions(absl::Span<FunctionBase* const> functions);
+
+  // Returns statistics about the requests for engines of the given kind.
+  AnalysisCacheStats stats(QueryEngineKind kind) const {
+    absl::MutexLock lock(&stats_mutex_);
+    return stats_[static_cast<int64_t>(kind)];
+  }
+
+  // Adds the statistics of all engine kinds to `result`.
+  void RecordStats(CompoundPassResult& result) const;
+
+  // Notes the start of a run of a function-base pass. `invocations` are the
+  // pass invocations recorded so far in the pipeline. Any change made by an
+  // invocation which was not itself announced through this method (for
+  // example a package-level pass) may have touched state outside of the
+  // function bodies, so it invalidates every recorded no-op run.
+  void BeginFunctionBasePass(absl::Span<const PassInvocation> invocations);
+
+  // The state a function-base pass running on a function depends on: the
+  // function itself, the functions it calls transitively, and any state
+  // outside of the function bodies.
+  struct FunctionBaseVersion {
+    int64_t function_version;
+    // The sum of the versions of the called functions. Versions only grow
+    // and the set of callees only changes along with `function_version`, so
+    // the sum only stays the same if no callee changed.
+    int64_t callee_version;
+    int64_t package_version;
+
+    bool operator==(const FunctionBaseVersion& other) const = default;
+  };
+
+  // Returns the current version of `f`. Take it before running a pass on `f`
+  // and pass it to RecordFunctionBasePassRun afterwards, so that callees
+  // changed by the same pass after it ran on `f` are not missed.
+  FunctionBaseVersion GetFunctionBaseVersion(FunctionBase* f);
+
+  // Returns true if the function-base pass `pass` previously ran on `f` with
+  // the same `opt_level` without changing it, and neither `f`, the functions
+  // it calls nor the package changed since. `pass` identifies the pass object
+  // and is never dereferenced. Function-base passes only depend on the
+  // function they are run on and its callees so running the pass again would
+  // be a no-op.
+  bool IsKnownNoOp(const void* pass, FunctionBase* f, int64_t opt_level);
+
+  // Records the result of running the function-base pass `pass` on `f`.
+  // `version` is the version of `f` before the pass ran.
+  void RecordFunctionBasePassRun(const void* pass, FunctionBase* f,
+                                 const FunctionBaseVersion& version,
+                                 int64_t opt_level, bool changed);
+
+ private:
+  class FunctionState;
+
+  // The state of the package when a function-base pass ran on a function
+  // without changing it.
+  struct NoOpRun {
+    FunctionBaseVersion version;
+    int64_t opt_level;
+
+    bool operator==(const NoOpRun& other) const = default;
+  };
+
+  FunctionState& GetFunctionState(FunctionBase* f);
+
+  QueryEngineOptions query_engine_options_;
+
+  absl::flat_hash_map<FunctionBase*, std::unique_ptr<FunctionState>>
+      functions_;
+  mutable absl::Mutex stats_mutex_;
+  std::array<AnalysisCacheStats, kQueryEngineKindCount> stats_
+      ABSL_GUARDED_BY(stats_mutex_);
+
+  // Incremented whenever a change is made which is not attributed to a
+  // single function base.
+  int64_t package_version_ = 0;
+  // The number of pass invocations inspected by BeginFunctionBasePass and the
+  // index of the invocation announced by its most recent call.
+  int64_t synced_invocation_count_ = 0;
+  std::optional<int64_t> announced_invocation_;
+};
+
+// Returns a query engine of the given kind for use in a pass. If `context` is
+// non-null the engine is shared through the context, otherwise a new engine
+// is created with the default QueryEngineOptions. In either case the engine
+// must be populated before use.
+std::unique_ptr<QueryEngine> MakeQueryEngine(OptimizationContext* context,
+                                             QueryEngineKind kind);
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_OPTIMIZATION_CONTEXT_H_
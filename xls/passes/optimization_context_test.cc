@@ -0,0 +1,229 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/passes/optimization_context.h"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "xls/ir/source_location.h"
+#include "xls/ir/value.h"
+#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/query_engine.h"
+#include "xls/passes/ternary_query_engine.h"
+
+namespace xls {
+namespace {
+
+class OptimizationContextTest : public IrTestBase {
+ protected:
+  // Checks that `engine` agrees with a newly populated TernaryQueryEngine on
+  // every bits-typed node of `f`.
+  void ExpectMatchesNewTernaryEngine(FunctionBase* f,
+                                     const QueryEngine& engine) {
+    TernaryQueryEngine expected;
+    XLS_ASSERT_OK(expected.Populate(f).status());
+    for (Node* node : f->nodes()) {
+      if (!node->GetType()->IsBits()) {
+        continue;
+      }
+      ASSERT_TRUE(engine.IsTracked(node)) << node;
+      EXPECT_EQ(engine.GetTernary(node)->Get({}),
+                expected.GetTernary(node)->Get({}))
+          << node;
+    }
+  }
+};
+
+TEST_F(OptimizationContextTest, UnchangedFunctionIsHit) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[8]) -> bits[8] {
+  literal.2: bits[8] = literal(value=0x0f)
+  ret and.3: bits[8] = and(x, literal.2)
+}
+)",
+                                                       p.get()));
+  OptimizationContext context;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      QueryEngine * first,
+      context.GetQueryEngine(f, QueryEngineKind::kTernary));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      QueryEngine * second,
+      context.GetQueryEngine(f, QueryEngineKind::kTernary));
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(context.stats(QueryEngineKind::kTernary).miss_count, 1);
+  EXPECT_EQ(context.stats(QueryEngineKind::kTernary).hit_count, 1);
+  EXPECT_EQ(context.stats(QueryEngineKind::kRange).miss_count, 0);
+}
+
+TEST_F(OptimizationContextTest, TernaryEngineIsUpdatedIncrementally) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[8], y: bits[8]) -> bits[8] {
+  literal.3: bits[8] = literal(value=0x0f)
+  and.4: bits[8] = and(x, literal.3)
+  not.5: bits[8] = not(y)
+  ret or.6: bits[8] = or(and.4, not.5)
+}
+)",
+                                                       p.get()));
+  OptimizationContext context;
+  XLS_ASSERT_OK(context.GetQueryEngine(f, QueryEngineKind::kTernary).status());
+
+  // Change the mask, add a node and remove one.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * mask,
+      f->MakeNode<Literal>(SourceInfo(), Value(UBits(0x3c, 8))));
+  XLS_ASSERT_OK(FindNode("and.4", f)->ReplaceOperandNumber(1, mask));
+  XLS_ASSERT_OK(f->RemoveNode(FindNode("literal.3", f)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      QueryEngine * engine,
+      context.GetQueryEngine(f, QueryEngineKind::kTernary));
+  ExpectMatchesNewTernaryEngine(f, *engine);
+
+  // Replace the return value with a node which has fewer known bits.
+  Node* ret = f->return_value();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * neg, f->MakeNode<UnOp>(SourceInfo(), ret, Op::kNeg));
+  XLS_ASSERT_OK(f->set_return_value(neg));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      engine, context.GetQueryEngine(f, QueryEngineKind::kTernary));
+  ExpectMatchesNewTernaryEngine(f, *engine);
+
+  EXPECT_EQ(context.stats(QueryEngineKind::kTernary).miss_count, 1);
+  EXPECT_EQ(context.stats(QueryEngineKind::kTernary).incremental_update_count,
+            2);
+}
+
+TEST_F(OptimizationContextTest, RangeEngineIsRecomputedAfterChange) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[8]) -> bits[8] {
+  literal.2: bits[8] = literal(value=3)
+  ret umul.3: bits[8] = umul(x, literal.2)
+}
+)",
+                                                       p.get()));
+  OptimizationContext context;
+  XLS_ASSERT_OK(context.GetQueryEngine(f, QueryEngineKind::kRange).status());
+  XLS_ASSERT_OK(context.GetQueryEngine(f, QueryEngineKind::kRange).status());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * zero, f->MakeNode<Literal>(SourceInfo(), Value(UBits(0, 8))));
+  XLS_ASSERT_OK(FindNode("umul.3", f)->ReplaceOperandNumber(1, zero));
+  XLS_ASSERT_OK_AND_ASSIGN(QueryEngine * engine,
+                           context.GetQueryEngine(f, QueryEngineKind::kRange));
+  EXPECT_TRUE(engine->IsAllZeros(f->return_value()));
+  EXPECT_EQ(context.stats(QueryEngineKind::kRange).miss_count, 2);
+  EXPECT_EQ(context.stats(QueryEngineKind::kRange).hit_count, 1);
+}
+
+TEST_F(OptimizationContextTest, SharedQueryEngineForwardsToCachedEngine) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[8]) -> bits[8] {
+  literal.2: bits[8] = literal(value=0xf0)
+  ret and.3: bits[8] = and(x, literal.2)
+}
+)",
+                                                       p.get()));
+  OptimizationContext context;
+  std::unique_ptr<QueryEngine> first =
+      MakeQueryEngine(&context, QueryEngineKind::kTernary);
+  std::unique_ptr<QueryEngine> second =
+      MakeQueryEngine(&context, QueryEngineKind::kTernary);
+  XLS_ASSERT_OK(first->Populate(f).status());
+  XLS_ASSERT_OK(second->Populate(f).status());
+  EXPECT_EQ(first->KnownValueAsBits(FindNode("literal.2", f)),
+            UBits(0xf0, 8));
+  EXPECT_FALSE(second->IsKnown(TreeBitLocation(f->return_value(), 7)));
+  EXPECT_TRUE(second->IsKnown(TreeBitLocation(f->return_value(), 0)));
+  EXPECT_EQ(context.stats(QueryEngineKind::kTernary).miss_count, 1);
+  EXPECT_EQ(context.stats(QueryEngineKind::kTernary).hit_count, 1);
+}
+
+TEST_F(OptimizationContextTest, WithoutContextEnginesAreNotShared) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[8]) -> bits[8] {
+  ret neg.2: bits[8] = neg(x)
+}
+)",
+                                                       p.get()));
+  std::unique_ptr<QueryEngine> engine =
+      MakeQueryEngine(/*context=*/nullptr, QueryEngineKind::kBdd);
+  XLS_ASSERT_OK(engine->Populate(f).status());
+  EXPECT_TRUE(engine->IsTracked(f->return_value()));
+}
+
+TEST_F(OptimizationContextTest, BddDynamicReorderingIsConfigurable) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[8]) -> bits[8] {
+  ret neg.2: bits[8] = neg(x)
+}
+)",
+                                                       p.get()));
+  OptimizationContext default_context;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      QueryEngine * engine,
+      default_context.GetQueryEngine(f, QueryEngineKind::kBdd));
+  EXPECT_FALSE(
+      static_cast<BddQueryEngine*>(engine)->options().dynamic_reordering);
+
+  OptimizationContext reordering_context(
+      QueryEngineOptions{.bdd = {.dynamic_reordering = true}});
+  XLS_ASSERT_OK_AND_ASSIGN(
+      engine, reordering_context.GetQueryEngine(f, QueryEngineKind::kBdd));
+  EXPECT_TRUE(
+      static_cast<BddQueryEngine*>(engine)->options().dynamic_reordering);
+}
+
+TEST_F(OptimizationContextTest, RemovedFunctionIsDropped) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[8]) -> bits[8] {
+  ret neg.2: bits[8] = neg(x)
+}
+)",
+                                                       p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * g, ParseFunction(R"(
+fn g(x: bits[8]) -> bits[8] {
+  ret not.4: bits[8] = not(x)
+}
+)",
+                                                       p.get()));
+  OptimizationContext context;
+  XLS_ASSERT_OK(context.GetQueryEngine(f, QueryEngineKind::kTernary).status());
+  XLS_ASSERT_OK(context.GetQueryEngine(g, QueryEngineKind::kTernary).status());
+  XLS_ASSERT_OK(p->RemoveFunction(f));
+  XLS_ASSERT_OK(context.GetQueryEngine(g, QueryEngineKind::kTernary).status());
+  EXPECT_EQ(context.stats(QueryEngineKind::kTernary).hit_count, 1);
+}
+
+}  // namespace
+}  // namespace xls
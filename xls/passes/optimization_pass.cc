@@ -14,6 +14,7 @@
 
 #include "xls/passes/optimization_pass.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <iterator>
@@ -22,6 +23,7 @@
 #include <string_view>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
@@ -29,14 +31,20 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/types/span.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/math_util.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/work_stealing_thread_pool.h"
+#include "xls/ir/call_graph.h"
 #include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
 #include "xls/ir/package.h"
 #include "xls/ir/ram_rewrite.pb.h"
+#include "xls/passes/optimization_context.h"
 #include "xls/passes/pass_base.h"
+#include "xls/passes/simulation_oracle.h"
 
 namespace xls {
 
@@ -144,15 +152,186 @@ absl::StatusOr<bool> OptimizationFunctionBasePass::RunOnFunctionBase(
   return changed;
 }
 
+namespace {
+
+// Groups the function bases of the package into waves which can be
+// transformed concurrently. Every function base called or instantiated by a
+// function base of a wave is in an earlier wave. Within a wave function bases
+// are in package order.
+std::vector<std::vector<FunctionBase*>> GroupByCallDepth(Package* p) {
+  absl::flat_hash_map<FunctionBase*, int64_t> depths;
+  int64_t max_depth = 0;
+  for (FunctionBase* f : FunctionsInPostOrder(p)) {
+    int64_t depth = 0;
+    for (FunctionBase* callee : CalledFunctions(f)) {
+      depth = std::max(depth, depths[callee] + 1);
+    }
+    depths[f] = depth;
+    max_depth = std::max(max_depth, depth);
+  }
+  std::vector<std::vector<FunctionBase*>> waves(max_depth + 1);
+  for (FunctionBase* f : p->GetFunctionBases()) {
+    waves[depths[f]].push_back(f);
+  }
+  return waves;
+}
+
+// Adds `offset` to the id of every node of `f` with an id of at least
+// `first_node_id`. Nodes are renumbered in decreasing id order so no two nodes
+// of `f` share an id at any point.
+void RenumberNodes(FunctionBase* f, int64_t first_node_id, int64_t offset) {
+  std::vector<Node*> nodes;
+  for (Node* node : f->nodes()) {
+    if (node->id() >= first_node_id) {
+      nodes.push_back(node);
+    }
+  }
+  absl::c_sort(nodes, [](Node* a, Node* b) { return a->id() > b->id(); });
+  for (Node* node : nodes) {
+    node->SetId(node->id() + offset);
+  }
+}
+
+}  // namespace
+
 absl::StatusOr<bool> OptimizationFunctionBasePass::RunInternal(
     Package* p, const OptimizationPassOptions& options,
     PassResults* results) const {
+  OptimizationContext* context = options.context;
+  if (context != nullptr) {
+    context->BeginFunctionBasePass(results->invocations);
+  }
+  // Collects the queries checked against a simulation by the engines used on
+  // this thread. Runs on other threads add theirs after they finish.
+  SimulationStatsScope simulation_stats;
+  std::vector<std::vector<FunctionBase*>> waves;
+  if (options.thread_pool == nullptr) {
+    for (FunctionBase* f : p->GetFunctionBases()) {
+      waves.push_back({f});
+    }
+  } else {
+    waves = GroupByCallDepth(p);
+    if (context != nullptr) {
+      // The context may only be used concurrently for tracked functions.
+      context->TrackFunctions(p->GetFunctionBases());
+    }
+  }
   bool changed = false;
-  for (FunctionBase* f : p->GetFunctionBases()) {
-    XLS_ASSIGN_OR_RETURN(bool function_changed,
-                         RunOnFunctionBaseInternal(f, options, results));
-    changed = changed || function_changed;
+  int64_t skipped_count = 0;
+  for (const std::vector<FunctionBase*>& wave : waves) {
+    std::vector<FunctionBase*> to_run;
+    std::vector<OptimizationContext::FunctionBaseVersion> versions;
+    for (FunctionBase* f : wave) {
+      if (context != nullptr &&
+          context->IsKnownNoOp(this, f, options.opt_level)) {
+        VLOG(3) << absl::StreamFormat(
+            "Skipping %s on %s. Unchanged since the pass last ran on it.",
+            short_name(), f->name());
+        ++skipped_count;
+        continue;
+      }
+      to_run.push_back(f);
+      if (context != nullptr) {
+        versions.push_back(context->GetFunctionBaseVersion(f));
+      }
+    }
+    std::vector<bool> function_changed;
+    if (to_run.size() > 1 && options.thread_pool != nullptr) {
+      XLS_ASSIGN_OR_RETURN(
+          function_changed,
+          RunOnFunctionBasesConcurrently(p, to_run, options, results,
+                                         &simulation_stats));
+    } else {
+      for (FunctionBase* f : to_run) {
+        XLS_ASSIGN_OR_RETURN(bool f_changed,
+                             RunOnFunctionBaseInternal(f, options, results));
+        function_changed.push_back(f_changed);
+      }
+    }
+    for (int64_t i = 0; i < to_run.size(); ++i) {
+      if (context != nullptr) {
+        context->RecordFunctionBasePassRun(this, to_run[i], versions[i],
+                                           options.opt_level,
+                                           function_changed[i]);
+      }
+      changed = changed || function_changed[i];
+    }
+  }
+  if (skipped_count > 0 && options.record_metrics) {
+    results->aggregate_results.AddSkippedFunctions(short_name(),
+                                                   skipped_count);
+  }
+  if (simulation_stats.stats().query_count > 0) {
+    VLOG(2) << absl::StreamFormat(
+        "%s: %d of %d symbolic queries refuted by simulation", short_name(),
+        simulation_stats.stats().refuted_count,
+        simulation_stats.stats().query_count);
+    if (options.record_metrics) {
+      results->aggregate_results.AddSimulatedQueries(
+          short_name(), simulation_stats.stats().query_count,
+          simulation_stats.stats().refuted_count);
+    }
+  }
+  return changed;
+}
+
+absl::StatusOr<std::vector<bool>>
+OptimizationFunctionBasePass::RunOnFunctionBasesConcurrently(
+    Package* p, absl::Span<FunctionBase* const> function_bases,
+    const OptimizationPassOptions& options, PassResults* results,
+    SimulationStatsScope* simulation_stats) const {
+  struct Outcome {
+    absl::StatusOr<bool> changed = false;
+    int64_t next_node_id;
+    TransformMetrics metrics;
+    SimulationFilterStats simulation_stats;
+  };
+  // Every function base numbers its new nodes starting from the same id. The
+  // ids only depend on the function base itself which makes the result
+  // independent of the order in which the function bases are transformed.
+  int64_t first_node_id = p->next_node_id();
+  std::vector<Outcome> outcomes(function_bases.size());
+  absl::BlockingCounter pending(function_bases.size());
+  for (int64_t i = 0; i < function_bases.size(); ++i) {
+    options.thread_pool->Schedule([&, i]() {
+      Outcome& outcome = outcomes[i];
+      {
+        ConcurrentTransformScope scope(p, first_node_id);
+        SimulationStatsScope simulation_scope;
+        outcome.changed =
+            RunOnFunctionBaseInternal(function_bases[i], options, results);
+        outcome.next_node_id = scope.next_node_id();
+        outcome.metrics = scope.transform_metrics();
+        outcome.simulation_stats = simulation_scope.stats();
+      }
+      pending.DecrementCount();
+    });
+  }
+  pending.Wait();
+
+  // Give the function bases disjoint id ranges in package order, as if they
+  // had been transformed one after another.
+  int64_t next_node_id = first_node_id;
+  std::vector<bool> changed;
+  changed.reserve(function_bases.size());
+  absl::Status status;
+  for (int64_t i = 0; i < function_bases.size(); ++i) {
+    const Outcome& outcome = outcomes[i];
+    if (next_node_id != first_node_id) {
+      RenumberNodes(function_bases[i], first_node_id,
+                    next_node_id - first_node_id);
+    }
+    next_node_id += outcome.next_node_id - first_node_id;
+    p->transform_metrics() = p->transform_metrics() + outcome.metrics;
+    simulation_stats->Add(outcome.simulation_stats);
+    if (outcome.changed.ok()) {
+      changed.push_back(*outcome.changed);
+    } else if (status.ok()) {
+      status = outcome.changed.status();
+    }
   }
+  p->set_next_node_id(std::max(p->next_node_id(), next_node_id));
+  XLS_RETURN_IF_ERROR(status);
   return changed;
 }
 
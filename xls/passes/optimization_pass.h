@@ -40,9 +40,13 @@
 #include "xls/passes/pass_base.h"
 #include "xls/passes/pass_registry.h"
 #include "xls/passes/pipeline_generator.h"
+#include "xls/passes/simulation_oracle.h"
 
 namespace xls {
 
+class OptimizationContext;
+class WorkStealingThreadPool;
+
 inline constexpr int64_t kMaxOptLevel = 3;
 
 // Metadata for RAMs.
@@ -156,6 +160,17 @@ struct OptimizationPassOptions : public PassOptionsBase {
 
   // Use select context during narrowing range analysis.
   bool use_context_narrowing_analysis = false;
+
+  // Analysis state shared between the passes of the pipeline (not owned). If
+  // null, each pass computes its analyses from scratch and function-base
+  // passes run on every function. See OptimizationContext.
+  OptimizationContext* context = nullptr;
+
+  // Thread pool on which function-base passes transform distinct function
+  // bases of the package concurrently (not owned). If null, function bases are
+  // transformed one after another on the calling thread. See
+  // OptimizationFunctionBasePass.
+  WorkStealingThreadPool* thread_pool = nullptr;
 };
 
 // An object containing information about the invocation of a pass (single call
@@ -319,6 +334,15 @@ inline bool OptimizationPassOptions::splits_enabled() const {
 
 // Abstract base class for passes operate at function/proc scope. The derived
 // class must define RunOnFunctionBaseInternal.
+//
+// If a thread pool is given in the options, the function bases are transformed
+// concurrently in waves ordered by call depth: a function base runs only after
+// every function it calls or block it instantiates has been transformed, so
+// passes may inspect the bodies of callees. Each function base is transformed
+// inside a ConcurrentTransformScope and the nodes created by the pass are
+// renumbered afterwards in the order of the function bases in the package. The
+// resulting IR is therefore independent of the number of threads. Passes must
+// only modify the function base they are run on and must not modify `results`.
 class OptimizationFunctionBasePass : public OptimizationPass {
  public:
   OptimizationFunctionBasePass(std::string_view short_name,
@@ -337,6 +361,15 @@ class OptimizationFunctionBasePass : public OptimizationPass {
                                    const OptimizationPassOptions& options,
                                    PassResults* results) const override;
 
+  // Runs the pass on each of the given function bases, none of which may call
+  // another, concurrently on `options.thread_pool`. Returns whether each
+  // function base changed. The simulation statistics of the runs are added to
+  // `simulation_stats`.
+  absl::StatusOr<std::vector<bool>> RunOnFunctionBasesConcurrently(
+      Package* p, absl::Span<FunctionBase* const> function_bases,
+      const OptimizationPassOptions& options, PassResults* results,
+      SimulationStatsScope* simulation_stats) const;
+
   virtual absl::StatusOr<bool> RunOnFunctionBaseInternal(
       FunctionBase* f, const OptimizationPassOptions& options,
       PassResults* results) const = 0;
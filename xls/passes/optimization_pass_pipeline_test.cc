@@ -16,6 +16,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -25,6 +26,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "xls/common/status/matchers.h"
+#include "xls/common/work_stealing_thread_pool.h"
 #include "xls/examples/sample_packages.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/function.h"
@@ -34,7 +36,9 @@
 #include "xls/ir/nodes.h"
 #include "xls/ir/op.h"
 #include "xls/ir/package.h"
+#include "xls/passes/optimization_context.h"
 #include "xls/passes/optimization_pass.h"
+#include "xls/passes/pass_base.h"
 
 namespace m = ::xls::op_matchers;
 
@@ -43,6 +47,40 @@ namespace {
 
 using ::absl_testing::IsOkAndHolds;
 
+// Returns the IR of a package without a top containing `count` functions
+// which each fold constants, call a shared helper and unroll a loop.
+std::string ManyFunctionsIr(int64_t count) {
+  std::string ir = R"(package many
+
+fn body(i: bits[32], acc: bits[32]) -> bits[32] {
+  ret add.1: bits[32] = add(i, acc)
+}
+
+fn helper(x: bits[32]) -> bits[32] {
+  one: bits[32] = literal(value=1)
+  ret add.2: bits[32] = add(x, one)
+}
+)";
+  for (int64_t i = 0; i < count; ++i) {
+    absl::StrAppendFormat(&ir, R"(
+fn f%d(x: bits[32], y: bits[32]) -> bits[32] {
+  a: bits[32] = literal(value=%d)
+  b: bits[32] = literal(value=3)
+  c: bits[32] = add(a, b)
+  d: bits[32] = umul(x, c)
+  e: bits[32] = identity(d)
+  f: bits[32] = invoke(e, to_apply=helper)
+  g: bits[32] = counted_for(f, trip_count=4, stride=1, body=body)
+  h: bits[32] = sub(g, y)
+  k: bits[32] = sub(h, h)
+  ret r: bits[32] = add(h, k)
+}
+)",
+                          i, i);
+  }
+  return ir;
+}
+
 class OptimizationPipelineTest : public IrTestBase {
  protected:
   OptimizationPipelineTest() = default;
@@ -92,6 +130,31 @@ class OptimizationPipelineTest : public IrTestBase {
   }
 };
 
+TEST_F(OptimizationPipelineTest, ConcurrentFunctionBasePassesAreDeterministic) {
+  std::string ir = ManyFunctionsIr(/*count=*/16);
+  std::optional<std::string> expected_ir;
+  std::optional<TransformMetrics> expected_metrics;
+  for (int64_t thread_count : {1, 2, 8}) {
+    XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, ParsePackage(ir));
+    OptimizationContext context;
+    WorkStealingThreadPool thread_pool(thread_count);
+    OptimizationPassOptions options;
+    options.context = &context;
+    options.thread_pool = &thread_pool;
+    PassResults results;
+    ASSERT_THAT(CreateOptimizationPassPipeline()->Run(p.get(), options,
+                                                      &results),
+                IsOkAndHolds(true));
+    if (!expected_ir.has_value()) {
+      expected_ir = p->DumpIr();
+      expected_metrics = p->transform_metrics();
+      continue;
+    }
+    EXPECT_EQ(p->DumpIr(), *expected_ir) << "thread count: " << thread_count;
+    EXPECT_EQ(p->transform_metrics().ToString(), expected_metrics->ToString());
+  }
+}
+
 TEST_F(OptimizationPipelineTest, IdentityRemoval) {
   auto p = CreatePackage();
   std::unique_ptr<OptimizationCompoundPass> pass_mgr =
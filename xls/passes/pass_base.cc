@@ -39,6 +39,23 @@ void CompoundPassResult::AddSinglePassResult(std::string_view pass_name,
   result.metrics = result.metrics + metrics;
 }
 
+void CompoundPassResult::AddSkippedPass(std::string_view pass_name) {
+  ++pass_results_[pass_name].skipped_count;
+}
+
+void CompoundPassResult::AddSkippedFunctions(std::string_view pass_name,
+                                             int64_t function_count) {
+  pass_results_[pass_name].skipped_function_count += function_count;
+}
+
+void CompoundPassResult::AddSimulatedQueries(std::string_view pass_name,
+                                             int64_t query_count,
+                                             int64_t refuted_count) {
+  SinglePassResult& result = pass_results_[pass_name];
+  result.simulated_query_count += query_count;
+  result.simulation_refuted_count += refuted_count;
+}
+
 void CompoundPassResult::AccumulateCompoundPassResult(
     const CompoundPassResult& other) {
   changed_ = changed_ || other.changed_;
@@ -46,9 +63,24 @@ void CompoundPassResult::AccumulateCompoundPassResult(
     SinglePassResult& pass_result = pass_results_[pass_name];
     pass_result.changed_count += other_pass_result.changed_count;
     pass_result.run_count += other_pass_result.run_count;
+    pass_result.skipped_count += other_pass_result.skipped_count;
+    pass_result.skipped_function_count +=
+        other_pass_result.skipped_function_count;
+    pass_result.simulated_query_count +=
+        other_pass_result.simulated_query_count;
+    pass_result.simulation_refuted_count +=
+        other_pass_result.simulation_refuted_count;
     pass_result.duration = pass_result.duration + other_pass_result.duration;
     pass_result.metrics = pass_result.metrics + other_pass_result.metrics;
   }
+  for (const auto& [analysis_name, stats] : other.analysis_cache_stats_) {
+    analysis_cache_stats_[analysis_name] += stats;
+  }
+}
+
+void CompoundPassResult::AddAnalysisCacheStats(
+    std::string_view analysis_name, const AnalysisCacheStats& stats) {
+  analysis_cache_stats_[analysis_name] += stats;
 }
 
 std::string CompoundPassResult::ToString() const {
@@ -67,9 +99,32 @@ std::string CompoundPassResult::ToString() const {
   for (const std::string& name : pass_names) {
     SinglePassResult result = pass_results_.at(name);
     absl::StrAppendFormat(
-        &s, "  %15s: changed %d/%d, total time %s, metrics %s\n", name,
-        result.changed_count, result.run_count, FormatDuration(result.duration),
+        &s,
+        "  %15s: changed %d/%d, skipped %d (%d functions), total time %s, "
+        "metrics %s\n",
+        name, result.changed_count, result.run_count, result.skipped_count,
+        result.skipped_function_count, FormatDuration(result.duration),
         result.metrics.ToString());
+    if (result.simulated_query_count > 0) {
+      absl::StrAppendFormat(
+          &s, "  %15s  %d of %d symbolic queries refuted by simulation\n", "",
+          result.simulation_refuted_count, result.simulated_query_count);
+    }
+  }
+  if (!analysis_cache_stats_.empty()) {
+    std::vector<std::string> analysis_names;
+    for (const auto& [name, _] : analysis_cache_stats_) {
+      analysis_names.push_back(name);
+    }
+    std::sort(analysis_names.begin(), analysis_names.end());
+    s += "Analysis cache statistics:\n";
+    for (const std::string& name : analysis_names) {
+      const AnalysisCacheStats& stats = analysis_cache_stats_.at(name);
+      absl::StrAppendFormat(
+          &s, "  %15s: hits %d, misses %d, incremental updates %d (%d nodes)\n",
+          name, stats.hit_count, stats.miss_count,
+          stats.incremental_update_count, stats.updated_node_count);
+    }
   }
   return s;
 }
@@ -78,6 +133,10 @@ PassResultProto SinglePassResult::ToProto() const {
   PassResultProto res;
   res.set_run_count(run_count);
   res.set_changed_count(changed_count);
+  res.set_skipped_count(skipped_count);
+  res.set_skipped_function_count(skipped_function_count);
+  res.set_simulated_query_count(simulated_query_count);
+  res.set_simulation_refuted_count(simulation_refuted_count);
   *res.mutable_metrics() = metrics.ToProto();
 
   absl::Duration rem;
@@ -88,11 +147,32 @@ PassResultProto SinglePassResult::ToProto() const {
   return res;
 }
 
+AnalysisCacheStats& AnalysisCacheStats::operator+=(
+    const AnalysisCacheStats& other) {
+  hit_count += other.hit_count;
+  miss_count += other.miss_count;
+  incremental_update_count += other.incremental_update_count;
+  updated_node_count += other.updated_node_count;
+  return *this;
+}
+
+AnalysisCacheStatsProto AnalysisCacheStats::ToProto() const {
+  AnalysisCacheStatsProto res;
+  res.set_hit_count(hit_count);
+  res.set_miss_count(miss_count);
+  res.set_incremental_update_count(incremental_update_count);
+  res.set_updated_node_count(updated_node_count);
+  return res;
+}
+
 PipelineMetricsProto CompoundPassResult::ToProto() const {
   PipelineMetricsProto res;
   for (const auto& [name, result] : pass_results_) {
     res.mutable_pass_results()->insert({name, result.ToProto()});
   }
+  for (const auto& [name, stats] : analysis_cache_stats_) {
+    res.mutable_analysis_cache_stats()->insert({name, stats.ToProto()});
+  }
   return res;
 }
 
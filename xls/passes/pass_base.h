@@ -96,6 +96,17 @@ struct SinglePassResult {
   int64_t run_count = 0;
   // How many runs changed the IR.
   int64_t changed_count = 0;
+  // How many times the pass was not run because the IR had not changed since
+  // its last run which did not change the IR.
+  int64_t skipped_count = 0;
+  // How many times a pass which runs on each function separately was not run
+  // on a function because the function had not changed since the last run of
+  // the pass on it which did not change it.
+  int64_t skipped_function_count = 0;
+  // How many symbolic queries were checked against a simulation of the
+  // function and how many of those the simulation refuted.
+  int64_t simulated_query_count = 0;
+  int64_t simulation_refuted_count = 0;
   // Aggregate transformation metrics across the runs.
   TransformMetrics metrics{};
   // Total duration of the running of the pass.
@@ -104,6 +115,21 @@ struct SinglePassResult {
   PassResultProto ToProto() const;
 };
 
+// Statistics about the reuse of an analysis which is cached between passes.
+struct AnalysisCacheStats {
+  // Requests served by an up to date result.
+  int64_t hit_count = 0;
+  // Requests which required computing the analysis from scratch.
+  int64_t miss_count = 0;
+  // Requests served by updating only the changed nodes of a previous result.
+  int64_t incremental_update_count = 0;
+  // Total number of changed nodes processed by incremental updates.
+  int64_t updated_node_count = 0;
+
+  AnalysisCacheStats& operator+=(const AnalysisCacheStats& other);
+  AnalysisCacheStatsProto ToProto() const;
+};
+
 // Data structure returned by contains aggregate statistics about the passes run
 // in a compound pass.
 class CompoundPassResult {
@@ -117,9 +143,23 @@ class CompoundPassResult {
                            absl::Duration duration,
                            const TransformMetrics& metrics);
 
+  // Record that the pass was skipped entirely or on `function_count`
+  // functions. See SinglePassResult.
+  void AddSkippedPass(std::string_view pass_name);
+  void AddSkippedFunctions(std::string_view pass_name, int64_t function_count);
+
+  // Record that the pass checked `query_count` symbolic queries against a
+  // simulation which refuted `refuted_count` of them. See SinglePassResult.
+  void AddSimulatedQueries(std::string_view pass_name, int64_t query_count,
+                           int64_t refuted_count);
+
   // Accumulates the statistics in `other` into this one.
   void AccumulateCompoundPassResult(const CompoundPassResult& other);
 
+  // Accumulates statistics about the analysis with the given name.
+  void AddAnalysisCacheStats(std::string_view analysis_name,
+                             const AnalysisCacheStats& stats);
+
   std::string ToString() const;
   PipelineMetricsProto ToProto() const;
 
@@ -128,6 +168,9 @@ class CompoundPassResult {
 
   // Aggregate results for each pass. Indexed by short name.
   absl::flat_hash_map<std::string, SinglePassResult> pass_results_;
+
+  // Aggregate statistics for each cached analysis. Indexed by analysis name.
+  absl::flat_hash_map<std::string, AnalysisCacheStats> analysis_cache_stats_;
 };
 
 // A object to which metadata may be written in each pass invocation. This data
@@ -350,7 +393,30 @@ class CompoundPassBase : public PassBase<IrT, OptionsT, ResultsT> {
   virtual absl::StatusOr<CompoundPassResult> RunNested(
       IrT* ir, const OptionsT& options, ResultsT* results,
       std::string_view top_level_name,
-      absl::Span<const InvariantChecker* const> invariant_checkers) const;
+      absl::Span<const InvariantChecker* const> invariant_checkers) const {
+    return RunPasses(ir, options, results, top_level_name, invariant_checkers,
+                     /*fixed_point_state=*/nullptr);
+  }
+
+  // State carried across the iterations of a fixed point compound pass which
+  // identifies passes that would not change the IR if run again.
+  struct FixedPointState {
+    // Number of pass runs in the fixed point which changed the IR.
+    int64_t change_count = 0;
+    // For each pass, the value of `change_count` after its last run if that
+    // run did not change the IR. A pass whose entry equals `change_count` is
+    // known to be a no-op and is skipped.
+    std::vector<std::optional<int64_t>> unchanged_at_change_count;
+  };
+
+  // Runs each pass once in order. If `fixed_point_state` is non-null passes
+  // which are known not to change the IR are skipped and the state is
+  // updated.
+  absl::StatusOr<CompoundPassResult> RunPasses(
+      IrT* ir, const OptionsT& options, ResultsT* results,
+      std::string_view top_level_name,
+      absl::Span<const InvariantChecker* const> invariant_checkers,
+      FixedPointState* fixed_point_state) const;
 
   // Dump the IR to a file in the given directory. Name is determined by the
   // various arguments passed in. File names will be lexicographically ordered
@@ -402,12 +468,14 @@ class FixedPointCompoundPassBase
     bool local_changed = true;
     int64_t iteration_count = 0;
     CompoundPassResult aggregate_result;
+    typename CompoundPassBase<IrT, OptionsT, ResultsT>::FixedPointState state;
+    state.unchanged_at_change_count.resize(this->passes_.size());
     while (local_changed) {
       ++iteration_count;
       XLS_ASSIGN_OR_RETURN(
           CompoundPassResult compound_result,
-          (CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
-              ir, options, results, top_level_name, invariant_checkers)),
+          this->RunPasses(ir, options, results, top_level_name,
+                          invariant_checkers, &state),
           _ << "Running pass #" << results->invocations.size() << ": "
             << this->long_name() << " [short: " << this->short_name() << "]");
       local_changed = compound_result.changed();
@@ -423,10 +491,11 @@ class FixedPointCompoundPassBase
 
 template <typename IrT, typename OptionsT, typename ResultsT>
 absl::StatusOr<CompoundPassResult>
-CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
+CompoundPassBase<IrT, OptionsT, ResultsT>::RunPasses(
     IrT* ir, const OptionsT& options, ResultsT* results,
     std::string_view top_level_name,
-    absl::Span<const InvariantChecker* const> invariant_checkers) const {
+    absl::Span<const InvariantChecker* const> invariant_checkers,
+    FixedPointState* fixed_point_state) const {
   VLOG(1) << "Running " << this->short_name() << " compound pass on package "
           << ir->name();
   VLOG(2) << "Start of compound pass " << this->short_name() << ":";
@@ -454,7 +523,8 @@ CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
 
   CompoundPassResult aggregate_result;
   bool changed = false;
-  for (const auto& pass : passes_) {
+  for (int64_t pass_index = 0; pass_index < passes_.size(); ++pass_index) {
+    const std::unique_ptr<Pass>& pass = passes_[pass_index];
     VLOG(1) << absl::StreamFormat("Running %s (%s, #%d) pass on package %s",
                                   pass->long_name(), pass->short_name(),
                                   results->invocations.size(), ir->name());
@@ -479,6 +549,14 @@ CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
       continue;
     }
 
+    if (fixed_point_state != nullptr &&
+        fixed_point_state->unchanged_at_change_count[pass_index] ==
+            fixed_point_state->change_count) {
+      VLOG(1) << "Skipping pass. IR unchanged since its last run.";
+      aggregate_result.AddSkippedPass(pass->short_name());
+      continue;
+    }
+
 #ifdef DEBUG
     // Verify that the IR should change iff Run returns true. This is slow, so
     // do not check it in optimized builds.
@@ -516,6 +594,15 @@ CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
     }
 #endif
     changed = changed || pass_changed;
+    if (fixed_point_state != nullptr) {
+      if (pass_changed) {
+        ++fixed_point_state->change_count;
+        fixed_point_state->unchanged_at_change_count[pass_index] = std::nullopt;
+      } else {
+        fixed_point_state->unchanged_at_change_count[pass_index] =
+            fixed_point_state->change_count;
+      }
+    }
     TransformMetrics pass_metrics = ir->transform_metrics() - before_metrics;
     VLOG(1) << absl::StreamFormat(
         "[elapsed %s] Pass %s %s.", FormatDuration(duration),
@@ -16,6 +16,7 @@
 
 #include <memory>
 #include <optional>
+#include <string_view>
 #include <utility>
 
 #include "gmock/gmock.h"
@@ -26,6 +27,7 @@
 #include "absl/types/span.h"
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/work_stealing_thread_pool.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/function.h"
@@ -38,7 +40,10 @@
 #include "xls/ir/topo_sort.h"
 #include "xls/ir/value.h"
 #include "xls/passes/dce_pass.h"
+#include "xls/passes/optimization_context.h"
 #include "xls/passes/optimization_pass.h"
+#include "xls/passes/pass_metrics.pb.h"
+#include "xls/passes/simulation_oracle.h"
 
 namespace m = ::xls::op_matchers;
 namespace xls {
@@ -120,6 +125,55 @@ class LevelUpPass : public OptimizationFunctionBasePass {
   }
 };
 
+// Replaces invokes of functions which return an all-ones literal with the
+// literal. The result on a function depends on the functions it calls.
+class FoldAllOnesInvokePass : public OptimizationFunctionBasePass {
+ public:
+  FoldAllOnesInvokePass()
+      : OptimizationFunctionBasePass("fold_invoke", "Fold all-ones invokes") {}
+  ~FoldAllOnesInvokePass() override = default;
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const OptimizationPassOptions& options,
+      PassResults* results) const override {
+    bool changed = false;
+    for (Node* n : TopoSort(f)) {
+      if (!n->Is<Invoke>()) {
+        continue;
+      }
+      Node* callee_return = n->As<Invoke>()->to_apply()->return_value();
+      if (!callee_return->Is<Literal>()) {
+        continue;
+      }
+      const Value& value = callee_return->As<Literal>()->value();
+      if (value.IsBits() && value.bits().IsAllOnes()) {
+        changed = true;
+        XLS_RETURN_IF_ERROR(n->ReplaceUsesWithNew<Literal>(value).status());
+      }
+    }
+    return changed;
+  }
+};
+
+// Checks one query per function against a (pretend) simulation which refutes
+// it, as a query engine filtering its queries would.
+class SimulatedQueryPass : public OptimizationFunctionBasePass {
+ public:
+  SimulatedQueryPass()
+      : OptimizationFunctionBasePass("simulated_query", "Simulated query") {}
+  ~SimulatedQueryPass() override = default;
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const OptimizationPassOptions& options,
+      PassResults* results) const override {
+    SimulationFilterStats stats;
+    stats.Record(/*refuted=*/true);
+    return false;
+  }
+};
+
 auto DceInvoke() { return Field(&PassInvocation::pass_name, Eq("dce")); }
 auto LevelUpInvoke() {
   return Field(&PassInvocation::pass_name, Eq("level_up"));
@@ -267,6 +321,127 @@ TEST_F(PassBaseTest, BisectLimitInMiddleOfFixedPoint) {
                   DceInvoke(), LevelUpInvoke(), DceInvoke()));
 }
 
+TEST_F(PassBaseTest, FixedPointSkipsPassesWhenIrIsUnchanged) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  fb.Literal(UBits(0, 2));
+  XLS_ASSERT_OK_AND_ASSIGN(auto* f, fb.Build());
+  OptimizationCompoundPass opt("opt", "opt");
+  {
+    auto fp =
+        std::make_unique<OptimizationFixedPointCompoundPass>("fixed", "fixed");
+    fp->Add<LevelUpPass>();
+    fp->Add<DeadCodeEliminationPass>();
+    fp->Add<DeadCodeEliminationPass>();
+    opt.AddOwned(std::move(fp));
+  }
+  PassResults results;
+  EXPECT_THAT(
+      opt.Run(p.get(),
+              OptimizationPassOptions(PassOptionsBase{.record_metrics = true}),
+              &results),
+      IsOk());
+  EXPECT_THAT(f->return_value(), m::Literal(UBits(3, 2)));
+  // The literal reaches all ones after three sweeps. In the final sweep the
+  // last DCE is skipped because nothing changed since it last ran.
+  EXPECT_THAT(
+      results.invocations,
+      ElementsAre(LevelUpInvoke(), DceInvoke(), DceInvoke(), LevelUpInvoke(),
+                  DceInvoke(), DceInvoke(), LevelUpInvoke(), DceInvoke(),
+                  DceInvoke(), LevelUpInvoke(), DceInvoke()));
+  PipelineMetricsProto metrics = results.aggregate_results.ToProto();
+  EXPECT_EQ(metrics.pass_results().at("dce").run_count(), 7);
+  EXPECT_EQ(metrics.pass_results().at("dce").skipped_count(), 1);
+  EXPECT_EQ(metrics.pass_results().at("level_up").skipped_count(), 0);
+}
+
+TEST_F(PassBaseTest, ContextSkipsUnchangedFunctions) {
+  auto p = CreatePackage();
+  FunctionBuilder fb_f("f", p.get());
+  fb_f.Literal(UBits(0, 2));
+  XLS_ASSERT_OK_AND_ASSIGN(auto* f, fb_f.Build());
+  FunctionBuilder fb_g("g", p.get());
+  fb_g.Literal(UBits(3, 2));
+  XLS_ASSERT_OK_AND_ASSIGN(auto* g, fb_g.Build());
+  OptimizationCompoundPass opt("opt", "opt");
+  {
+    auto fp =
+        std::make_unique<OptimizationFixedPointCompoundPass>("fixed", "fixed");
+    fp->Add<LevelUpPass>();
+    fp->Add<DeadCodeEliminationPass>();
+    opt.AddOwned(std::move(fp));
+  }
+  OptimizationContext context;
+  OptimizationPassOptions options(PassOptionsBase{.record_metrics = true});
+  options.context = &context;
+  PassResults results;
+  EXPECT_THAT(opt.Run(p.get(), options, &results), IsOk());
+  EXPECT_THAT(f->return_value(), m::Literal(UBits(3, 2)));
+  EXPECT_THAT(g->return_value(), m::Literal(UBits(3, 2)));
+  // `g` is never changed so after the first sweep both passes skip it in each
+  // of the three remaining sweeps.
+  EXPECT_EQ(results.invocations.size(), 8);
+  PipelineMetricsProto metrics = results.aggregate_results.ToProto();
+  EXPECT_EQ(metrics.pass_results().at("level_up").skipped_function_count(), 3);
+  EXPECT_EQ(metrics.pass_results().at("dce").skipped_function_count(), 3);
+}
+
+TEST_F(PassBaseTest, SimulatedQueriesAreRecordedPerPass) {
+  auto p = CreatePackage();
+  for (std::string_view name : {"f", "g", "h"}) {
+    FunctionBuilder fb(name, p.get());
+    fb.Param("x", p->GetBitsType(2));
+    XLS_ASSERT_OK(fb.Build().status());
+  }
+  OptimizationCompoundPass opt("opt", "opt");
+  opt.Add<SimulatedQueryPass>();
+  opt.Add<DeadCodeEliminationPass>();
+  OptimizationPassOptions options(PassOptionsBase{.record_metrics = true});
+  PassResults results;
+  EXPECT_THAT(opt.Run(p.get(), options, &results), IsOk());
+
+  // The functions are independent so they are transformed concurrently.
+  WorkStealingThreadPool thread_pool(/*thread_count=*/2);
+  options.thread_pool = &thread_pool;
+  EXPECT_THAT(opt.Run(p.get(), options, &results), IsOk());
+
+  PipelineMetricsProto metrics = results.aggregate_results.ToProto();
+  EXPECT_EQ(
+      metrics.pass_results().at("simulated_query").simulated_query_count(), 6);
+  EXPECT_EQ(
+      metrics.pass_results().at("simulated_query").simulation_refuted_count(),
+      6);
+  EXPECT_EQ(metrics.pass_results().at("dce").simulated_query_count(), 0);
+}
+
+TEST_F(PassBaseTest, ContextRerunsCallersOfChangedFunctions) {
+  auto p = CreatePackage();
+  FunctionBuilder fb_g("g", p.get());
+  fb_g.Literal(UBits(0, 2));
+  XLS_ASSERT_OK_AND_ASSIGN(auto* g, fb_g.Build());
+  FunctionBuilder fb_f("f", p.get());
+  fb_f.Invoke({}, g);
+  XLS_ASSERT_OK_AND_ASSIGN(auto* f, fb_f.Build());
+  OptimizationCompoundPass opt("opt", "opt");
+  {
+    auto fp =
+        std::make_unique<OptimizationFixedPointCompoundPass>("fixed", "fixed");
+    fp->Add<FoldAllOnesInvokePass>();
+    fp->Add<LevelUpPass>();
+    fp->Add<DeadCodeEliminationPass>();
+    opt.AddOwned(std::move(fp));
+  }
+  OptimizationContext context;
+  OptimizationPassOptions options;
+  options.context = &context;
+  PassResults results;
+  EXPECT_THAT(opt.Run(p.get(), options, &results), IsOk());
+  EXPECT_THAT(g->return_value(), m::Literal(UBits(3, 2)));
+  // `f` itself only changes once `g` returns all ones. Each change to `g`
+  // must cause the folding pass to run on `f` again.
+  EXPECT_THAT(f->return_value(), m::Literal(UBits(3, 2)));
+}
+
 TEST_F(PassBaseTest, BisectLimitZero) {
   auto p = CreatePackage();
   FunctionBuilder fb(TestName(), p.get());
@@ -61,6 +61,7 @@
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
 #include "xls/passes/query_engine.h"
+#include "xls/passes/simulation_oracle.h"
 #include "xls/passes/stateless_query_engine.h"
 #include "xls/passes/token_provenance_analysis.h"
 #include "xls/passes/union_query_engine.h"
@@ -1995,8 +1996,16 @@ absl::StatusOr<bool> ProcInliningPass::RunInternal(
 
   XLS_RETURN_IF_ERROR(query_engine.Populate(container_proc).status());
 
-  for (ProcThread& proc_thread : proc_threads) {
-    XLS_RETURN_IF_ERROR(proc_thread.MaybeSaveReceivedData(query_engine));
+  {
+    SimulationStatsScope simulation_stats;
+    for (ProcThread& proc_thread : proc_threads) {
+      XLS_RETURN_IF_ERROR(proc_thread.MaybeSaveReceivedData(query_engine));
+    }
+    if (options.record_metrics && simulation_stats.stats().query_count > 0) {
+      results->aggregate_results.AddSimulatedQueries(
+          short_name(), simulation_stats.stats().query_count,
+          simulation_stats.stats().refuted_count);
+    }
   }
 
   // Add the inlined (and top) proc state and activation bits.
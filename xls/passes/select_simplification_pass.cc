@@ -64,13 +64,12 @@
 #include "xls/ir/value.h"
 #include "xls/ir/value_utils.h"
 #include "xls/passes/bit_provenance_analysis.h"
+#include "xls/passes/optimization_context.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
 #include "xls/passes/query_engine.h"
-#include "xls/passes/range_query_engine.h"
 #include "xls/passes/stateless_query_engine.h"
-#include "xls/passes/ternary_query_engine.h"
 #include "xls/passes/union_query_engine.h"
 
 namespace xls {
@@ -2207,9 +2206,11 @@ absl::StatusOr<bool> SelectSimplificationPassBase::RunOnFunctionBaseInternal(
     PassResults* results) const {
   std::vector<std::unique_ptr<QueryEngine>> query_engines;
   query_engines.push_back(std::make_unique<StatelessQueryEngine>());
-  query_engines.push_back(std::make_unique<TernaryQueryEngine>());
+  query_engines.push_back(
+      MakeQueryEngine(options.context, QueryEngineKind::kTernary));
   if (range_analysis_) {
-    query_engines.push_back(std::make_unique<RangeQueryEngine>());
+    query_engines.push_back(
+        MakeQueryEngine(options.context, QueryEngineKind::kRange));
   }
   VLOG(2) << "Range analysis is " << std::boolalpha << range_analysis_;
 
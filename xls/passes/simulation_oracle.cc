@@ -0,0 +1,320 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/simulation_oracle.h"
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/log.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/abstract_evaluator.h"
+#include "xls/ir/abstract_node_evaluator.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/topo_sort.h"
+#include "xls/passes/query_engine.h"
+
+namespace xls {
+namespace {
+
+// The innermost simulation stats scope active on the current thread.
+thread_local SimulationStatsScope* active_stats_scope = nullptr;
+
+// An abstract evaluator whose elements hold the values of a single bit under
+// 64 input vectors.
+class WordEvaluator : public AbstractEvaluator<uint64_t, WordEvaluator> {
+ public:
+  uint64_t One() const { return ~uint64_t{0}; }
+  uint64_t Zero() const { return 0; }
+  uint64_t Not(uint64_t input) const { return ~input; }
+  uint64_t And(uint64_t a, uint64_t b) const { return a & b; }
+  uint64_t Or(uint64_t a, uint64_t b) const { return a | b; }
+  uint64_t If(uint64_t sel, uint64_t consequent, uint64_t alternate) const {
+    return (sel & consequent) | (~sel & alternate);
+  }
+};
+
+// Returns true if `node` is an input of the function whose values are chosen
+// by the simulation rather than computed.
+bool IsSimulationInput(Node* node) {
+  if (node->OpIn({Op::kParam, Op::kStateRead, Op::kReceive, Op::kInputPort,
+                  Op::kRegisterRead, Op::kInstantiationOutput})) {
+    return true;
+  }
+  return node->Is<TupleIndex>() && IsSimulationInput(node->operand(0));
+}
+
+// Returns the values of an input bit under the 64 vectors of word `word`.
+uint64_t InputWord(int64_t word, std::mt19937_64& rng) {
+  switch (word % 3) {
+    case 0: {
+      uint64_t value = rng();
+      if (word == 0) {
+        // Vector 0 is all zeros and vector 1 is all ones.
+        value = (value & ~uint64_t{0b11}) | uint64_t{0b10};
+      }
+      return value;
+    }
+    case 1: {
+      uint64_t a = rng();
+      uint64_t b = rng();
+      return a & b & rng();
+    }
+    default: {
+      uint64_t a = rng();
+      uint64_t b = rng();
+      return a | b | rng();
+    }
+  }
+}
+
+}  // namespace
+
+bool SimulationFilterStats::Record(bool refuted) {
+  ++query_count;
+  refuted_count += refuted ? 1 : 0;
+  if (active_stats_scope != nullptr) {
+    ++active_stats_scope->stats_.query_count;
+    active_stats_scope->stats_.refuted_count += refuted ? 1 : 0;
+  }
+  return refuted;
+}
+
+SimulationFilterStats& SimulationFilterStats::operator+=(
+    const SimulationFilterStats& other) {
+  query_count += other.query_count;
+  refuted_count += other.refuted_count;
+  return *this;
+}
+
+SimulationStatsScope::SimulationStatsScope()
+    : enclosing_(active_stats_scope) {
+  active_stats_scope = this;
+}
+
+SimulationStatsScope::~SimulationStatsScope() {
+  active_stats_scope = enclosing_;
+}
+
+/* static */ absl::StatusOr<SimulationOracle> SimulationOracle::Run(
+    FunctionBase* f, int64_t word_count, uint64_t seed) {
+  XLS_RET_CHECK_GT(word_count, 0);
+  SimulationOracle oracle(word_count);
+  std::mt19937_64 rng(seed);
+  WordEvaluator evaluator;
+  std::vector<Node*> topo_sort = TopoSort(f);
+
+  // The values of each simulated node under the vectors of the current word.
+  absl::flat_hash_map<Node*, WordEvaluator::Vector> values;
+  for (int64_t word = 0; word < word_count; ++word) {
+    values.clear();
+    for (Node* node : topo_sort) {
+      if (!node->GetType()->IsBits() ||
+          (word > 0 && !oracle.HasSignature(node))) {
+        continue;
+      }
+      WordEvaluator::Vector value;
+      if (IsSimulationInput(node)) {
+        value.resize(node->BitCountOrDie());
+        for (uint64_t& bit : value) {
+          bit = InputWord(word, rng);
+        }
+      } else {
+        std::vector<WordEvaluator::Vector> operand_values;
+        operand_values.reserve(node->operand_count());
+        for (Node* operand : node->operands()) {
+          auto it = values.find(operand);
+          if (it == values.end()) {
+            break;
+          }
+          operand_values.push_back(it->second);
+        }
+        if (operand_values.size() != node->operand_count()) {
+          continue;
+        }
+        bool supported = true;
+        XLS_ASSIGN_OR_RETURN(
+            value,
+            AbstractEvaluate(node, operand_values, &evaluator,
+                             [&](Node* n) {
+                               supported = false;
+                               return WordEvaluator::Vector(
+                                   n->BitCountOrDie(), evaluator.Zero());
+                             }));
+        if (!supported) {
+          VLOG(3) << "Node is not simulated: " << node->ToString();
+          continue;
+        }
+      }
+      std::vector<uint64_t>& signature = oracle.signatures_[node];
+      signature.resize(value.size() * word_count);
+      for (int64_t i = 0; i < value.size(); ++i) {
+        signature[i * word_count + word] = value[i];
+      }
+      values[node] = std::move(value);
+    }
+  }
+  VLOG(2) << absl::StreamFormat("Simulated %d of %d nodes of %s on %d vectors",
+                                oracle.signatures_.size(), f->node_count(),
+                                f->name(), oracle.vector_count());
+  return oracle;
+}
+
+std::optional<absl::Span<const uint64_t>> SimulationOracle::GetSignature(
+    Node* node, int64_t bit_index) const {
+  auto it = signatures_.find(node);
+  if (it == signatures_.end()) {
+    return std::nullopt;
+  }
+  return absl::MakeConstSpan(it->second)
+      .subspan(bit_index * word_count_, word_count_);
+}
+
+std::optional<absl::Span<const uint64_t>> SimulationOracle::GetSignature(
+    const TreeBitLocation& location) const {
+  if (!location.tree_index().empty()) {
+    return std::nullopt;
+  }
+  return GetSignature(location.node(), location.bit_index());
+}
+
+std::optional<std::vector<uint64_t>> SimulationOracle::VectorsWhere(
+    absl::Span<const std::pair<TreeBitLocation, bool>> bit_values) const {
+  std::vector<uint64_t> mask(word_count_, ~uint64_t{0});
+  for (const auto& [location, value] : bit_values) {
+    std::optional<absl::Span<const uint64_t>> signature =
+        GetSignature(location);
+    if (!signature.has_value()) {
+      return std::nullopt;
+    }
+    for (int64_t w = 0; w < word_count_; ++w) {
+      mask[w] &= value ? (*signature)[w] : ~(*signature)[w];
+    }
+  }
+  return mask;
+}
+
+bool SimulationOracle::RefutesKnownValue(const TreeBitLocation& bit,
+                                         bool value) const {
+  std::optional<absl::Span<const uint64_t>> signature = GetSignature(bit);
+  if (!signature.has_value()) {
+    return false;
+  }
+  uint64_t expected = value ? ~uint64_t{0} : 0;
+  return absl::c_any_of(*signature,
+                        [&](uint64_t word) { return word != expected; });
+}
+
+bool SimulationOracle::RefutesImplies(absl::Span<const uint64_t> condition,
+                                      const TreeBitLocation& bit,
+                                      bool value) const {
+  std::optional<absl::Span<const uint64_t>> signature = GetSignature(bit);
+  if (!signature.has_value()) {
+    return false;
+  }
+  for (int64_t w = 0; w < word_count_; ++w) {
+    uint64_t violations = value ? ~(*signature)[w] : (*signature)[w];
+    if ((condition[w] & violations) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SimulationOracle::RefutesImplies(const TreeBitLocation& a,
+                                      const TreeBitLocation& b) const {
+  std::optional<absl::Span<const uint64_t>> a_signature = GetSignature(a);
+  if (!a_signature.has_value()) {
+    return false;
+  }
+  return RefutesImplies(*a_signature, b, /*value=*/true);
+}
+
+bool SimulationOracle::RefutesKnownEquals(const TreeBitLocation& a,
+                                          const TreeBitLocation& b) const {
+  std::optional<absl::Span<const uint64_t>> a_signature = GetSignature(a);
+  std::optional<absl::Span<const uint64_t>> b_signature = GetSignature(b);
+  if (!a_signature.has_value() || !b_signature.has_value()) {
+    return false;
+  }
+  for (int64_t w = 0; w < word_count_; ++w) {
+    if (((*a_signature)[w] ^ (*b_signature)[w]) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SimulationOracle::RefutesKnownNotEquals(const TreeBitLocation& a,
+                                             const TreeBitLocation& b) const {
+  std::optional<absl::Span<const uint64_t>> a_signature = GetSignature(a);
+  std::optional<absl::Span<const uint64_t>> b_signature = GetSignature(b);
+  if (!a_signature.has_value() || !b_signature.has_value()) {
+    return false;
+  }
+  for (int64_t w = 0; w < word_count_; ++w) {
+    if (~((*a_signature)[w] ^ (*b_signature)[w]) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SimulationOracle::RefutesAtMostOneTrue(
+    absl::Span<const TreeBitLocation> bits) const {
+  std::vector<uint64_t> any_set(word_count_, 0);
+  for (const TreeBitLocation& bit : bits) {
+    std::optional<absl::Span<const uint64_t>> signature = GetSignature(bit);
+    if (!signature.has_value()) {
+      continue;
+    }
+    for (int64_t w = 0; w < word_count_; ++w) {
+      if ((any_set[w] & (*signature)[w]) != 0) {
+        return true;
+      }
+      any_set[w] |= (*signature)[w];
+    }
+  }
+  return false;
+}
+
+bool SimulationOracle::RefutesAtLeastOneTrue(
+    absl::Span<const TreeBitLocation> bits) const {
+  std::vector<uint64_t> any_set(word_count_, 0);
+  for (const TreeBitLocation& bit : bits) {
+    std::optional<absl::Span<const uint64_t>> signature = GetSignature(bit);
+    if (!signature.has_value()) {
+      return false;
+    }
+    for (int64_t w = 0; w < word_count_; ++w) {
+      any_set[w] |= (*signature)[w];
+    }
+  }
+  return absl::c_any_of(any_set,
+                        [](uint64_t word) { return word != ~uint64_t{0}; });
+}
+
+}  // namespace xls
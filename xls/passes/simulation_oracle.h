@@ -0,0 +1,153 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_SIMULATION_ORACLE_H_
+#define XLS_PASSES_SIMULATION_ORACLE_H_
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/passes/query_engine.h"
+
+namespace xls {
+
+// Counts of the symbolic queries which were checked against a simulation and
+// of those the simulation refuted, i.e., which were answered without a
+// symbolic (BDD or SAT) computation.
+struct SimulationFilterStats {
+  int64_t query_count = 0;
+  int64_t refuted_count = 0;
+
+  // Records a query in these counts and in the innermost SimulationStatsScope
+  // active on the current thread, if any. Returns `refuted`.
+  bool Record(bool refuted);
+
+  SimulationFilterStats& operator+=(const SimulationFilterStats& other);
+};
+
+// Collects the SimulationFilterStats of all queries recorded on the current
+// thread while the scope is alive, whichever engine or pass made them. This
+// lets the pass framework attribute the queries to the pass being run. Scopes
+// may be nested, in which case a query is only recorded in the innermost one.
+class SimulationStatsScope {
+ public:
+  SimulationStatsScope();
+  ~SimulationStatsScope();
+
+  SimulationStatsScope(const SimulationStatsScope&) = delete;
+  SimulationStatsScope& operator=(const SimulationStatsScope&) = delete;
+
+  const SimulationFilterStats& stats() const { return stats_; }
+
+  // Adds counts collected elsewhere, e.g., in a scope on another thread.
+  void Add(const SimulationFilterStats& stats) { stats_ += stats; }
+
+ private:
+  friend struct SimulationFilterStats;
+
+  SimulationStatsScope* enclosing_;
+  SimulationFilterStats stats_;
+};
+
+// Evaluates a function on many input vectors at once and records the value of
+// every bit of every simulated node under each vector. The values of a bit are
+// packed into its "signature": bit `i` of word `w` is the value of the bit
+// under input vector `64 * w + i`. Each logical operation of the evaluation
+// processes 64 vectors.
+//
+// Signatures cheaply disprove properties. If the simulated values violate a
+// property then so does the function and a symbolic query for the property
+// can be skipped. A node is only simulated if its value is exactly determined
+// by the inputs of the function (parameters, state and received data), so a
+// refutation holds for any engine which treats these inputs as unconstrained.
+// Nodes which are not bits-typed or depend on operations the simulation does
+// not support (e.g., invokes or array operations) have no signature.
+class SimulationOracle {
+ public:
+  // The default number of 64-bit words in each signature.
+  static constexpr int64_t kDefaultWordCount = 4;
+
+  // Simulates `f` on `64 * word_count` input vectors. The first two vectors
+  // set every input to all zeros and all ones respectively. The remaining
+  // vectors are pseudo-random with bit densities alternating between 1/2, 1/8
+  // and 7/8 per word. The generator is seeded with `seed` so the signatures
+  // are deterministic.
+  static absl::StatusOr<SimulationOracle> Run(
+      FunctionBase* f, int64_t word_count = kDefaultWordCount,
+      uint64_t seed = 0);
+
+  int64_t word_count() const { return word_count_; }
+  int64_t vector_count() const { return 64 * word_count_; }
+
+  // Returns true if the given node was simulated.
+  bool HasSignature(Node* node) const { return signatures_.contains(node); }
+
+  // Returns the signature of the given bit or std::nullopt if its node was not
+  // simulated.
+  std::optional<absl::Span<const uint64_t>> GetSignature(
+      Node* node, int64_t bit_index) const;
+  std::optional<absl::Span<const uint64_t>> GetSignature(
+      const TreeBitLocation& location) const;
+
+  // Returns the mask of the vectors under which each of the given bits has the
+  // paired value. Returns std::nullopt if any of the bits was not simulated.
+  std::optional<std::vector<uint64_t>> VectorsWhere(
+      absl::Span<const std::pair<TreeBitLocation, bool>> bit_values) const;
+
+  // The following methods return true if the simulation shows that the
+  // respective property does not hold. A return value of false means nothing:
+  // the property was not violated by the simulated vectors or a bit involved
+  // was not simulated.
+
+  // The bit always has the given value.
+  bool RefutesKnownValue(const TreeBitLocation& bit, bool value) const;
+  // Whenever the vectors in the mask `condition` are selected, the bit has the
+  // given value.
+  bool RefutesImplies(absl::Span<const uint64_t> condition,
+                      const TreeBitLocation& bit, bool value) const;
+  // `a` implies `b`.
+  bool RefutesImplies(const TreeBitLocation& a,
+                      const TreeBitLocation& b) const;
+  // The bits are always equal.
+  bool RefutesKnownEquals(const TreeBitLocation& a,
+                          const TreeBitLocation& b) const;
+  // The bits are never equal.
+  bool RefutesKnownNotEquals(const TreeBitLocation& a,
+                             const TreeBitLocation& b) const;
+  // At most one of the bits is set. Bits which were not simulated are ignored
+  // as two simulated bits which are set at once suffice to refute this.
+  bool RefutesAtMostOneTrue(absl::Span<const TreeBitLocation> bits) const;
+  // At least one of the bits is set.
+  bool RefutesAtLeastOneTrue(absl::Span<const TreeBitLocation> bits) const;
+
+ private:
+  explicit SimulationOracle(int64_t word_count) : word_count_(word_count) {}
+
+  int64_t word_count_;
+
+  // The signatures of the simulated nodes. The signature of bit `i` occupies
+  // the words `[i * word_count_, (i + 1) * word_count_)`.
+  absl::flat_hash_map<Node*, std::vector<uint64_t>> signatures_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_SIMULATION_ORACLE_H_
@@ -0,0 +1,203 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/simulation_oracle.h"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/types/span.h"
+#include "xls/common/status/matchers.h"
+#include "xls/interpreter/ir_interpreter.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/package.h"
+#include "xls/ir/topo_sort.h"
+#include "xls/ir/value.h"
+#include "xls/passes/query_engine.h"
+
+namespace xls {
+namespace {
+
+class SimulationOracleTest : public IrTestBase {
+ protected:
+  // Returns the value of `node` under the given simulated vector.
+  static Value SimulatedValue(const SimulationOracle& oracle, Node* node,
+                              int64_t vector) {
+    absl::InlinedVector<bool, 64> bits;
+    for (int64_t i = 0; i < node->BitCountOrDie(); ++i) {
+      absl::Span<const uint64_t> signature = *oracle.GetSignature(node, i);
+      bits.push_back(((signature[vector / 64] >> (vector % 64)) & 1) == 1);
+    }
+    return Value(Bits(bits));
+  }
+};
+
+TEST_F(SimulationOracleTest, SignaturesMatchInterpreter) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue s = fb.Param("s", p->GetBitsType(2));
+  BValue sum = fb.Add(x, y);
+  BValue product = fb.UMul(x, y);
+  BValue quotient = fb.UDiv(x, y);
+  BValue shifted = fb.Shll(x, s);
+  BValue lt = fb.ULt(x, y);
+  BValue selected =
+      fb.Select(s, {sum, product, quotient}, /*default_value=*/shifted);
+  BValue neg = fb.Negate(selected);
+  fb.Concat({lt, fb.BitSlice(neg, /*start=*/2, /*width=*/5),
+             fb.Xor(neg, fb.SignExtend(s, 8))});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(SimulationOracle oracle,
+                           SimulationOracle::Run(f, /*word_count=*/2));
+  EXPECT_EQ(oracle.vector_count(), 128);
+  for (int64_t vector = 0; vector < oracle.vector_count(); ++vector) {
+    absl::flat_hash_map<Node*, Value> values;
+    for (Node* node : TopoSort(f)) {
+      ASSERT_TRUE(oracle.HasSignature(node)) << node->ToString();
+      if (node->Is<Param>()) {
+        values[node] = SimulatedValue(oracle, node, vector);
+        continue;
+      }
+      std::vector<Value> operand_values;
+      for (Node* operand : node->operands()) {
+        operand_values.push_back(values.at(operand));
+      }
+      XLS_ASSERT_OK_AND_ASSIGN(values[node],
+                               InterpretNode(node, operand_values));
+      EXPECT_EQ(values.at(node), SimulatedValue(oracle, node, vector))
+          << node->ToString() << " under vector " << vector;
+    }
+  }
+}
+
+TEST_F(SimulationOracleTest, FirstVectorsAreAllZerosAndAllOnes) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(16));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(SimulationOracle oracle, SimulationOracle::Run(f));
+  EXPECT_EQ(SimulatedValue(oracle, x.node(), 0), Value(UBits(0, 16)));
+  EXPECT_EQ(SimulatedValue(oracle, x.node(), 1), Value(Bits::AllOnes(16)));
+}
+
+TEST_F(SimulationOracleTest, Deterministic) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(16));
+  fb.Add(x, fb.Literal(UBits(3, 16)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(SimulationOracle a, SimulationOracle::Run(f));
+  XLS_ASSERT_OK_AND_ASSIGN(SimulationOracle b, SimulationOracle::Run(f));
+  XLS_ASSERT_OK_AND_ASSIGN(SimulationOracle c,
+                           SimulationOracle::Run(f, /*word_count=*/4,
+                                                 /*seed=*/42));
+  for (int64_t i = 0; i < 16; ++i) {
+    EXPECT_THAT(*a.GetSignature(f->return_value(), i),
+                testing::ElementsAreArray(
+                    *b.GetSignature(f->return_value(), i)));
+  }
+  EXPECT_NE(SimulatedValue(a, x.node(), 100), SimulatedValue(c, x.node(), 100));
+}
+
+TEST_F(SimulationOracleTest, Refutations) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(2));
+  BValue x0 = fb.BitSlice(x, 0, 1);
+  BValue x1 = fb.BitSlice(x, 1, 1);
+  BValue both = fb.And(x0, x1);
+  BValue only_x0 = fb.And(x0, fb.Not(x1));
+  BValue never = fb.And(x0, fb.Not(x0));
+  BValue not_x0 = fb.Not(x0);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(SimulationOracle oracle, SimulationOracle::Run(f));
+  auto bit = [](BValue v) { return TreeBitLocation(v.node(), 0); };
+
+  EXPECT_TRUE(oracle.RefutesKnownValue(bit(both), false));
+  EXPECT_TRUE(oracle.RefutesKnownValue(bit(both), true));
+  EXPECT_FALSE(oracle.RefutesKnownValue(bit(never), false));
+  EXPECT_TRUE(oracle.RefutesKnownValue(bit(never), true));
+
+  EXPECT_FALSE(oracle.RefutesAtMostOneTrue({bit(both), bit(only_x0)}));
+  EXPECT_TRUE(oracle.RefutesAtMostOneTrue({bit(x0), bit(x1)}));
+  EXPECT_FALSE(oracle.RefutesAtLeastOneTrue({bit(x0), bit(not_x0)}));
+  EXPECT_TRUE(oracle.RefutesAtLeastOneTrue({bit(x0), bit(x1)}));
+
+  EXPECT_FALSE(oracle.RefutesImplies(bit(both), bit(x0)));
+  EXPECT_TRUE(oracle.RefutesImplies(bit(x0), bit(both)));
+  EXPECT_FALSE(oracle.RefutesKnownEquals(bit(x0), bit(x0)));
+  EXPECT_TRUE(oracle.RefutesKnownEquals(bit(x0), bit(x1)));
+  EXPECT_FALSE(oracle.RefutesKnownNotEquals(bit(x0), bit(not_x0)));
+  EXPECT_TRUE(oracle.RefutesKnownNotEquals(bit(x0), bit(x1)));
+
+  // Whenever x1 is set, `only_x0` is zero.
+  std::optional<std::vector<uint64_t>> x1_set =
+      oracle.VectorsWhere({{bit(x1), true}});
+  ASSERT_TRUE(x1_set.has_value());
+  EXPECT_FALSE(oracle.RefutesImplies(*x1_set, bit(only_x0), false));
+  EXPECT_TRUE(oracle.RefutesImplies(*x1_set, bit(x0), false));
+}
+
+TEST_F(SimulationOracleTest, UnsupportedNodesHaveNoSignature) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue a = fb.Param("a", p->GetArrayType(4, p->GetBitsType(8)));
+  BValue i = fb.Param("i", p->GetBitsType(2));
+  BValue element = fb.ArrayIndex(a, {i});
+  BValue sum = fb.Add(element, fb.ZeroExtend(i, 8));
+  BValue t = fb.Param("t", p->GetTupleType({p->GetBitsType(3)}));
+  BValue t0 = fb.TupleIndex(t, 0);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(SimulationOracle oracle, SimulationOracle::Run(f));
+  EXPECT_FALSE(oracle.HasSignature(a.node()));
+  EXPECT_FALSE(oracle.HasSignature(element.node()));
+  EXPECT_FALSE(oracle.HasSignature(sum.node()));
+  EXPECT_TRUE(oracle.HasSignature(i.node()));
+  EXPECT_TRUE(oracle.HasSignature(t0.node()));
+  EXPECT_FALSE(oracle.RefutesKnownValue(TreeBitLocation(sum.node(), 0), true));
+}
+
+TEST_F(SimulationOracleTest, StatsScopesCollectQueriesOnThread) {
+  SimulationFilterStats engine_stats;
+  engine_stats.Record(/*refuted=*/true);
+  SimulationStatsScope outer;
+  engine_stats.Record(/*refuted=*/false);
+  {
+    SimulationStatsScope inner;
+    engine_stats.Record(/*refuted=*/true);
+    engine_stats.Record(/*refuted=*/true);
+    EXPECT_EQ(inner.stats().query_count, 2);
+    EXPECT_EQ(inner.stats().refuted_count, 2);
+  }
+  engine_stats.Record(/*refuted=*/false);
+  EXPECT_EQ(outer.stats().query_count, 2);
+  EXPECT_EQ(outer.stats().refuted_count, 0);
+  EXPECT_EQ(engine_stats.query_count, 5);
+  EXPECT_EQ(engine_stats.refuted_count, 3);
+}
+
+}  // namespace
+}  // namespace xls
@@ -0,0 +1,254 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/ternary_evaluator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+#include "xls/data_structures/inline_bitmap.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/ternary.h"
+
+namespace xls {
+namespace {
+
+// Returns the mask of the bits of word `wordno` which are within a vector of
+// `bit_count` bits.
+uint64_t WordMask(int64_t bit_count, int64_t wordno) {
+  int64_t bits = std::min<int64_t>(64, bit_count - wordno * 64);
+  return bits == 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+}
+
+// Computes a one-hot select with the same result as the bit-serial
+// AbstractEvaluator::OneHotSelect. Each bit is tracked as a pair of masks of
+// the bits known to be one and known to be zero. `selector` is any sequence of
+// TernaryValues.
+template <typename SelectorT>
+PackedTernaryVector OneHotSelectWords(const SelectorT& selector,
+                                      TernaryEvaluator::SpanOfSpan cases,
+                                      bool selector_can_be_zero) {
+  CHECK_EQ(selector.size(), cases.size());
+  CHECK_GT(selector.size(), 0);
+  int64_t width = cases.front().size();
+  InlineBitmap known(width);
+  InlineBitmap value(width);
+  for (int64_t w = 0; w < known.word_count(); ++w) {
+    uint64_t mask = WordMask(width, w);
+    uint64_t one = 0;
+    uint64_t zero = mask;
+    // The AND of the cases whose selector bit may be one.
+    uint64_t and_one = mask;
+    uint64_t and_zero = 0;
+    for (int64_t i = 0; i < selector.size(); ++i) {
+      if (selector[i] == TernaryValue::kKnownZero) {
+        continue;
+      }
+      const PackedTernaryVector& c = cases[i].vector();
+      uint64_t c_one = c.value().GetWord(w);
+      uint64_t c_zero = c.known().GetWord(w) & ~c_one & mask;
+      if (selector[i] == TernaryValue::kKnownOne) {
+        one |= c_one;
+      }
+      zero &= c_zero;
+      and_one &= c_one;
+      and_zero |= c_zero;
+    }
+    if (!selector_can_be_zero) {
+      one |= and_one;
+      zero &= and_zero;
+    }
+    known.SetWord(w, one | zero);
+    value.SetWord(w, one);
+  }
+  return PackedTernaryVector(std::move(known), std::move(value));
+}
+
+}  // namespace
+
+TernaryEvaluator::Vector TernaryEvaluator::ZeroExtend(Span input,
+                                                      int64_t new_width) {
+  CHECK_GE(new_width, input.size());
+  return Vector(input.vector().known().WithSize(new_width, /*new_data=*/true),
+                input.vector().value().WithSize(new_width));
+}
+
+TernaryEvaluator::Vector TernaryEvaluator::SignExtend(Span input,
+                                                      int64_t new_width) {
+  CHECK_GE(input.size(), 1);
+  CHECK_GE(new_width, input.size());
+  TernaryValue msb = input.back();
+  return Vector(input.vector().known().WithSize(
+                    new_width, /*new_data=*/msb != TernaryValue::kUnknown),
+                input.vector().value().WithSize(
+                    new_width, /*new_data=*/msb == TernaryValue::kKnownOne));
+}
+
+TernaryEvaluator::Vector TernaryEvaluator::Reverse(Span input) {
+  Vector result(input.size());
+  for (int64_t i = 0; i < input.size(); ++i) {
+    result.Set(input.size() - i - 1, input[i]);
+  }
+  return result;
+}
+
+TernaryEvaluator::Element TernaryEvaluator::Equals(Span a, Span b) {
+  CHECK_EQ(a.size(), b.size());
+  const PackedTernaryVector& x = a.vector();
+  const PackedTernaryVector& y = b.vector();
+  bool fully_known = true;
+  for (int64_t w = 0; w < x.word_count(); ++w) {
+    uint64_t both_known = x.known().GetWord(w) & y.known().GetWord(w);
+    if ((both_known & (x.value().GetWord(w) ^ y.value().GetWord(w))) != 0) {
+      return TernaryValue::kKnownZero;
+    }
+    fully_known = fully_known && both_known == WordMask(x.bit_count(), w);
+  }
+  return fully_known ? TernaryValue::kKnownOne : TernaryValue::kUnknown;
+}
+
+TernaryEvaluator::Element TernaryEvaluator::ULessThan(Span a, Span b) {
+  CHECK_EQ(a.size(), b.size());
+  Element result = Zero();
+  Element upper_bits_lte = One();
+  for (int64_t i = a.size() - 1; i >= 0; --i) {
+    result = Or(result, And(upper_bits_lte, And(Not(a[i]), b[i])));
+    upper_bits_lte = And(upper_bits_lte, Or(Not(a[i]), b[i]));
+  }
+  return result;
+}
+
+TernaryEvaluator::Element TernaryEvaluator::SLessThan(Span a, Span b) {
+  Element a_neg_b_non_neg = And(a.back(), Not(b.back()));
+  Element a_non_neg_b_neg = And(Not(a.back()), b.back());
+  return Or(a_neg_b_non_neg, And(Not(a_non_neg_b_neg), ULessThan(a, b)));
+}
+
+TernaryEvaluator::Vector TernaryEvaluator::AndReduce(Span a) {
+  const PackedTernaryVector& v = a.vector();
+  for (int64_t w = 0; w < v.word_count(); ++w) {
+    if ((v.known().GetWord(w) & ~v.value().GetWord(w)) != 0) {
+      return Vector{TernaryValue::kKnownZero};
+    }
+  }
+  return Vector{v.IsKnownOne() ? TernaryValue::kKnownOne
+                               : TernaryValue::kUnknown};
+}
+
+TernaryEvaluator::Vector TernaryEvaluator::OrReduce(Span a) {
+  const PackedTernaryVector& v = a.vector();
+  if (!v.value().IsAllZeroes()) {
+    return Vector{TernaryValue::kKnownOne};
+  }
+  return Vector{v.IsFullyKnown() ? TernaryValue::kKnownZero
+                                 : TernaryValue::kUnknown};
+}
+
+TernaryEvaluator::Vector TernaryEvaluator::XorReduce(Span a) {
+  const PackedTernaryVector& v = a.vector();
+  if (!v.IsFullyKnown()) {
+    return Vector{TernaryValue::kUnknown};
+  }
+  int64_t parity = 0;
+  for (int64_t w = 0; w < v.word_count(); ++w) {
+    parity ^= std::popcount(v.value().GetWord(w)) & 1;
+  }
+  return Vector{parity == 1 ? TernaryValue::kKnownOne
+                            : TernaryValue::kKnownZero};
+}
+
+TernaryEvaluator::Vector TernaryEvaluator::Neg(Span x) {
+  if (x.empty()) {
+    return SpanToVec(x);
+  }
+  return Add(BitwiseNot(x), BitsToVector(UBits(1, x.size())));
+}
+
+TernaryEvaluator::Vector TernaryEvaluator::OneHotSelect(
+    Span selector, SpanOfSpan cases, bool selector_can_be_zero) {
+  return OneHotSelectWords(selector, cases, selector_can_be_zero);
+}
+
+TernaryEvaluator::Vector TernaryEvaluator::PrioritySelect(
+    Span selector, SpanOfSpan cases, bool selector_can_be_zero,
+    Span default_value) {
+  CHECK_EQ(selector.size(), cases.size());
+  if (selector.empty()) {
+    // No actual cases. Strange but valid.
+    return SpanToVec(default_value);
+  }
+  int64_t width = default_value.size();
+  for (Span c : cases) {
+    CHECK_EQ(c.size(), width);
+  }
+  int64_t case_count = cases.size();
+  if (!selector_can_be_zero) {
+    default_value = cases.back();
+    --case_count;
+  }
+  InlineBitmap known(width);
+  InlineBitmap value(width);
+  for (int64_t w = 0; w < known.word_count(); ++w) {
+    uint64_t k = default_value.vector().known().GetWord(w);
+    uint64_t v = default_value.vector().value().GetWord(w);
+    for (int64_t i = case_count - 1; i >= 0; --i) {
+      const PackedTernaryVector& c = cases[i].vector();
+      switch (selector[i]) {
+        case TernaryValue::kKnownOne:
+          k = c.known().GetWord(w);
+          v = c.value().GetWord(w);
+          break;
+        case TernaryValue::kKnownZero:
+          break;
+        case TernaryValue::kUnknown:
+          // Only the bits known to be the same in both choices stay known.
+          k &= c.known().GetWord(w) & ~(c.value().GetWord(w) ^ v);
+          v &= k;
+          break;
+      }
+    }
+    known.SetWord(w, k);
+    value.SetWord(w, v);
+  }
+  return Vector(std::move(known), std::move(value));
+}
+
+TernaryEvaluator::Vector TernaryEvaluator::Select(
+    Span selector, SpanOfSpan cases, std::optional<Span> default_value) {
+  // Turn the binary selector into a one-hot selector.
+  std::vector<TernaryValue> one_hot_selector;
+  one_hot_selector.reserve(cases.size() + 1);
+  for (int64_t i = 0; i < cases.size(); ++i) {
+    one_hot_selector.push_back(
+        Equals(selector, BitsToVector(UBits(i, selector.size()))));
+  }
+  if (!default_value.has_value()) {
+    return OneHotSelectWords(one_hot_selector, cases,
+                             /*selector_can_be_zero=*/false);
+  }
+  std::vector<Span> cases_vec(cases.begin(), cases.end());
+  one_hot_selector.push_back(ULessThan(
+      BitsToVector(UBits(cases_vec.size() - 1, selector.size())), selector));
+  cases_vec.push_back(*default_value);
+  return OneHotSelectWords(one_hot_selector, cases_vec,
+                           /*selector_can_be_zero=*/false);
+}
+
+}  // namespace xls
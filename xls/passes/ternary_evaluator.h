@@ -15,14 +15,21 @@
 #ifndef XLS_PASSES_TERNARY_EVALUATOR_H_
 #define XLS_PASSES_TERNARY_EVALUATOR_H_
 
+#include <cstdint>
+#include <optional>
+
+#include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/types/span.h"
 #include "xls/ir/abstract_evaluator.h"
+#include "xls/ir/bits.h"
 #include "xls/ir/ternary.h"
 
 namespace xls {
 
-class TernaryEvaluator
-    : public AbstractEvaluator<TernaryValue, TernaryEvaluator> {
+// Evaluates operations on TernaryVectors one bit at a time.
+class BitSerialTernaryEvaluator
+    : public AbstractEvaluator<TernaryValue, BitSerialTernaryEvaluator> {
  public:
   TernaryValue One() const { return TernaryValue::kKnownOne; }
 
@@ -63,6 +70,153 @@ class TernaryEvaluator
   }
 };
 
+// Evaluates operations on PackedTernaryVectors. It provides the operations of
+// AbstractEvaluator so it can be used with AbstractNodeEvaluator, and produces
+// the same results as BitSerialTernaryEvaluator.
+//
+// The bitwise operations, addition, slicing, extension, reductions,
+// comparisons and selects work on 64 bits at a time. Shifts, multiplication,
+// division, encode, decode and one-hot are quadratic or built from many
+// single-bit decisions; they unpack their operands and are evaluated by
+// BitSerialTernaryEvaluator.
+class TernaryEvaluator {
+ public:
+  using Element = TernaryValue;
+  using Vector = PackedTernaryVector;
+  using Span = PackedTernarySpan;
+  using SpanOfSpan = absl::Span<Span const>;
+
+  Element One() const { return bit_serial_.One(); }
+  Element Zero() const { return bit_serial_.Zero(); }
+  Element Not(const Element& input) const { return bit_serial_.Not(input); }
+  Element And(const Element& a, const Element& b) const {
+    return bit_serial_.And(a, b);
+  }
+  Element Or(const Element& a, const Element& b) const {
+    return bit_serial_.Or(a, b);
+  }
+  Element Xor(const Element& a, const Element& b) const {
+    return bit_serial_.Xor(a, b);
+  }
+  Element If(Element sel, Element consequent, Element alternate) const {
+    return bit_serial_.If(sel, consequent, alternate);
+  }
+
+  Vector SpanToVec(Span s) { return s.vector(); }
+  Vector BitsToVector(const Bits& bits) { return Vector::FromBits(bits); }
+
+  Vector BitwiseNot(Span input) { return ternary_ops::Not(input); }
+  Vector BitwiseAnd(SpanOfSpan inputs) {
+    return NaryOp(inputs, [](const Vector& a, const Vector& b) {
+      return ternary_ops::And(a, b);
+    });
+  }
+  Vector BitwiseOr(SpanOfSpan inputs) {
+    return NaryOp(inputs, [](const Vector& a, const Vector& b) {
+      return ternary_ops::Or(a, b);
+    });
+  }
+  Vector BitwiseXor(SpanOfSpan inputs) {
+    return NaryOp(inputs, [](const Vector& a, const Vector& b) {
+      return ternary_ops::Xor(a, b);
+    });
+  }
+  Vector BitwiseAnd(Span a, Span b) { return ternary_ops::And(a, b); }
+  Vector BitwiseOr(Span a, Span b) { return ternary_ops::Or(a, b); }
+  Vector BitwiseXor(Span a, Span b) { return ternary_ops::Xor(a, b); }
+
+  Vector Gate(const Element& a, Span b) {
+    return ternary_ops::And(Vector(b.size(), a), b);
+  }
+
+  Vector BitSlice(Span input, int64_t start, int64_t width) {
+    return input.vector().Slice(start, width);
+  }
+  Vector Concat(SpanOfSpan inputs) { return ternary_ops::Concat(inputs); }
+  Vector ZeroExtend(Span input, int64_t new_width);
+  Vector SignExtend(Span input, int64_t new_width);
+  Vector Reverse(Span input);
+
+  Element Equals(Span a, Span b);
+  Element ULessThan(Span a, Span b);
+  Element SLessThan(Span a, Span b);
+  Element ULessThanOrEqual(Span a, Span b) { return Not(ULessThan(b, a)); }
+  Element UGreaterThan(Span a, Span b) { return ULessThan(b, a); }
+  Element UGreaterThanOrEqual(Span a, Span b) { return Not(ULessThan(a, b)); }
+
+  Vector AndReduce(Span a);
+  Vector OrReduce(Span a);
+  Vector XorReduce(Span a);
+
+  Vector Add(Span a, Span b) { return ternary_ops::Add(a, b); }
+  Vector Neg(Span x);
+
+  Vector OneHotSelect(Span selector, SpanOfSpan cases,
+                      bool selector_can_be_zero);
+  Vector PrioritySelect(Span selector, SpanOfSpan cases,
+                        bool selector_can_be_zero, Span default_value);
+  Vector Select(Span selector, SpanOfSpan cases,
+                std::optional<Span> default_value = std::nullopt);
+
+  Vector OneHotMsbToLsb(Span input) {
+    return Pack(bit_serial_.OneHotMsbToLsb(Unpack(input)));
+  }
+  Vector OneHotLsbToMsb(Span input) {
+    return Pack(bit_serial_.OneHotLsbToMsb(Unpack(input)));
+  }
+  Vector ShiftRightLogical(Span input, Span amount) {
+    return Pack(bit_serial_.ShiftRightLogical(Unpack(input), Unpack(amount)));
+  }
+  Vector ShiftRightArith(Span input, Span amount) {
+    return Pack(bit_serial_.ShiftRightArith(Unpack(input), Unpack(amount)));
+  }
+  Vector ShiftLeftLogical(Span input, Span amount) {
+    return Pack(bit_serial_.ShiftLeftLogical(Unpack(input), Unpack(amount)));
+  }
+  Vector BitSliceUpdate(Span input, Span start, Span value) {
+    return Pack(bit_serial_.BitSliceUpdate(Unpack(input), Unpack(start),
+                                           Unpack(value)));
+  }
+  Vector Decode(Span input, int64_t result_width) {
+    return Pack(bit_serial_.Decode(Unpack(input), result_width));
+  }
+  Vector Encode(Span input) { return Pack(bit_serial_.Encode(Unpack(input))); }
+  Vector UMul(Span a, Span b) {
+    return Pack(bit_serial_.UMul(Unpack(a), Unpack(b)));
+  }
+  Vector SMul(Span a, Span b) {
+    return Pack(bit_serial_.SMul(Unpack(a), Unpack(b)));
+  }
+  Vector UDiv(Span n, Span d) {
+    return Pack(bit_serial_.UDiv(Unpack(n), Unpack(d)));
+  }
+  Vector UMod(Span n, Span d) {
+    return Pack(bit_serial_.UMod(Unpack(n), Unpack(d)));
+  }
+  Vector SDiv(Span n, Span d) {
+    return Pack(bit_serial_.SDiv(Unpack(n), Unpack(d)));
+  }
+  Vector SMod(Span n, Span d) {
+    return Pack(bit_serial_.SMod(Unpack(n), Unpack(d)));
+  }
+
+ private:
+  static TernaryVector Unpack(Span s) { return s.vector().ToVector(); }
+  static Vector Pack(TernarySpan s) { return Vector::FromSpan(s); }
+
+  template <typename F>
+  static Vector NaryOp(SpanOfSpan inputs, F f) {
+    CHECK_GT(inputs.size(), 0);
+    Vector result = inputs.front().vector();
+    for (Span input : inputs.subspan(1)) {
+      result = f(result, input);
+    }
+    return result;
+  }
+
+  BitSerialTernaryEvaluator bit_serial_;
+};
+
 }  // namespace xls
 
 #endif  // XLS_PASSES_TERNARY_EVALUATOR_H_
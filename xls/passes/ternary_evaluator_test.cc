@@ -21,12 +21,14 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "benchmark/benchmark.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "xls/common/status/matchers.h"
+#include "xls/ir/abstract_evaluator.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/ternary.h"
@@ -37,27 +39,34 @@ namespace {
 using ::absl_testing::StatusIs;
 using ::testing::ElementsAre;
 
+using Vector = TernaryEvaluator::Vector;
+
 class TernaryLogicTest : public ::testing::Test {
  protected:
   TernaryLogicTest() = default;
 
-  TernaryVector FromString(std::string_view s) {
-    return StringToTernaryVector(s).value();
+  Vector FromString(std::string_view s) {
+    return Vector::FromSpan(StringToTernaryVector(s).value());
   }
 
   // Returns all TernaryVectors of the given width. For example, all
   // TernaryVectors of width 2 are: 0b00, 0b01, 0b0X, 0b10, 0b11, 0b1X, 0bX0,
   // 0bX1, 0bXX.
-  std::vector<TernaryVector> EnumerateTernaryVectors(int64_t width) {
+  std::vector<Vector> EnumerateTernaryVectors(int64_t width) {
     std::vector<TernaryVector> vectors;
     EnumerateTernaryVectorsHelper({}, width, &vectors);
-    return vectors;
+    std::vector<Vector> result;
+    result.reserve(vectors.size());
+    for (const TernaryVector& vector : vectors) {
+      result.push_back(Vector::FromSpan(vector));
+    }
+    return result;
   }
 
   // Returns all Bits objects which match the pattern of the given
   // TernaryVector. For example, TernaryVector 0b1xx0 produces the following
   // Bits values: 0b1000, 0b1010, 0b1100, 0b1110.
-  std::vector<Bits> ExpandToBits(const TernaryVector& vector) {
+  std::vector<Bits> ExpandToBits(const Vector& vector) {
     std::vector<Bits> result;
     ExpandToBitsHelper(vector, Bits(), &result);
     return result;
@@ -69,15 +78,15 @@ class TernaryLogicTest : public ::testing::Test {
   // is zero for all Bits values, the ternary value is TernaryValue::kKnownOne.
   // Otherwise it is TernaryValue::kUnknown. Example: { 0b1000, 0b1100, 0b1001 }
   // => 0b1X0X
-  TernaryVector ReduceFromBits(absl::Span<const Bits> bits_vector) {
+  Vector ReduceFromBits(absl::Span<const Bits> bits_vector) {
     CHECK(!bits_vector.empty());
-    TernaryVector result = evaluator_.BitsToVector(bits_vector.front());
+    Vector result = evaluator_.BitsToVector(bits_vector.front());
     for (const Bits& bits : bits_vector.subspan(1)) {
       CHECK_EQ(bits.bit_count(), result.size());
       for (int64_t i = 0; i < result.size(); ++i) {
         bool same = ((bits.Get(i) && result[i] == TernaryValue::kKnownOne) ||
                      (!bits.Get(i) && result[i] == TernaryValue::kKnownZero));
-        result[i] = same ? result[i] : TernaryValue::kUnknown;
+        result.Set(i, same ? result[i] : TernaryValue::kUnknown);
       }
     }
     return result;
@@ -103,7 +112,7 @@ class TernaryLogicTest : public ::testing::Test {
     }
   }
 
-  void ExpandToBitsHelper(const TernaryVector& vector, const Bits& prefix,
+  void ExpandToBitsHelper(const Vector& vector, const Bits& prefix,
                           std::vector<Bits>* bits) {
     int64_t index = vector.size() - prefix.bit_count() - 1;
     if (index == -1) {
@@ -245,8 +254,8 @@ TEST_F(TernaryLogicTest, Concat) {
 // a '0').
 TEST_F(TernaryLogicTest, ULessThan) {
   // Enumerate all 3-wide ternary inputs.
-  for (const TernaryVector& lhs : EnumerateTernaryVectors(/*width=*/3)) {
-    for (const TernaryVector& rhs : EnumerateTernaryVectors(/*width=*/3)) {
+  for (const Vector& lhs : EnumerateTernaryVectors(/*width=*/3)) {
+    for (const Vector& rhs : EnumerateTernaryVectors(/*width=*/3)) {
       std::vector<Bits> results;
       for (const Bits& lhs_bits : ExpandToBits(lhs)) {
         for (const Bits& rhs_bits : ExpandToBits(rhs)) {
@@ -266,10 +275,9 @@ TEST_F(TernaryLogicTest, ULessThan) {
 }
 
 TEST_F(TernaryLogicTest, BinarySelect) {
-  for (const TernaryVector& selector : EnumerateTernaryVectors(/*width=*/1)) {
-    for (const TernaryVector& on_true : EnumerateTernaryVectors(/*width=*/2)) {
-      for (const TernaryVector& on_false :
-           EnumerateTernaryVectors(/*width=*/2)) {
+  for (const Vector& selector : EnumerateTernaryVectors(/*width=*/1)) {
+    for (const Vector& on_true : EnumerateTernaryVectors(/*width=*/2)) {
+      for (const Vector& on_false : EnumerateTernaryVectors(/*width=*/2)) {
         std::vector<Bits> results;
         for (const Bits& selector_bits : ExpandToBits(selector)) {
           for (const Bits& on_true_bits : ExpandToBits(on_true)) {
@@ -279,8 +287,8 @@ TEST_F(TernaryLogicTest, BinarySelect) {
             }
           }
         }
-        TernaryVector expected = ReduceFromBits(results);
-        TernaryVector actual = evaluator_.Select(selector, {on_false, on_true});
+        Vector expected = ReduceFromBits(results);
+        Vector actual = evaluator_.Select(selector, {on_false, on_true});
         std::string message = absl::StrFormat(
             "Sel(%s, cases=[%s, %s]) => %s", ToString(selector),
             ToString(on_false), ToString(on_true), ToString(expected));
@@ -294,12 +302,11 @@ TEST_F(TernaryLogicTest, BinarySelect) {
 }
 
 TEST_F(TernaryLogicTest, ThreeWaySelectWithDefault) {
-  for (const TernaryVector& selector : EnumerateTernaryVectors(/*width=*/3)) {
-    for (const TernaryVector& case0 : EnumerateTernaryVectors(/*width=*/1)) {
-      for (const TernaryVector& case1 : EnumerateTernaryVectors(/*width=*/1)) {
-        for (const TernaryVector& case2 :
-             EnumerateTernaryVectors(/*width=*/1)) {
-          for (const TernaryVector& default_case :
+  for (const Vector& selector : EnumerateTernaryVectors(/*width=*/3)) {
+    for (const Vector& case0 : EnumerateTernaryVectors(/*width=*/1)) {
+      for (const Vector& case1 : EnumerateTernaryVectors(/*width=*/1)) {
+        for (const Vector& case2 : EnumerateTernaryVectors(/*width=*/1)) {
+          for (const Vector& default_case :
                EnumerateTernaryVectors(/*width=*/1)) {
             std::vector<Bits> results;
             for (const Bits& selector_bits : ExpandToBits(selector)) {
@@ -322,8 +329,8 @@ TEST_F(TernaryLogicTest, ThreeWaySelectWithDefault) {
                 }
               }
             }
-            TernaryVector expected = ReduceFromBits(results);
-            TernaryVector actual = evaluator_.Select(
+            Vector expected = ReduceFromBits(results);
+            Vector actual = evaluator_.Select(
                 selector, {case0, case1, case2}, default_case);
             std::string message = absl::StrFormat(
                 "Sel(%s, cases=[%s, %s, %s], default=%s) => %s",
@@ -343,10 +350,10 @@ TEST_F(TernaryLogicTest, ThreeWaySelectWithDefault) {
 TEST_F(TernaryLogicTest, OneHotSelectSelectorCanBeZero) {
   // Enumerate all ternary inputs for a 3-wide selector with single bit
   // cases.
-  for (const TernaryVector& selector : EnumerateTernaryVectors(/*width=*/3)) {
-    for (const TernaryVector& a : EnumerateTernaryVectors(/*width=*/1)) {
-      for (const TernaryVector& b : EnumerateTernaryVectors(/*width=*/1)) {
-        for (const TernaryVector& c : EnumerateTernaryVectors(/*width=*/1)) {
+  for (const Vector& selector : EnumerateTernaryVectors(/*width=*/3)) {
+    for (const Vector& a : EnumerateTernaryVectors(/*width=*/1)) {
+      for (const Vector& b : EnumerateTernaryVectors(/*width=*/1)) {
+        for (const Vector& c : EnumerateTernaryVectors(/*width=*/1)) {
           std::vector<Bits> results;
           for (const Bits& selector_bits : ExpandToBits(selector)) {
             for (const Bits& a_bits : ExpandToBits(a)) {
@@ -362,8 +369,8 @@ TEST_F(TernaryLogicTest, OneHotSelectSelectorCanBeZero) {
               }
             }
           }
-          TernaryVector expected = ReduceFromBits(results);
-          TernaryVector actual =
+          Vector expected = ReduceFromBits(results);
+          Vector actual =
               evaluator_.OneHotSelect(selector, {a, b, c},
                                       /*selector_can_be_zero=*/true);
           std::string message = absl::StrFormat(
@@ -381,10 +388,10 @@ TEST_F(TernaryLogicTest, OneHotSelectSelectorCanBeZero) {
 
 TEST_F(TernaryLogicTest, OneHotSelectSelectorCannotBeZero) {
   // Enumerate all ternary inputs for a 3-wide selector with single bit cases.
-  for (const TernaryVector& selector : EnumerateTernaryVectors(/*width=*/3)) {
-    for (const TernaryVector& a : EnumerateTernaryVectors(/*width=*/1)) {
-      for (const TernaryVector& b : EnumerateTernaryVectors(/*width=*/1)) {
-        for (const TernaryVector& c : EnumerateTernaryVectors(/*width=*/1)) {
+  for (const Vector& selector : EnumerateTernaryVectors(/*width=*/3)) {
+    for (const Vector& a : EnumerateTernaryVectors(/*width=*/1)) {
+      for (const Vector& b : EnumerateTernaryVectors(/*width=*/1)) {
+        for (const Vector& c : EnumerateTernaryVectors(/*width=*/1)) {
           std::vector<Bits> results;
           for (const Bits& selector_bits : ExpandToBits(selector)) {
             if (selector_bits.IsZero()) {
@@ -405,8 +412,8 @@ TEST_F(TernaryLogicTest, OneHotSelectSelectorCannotBeZero) {
           if (results.empty()) {
             continue;
           }
-          TernaryVector expected = ReduceFromBits(results);
-          TernaryVector actual =
+          Vector expected = ReduceFromBits(results);
+          Vector actual =
               evaluator_.OneHotSelect(selector, {a, b, c},
                                       /*selector_can_be_zero=*/false);
           std::string message = absl::StrFormat(
@@ -425,8 +432,8 @@ TEST_F(TernaryLogicTest, OneHotSelectSelectorCannotBeZero) {
 
 TEST_F(TernaryLogicTest, ShiftRightLogical3wide) {
   // Enumerate all pairs of 3-wide ternary inputs.
-  for (const TernaryVector& input : EnumerateTernaryVectors(/*width=*/3)) {
-    for (const TernaryVector& amount : EnumerateTernaryVectors(/*width=*/3)) {
+  for (const Vector& input : EnumerateTernaryVectors(/*width=*/3)) {
+    for (const Vector& amount : EnumerateTernaryVectors(/*width=*/3)) {
       std::vector<Bits> results;
       for (const Bits& input_bits : ExpandToBits(input)) {
         for (const Bits& amount_bits : ExpandToBits(amount)) {
@@ -434,8 +441,8 @@ TEST_F(TernaryLogicTest, ShiftRightLogical3wide) {
               input_bits, amount_bits.ToUint64().value()));
         }
       }
-      TernaryVector expected = ReduceFromBits(results);
-      TernaryVector actual = evaluator_.ShiftRightLogical(input, amount);
+      Vector expected = ReduceFromBits(results);
+      Vector actual = evaluator_.ShiftRightLogical(input, amount);
       std::string message =
           absl::StrFormat("%s >> %s => %s", ToString(input), ToString(amount),
                           ToString(expected));
@@ -447,8 +454,8 @@ TEST_F(TernaryLogicTest, ShiftRightLogical3wide) {
 
 TEST_F(TernaryLogicTest, ShiftRightLogical4x2) {
   // Enumerate all pairs of 4-wide inputs with a 2-wide shifter.
-  for (const TernaryVector& input : EnumerateTernaryVectors(/*width=*/4)) {
-    for (const TernaryVector& amount : EnumerateTernaryVectors(/*width=*/2)) {
+  for (const Vector& input : EnumerateTernaryVectors(/*width=*/4)) {
+    for (const Vector& amount : EnumerateTernaryVectors(/*width=*/2)) {
       std::vector<Bits> results;
       for (const Bits& input_bits : ExpandToBits(input)) {
         for (const Bits& amount_bits : ExpandToBits(amount)) {
@@ -456,8 +463,8 @@ TEST_F(TernaryLogicTest, ShiftRightLogical4x2) {
               input_bits, amount_bits.ToUint64().value()));
         }
       }
-      TernaryVector expected = ReduceFromBits(results);
-      TernaryVector actual = evaluator_.ShiftRightLogical(input, amount);
+      Vector expected = ReduceFromBits(results);
+      Vector actual = evaluator_.ShiftRightLogical(input, amount);
       std::string message =
           absl::StrFormat("%s >> %s => %s", ToString(input), ToString(amount),
                           ToString(expected));
@@ -469,8 +476,8 @@ TEST_F(TernaryLogicTest, ShiftRightLogical4x2) {
 
 TEST_F(TernaryLogicTest, ShiftRightArith3wide) {
   // Enumerate all pairs of 3-wide ternary inputs.
-  for (const TernaryVector& input : EnumerateTernaryVectors(/*width=*/3)) {
-    for (const TernaryVector& amount : EnumerateTernaryVectors(/*width=*/3)) {
+  for (const Vector& input : EnumerateTernaryVectors(/*width=*/3)) {
+    for (const Vector& amount : EnumerateTernaryVectors(/*width=*/3)) {
       std::vector<Bits> results;
       for (const Bits& input_bits : ExpandToBits(input)) {
         for (const Bits& amount_bits : ExpandToBits(amount)) {
@@ -478,8 +485,8 @@ TEST_F(TernaryLogicTest, ShiftRightArith3wide) {
               input_bits, amount_bits.ToUint64().value()));
         }
       }
-      TernaryVector expected = ReduceFromBits(results);
-      TernaryVector actual = evaluator_.ShiftRightArith(input, amount);
+      Vector expected = ReduceFromBits(results);
+      Vector actual = evaluator_.ShiftRightArith(input, amount);
       std::string message =
           absl::StrFormat("%s >>> %s => %s", ToString(input), ToString(amount),
                           ToString(expected));
@@ -491,8 +498,8 @@ TEST_F(TernaryLogicTest, ShiftRightArith3wide) {
 
 TEST_F(TernaryLogicTest, ShiftRightArith4x2) {
   // Enumerate all pairs of 4-wide inputs with a 2-wide shifter.
-  for (const TernaryVector& input : EnumerateTernaryVectors(/*width=*/4)) {
-    for (const TernaryVector& amount : EnumerateTernaryVectors(/*width=*/2)) {
+  for (const Vector& input : EnumerateTernaryVectors(/*width=*/4)) {
+    for (const Vector& amount : EnumerateTernaryVectors(/*width=*/2)) {
       std::vector<Bits> results;
       for (const Bits& input_bits : ExpandToBits(input)) {
         for (const Bits& amount_bits : ExpandToBits(amount)) {
@@ -500,8 +507,8 @@ TEST_F(TernaryLogicTest, ShiftRightArith4x2) {
               input_bits, amount_bits.ToUint64().value()));
         }
       }
-      TernaryVector expected = ReduceFromBits(results);
-      TernaryVector actual = evaluator_.ShiftRightArith(input, amount);
+      Vector expected = ReduceFromBits(results);
+      Vector actual = evaluator_.ShiftRightArith(input, amount);
       std::string message =
           absl::StrFormat("%s >>> %s => %s", ToString(input), ToString(amount),
                           ToString(expected));
@@ -513,8 +520,8 @@ TEST_F(TernaryLogicTest, ShiftRightArith4x2) {
 
 TEST_F(TernaryLogicTest, ShiftLeftLogical3wide) {
   // Enumerate all pairs of 3-wide ternary inputs.
-  for (const TernaryVector& input : EnumerateTernaryVectors(/*width=*/3)) {
-    for (const TernaryVector& amount : EnumerateTernaryVectors(/*width=*/3)) {
+  for (const Vector& input : EnumerateTernaryVectors(/*width=*/3)) {
+    for (const Vector& amount : EnumerateTernaryVectors(/*width=*/3)) {
       std::vector<Bits> results;
       for (const Bits& input_bits : ExpandToBits(input)) {
         for (const Bits& amount_bits : ExpandToBits(amount)) {
@@ -522,8 +529,8 @@ TEST_F(TernaryLogicTest, ShiftLeftLogical3wide) {
               input_bits, amount_bits.ToUint64().value()));
         }
       }
-      TernaryVector expected = ReduceFromBits(results);
-      TernaryVector actual = evaluator_.ShiftLeftLogical(input, amount);
+      Vector expected = ReduceFromBits(results);
+      Vector actual = evaluator_.ShiftLeftLogical(input, amount);
       std::string message =
           absl::StrFormat("%s << %s => %s", ToString(input), ToString(amount),
                           ToString(expected));
@@ -535,8 +542,8 @@ TEST_F(TernaryLogicTest, ShiftLeftLogical3wide) {
 
 TEST_F(TernaryLogicTest, ShiftLeftLogical4x2) {
   // Enumerate all pairs of 4-wide inputs with a 2-wide shifter.
-  for (const TernaryVector& input : EnumerateTernaryVectors(/*width=*/4)) {
-    for (const TernaryVector& amount : EnumerateTernaryVectors(/*width=*/2)) {
+  for (const Vector& input : EnumerateTernaryVectors(/*width=*/4)) {
+    for (const Vector& amount : EnumerateTernaryVectors(/*width=*/2)) {
       std::vector<Bits> results;
       for (const Bits& input_bits : ExpandToBits(input)) {
         for (const Bits& amount_bits : ExpandToBits(amount)) {
@@ -544,8 +551,8 @@ TEST_F(TernaryLogicTest, ShiftLeftLogical4x2) {
               input_bits, amount_bits.ToUint64().value()));
         }
       }
-      TernaryVector expected = ReduceFromBits(results);
-      TernaryVector actual = evaluator_.ShiftLeftLogical(input, amount);
+      Vector expected = ReduceFromBits(results);
+      Vector actual = evaluator_.ShiftLeftLogical(input, amount);
       std::string message =
           absl::StrFormat("%s << %s => %s", ToString(input), ToString(amount),
                           ToString(expected));
@@ -557,13 +564,13 @@ TEST_F(TernaryLogicTest, ShiftLeftLogical4x2) {
 
 TEST_F(TernaryLogicTest, OneHotLsbToMsb) {
   // Enumerate all pairs of 4-wide ternary inputs.
-  for (const TernaryVector& input : EnumerateTernaryVectors(/*width=*/4)) {
+  for (const Vector& input : EnumerateTernaryVectors(/*width=*/4)) {
     std::vector<Bits> results;
     for (const Bits& input_bits : ExpandToBits(input)) {
       results.push_back(bits_ops::OneHotLsbToMsb(input_bits));
     }
-    TernaryVector expected = ReduceFromBits(results);
-    TernaryVector actual = evaluator_.OneHotLsbToMsb(input);
+    Vector expected = ReduceFromBits(results);
+    Vector actual = evaluator_.OneHotLsbToMsb(input);
     std::string message = absl::StrFormat("OneHotLsbToMsb(%s) => %s",
                                           ToString(input), ToString(expected));
     VLOG(1) << message;
@@ -623,13 +630,13 @@ TEST_F(TernaryLogicTest, Encode) {
 
 TEST_F(TernaryLogicTest, OneHotMsbToLsb) {
   // Enumerate all pairs of 4-wide ternary inputs.
-  for (const TernaryVector& input : EnumerateTernaryVectors(/*width=*/4)) {
+  for (const Vector& input : EnumerateTernaryVectors(/*width=*/4)) {
     std::vector<Bits> results;
     for (const Bits& input_bits : ExpandToBits(input)) {
       results.push_back(bits_ops::OneHotMsbToLsb(input_bits));
     }
-    TernaryVector expected = ReduceFromBits(results);
-    TernaryVector actual = evaluator_.OneHotMsbToLsb(input);
+    Vector expected = ReduceFromBits(results);
+    Vector actual = evaluator_.OneHotMsbToLsb(input);
     std::string message = absl::StrFormat("OneHotMsbToLsb(%s) => %s",
                                           ToString(input), ToString(expected));
     VLOG(1) << message;
@@ -674,5 +681,205 @@ TEST_F(TernaryLogicTest, TestTheTestStuff) {
             FromString("0bX10X"));
 }
 
+// The packed implementations in TernaryEvaluator must agree exactly with the
+// bit-at-a-time implementations in BitSerialTernaryEvaluator.
+TEST_F(TernaryLogicTest, PackedOpsMatchBitSerial) {
+  BitSerialTernaryEvaluator bit_serial;
+  for (const Vector& lhs : EnumerateTernaryVectors(/*width=*/3)) {
+    TernaryVector l = lhs.ToVector();
+    EXPECT_EQ(evaluator_.BitwiseNot(lhs).ToVector(), bit_serial.BitwiseNot(l))
+        << lhs;
+    EXPECT_EQ(evaluator_.Neg(lhs).ToVector(), bit_serial.Neg(l)) << lhs;
+    EXPECT_EQ(evaluator_.AndReduce(lhs).ToVector(), bit_serial.AndReduce(l))
+        << lhs;
+    EXPECT_EQ(evaluator_.OrReduce(lhs).ToVector(), bit_serial.OrReduce(l))
+        << lhs;
+    EXPECT_EQ(evaluator_.XorReduce(lhs).ToVector(), bit_serial.XorReduce(l))
+        << lhs;
+    EXPECT_EQ(evaluator_.ZeroExtend(lhs, 5).ToVector(),
+              bit_serial.ZeroExtend(l, 5))
+        << lhs;
+    EXPECT_EQ(evaluator_.SignExtend(lhs, 5).ToVector(),
+              bit_serial.SignExtend(l, 5))
+        << lhs;
+    EXPECT_EQ(evaluator_.Reverse(lhs).ToVector(), bit_serial.Reverse(l))
+        << lhs;
+    EXPECT_EQ(evaluator_.BitSlice(lhs, 1, 2).ToVector(),
+              bit_serial.BitSlice(l, 1, 2))
+        << lhs;
+    for (const Vector& rhs : EnumerateTernaryVectors(/*width=*/3)) {
+      TernaryVector r = rhs.ToVector();
+      TernaryVector not_r = bit_serial.BitwiseNot(r);
+      Vector not_rhs = evaluator_.BitwiseNot(rhs);
+      std::string message =
+          absl::StrFormat("lhs: %s, rhs: %s", ToString(lhs), ToString(rhs));
+      EXPECT_EQ(evaluator_.BitwiseAnd(lhs, rhs).ToVector(),
+                bit_serial.BitwiseAnd(l, r))
+          << message;
+      EXPECT_EQ(evaluator_.BitwiseOr(lhs, rhs).ToVector(),
+                bit_serial.BitwiseOr(l, r))
+          << message;
+      EXPECT_EQ(evaluator_.BitwiseXor(lhs, rhs).ToVector(),
+                bit_serial.BitwiseXor(l, r))
+          << message;
+      EXPECT_EQ(evaluator_.Add(lhs, rhs).ToVector(), bit_serial.Add(l, r))
+          << message;
+      EXPECT_EQ(evaluator_.Equals(lhs, rhs), bit_serial.Equals(l, r))
+          << message;
+      EXPECT_EQ(evaluator_.ULessThan(lhs, rhs), bit_serial.ULessThan(l, r))
+          << message;
+      EXPECT_EQ(evaluator_.SLessThan(lhs, rhs), bit_serial.SLessThan(l, r))
+          << message;
+      EXPECT_EQ(evaluator_.Concat({lhs, rhs}).ToVector(),
+                bit_serial.Concat({l, r}))
+          << message;
+      EXPECT_EQ(evaluator_.Gate(lhs[0], rhs).ToVector(),
+                bit_serial.Gate(l[0], r))
+          << message;
+      for (bool selector_can_be_zero : {false, true}) {
+        EXPECT_EQ(evaluator_
+                      .OneHotSelect(lhs, {rhs, not_rhs, lhs},
+                                    selector_can_be_zero)
+                      .ToVector(),
+                  bit_serial.OneHotSelect(l, {r, not_r, l},
+                                          selector_can_be_zero))
+            << message;
+        EXPECT_EQ(evaluator_
+                      .PrioritySelect(lhs, {rhs, not_rhs, lhs},
+                                      selector_can_be_zero, not_rhs)
+                      .ToVector(),
+                  bit_serial.PrioritySelect(l, {r, not_r, l},
+                                            selector_can_be_zero, not_r))
+            << message;
+      }
+      EXPECT_EQ(
+          evaluator_.Select(evaluator_.BitSlice(lhs, 0, 1), {rhs, not_rhs})
+              .ToVector(),
+          bit_serial.Select(bit_serial.BitSlice(l, 0, 1), {r, not_r}))
+          << message;
+      EXPECT_EQ(evaluator_.Select(lhs, {rhs, not_rhs, lhs}, not_rhs)
+                    .ToVector(),
+                bit_serial.Select(l, {r, not_r, l}, not_r))
+          << message;
+    }
+  }
+}
+
+// Returns a deterministic mix of known and unknown bits.
+TernaryVector MixedTernaryVector(int64_t width, int64_t seed) {
+  TernaryVector result(width);
+  for (int64_t i = 0; i < width; ++i) {
+    result[i] = static_cast<TernaryValue>((i * 7 + i / 5 + seed) % 3);
+  }
+  return result;
+}
+
+TEST_F(TernaryLogicTest, PackedOpsMatchBitSerialWide) {
+  BitSerialTernaryEvaluator bit_serial;
+  // Widths around the 64-bit word boundaries.
+  for (int64_t width : {63, 64, 65, 128, 130, 1024}) {
+    for (int64_t seed = 0; seed < 3; ++seed) {
+      TernaryVector l = MixedTernaryVector(width, seed);
+      TernaryVector r = MixedTernaryVector(width, seed + 1);
+      // Long runs of known ones exercise carries across words.
+      TernaryVector o(width, TernaryValue::kKnownOne);
+      Vector lhs = Vector::FromSpan(l);
+      Vector rhs = Vector::FromSpan(r);
+      Vector ones = Vector::FromSpan(o);
+      EXPECT_EQ(evaluator_.Add(lhs, rhs).ToVector(), bit_serial.Add(l, r));
+      EXPECT_EQ(evaluator_.Add(lhs, ones).ToVector(), bit_serial.Add(l, o));
+      EXPECT_EQ(evaluator_.Add(ones, evaluator_.BitsToVector(UBits(1, width))),
+                Vector(width, TernaryValue::kKnownZero));
+      EXPECT_EQ(evaluator_.Neg(lhs).ToVector(), bit_serial.Neg(l));
+      EXPECT_EQ(evaluator_.BitwiseAnd({lhs, rhs, ones}).ToVector(),
+                bit_serial.BitwiseAnd({l, r, o}));
+      EXPECT_EQ(evaluator_.BitwiseOr({lhs, rhs, ones}).ToVector(),
+                bit_serial.BitwiseOr({l, r, o}));
+      EXPECT_EQ(evaluator_.BitwiseXor({lhs, rhs, ones}).ToVector(),
+                bit_serial.BitwiseXor({l, r, o}));
+      EXPECT_EQ(evaluator_.BitwiseNot(lhs).ToVector(),
+                bit_serial.BitwiseNot(l));
+      for (const TernaryVector& v : {l, o}) {
+        Vector packed = Vector::FromSpan(v);
+        EXPECT_EQ(evaluator_.AndReduce(packed).ToVector(),
+                  bit_serial.AndReduce(v));
+        EXPECT_EQ(evaluator_.OrReduce(packed).ToVector(),
+                  bit_serial.OrReduce(v));
+        EXPECT_EQ(evaluator_.XorReduce(packed).ToVector(),
+                  bit_serial.XorReduce(v));
+        EXPECT_EQ(evaluator_.Equals(packed, packed), bit_serial.Equals(v, v));
+        EXPECT_EQ(evaluator_.Equals(packed, rhs), bit_serial.Equals(v, r));
+      }
+      EXPECT_EQ(evaluator_.ULessThan(lhs, rhs), bit_serial.ULessThan(l, r));
+      EXPECT_EQ(evaluator_.SLessThan(lhs, rhs), bit_serial.SLessThan(l, r));
+      EXPECT_EQ(evaluator_.ZeroExtend(lhs, width + 70).ToVector(),
+                bit_serial.ZeroExtend(l, width + 70));
+      EXPECT_EQ(evaluator_.SignExtend(lhs, width + 70).ToVector(),
+                bit_serial.SignExtend(l, width + 70));
+      EXPECT_EQ(evaluator_.Reverse(lhs).ToVector(), bit_serial.Reverse(l));
+      EXPECT_EQ(evaluator_.BitSlice(lhs, 1, width - 2).ToVector(),
+                bit_serial.BitSlice(l, 1, width - 2));
+      EXPECT_EQ(evaluator_.BitSlice(lhs, width / 2, width - width / 2)
+                    .ToVector(),
+                bit_serial.BitSlice(l, width / 2, width - width / 2));
+      EXPECT_EQ(evaluator_.Concat({lhs, rhs, ones}).ToVector(),
+                bit_serial.Concat({l, r, o}));
+      EXPECT_EQ(evaluator_.Concat({evaluator_.BitSlice(lhs, 0, 3), rhs})
+                    .ToVector(),
+                bit_serial.Concat({bit_serial.BitSlice(l, 0, 3), r}));
+      Vector selector = evaluator_.BitSlice(rhs, 0, 3);
+      TernaryVector s = bit_serial.BitSlice(r, 0, 3);
+      EXPECT_EQ(
+          evaluator_.OneHotSelect(selector, {lhs, rhs, ones}, false).ToVector(),
+          bit_serial.OneHotSelect(s, {l, r, o}, false));
+      EXPECT_EQ(evaluator_.PrioritySelect(selector, {lhs, rhs, ones}, true, lhs)
+                    .ToVector(),
+                bit_serial.PrioritySelect(s, {l, r, o}, true, l));
+      EXPECT_EQ(evaluator_.Select(selector, {lhs, rhs, ones}, lhs).ToVector(),
+                bit_serial.Select(s, {l, r, o}, l));
+    }
+  }
+}
+
+void BM_TernaryAdd(benchmark::State& state) {
+  TernaryEvaluator evaluator;
+  Vector lhs = Vector::FromSpan(MixedTernaryVector(state.range(0), 0));
+  Vector rhs = Vector::FromSpan(MixedTernaryVector(state.range(0), 1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(evaluator.Add(lhs, rhs));
+  }
+}
+BENCHMARK(BM_TernaryAdd)->Range(8, 1024);
+
+void BM_TernaryAddBitSerial(benchmark::State& state) {
+  BitSerialTernaryEvaluator evaluator;
+  TernaryVector lhs = MixedTernaryVector(state.range(0), 0);
+  TernaryVector rhs = MixedTernaryVector(state.range(0), 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(evaluator.Add(lhs, rhs));
+  }
+}
+BENCHMARK(BM_TernaryAddBitSerial)->Range(8, 1024);
+
+void BM_TernaryAnd(benchmark::State& state) {
+  TernaryEvaluator evaluator;
+  Vector lhs = Vector::FromSpan(MixedTernaryVector(state.range(0), 0));
+  Vector rhs = Vector::FromSpan(MixedTernaryVector(state.range(0), 1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(evaluator.BitwiseAnd(lhs, rhs));
+  }
+}
+BENCHMARK(BM_TernaryAnd)->Range(8, 1024);
+
+void BM_TernaryAndBitSerial(benchmark::State& state) {
+  BitSerialTernaryEvaluator evaluator;
+  TernaryVector lhs = MixedTernaryVector(state.range(0), 0);
+  TernaryVector rhs = MixedTernaryVector(state.range(0), 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(evaluator.BitwiseAnd(lhs, rhs));
+  }
+}
+BENCHMARK(BM_TernaryAndBitSerial)->Range(8, 1024);
+
 }  // namespace
 }  // namespace xls
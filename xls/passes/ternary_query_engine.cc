@@ -24,6 +24,7 @@
 
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -37,8 +38,9 @@
 #include "xls/ir/nodes.h"
 #include "xls/ir/op.h"
 #include "xls/ir/ternary.h"
-#include "xls/ir/topo_sort.h"
 #include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/ir/value_utils.h"
 #include "xls/passes/query_engine.h"
 #include "xls/passes/ternary_evaluator.h"
 
@@ -144,17 +146,17 @@ bool IsExpensiveToEvaluate(
   if (needs_index_scan) {
     int64_t unknown_index_bits;
     if (node->Is<ArraySlice>()) {
-      unknown_index_bits =
-          absl::c_count(known_bits.at(node->As<ArraySlice>()->start()).Get({}),
-                        TernaryValue::kUnknown);
+      const PackedTernaryVector& start =
+          known_bits.at(node->As<ArraySlice>()->start()).Get({});
+      unknown_index_bits = start.bit_count() - start.NumberOfKnownBits();
     } else {
       auto indices = node->Is<ArrayIndex>()
                          ? node->As<ArrayIndex>()->indices()
                          : node->As<ArrayUpdate>()->indices();
       unknown_index_bits =
           absl::c_accumulate(indices, 0, [&](int64_t acc, Node* n) {
-            return acc + absl::c_count(known_bits.at(n).Get({}),
-                                       TernaryValue::kUnknown);
+            const PackedTernaryVector& index = known_bits.at(n).Get({});
+            return acc + index.bit_count() - index.NumberOfKnownBits();
           });
     }
     return unknown_index_bits >= kIndexBitLimit;
@@ -170,7 +172,7 @@ class TernaryNodeEvaluator : public AbstractNodeEvaluator<TernaryEvaluator> {
   using CompoundValueView = LeafTypeTreeView<TernaryEvaluator::Vector>;
   using AbstractNodeEvaluator<TernaryEvaluator>::AbstractNodeEvaluator;
 
-  absl::Status SetGivenValue(Node* n, LeafTypeTree<TernaryVector> v) {
+  absl::Status SetGivenValue(Node* n, CompoundValue v) {
     return SetValue(n, std::move(v));
   }
 
@@ -234,7 +236,9 @@ class TernaryNodeEvaluator : public AbstractNodeEvaluator<TernaryEvaluator> {
     XLS_ASSIGN_OR_RETURN(auto update_value,
                          GetCompoundValue(update->update_value()));
     CompoundValue result(update->GetType(), array.elements());
-    if (absl::c_all_of(indices, ternary_ops::IsFullyKnown)) {
+    if (absl::c_all_of(indices, [](TernaryEvaluator::Span index) {
+          return ternary_ops::IsFullyKnown(index);
+        })) {
       // Update location is exactly known. We know exactly what that location
       // will be after this.
       std::vector<int64_t> singleton_index;
@@ -277,11 +281,12 @@ class TernaryNodeEvaluator : public AbstractNodeEvaluator<TernaryEvaluator> {
       // it usually will happen quickly so spend a bit of time to check this.
       if (absl::c_all_of(result.elements(),
                          [](const TernaryEvaluator::Vector& elem) {
-                           return absl::c_all_of(elem, ternary_ops::IsUnknown);
+                           return elem.AllUnknown();
                          })) {
         return result;
       }
-      leaf_type_tree::SimpleUpdateFrom<TernaryVector, TernaryVector>(
+      leaf_type_tree::SimpleUpdateFrom<PackedTernaryVector,
+                                       PackedTernaryVector>(
           result.AsMutableView(), possibility, [](auto& lhs, const auto& rhs) {
             ternary_ops::UpdateWithIntersection(lhs, rhs);
           });
@@ -322,11 +327,17 @@ absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::PopulateWithGivens(
     FunctionBase* f, const TernaryDataProvider& givens) {
   TernaryEvaluator evaluator;
   TernaryNodeEvaluator ternary_visitor(evaluator);
-  for (Node* n : TopoSort(f)) {
+  // The engine is repopulated after every change by many passes. The
+  // incremental order avoids a full TopoSort when only a few nodes changed.
+  for (Node* n : f->IncrementalTopoSort()) {
     std::optional<LeafTypeTree<TernaryVector>> given =
         givens.GetKnownTernary(n);
     if (given) {
-      XLS_RETURN_IF_ERROR(ternary_visitor.SetGivenValue(n, *std::move(given)));
+      XLS_RETURN_IF_ERROR(ternary_visitor.SetGivenValue(
+          n, leaf_type_tree::Map<PackedTernaryVector, TernaryVector>(
+                 given->AsView(), [](const TernaryVector& v) {
+                   return PackedTernaryVector::FromSpan(v);
+                 })));
       continue;
     }
     if (IsExpensiveToEvaluate(n, ternary_visitor.values())) {
@@ -336,16 +347,17 @@ absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::PopulateWithGivens(
     XLS_RETURN_IF_ERROR(n->VisitSingleNode(&ternary_visitor));
   }
 
-  absl::flat_hash_map<Node*, LeafTypeTree<TernaryVector>> new_values =
+  absl::flat_hash_map<Node*, LeafTypeTree<PackedTernaryVector>> new_values =
       std::move(ternary_visitor).values();
   ReachedFixpoint rf = ReachedFixpoint::Unchanged;
   for (Node* node : f->nodes()) {
     CHECK(new_values.contains(node));
     if (values_.contains(node) &&
         values_[node].type() == new_values[node].type()) {
-      leaf_type_tree::SimpleUpdateFrom<TernaryVector, TernaryVector>(
+      leaf_type_tree::SimpleUpdateFrom<PackedTernaryVector,
+                                       PackedTernaryVector>(
           values_[node].AsMutableView(), new_values[node].AsView(),
-          [&rf](TernaryVector& lhs, const TernaryVector& rhs) {
+          [&rf](PackedTernaryVector& lhs, const PackedTernaryVector& rhs) {
             if (lhs != rhs) {
               rf = ReachedFixpoint::Changed;
             }
@@ -358,11 +370,155 @@ absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::PopulateWithGivens(
   return rf;
 }
 
+absl::Status TernaryQueryEngine::UpdateNodes(FunctionBase* f,
+                                             absl::Span<Node* const> changed,
+                                             absl::Span<Node* const> removed) {
+  for (Node* node : removed) {
+    values_.erase(node);
+  }
+  // Collect the forward cone of the changed nodes along with the number of
+  // distinct operands of each cone node which are themselves in the cone.
+  absl::flat_hash_map<Node*, int64_t> pending_operands;
+  std::vector<Node*> worklist(changed.begin(), changed.end());
+  while (!worklist.empty()) {
+    Node* node = worklist.back();
+    worklist.pop_back();
+    if (pending_operands.contains(node)) {
+      continue;
+    }
+    pending_operands[node] = 0;
+    absl::c_copy(node->users(), std::back_inserter(worklist));
+  }
+  if (pending_operands.empty()) {
+    return absl::OkStatus();
+  }
+  std::vector<Node*> ready;
+  for (auto& [node, count] : pending_operands) {
+    // `users()` has no duplicates so each cone node is counted once per
+    // distinct cone operand.
+    for (Node* user : node->users()) {
+      ++pending_operands.at(user);
+    }
+  }
+  for (const auto& [node, count] : pending_operands) {
+    if (count == 0) {
+      ready.push_back(node);
+    }
+  }
+
+  // Visit the cone in topological order. A node is only re-evaluated if it was
+  // changed itself or if the value of one of its operands changed. This stops
+  // the propagation as soon as the values stop changing rather than at the end
+  // of the cone.
+  absl::flat_hash_set<Node*> dirty(changed.begin(), changed.end());
+  TernaryEvaluator evaluator;
+  TernaryNodeEvaluator ternary_visitor(evaluator);
+  std::vector<Node*> evaluated;
+  while (!ready.empty()) {
+    Node* n = ready.back();
+    ready.pop_back();
+    for (Node* user : n->users()) {
+      if (--pending_operands.at(user) == 0) {
+        ready.push_back(user);
+      }
+    }
+    if (!dirty.contains(n)) {
+      continue;
+    }
+    // Operands which were not re-evaluated keep their previous values.
+    for (Node* operand : n->operands()) {
+      if (!ternary_visitor.values().contains(operand)) {
+        auto it = values_.find(operand);
+        XLS_RET_CHECK(it != values_.end()) << operand;
+        XLS_RETURN_IF_ERROR(ternary_visitor.SetGivenValue(operand, it->second));
+      }
+    }
+    if (IsExpensiveToEvaluate(n, ternary_visitor.values())) {
+      XLS_RETURN_IF_ERROR(ternary_visitor.DefaultHandler(n));
+    } else {
+      XLS_RETURN_IF_ERROR(n->VisitSingleNode(&ternary_visitor));
+    }
+    evaluated.push_back(n);
+    auto it = values_.find(n);
+    if (it == values_.end() || it->second != ternary_visitor.values().at(n)) {
+      dirty.insert(n->users().begin(), n->users().end());
+    }
+  }
+
+  absl::flat_hash_map<Node*, LeafTypeTree<PackedTernaryVector>> new_values =
+      std::move(ternary_visitor).values();
+  for (Node* node : evaluated) {
+    values_[node] = std::move(new_values.at(node));
+  }
+  return absl::OkStatus();
+}
+
 absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::Populate(FunctionBase* f) {
   NoOpGivens givens;
   return PopulateWithGivens(f, givens);
 }
 
+std::optional<SharedLeafTypeTree<TernaryVector>> TernaryQueryEngine::GetTernary(
+    Node* node) const {
+  return leaf_type_tree::Map<TernaryVector, PackedTernaryVector>(
+             GetTernaryView(node),
+             [](const PackedTernaryVector& v) { return v.ToVector(); })
+      .AsShared();
+}
+
+bool TernaryQueryEngine::IsKnown(const TreeBitLocation& bit) const {
+  if (!IsTracked(bit.node())) {
+    return false;
+  }
+  return values_.at(bit.node()).Get(bit.tree_index()).known().Get(
+      bit.bit_index());
+}
+
+std::optional<bool> TernaryQueryEngine::KnownValue(
+    const TreeBitLocation& bit) const {
+  if (!IsKnown(bit)) {
+    return std::nullopt;
+  }
+  return values_.at(bit.node()).Get(bit.tree_index()).value().Get(
+      bit.bit_index());
+}
+
+std::optional<Value> TernaryQueryEngine::KnownValue(Node* node) const {
+  if (!IsFullyKnown(node)) {
+    return std::nullopt;
+  }
+  LeafTypeTree<Value> value =
+      leaf_type_tree::MapIndex<Value, PackedTernaryVector>(
+          GetTernaryView(node),
+          [](Type* leaf_type, const PackedTernaryVector& v,
+             absl::Span<const int64_t>) -> absl::StatusOr<Value> {
+            CHECK(leaf_type->IsBits());
+            return Value(Bits::FromBitmap(v.value()));
+          })
+          .value();
+  absl::StatusOr<Value> result = LeafTypeTreeToValue(value.AsView());
+  CHECK_OK(result.status());
+  return *result;
+}
+
+bool TernaryQueryEngine::IsAllZeros(Node* node) const {
+  if (!IsTracked(node) || TypeHasToken(node->GetType())) {
+    return false;
+  }
+  return absl::c_all_of(
+      values_.at(node).elements(),
+      [](const PackedTernaryVector& v) { return v.IsKnownZero(); });
+}
+
+bool TernaryQueryEngine::IsAllOnes(Node* node) const {
+  if (!IsTracked(node) || TypeHasToken(node->GetType())) {
+    return false;
+  }
+  return absl::c_all_of(
+      values_.at(node).elements(),
+      [](const PackedTernaryVector& v) { return v.IsKnownOne(); });
+}
+
 bool TernaryQueryEngine::AtMostOneTrue(
     absl::Span<TreeBitLocation const> bits) const {
   int64_t maybe_one_count = 0;
@@ -30,6 +30,7 @@
 #include "xls/ir/node.h"
 #include "xls/ir/ternary.h"
 #include "xls/ir/type.h"
+#include "xls/ir/value.h"
 #include "xls/passes/query_engine.h"
 #include "xls/passes/ternary_evaluator.h"
 
@@ -55,16 +56,28 @@ class TernaryQueryEngine : public QueryEngine {
   absl::StatusOr<ReachedFixpoint> PopulateWithGivens(
       FunctionBase* f, const TernaryDataProvider& givens);
 
+  // Brings a populated engine up to date after the nodes in `changed` were
+  // added to `f` or had their operands changed, and the nodes in `removed`
+  // were removed from `f`. Nodes are re-evaluated in topological order from a
+  // worklist: a node in the forward cone of the changed nodes is only
+  // re-evaluated if one of its operands got a new value, so propagation stops
+  // where the values stop changing. Unlike Populate, the re-evaluated values
+  // replace the previous values rather than being combined with them, so the
+  // result is the same as populating a new engine. Must not be used on engines
+  // populated with givens.
+  absl::Status UpdateNodes(FunctionBase* f, absl::Span<Node* const> changed,
+                           absl::Span<Node* const> removed);
+
   bool IsTracked(Node* node) const override {
     return values_.contains(node) && values_.at(node).type() == node->GetType();
   }
 
+  // Unpacks the stored value. Prefer the bit and node queries below, which
+  // read the packed value directly.
   std::optional<SharedLeafTypeTree<TernaryVector>> GetTernary(
-      Node* node) const override {
-    return GetTernaryView(node).AsShared();
-  }
+      Node* node) const override;
 
-  LeafTypeTreeView<TernaryVector> GetTernaryView(Node* node) const {
+  LeafTypeTreeView<PackedTernaryVector> GetTernaryView(Node* node) const {
     CHECK(IsTracked(node)) << node;
     return values_.at(node).AsView();
   }
@@ -94,14 +107,19 @@ class TernaryQueryEngine : public QueryEngine {
     return std::nullopt;
   }
 
+  bool IsKnown(const TreeBitLocation& bit) const override;
+  std::optional<bool> KnownValue(const TreeBitLocation& bit) const override;
+  std::optional<Value> KnownValue(Node* node) const override;
+  bool IsAllZeros(Node* node) const override;
+  bool IsAllOnes(Node* node) const override;
+
   bool IsFullyKnown(Node* n) const override {
     if (!IsTracked(n) || TypeHasToken(n->GetType())) {
       return false;
     }
-    return absl::c_all_of(values_.at(n).AsView().elements(),
-                          [](const TernaryVector& tv) -> bool {
-                            return ternary_ops::IsFullyKnown(tv);
-                          });
+    return absl::c_all_of(
+        values_.at(n).AsView().elements(),
+        [](const PackedTernaryVector& v) { return v.IsFullyKnown(); });
   }
 
  private:
@@ -51,6 +51,7 @@
 #include "xls/ir/ir_test_base.h"
 #include "xls/ir/lsb_or_msb.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
 #include "xls/ir/package.h"
 #include "xls/ir/source_location.h"
 #include "xls/ir/ternary.h"
@@ -1785,6 +1786,41 @@ TEST_F(TernaryQueryEngineTest, Givens) {
   EXPECT_THAT(query_engine.ToString(v.node()), "0bXX11_11XX");
 }
 
+TEST_F(TernaryQueryEngineTest, UpdateNodesMatchesPopulate) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue mask = fb.Literal(UBits(0xf0, 8));
+  BValue high = fb.And(x, mask);
+  BValue low = fb.And(high, fb.Literal(UBits(0x0f, 8)));
+  BValue sum = fb.Add(low, y);
+  BValue result = fb.Or(sum, high);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(result));
+
+  TernaryQueryEngine query_engine;
+  XLS_ASSERT_OK(query_engine.Populate(f).status());
+  ASSERT_THAT(query_engine.ToString(high.node()), "0bXXXX_0000");
+
+  // Narrowing the mask changes `high` and `result` but `low` stays zero so
+  // the update stops propagating at `sum`.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * new_mask,
+      mask.node()->ReplaceUsesWithNew<Literal>(Value(UBits(0xe0, 8))));
+  XLS_ASSERT_OK(f->RemoveNode(mask.node()));
+  XLS_ASSERT_OK(query_engine.UpdateNodes(f, {new_mask, high.node()},
+                                         {mask.node()}));
+  EXPECT_THAT(query_engine.ToString(high.node()), "0bXXX0_0000");
+  EXPECT_THAT(query_engine.ToString(low.node()), "0b0000_0000");
+
+  TernaryQueryEngine fresh_engine;
+  XLS_ASSERT_OK(fresh_engine.Populate(f).status());
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(query_engine.ToString(node), fresh_engine.ToString(node))
+        << node;
+  }
+}
+
 namespace {
 
 class ArrayCreation : public benchmark_support::strategy::NaryNode {
@@ -1861,6 +1897,78 @@ void BM_ArrayIndexExactTree(benchmark::State& state) {
   }
 }
 
+// A chain of wide and/add nodes in which every masking step fixes the same
+// bits. Returns the first masking node.
+absl::StatusOr<Node*> BuildWideChain(FunctionBuilder& fb, int64_t length) {
+  Type* type = fb.package()->GetBitsType(512);
+  BValue v = fb.Param("x", type);
+  BValue y = fb.Param("y", type);
+  Bits mask = bits_ops::ZeroExtend(Bits::AllOnes(256), 512);
+  std::optional<BValue> first;
+  for (int64_t i = 0; i < length; ++i) {
+    BValue masked = fb.And(v, fb.Literal(mask));
+    if (!first.has_value()) {
+      first = masked;
+    }
+    v = fb.Add(masked, y);
+  }
+  XLS_RETURN_IF_ERROR(fb.Build().status());
+  return first->node();
+}
+
+void BM_PopulateWideChain(benchmark::State& state) {
+  auto p = std::make_unique<VerifiedPackage>("wide_chain");
+  FunctionBuilder fb("wide_chain", p.get());
+  XLS_ASSERT_OK(BuildWideChain(fb, state.range(0)).status());
+  FunctionBase* f = p->functions().front().get();
+  for (auto _ : state) {
+    TernaryQueryEngine tqe;
+    XLS_ASSERT_OK_AND_ASSIGN(auto r, tqe.Populate(f));
+    benchmark::DoNotOptimize(r);
+  }
+}
+
+// Re-evaluates the head of the chain. Its value does not change so the update
+// stops immediately rather than re-evaluating the whole chain.
+void BM_UpdateNodesWideChain(benchmark::State& state) {
+  auto p = std::make_unique<VerifiedPackage>("wide_chain");
+  FunctionBuilder fb("wide_chain", p.get());
+  XLS_ASSERT_OK_AND_ASSIGN(Node * first, BuildWideChain(fb, state.range(0)));
+  FunctionBase* f = p->functions().front().get();
+  TernaryQueryEngine tqe;
+  XLS_ASSERT_OK(tqe.Populate(f).status());
+  for (auto _ : state) {
+    XLS_ASSERT_OK(tqe.UpdateNodes(f, {first}, {}));
+  }
+}
+
+// Repopulates a fresh engine after replacing the head of the chain with a new
+// node, as a pass does between iterations. The order of the chain is repaired
+// incrementally rather than recomputed.
+void BM_PopulateWideChainAfterReplacement(benchmark::State& state) {
+  auto p = std::make_unique<VerifiedPackage>("wide_chain");
+  FunctionBuilder fb("wide_chain", p.get());
+  XLS_ASSERT_OK_AND_ASSIGN(Node * first, BuildWideChain(fb, state.range(0)));
+  FunctionBase* f = p->functions().front().get();
+  for (auto _ : state) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Node * replacement,
+        f->MakeNode<NaryOp>(SourceInfo(),
+                            std::vector<Node*>(first->operands().begin(),
+                                               first->operands().end()),
+                            Op::kAnd));
+    XLS_ASSERT_OK(first->ReplaceUsesWith(replacement));
+    XLS_ASSERT_OK(f->RemoveNode(first));
+    first = replacement;
+    TernaryQueryEngine tqe;
+    XLS_ASSERT_OK_AND_ASSIGN(auto r, tqe.Populate(f));
+    benchmark::DoNotOptimize(r);
+  }
+}
+
+BENCHMARK(BM_PopulateWideChain)->Range(8, 512);
+BENCHMARK(BM_PopulateWideChainAfterReplacement)->Range(8, 512);
+BENCHMARK(BM_UpdateNodesWideChain)->Range(8, 512);
 BENCHMARK(BM_ArrayIndexExactDeep)->DenseRange(2, 14, 1);
 BENCHMARK(BM_ArrayIndexExactShallow)->DenseRange(2, 14, 1);
 BENCHMARK(BM_ArrayIndexExactTree)->DenseRange(2, 12, 1);
@@ -59,6 +59,8 @@
 #include "xls/ir/value.h"
 #include "xls/ir/value_utils.h"
 #include "xls/passes/post_dominator_analysis.h"
+#include "xls/passes/query_engine.h"
+#include "xls/passes/simulation_oracle.h"
 #include "xls/passes/token_provenance_analysis.h"
 #include "xls/scheduling/scheduling_options.h"
 #include "xls/scheduling/scheduling_pass.h"
@@ -224,7 +226,8 @@ absl::StatusOr<NodeRelation> ComputeMergableEffects(FunctionBase* f) {
   };
 
   NodeRelation result;
-  NodeRelation transitive_closure = TransitiveClosure<Node*>(token_dag);
+  XLS_ASSIGN_OR_RETURN(AcyclicTransitiveClosure<Node*> transitive_closure,
+                       AcyclicTransitiveClosure<Node*>::Create(token_dag));
   for (Node* node : ReverseTopoSort(f)) {
     if (node->Is<Send>() || node->Is<Receive>()) {
       absl::flat_hash_set<Node*> subgraph =
@@ -259,10 +262,8 @@ absl::StatusOr<NodeRelation> ComputeMergableEffects(FunctionBase* f) {
   }
   for (Node* x : token_nodes) {
     for (Node* y : token_nodes) {
-      if (!(transitive_closure.contains(x) &&
-            transitive_closure.at(x).contains(y)) &&
-          !(transitive_closure.contains(y) &&
-            transitive_closure.at(y).contains(x))) {
+      if (!transitive_closure.Contains(x, y) &&
+          !transitive_closure.Contains(y, x)) {
         result[x].insert(y);
         result[y].insert(x);
       }
@@ -1163,11 +1164,22 @@ absl::Status ComputeMutualExclusion(Predicates* p, FunctionBase* f,
 
   solvers::z3::ScopedErrorHandler seh(ctx);
 
+  // Simulating the function is much cheaper than a Z3 query and disproves
+  // most properties which do not hold: a predicate which is ever true is not
+  // always false, and two predicates which are true at once are not mutually
+  // exclusive.
+  XLS_ASSIGN_OR_RETURN(SimulationOracle simulation, SimulationOracle::Run(f));
+  SimulationFilterStats simulation_stats;
+
   // Determine for each predicate whether it is always false using Z3.
   // Dead nodes are mutually exclusive with all other nodes, so this can reduce
   // the runtime by doing only a linear amount of Z3 calls to remove
   // quadratically many Z3 calls.
   for (const auto& [node, index] : predicate_nodes) {
+    if (simulation_stats.Record(simulation.RefutesKnownValue(
+            TreeBitLocation(node, 0), /*value=*/false))) {
+      continue;
+    }
     Z3_ast translated = translator->GetTranslation(node);
     // Check whether it's possible for `node` to need to be proven mutually
     // exclusive with some other node in order for channel operations to be
@@ -1238,7 +1250,14 @@ absl::Status ComputeMutualExclusion(Predicates* p, FunctionBase* f,
                   << node_a->GetName() << " and " << node_b->GetName()
                   << " as mutual exclusion is required for compilation.";
       }
-      Z3_lbool satisfiable = RunSolver(ctx, a_and_b);
+      Z3_lbool satisfiable;
+      if (simulation_stats.Record(simulation.RefutesAtMostOneTrue(
+              {TreeBitLocation(node_a, 0), TreeBitLocation(node_b, 0)}))) {
+        // The simulation found inputs for which both predicates are true.
+        satisfiable = Z3_L_TRUE;
+      } else {
+        satisfiable = RunSolver(ctx, a_and_b);
+      }
 
       if (satisfiable == Z3_L_FALSE) {
         known_true += 1;
@@ -1279,6 +1298,9 @@ absl::Status ComputeMutualExclusion(Predicates* p, FunctionBase* f,
   VLOG(3) << "known_false = " << known_false;
   VLOG(3) << "known_true  = " << known_true;
   VLOG(3) << "unknown     = " << unknown;
+  VLOG(2) << absl::StreamFormat(
+      "%s: %d of %d Z3 queries refuted by simulation", f->name(),
+      simulation_stats.refuted_count, simulation_stats.query_count);
 
   XLS_RETURN_IF_ERROR(seh.status());
 
@@ -1306,7 +1328,15 @@ absl::StatusOr<bool> MutualExclusionPass::RunOnFunctionBaseInternal(
 
   Predicates p;
   XLS_RETURN_IF_ERROR(AddSendReceivePredicates(&p, f));
-  XLS_RETURN_IF_ERROR(ComputeMutualExclusion(&p, f, z3_rlimit));
+  {
+    SimulationStatsScope simulation_stats;
+    XLS_RETURN_IF_ERROR(ComputeMutualExclusion(&p, f, z3_rlimit));
+    if (options.record_metrics && simulation_stats.stats().query_count > 0) {
+      results->aggregate_results.AddSimulatedQueries(
+          short_name(), simulation_stats.stats().query_count,
+          simulation_stats.stats().refuted_count);
+    }
+  }
   XLS_ASSIGN_OR_RETURN(std::vector<absl::flat_hash_set<Node*>> merge_classes,
                        ComputeMergeClasses(&p, f, scm));
 
@@ -399,8 +399,13 @@ absl::StatusOr<PipelineSchedule> RunPipelineSchedule(
   std::unique_ptr<SDCScheduler> sdc_scheduler;
   auto initialize_sdc_scheduler = [&]() -> absl::Status {
     if (sdc_scheduler == nullptr) {
-      XLS_ASSIGN_OR_RETURN(sdc_scheduler,
-                           SDCScheduler::Create(f, io_delay_added));
+      XLS_ASSIGN_OR_RETURN(
+          sdc_scheduler,
+          SDCScheduler::Create(
+              f, io_delay_added,
+              options.strategy() == SchedulingStrategy::SDC_MIN_COST_FLOW
+                  ? SDCSolver::kMinCostFlow
+                  : SDCSolver::kLinearProgram));
       XLS_RETURN_IF_ERROR(sdc_scheduler->AddConstraints(options.constraints()));
     }
     return absl::OkStatus();
@@ -498,8 +503,10 @@ absl::StatusOr<PipelineSchedule> RunPipelineSchedule(
   }
 
   ScheduleCycleMap cycle_map;
-  if (options.strategy() == SchedulingStrategy::SDC) {
-    // Enable iterative SDC scheduling when use_fdo is true
+  if (options.strategy() == SchedulingStrategy::SDC ||
+      options.strategy() == SchedulingStrategy::SDC_MIN_COST_FLOW) {
+    // Enable iterative SDC scheduling when use_fdo is true. The iterative SDC
+    // scheduler always uses the LP solver.
     if (options.use_fdo()) {
       if (!options.clock_period_ps().has_value()) {
         return absl::UnimplementedError(
@@ -48,6 +48,12 @@ enum class SchedulingStrategy : int8_t {
   // solving a system of difference constraints.
   SDC,
 
+  // Same as SDC, but solves the system of difference constraints through its
+  // dual minimum-cost flow problem rather than with a general LP solver. The
+  // LP solver is still used for problems with constraints which are not
+  // difference constraints, e.g., when explaining an infeasible schedule.
+  SDC_MIN_COST_FLOW,
+
   // Create a random but sound schedule. This is useful for testing.
   RANDOM,
 };
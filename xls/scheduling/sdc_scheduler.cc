@@ -14,9 +14,11 @@
 
 #include "xls/scheduling/sdc_scheduler.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -24,6 +26,7 @@
 #include <variant>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
@@ -37,6 +40,7 @@
 #include "absl/types/span.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/data_structures/difference_constraints.h"
 #include "xls/estimators/delay_model/delay_estimator.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/function.h"
@@ -58,6 +62,17 @@ namespace {
 using DelayMap = absl::flat_hash_map<Node*, int64_t>;
 namespace math_opt = ::operations_research::math_opt;
 
+// Returns `value` as an integer if it is an integer exactly representable as a
+// double.
+std::optional<int64_t> ToInteger(double value) {
+  constexpr double kMaxExactInteger = 9007199254740992.0;  // 2^53
+  if (!std::isfinite(value) || std::fabs(value) > kMaxExactInteger ||
+      std::round(value) != value) {
+    return std::nullopt;
+  }
+  return static_cast<int64_t>(value);
+}
+
 // A helper function to compute each node's delay by calling the delay estimator
 absl::StatusOr<DelayMap> ComputeNodeDelays(
     FunctionBase* f, const DelayEstimator& delay_estimator) {
@@ -127,63 +142,6 @@ ComputeDistancesToNodes(FunctionBase* f, absl::Span<Node* const> topo_sort,
   return distances_to_node;
 }
 
-// Returns the minimal set of schedule constraints which ensure that no
-// combinational path in the schedule exceeds `clock_period_ps`. The returned
-// map has a (potentially empty) vector entry for each node in `f`. The map
-// value (vector of nodes) for node `x` is the set of nodes which must be
-// scheduled at least one cycle later than `x`. That is, if `return_value[x]` is
-// `S` then:
-//
-//   cycle(i) + 1 >= cycle(x) for i \in S
-//
-// The set of constraints is a minimal set which guarantees that no
-// combinational path violates the clock period timing. Specifically, `(a, b)`
-// is in the set of returned constraints (ie., `return_value[a]` contains `b`)
-// iff critical-path distance from `a` to `b` including the delay of `a` and `b`
-// is greater than `critical_path_period`, but the critical-path distance of the
-// path *not* including the delay of `b` is *less than* `critical_path_period`.
-absl::flat_hash_map<Node*, std::vector<Node*>>
-ComputeCombinationalDelayConstraints(
-    FunctionBase* f, absl::Span<Node* const> topo_sort, int64_t clock_period_ps,
-    const absl::flat_hash_map<Node*, absl::flat_hash_map<Node*, int64_t>>&
-        distances_to_node,
-    const DelayMap& delay_map) {
-  absl::flat_hash_map<Node*, std::vector<Node*>> result;
-  result.reserve(f->node_count());
-  for (Node* a : topo_sort) {
-    result[a];
-  }
-
-  for (Node* node : topo_sort) {
-    const int64_t node_delay = delay_map.at(node);
-
-    // For each ancestor `a`, check whether the critical-path length from `a`'s
-    // start to `node`'s end crosses a `clock_period_ps` boundary due to
-    // `node`'s delay. If so, we need a constraint to ensure that `node` is in a
-    // later stage than `a`.
-    //
-    // NOTE: The order in which we iterate over the ancestors `a` here does not
-    // matter. As long as our iteration over `node` is deterministic, we will
-    // push the same sequence of `node`s into each `result[a]` every time.
-    for (auto [a, distance] : distances_to_node.at(node)) {
-      if (distance > clock_period_ps &&
-          distance - node_delay <= clock_period_ps) {
-        result.at(a).push_back(node);
-      }
-    }
-  }
-
-  if (VLOG_IS_ON(4)) {
-    VLOG(4) << absl::StrFormat("Constraints (clock period: %dps):",
-                               clock_period_ps);
-    for (Node* node : topo_sort) {
-      VLOG(4) << absl::StrFormat("  %s: [%s]", node->GetName(),
-                                 absl::StrJoin(result.at(node), ", "));
-    }
-  }
-  return result;
-}
-
 }  // namespace
 
 SDCSchedulingModel::SDCSchedulingModel(FunctionBase* func,
@@ -196,10 +154,48 @@ SDCSchedulingModel::SDCSchedulingModel(FunctionBase* func,
       last_stage_(model_.AddContinuousVariable(0.0, kMaxStages, "last_stage")),
       cycle_at_sinknode_(model_.AddContinuousVariable(-kInfinity, kInfinity,
                                                       "cycle_at_sinknode")) {
-  // when subclassed for Iterative SDC, delay_map_ and distances_to_node_
-  // are not used.
+  // when subclassed for Iterative SDC, delay_map_ and timing_pairs_ are not
+  // used.
   if (!delay_map_.empty()) {
-    distances_to_node_ = ComputeDistancesToNodes(func_, topo_sort_, delay_map_);
+    absl::flat_hash_map<Node*, absl::flat_hash_map<Node*, int64_t>>
+        distances_to_node =
+            ComputeDistancesToNodes(func_, topo_sort_, delay_map_);
+    absl::flat_hash_map<Node*, int64_t> topo_index;
+    topo_index.reserve(topo_sort_.size());
+    for (int64_t i = 0; i < topo_sort_.size(); ++i) {
+      topo_index[topo_sort_[i]] = i;
+    }
+    for (Node* target : topo_sort_) {
+      const int64_t target_delay = delay_map_.at(target);
+      if (target_delay <= 0) {
+        continue;
+      }
+      for (auto [source, distance] : distances_to_node.at(target)) {
+        timing_pairs_.push_back(
+            TimingPair{.source = source,
+                       .target = target,
+                       .min_clock_period_ps = distance - target_delay,
+                       .max_clock_period_ps = distance});
+      }
+    }
+    // Constraints are added to the model in this order which keeps the model,
+    // and hence the solution, deterministic.
+    absl::c_sort(timing_pairs_, [&](const TimingPair& a, const TimingPair& b) {
+      return std::make_pair(topo_index.at(a.source), topo_index.at(a.target)) <
+             std::make_pair(topo_index.at(b.source), topo_index.at(b.target));
+    });
+    timing_pairs_by_min_period_.resize(timing_pairs_.size());
+    std::iota(timing_pairs_by_min_period_.begin(),
+              timing_pairs_by_min_period_.end(), 0);
+    timing_pairs_by_max_period_ = timing_pairs_by_min_period_;
+    absl::c_sort(timing_pairs_by_min_period_, [&](int64_t a, int64_t b) {
+      return timing_pairs_[a].min_clock_period_ps <
+             timing_pairs_[b].min_clock_period_ps;
+    });
+    absl::c_sort(timing_pairs_by_max_period_, [&](int64_t a, int64_t b) {
+      return timing_pairs_[a].max_clock_period_ps <
+             timing_pairs_[b].max_clock_period_ps;
+    });
   }
 
   for (Node* node : topo_sort_) {
@@ -528,45 +524,254 @@ absl::StatusOr<ScheduleCycleMap> SDCSchedulingModel::ExtractResult(
   return cycle_map;
 }
 
-void SDCSchedulingModel::SetClockPeriod(int64_t clock_period_ps) {
-  absl::flat_hash_map<Node*, std::vector<Node*>> prev_delay_constraints =
-      std::move(delay_constraints_);
-  delay_constraints_ = ComputeCombinationalDelayConstraints(
-      func_, topo_sort_, clock_period_ps, distances_to_node_, delay_map_);
-
-  for (Node* source : topo_sort_) {
-    if (!prev_delay_constraints.empty()) {
-      // Check over all the prior constraints, dropping any that are obsolete.
-      absl::flat_hash_set<Node*> new_targets(
-          delay_constraints_.at(source).begin(),
-          delay_constraints_.at(source).end());
-      for (Node* target : prev_delay_constraints.at(source)) {
-        if (new_targets.contains(target)) {
-          continue;
-        }
+std::optional<SDCSchedulingModel::DifferenceConstraintSolution>
+SDCSchedulingModel::SolveAsDifferenceConstraints() const {
+  // Every variable of the model is a variable of the system, minus an offset
+  // variable for lifetimes: lifetime[node] = last_use[node] - cycle[node].
+  struct SystemTerm {
+    int64_t variable;
+    std::optional<int64_t> offset;
+  };
+  DifferenceConstraintSystem system;
+  const std::vector<math_opt::Variable> variables = model_.SortedVariables();
+  absl::flat_hash_map<math_opt::Variable, SystemTerm> terms;
+  terms.reserve(variables.size());
+  for (const math_opt::Variable& variable : variables) {
+    terms.emplace(variable, SystemTerm{.variable = system.AddVariable()});
+  }
+  for (const auto& [node, lifetime] : lifetime_var_) {
+    terms.at(lifetime).offset = terms.at(cycle_var_.at(node)).variable;
+  }
 
-        // No longer related; remove constraint.
-        auto it = timing_constraint_.find(std::make_pair(source, target));
-        model_.DeleteLinearConstraint(it->second);
-        timing_constraint_.erase(it);
+  // A linear expression over the variables of the system as (variable,
+  // coefficient) pairs.
+  using Expression = std::vector<std::pair<int64_t, int64_t>>;
+  auto append = [&](math_opt::Variable variable, int64_t coefficient,
+                    Expression& expression) {
+    const SystemTerm& term = terms.at(variable);
+    expression.push_back({term.variable, coefficient});
+    if (term.offset.has_value()) {
+      expression.push_back({*term.offset, -coefficient});
+    }
+  };
+  // Adds `lower <= expression <= upper` to the system. Returns false if this
+  // is not a bound on a single variable or on the difference of two.
+  auto add_constraint = [&](Expression& expression, double lower,
+                            double upper) -> bool {
+    absl::c_sort(expression);
+    Expression combined;
+    for (const auto& [variable, coefficient] : expression) {
+      if (!combined.empty() && combined.back().first == variable) {
+        combined.back().second += coefficient;
+      } else {
+        combined.push_back({variable, coefficient});
+      }
+    }
+    std::erase_if(combined, [](const std::pair<int64_t, int64_t>& term) {
+      return term.second == 0;
+    });
+    std::optional<int64_t> lower_limit;
+    std::optional<int64_t> upper_limit;
+    if (lower != -kInfinity) {
+      lower_limit = ToInteger(lower);
+      if (!lower_limit.has_value()) {
+        return false;
+      }
+    }
+    if (upper != kInfinity) {
+      upper_limit = ToInteger(upper);
+      if (!upper_limit.has_value()) {
+        return false;
+      }
+    }
+    if (combined.empty()) {
+      return lower <= 0.0 && upper >= 0.0;
+    }
+    if (combined.size() == 1 && std::abs(combined[0].second) == 1) {
+      const int64_t x = combined[0].first;
+      if (combined[0].second == -1) {
+        std::swap(lower_limit, upper_limit);
+        if (lower_limit.has_value()) {
+          lower_limit = -*lower_limit;
+        }
+        if (upper_limit.has_value()) {
+          upper_limit = -*upper_limit;
+        }
+      }
+      if (lower_limit.has_value()) {
+        system.AddLowerBound(x, *lower_limit);
+      }
+      if (upper_limit.has_value()) {
+        system.AddUpperBound(x, *upper_limit);
+      }
+      return true;
+    }
+    if (combined.size() == 2 && std::abs(combined[0].second) == 1 &&
+        combined[0].second == -combined[1].second) {
+      auto [x, y] = combined[0].second == 1
+                        ? std::make_pair(combined[0].first, combined[1].first)
+                        : std::make_pair(combined[1].first, combined[0].first);
+      if (lower_limit.has_value()) {
+        system.AddDifferenceAtLeast(x, y, *lower_limit);
+      }
+      if (upper_limit.has_value()) {
+        system.AddDifferenceAtMost(x, y, *upper_limit);
+      }
+      return true;
+    }
+    return false;
+  };
+
+  for (const math_opt::Variable& variable : variables) {
+    Expression expression;
+    append(variable, 1, expression);
+    if (!add_constraint(expression, variable.lower_bound(),
+                        variable.upper_bound())) {
+      VLOG(3) << "Bounds of " << variable.name()
+              << " are not a difference constraint";
+      return std::nullopt;
+    }
+  }
+  for (const math_opt::LinearConstraint& constraint :
+       model_.SortedLinearConstraints()) {
+    Expression expression;
+    for (const math_opt::Variable& variable : model_.RowNonzeros(constraint)) {
+      std::optional<int64_t> coefficient =
+          ToInteger(constraint.coefficient(variable));
+      if (!coefficient.has_value()) {
+        return std::nullopt;
       }
+      append(variable, *coefficient, expression);
     }
+    if (!add_constraint(expression, constraint.lower_bound(),
+                        constraint.upper_bound())) {
+      VLOG(3) << "Constraint " << constraint.name()
+              << " is not a difference constraint";
+      return std::nullopt;
+    }
+  }
+  const int64_t sense = model_.is_maximize() ? -1 : 1;
+  for (const math_opt::Variable& variable : variables) {
+    std::optional<int64_t> coefficient =
+        ToInteger(model_.objective_coefficient(variable));
+    if (!coefficient.has_value()) {
+      return std::nullopt;
+    }
+    const SystemTerm& term = terms.at(variable);
+    system.AddToObjective(term.variable, sense * *coefficient);
+    if (term.offset.has_value()) {
+      system.AddToObjective(*term.offset, -sense * *coefficient);
+    }
+  }
 
-    // Add all new constraints, avoiding duplicates for any that already exist.
-    for (Node* target : delay_constraints_.at(source)) {
-      auto key = std::make_pair(source, target);
-      if (timing_constraint_.contains(key)) {
-        continue;
+  DifferenceConstraintSolution solution{.result = system.Solve()};
+  VLOG(3) << absl::StrFormat(
+      "Solved %d difference constraints over %d variables: %s",
+      system.constraint_count(), system.variable_count(),
+      solution.result == DifferenceConstraintSystem::Result::kOptimal
+          ? "optimal"
+          : "no optimal solution");
+  if (solution.result == DifferenceConstraintSystem::Result::kOptimal) {
+    solution.variable_values.reserve(variables.size());
+    for (const math_opt::Variable& variable : variables) {
+      const SystemTerm& term = terms.at(variable);
+      int64_t value = system.value(term.variable);
+      if (term.offset.has_value()) {
+        value -= system.value(*term.offset);
       }
+      solution.variable_values.emplace(variable, static_cast<double>(value));
+    }
+  }
+  return solution;
+}
 
-      // Newly related; add constraint.
-      VLOG(2) << "Setting timing constraint: "
-              << absl::StrFormat("1 ≤ %s - %s", target->GetName(),
-                                 source->GetName());
-      timing_constraint_.emplace(
-          key, DiffAtLeastConstraint(target, source, 1, "timing"));
+void SDCSchedulingModel::SetClockPeriod(int64_t clock_period_ps) {
+  std::vector<int64_t> candidates;
+  if (!clock_period_ps_.has_value()) {
+    candidates.resize(timing_pairs_.size());
+    std::iota(candidates.begin(), candidates.end(), 0);
+  } else {
+    // The constraint of a pair changes iff exactly one of the old and new
+    // clock periods lies in [min_clock_period_ps, max_clock_period_ps), i.e.,
+    // iff one of the bounds lies in (low, high].
+    const int64_t low = std::min(*clock_period_ps_, clock_period_ps);
+    const int64_t high = std::max(*clock_period_ps_, clock_period_ps);
+    auto add_candidates = [&](absl::Span<const int64_t> indices,
+                              int64_t TimingPair::*period) {
+      auto before = [&](int64_t value, int64_t index) {
+        return value < timing_pairs_[index].*period;
+      };
+      auto begin = absl::c_upper_bound(indices, low, before);
+      auto end = std::upper_bound(begin, indices.end(), high, before);
+      candidates.insert(candidates.end(), begin, end);
+    };
+    add_candidates(timing_pairs_by_min_period_,
+                   &TimingPair::min_clock_period_ps);
+    add_candidates(timing_pairs_by_max_period_,
+                   &TimingPair::max_clock_period_ps);
+    absl::c_sort(candidates);
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+  }
+
+  for (int64_t index : candidates) {
+    const TimingPair& pair = timing_pairs_[index];
+    bool needed = pair.min_clock_period_ps <= clock_period_ps &&
+                  clock_period_ps < pair.max_clock_period_ps;
+    UpdateTimingConstraint(pair.source, pair.target, needed);
+  }
+  clock_period_ps_ = clock_period_ps;
+  VLOG(4) << absl::StrFormat(
+      "%d timing constraints (clock period: %dps), %d pairs checked",
+      timing_constraint_.size(), clock_period_ps, candidates.size());
+}
+
+void SDCSchedulingModel::SetTimingConstraints(
+    absl::Span<const std::pair<Node*, Node*>> constraints) {
+  absl::flat_hash_set<std::pair<Node*, Node*>> needed(constraints.begin(),
+                                                      constraints.end());
+  std::vector<std::pair<Node*, Node*>> obsolete;
+  for (const auto& [key, constraint] : timing_constraint_) {
+    if (!needed.contains(key)) {
+      obsolete.push_back(key);
     }
   }
+  for (const auto& [source, target] : obsolete) {
+    UpdateTimingConstraint(source, target, /*needed=*/false);
+  }
+  for (const auto& [source, target] : constraints) {
+    UpdateTimingConstraint(source, target, /*needed=*/true);
+  }
+  clock_period_ps_ = std::nullopt;
+}
+
+void SDCSchedulingModel::UpdateTimingConstraint(Node* source, Node* target,
+                                                bool needed) {
+  auto key = std::make_pair(source, target);
+  auto it = timing_constraint_.find(key);
+  if (needed == (it != timing_constraint_.end())) {
+    return;
+  }
+  if (needed) {
+    VLOG(2) << "Setting timing constraint: "
+            << absl::StrFormat("1 ≤ %s - %s", target->GetName(),
+                               source->GetName());
+    timing_constraint_.emplace(
+        key, DiffAtLeastConstraint(target, source, 1, "timing"));
+  } else {
+    model_.DeleteLinearConstraint(it->second);
+    timing_constraint_.erase(it);
+  }
+}
+
+absl::flat_hash_set<std::pair<Node*, Node*>>
+SDCSchedulingModel::GetTimingConstraints() const {
+  absl::flat_hash_set<std::pair<Node*, Node*>> result;
+  result.reserve(timing_constraint_.size());
+  for (const auto& [key, constraint] : timing_constraint_) {
+    result.insert(key);
+  }
+  return result;
 }
 
 absl::Status SDCSchedulingModel::SetWorstCaseThroughput(
@@ -911,19 +1116,21 @@ SDCSchedulingModel::AddLowerBoundSlack(
 }
 
 absl::StatusOr<std::unique_ptr<SDCScheduler>> SDCScheduler::Create(
-    FunctionBase* f, const DelayEstimator& delay_estimator) {
+    FunctionBase* f, const DelayEstimator& delay_estimator, SDCSolver solver) {
   XLS_ASSIGN_OR_RETURN(DelayMap delay_map,
                        ComputeNodeDelays(f, delay_estimator));
   std::unique_ptr<SDCScheduler> scheduler(
-      new SDCScheduler(f, std::move(delay_map)));
+      new SDCScheduler(f, std::move(delay_map), solver));
   XLS_RETURN_IF_ERROR(scheduler->Initialize());
   return std::move(scheduler);
 }
 
-SDCScheduler::SDCScheduler(FunctionBase* f, DelayMap delay_map)
+SDCScheduler::SDCScheduler(FunctionBase* f, DelayMap delay_map,
+                           SDCSolver solver)
     : f_(f),
       delay_map_(std::move(delay_map)),
-      model_(f, delay_map_, absl::StrCat("sdc_model:", f->name())) {}
+      model_(f, delay_map_, absl::StrCat("sdc_model:", f->name())),
+      solver_type_(solver) {}
 
 absl::Status SDCScheduler::Initialize() {
   XLS_ASSIGN_OR_RETURN(
@@ -995,6 +1202,37 @@ absl::Status SDCScheduler::BuildError(
                    math_opt::EnumToString(result.termination.reason)));
 }
 
+absl::StatusOr<math_opt::VariableMap<double>> SDCScheduler::Solve(
+    SchedulingFailureBehavior failure_behavior, bool check_feasibility) {
+  if (solver_type_ == SDCSolver::kMinCostFlow) {
+    std::optional<SDCSchedulingModel::DifferenceConstraintSolution> solution =
+        model_.SolveAsDifferenceConstraints();
+    if (solution.has_value()) {
+      if (solution->result == DifferenceConstraintSystem::Result::kOptimal) {
+        return std::move(solution->variable_values);
+      }
+      if (!failure_behavior.explain_infeasibility) {
+        return absl::InternalError(absl::StrCat(
+            "The problem does not have an optimal solution; min-cost flow "
+            "solver found the problem ",
+            solution->result == DifferenceConstraintSystem::Result::kInfeasible
+                ? "infeasible"
+                : "unbounded"));
+      }
+      // BuildError explains the failure from the LP solver's result; solve
+      // with the LP solver.
+    }
+  }
+
+  XLS_ASSIGN_OR_RETURN(math_opt::SolveResult result, solver_->Solve());
+  if (result.termination.reason == math_opt::TerminationReason::kOptimal ||
+      (check_feasibility &&
+       result.termination.reason == math_opt::TerminationReason::kFeasible)) {
+    return result.variable_values();
+  }
+  return BuildError(result, failure_behavior);
+}
+
 absl::StatusOr<ScheduleCycleMap> SDCScheduler::Schedule(
     std::optional<int64_t> pipeline_stages, int64_t clock_period_ps,
     SchedulingFailureBehavior failure_behavior, bool check_feasibility,
@@ -1009,17 +1247,11 @@ absl::StatusOr<ScheduleCycleMap> SDCScheduler::Schedule(
     // Find the minimum feasible pipeline length.
     model_.MinimizePipelineLength();
     XLS_ASSIGN_OR_RETURN(
-        const math_opt::SolveResult result_with_minimized_pipeline_length,
-        solver_->Solve());
-    if (result_with_minimized_pipeline_length.termination.reason !=
-        math_opt::TerminationReason::kOptimal) {
-      return BuildError(result_with_minimized_pipeline_length,
-                        failure_behavior);
-    }
+        const math_opt::VariableMap<double> values_with_minimized_length,
+        Solve(failure_behavior, /*check_feasibility=*/false));
     XLS_ASSIGN_OR_RETURN(
         const int64_t min_pipeline_length,
-        model_.ExtractPipelineLength(
-            result_with_minimized_pipeline_length.variable_values()));
+        model_.ExtractPipelineLength(values_with_minimized_length));
     model_.SetPipelineLength(min_pipeline_length);
   }
 
@@ -1029,13 +1261,9 @@ absl::StatusOr<ScheduleCycleMap> SDCScheduler::Schedule(
     model_.SetObjective();
   }
 
-  XLS_ASSIGN_OR_RETURN(math_opt::SolveResult result, solver_->Solve());
-  if (result.termination.reason == math_opt::TerminationReason::kOptimal ||
-      (check_feasibility &&
-       result.termination.reason == math_opt::TerminationReason::kFeasible)) {
-    return model_.ExtractResult(result.variable_values());
-  }
-  return BuildError(result, failure_behavior);
+  XLS_ASSIGN_OR_RETURN(const math_opt::VariableMap<double> values,
+                       Solve(failure_behavior, check_feasibility));
+  return model_.ExtractResult(values);
 }
 
 }  // namespace xls
@@ -24,9 +24,11 @@
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
+#include "xls/data_structures/difference_constraints.h"
 #include "xls/estimators/delay_model/delay_estimator.h"
 #include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
@@ -63,6 +65,10 @@ class SDCSchedulingModel {
   absl::Status AddSendThenRecvConstraint(
       const SendThenRecvConstraint& constraint);
 
+  // Sets the timing constraints for the given clock period. Only the
+  // constraints which differ from those for the previous clock period are
+  // added to or deleted from the model, so an incremental solver attached to
+  // the model can reuse its state from the previous solve.
   void SetClockPeriod(int64_t clock_period_ps);
 
   absl::Status SetWorstCaseThroughput(int64_t worst_case_throughput);
@@ -93,6 +99,22 @@ class SDCSchedulingModel {
       const operations_research::math_opt::VariableMap<double>& variable_values)
       const;
 
+  struct DifferenceConstraintSolution {
+    DifferenceConstraintSystem::Result result;
+    // The value of every variable of the model if `result` is kOptimal.
+    operations_research::math_opt::VariableMap<double> variable_values;
+  };
+
+  // Solves the model as a system of difference constraints, i.e., through its
+  // dual minimum-cost flow problem, without a general LP solver. The lifetime
+  // of a node is expressed as the difference between the cycle of its last
+  // use and its own cycle, which turns the lifetime constraints into
+  // difference constraints. Returns std::nullopt if the model has a constraint
+  // or objective term which cannot be expressed that way, e.g., the slack
+  // variables added by AddSlackVariables.
+  std::optional<DifferenceConstraintSolution> SolveAsDifferenceConstraints()
+      const;
+
   absl::flat_hash_map<Node*, operations_research::math_opt::Variable>
   GetCycleVars() const {
     return cycle_var_;
@@ -118,7 +140,22 @@ class SDCSchedulingModel {
   operations_research::math_opt::LinearConstraint DiffEqualsConstraint(
       Node* x, Node* y, int64_t diff, std::string_view name);
 
+  // Returns the (source, target) pairs currently constrained to have `target`
+  // scheduled in a later stage than `source` because of the clock period.
+  absl::flat_hash_set<std::pair<Node*, Node*>> GetTimingConstraints() const;
+
+ protected:
+  // Replaces the timing constraints with `constraints`, where each (source,
+  // target) pair requires `target` to be scheduled in a later stage than
+  // `source`. Constraints already in the model are kept as is.
+  void SetTimingConstraints(
+      absl::Span<const std::pair<Node*, Node*>> constraints);
+
  private:
+  // Adds or deletes the timing constraint between `source` and `target` so
+  // that it is present iff `needed` is true.
+  void UpdateTimingConstraint(Node* source, Node* target, bool needed);
+
   operations_research::math_opt::Variable AddUpperBoundSlack(
       operations_research::math_opt::LinearConstraint c,
       std::optional<operations_research::math_opt::Variable> slack =
@@ -152,11 +189,29 @@ class SDCSchedulingModel {
   operations_research::math_opt::Model model_;
   const DelayMap& delay_map_;
 
-  // Stores the critical-path distances between all pairs of Nodes; if there is
-  // a path from `x` to `y`, `distances_to_node_[y][x]` is the length of the
-  // critical path.
-  absl::flat_hash_map<Node*, absl::flat_hash_map<Node*, int64_t>>
-      distances_to_node_;
+  // A pair of nodes connected by a combinational path. `target` must be
+  // scheduled in a later stage than `source` iff the clock period is in
+  // [min_clock_period_ps, max_clock_period_ps), i.e., iff the critical path
+  // from the start of `source` to the end of `target` exceeds the clock period
+  // but the critical path to the start of `target` does not.
+  struct TimingPair {
+    Node* source;
+    Node* target;
+    int64_t min_clock_period_ps;
+    int64_t max_clock_period_ps;
+  };
+
+  // All pairs which need a timing constraint for some clock period, ordered by
+  // the topological position of the source and then of the target.
+  std::vector<TimingPair> timing_pairs_;
+  // Indices into `timing_pairs_` ordered by the minimum and by the maximum
+  // clock period. Used to find the pairs whose constraint changes when the
+  // clock period changes.
+  std::vector<int64_t> timing_pairs_by_min_period_;
+  std::vector<int64_t> timing_pairs_by_max_period_;
+  // The clock period of the current timing constraints, if set by
+  // SetClockPeriod.
+  std::optional<int64_t> clock_period_ps_;
 
   operations_research::math_opt::Variable last_stage_;
   std::optional<operations_research::math_opt::Variable> last_stage_slack_;
@@ -174,9 +229,6 @@ class SDCSchedulingModel {
   // data-dependence graph.
   operations_research::math_opt::Variable cycle_at_sinknode_;
 
-  // A cache of the delay constraints.
-  absl::flat_hash_map<Node*, std::vector<Node*>> delay_constraints_;
-
   absl::flat_hash_map<std::pair<Node*, Node*>,
                       operations_research::math_opt::LinearConstraint>
       backedge_constraint_;
@@ -207,12 +259,24 @@ class SDCSchedulingModel {
   absl::flat_hash_map<IOConstraint, SlackPair> io_slack_;
 };
 
+// The algorithm used by SDCScheduler to solve its scheduling problem.
+enum class SDCSolver : int8_t {
+  // Solve the linear program with a general LP solver.
+  kLinearProgram,
+  // Solve the problem with a minimum-cost flow solver; see
+  // SDCSchedulingModel::SolveAsDifferenceConstraints. Falls back to the LP
+  // solver if the model is not a system of difference constraints or to
+  // explain an infeasible problem.
+  kMinCostFlow,
+};
+
 class SDCScheduler {
   using DelayMap = absl::flat_hash_map<Node*, int64_t>;
 
  public:
   static absl::StatusOr<std::unique_ptr<SDCScheduler>> Create(
-      FunctionBase* f, const DelayEstimator& delay_estimator);
+      FunctionBase* f, const DelayEstimator& delay_estimator,
+      SDCSolver solver = SDCSolver::kLinearProgram);
 
   absl::Status AddConstraints(
       absl::Span<const SchedulingConstraint> constraints);
@@ -247,9 +311,15 @@ class SDCScheduler {
       std::optional<int64_t> worst_case_throughput = std::nullopt);
 
  private:
-  SDCScheduler(FunctionBase* f, DelayMap delay_map);
+  SDCScheduler(FunctionBase* f, DelayMap delay_map, SDCSolver solver);
   absl::Status Initialize();
 
+  // Solves the model with the configured solver. Returns the values of the
+  // variables in an optimal solution, or in any feasible solution if
+  // `check_feasibility` is true.
+  absl::StatusOr<operations_research::math_opt::VariableMap<double>> Solve(
+      SchedulingFailureBehavior failure_behavior, bool check_feasibility);
+
   absl::Status BuildError(
       const operations_research::math_opt::SolveResult& result,
       SchedulingFailureBehavior failure_behavior);
@@ -258,6 +328,7 @@ class SDCScheduler {
   DelayMap delay_map_;
 
   SDCSchedulingModel model_;
+  SDCSolver solver_type_;
   std::unique_ptr<operations_research::math_opt::IncrementalSolver> solver_;
 };
 
@@ -0,0 +1,390 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/scheduling/sdc_scheduler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "benchmark/benchmark.h"
+#include "xls/common/status/matchers.h"
+#include "xls/estimators/delay_model/delay_estimator.h"
+#include "xls/examples/sample_packages.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/package.h"
+#include "xls/ir/topo_sort.h"
+#include "xls/scheduling/pipeline_schedule.h"
+#include "xls/scheduling/run_pipeline_schedule.h"
+#include "xls/scheduling/scheduling_options.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+
+using DelayMap = absl::flat_hash_map<Node*, int64_t>;
+
+constexpr std::string_view kExamples[] = {
+    "examples/adler32/adler32",
+    "examples/crc32/crc32",
+    "examples/sha256",
+};
+
+absl::StatusOr<DelayMap> ComputeDelayMap(FunctionBase* f,
+                                         const DelayEstimator& estimator) {
+  DelayMap delay_map;
+  for (Node* node : f->nodes()) {
+    XLS_ASSIGN_OR_RETURN(delay_map[node],
+                         estimator.GetOperationDelayInPs(node));
+  }
+  return delay_map;
+}
+
+// Returns the delay of the longest combinational path through `f`.
+int64_t CriticalPathDelay(FunctionBase* f, const DelayMap& delay_map) {
+  absl::flat_hash_map<Node*, int64_t> path_delay;
+  int64_t result = 0;
+  for (Node* node : TopoSort(f)) {
+    int64_t operand_delay = 0;
+    for (Node* operand : node->operands()) {
+      operand_delay = std::max(operand_delay, path_delay.at(operand));
+    }
+    path_delay[node] = operand_delay + delay_map.at(node);
+    result = std::max(result, path_delay[node]);
+  }
+  return result;
+}
+
+// Returns the clock periods visited by a binary search for the minimum clock
+// period in [1, `max_period`], mimicking the access pattern of
+// FindMinimumClockPeriod. The search steers toward `target`.
+std::vector<int64_t> BinarySearchPeriods(int64_t max_period, int64_t target) {
+  std::vector<int64_t> periods = {max_period};
+  int64_t low = 1;
+  int64_t high = max_period;
+  while (low < high) {
+    int64_t mid = low + (high - low) / 2;
+    periods.push_back(mid);
+    if (mid >= target) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return periods;
+}
+
+// Returns the objective minimized by the SDC scheduler for a schedule of a
+// function: the bit count of every node weighted by its lifetime, plus the sum
+// of all cycles as a tie-breaker.
+int64_t ScheduleCost(FunctionBase* f, const ScheduleCycleMap& cycle_map) {
+  int64_t cost = 0;
+  for (Node* node : f->nodes()) {
+    int64_t last_use = cycle_map.at(node);
+    for (Node* user : node->users()) {
+      last_use = std::max(last_use, cycle_map.at(user));
+    }
+    cost += 1024 * node->GetType()->GetFlatBitCount() *
+                (last_use - cycle_map.at(node)) +
+            cycle_map.at(node);
+  }
+  return cost;
+}
+
+int64_t PipelineLength(const ScheduleCycleMap& cycle_map) {
+  int64_t max_cycle = 0;
+  for (const auto& [node, cycle] : cycle_map) {
+    max_cycle = std::max(max_cycle, cycle);
+  }
+  return max_cycle + 1;
+}
+
+// Returns the number of stages of the minimum-length pipeline for `f` at
+// `clock_period_ps`, or std::nullopt if no such pipeline exists.
+std::optional<int64_t> MinimumPipelineLength(SDCScheduler& scheduler,
+                                             int64_t clock_period_ps) {
+  absl::StatusOr<ScheduleCycleMap> cycle_map = scheduler.Schedule(
+      /*pipeline_stages=*/std::nullopt, clock_period_ps,
+      SchedulingFailureBehavior{.explain_infeasibility = false});
+  if (!cycle_map.ok()) {
+    return std::nullopt;
+  }
+  return PipelineLength(*cycle_map);
+}
+
+TEST(SDCSchedulerTest, IncrementalTimingConstraintsMatchFreshModel) {
+  for (std::string_view example : kExamples) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<Package> p,
+        sample_packages::GetBenchmark(example, /*optimized=*/true));
+    XLS_ASSERT_OK_AND_ASSIGN(FunctionBase * f, p->GetTopAsFunction());
+    XLS_ASSERT_OK_AND_ASSIGN(DelayMap delay_map,
+                             ComputeDelayMap(f, TestDelayEstimator()));
+    int64_t critical_path = CriticalPathDelay(f, delay_map);
+
+    SDCSchedulingModel model(f, delay_map);
+    for (int64_t clock_period_ps :
+         BinarySearchPeriods(critical_path, (critical_path + 2) / 3)) {
+      model.SetClockPeriod(clock_period_ps);
+
+      SDCSchedulingModel fresh_model(f, delay_map);
+      fresh_model.SetClockPeriod(clock_period_ps);
+      EXPECT_EQ(model.GetTimingConstraints(),
+                fresh_model.GetTimingConstraints())
+          << example << " at clock period " << clock_period_ps;
+    }
+  }
+}
+
+TEST(SDCSchedulerTest, ReusedSchedulerMatchesFreshScheduler) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Package> p,
+      sample_packages::GetBenchmark("examples/crc32/crc32",
+                                    /*optimized=*/true));
+  XLS_ASSERT_OK_AND_ASSIGN(FunctionBase * f, p->GetTopAsFunction());
+  TestDelayEstimator estimator;
+  XLS_ASSERT_OK_AND_ASSIGN(DelayMap delay_map, ComputeDelayMap(f, estimator));
+  int64_t critical_path = CriticalPathDelay(f, delay_map);
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SDCScheduler> scheduler,
+                           SDCScheduler::Create(f, estimator));
+  for (int64_t clock_period_ps :
+       BinarySearchPeriods(critical_path, (critical_path + 3) / 4)) {
+    XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SDCScheduler> fresh_scheduler,
+                             SDCScheduler::Create(f, estimator));
+    EXPECT_EQ(MinimumPipelineLength(*scheduler, clock_period_ps),
+              MinimumPipelineLength(*fresh_scheduler, clock_period_ps))
+        << "at clock period " << clock_period_ps;
+  }
+}
+
+TEST(SDCSchedulerTest, MinCostFlowMatchesLinearProgram) {
+  TestDelayEstimator estimator;
+  for (std::string_view example : kExamples) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<Package> p,
+        sample_packages::GetBenchmark(example, /*optimized=*/true));
+    XLS_ASSERT_OK_AND_ASSIGN(FunctionBase * f, p->GetTopAsFunction());
+    XLS_ASSERT_OK_AND_ASSIGN(DelayMap delay_map, ComputeDelayMap(f, estimator));
+    int64_t critical_path = CriticalPathDelay(f, delay_map);
+
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<SDCScheduler> lp_scheduler,
+        SDCScheduler::Create(f, estimator, SDCSolver::kLinearProgram));
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<SDCScheduler> flow_scheduler,
+        SDCScheduler::Create(f, estimator, SDCSolver::kMinCostFlow));
+    for (int64_t clock_period_ps :
+         {critical_path, (critical_path + 1) / 2, (critical_path + 3) / 4}) {
+      XLS_ASSERT_OK_AND_ASSIGN(
+          ScheduleCycleMap lp_schedule,
+          lp_scheduler->Schedule(/*pipeline_stages=*/std::nullopt,
+                                 clock_period_ps, SchedulingFailureBehavior()));
+      XLS_ASSERT_OK_AND_ASSIGN(
+          ScheduleCycleMap flow_schedule,
+          flow_scheduler->Schedule(/*pipeline_stages=*/std::nullopt,
+                                   clock_period_ps,
+                                   SchedulingFailureBehavior()));
+      EXPECT_EQ(PipelineLength(flow_schedule), PipelineLength(lp_schedule))
+          << example << " at clock period " << clock_period_ps;
+      EXPECT_EQ(ScheduleCost(f, flow_schedule), ScheduleCost(f, lp_schedule))
+          << example << " at clock period " << clock_period_ps;
+
+      // A longer pipeline than necessary.
+      int64_t pipeline_stages = PipelineLength(lp_schedule) + 1;
+      XLS_ASSERT_OK_AND_ASSIGN(
+          lp_schedule,
+          lp_scheduler->Schedule(pipeline_stages, clock_period_ps,
+                                 SchedulingFailureBehavior()));
+      XLS_ASSERT_OK_AND_ASSIGN(
+          flow_schedule,
+          flow_scheduler->Schedule(pipeline_stages, clock_period_ps,
+                                   SchedulingFailureBehavior()));
+      EXPECT_EQ(PipelineLength(flow_schedule), pipeline_stages);
+      EXPECT_EQ(ScheduleCost(f, flow_schedule), ScheduleCost(f, lp_schedule))
+          << example << " at clock period " << clock_period_ps << " in "
+          << pipeline_stages << " stages";
+    }
+  }
+}
+
+TEST(SDCSchedulerTest, MinCostFlowFeasibilityMatchesLinearProgram) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Package> p,
+      sample_packages::GetBenchmark("examples/crc32/crc32",
+                                    /*optimized=*/true));
+  XLS_ASSERT_OK_AND_ASSIGN(FunctionBase * f, p->GetTopAsFunction());
+  TestDelayEstimator estimator;
+  XLS_ASSERT_OK_AND_ASSIGN(DelayMap delay_map, ComputeDelayMap(f, estimator));
+  int64_t critical_path = CriticalPathDelay(f, delay_map);
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<SDCScheduler> lp_scheduler,
+      SDCScheduler::Create(f, estimator, SDCSolver::kLinearProgram));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<SDCScheduler> flow_scheduler,
+      SDCScheduler::Create(f, estimator, SDCSolver::kMinCostFlow));
+  SchedulingFailureBehavior failure_behavior{.explain_infeasibility = false};
+  for (int64_t clock_period_ps = 1; clock_period_ps <= critical_path;
+       ++clock_period_ps) {
+    EXPECT_EQ(flow_scheduler
+                  ->Schedule(/*pipeline_stages=*/4, clock_period_ps,
+                             failure_behavior, /*check_feasibility=*/true)
+                  .ok(),
+              lp_scheduler
+                  ->Schedule(/*pipeline_stages=*/4, clock_period_ps,
+                             failure_behavior, /*check_feasibility=*/true)
+                  .ok())
+        << "at clock period " << clock_period_ps;
+  }
+}
+
+TEST(SDCSchedulerTest, MinCostFlowExplainsInfeasibilityWithLinearProgram) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Package> p,
+      sample_packages::GetBenchmark("examples/crc32/crc32",
+                                    /*optimized=*/true));
+  XLS_ASSERT_OK_AND_ASSIGN(FunctionBase * f, p->GetTopAsFunction());
+  TestDelayEstimator estimator;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<SDCScheduler> lp_scheduler,
+      SDCScheduler::Create(f, estimator, SDCSolver::kLinearProgram));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<SDCScheduler> flow_scheduler,
+      SDCScheduler::Create(f, estimator, SDCSolver::kMinCostFlow));
+
+  absl::Status lp_status =
+      lp_scheduler
+          ->Schedule(/*pipeline_stages=*/1, /*clock_period_ps=*/1,
+                     SchedulingFailureBehavior())
+          .status();
+  absl::Status flow_status =
+      flow_scheduler
+          ->Schedule(/*pipeline_stages=*/1, /*clock_period_ps=*/1,
+                     SchedulingFailureBehavior())
+          .status();
+  EXPECT_THAT(flow_status, StatusIs(absl::StatusCode::kInvalidArgument,
+                                    HasSubstr("--pipeline_stages=")));
+  EXPECT_EQ(flow_status, lp_status);
+}
+
+struct Design {
+  std::unique_ptr<Package> package;
+  FunctionBase* f;
+  DelayMap delay_map;
+  int64_t critical_path;
+};
+
+Design LoadDesign(int64_t example_index) {
+  Design design;
+  design.package =
+      sample_packages::GetBenchmark(kExamples[example_index],
+                                    /*optimized=*/true)
+          .value();
+  design.f = design.package->GetTopAsFunction().value();
+  design.delay_map = ComputeDelayMap(design.f, TestDelayEstimator()).value();
+  design.critical_path = CriticalPathDelay(design.f, design.delay_map);
+  return design;
+}
+
+// Searches for the minimum clock period of an example in a fixed number of
+// stages, as done when only `pipeline_stages` is given. `state.range(2)`
+// selects the LP (0) or the min-cost flow (1) solver.
+void BM_MinimumClockPeriod(benchmark::State& state) {
+  Design design = LoadDesign(state.range(0));
+  SchedulingOptions options(state.range(2) == 0
+                                ? SchedulingStrategy::SDC
+                                : SchedulingStrategy::SDC_MIN_COST_FLOW);
+  options.pipeline_stages(state.range(1));
+  TestDelayEstimator estimator;
+  for (auto _ : state) {
+    absl::StatusOr<PipelineSchedule> schedule =
+        RunPipelineSchedule(design.f, estimator, options);
+    CHECK_OK(schedule.status());
+    benchmark::DoNotOptimize(schedule);
+  }
+}
+BENCHMARK(BM_MinimumClockPeriod)
+    ->ArgsProduct({benchmark::CreateDenseRange(0, std::size(kExamples) - 1,
+                                               /*step=*/1),
+                   {2, 4},
+                   {0, 1}});
+
+// Schedules an example for minimum register count at a quarter of its
+// critical path. `state.range(1)` selects the LP (0) or the min-cost flow (1)
+// solver.
+void BM_Schedule(benchmark::State& state) {
+  Design design = LoadDesign(state.range(0));
+  TestDelayEstimator estimator;
+  int64_t clock_period_ps = (design.critical_path + 3) / 4;
+  SDCSolver solver = state.range(1) == 0 ? SDCSolver::kLinearProgram
+                                         : SDCSolver::kMinCostFlow;
+  for (auto _ : state) {
+    std::unique_ptr<SDCScheduler> scheduler =
+        SDCScheduler::Create(design.f, estimator, solver).value();
+    absl::StatusOr<ScheduleCycleMap> cycle_map =
+        scheduler->Schedule(/*pipeline_stages=*/std::nullopt,
+                            clock_period_ps, SchedulingFailureBehavior());
+    CHECK_OK(cycle_map.status());
+    benchmark::DoNotOptimize(cycle_map);
+  }
+}
+BENCHMARK(BM_Schedule)->ArgsProduct(
+    {benchmark::CreateDenseRange(0, std::size(kExamples) - 1, /*step=*/1),
+     {0, 1}});
+
+// Updates the timing constraints of one model over the clock periods of a
+// binary search. `state.range(1)` selects between reusing the model (1) and
+// building a fresh model for every clock period (0).
+void BM_SetClockPeriod(benchmark::State& state) {
+  Design design = LoadDesign(state.range(0));
+  bool incremental = state.range(1) != 0;
+  std::vector<int64_t> periods =
+      BinarySearchPeriods(design.critical_path, (design.critical_path + 3) / 4);
+  for (auto _ : state) {
+    if (incremental) {
+      SDCSchedulingModel model(design.f, design.delay_map);
+      for (int64_t clock_period_ps : periods) {
+        model.SetClockPeriod(clock_period_ps);
+      }
+    } else {
+      for (int64_t clock_period_ps : periods) {
+        SDCSchedulingModel model(design.f, design.delay_map);
+        model.SetClockPeriod(clock_period_ps);
+      }
+    }
+  }
+}
+BENCHMARK(BM_SetClockPeriod)
+    ->ArgsProduct({benchmark::CreateDenseRange(0, std::size(kExamples) - 1,
+                                               /*step=*/1),
+                   {0, 1}});
+
+}  // namespace
+}  // namespace xls
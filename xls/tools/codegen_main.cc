@@ -33,7 +33,7 @@
 #include "xls/common/status/status_macros.h"
 #include "xls/dev_tools/tool_timeout.h"
 #include "xls/ir/function_base.h"
-#include "xls/ir/ir_parser.h"
+#include "xls/ir/indexed_ir.h"
 #include "xls/ir/verifier.h"
 #include "xls/scheduling/pipeline_schedule.pb.h"
 #include "xls/scheduling/scheduling_options.h"
@@ -66,15 +66,15 @@ absl::Status RealMain(std::string_view ir_path) {
   if (ir_path == "-") {
     ir_path = "/dev/stdin";
   }
-  XLS_ASSIGN_OR_RETURN(std::string ir_contents, GetFileContents(ir_path));
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> p,
-                       Parser::ParsePackage(ir_contents, ir_path));
-
   XLS_ASSIGN_OR_RETURN(CodegenFlagsProto codegen_flags_proto,
                        GetCodegenFlags());
+  std::optional<std::string_view> top;
   if (!codegen_flags_proto.top().empty()) {
-    XLS_RETURN_IF_ERROR(p->SetTopByName(codegen_flags_proto.top()));
+    top = codegen_flags_proto.top();
   }
+  // Indexed IR only materializes the top and the function bases it depends on.
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> p,
+                       LoadPackageFromFile(ir_path, top));
 
   XLS_RET_CHECK(p->GetTop().has_value())
       << "Package " << p->name() << " needs a top function/proc.";
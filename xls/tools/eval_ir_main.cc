@@ -83,6 +83,7 @@
 #include "xls/ir/events.h"
 #include "xls/ir/format_preference.h"
 #include "xls/ir/function.h"
+#include "xls/ir/indexed_ir.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
@@ -92,6 +93,7 @@
 #include "xls/ir/value_utils.h"
 #include "xls/jit/function_jit.h"
 #include "xls/jit/jit_buffer.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/observer.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_pipeline.h"
@@ -228,6 +230,11 @@ ABSL_FLAG(
     "Instead of compiling jitted XLS ir code and executing it, compile it to "
     "LLVM ir and then interpret the LLVM IR. --use_llvm_jit must be true. Use "
     "--llvm_opt_level=0 if you want to execute the unoptimized llvm ir.");
+ABSL_FLAG(std::optional<std::string>, jit_object_cache_dir, std::nullopt,
+          "Directory in which to cache object code compiled by the LLVM JIT. "
+          "Compiling identical LLVM IR with identical settings again loads "
+          "the object from the cache instead of running the LLVM pipeline. "
+          "The directory may be shared between processes.");
 
 namespace xls {
 namespace {
@@ -652,12 +659,14 @@ absl::Status RealMain(std::string_view input_path,
   if (input_path == "-") {
     input_path = "/dev/stdin";
   }
-  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(input_path));
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                       Parser::ParsePackage(contents, input_path));
-  if (!absl::GetFlag(FLAGS_top).empty()) {
-    XLS_RETURN_IF_ERROR(package->SetTopByName(absl::GetFlag(FLAGS_top)));
+  std::string top_flag = absl::GetFlag(FLAGS_top);
+  std::optional<std::string_view> top;
+  if (!top_flag.empty()) {
+    top = top_flag;
   }
+  // Indexed IR only materializes the top and the functions it calls.
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       LoadPackageFromFile(input_path, top));
   XLS_ASSIGN_OR_RETURN(Function * f, package->GetTopAsFunction());
 
   std::vector<ArgSet> arg_sets;
@@ -778,6 +787,10 @@ int main(int argc, char** argv) {
          absl::GetFlag(FLAGS_input_validator_path).empty())
       << "At most one one of 'input_validator' or 'input_validator_path' may "
          "be specified.";
+  if (absl::GetFlag(FLAGS_jit_object_cache_dir).has_value()) {
+    xls::SetJitObjectCacheDirectory(
+        std::filesystem::path(*absl::GetFlag(FLAGS_jit_object_cache_dir)));
+  }
   std::string dslx_stdlib_path = absl::GetFlag(FLAGS_dslx_stdlib_path);
 
   std::string dslx_path = absl::GetFlag(FLAGS_dslx_path);
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <deque>
+#include <filesystem>  // NOLINT
 #include <iostream>
 #include <iterator>
 #include <memory>
@@ -60,6 +61,7 @@
 #include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/evaluator_options.h"
 #include "xls/interpreter/interpreter_proc_runtime.h"
+#include "xls/interpreter/proc_runtime.h"
 #include "xls/interpreter/serial_proc_runtime.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/block.h"
@@ -77,6 +79,7 @@
 #include "xls/ir/value.h"
 #include "xls/ir/value_utils.h"
 #include "xls/jit/block_jit.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/jit_proc_runtime.h"
 #include "xls/jit/jit_runtime.h"
 #include "xls/tools/eval_utils.h"
@@ -105,6 +108,8 @@ ABSL_FLAG(std::vector<std::string>, ticks, {},
 ABSL_FLAG(std::string, backend, "serial_jit",
           "Backend to use for evaluation. Valid options are:\n"
           " * serial_jit: JIT-backed single-stepping runtime.\n"
+          " * parallel_jit: JIT-backed runtime which ticks procs on multiple "
+          "threads.\n"
           " * ir_interpreter: Interpreter at the IR level.\n"
           " * block_interpreter: Interpret a block generated from a proc.\n"
           " * block_jit: JIT-backed block execution generated from a proc.");
@@ -201,6 +206,11 @@ ABSL_FLAG(std::string, ram_rewrites_textproto, "",
           "Path to ram rewrites textproto, which is used to create memory "
           "models. Blank is default, in which case no memory models are added "
           "to the simulation.");
+ABSL_FLAG(std::optional<std::string>, jit_object_cache_dir, std::nullopt,
+          "Directory in which to cache object code compiled by the LLVM JIT. "
+          "Compiling identical LLVM IR with identical settings again loads "
+          "the object from the cache instead of running the LLVM pipeline. "
+          "The directory may be shared between processes.");
 
 namespace xls {
 
@@ -228,6 +238,8 @@ static absl::Status LogInterpreterEvents(std::string_view entity_name,
 
 struct EvaluateProcsOptions {
   bool use_jit = false;
+  // Whether to tick procs on multiple threads. Only supported with the JIT.
+  bool use_parallel_runtime = false;
   bool fail_on_assert = false;
   std::vector<int64_t> ticks = {-1};
   std::optional<std::string> top = std::nullopt;
@@ -240,7 +252,7 @@ static absl::Status EvaluateProcs(
         expected_outputs_for_channels,
     const RamRewritesProto& ram_rewrites,
     const EvaluateProcsOptions& options = {}) {
-  std::unique_ptr<SerialProcRuntime> runtime;
+  std::unique_ptr<ProcRuntime> runtime;
   std::optional<JitRuntime*> jit;
   EvaluatorOptions evaluator_options;
   evaluator_options.set_trace_channels(absl::GetFlag(FLAGS_trace_channels));
@@ -255,7 +267,12 @@ static absl::Status EvaluateProcs(
     }
   }
   evaluator_options.set_support_observers(uses_observers);
-  if (options.use_jit) {
+  if (options.use_jit && options.use_parallel_runtime) {
+    XLS_ASSIGN_OR_RETURN(
+        runtime, CreateJitParallelProcRuntime(package, evaluator_options));
+    XLS_ASSIGN_OR_RETURN(auto jit_queue, runtime->GetJitChannelQueueManager());
+    jit = &jit_queue->runtime();
+  } else if (options.use_jit) {
     XLS_ASSIGN_OR_RETURN(
         runtime, CreateJitSerialProcRuntime(package, evaluator_options));
     XLS_ASSIGN_OR_RETURN(auto jit_queue, runtime->GetJitChannelQueueManager());
@@ -1205,6 +1222,9 @@ static absl::Status RealMain(
 
   if (backend == "serial_jit") {
     evaluate_procs_options.use_jit = true;
+  } else if (backend == "parallel_jit") {
+    evaluate_procs_options.use_jit = true;
+    evaluate_procs_options.use_parallel_runtime = true;
   } else if (backend == "ir_interpreter") {
     evaluate_procs_options.use_jit = false;
   } else {
@@ -1225,9 +1245,15 @@ int main(int argc, char* argv[]) {
     LOG(QFATAL) << "One (and only one) IR file must be given.";
   }
 
+  if (absl::GetFlag(FLAGS_jit_object_cache_dir).has_value()) {
+    xls::SetJitObjectCacheDirectory(
+        std::filesystem::path(*absl::GetFlag(FLAGS_jit_object_cache_dir)));
+  }
+
   std::string backend = absl::GetFlag(FLAGS_backend);
-  if (backend != "serial_jit" && backend != "ir_interpreter" &&
-      backend != "block_interpreter" && backend != "block_jit") {
+  if (backend != "serial_jit" && backend != "parallel_jit" &&
+      backend != "ir_interpreter" && backend != "block_interpreter" &&
+      backend != "block_jit") {
     LOG(QFATAL) << "Unrecognized backend choice.";
   }
 
@@ -14,6 +14,7 @@
 
 #include "xls/tools/opt.h"
 
+#include <cstdint>
 #include <filesystem>  // NOLINT
 #include <memory>
 #include <optional>
@@ -30,10 +31,13 @@
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/visitor.h"
+#include "xls/common/work_stealing_thread_pool.h"
 #include "xls/ir/function_base.h"
+#include "xls/ir/indexed_ir.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
 #include "xls/ir/verifier.h"
+#include "xls/passes/optimization_context.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_pipeline.h"
 #include "xls/passes/pass_base.h"
@@ -104,9 +108,19 @@ absl::Status OptimizeIrForTop(Package* package, const OptOptions& options) {
       options.use_context_narrowing_analysis;
   pass_options.bisect_limit = options.bisect_limit;
   pass_options.record_metrics = options.metrics != nullptr;
+  OptimizationContext context(QueryEngineOptions{
+      .bdd = {.dynamic_reordering = options.bdd_dynamic_reordering}});
+  pass_options.context = &context;
+  std::optional<WorkStealingThreadPool> thread_pool;
+  if (options.pass_thread_count.has_value()) {
+    XLS_RET_CHECK_GT(*options.pass_thread_count, 0);
+    thread_pool.emplace(*options.pass_thread_count);
+    pass_options.thread_pool = &*thread_pool;
+  }
   PassResults results;
   XLS_RETURN_IF_ERROR(pipeline->Run(package, pass_options, &results).status());
   if (options.metrics) {
+    context.RecordStats(results.aggregate_results);
     *options.metrics = results.aggregate_results.ToProto();
   }
   return absl::OkStatus();
@@ -114,9 +128,22 @@ absl::Status OptimizeIrForTop(Package* package, const OptOptions& options) {
 
 absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
                                              const OptOptions& options) {
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                       Parser::ParsePackage(ir, options.ir_path));
+  std::unique_ptr<Package> package;
+  if (IsIndexedIr(ir)) {
+    // The whole package is materialized as passes such as DFE decide which
+    // function bases are kept.
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<IndexedIrReader> reader,
+                         IndexedIrReader::FromBuffer(std::string(ir)));
+    XLS_RETURN_IF_ERROR(reader->MaterializeAll());
+    package = reader->TakePackage();
+  } else {
+    XLS_ASSIGN_OR_RETURN(package,
+                         Parser::ParsePackageInParallel(ir, options.ir_path));
+  }
   XLS_RETURN_IF_ERROR(OptimizeIrForTop(package.get(), options));
+  if (options.indexed_output) {
+    return SerializePackageToIndexedIr(package.get());
+  }
   return package->DumpIr();
 }
 
@@ -50,6 +50,16 @@ struct OptOptions {
       pass_pipeline = std::nullopt;
   std::optional<int64_t> bisect_limit;
   PipelineMetricsProto* metrics = nullptr;
+  // Whether the string-based OptimizeIrForTop returns the optimized package in
+  // the indexed IR format (see xls/ir/indexed_ir.h) rather than as IR text.
+  bool indexed_output = false;
+  // If set, function-base passes transform the function bases of the package
+  // concurrently on this many threads. The result does not depend on the
+  // number of threads.
+  std::optional<int64_t> pass_thread_count = std::nullopt;
+  // Whether the BDD query engines shared between passes reorder their
+  // variables by sifting as the BDDs grow.
+  bool bdd_dynamic_reordering = false;
 };
 
 // Helper used in the opt_main tool, optimizes the given IR for a particular
@@ -59,7 +69,7 @@ absl::Status OptimizeIrForTop(Package* package, const OptOptions& options);
 
 // Helper used in the opt_main tool, optimizes the given IR for a particular
 // top-level entity (e.g., function, proc, etc) at the given opt level and
-// returns the resulting optimized IR.
+// returns the resulting optimized IR. `ir` may be IR text or indexed IR.
 absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
                                              const OptOptions& options);
 }  // namespace xls::tools
@@ -62,7 +62,8 @@ Successfully optimized IR is printed to stdout.
 Expected invocation:
   opt_main <IR file>
 where:
-  - <IR file> is the path to the input IR file. '-' denotes stdin as input.
+  - <IR file> is the path to the input IR file, either IR text or indexed IR.
+    '-' denotes stdin as input.
 
 Example invocation:
   opt_main path/to/file.ir
@@ -70,6 +71,16 @@ Example invocation:
 
 ABSL_FLAG(std::string, output_path, "-",
           "Output path for the optimized IR file; '-' denotes stdout.");
+ABSL_FLAG(bool, output_indexed_ir, false,
+          "Emit the optimized package in the indexed IR format, which tools "
+          "can load lazily, instead of as IR text.");
+ABSL_FLAG(std::optional<int64_t>, pass_threads, std::nullopt,
+          "If given, function-level passes optimize the functions and procs "
+          "of the package concurrently on this many threads. The optimized "
+          "IR does not depend on the number of threads.");
+ABSL_FLAG(bool, bdd_dynamic_reordering, false,
+          "Whether the BDDs built by BDD-based passes reorder their variables "
+          "by sifting as they grow. Slower, but may keep large BDDs smaller.");
 ABSL_FLAG(std::optional<std::string>, alsologto, std::nullopt,
           "Path to write logs to, in addition to stderr.");
 // LINT.IfChange
@@ -269,6 +280,10 @@ absl::Status RealMain(std::string_view input_path) {
               .pass_pipeline = pass_pipeline,
               .bisect_limit = bisect_limit,
               .metrics = wants_metrics ? &metrics : nullptr,
+              .indexed_output = absl::GetFlag(FLAGS_output_indexed_ir),
+              .pass_thread_count = absl::GetFlag(FLAGS_pass_threads),
+              .bdd_dynamic_reordering =
+                  absl::GetFlag(FLAGS_bdd_dynamic_reordering),
           }));
   if (absl::GetFlag(FLAGS_pipeline_metrics_proto)) {
     XLS_RETURN_IF_ERROR(